@@ -0,0 +1,119 @@
+// Moves many colliders around a world and reports how long the broadphase
+// takes to find their overlapping pairs each tick.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "absl/log/globals.h"
+#include "absl/log/initialize.h"
+#include "absl/log/log.h"
+#include "absl/status/status.h"
+#include "absl/strings/numbers.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "common/status_macros.h"
+#include "objects/collider_geometry.h"
+#include "runtime/collider_broadphase.h"
+
+namespace {
+
+using ::zebes::BroadphasePair;
+using ::zebes::ColliderBounds;
+using ::zebes::ColliderBroadphase;
+using ::zebes::Vec;
+
+constexpr double kCellSize = 32;
+constexpr int kRuns = 5;
+
+struct Mover {
+  Vec position;
+  Vec size;
+  Vec velocity;
+};
+
+// Colliders from 8 to 32 pixels across, spread so a typical one overlaps about
+// one other, each drifting up to four pixels a tick and bouncing off the walls.
+std::vector<Mover> MakeMovers(int count, double world) {
+  std::mt19937 random(11);
+  std::uniform_real_distribution<double> position(0, world);
+  std::uniform_real_distribution<double> size(8, 32);
+  std::uniform_real_distribution<double> speed(-4, 4);
+  std::vector<Mover> movers(count);
+  for (Mover& mover : movers) {
+    mover = {.position = {.x = position(random), .y = position(random)},
+             .size = {.x = size(random), .y = size(random)},
+             .velocity = {.x = speed(random), .y = speed(random)}};
+  }
+  return movers;
+}
+
+void Move(std::vector<Mover>& movers, double world) {
+  for (Mover& mover : movers) {
+    mover.position.x += mover.velocity.x;
+    mover.position.y += mover.velocity.y;
+    if (mover.position.x < 0 || mover.position.x > world) mover.velocity.x = -mover.velocity.x;
+    if (mover.position.y < 0 || mover.position.y > world) mover.velocity.y = -mover.velocity.y;
+  }
+}
+
+absl::Status Run(int count, int ticks) {
+  ASSIGN_OR_RETURN(ColliderBroadphase broadphase, ColliderBroadphase::Create(kCellSize));
+  // About 400 square pixels of world per collider.
+  const double world = std::sqrt(count * 400.0);
+
+  absl::Duration best = absl::InfiniteDuration();
+  int64_t pairs = 0;
+  for (int run = 0; run < kRuns; ++run) {
+    std::vector<Mover> movers = MakeMovers(count, world);
+    std::vector<ColliderBounds> bounds(count);
+    pairs = 0;
+    absl::Duration elapsed;
+    for (int tick = 0; tick < ticks; ++tick) {
+      Move(movers, world);
+      for (int i = 0; i < count; ++i) {
+        const Mover& mover = movers[i];
+        bounds[i] = {.min = mover.position,
+                     .max = {.x = mover.position.x + mover.size.x,
+                             .y = mover.position.y + mover.size.y}};
+      }
+      const absl::Time start = absl::Now();
+      const absl::Span<const BroadphasePair> found = broadphase.FindPairs(bounds);
+      elapsed += absl::Now() - start;
+      pairs += static_cast<int64_t>(found.size());
+    }
+    best = std::min(best, elapsed);
+  }
+
+  LOG(INFO) << count << " colliders over " << ticks << " ticks: best of " << kRuns << " took "
+            << absl::FormatDuration(best / ticks) << " per tick ("
+            << absl::ToDoubleNanoseconds(best / ticks) / count << " ns per collider), "
+            << static_cast<double>(pairs) / ticks << " pairs per tick";
+  return absl::OkStatus();
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  absl::SetStderrThreshold(absl::LogSeverityAtLeast::kInfo);
+  absl::InitializeLog();
+  int count = 50000;
+  int ticks = 120;
+  if (argc != 1 && argc != 3) {
+    LOG(ERROR) << "Usage: " << argv[0] << " [colliders ticks]";
+    return 1;
+  }
+  if (argc == 3 && (!absl::SimpleAtoi(argv[1], &count) || !absl::SimpleAtoi(argv[2], &ticks) ||
+                    count <= 0 || ticks <= 0)) {
+    LOG(ERROR) << "collider and tick counts must be positive integers";
+    return 1;
+  }
+  const absl::Status status = Run(count, ticks);
+  if (!status.ok()) {
+    LOG(ERROR) << status.message();
+    return 1;
+  }
+  return 0;
+}
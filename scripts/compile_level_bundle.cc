@@ -0,0 +1,160 @@
+// Compiles one level from an assets root into a level bundle: the level and
+// every asset it references in a single file the game maps in at startup,
+// instead of parsing each definition and decoding each PNG.
+//
+// Usage: compile_level_bundle <assets_root> <level_id> <output_path>
+
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/log/globals.h"
+#include "absl/log/initialize.h"
+#include "absl/log/log.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/types/span.h"
+#include "common/status_macros.h"
+#include "resources/blueprint_manager.h"
+#include "resources/collider_manager.h"
+#include "resources/level_manager.h"
+#include "resources/level_region_store.h"
+#include "resources/level_streamer.h"
+#include "resources/sprite_manager.h"
+#include "resources/texture_manager.h"
+#include "resources/texture_resource_store.h"
+#include "resources/tileset_manager.h"
+#include "runtime/level_bundle.h"
+#include "runtime/level_bundle_compiler.h"
+
+namespace {
+
+using ::zebes::Blueprint;
+using ::zebes::Collider;
+using ::zebes::RgbaImage;
+using ::zebes::Sprite;
+using ::zebes::TextureHandle;
+using ::zebes::Tileset;
+
+// Texture definitions are all this tool needs; the pixels it ships are read
+// straight from the images, so nothing is ever uploaded anywhere.
+class DetachedTextureStore : public zebes::TextureResourceStore {
+ public:
+  absl::StatusOr<TextureHandle> Load(const std::string& path) override {
+    return MakeHandle(next_id_++);
+  }
+  absl::StatusOr<TextureHandle> LoadFromPixels(int width, int height,
+                                               absl::Span<const uint8_t> pixels) override {
+    return MakeHandle(next_id_++);
+  }
+  absl::Status Unload(TextureHandle handle) override { return absl::OkStatus(); }
+
+ private:
+  uint64_t next_id_ = 1;
+};
+
+class ManagerAssets : public zebes::LevelBundleAssetSource {
+ public:
+  static absl::StatusOr<std::unique_ptr<ManagerAssets>> Create(const std::string& root) {
+    std::unique_ptr<ManagerAssets> assets(new ManagerAssets());
+    ASSIGN_OR_RETURN(assets->textures_, zebes::TextureManager::Create(&assets->store_, root));
+    RETURN_IF_ERROR(assets->textures_->LoadAllTextures());
+    ASSIGN_OR_RETURN(assets->tilesets_, zebes::TilesetManager::Create(root));
+    RETURN_IF_ERROR(assets->tilesets_->LoadAllTilesets());
+    ASSIGN_OR_RETURN(assets->sprites_, zebes::SpriteManager::Create(assets->textures_.get(), root));
+    RETURN_IF_ERROR(assets->sprites_->LoadAllSprites());
+    ASSIGN_OR_RETURN(assets->colliders_, zebes::ColliderManager::Create(root));
+    RETURN_IF_ERROR(assets->colliders_->LoadAllColliders());
+    ASSIGN_OR_RETURN(assets->blueprints_, zebes::BlueprintManager::Create(root));
+    RETURN_IF_ERROR(assets->blueprints_->LoadAllBlueprints());
+    ASSIGN_OR_RETURN(assets->levels_, zebes::LevelManager::Create(root));
+    RETURN_IF_ERROR(assets->levels_->LoadAllLevels());
+    return assets;
+  }
+
+  zebes::LevelManager& levels() { return *levels_; }
+
+  absl::StatusOr<const Tileset*> GetTileset(const std::string& id) override {
+    return tilesets_->GetTileset(id);
+  }
+  absl::StatusOr<const Sprite*> GetSprite(const std::string& id) override {
+    return sprites_->GetSprite(id);
+  }
+  absl::StatusOr<const Collider*> GetCollider(const std::string& id) override {
+    return colliders_->GetCollider(id);
+  }
+  absl::StatusOr<const Blueprint*> GetBlueprint(const std::string& id) override {
+    return blueprints_->GetBlueprint(id);
+  }
+  absl::StatusOr<RgbaImage> ReadTexturePixels(const std::string& id) override {
+    return textures_->ReadTexturePixels(id);
+  }
+
+ private:
+  ManagerAssets() = default;
+
+  // Each is declared before whatever holds on to it, so it is destroyed after.
+  DetachedTextureStore store_;
+  std::unique_ptr<zebes::TextureManager> textures_;
+  std::unique_ptr<zebes::TilesetManager> tilesets_;
+  std::unique_ptr<zebes::SpriteManager> sprites_;
+  std::unique_ptr<zebes::ColliderManager> colliders_;
+  std::unique_ptr<zebes::BlueprintManager> blueprints_;
+  std::unique_ptr<zebes::LevelManager> levels_;
+};
+
+// A streamed level's definition holds none of its world content, and a bundle
+// is the whole level, so every region is loaded into it first.
+absl::Status LoadRegions(const std::string& root, zebes::Level& level) {
+  absl::StatusOr<std::unique_ptr<zebes::LevelRegionStore>> store =
+      zebes::LevelRegionStore::Open(root, level.id);
+  if (absl::IsNotFound(store.status())) return absl::OkStatus();
+  RETURN_IF_ERROR(store.status());
+  ASSIGN_OR_RETURN(std::unique_ptr<zebes::LevelStreamer> streamer,
+                   zebes::LevelStreamer::Create(&level, store->get()));
+  return streamer->LoadAll();
+}
+
+absl::Status Run(const std::string& root, const std::string& level_id,
+                 const std::string& output_path) {
+  ASSIGN_OR_RETURN(std::unique_ptr<ManagerAssets> assets, ManagerAssets::Create(root));
+  ASSIGN_OR_RETURN(zebes::Level* level, assets->levels().GetLevel(level_id));
+  RETURN_IF_ERROR(LoadRegions(root, *level));
+  ASSIGN_OR_RETURN(const std::vector<uint8_t> bytes, zebes::CompileLevelBundle(*level, *assets));
+
+  {
+    std::ofstream file(output_path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(bytes.data()),
+               static_cast<std::streamsize>(bytes.size()));
+    if (!file) return absl::InternalError(absl::StrCat("failed to write ", output_path));
+  }
+  // Read it back the way the game will, so a bundle that cannot load is
+  // caught here rather than at startup.
+  ASSIGN_OR_RETURN(std::unique_ptr<zebes::LevelBundle> bundle,
+                   zebes::LevelBundle::Open(output_path));
+  LOG(INFO) << "Wrote " << output_path << ": " << bytes.size() << " bytes, "
+            << bundle->layers().size() << " layers, " << bundle->chunks().size() << " chunks, "
+            << bundle->entities().size() << " entities, " << bundle->textures().size()
+            << " textures";
+  return absl::OkStatus();
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  absl::SetStderrThreshold(absl::LogSeverityAtLeast::kInfo);
+  absl::InitializeLog();
+  if (argc != 4) {
+    LOG(ERROR) << "Usage: " << argv[0] << " <assets_root> <level_id> <output_path>";
+    return 1;
+  }
+  const absl::Status status = Run(argv[1], argv[2], argv[3]);
+  if (!status.ok()) {
+    LOG(ERROR) << status.message();
+    return 1;
+  }
+  return 0;
+}
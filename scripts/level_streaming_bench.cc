@@ -0,0 +1,108 @@
+// Opens a level split with split_level_regions the way the editor does, and
+// reports how long the regions around the spawn point take to become
+// resident, what each streaming update costs while the focus sweeps across the
+// world, and, for comparison, how long loading every region takes.
+//
+// Usage: level_streaming_bench <assets_root> <level_id> [residency_radius]
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/log/globals.h"
+#include "absl/log/initialize.h"
+#include "absl/log/log.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/numbers.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "common/status_macros.h"
+#include "objects/level.h"
+#include "objects/level_region.h"
+#include "resources/level_manager.h"
+#include "resources/level_region_store.h"
+#include "resources/level_streamer.h"
+
+namespace {
+
+void ReportStats(const zebes::LevelStreamerStats& stats) {
+  LOG(INFO) << "  " << stats.resident_regions << " regions resident, about "
+            << stats.resident_bytes / 1024 << " KiB; " << stats.regions_loaded << " loaded, "
+            << stats.regions_evicted << " evicted, " << stats.regions_written << " written";
+}
+
+absl::Status Run(const std::string& root, const std::string& level_id, int radius) {
+  ASSIGN_OR_RETURN(std::unique_ptr<zebes::LevelManager> levels, zebes::LevelManager::Create(root));
+  RETURN_IF_ERROR(levels->LoadAllLevels());
+  ASSIGN_OR_RETURN(const zebes::Level* definition, levels->GetLevel(level_id));
+  ASSIGN_OR_RETURN(std::unique_ptr<zebes::LevelRegionStore> store,
+                   zebes::LevelRegionStore::Open(root, level_id));
+  ASSIGN_OR_RETURN(const std::vector<zebes::LevelRegionCoordinate> stored, store->List());
+  if (stored.empty()) return absl::FailedPreconditionError("the level has no region files");
+
+  // The bench makes no edits, so eviction writes nothing back.
+  zebes::Level level = *definition;
+  ASSIGN_OR_RETURN(std::unique_ptr<zebes::LevelStreamer> streamer,
+                   zebes::LevelStreamer::Create(&level, store.get(),
+                                                {.residency_radius = radius}));
+
+  absl::Time start = absl::Now();
+  RETURN_IF_ERROR(streamer->Update(level.spawn_point));
+  RETURN_IF_ERROR(streamer->WaitForLoads());
+  LOG(INFO) << "Spawn view resident in " << absl::FormatDuration(absl::Now() - start);
+  ReportStats(streamer->stats());
+
+  // One chunk per update along the spawn row, across every stored region.
+  const auto [min_x, max_x] = std::minmax_element(
+      stored.begin(), stored.end(),
+      [](const auto& a, const auto& b) { return a.x < b.x; });
+  const double region_width = static_cast<double>(store->region_chunks()) *
+                              zebes::TileChunk::kSize * level.tile_render_width;
+  const double step = zebes::TileChunk::kSize * level.tile_render_width;
+  std::vector<absl::Duration> updates;
+  for (double x = min_x->x * region_width; x < (max_x->x + 1) * region_width; x += step) {
+    const absl::Time update_start = absl::Now();
+    RETURN_IF_ERROR(streamer->Update({.x = x, .y = level.spawn_point.y}));
+    updates.push_back(absl::Now() - update_start);
+  }
+  RETURN_IF_ERROR(streamer->WaitForLoads());
+  std::sort(updates.begin(), updates.end());
+  LOG(INFO) << "Sweep: " << updates.size() << " updates, p50 "
+            << absl::FormatDuration(updates[updates.size() / 2]) << ", max "
+            << absl::FormatDuration(updates.back());
+  ReportStats(streamer->stats());
+
+  zebes::Level whole = *definition;
+  ASSIGN_OR_RETURN(std::unique_ptr<zebes::LevelStreamer> loader,
+                   zebes::LevelStreamer::Create(&whole, store.get()));
+  start = absl::Now();
+  RETURN_IF_ERROR(loader->LoadAll());
+  LOG(INFO) << "Whole world (" << stored.size() << " regions) resident in "
+            << absl::FormatDuration(absl::Now() - start);
+  ReportStats(loader->stats());
+  return absl::OkStatus();
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  absl::SetStderrThreshold(absl::LogSeverityAtLeast::kInfo);
+  absl::InitializeLog();
+  if (argc != 3 && argc != 4) {
+    LOG(ERROR) << "Usage: " << argv[0] << " <assets_root> <level_id> [residency_radius]";
+    return 1;
+  }
+  int radius = zebes::LevelStreamerOptions().residency_radius;
+  if (argc == 4 && (!absl::SimpleAtoi(argv[3], &radius) || radius < 0)) {
+    LOG(ERROR) << "residency_radius must be a non-negative integer";
+    return 1;
+  }
+  const absl::Status status = Run(argv[1], argv[2], radius);
+  if (!status.ok()) {
+    LOG(ERROR) << status.message();
+    return 1;
+  }
+  return 0;
+}
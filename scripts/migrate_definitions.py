@@ -248,19 +248,18 @@ def migrate_terrain_recipe(document: dict) -> bool:
     return True
 
 
-PROP_RECIPE_SCHEMA_VERSION = 2
+PROP_RECIPE_SCHEMA_VERSION = 3
 PROP_PIPELINE_VERSION = 2
 
+# What a v2 recipe means under v3. v2 predates the working proxy, so every stage
+# read the source itself; full resolution reproduces its pixels exactly. The
+# oversample is PropWorkingProxyConfig's default and is inert while full
+# resolution is selected.
+PROP_V2_WORKING_PROXY = {"full_resolution": True, "minimum_oversample": 8}
 
-def migrate_prop_recipe(document: dict) -> bool:
+
+def _migrate_prop_recipe_v1(document: dict) -> None:
     """Adds explicit grounded attachment semantics without changing output."""
-    version = document.get("schema_version")
-    if version == PROP_RECIPE_SCHEMA_VERSION:
-        return False
-    if version != 1:
-        raise ValueError(
-            f"Cannot migrate prop recipe schema version {version!r}; only 1 is supported"
-        )
     if document.get("pipeline_version") != 1:
         raise ValueError("Cannot migrate prop recipe with a non-v1 pipeline")
 
@@ -275,6 +274,21 @@ def migrate_prop_recipe(document: dict) -> bool:
     composition["attachment"] = {"mode": "grounded", "free_anchor": None}
     cleanup["contact_tolerance"] = cleanup.pop("grounded_tolerance")
     document["pipeline_version"] = PROP_PIPELINE_VERSION
+
+
+def migrate_prop_recipe(document: dict) -> bool:
+    """Upgrades a v1 or v2 recipe in place. Returns whether anything changed."""
+    version = document.get("schema_version")
+    if version == PROP_RECIPE_SCHEMA_VERSION:
+        return False
+    if version not in (1, 2):
+        raise ValueError(
+            f"Cannot migrate prop recipe schema version {version!r}; only 1 and 2 are supported"
+        )
+    if version == 1:
+        _migrate_prop_recipe_v1(document)
+
+    document["pipeline"].setdefault("working_proxy", dict(PROP_V2_WORKING_PROXY))
     document["schema_version"] = PROP_RECIPE_SCHEMA_VERSION
     return True
 
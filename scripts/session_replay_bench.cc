@@ -0,0 +1,188 @@
+// Replays a session recorded with zebes_editor --record_session against the
+// level it was recorded on, headless, and reports how long each frame took and
+// a hash of the level every N frames. A slowdown that only one editing session
+// triggers can then be measured, and compared across builds, without redoing
+// the session by hand.
+//
+// Usage: session_replay_bench <assets_root> <recording> [hash_interval]
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/log/globals.h"
+#include "absl/log/initialize.h"
+#include "absl/log/log.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_format.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+#include "common/status_macros.h"
+#include "editor/level_editor/session_recording.h"
+#include "editor/level_editor/session_replay.h"
+#include "resources/blueprint_manager.h"
+#include "resources/level_manager.h"
+#include "resources/sprite_manager.h"
+#include "resources/texture_manager.h"
+#include "resources/texture_resource_store.h"
+#include "resources/tileset_manager.h"
+
+namespace {
+
+using ::zebes::Blueprint;
+using ::zebes::ReplayFrameTiming;
+using ::zebes::SessionReplayReport;
+using ::zebes::Sprite;
+using ::zebes::TextureHandle;
+using ::zebes::Tileset;
+
+// The frames listed individually, slowest first.
+constexpr size_t kSlowestFrames = 10;
+
+// Sprites need their textures' definitions, never their pixels.
+class DetachedTextureStore : public zebes::TextureResourceStore {
+ public:
+  absl::StatusOr<TextureHandle> Load(const std::string& path) override {
+    return MakeHandle(next_id_++);
+  }
+  absl::StatusOr<TextureHandle> LoadFromPixels(int width, int height,
+                                               absl::Span<const uint8_t> pixels) override {
+    return MakeHandle(next_id_++);
+  }
+  absl::Status Unload(TextureHandle handle) override { return absl::OkStatus(); }
+
+ private:
+  uint64_t next_id_ = 1;
+};
+
+class ManagerAssets : public zebes::SessionReplayAssets {
+ public:
+  static absl::StatusOr<std::unique_ptr<ManagerAssets>> Create(const std::string& root) {
+    std::unique_ptr<ManagerAssets> assets(new ManagerAssets());
+    ASSIGN_OR_RETURN(assets->textures_, zebes::TextureManager::Create(&assets->store_, root));
+    RETURN_IF_ERROR(assets->textures_->LoadAllTextures());
+    ASSIGN_OR_RETURN(assets->tilesets_, zebes::TilesetManager::Create(root));
+    RETURN_IF_ERROR(assets->tilesets_->LoadAllTilesets());
+    ASSIGN_OR_RETURN(assets->sprites_, zebes::SpriteManager::Create(assets->textures_.get(), root));
+    RETURN_IF_ERROR(assets->sprites_->LoadAllSprites());
+    ASSIGN_OR_RETURN(assets->blueprints_, zebes::BlueprintManager::Create(root));
+    RETURN_IF_ERROR(assets->blueprints_->LoadAllBlueprints());
+    ASSIGN_OR_RETURN(assets->levels_, zebes::LevelManager::Create(root));
+    RETURN_IF_ERROR(assets->levels_->LoadAllLevels());
+    return assets;
+  }
+
+  zebes::LevelManager& levels() { return *levels_; }
+
+  absl::StatusOr<const Tileset*> GetTileset(const std::string& id) override {
+    return tilesets_->GetTileset(id);
+  }
+  absl::StatusOr<const Blueprint*> GetBlueprint(const std::string& id) override {
+    return blueprints_->GetBlueprint(id);
+  }
+  absl::StatusOr<const Sprite*> GetSprite(const std::string& id) override {
+    return sprites_->GetSprite(id);
+  }
+
+ private:
+  ManagerAssets() = default;
+
+  // Each is declared before whatever holds on to it, so it is destroyed after.
+  DetachedTextureStore store_;
+  std::unique_ptr<zebes::TextureManager> textures_;
+  std::unique_ptr<zebes::TilesetManager> tilesets_;
+  std::unique_ptr<zebes::SpriteManager> sprites_;
+  std::unique_ptr<zebes::BlueprintManager> blueprints_;
+  std::unique_ptr<zebes::LevelManager> levels_;
+};
+
+// Nearest-rank percentile of durations already sorted ascending.
+absl::Duration Percentile(absl::Span<const absl::Duration> sorted, double percentile) {
+  const size_t rank = static_cast<size_t>(percentile / 100.0 * (sorted.size() - 1) + 0.5);
+  return sorted[std::min(rank, sorted.size() - 1)];
+}
+
+void Report(const SessionReplayReport& report) {
+  if (report.frames.empty()) {
+    LOG(INFO) << "The recording has no frames";
+    return;
+  }
+
+  std::vector<absl::Duration> sorted;
+  sorted.reserve(report.frames.size());
+  absl::Duration total;
+  for (const ReplayFrameTiming& frame : report.frames) {
+    sorted.push_back(frame.elapsed);
+    total += frame.elapsed;
+  }
+  std::sort(sorted.begin(), sorted.end());
+  LOG(INFO) << report.frames.size() << " frames in " << absl::FormatDuration(total)
+            << ": p50 " << absl::FormatDuration(Percentile(sorted, 50)) << ", p95 "
+            << absl::FormatDuration(Percentile(sorted, 95)) << ", p99 "
+            << absl::FormatDuration(Percentile(sorted, 99)) << ", max "
+            << absl::FormatDuration(sorted.back());
+
+  std::vector<ReplayFrameTiming> slowest = report.frames;
+  const size_t listed = std::min(kSlowestFrames, slowest.size());
+  std::partial_sort(slowest.begin(), slowest.begin() + listed, slowest.end(),
+                    [](const ReplayFrameTiming& a, const ReplayFrameTiming& b) {
+                      return a.elapsed > b.elapsed;
+                    });
+  for (size_t i = 0; i < listed; ++i) {
+    LOG(INFO) << "  frame " << slowest[i].frame << ": " << absl::FormatDuration(slowest[i].elapsed)
+              << ", " << slowest[i].commands << " commands";
+  }
+
+  for (const zebes::ReplayCheckpoint& checkpoint : report.checkpoints) {
+    LOG(INFO) << absl::StrFormat("hash after frame %d: %016x", checkpoint.frame, checkpoint.hash);
+  }
+}
+
+absl::Status Run(const std::string& root, const std::string& recording_path,
+                 int64_t hash_interval) {
+  ASSIGN_OR_RETURN(zebes::SessionRecording recording, zebes::ReadSessionRecording(recording_path));
+  if (recording.level_id.empty()) {
+    return absl::FailedPreconditionError("the recording edited no level");
+  }
+  ASSIGN_OR_RETURN(std::unique_ptr<ManagerAssets> assets, ManagerAssets::Create(root));
+  ASSIGN_OR_RETURN(const zebes::Level* level, assets->levels().GetLevel(recording.level_id));
+  if (recording.unrecorded_edit_frame.has_value()) {
+    LOG(WARNING) << "The session edited the level outside the recorded commands on frame "
+                 << *recording.unrecorded_edit_frame << "; replaying only the frames before it";
+  }
+
+  ASSIGN_OR_RETURN(std::unique_ptr<zebes::SessionReplayer> replayer,
+                   zebes::SessionReplayer::Create(*level, std::move(recording), *assets,
+                                                  {.hash_interval = hash_interval}));
+  ASSIGN_OR_RETURN(const SessionReplayReport report, replayer->Run());
+  Report(report);
+  return absl::OkStatus();
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  absl::SetStderrThreshold(absl::LogSeverityAtLeast::kInfo);
+  absl::InitializeLog();
+  if (argc != 3 && argc != 4) {
+    LOG(ERROR) << "Usage: " << argv[0] << " <assets_root> <recording> [hash_interval]";
+    return 1;
+  }
+  int64_t hash_interval = zebes::SessionReplayOptions().hash_interval;
+  if (argc == 4 && (!absl::SimpleAtoi(argv[3], &hash_interval) || hash_interval < 0)) {
+    LOG(ERROR) << "hash interval must be a non-negative integer";
+    return 1;
+  }
+  const absl::Status status = Run(argv[1], argv[2], hash_interval);
+  if (!status.ok()) {
+    LOG(ERROR) << status.message();
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,70 @@
+// Splits one level's world content into region files, leaving its definition
+// with empty layers, so the editor and tools stream it around the camera
+// instead of reading the whole world when it opens.
+//
+// Usage: split_level_regions <assets_root> <level_id> [region_chunks]
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/log/globals.h"
+#include "absl/log/initialize.h"
+#include "absl/log/log.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/numbers.h"
+#include "common/status_macros.h"
+#include "objects/level.h"
+#include "objects/level_region.h"
+#include "resources/level_manager.h"
+#include "resources/level_region_store.h"
+
+namespace {
+
+absl::Status Run(const std::string& root, const std::string& level_id, int region_chunks) {
+  ASSIGN_OR_RETURN(std::unique_ptr<zebes::LevelManager> levels, zebes::LevelManager::Create(root));
+  RETURN_IF_ERROR(levels->LoadAllLevels());
+  ASSIGN_OR_RETURN(const zebes::Level* level, levels->GetLevel(level_id));
+  ASSIGN_OR_RETURN(std::unique_ptr<zebes::LevelRegionStore> store,
+                   zebes::LevelRegionStore::Create(root, level_id, region_chunks));
+
+  zebes::Level skeleton = *level;
+  const std::vector<zebes::LevelRegion> regions = zebes::TakeAllRegions(skeleton, region_chunks);
+  size_t bytes = 0;
+  for (const zebes::LevelRegion& region : regions) {
+    RETURN_IF_ERROR(store->Write(region));
+    bytes += region.EstimatedBytes();
+  }
+  // Only once every region is on disk, so a failed split leaves the original
+  // definition whole.
+  RETURN_IF_ERROR(levels->SaveLevel(skeleton));
+
+  LOG(INFO) << "Split " << level->name << " into " << regions.size() << " regions of "
+            << region_chunks << "x" << region_chunks << " chunks, about " << bytes / 1024
+            << " KiB resident when all are loaded";
+  return absl::OkStatus();
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  absl::SetStderrThreshold(absl::LogSeverityAtLeast::kInfo);
+  absl::InitializeLog();
+  if (argc != 3 && argc != 4) {
+    LOG(ERROR) << "Usage: " << argv[0] << " <assets_root> <level_id> [region_chunks]";
+    return 1;
+  }
+  int region_chunks = zebes::kDefaultRegionChunks;
+  if (argc == 4 && (!absl::SimpleAtoi(argv[3], &region_chunks) || region_chunks <= 0)) {
+    LOG(ERROR) << "region_chunks must be a positive integer";
+    return 1;
+  }
+  const absl::Status status = Run(argv[1], argv[2], region_chunks);
+  if (!status.ok()) {
+    LOG(ERROR) << status.message();
+    return 1;
+  }
+  return 0;
+}
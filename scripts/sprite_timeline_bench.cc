@@ -0,0 +1,79 @@
+// Evaluates the current frame of many entities sharing one sprite, in a batch
+// through SpriteTimeline, and reports the cost per entity.
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "absl/log/globals.h"
+#include "absl/log/initialize.h"
+#include "absl/log/log.h"
+#include "absl/strings/numbers.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "objects/sprite.h"
+#include "objects/sprite_timeline.h"
+
+namespace {
+
+using ::zebes::SpriteFrame;
+using ::zebes::SpriteTimeline;
+
+constexpr int kRuns = 5;
+
+void Run(int entities, int frames, int ticks) {
+  std::mt19937 random(23);
+  std::uniform_int_distribution<int> duration(1, 12);
+  std::vector<SpriteFrame> sprite_frames(frames);
+  for (int i = 0; i < frames; ++i) {
+    sprite_frames[i] = {.index = i, .frames_per_cycle = duration(random)};
+  }
+  const SpriteTimeline timeline(sprite_frames);
+
+  // Staggered starts, so neighbouring entities are on different frames.
+  std::uniform_int_distribution<int64_t> start(0, 10000);
+  std::vector<int64_t> start_ticks(entities);
+  for (int64_t& tick : start_ticks) tick = start(random);
+  std::vector<int> indices(entities);
+
+  absl::Duration best = absl::InfiniteDuration();
+  int64_t checksum = 0;
+  for (int run = 0; run < kRuns; ++run) {
+    checksum = 0;
+    const absl::Time begin = absl::Now();
+    for (int64_t now = 0; now < ticks; ++now) {
+      timeline.FrameIndicesAt(now, start_ticks, absl::MakeSpan(indices));
+      checksum += indices[now % entities];
+    }
+    best = std::min(best, absl::Now() - begin);
+  }
+
+  const double evaluations = static_cast<double>(entities) * ticks;
+  LOG(INFO) << entities << " entities on a " << frames << "-frame sprite over " << ticks
+            << " ticks: best of " << kRuns << " took " << absl::FormatDuration(best) << ", "
+            << absl::ToDoubleNanoseconds(best) / evaluations << " ns per entity (checksum "
+            << checksum << ")";
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  absl::SetStderrThreshold(absl::LogSeverityAtLeast::kInfo);
+  absl::InitializeLog();
+  int entities = 100000;
+  int frames = 12;
+  int ticks = 120;
+  if (argc != 1 && argc != 4) {
+    LOG(ERROR) << "Usage: " << argv[0] << " [entities frames ticks]";
+    return 1;
+  }
+  if (argc == 4 &&
+      (!absl::SimpleAtoi(argv[1], &entities) || !absl::SimpleAtoi(argv[2], &frames) ||
+       !absl::SimpleAtoi(argv[3], &ticks) || entities <= 0 || frames <= 0 || ticks <= 0)) {
+    LOG(ERROR) << "entity, frame and tick counts must be positive integers";
+    return 1;
+  }
+  Run(entities, frames, ticks);
+  return 0;
+}
@@ -0,0 +1,135 @@
+// Sweeps boxes and points through a large generated tile layer and reports how
+// many collision queries run per millisecond.
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <random>
+#include <vector>
+
+#include "absl/log/globals.h"
+#include "absl/log/initialize.h"
+#include "absl/log/log.h"
+#include "absl/status/status.h"
+#include "absl/strings/numbers.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "common/status_macros.h"
+#include "objects/level.h"
+#include "objects/tileset.h"
+#include "runtime/tile_collision.h"
+
+namespace {
+
+using ::zebes::ChunkKey;
+using ::zebes::Tile;
+using ::zebes::TileChunk;
+using ::zebes::TileCollisionMap;
+using ::zebes::TileShape;
+using ::zebes::TileSweepHit;
+using ::zebes::Tileset;
+using ::zebes::Vec;
+using ::zebes::WorldLayer;
+
+constexpr int kTileSize = 16;
+constexpr int kRuns = 5;
+
+// Rolling ground with slopes and scattered floating blocks: the mix a
+// platformer's queries actually meet, rather than open air or solid rock.
+WorldLayer MakeLayer(int width, int height) {
+  std::mt19937 random(17);
+  std::uniform_int_distribution<int> shape(TileShape::kFullBlock,
+                                           TileShape::kSteepSlopeCeilingTallLeftTop);
+  std::bernoulli_distribution floating(0.04);
+  std::uniform_int_distribution<int> step(-1, 1);
+  WorldLayer layer;
+  auto set = [&](int x, int y, int tile_id) {
+    TileChunk& chunk = layer.tile_chunks[ChunkKey(x / TileChunk::kSize, y / TileChunk::kSize)];
+    chunk.SetTile((y % TileChunk::kSize) * TileChunk::kSize + x % TileChunk::kSize, tile_id);
+  };
+  int ground = height * 3 / 4;
+  for (int x = 0; x < width; ++x) {
+    ground = std::clamp(ground + step(random), height / 2, height - 2);
+    set(x, ground, shape(random));
+    for (int y = ground + 1; y < height; ++y) set(x, y, TileShape::kFullBlock);
+    for (int y = 0; y < ground; ++y) {
+      if (floating(random)) set(x, y, shape(random));
+    }
+  }
+  return layer;
+}
+
+absl::Status Run(int width, int height, int queries) {
+  Tileset tileset;
+  for (int shape = TileShape::kFullBlock; shape <= TileShape::kSteepSlopeCeilingTallLeftTop;
+       ++shape) {
+    tileset.tiles.push_back(Tile{.id = shape, .shape = static_cast<TileShape>(shape)});
+  }
+  ASSIGN_OR_RETURN(const TileCollisionMap map,
+                   TileCollisionMap::Create(MakeLayer(width, height), tileset, kTileSize,
+                                            kTileSize));
+
+  // Drawn up front so the timed loop measures queries alone. Motions span up
+  // to four tiles, a fast body's worth per step.
+  std::mt19937 random(29);
+  std::uniform_real_distribution<double> x(0, width * kTileSize);
+  std::uniform_real_distribution<double> y(0, height * kTileSize);
+  std::uniform_real_distribution<double> motion(-4 * kTileSize, 4 * kTileSize);
+  std::uniform_real_distribution<double> extent(0, kTileSize);
+  struct Query {
+    Vec start;
+    Vec half_extents;
+    Vec delta;
+  };
+  std::vector<Query> batch(queries);
+  for (Query& query : batch) {
+    query = {.start = {.x = x(random), .y = y(random)},
+             .half_extents = {.x = extent(random), .y = extent(random)},
+             .delta = {.x = motion(random), .y = motion(random)}};
+  }
+
+  absl::Duration best = absl::InfiniteDuration();
+  int hits = 0;
+  for (int run = 0; run < kRuns; ++run) {
+    hits = 0;
+    const absl::Time start = absl::Now();
+    for (const Query& query : batch) {
+      const std::optional<TileSweepHit> hit =
+          map.SweepBox(query.start, query.half_extents, query.delta);
+      if (hit.has_value()) ++hits;
+    }
+    best = std::min(best, absl::Now() - start);
+  }
+
+  LOG(INFO) << queries << " sweeps over " << width << "x" << height << " tiles: best of " << kRuns
+            << " took " << absl::FormatDuration(best) << ", "
+            << queries / absl::ToDoubleMilliseconds(best) << " sweeps per ms (" << hits
+            << " hit)";
+  return absl::OkStatus();
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  absl::SetStderrThreshold(absl::LogSeverityAtLeast::kInfo);
+  absl::InitializeLog();
+  int width = 4096;
+  int height = 512;
+  int queries = 200000;
+  if (argc != 1 && argc != 4) {
+    LOG(ERROR) << "Usage: " << argv[0] << " [width_tiles height_tiles queries]";
+    return 1;
+  }
+  if (argc == 4 &&
+      (!absl::SimpleAtoi(argv[1], &width) || !absl::SimpleAtoi(argv[2], &height) ||
+       !absl::SimpleAtoi(argv[3], &queries) || width <= 0 || height <= 1 || queries <= 0)) {
+    LOG(ERROR) << "dimensions and query count must be positive integers, height above one";
+    return 1;
+  }
+  const absl::Status status = Run(width, height, queries);
+  if (!status.ok()) {
+    LOG(ERROR) << status.message();
+    return 1;
+  }
+  return 0;
+}
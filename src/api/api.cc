@@ -148,6 +148,15 @@ absl::StatusOr<RgbaImage> Api::ReadTexturePixels(const std::string& texture_id)
   return texture_manager_->ReadTexturePixels(texture_id);
 }
 
+absl::StatusOr<TextureHandle> Api::LoadTransientTexture(int width, int height,
+                                                        absl::Span<const uint8_t> pixels) {
+  return texture_manager_->LoadTransientTexture(width, height, pixels);
+}
+
+void Api::UnloadTransientTexture(TextureHandle handle) {
+  texture_manager_->UnloadTransientTexture(handle);
+}
+
 absl::Status Api::UpdateTexture(const Texture& texture) {
   return texture_manager_->UpdateTexture(texture);
 }
@@ -65,6 +65,11 @@ class Api {
   // Decodes a texture's artwork back off disk. See
   // TextureManager::ReadTexturePixels.
   virtual absl::StatusOr<RgbaImage> ReadTexturePixels(const std::string& texture_id);
+  // Display-only artwork with no definition behind it. See
+  // TextureManager::LoadTransientTexture.
+  virtual absl::StatusOr<TextureHandle> LoadTransientTexture(int width, int height,
+                                                             absl::Span<const uint8_t> pixels);
+  virtual void UnloadTransientTexture(TextureHandle handle);
   virtual absl::Status DeleteTexture(const std::string& texture_id);
   virtual absl::StatusOr<std::vector<Texture>> GetAllTextures();
   virtual absl::Status UpdateTexture(const Texture& texture);
@@ -2,60 +2,18 @@
 
 #include <algorithm>
 #include <cstddef>
-#include <queue>
+#include <cstdint>
+#include <functional>
 #include <vector>
 
 #include "absl/status/status.h"
 #include "absl/strings/str_cat.h"
+#include "artwork/connected_components.h"
+#include "common/status_macros.h"
 
 namespace zebes {
 namespace {
 
-struct Component {
-  std::vector<size_t> pixels;
-};
-
-std::vector<Component> FindComponents(const RgbaImage& image) {
-  const size_t pixel_count = static_cast<size_t>(image.width) * image.height;
-  std::vector<uint8_t> visited(pixel_count, 0);
-  std::vector<Component> components;
-  std::queue<size_t> pending;
-  for (size_t start = 0; start < pixel_count; ++start) {
-    if (visited[start] != 0 || image.pixels[start * 4 + 3] == 0) continue;
-    visited[start] = 1;
-    pending.push(start);
-    Component component;
-    while (!pending.empty()) {
-      const size_t pixel = pending.front();
-      pending.pop();
-      component.pixels.push_back(pixel);
-      const int x = static_cast<int>(pixel % image.width);
-      const int y = static_cast<int>(pixel / image.width);
-      for (int dy = -1; dy <= 1; ++dy) {
-        for (int dx = -1; dx <= 1; ++dx) {
-          if (dx == 0 && dy == 0) continue;
-          const int neighbor_x = x + dx;
-          const int neighbor_y = y + dy;
-          if (neighbor_x < 0 || neighbor_y < 0 || neighbor_x >= image.width ||
-              neighbor_y >= image.height) {
-            continue;
-          }
-          const size_t neighbor = static_cast<size_t>(neighbor_y) * image.width + neighbor_x;
-          if (visited[neighbor] != 0 || image.pixels[neighbor * 4 + 3] == 0) continue;
-          visited[neighbor] = 1;
-          pending.push(neighbor);
-        }
-      }
-    }
-    components.push_back(std::move(component));
-  }
-  std::sort(components.begin(), components.end(),
-            [](const Component& left, const Component& right) {
-              return left.pixels.size() > right.pixels.size();
-            });
-  return components;
-}
-
 bool PaletteContains(absl::Span<const RgbaColor> palette, const RgbaColor& candidate) {
   for (const RgbaColor& color : palette) {
     if (color == candidate) return true;
@@ -94,24 +52,35 @@ absl::StatusOr<PropArtwork> CleanupAndValidateProp(const PropArtwork& artwork,
     std::fill_n(cleaned.image.pixels.begin() + static_cast<ptrdiff_t>(offset), 4, 0);
   }
 
-  std::vector<Component> components = FindComponents(cleaned.image);
-  if (components.empty()) return absl::FailedPreconditionError("cleaned prop has no subject");
-  if (components.front().pixels.size() < static_cast<size_t>(config.minimum_component_area)) {
+  std::vector<uint8_t> opaque(pixel_count, 0);
+  for (size_t pixel = 0; pixel < pixel_count; ++pixel) {
+    opaque[pixel] = cleaned.image.pixels[pixel * 4 + 3] != 0 ? 1 : 0;
+  }
+  ASSIGN_OR_RETURN(const ConnectedComponents components,
+                   LabelConnectedComponents(opaque, cleaned.image.width, cleaned.image.height,
+                                            Connectivity::kEight));
+  const auto largest = std::max_element(components.areas.begin(), components.areas.end());
+  if (largest == components.areas.end()) {
+    return absl::FailedPreconditionError("cleaned prop has no subject");
+  }
+  if (*largest < config.minimum_component_area) {
     return absl::FailedPreconditionError("cleaned prop has no component meeting the minimum area");
   }
-  for (size_t index = 0; index < components.size(); ++index) {
-    const Component& component = components[index];
-    if (component.pixels.size() >= static_cast<size_t>(config.minimum_component_area)) {
-      if (index > 0) {
-        return absl::FailedPreconditionError(
-            absl::StrCat("cleaned prop has a second substantial component of ",
-                         component.pixels.size(), " pixels"));
-      }
-      continue;
-    }
-    for (const size_t pixel : component.pixels) {
-      std::fill_n(cleaned.image.pixels.begin() + static_cast<ptrdiff_t>(pixel * 4), 4, 0);
-    }
+  // The subject is the largest component; any other that meets the minimum
+  // competes with it, and any that does not is a speck.
+  std::vector<int> substantial;
+  for (const int area : components.areas) {
+    if (area >= config.minimum_component_area) substantial.push_back(area);
+  }
+  if (substantial.size() > 1) {
+    std::sort(substantial.begin(), substantial.end(), std::greater<>());
+    return absl::FailedPreconditionError(absl::StrCat(
+        "cleaned prop has a second substantial component of ", substantial[1], " pixels"));
+  }
+  for (size_t pixel = 0; pixel < pixel_count; ++pixel) {
+    const uint32_t label = components.labels[pixel];
+    if (label == 0 || components.areas[label - 1] >= config.minimum_component_area) continue;
+    std::fill_n(cleaned.image.pixels.begin() + static_cast<ptrdiff_t>(pixel * 4), 4, 0);
   }
 
   if (attachment_mode != PropAttachmentMode::kFree) {
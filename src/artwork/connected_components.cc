@@ -0,0 +1,148 @@
+#include "artwork/connected_components.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "common/parallel_for.h"
+#include "common/status_macros.h"
+
+namespace zebes {
+namespace {
+
+// Rows labelled by one ParallelFor item. Only the first row of each band needs
+// merging with the band above, so taller bands mean less serial work.
+constexpr int kRowsPerBand = 64;
+
+// A forest over pixel indices in which every parent precedes its child in
+// raster order, so each tree's root is its component's first pixel.
+class PixelForest {
+ public:
+  explicit PixelForest(std::vector<uint32_t>& parents) : parents_(parents) {}
+
+  void MakeRoot(uint32_t pixel) { parents_[pixel] = pixel; }
+  void Attach(uint32_t pixel, uint32_t parent) { parents_[pixel] = parent; }
+
+  uint32_t Find(uint32_t pixel) {
+    while (parents_[pixel] != pixel) {
+      // Path halving keeps parents ahead of their children.
+      parents_[pixel] = parents_[parents_[pixel]];
+      pixel = parents_[pixel];
+    }
+    return pixel;
+  }
+
+  void Union(uint32_t a, uint32_t b) {
+    a = Find(a);
+    b = Find(b);
+    if (a == b) return;
+    if (a < b) {
+      parents_[b] = a;
+    } else {
+      parents_[a] = b;
+    }
+  }
+
+ private:
+  std::vector<uint32_t>& parents_;
+};
+
+}  // namespace
+
+absl::StatusOr<ConnectedComponents> LabelConnectedComponents(absl::Span<const uint8_t> mask,
+                                                             int width, int height,
+                                                             Connectivity connectivity) {
+  if (width <= 0 || height <= 0) {
+    return absl::InvalidArgumentError("component mask dimensions are invalid");
+  }
+  const size_t pixel_count = static_cast<size_t>(width) * height;
+  if (pixel_count > static_cast<size_t>(std::numeric_limits<int>::max())) {
+    return absl::InvalidArgumentError("component mask is too large to label");
+  }
+  if (mask.size() != pixel_count) {
+    return absl::InvalidArgumentError("component mask size does not match its dimensions");
+  }
+
+  const bool corners = connectivity == Connectivity::kEight;
+  ConnectedComponents components;
+  // Holds the forest until the final pass overwrites it with labels.
+  std::vector<uint32_t>& parents = components.labels;
+  parents.assign(pixel_count, 0);
+  PixelForest forest(parents);
+
+  // First pass. Each band links its pixels only to pixels earlier in the same
+  // band, so bands write disjoint parts of the forest. A set neighbour above
+  // is already joined to every other earlier neighbour but the one above and
+  // to the right, so most pixels take a single link and no union at all.
+  const int bands = (height + kRowsPerBand - 1) / kRowsPerBand;
+  RETURN_IF_ERROR(ParallelFor(bands, /*max_workers=*/0, [&](int band) {
+    const int band_start = band * kRowsPerBand;
+    const int band_end = std::min(height, band_start + kRowsPerBand);
+    for (int y = band_start; y < band_end; ++y) {
+      const bool has_above = y > band_start;
+      for (int x = 0; x < width; ++x) {
+        const uint32_t pixel = static_cast<uint32_t>(y) * width + x;
+        if (mask[pixel] == 0) continue;
+        const uint32_t above = pixel - width;
+        const bool left = x > 0 && mask[pixel - 1] != 0;
+        if (has_above && mask[above] != 0) {
+          forest.Attach(pixel, above);
+          if (!corners && left) forest.Union(pixel, pixel - 1);
+          continue;
+        }
+        const bool above_left = corners && has_above && x > 0 && mask[above - 1] != 0;
+        const bool above_right = corners && has_above && x + 1 < width && mask[above + 1] != 0;
+        if (left) {
+          forest.Attach(pixel, pixel - 1);
+        } else if (above_left) {
+          forest.Attach(pixel, above - 1);
+        } else if (above_right) {
+          forest.Attach(pixel, above + 1);
+          continue;
+        } else {
+          forest.MakeRoot(pixel);
+          continue;
+        }
+        if (above_right) forest.Union(pixel, above + 1);
+      }
+    }
+    return absl::OkStatus();
+  }));
+
+  // Merge each band's first row into the band above.
+  for (int band = 1; band < bands; ++band) {
+    const uint32_t row = static_cast<uint32_t>(band) * kRowsPerBand * width;
+    for (int x = 0; x < width; ++x) {
+      const uint32_t pixel = row + x;
+      if (mask[pixel] == 0) continue;
+      const uint32_t above = pixel - width;
+      if (mask[above] != 0) forest.Union(pixel, above);
+      if (!corners) continue;
+      if (x > 0 && mask[above - 1] != 0) forest.Union(pixel, above - 1);
+      if (x + 1 < width && mask[above + 1] != 0) forest.Union(pixel, above + 1);
+    }
+  }
+
+  // Every parent precedes its child, so by the time a pixel is reached its
+  // parent already holds the component's label.
+  for (size_t pixel = 0; pixel < pixel_count; ++pixel) {
+    if (mask[pixel] == 0) {
+      parents[pixel] = 0;
+      continue;
+    }
+    const uint32_t parent = parents[pixel];
+    if (parent == pixel) {
+      components.areas.push_back(0);
+      parents[pixel] = static_cast<uint32_t>(components.areas.size());
+    } else {
+      parents[pixel] = parents[parent];
+    }
+    ++components.areas[parents[pixel] - 1];
+  }
+  return components;
+}
+
+}  // namespace zebes
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+
+namespace zebes {
+
+enum class Connectivity {
+  // Edge neighbours only.
+  kFour,
+  // Edge and corner neighbours.
+  kEight,
+};
+
+struct ConnectedComponents {
+  // One per mask pixel: zero where the mask is zero, otherwise the pixel's
+  // component. Components are numbered from one in the raster order of their
+  // first pixel, so the labelling does not depend on how the work was split.
+  std::vector<uint32_t> labels;
+  // areas[label - 1] is that component's pixel count.
+  std::vector<int> areas;
+};
+
+// Labels the connected non-zero pixels of a row-major `width` x `height` mask.
+//
+// Two scanline passes over a union-find forest instead of a flood fill: bands
+// of rows are labelled in parallel, the rows where bands meet are merged, and
+// one final pass in raster order turns roots into labels. Cost is linear in
+// the pixel count whatever the shapes, and no pixel is visited out of order.
+absl::StatusOr<ConnectedComponents> LabelConnectedComponents(absl::Span<const uint8_t> mask,
+                                                             int width, int height,
+                                                             Connectivity connectivity);
+
+}  // namespace zebes
@@ -5,11 +5,12 @@
 #include <cmath>
 #include <cstddef>
 #include <cstdint>
-#include <queue>
 #include <vector>
 
 #include "absl/status/status.h"
 #include "absl/strings/str_cat.h"
+#include "artwork/connected_components.h"
+#include "common/status_macros.h"
 
 namespace zebes {
 namespace {
@@ -42,42 +43,6 @@ uint8_t BorderMedian(const RgbaImage& image, int channel) {
   return 0;
 }
 
-std::vector<int> ComponentAreas(const std::vector<uint8_t>& foreground, int width, int height) {
-  std::vector<uint8_t> visited(foreground.size(), 0);
-  std::vector<int> areas;
-  std::queue<size_t> pending;
-  for (size_t start = 0; start < foreground.size(); ++start) {
-    if (foreground[start] == 0 || visited[start] != 0) continue;
-    visited[start] = 1;
-    pending.push(start);
-    int area = 0;
-    while (!pending.empty()) {
-      const size_t pixel = pending.front();
-      pending.pop();
-      ++area;
-      const int x = static_cast<int>(pixel % width);
-      const int y = static_cast<int>(pixel / width);
-      for (int dy = -1; dy <= 1; ++dy) {
-        for (int dx = -1; dx <= 1; ++dx) {
-          if (dx == 0 && dy == 0) continue;
-          const int neighbor_x = x + dx;
-          const int neighbor_y = y + dy;
-          if (neighbor_x < 0 || neighbor_y < 0 || neighbor_x >= width || neighbor_y >= height) {
-            continue;
-          }
-          const size_t neighbor = static_cast<size_t>(neighbor_y) * width + neighbor_x;
-          if (foreground[neighbor] == 0 || visited[neighbor] != 0) continue;
-          visited[neighbor] = 1;
-          pending.push(neighbor);
-        }
-      }
-    }
-    areas.push_back(area);
-  }
-  std::sort(areas.begin(), areas.end(), std::greater<>());
-  return areas;
-}
-
 }  // namespace
 
 absl::StatusOr<RgbaImage> IsolateSubject(const RgbaImage& source,
@@ -124,47 +89,36 @@ absl::StatusOr<RgbaImage> IsolateSubject(const RgbaImage& source,
       background_candidate[pixel] = distance_squared <= threshold_squared ? 1 : 0;
     }
 
-    std::vector<uint8_t> exterior(pixel_count, 0);
-    std::queue<size_t> pending;
-    const auto enqueue = [&](int x, int y) {
-      const size_t pixel = PixelIndex(source, x, y);
-      if (background_candidate[pixel] == 0 || exterior[pixel] != 0) return;
-      exterior[pixel] = 1;
-      pending.push(pixel);
+    // Background is whatever candidate region reaches the border.
+    ASSIGN_OR_RETURN(const ConnectedComponents candidates,
+                     LabelConnectedComponents(background_candidate, source.width, source.height,
+                                              Connectivity::kFour));
+    std::vector<uint8_t> exterior_label(candidates.areas.size() + 1, 0);
+    const auto mark_exterior = [&](int x, int y) {
+      exterior_label[candidates.labels[PixelIndex(source, x, y)]] = 1;
     };
     for (int x = 0; x < source.width; ++x) {
-      enqueue(x, 0);
-      enqueue(x, source.height - 1);
+      mark_exterior(x, 0);
+      mark_exterior(x, source.height - 1);
     }
     for (int y = 0; y < source.height; ++y) {
-      enqueue(0, y);
-      enqueue(source.width - 1, y);
-    }
-
-    constexpr std::array<int, 4> kDx = {-1, 1, 0, 0};
-    constexpr std::array<int, 4> kDy = {0, 0, -1, 1};
-    while (!pending.empty()) {
-      const size_t pixel = pending.front();
-      pending.pop();
-      const int x = static_cast<int>(pixel % source.width);
-      const int y = static_cast<int>(pixel / source.width);
-      for (size_t direction = 0; direction < kDx.size(); ++direction) {
-        const int neighbor_x = x + kDx[direction];
-        const int neighbor_y = y + kDy[direction];
-        if (neighbor_x < 0 || neighbor_y < 0 || neighbor_x >= source.width ||
-            neighbor_y >= source.height) {
-          continue;
-        }
-        enqueue(neighbor_x, neighbor_y);
-      }
+      mark_exterior(0, y);
+      mark_exterior(source.width - 1, y);
     }
+    // Label zero is not a candidate at all.
+    exterior_label[0] = 0;
     for (size_t pixel = 0; pixel < pixel_count; ++pixel) {
       const bool enclosed_background = background_distances[pixel] <= enclosed_threshold_squared;
-      foreground[pixel] = exterior[pixel] == 0 && !enclosed_background ? 1 : 0;
+      const bool exterior = exterior_label[candidates.labels[pixel]] != 0;
+      foreground[pixel] = !exterior && !enclosed_background ? 1 : 0;
     }
   }
 
-  const std::vector<int> areas = ComponentAreas(foreground, source.width, source.height);
+  ASSIGN_OR_RETURN(ConnectedComponents subjects,
+                   LabelConnectedComponents(foreground, source.width, source.height,
+                                            Connectivity::kEight));
+  std::vector<int>& areas = subjects.areas;
+  std::sort(areas.begin(), areas.end(), std::greater<>());
   if (areas.empty() || areas.front() < config.minimum_subject_area) {
     return absl::FailedPreconditionError("subject isolation found no usable foreground");
   }
@@ -54,7 +54,8 @@ std::string PropTexturePath(std::string_view texture_id) {
 
 absl::StatusOr<PreparedPropAsset> PreparePropAsset(const SourceArtwork& source,
                                                    const RgbaImage& source_pixels,
-                                                   const PreparePropAssetRequest& request) {
+                                                   const PreparePropAssetRequest& request,
+                                                   PropArtworkPipelineCache* cache) {
   RETURN_IF_ERROR(ValidateSourceArtwork(source));
   RETURN_IF_ERROR(ValidateName(request.name));
   RETURN_IF_ERROR(ValidateIds(request.ids));
@@ -62,14 +63,18 @@ absl::StatusOr<PreparedPropAsset> PreparePropAsset(const SourceArtwork& source,
     return absl::FailedPreconditionError(
         "retained source dimensions do not match the accepted source artwork");
   }
-  ASSIGN_OR_RETURN(const std::string source_digest, RgbaImageDigest(source_pixels));
+  ASSIGN_OR_RETURN(const std::string source_digest, cache != nullptr
+                                                        ? cache->SourceDigest(source_pixels)
+                                                        : RgbaImageDigest(source_pixels));
   if (source_digest != source.content_digest) {
     return absl::FailedPreconditionError(
         "retained source pixels do not match the accepted source artwork digest");
   }
 
   ASSIGN_OR_RETURN(PropArtworkPipelineResult artwork,
-                   RunPropArtworkPipeline(source_pixels, request.style, request.pipeline));
+                   cache != nullptr
+                       ? cache->Run(source_pixels, request.style, request.pipeline)
+                       : RunPropArtworkPipeline(source_pixels, request.style, request.pipeline));
   const RgbaImage& finished = artwork.finished.image;
   ASSIGN_OR_RETURN(const std::string final_digest, RgbaImageDigest(finished));
 
@@ -46,9 +46,13 @@ struct PreparedPropAsset {
 
 // Pure over its arguments: no resource catalogue, renderer, or filesystem is
 // touched. The retained source pixels are the reproducibility authority.
+//
+// A `cache` carried between calls skips the pipeline stages whose inputs did
+// not change since the last call; the result is the same either way.
 absl::StatusOr<PreparedPropAsset> PreparePropAsset(const SourceArtwork& source,
                                                    const RgbaImage& source_pixels,
-                                                   const PreparePropAssetRequest& request);
+                                                   const PreparePropAssetRequest& request,
+                                                   PropArtworkPipelineCache* cache = nullptr);
 
 // Rechecks the complete internal graph and pixel digests before a prepared
 // bundle crosses the persistence boundary.
@@ -1,11 +1,17 @@
 #include "artwork/prop_artwork_pipeline.h"
 
+#include <algorithm>
 #include <array>
 #include <cstddef>
 #include <cstdint>
 #include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
 #include <utility>
 
+#include "absl/hash/hash.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
@@ -55,6 +61,205 @@ PropStageDiagnostic Diagnostic(PropArtworkStage stage, const RgbaImage& image) {
   };
 }
 
+// Settings derived once per run and read by more than one stage.
+struct RunSetup {
+  int output_width = 0;
+  int output_height = 0;
+  // The size isolation works at; the source's own when no proxy is used.
+  int working_width = 0;
+  int working_height = 0;
+  PropRasterConfig raster;
+};
+
+int HalvedSize(int size, int halvings) {
+  return static_cast<int>((static_cast<int64_t>(size) + (int64_t{1} << halvings) - 1) >>
+                          halvings);
+}
+
+// Halves the source while both sides stay at least `oversample` times the
+// output's. Halving rounds up, so an odd edge keeps its last pixel.
+std::pair<int, int> WorkingSize(const RgbaImage& source, int output_width, int output_height,
+                                const PropWorkingProxyConfig& proxy) {
+  if (proxy.full_resolution) return {source.width, source.height};
+  const int64_t minimum_width = static_cast<int64_t>(output_width) * proxy.minimum_oversample;
+  const int64_t minimum_height = static_cast<int64_t>(output_height) * proxy.minimum_oversample;
+  int halvings = 0;
+  while (halvings < 30 && HalvedSize(source.width, halvings + 1) >= minimum_width &&
+         HalvedSize(source.height, halvings + 1) >= minimum_height) {
+    ++halvings;
+  }
+  return {HalvedSize(source.width, halvings), HalvedSize(source.height, halvings)};
+}
+
+absl::StatusOr<RunSetup> ValidateRun(const RgbaImage& source, const PropArtworkStyle& style,
+                                     const PropArtworkPipelineConfig& config) {
+  RETURN_IF_ERROR(ValidatePropSource(source, config.source_limits));
+  RETURN_IF_ERROR(ValidatePropArtworkStyle(style));
+
+  const int64_t output_width =
+      static_cast<int64_t>(style.tile_size) * config.composition.canvas_tiles_wide;
+  const int64_t output_height =
+      static_cast<int64_t>(style.tile_size) * config.composition.canvas_tiles_high;
+  if (output_width <= 0 || output_height <= 0 || output_width > std::numeric_limits<int>::max() ||
+      output_height > std::numeric_limits<int>::max()) {
+    return absl::InvalidArgumentError("prop output dimensions overflow integer storage");
+  }
+  RETURN_IF_ERROR(ValidatePropAttachment(config.composition.attachment,
+                                         static_cast<int>(output_width),
+                                         static_cast<int>(output_height)));
+  if (config.working_proxy.minimum_oversample <= 0) {
+    return absl::InvalidArgumentError("working proxy oversample must be positive");
+  }
+  const auto [working_width, working_height] =
+      WorkingSize(source, static_cast<int>(output_width), static_cast<int>(output_height),
+                  config.working_proxy);
+  return RunSetup{
+      .output_width = static_cast<int>(output_width),
+      .output_height = static_cast<int>(output_height),
+      .working_width = working_width,
+      .working_height = working_height,
+      .raster =
+          PropRasterConfig{
+              .tile_size = style.tile_size,
+              .canvas_tiles_wide = config.composition.canvas_tiles_wide,
+              .canvas_tiles_high = config.composition.canvas_tiles_high,
+              .pixel_block_size = style.pixel_block_size,
+          },
+  };
+}
+
+int StageIndex(PropArtworkStage stage) { return static_cast<int>(stage); }
+
+// Runs the stages from `first` on, leaving the earlier stages of `result` as
+// they are. `completed` counts the leading stages of `result` that are filled,
+// so a stage that fails leaves it at that stage. Quantization reuses
+// `palette_lookup` when it was built for the same colours, and otherwise
+// replaces it.
+absl::Status RunStages(int first, const RgbaImage& source, const PropArtworkStyle& style,
+                       const PropArtworkPipelineConfig& config, const RunSetup& setup,
+                       PropArtworkPipelineResult& result, int& completed,
+                       std::shared_ptr<const PropPaletteLookup>& palette_lookup) {
+  using Stage = PropArtworkStage;
+  const auto runs = [&](Stage stage) { return first <= StageIndex(stage); };
+  const auto finish = [&](Stage stage, const RgbaImage& image) {
+    result.diagnostics[StageIndex(stage)] = Diagnostic(stage, image);
+    completed = StageIndex(stage) + 1;
+  };
+  completed = first;
+
+  if (runs(Stage::kIsolation)) {
+    if (setup.working_width == source.width && setup.working_height == source.height) {
+      ASSIGN_OR_RETURN(result.isolated,
+                       AtStage(Stage::kIsolation, IsolateSubject(source, config.isolation)));
+    } else {
+      ASSIGN_OR_RETURN(const RgbaImage working,
+                       AtStage(Stage::kIsolation, AreaResample(source, setup.working_width,
+                                                               setup.working_height)));
+      // The minimum area is in source pixels; keep it meaning the same subject.
+      SubjectIsolationConfig isolation = config.isolation;
+      const int64_t working_pixels = static_cast<int64_t>(working.width) * working.height;
+      const int64_t source_pixels = static_cast<int64_t>(source.width) * source.height;
+      isolation.minimum_subject_area = static_cast<int>(std::max<int64_t>(
+          1, (isolation.minimum_subject_area * working_pixels + source_pixels - 1) /
+                 source_pixels));
+      ASSIGN_OR_RETURN(result.isolated,
+                       AtStage(Stage::kIsolation, IsolateSubject(working, isolation)));
+    }
+    finish(Stage::kIsolation, result.isolated);
+  }
+  if (runs(Stage::kComposition)) {
+    ASSIGN_OR_RETURN(result.composed,
+                     AtStage(Stage::kComposition,
+                             ComposeProp(result.isolated, config.composition, setup.output_width,
+                                         setup.output_height)));
+    finish(Stage::kComposition, result.composed.image);
+  }
+  if (runs(Stage::kRasterization)) {
+    ASSIGN_OR_RETURN(result.rasterized, AtStage(Stage::kRasterization,
+                                                RasterizeProp(result.composed, setup.raster)));
+    if (config.composition.attachment.mode == PropAttachmentMode::kFree) {
+      result.rasterized.anchor_x = config.composition.attachment.free_anchor->x;
+      result.rasterized.anchor_y = config.composition.attachment.free_anchor->y;
+    }
+    finish(Stage::kRasterization, result.rasterized.image);
+  }
+  if (runs(Stage::kQuantization)) {
+    ASSIGN_OR_RETURN(result.palette,
+                     AtStage(Stage::kQuantization, BuildPropPalette(style.palette)));
+    if (palette_lookup == nullptr || palette_lookup->colors() != result.palette.colors) {
+      ASSIGN_OR_RETURN(
+          PropPaletteLookup lookup,
+          AtStage(Stage::kQuantization, PropPaletteLookup::Build(result.palette.colors)));
+      palette_lookup = std::make_shared<const PropPaletteLookup>(std::move(lookup));
+    }
+    ASSIGN_OR_RETURN(result.quantized, AtStage(Stage::kQuantization,
+                                               QuantizeProp(result.rasterized, *palette_lookup)));
+    finish(Stage::kQuantization, result.quantized.image);
+  }
+  if (runs(Stage::kEdgeTreatment)) {
+    ASSIGN_OR_RETURN(result.edge_treated,
+                     AtStage(Stage::kEdgeTreatment,
+                             ApplyPropEdgeTreatment(result.quantized, result.palette.outline,
+                                                    config.edge)));
+    finish(Stage::kEdgeTreatment, result.edge_treated.image);
+  }
+  ASSIGN_OR_RETURN(
+      result.finished,
+      AtStage(Stage::kCleanup,
+              CleanupAndValidateProp(result.edge_treated, result.palette.colors, style.tile_size,
+                                     config.cleanup, config.composition.attachment.mode)));
+  finish(Stage::kCleanup, result.finished.image);
+  return absl::OkStatus();
+}
+
+// Each stage's key folds in the previous stage's, so a stage matches only when
+// everything upstream of it does too.
+std::array<uint64_t, 6> StageKeys(const std::string& source_digest, const PropArtworkStyle& style,
+                                  const PropArtworkPipelineConfig& config,
+                                  const RunSetup& setup) {
+  const SubjectIsolationConfig& isolation = config.isolation;
+  const PropCompositionConfig& composition = config.composition;
+  const std::optional<PropFreeAnchor>& anchor = composition.attachment.free_anchor;
+  std::array<uint64_t, 6> keys;
+  keys[0] = absl::HashOf(kPropArtworkPipelineVersion, source_digest, isolation.alpha_threshold,
+                         isolation.background_distance, isolation.enclosed_background_distance,
+                         isolation.minimum_subject_area, isolation.competing_subject_ratio,
+                         setup.working_width, setup.working_height);
+  keys[1] = absl::HashOf(keys[0], style.tile_size, composition.canvas_tiles_wide,
+                         composition.canvas_tiles_high, composition.padding_fraction,
+                         composition.attachment.mode, anchor.has_value(),
+                         anchor.has_value() ? anchor->x : 0, anchor.has_value() ? anchor->y : 0);
+  keys[2] = absl::HashOf(keys[1], style.pixel_block_size);
+  uint64_t palette = keys[2];
+  for (const RgbaColor& color : style.palette.colors) {
+    palette = absl::HashOf(palette, color.r, color.g, color.b, color.a);
+  }
+  keys[3] = palette;
+  keys[4] = absl::HashOf(keys[3], config.edge.width, config.edge.alpha_threshold);
+  keys[5] = absl::HashOf(keys[4], config.cleanup.alpha_threshold,
+                         config.cleanup.minimum_component_area, config.cleanup.contact_tolerance);
+  return keys;
+}
+
+// Copies the artifacts of stages [first, end) from one result to another.
+void CopyStages(const PropArtworkPipelineResult& from, int first, int end,
+                PropArtworkPipelineResult& to) {
+  using Stage = PropArtworkStage;
+  const auto copies = [&](Stage stage) {
+    return first <= StageIndex(stage) && StageIndex(stage) < end;
+  };
+  if (copies(Stage::kIsolation)) to.isolated = from.isolated;
+  if (copies(Stage::kComposition)) to.composed = from.composed;
+  if (copies(Stage::kRasterization)) to.rasterized = from.rasterized;
+  if (copies(Stage::kQuantization)) {
+    to.palette = from.palette;
+    to.quantized = from.quantized;
+  }
+  if (copies(Stage::kEdgeTreatment)) to.edge_treated = from.edge_treated;
+  if (copies(Stage::kCleanup)) to.finished = from.finished;
+  for (int stage = first; stage < end; ++stage) to.diagnostics[stage] = from.diagnostics[stage];
+}
+
 }  // namespace
 
 absl::Status ValidatePropSource(const RgbaImage& source, const PropSourceLimits& limits) {
@@ -77,72 +282,77 @@ absl::Status ValidatePropSource(const RgbaImage& source, const PropSourceLimits&
 absl::StatusOr<PropArtworkPipelineResult> RunPropArtworkPipeline(
     const RgbaImage& source, const PropArtworkStyle& style,
     const PropArtworkPipelineConfig& config) {
-  RETURN_IF_ERROR(ValidatePropSource(source, config.source_limits));
-  RETURN_IF_ERROR(ValidatePropArtworkStyle(style));
+  ASSIGN_OR_RETURN(const RunSetup setup, ValidateRun(source, style, config));
+  PropArtworkPipelineResult result;
+  ASSIGN_OR_RETURN(result.source_digest, RgbaImageDigest(source));
+  int completed = 0;
+  std::shared_ptr<const PropPaletteLookup> palette_lookup;
+  RETURN_IF_ERROR(RunStages(0, source, style, config, setup, result, completed, palette_lookup));
+  return result;
+}
 
-  const PropRasterConfig raster_config{
-      .tile_size = style.tile_size,
-      .canvas_tiles_wide = config.composition.canvas_tiles_wide,
-      .canvas_tiles_high = config.composition.canvas_tiles_high,
-      .pixel_block_size = style.pixel_block_size,
-  };
-  const int64_t output_width =
-      static_cast<int64_t>(style.tile_size) * config.composition.canvas_tiles_wide;
-  const int64_t output_height =
-      static_cast<int64_t>(style.tile_size) * config.composition.canvas_tiles_high;
-  if (output_width <= 0 || output_height <= 0 || output_width > std::numeric_limits<int>::max() ||
-      output_height > std::numeric_limits<int>::max()) {
-    return absl::InvalidArgumentError("prop output dimensions overflow integer storage");
+absl::StatusOr<std::string> PropArtworkPipelineCache::SourceDigest(const RgbaImage& source) {
+  {
+    std::lock_guard lock(mutex_);
+    if (!source_digest_.empty() && source.width == source_.width &&
+        source.height == source_.height && source.pixels == source_.pixels) {
+      return source_digest_;
+    }
   }
-  RETURN_IF_ERROR(ValidatePropAttachment(config.composition.attachment,
-                                         static_cast<int>(output_width),
-                                         static_cast<int>(output_height)));
+  ASSIGN_OR_RETURN(std::string digest, RgbaImageDigest(source));
+  std::lock_guard lock(mutex_);
+  source_ = source;
+  source_digest_ = digest;
+  return digest;
+}
 
-  ASSIGN_OR_RETURN(const std::string source_digest, RgbaImageDigest(source));
-  ASSIGN_OR_RETURN(RgbaImage isolated,
-                   AtStage(PropArtworkStage::kIsolation, IsolateSubject(source, config.isolation)));
-  ASSIGN_OR_RETURN(PropArtwork composed,
-                   AtStage(PropArtworkStage::kComposition,
-                           ComposeProp(isolated, config.composition, static_cast<int>(output_width),
-                                       static_cast<int>(output_height))));
-  ASSIGN_OR_RETURN(PropArtwork rasterized, AtStage(PropArtworkStage::kRasterization,
-                                                   RasterizeProp(composed, raster_config)));
-  if (config.composition.attachment.mode == PropAttachmentMode::kFree) {
-    rasterized.anchor_x = config.composition.attachment.free_anchor->x;
-    rasterized.anchor_y = config.composition.attachment.free_anchor->y;
-  }
-  ASSIGN_OR_RETURN(PropPalette palette,
-                   AtStage(PropArtworkStage::kQuantization, BuildPropPalette(style.palette)));
-  ASSIGN_OR_RETURN(PropArtwork quantized,
-                   AtStage(PropArtworkStage::kQuantization, QuantizeProp(rasterized, palette)));
-  ASSIGN_OR_RETURN(PropArtwork edge_treated,
-                   AtStage(PropArtworkStage::kEdgeTreatment,
-                           ApplyPropEdgeTreatment(quantized, palette.outline, config.edge)));
-  ASSIGN_OR_RETURN(
-      PropArtwork finished,
-      AtStage(PropArtworkStage::kCleanup,
-              CleanupAndValidateProp(edge_treated, palette.colors, style.tile_size, config.cleanup,
-                                     config.composition.attachment.mode)));
-
-  const std::array<PropStageDiagnostic, 6> diagnostics = {
-      Diagnostic(PropArtworkStage::kIsolation, isolated),
-      Diagnostic(PropArtworkStage::kComposition, composed.image),
-      Diagnostic(PropArtworkStage::kRasterization, rasterized.image),
-      Diagnostic(PropArtworkStage::kQuantization, quantized.image),
-      Diagnostic(PropArtworkStage::kEdgeTreatment, edge_treated.image),
-      Diagnostic(PropArtworkStage::kCleanup, finished.image),
-  };
-  return PropArtworkPipelineResult{
-      .source_digest = source_digest,
-      .palette = std::move(palette),
-      .isolated = std::move(isolated),
-      .composed = std::move(composed),
-      .rasterized = std::move(rasterized),
-      .quantized = std::move(quantized),
-      .edge_treated = std::move(edge_treated),
-      .finished = std::move(finished),
-      .diagnostics = diagnostics,
-  };
+absl::StatusOr<PropArtworkPipelineResult> PropArtworkPipelineCache::Run(
+    const RgbaImage& source, const PropArtworkStyle& style,
+    const PropArtworkPipelineConfig& config) {
+  ASSIGN_OR_RETURN(const RunSetup setup, ValidateRun(source, style, config));
+  PropArtworkPipelineResult result;
+  ASSIGN_OR_RETURN(result.source_digest, SourceDigest(source));
+  const std::array<uint64_t, kStageCount> keys =
+      StageKeys(result.source_digest, style, config, setup);
+
+  int reused = 0;
+  std::shared_ptr<const PropPaletteLookup> palette_lookup;
+  {
+    std::lock_guard lock(mutex_);
+    while (reused < completed_stages_ && keys_[reused] == keys[reused]) ++reused;
+    CopyStages(artifacts_, 0, reused, result);
+    reused_stages_ = reused;
+    palette_lookup = palette_lookup_;
+  }
+
+  int completed = reused;
+  const absl::Status status =
+      RunStages(reused, source, style, config, setup, result, completed, palette_lookup);
+
+  std::lock_guard lock(mutex_);
+  palette_lookup_ = std::move(palette_lookup);
+  // Stages before `reused` are what the cache already holds.
+  CopyStages(result, reused, completed, artifacts_);
+  keys_ = keys;
+  completed_stages_ = completed;
+  RETURN_IF_ERROR(status);
+  return result;
+}
+
+int PropArtworkPipelineCache::reused_stages() const {
+  std::lock_guard lock(mutex_);
+  return reused_stages_;
+}
+
+void PropArtworkPipelineCache::Clear() {
+  std::lock_guard lock(mutex_);
+  source_ = {};
+  source_digest_.clear();
+  keys_ = {};
+  completed_stages_ = 0;
+  artifacts_ = {};
+  reused_stages_ = 0;
+  palette_lookup_.reset();
 }
 
 }  // namespace zebes
@@ -3,6 +3,8 @@
 #include <array>
 #include <cstddef>
 #include <cstdint>
+#include <memory>
+#include <mutex>
 #include <string>
 
 #include "absl/status/statusor.h"
@@ -35,8 +37,26 @@ struct PropSourceLimits {
   size_t maximum_bytes = 64 * 1024 * 1024;
 };
 
+// Isolation and composition read a copy of the source reduced to a size
+// chosen from the prop's output size, since a multi-megapixel source usually
+// becomes a sprite of a few thousand pixels.
+//
+// The copy is the source area-averaged down by whole halvings, the last level
+// of a mip chain whose width and height are both still at least
+// `minimum_oversample` times the prop's. A subject filling a fraction of the
+// source that large or more therefore still reaches rasterization with at
+// least one working pixel per output pixel. Sources already that small are
+// used as they are.
+struct PropWorkingProxyConfig {
+  // Every stage reads the source itself. Exact, and for a source far larger
+  // than its prop, much slower.
+  bool full_resolution = false;
+  int minimum_oversample = 8;
+};
+
 struct PropArtworkPipelineConfig {
   PropSourceLimits source_limits;
+  PropWorkingProxyConfig working_proxy;
   SubjectIsolationConfig isolation;
   PropCompositionConfig composition;
   PropEdgeConfig edge;
@@ -60,6 +80,7 @@ struct PropArtworkPipelineResult {
   int pipeline_version = kPropArtworkPipelineVersion;
   std::string source_digest;
   PropPalette palette;
+  // At working resolution; see PropWorkingProxyConfig.
   RgbaImage isolated;
   PropArtwork composed;
   PropArtwork rasterized;
@@ -75,4 +96,49 @@ absl::StatusOr<PropArtworkPipelineResult> RunPropArtworkPipeline(
     const RgbaImage& source, const PropArtworkStyle& style,
     const PropArtworkPipelineConfig& config);
 
+// Keeps the artifacts of the last run so the next one over the same source
+// resumes at the first stage whose inputs changed: tweaking edge treatment
+// reruns edge treatment and cleanup, not isolation through quantization.
+//
+// Each stage is keyed by the source digest, the pipeline version, and a hash of
+// every setting that stage and the stages before it read. A stage that fails
+// keeps the stages before it, so correcting the failing setting resumes there.
+//
+// The source itself is retained too. An identical source is recognised by
+// comparing bytes, which is far cheaper than hashing it again. Callers running
+// one prop at a time, like an editor session, therefore hold two copies of the
+// source. The palette's nearest-colour lookup is kept as well, so rerunning
+// quantization after an upstream change does not rebuild it. The cache may be
+// shared between threads; a run holds its lock only while copying artifacts in
+// or out.
+class PropArtworkPipelineCache {
+ public:
+  // RgbaImageDigest(source), without hashing a source identical to the last.
+  absl::StatusOr<std::string> SourceDigest(const RgbaImage& source);
+
+  // Same result as RunPropArtworkPipeline with the same arguments.
+  absl::StatusOr<PropArtworkPipelineResult> Run(const RgbaImage& source,
+                                                const PropArtworkStyle& style,
+                                                const PropArtworkPipelineConfig& config);
+
+  // How many stages, in order from isolation, the last Run() reused.
+  int reused_stages() const;
+
+  void Clear();
+
+ private:
+  static constexpr int kStageCount = 6;
+
+  mutable std::mutex mutex_;
+  RgbaImage source_;
+  std::string source_digest_;
+  // Stages before `completed_stages_` in `artifacts_` are valid for `keys_`.
+  std::array<uint64_t, kStageCount> keys_{};
+  int completed_stages_ = 0;
+  PropArtworkPipelineResult artifacts_;
+  int reused_stages_ = 0;
+  // Shared, not copied, with the run using it; null until quantization runs.
+  std::shared_ptr<const PropPaletteLookup> palette_lookup_;
+};
+
 }  // namespace zebes
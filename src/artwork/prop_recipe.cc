@@ -154,6 +154,9 @@ nlohmann::json PipelineToJson(const PropArtworkPipelineConfig& pipeline) {
         {"maximum_height", pipeline.source_limits.maximum_height},
         {"maximum_pixels", pipeline.source_limits.maximum_pixels},
         {"maximum_bytes", pipeline.source_limits.maximum_bytes}}},
+      {"working_proxy",
+       {{"full_resolution", pipeline.working_proxy.full_resolution},
+        {"minimum_oversample", pipeline.working_proxy.minimum_oversample}}},
       {"isolation",
        {{"alpha_threshold", pipeline.isolation.alpha_threshold},
         {"background_distance", pipeline.isolation.background_distance},
@@ -183,6 +186,12 @@ absl::StatusOr<PropArtworkPipelineConfig> PipelineFromJson(const nlohmann::json&
                    Required<size_t>(limits, "maximum_pixels"));
   ASSIGN_OR_RETURN(pipeline.source_limits.maximum_bytes, Required<size_t>(limits, "maximum_bytes"));
 
+  ASSIGN_OR_RETURN(const nlohmann::json proxy, Required<nlohmann::json>(json, "working_proxy"));
+  ASSIGN_OR_RETURN(pipeline.working_proxy.full_resolution,
+                   Required<bool>(proxy, "full_resolution"));
+  ASSIGN_OR_RETURN(pipeline.working_proxy.minimum_oversample,
+                   Required<int>(proxy, "minimum_oversample"));
+
   ASSIGN_OR_RETURN(const nlohmann::json isolation, Required<nlohmann::json>(json, "isolation"));
   ASSIGN_OR_RETURN(pipeline.isolation.alpha_threshold, Required<int>(isolation, "alpha_threshold"));
   ASSIGN_OR_RETURN(pipeline.isolation.background_distance,
@@ -249,6 +258,9 @@ absl::Status ValidatePipelineSettings(const PropArtworkPipelineConfig& pipeline,
       limits.maximum_bytes == 0) {
     return absl::InvalidArgumentError("prop recipe source limits must be positive");
   }
+  if (pipeline.working_proxy.minimum_oversample <= 0) {
+    return absl::InvalidArgumentError("prop recipe working proxy oversample must be positive");
+  }
   const SubjectIsolationConfig& isolation = pipeline.isolation;
   if (isolation.alpha_threshold < 0 || isolation.alpha_threshold > 255 ||
       !std::isfinite(isolation.background_distance) ||
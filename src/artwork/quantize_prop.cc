@@ -1,32 +1,72 @@
 #include "artwork/quantize_prop.h"
 
+#include <algorithm>
+#include <array>
 #include <cmath>
 #include <cstddef>
 #include <limits>
+#include <utility>
+#include <vector>
 
+#include "absl/base/no_destructor.h"
 #include "absl/status/status.h"
+#include "absl/types/span.h"
 
 namespace zebes {
 namespace {
 
-struct Oklab {
-  double lightness = 0.0;
-  double green_red = 0.0;
-  double blue_yellow = 0.0;
-};
+// Each top-level cell spans 16 values per channel.
+constexpr int kCellShift = 4;
+constexpr int kCellsPerChannel = 256 >> kCellShift;
+constexpr int kCellSpan = 1 << kCellShift;
+// A cell straddling a boundary splits into octants down to this span, and
+// below it searches its remaining candidates per colour.
+constexpr int kMinimumSpan = 4;
+// Far above the rounding error of a distance in [0, 1], so an entry is never
+// dropped from a cell it could win somewhere inside of.
+constexpr double kCandidateSlack = 1e-9;
 
 double SrgbToLinear(uint8_t channel) {
   const double value = channel / 255.0;
   return value <= 0.04045 ? value / 12.92 : std::pow((value + 0.055) / 1.055, 2.4);
 }
 
-Oklab ToOklab(const RgbaColor& color) {
-  const double red = SrgbToLinear(color.r);
-  const double green = SrgbToLinear(color.g);
-  const double blue = SrgbToLinear(color.b);
-  const double l = std::cbrt(0.4122214708 * red + 0.5363325363 * green + 0.0514459929 * blue);
-  const double m = std::cbrt(0.2119034982 * red + 0.6806995451 * green + 0.1073969566 * blue);
-  const double s = std::cbrt(0.0883024619 * red + 0.2817188376 * green + 0.6299787005 * blue);
+const std::array<double, 256>& LinearTable() {
+  static const absl::NoDestructor<std::array<double, 256>> kTable([] {
+    std::array<double, 256> table;
+    for (int channel = 0; channel < 256; ++channel) {
+      table[channel] = SrgbToLinear(static_cast<uint8_t>(channel));
+    }
+    return table;
+  }());
+  return *kTable;
+}
+
+// The LMS cube roots for linear RGB. Every coefficient is positive, so each
+// root grows with every channel, which is what lets a cell's corners bound it.
+std::array<double, 3> ConeRoots(double red, double green, double blue) {
+  return {
+      std::cbrt(0.4122214708 * red + 0.5363325363 * green + 0.0514459929 * blue),
+      std::cbrt(0.2119034982 * red + 0.6806995451 * green + 0.1073969566 * blue),
+      std::cbrt(0.0883024619 * red + 0.2817188376 * green + 0.6299787005 * blue),
+  };
+}
+
+constexpr double kOklabMatrix[3][3] = {
+    {0.2104542553, 0.7936177850, -0.0040720468},
+    {1.9779984951, -2.4285922050, 0.4505937099},
+    {0.0259040371, 0.7827717662, -0.8086757660},
+};
+
+}  // namespace
+
+PropPaletteLookup::Oklab PropPaletteLookup::ToOklab(uint8_t red, uint8_t green, uint8_t blue) {
+  const std::array<double, 256>& linear = LinearTable();
+  return FromConeRoots(ConeRoots(linear[red], linear[green], linear[blue]));
+}
+
+PropPaletteLookup::Oklab PropPaletteLookup::FromConeRoots(const std::array<double, 3>& roots) {
+  const auto [l, m, s] = roots;
   return Oklab{
       .lightness = 0.2104542553 * l + 0.7936177850 * m - 0.0040720468 * s,
       .green_red = 1.9779984951 * l - 2.4285922050 * m + 0.4505937099 * s,
@@ -34,14 +74,137 @@ Oklab ToOklab(const RgbaColor& color) {
   };
 }
 
-double DistanceSquared(const Oklab& left, const Oklab& right) {
+double PropPaletteLookup::DistanceSquared(const Oklab& left, const Oklab& right) {
   const double lightness = left.lightness - right.lightness;
   const double green_red = left.green_red - right.green_red;
   const double blue_yellow = left.blue_yellow - right.blue_yellow;
   return lightness * lightness + green_red * green_red + blue_yellow * blue_yellow;
 }
 
-}  // namespace
+absl::StatusOr<PropPaletteLookup> PropPaletteLookup::Build(const std::vector<RgbaColor>& colors) {
+  if (colors.empty()) return absl::InvalidArgumentError("prop palette is empty");
+  if (colors.size() > std::numeric_limits<uint16_t>::max()) {
+    return absl::InvalidArgumentError("prop palette is too large");
+  }
+
+  PropPaletteLookup lookup;
+  lookup.colors_ = colors;
+  std::vector<uint16_t> everything;
+  for (const RgbaColor& color : colors) {
+    if (color.a != 255) return absl::InvalidArgumentError("prop palette must be opaque");
+    everything.push_back(static_cast<uint16_t>(lookup.resolved_.size()));
+    lookup.resolved_.push_back(ToOklab(color.r, color.g, color.b));
+  }
+
+  lookup.cells_.resize(static_cast<size_t>(kCellsPerChannel) * kCellsPerChannel *
+                       kCellsPerChannel);
+  size_t cell = 0;
+  for (int red = 0; red < 256; red += kCellSpan) {
+    for (int green = 0; green < 256; green += kCellSpan) {
+      for (int blue = 0; blue < 256; blue += kCellSpan) {
+        lookup.Resolve(cell++, {red, green, blue}, kCellSpan, everything);
+      }
+    }
+  }
+  return lookup;
+}
+
+void PropPaletteLookup::Resolve(size_t cell, std::array<int, 3> origin, int span,
+                                absl::Span<const uint16_t> entries) {
+  // Cone roots only grow with each channel, so the cube's extreme corners
+  // bound every root inside it.
+  const std::array<double, 256>& linear = LinearTable();
+  const std::array<double, 3> root_low =
+      ConeRoots(linear[origin[0]], linear[origin[1]], linear[origin[2]]);
+  const std::array<double, 3> root_high = ConeRoots(
+      linear[origin[0] + span - 1], linear[origin[1] + span - 1], linear[origin[2] + span - 1]);
+
+  // Whichever entry is nearest the middle of the cube is the one to beat.
+  std::array<double, 3> middle_roots;
+  for (int root = 0; root < 3; ++root) {
+    middle_roots[root] = (root_low[root] + root_high[root]) / 2;
+  }
+  const Oklab middle = FromConeRoots(middle_roots);
+  uint16_t leader = entries.front();
+  for (const uint16_t entry : entries) {
+    if (DistanceSquared(middle, resolved_[entry]) < DistanceSquared(middle, resolved_[leader])) {
+      leader = entry;
+    }
+  }
+
+  // How much farther an entry is than the leader, squared, is linear in the
+  // Oklab colour and so in the cone roots. Its minimum over the cube is at a
+  // corner of the roots' range, and an entry that is farther even there can
+  // win nowhere inside.
+  auto norm = [](const Oklab& color) {
+    return color.lightness * color.lightness + color.green_red * color.green_red +
+           color.blue_yellow * color.blue_yellow;
+  };
+  const Oklab& lead = resolved_[leader];
+  std::vector<uint16_t> kept;
+  for (const uint16_t entry : entries) {
+    const Oklab& rival = resolved_[entry];
+    const std::array<double, 3> direction = {
+        rival.lightness - lead.lightness,
+        rival.green_red - lead.green_red,
+        rival.blue_yellow - lead.blue_yellow,
+    };
+    double margin = norm(rival) - norm(lead);
+    for (int root = 0; root < 3; ++root) {
+      double slope = 0.0;
+      for (int axis = 0; axis < 3; ++axis) slope += kOklabMatrix[axis][root] * direction[axis];
+      margin -= 2 * std::max(slope * root_low[root], slope * root_high[root]);
+    }
+    if (entry == leader || margin <= kCandidateSlack) kept.push_back(entry);
+  }
+
+  if (kept.size() > 1 && span > kMinimumSpan) {
+    const size_t children = cells_.size();
+    cells_.resize(children + 8);
+    cells_[cell] = Cell{.first = static_cast<uint32_t>(children), .count = 0};
+    const int half = span / 2;
+    for (int octant = 0; octant < 8; ++octant) {
+      Resolve(children + octant,
+              {origin[0] + (octant & 4 ? half : 0), origin[1] + (octant & 2 ? half : 0),
+               origin[2] + (octant & 1 ? half : 0)},
+              half, kept);
+    }
+    return;
+  }
+  cells_[cell] = Cell{
+      .first = static_cast<uint32_t>(candidates_.size()),
+      .count = static_cast<uint32_t>(kept.size()),
+  };
+  candidates_.insert(candidates_.end(), kept.begin(), kept.end());
+}
+
+size_t PropPaletteLookup::Nearest(uint8_t red, uint8_t green, uint8_t blue) const {
+  const Cell* cell = &cells_[((static_cast<size_t>(red >> kCellShift) * kCellsPerChannel) +
+                              (green >> kCellShift)) *
+                                 kCellsPerChannel +
+                             (blue >> kCellShift)];
+  for (int shift = kCellShift - 1; cell->count == 0; --shift) {
+    const int octant =
+        ((red >> shift) & 1) << 2 | ((green >> shift) & 1) << 1 | ((blue >> shift) & 1);
+    cell = &cells_[cell->first + octant];
+  }
+  if (cell->count == 1) return candidates_[cell->first];
+
+  // Candidates are in palette order, so a strict comparison keeps the lower
+  // index on a tie exactly as a search of the whole palette would.
+  const Oklab source = ToOklab(red, green, blue);
+  size_t best = 0;
+  double best_distance = std::numeric_limits<double>::infinity();
+  for (uint32_t slot = cell->first; slot < cell->first + cell->count; ++slot) {
+    const size_t candidate = candidates_[slot];
+    const double distance = DistanceSquared(source, resolved_[candidate]);
+    if (distance < best_distance) {
+      best = candidate;
+      best_distance = distance;
+    }
+  }
+  return best;
+}
 
 absl::StatusOr<PropPalette> BuildPropPalette(const ResolvedTerrainPalette& terrain) {
   PropPalette palette{
@@ -57,44 +220,30 @@ absl::StatusOr<PropPalette> BuildPropPalette(const ResolvedTerrainPalette& terra
 
 absl::StatusOr<PropArtwork> QuantizeProp(const PropArtwork& artwork, const PropPalette& palette) {
   if (!artwork.IsValid()) return absl::InvalidArgumentError("prop artwork is invalid");
-  if (palette.colors.empty()) return absl::InvalidArgumentError("prop palette is empty");
+  absl::StatusOr<PropPaletteLookup> lookup = PropPaletteLookup::Build(palette.colors);
+  if (!lookup.ok()) return lookup.status();
+  return QuantizeProp(artwork, *lookup);
+}
 
-  std::vector<Oklab> resolved;
-  resolved.reserve(palette.colors.size());
-  for (const RgbaColor& color : palette.colors) {
-    if (color.a != 255) return absl::InvalidArgumentError("prop palette must be opaque");
-    resolved.push_back(ToOklab(color));
-  }
+absl::StatusOr<PropArtwork> QuantizeProp(const PropArtwork& artwork,
+                                         const PropPaletteLookup& lookup) {
+  if (!artwork.IsValid()) return absl::InvalidArgumentError("prop artwork is invalid");
 
   PropArtwork quantized = artwork;
+  const std::vector<RgbaColor>& colors = lookup.colors();
   const size_t pixel_count = static_cast<size_t>(quantized.image.width) * quantized.image.height;
   for (size_t pixel = 0; pixel < pixel_count; ++pixel) {
-    const size_t offset = pixel * 4;
-    if (quantized.image.pixels[offset + 3] == 0) {
-      quantized.image.pixels[offset + 0] = 0;
-      quantized.image.pixels[offset + 1] = 0;
-      quantized.image.pixels[offset + 2] = 0;
+    uint8_t* rgba = &quantized.image.pixels[pixel * 4];
+    if (rgba[3] == 0) {
+      rgba[0] = 0;
+      rgba[1] = 0;
+      rgba[2] = 0;
       continue;
     }
-
-    const Oklab source = ToOklab(RgbaColor{
-        quantized.image.pixels[offset + 0],
-        quantized.image.pixels[offset + 1],
-        quantized.image.pixels[offset + 2],
-        255,
-    });
-    size_t best = 0;
-    double best_distance = std::numeric_limits<double>::infinity();
-    for (size_t candidate = 0; candidate < resolved.size(); ++candidate) {
-      const double distance = DistanceSquared(source, resolved[candidate]);
-      if (distance < best_distance) {
-        best = candidate;
-        best_distance = distance;
-      }
-    }
-    quantized.image.pixels[offset + 0] = palette.colors[best].r;
-    quantized.image.pixels[offset + 1] = palette.colors[best].g;
-    quantized.image.pixels[offset + 2] = palette.colors[best].b;
+    const RgbaColor& nearest = colors[lookup.Nearest(rgba[0], rgba[1], rgba[2])];
+    rgba[0] = nearest.r;
+    rgba[1] = nearest.g;
+    rgba[2] = nearest.b;
   }
   return quantized;
 }
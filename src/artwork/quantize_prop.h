@@ -1,8 +1,12 @@
 #pragma once
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <vector>
 
 #include "absl/status/statusor.h"
+#include "absl/types/span.h"
 #include "artwork/prop_artwork.h"
 #include "terrain/terrain_palette.h"
 
@@ -16,8 +20,59 @@ struct PropPalette {
 // The accepted production policy uses every resolved opaque terrain colour.
 absl::StatusOr<PropPalette> BuildPropPalette(const ResolvedTerrainPalette& terrain);
 
+// Answers "which palette colour is nearest in Oklab" for any RGB colour.
+//
+// The RGB cube is cut into 16x16x16 cells. A cell whose every colour has the
+// same nearest palette entry answers with that entry and no arithmetic at all.
+// A cell straddling a boundary splits into octants, down to 4x4x4, and the
+// smallest that still straddle one keep only the few entries that can win
+// inside them and search those. Either way the answer is the one a search of
+// the whole palette gives, ties included, so swapping this in changes no pixel.
+class PropPaletteLookup {
+ public:
+  static absl::StatusOr<PropPaletteLookup> Build(const std::vector<RgbaColor>& colors);
+
+  // Index into the palette's colours; ties go to the lower index.
+  size_t Nearest(uint8_t red, uint8_t green, uint8_t blue) const;
+
+  const std::vector<RgbaColor>& colors() const { return colors_; }
+
+ private:
+  struct Oklab {
+    double lightness = 0.0;
+    double green_red = 0.0;
+    double blue_yellow = 0.0;
+  };
+  // A run of `candidates_`, or with no count, eight octant cells starting at
+  // `first` in `cells_`.
+  struct Cell {
+    uint32_t first = 0;
+    uint32_t count = 0;
+  };
+
+  PropPaletteLookup() = default;
+
+  static Oklab ToOklab(uint8_t red, uint8_t green, uint8_t blue);
+  static Oklab FromConeRoots(const std::array<double, 3>& roots);
+  static double DistanceSquared(const Oklab& left, const Oklab& right);
+
+  // Fills `cell`, the cube `span` values wide from `origin`, choosing among
+  // `entries` and splitting it when more than one can win inside it.
+  void Resolve(size_t cell, std::array<int, 3> origin, int span,
+               absl::Span<const uint16_t> entries);
+
+  std::vector<RgbaColor> colors_;
+  std::vector<Oklab> resolved_;
+  std::vector<Cell> cells_;
+  std::vector<uint16_t> candidates_;
+};
+
 // Maps opaque RGB through Oklab distance. Alpha is preserved for the cleanup
 // stage so resampled edge coverage remains available to edge treatment.
+absl::StatusOr<PropArtwork> QuantizeProp(const PropArtwork& artwork,
+                                         const PropPaletteLookup& lookup);
+// Builds the palette's lookup for this call alone. Callers quantizing more
+// than once with one palette build a PropPaletteLookup and keep it.
 absl::StatusOr<PropArtwork> QuantizeProp(const PropArtwork& artwork, const PropPalette& palette);
 
 }  // namespace zebes
@@ -7,73 +7,131 @@
 #include <vector>
 
 #include "absl/status/status.h"
+#include "common/parallel_for.h"
+#include "common/status_macros.h"
 
 namespace zebes {
 namespace {
 
-uint8_t ToByte(double value) {
-  return static_cast<uint8_t>(std::clamp(std::lround(value), 0L, 255L));
+// Output rows resampled by one ParallelFor item, which share one column buffer.
+constexpr int kRowsPerBand = 16;
+
+// A column's sums reach source height * 255 * 255, which must fit 32 bits.
+constexpr int kMaximumSourceHeight = 65535;
+
+// How much of each source pixel along one axis falls inside each output pixel.
+//
+// Measured in units of 1/output_size of a source pixel, the edges of every
+// output pixel land on whole units, so every overlap is an exact integer and
+// an output pixel's weights sum to source_size.
+struct AxisWeights {
+  // Output pixel i reads source pixels first[i] onward, one per weight in
+  // weights[offsets[i]] up to weights[offsets[i + 1]].
+  std::vector<int> first;
+  std::vector<size_t> offsets;
+  std::vector<uint32_t> weights;
+};
+
+AxisWeights BuildAxisWeights(int source_size, int output_size) {
+  AxisWeights axis;
+  axis.first.reserve(output_size);
+  axis.offsets.reserve(static_cast<size_t>(output_size) + 1);
+  axis.offsets.push_back(0);
+  const int64_t source = source_size;
+  const int64_t output = output_size;
+  for (int64_t i = 0; i < output; ++i) {
+    const int64_t start = i * source;
+    const int64_t end = (i + 1) * source;
+    const int64_t first = start / output;
+    const int64_t last = (end - 1) / output;
+    axis.first.push_back(static_cast<int>(first));
+    for (int64_t pixel = first; pixel <= last; ++pixel) {
+      const int64_t overlap = std::min(end, (pixel + 1) * output) - std::max(start, pixel * output);
+      axis.weights.push_back(static_cast<uint32_t>(overlap));
+    }
+    axis.offsets.push_back(axis.weights.size());
+  }
+  return axis;
+}
+
+// round(numerator / denominator), halves rounding up.
+uint8_t RoundedRatio(uint64_t numerator, uint64_t denominator) {
+  return static_cast<uint8_t>(
+      std::min<uint64_t>((2 * numerator + denominator) / (2 * denominator), 255));
 }
 
-RgbaImage AreaResize(const RgbaImage& source, int output_width, int output_height) {
+// Separable: each output row first sums its source rows into one row of
+// columns, then sums each output pixel's columns. Bands of output rows run in
+// parallel and write disjoint rows, so the result does not depend on
+// scheduling.
+absl::StatusOr<RgbaImage> AreaResize(const RgbaImage& source, int output_width,
+                                     int output_height) {
   RgbaImage output;
   output.width = output_width;
   output.height = output_height;
   output.pixels.resize(static_cast<size_t>(output_width) * output_height * 4);
 
-  const double scale_x = static_cast<double>(source.width) / output_width;
-  const double scale_y = static_cast<double>(source.height) / output_height;
-  for (int output_y = 0; output_y < output_height; ++output_y) {
-    const double source_top = output_y * scale_y;
-    const double source_bottom = (output_y + 1) * scale_y;
-    const int first_y = static_cast<int>(std::floor(source_top));
-    const int last_y = static_cast<int>(std::ceil(source_bottom));
-    for (int output_x = 0; output_x < output_width; ++output_x) {
-      const double source_left = output_x * scale_x;
-      const double source_right = (output_x + 1) * scale_x;
-      const int first_x = static_cast<int>(std::floor(source_left));
-      const int last_x = static_cast<int>(std::ceil(source_right));
-
-      double accumulated_alpha = 0.0;
-      double accumulated_red = 0.0;
-      double accumulated_green = 0.0;
-      double accumulated_blue = 0.0;
-      double accumulated_area = 0.0;
-      for (int source_y = first_y; source_y < last_y; ++source_y) {
-        if (source_y < 0 || source_y >= source.height) continue;
-        const double overlap_y =
-            std::max(0.0, std::min(source_bottom, static_cast<double>(source_y + 1)) -
-                              std::max(source_top, static_cast<double>(source_y)));
-        for (int source_x = first_x; source_x < last_x; ++source_x) {
-          if (source_x < 0 || source_x >= source.width) continue;
-          const double overlap_x =
-              std::max(0.0, std::min(source_right, static_cast<double>(source_x + 1)) -
-                                std::max(source_left, static_cast<double>(source_x)));
-          const double area = overlap_x * overlap_y;
-          const size_t source_pixel = (static_cast<size_t>(source_y) * source.width + source_x) * 4;
-          const double alpha = source.pixels[source_pixel + 3] / 255.0;
-          accumulated_alpha += alpha * area;
-          accumulated_red += source.pixels[source_pixel + 0] * alpha * area;
-          accumulated_green += source.pixels[source_pixel + 1] * alpha * area;
-          accumulated_blue += source.pixels[source_pixel + 2] * alpha * area;
-          accumulated_area += area;
+  const AxisWeights columns = BuildAxisWeights(source.width, output_width);
+  const AxisWeights rows = BuildAxisWeights(source.height, output_height);
+  // Every output pixel's weights multiply out to the same total area.
+  const uint64_t total_area = static_cast<uint64_t>(source.width) * source.height;
+
+  const int bands = (output_height + kRowsPerBand - 1) / kRowsPerBand;
+  RETURN_IF_ERROR(ParallelFor(bands, /*max_workers=*/0, [&](int band) {
+    // Alpha, then alpha-weighted red, green and blue, per source column. An
+    // output row's row weights sum to source.height, so a column's sums stay
+    // below kMaximumSourceHeight * 255 * 255 and fit 32 bits.
+    std::vector<uint32_t> sums(static_cast<size_t>(source.width) * 4);
+    const int band_end = std::min(output_height, (band + 1) * kRowsPerBand);
+    for (int output_y = band * kRowsPerBand; output_y < band_end; ++output_y) {
+      std::fill(sums.begin(), sums.end(), 0);
+      for (size_t tap = rows.offsets[output_y]; tap < rows.offsets[output_y + 1]; ++tap) {
+        const uint32_t weight = rows.weights[tap];
+        const int source_y = rows.first[output_y] + static_cast<int>(tap - rows.offsets[output_y]);
+        const uint8_t* row = &source.pixels[static_cast<size_t>(source_y) * source.width * 4];
+        for (size_t x = 0; x < static_cast<size_t>(source.width); ++x) {
+          const uint8_t* pixel = row + x * 4;
+          uint32_t* sum = &sums[x * 4];
+          const uint32_t weighted_alpha = weight * pixel[3];
+          sum[0] += weighted_alpha;
+          sum[1] += weighted_alpha * pixel[0];
+          sum[2] += weighted_alpha * pixel[1];
+          sum[3] += weighted_alpha * pixel[2];
         }
       }
 
-      const size_t output_pixel = (static_cast<size_t>(output_y) * output_width + output_x) * 4;
-      if (accumulated_alpha > 0.0) {
-        output.pixels[output_pixel + 0] = ToByte(accumulated_red / accumulated_alpha);
-        output.pixels[output_pixel + 1] = ToByte(accumulated_green / accumulated_alpha);
-        output.pixels[output_pixel + 2] = ToByte(accumulated_blue / accumulated_alpha);
-      } else {
-        output.pixels[output_pixel + 0] = 0;
-        output.pixels[output_pixel + 1] = 0;
-        output.pixels[output_pixel + 2] = 0;
+      uint8_t* out = &output.pixels[static_cast<size_t>(output_y) * output_width * 4];
+      for (int output_x = 0; output_x < output_width; ++output_x) {
+        uint64_t alpha = 0;
+        uint64_t red = 0;
+        uint64_t green = 0;
+        uint64_t blue = 0;
+        for (size_t tap = columns.offsets[output_x]; tap < columns.offsets[output_x + 1];
+             ++tap) {
+          const uint64_t weight = columns.weights[tap];
+          const uint32_t* sum =
+              &sums[static_cast<size_t>(columns.first[output_x] + tap - columns.offsets[output_x]) *
+                    4];
+          alpha += weight * sum[0];
+          red += weight * sum[1];
+          green += weight * sum[2];
+          blue += weight * sum[3];
+        }
+        uint8_t* pixel = out + static_cast<size_t>(output_x) * 4;
+        if (alpha > 0) {
+          pixel[0] = RoundedRatio(red, alpha);
+          pixel[1] = RoundedRatio(green, alpha);
+          pixel[2] = RoundedRatio(blue, alpha);
+        } else {
+          pixel[0] = 0;
+          pixel[1] = 0;
+          pixel[2] = 0;
+        }
+        pixel[3] = RoundedRatio(alpha, total_area);
       }
-      output.pixels[output_pixel + 3] =
-          accumulated_area > 0.0 ? ToByte(accumulated_alpha / accumulated_area * 255.0) : 0;
     }
-  }
+    return absl::OkStatus();
+  }));
   return output;
 }
 
@@ -96,6 +154,17 @@ RgbaImage ExpandNearest(const RgbaImage& logical, int scale) {
 
 }  // namespace
 
+absl::StatusOr<RgbaImage> AreaResample(const RgbaImage& source, int width, int height) {
+  if (!source.IsValid()) return absl::InvalidArgumentError("image to resample is invalid");
+  if (width <= 0 || height <= 0) {
+    return absl::InvalidArgumentError("resampled image dimensions must be positive");
+  }
+  if (source.height > kMaximumSourceHeight) {
+    return absl::InvalidArgumentError("image to resample is too tall");
+  }
+  return AreaResize(source, width, height);
+}
+
 absl::StatusOr<PropArtwork> RasterizeProp(const PropArtwork& composed,
                                           const PropRasterConfig& config) {
   if (!composed.IsValid()) return absl::InvalidArgumentError("composed prop is invalid");
@@ -113,7 +182,8 @@ absl::StatusOr<PropArtwork> RasterizeProp(const PropArtwork& composed,
 
   const int logical_width = static_cast<int>(output_width) / config.pixel_block_size;
   const int logical_height = static_cast<int>(output_height) / config.pixel_block_size;
-  RgbaImage logical = AreaResize(composed.image, logical_width, logical_height);
+  ASSIGN_OR_RETURN(RgbaImage logical,
+                   AreaResample(composed.image, logical_width, logical_height));
   RgbaImage output = ExpandNearest(logical, config.pixel_block_size);
 
   PropArtwork result{
@@ -12,7 +12,17 @@ struct PropRasterConfig {
   int pixel_block_size = 1;
 };
 
-// Area-downsamples premultiplied RGBA to the logical grid, then expands by an
+// Resizes `source` to `width` x `height` by averaging premultiplied RGBA over
+// the area each output pixel covers, so a transparent pixel's RGB never tints
+// its neighbours.
+//
+// The area sums are exact integers, so every channel is the correctly rounded
+// average, halves rounding up. A floating-point average, as this once was,
+// agrees to within one step in any channel and differs only where rounding
+// error moves an average across a half.
+absl::StatusOr<RgbaImage> AreaResample(const RgbaImage& source, int width, int height);
+
+// Area-downsamples to the logical grid with AreaResample(), then expands by an
 // integer nearest-neighbor scale when the style uses larger pixel blocks.
 absl::StatusOr<PropArtwork> RasterizeProp(const PropArtwork& composed,
                                           const PropRasterConfig& config);
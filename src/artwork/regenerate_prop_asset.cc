@@ -13,7 +13,7 @@ namespace zebes {
 absl::StatusOr<PreparedPropRegeneration> PreparePropRegeneration(
     const SourceArtwork& source, const RgbaImage& source_pixels, const PropRecipe& recipe,
     const Texture& texture, const RgbaImage& texture_pixels, const Sprite& sprite,
-    const PropRegenerationSettings& settings) {
+    const PropRegenerationSettings& settings, PropArtworkPipelineCache* cache) {
   RETURN_IF_ERROR(ValidateSourceArtwork(source));
   RETURN_IF_ERROR(ValidatePropRecipe(recipe));
   if (source.id != recipe.source_artwork_id) {
@@ -46,7 +46,8 @@ absl::StatusOr<PreparedPropRegeneration> PreparePropRegeneration(
               .recipe_id = recipe.id,
           },
   };
-  ASSIGN_OR_RETURN(PreparedPropAsset rebuilt, PreparePropAsset(source, source_pixels, request));
+  ASSIGN_OR_RETURN(PreparedPropAsset rebuilt,
+                   PreparePropAsset(source, source_pixels, request, cache));
 
   PreparedPropRegeneration prepared{
       .source_snapshot = source,
@@ -39,11 +39,11 @@ struct PreparedPropRegeneration {
 
 // Reprocesses retained source pixels without touching managers or the
 // filesystem. Existing runtime IDs and the prop name are structural and cannot
-// change during regeneration.
+// change during regeneration. `cache` is as for PreparePropAsset.
 absl::StatusOr<PreparedPropRegeneration> PreparePropRegeneration(
     const SourceArtwork& source, const RgbaImage& source_pixels, const PropRecipe& recipe,
     const Texture& texture, const RgbaImage& texture_pixels, const Sprite& sprite,
-    const PropRegenerationSettings& settings);
+    const PropRegenerationSettings& settings, PropArtworkPipelineCache* cache = nullptr);
 
 absl::Status ValidatePreparedPropRegeneration(const PreparedPropRegeneration& prepared);
 
@@ -0,0 +1,97 @@
+#include "common/parallel_for.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <limits>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+
+namespace zebes {
+namespace {
+
+// Shared between the workers of one ParallelFor call.
+class WorkQueue {
+ public:
+  WorkQueue(int count, absl::FunctionRef<absl::Status(int)> body) : count_(count), body_(body) {}
+
+  void Drain() {
+    while (true) {
+      const int index = next_.fetch_add(1, std::memory_order_relaxed);
+      if (index >= count_ || index > failed_index_.load(std::memory_order_acquire)) return;
+      absl::Status status = RunOne(index);
+      if (!status.ok()) RecordFailure(index, std::move(status));
+    }
+  }
+
+  absl::Status TakeFailure() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return std::move(failure_);
+  }
+
+ private:
+  absl::Status RunOne(int index) {
+    try {
+      return body_(index);
+    } catch (const std::exception& error) {
+      return absl::InternalError(
+          absl::StrCat("Parallel work failed outside its status contract: ", error.what()));
+    } catch (...) {
+      return absl::InternalError(
+          "Parallel work failed outside its status contract: unknown exception");
+    }
+  }
+
+  void RecordFailure(int index, absl::Status status) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (index >= failed_index_.load(std::memory_order_relaxed)) return;
+    failed_index_.store(index, std::memory_order_release);
+    failure_ = std::move(status);
+  }
+
+  const int count_;
+  absl::FunctionRef<absl::Status(int)> body_;
+  std::atomic<int> next_ = 0;
+  // The lowest index that has failed so far. Indices above it are not started.
+  std::atomic<int> failed_index_ = std::numeric_limits<int>::max();
+  std::mutex mutex_;
+  absl::Status failure_;
+};
+
+int WorkerCount(int count, int max_workers) {
+  int workers = max_workers;
+  if (workers <= 0) workers = static_cast<int>(std::thread::hardware_concurrency());
+  return std::clamp(workers, 1, std::max(count, 1));
+}
+
+}  // namespace
+
+absl::Status ParallelFor(int count, int max_workers, absl::FunctionRef<absl::Status(int)> body) {
+  if (count < 0) {
+    return absl::InvalidArgumentError(absl::StrCat("cannot run ", count, " parallel items"));
+  }
+  if (count == 0) return absl::OkStatus();
+
+  WorkQueue queue(count, body);
+  std::vector<std::thread> helpers;
+  const int workers = WorkerCount(count, max_workers);
+  helpers.reserve(workers - 1);
+  for (int i = 1; i < workers; ++i) {
+    try {
+      helpers.emplace_back([&queue] { queue.Drain(); });
+    } catch (const std::system_error&) {
+      // Fewer threads only means slower; the caller drains whatever is left.
+      break;
+    }
+  }
+
+  queue.Drain();
+  for (std::thread& helper : helpers) helper.join();
+  return queue.TakeFailure();
+}
+
+}  // namespace zebes
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "absl/functional/function_ref.h"
+#include "absl/status/status.h"
+
+namespace zebes {
+
+// Runs body(i) for every i in [0, count) on up to `max_workers` threads, the
+// calling thread included, and returns once every started index has finished.
+//
+// This is for bounded batches of independent, CPU-bound work whose results the
+// caller writes into slots it preallocated by index. Nothing about the order in
+// which indices run is promised, so a caller that needs a deterministic result
+// must make each index's output depend only on its own inputs.
+//
+// The failure returned is always the one a sequential loop would have hit
+// first. Indices are claimed in ascending order, so once some index fails every
+// lower index has already been claimed and will finish; workers then stop
+// claiming new ones. An exception escaping `body` is translated to Internal,
+// which makes this the repository's exception boundary for worker threads in
+// the same way BackgroundTask is for a single one.
+//
+// `max_workers` of zero means one per hardware thread. A thread that cannot be
+// started is not an error: the work still completes on the threads that did.
+absl::Status ParallelFor(int count, int max_workers, absl::FunctionRef<absl::Status(int)> body);
+
+}  // namespace zebes
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <utility>
+
+namespace zebes {
+
+// A lock-free, single-writer/single-reader double buffer for handing whole
+// values from one thread to another, newest wins.
+//
+// The writer fills the slot the reader is not looking at and then flips which
+// slot is the front. The reader pins the front for as long as it holds a Read,
+// so a value it is looking at never changes under it. Neither side ever waits
+// on the other: a publish that would overwrite the slot the reader still has
+// pinned is declined instead, and the writer simply publishes again later.
+//
+// Slots are reused, never reallocated, so a T holding vectors keeps their
+// capacity from one publish to the next and a steady writer allocates nothing.
+//
+// TryPublish belongs to one writer thread and Acquire to one reader thread; at
+// most one Read may be alive at a time. Destruction requires both to have
+// stopped and the Read to have been released.
+template <typename T>
+class SnapshotExchange {
+ public:
+  static_assert(std::atomic<uint32_t>::is_always_lock_free,
+                "Snapshot exchange state requires an always-lock-free atomic<uint32_t>");
+
+  // The reader's hold on the front value. An empty Read means nothing has been
+  // published yet. The slot stays pinned until the Read is destroyed.
+  class Read {
+   public:
+    Read() = default;
+    Read(Read&& other) noexcept
+        : exchange_(std::exchange(other.exchange_, nullptr)),
+          value_(std::exchange(other.value_, nullptr)) {}
+    Read& operator=(Read&& other) noexcept {
+      if (this != &other) {
+        Release();
+        exchange_ = std::exchange(other.exchange_, nullptr);
+        value_ = std::exchange(other.value_, nullptr);
+      }
+      return *this;
+    }
+    ~Read() { Release(); }
+
+    Read(const Read&) = delete;
+    Read& operator=(const Read&) = delete;
+
+    explicit operator bool() const { return value_ != nullptr; }
+    const T* get() const { return value_; }
+    const T& operator*() const { return *value_; }
+    const T* operator->() const { return value_; }
+
+   private:
+    friend class SnapshotExchange;
+
+    Read(SnapshotExchange* exchange, const T* value) : exchange_(exchange), value_(value) {}
+
+    void Release() {
+      if (exchange_ != nullptr) exchange_->Unpin();
+      exchange_ = nullptr;
+      value_ = nullptr;
+    }
+
+    SnapshotExchange* exchange_ = nullptr;
+    const T* value_ = nullptr;
+  };
+
+  SnapshotExchange() = default;
+
+  SnapshotExchange(const SnapshotExchange&) = delete;
+  SnapshotExchange& operator=(const SnapshotExchange&) = delete;
+
+  // Calls `fill(T&)` on the back slot and makes the result the front. The slot
+  // still holds whatever was published into it two publishes ago, so `fill`
+  // must overwrite every field it cares about.
+  //
+  // Returns false without calling `fill` when the reader still has the back
+  // slot pinned, which happens when it held a Read across a whole publish. The
+  // front is then still the newest value the writer managed to publish.
+  template <typename Fill>
+  bool TryPublish(Fill&& fill) {
+    // Acquire pairs with Unpin's release: once the pin is seen cleared, every
+    // read the reader made of this slot has finished, and it may be written.
+    uint32_t state = state_.load(std::memory_order_acquire);
+    const uint32_t back = (state & kFrontMask) ^ 1;
+    if (PinnedSlot(state) == back) return false;
+
+    // The reader can only pin the front, and only this thread moves the front,
+    // so the back stays unpinned for as long as this fill runs.
+    std::forward<Fill>(fill)(slots_[back]);
+
+    // A CAS rather than a store, because the reader may pin or unpin the front
+    // concurrently and its pin bits must survive the flip. Release publishes
+    // the fill to the reader's acquiring pin.
+    uint32_t desired;
+    do {
+      desired = (state & ~kFrontMask) | back | kPublished;
+    } while (!state_.compare_exchange_weak(state, desired, std::memory_order_release,
+                                           std::memory_order_relaxed));
+    return true;
+  }
+
+  // Pins and returns the newest published value. Never blocks: the pin only
+  // races the writer's flip, and a lost race retries against the new front.
+  Read Acquire() {
+    uint32_t state = state_.load(std::memory_order_relaxed);
+    uint32_t desired;
+    do {
+      if ((state & kPublished) == 0) return Read();
+      desired = (state & ~kPinnedMask) | (((state & kFrontMask) + 1) << kPinnedShift);
+      // Acquire pairs with TryPublish's release, so the fill that made this
+      // slot the front is visible before anything reads it.
+    } while (!state_.compare_exchange_weak(state, desired, std::memory_order_acquire,
+                                           std::memory_order_relaxed));
+    return Read(this, &slots_[state & kFrontMask]);
+  }
+
+ private:
+  // One word holds everything both sides race on, so each side's view of the
+  // front and the pin is always a consistent pair.
+  //   bit 0:    the front slot.
+  //   bits 1-2: the pinned slot plus one, or zero when nothing is pinned. The
+  //             pinned slot need not be the front: the writer may have flipped
+  //             since the reader pinned it.
+  //   bit 3:    whether anything has been published.
+  static constexpr uint32_t kFrontMask = 1;
+  static constexpr uint32_t kPinnedShift = 1;
+  static constexpr uint32_t kPinnedMask = 3 << kPinnedShift;
+  static constexpr uint32_t kPublished = 1 << 3;
+  static constexpr uint32_t kNotPinned = 2;
+
+  // The pinned slot, or kNotPinned, which matches neither.
+  static uint32_t PinnedSlot(uint32_t state) {
+    const uint32_t pinned = (state & kPinnedMask) >> kPinnedShift;
+    return pinned == 0 ? kNotPinned : pinned - 1;
+  }
+
+  // Release pairs with TryPublish's acquiring load, ordering every read of the
+  // pinned slot before the writer's next fill of it.
+  void Unpin() { state_.fetch_and(~kPinnedMask, std::memory_order_release); }
+
+  std::array<T, 2> slots_{};
+  std::atomic<uint32_t> state_ = 0;
+};
+
+}  // namespace zebes
@@ -0,0 +1,194 @@
+#include "common/tick_scheduler.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <system_error>
+#include <utility>
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/strings/str_cat.h"
+#include "absl/time/clock.h"
+#include "common/status_macros.h"
+
+namespace zebes {
+namespace {
+
+absl::StatusOr<uint64_t> ResourceMask(const TickSystem& system,
+                                      const std::vector<TickResource>& resources) {
+  uint64_t mask = 0;
+  for (const TickResource resource : resources) {
+    if (resource < 0 || resource >= kMaxTickResources) {
+      return absl::InvalidArgumentError(absl::StrCat("system ", system.name, " names resource ",
+                                                     resource, ", outside [0, ",
+                                                     kMaxTickResources, ")"));
+    }
+    mask |= uint64_t{1} << resource;
+  }
+  return mask;
+}
+
+absl::Status RunSystem(TickSystem& system) {
+  try {
+    return system.run();
+  } catch (const std::exception& error) {
+    return absl::InternalError(absl::StrCat("system ", system.name,
+                                            " failed outside its status contract: ", error.what()));
+  } catch (...) {
+    return absl::InternalError(
+        absl::StrCat("system ", system.name, " failed outside its status contract"));
+  }
+}
+
+}  // namespace
+
+absl::StatusOr<std::unique_ptr<TickScheduler>> TickScheduler::Create(
+    std::vector<TickSystem> systems, TickSchedulerOptions options) {
+  if (options.worker_threads < 0) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("a tick scheduler cannot have ", options.worker_threads, " worker threads"));
+  }
+
+  absl::flat_hash_set<std::string> names;
+  std::vector<uint64_t> reads;
+  std::vector<uint64_t> writes;
+  for (const TickSystem& system : systems) {
+    if (system.name.empty()) return absl::InvalidArgumentError("a tick system needs a name");
+    if (!system.run) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("system ", system.name, " has nothing to run"));
+    }
+    if (!names.insert(system.name).second) {
+      return absl::InvalidArgumentError(absl::StrCat("system ", system.name, " is listed twice"));
+    }
+    ASSIGN_OR_RETURN(const uint64_t read_mask, ResourceMask(system, system.reads));
+    ASSIGN_OR_RETURN(const uint64_t write_mask, ResourceMask(system, system.writes));
+    reads.push_back(read_mask);
+    writes.push_back(write_mask);
+  }
+
+  std::vector<Node> nodes(systems.size());
+  for (size_t later = 0; later < systems.size(); ++later) {
+    nodes[later].system = std::move(systems[later]);
+    for (size_t earlier = 0; earlier < later; ++earlier) {
+      const bool conflicts = (writes[earlier] & (reads[later] | writes[later])) != 0 ||
+                             (reads[earlier] & writes[later]) != 0;
+      if (!conflicts) continue;
+      nodes[later].prerequisites.push_back(static_cast<int>(earlier));
+      nodes[earlier].dependents.push_back(static_cast<int>(later));
+    }
+  }
+
+  std::unique_ptr<TickScheduler> scheduler(new TickScheduler(std::move(nodes)));
+  scheduler->StartWorkers(options.worker_threads);
+  return scheduler;
+}
+
+TickScheduler::TickScheduler(std::vector<Node> nodes)
+    : nodes_(std::move(nodes)), waiting_(nodes_.size()) {
+  stats_.reserve(nodes_.size());
+  for (const Node& node : nodes_) stats_.push_back({.name = node.system.name});
+  ready_.reserve(nodes_.size());
+}
+
+TickScheduler::~TickScheduler() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  changed_.notify_all();
+  for (std::thread& worker : workers_) worker.join();
+}
+
+void TickScheduler::StartWorkers(int count) {
+  workers_.reserve(count);
+  for (int i = 0; i < count; ++i) {
+    try {
+      workers_.emplace_back([this] { WorkerLoop(); });
+    } catch (const std::system_error&) {
+      // Fewer threads only means slower; the caller runs whatever is left.
+      break;
+    }
+  }
+}
+
+absl::Status TickScheduler::Tick() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  unfinished_ = static_cast<int>(nodes_.size());
+  failed_system_ = std::numeric_limits<int>::max();
+  failure_ = absl::OkStatus();
+  for (size_t i = 0; i < nodes_.size(); ++i) {
+    waiting_[i] = static_cast<int>(nodes_[i].prerequisites.size());
+    if (waiting_[i] == 0) {
+      ready_.push_back(static_cast<int>(i));
+      std::push_heap(ready_.begin(), ready_.end(), std::greater<>());
+    }
+  }
+  if (!ready_.empty()) changed_.notify_all();
+
+  while (unfinished_ > 0) {
+    if (ready_.empty()) {
+      changed_.wait(lock, [this] { return unfinished_ == 0 || !ready_.empty(); });
+      continue;
+    }
+    RunNext(lock);
+  }
+  return std::move(failure_);
+}
+
+void TickScheduler::WorkerLoop() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    changed_.wait(lock, [this] { return stopping_ || !ready_.empty(); });
+    if (stopping_) return;
+    RunNext(lock);
+  }
+}
+
+void TickScheduler::RunNext(std::unique_lock<std::mutex>& lock) {
+  std::pop_heap(ready_.begin(), ready_.end(), std::greater<>());
+  const int system = ready_.back();
+  ready_.pop_back();
+
+  // Skipped systems still finish, so their dependents are released and skipped
+  // in turn rather than left waiting.
+  if (system < failed_system_) {
+    lock.unlock();
+    const absl::Time start = absl::Now();
+    absl::Status status = RunSystem(nodes_[system].system);
+    const absl::Duration elapsed = absl::Now() - start;
+    lock.lock();
+
+    TickSystemStats& stats = stats_[system];
+    ++stats.runs;
+    stats.total += elapsed;
+    stats.max = std::max(stats.max, elapsed);
+    stats.last = elapsed;
+    if (!status.ok() && system < failed_system_) {
+      failed_system_ = system;
+      failure_ = std::move(status);
+    }
+  }
+  Finish(system);
+}
+
+void TickScheduler::Finish(int system) {
+  bool notify = --unfinished_ == 0;
+  for (const int dependent : nodes_[system].dependents) {
+    if (--waiting_[dependent] > 0) continue;
+    ready_.push_back(dependent);
+    std::push_heap(ready_.begin(), ready_.end(), std::greater<>());
+    notify = true;
+  }
+  if (notify) changed_.notify_all();
+}
+
+void TickScheduler::ResetStats() {
+  for (TickSystemStats& stats : stats_) {
+    stats = TickSystemStats{.name = stats.name};
+  }
+}
+
+}  // namespace zebes
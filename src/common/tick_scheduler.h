@@ -0,0 +1,126 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "absl/functional/any_invocable.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+
+namespace zebes {
+
+// Names one piece of state that systems share, such as one of a world's packed
+// arrays. Each world numbers its own, from zero up to kMaxTickResources.
+using TickResource = int;
+inline constexpr int kMaxTickResources = 64;
+
+// One unit of per-tick work and the state it touches. A system may only touch
+// what it declares: that is the whole of what keeps two concurrent systems
+// from racing.
+struct TickSystem {
+  std::string name;
+  std::vector<TickResource> reads;
+  // A resource that is written need not also be listed as read.
+  std::vector<TickResource> writes;
+  absl::AnyInvocable<absl::Status()> run;
+};
+
+// Wall time spent in one system, across the ticks since creation or the last
+// ResetStats.
+struct TickSystemStats {
+  std::string name;
+  int64_t runs = 0;
+  absl::Duration total;
+  absl::Duration max;
+  absl::Duration last;
+};
+
+struct TickSchedulerOptions {
+  // Pool threads kept alongside the one calling Tick. Zero runs every system on
+  // the caller, in registration order.
+  int worker_threads = 0;
+};
+
+// Runs a fixed list of systems once per tick, concurrently wherever their
+// declared accesses allow, on a pool of threads started once at creation.
+//
+// Two systems conflict when one writes a resource the other reads or writes.
+// A system starts only after every earlier-registered system it conflicts with
+// has finished, so each resource sees its readers and writers in registration
+// order and a tick leaves the same state a sequential loop would, however many
+// threads ran it. Systems that share nothing run at once.
+//
+// Like ParallelFor, a failed tick reports the failure a sequential loop would
+// have hit first: once a system fails no later-registered system is started,
+// and every earlier one still runs. An exception escaping a system is
+// translated to Internal.
+class TickScheduler {
+ public:
+  // InvalidArgument for a system without a name or a callable, a name used
+  // twice, or a resource outside [0, kMaxTickResources).
+  static absl::StatusOr<std::unique_ptr<TickScheduler>> Create(
+      std::vector<TickSystem> systems, TickSchedulerOptions options = {});
+
+  // Waits for the pool to stop. Must not run concurrently with Tick.
+  ~TickScheduler();
+
+  TickScheduler(const TickScheduler&) = delete;
+  TickScheduler& operator=(const TickScheduler&) = delete;
+
+  // Runs every system once and returns when all have finished. Ticks must not
+  // overlap; the calling thread runs systems too rather than idling.
+  absl::Status Tick();
+
+  // In registration order. Only stable between ticks.
+  absl::Span<const TickSystemStats> stats() const { return stats_; }
+  void ResetStats();
+
+  // Registration indices of the systems `system` waits for each tick.
+  absl::Span<const int> prerequisites(int system) const { return nodes_[system].prerequisites; }
+
+  // Pool threads actually started; may be fewer than requested.
+  int worker_threads() const { return static_cast<int>(workers_.size()); }
+
+ private:
+  struct Node {
+    TickSystem system;
+    std::vector<int> prerequisites;
+    std::vector<int> dependents;
+  };
+
+  explicit TickScheduler(std::vector<Node> nodes);
+
+  void StartWorkers(int count);
+  void WorkerLoop();
+  // Runs or skips the lowest ready system. `lock` holds mutex_ on entry and
+  // exit, and is released while the system runs.
+  void RunNext(std::unique_lock<std::mutex>& lock);
+  void Finish(int system);
+
+  std::vector<Node> nodes_;
+  std::vector<TickSystemStats> stats_;
+  std::vector<std::thread> workers_;
+
+  std::mutex mutex_;
+  // Signalled whenever a system becomes ready, the tick completes, or the pool
+  // is stopping.
+  std::condition_variable changed_;
+  // Ready systems, lowest registration index first.
+  std::vector<int> ready_;
+  // Prerequisites each system is still waiting on this tick.
+  std::vector<int> waiting_;
+  int unfinished_ = 0;
+  // The lowest system that has failed this tick. Later ones are not started.
+  int failed_system_ = 0;
+  absl::Status failure_;
+  bool stopping_ = false;
+};
+
+}  // namespace zebes
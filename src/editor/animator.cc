@@ -7,31 +7,9 @@
 
 namespace zebes {
 
-void Animator::Reset() {
-  current_frame_index_ = 0;
-  tick_counter_ = 0;
-}
-
-void Animator::Update(const std::vector<SpriteFrame>& frames) {
-  if (frames.empty()) return;
-  if (current_frame_index_ >= static_cast<int>(frames.size())) Reset();
-
-  const SpriteFrame& current_frame = frames[current_frame_index_];
+void Animator::Reset() { elapsed_ticks_ = 0; }
 
-  // Increment tick counter
-  tick_counter_++;
-
-  // Check if we need to advance to the next frame
-  if (tick_counter_ >= std::max(1, current_frame.frames_per_cycle)) {
-    tick_counter_ = 0;
-    current_frame_index_++;
-
-    // Loop back to start if we reached the end
-    if (current_frame_index_ >= static_cast<int>(frames.size())) {
-      current_frame_index_ = 0;
-    }
-  }
-}
+void Animator::Update() { ++elapsed_ticks_; }
 
 absl::StatusOr<SpriteFrame> Animator::GetCurrentFrame(
     const std::vector<SpriteFrame>& frames) const {
@@ -41,7 +19,19 @@ absl::StatusOr<SpriteFrame> Animator::GetCurrentFrame(
 
 absl::StatusOr<int> Animator::GetCurrentFrameIndex(const std::vector<SpriteFrame>& frames) const {
   if (frames.empty()) return absl::FailedPreconditionError("Animation has no frames.");
-  return current_frame_index_ % static_cast<int>(frames.size());
+  return TimelineFor(frames).FrameIndexAt(elapsed_ticks_);
+}
+
+const SpriteTimeline& Animator::TimelineFor(const std::vector<SpriteFrame>& frames) const {
+  const bool unchanged = std::equal(
+      frames.begin(), frames.end(), timeline_durations_.begin(), timeline_durations_.end(),
+      [](const SpriteFrame& frame, int duration) { return frame.frames_per_cycle == duration; });
+  if (unchanged) return timeline_;
+
+  timeline_durations_.clear();
+  for (const SpriteFrame& frame : frames) timeline_durations_.push_back(frame.frames_per_cycle);
+  timeline_ = SpriteTimeline(frames);
+  return timeline_;
 }
 
 bool Animator::IsActive(const std::vector<SpriteFrame>& frames) { return !frames.empty(); }
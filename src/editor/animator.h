@@ -1,12 +1,20 @@
 #pragma once
 
+#include <cstdint>
 #include <vector>
 
 #include "absl/status/statusor.h"
 #include "objects/sprite.h"
+#include "objects/sprite_timeline.h"
 
 namespace zebes {
 
+// Editor playback of a sprite being edited. The only state is how many ticks
+// have passed since Reset; which frame that lands on is looked up from the live
+// frames on every read, so edits made during playback show at once and two
+// animators with the same tick count always agree. The SpriteTimeline behind
+// the lookup is kept between reads and rebuilt only when the frame durations it
+// was built from change, as they do when another sprite is shown or edited.
 class Animator {
  public:
   Animator() = default;
@@ -15,8 +23,8 @@ class Animator {
   // Reset playback to the first frame.
   void Reset();
 
-  // Advance the supplied live frame collection by one tick.
-  void Update(const std::vector<SpriteFrame>& frames);
+  // Advance playback by one tick.
+  void Update();
 
   // Get the current frame of the animation.
   // Returns an error when frames are empty.
@@ -26,8 +34,14 @@ class Animator {
   static bool IsActive(const std::vector<SpriteFrame>& frames);
 
  private:
-  int current_frame_index_ = 0;
-  int tick_counter_ = 0;
+  // The timeline for `frames`, rebuilt first if their durations differ from
+  // the ones the cached timeline was built from.
+  const SpriteTimeline& TimelineFor(const std::vector<SpriteFrame>& frames) const;
+
+  int64_t elapsed_ticks_ = 0;
+  // Each frame's frames_per_cycle as of the last rebuild of timeline_.
+  mutable std::vector<int> timeline_durations_;
+  mutable SpriteTimeline timeline_;
 };
 
 }  // namespace zebes
@@ -143,7 +143,7 @@ void CanvasSprite::UpdateAnimation() {
   constexpr double kTickDuration = 1.0 / kTargetFps;
   animation_timer_ += ImGui::GetIO().DeltaTime;
   while (animation_timer_ >= kTickDuration) {
-    animator_.Update(sprite_.frames);
+    animator_.Update();
     animation_timer_ -= kTickDuration;
   }
 }
@@ -1,12 +1,16 @@
 #include "editor/editor_engine.h"
 
+#include <string>
+
 #include "SDL.h"
+#include "absl/flags/flag.h"
 #include "absl/log/log.h"
 #include "absl/strings/str_cat.h"
 #include "common/config.h"
 #include "common/imgui_wrapper.h"
 #include "common/sdl_wrapper.h"
 #include "common/status_macros.h"
+#include "editor/level_editor/session_recording.h"
 #include "engine/input_manager.h"
 #include "imgui.h"
 #include "imgui_impl_sdl2.h"
@@ -17,6 +21,10 @@
 #include "resources/level_manager.h"
 #include "resources/texture_manager.h"
 
+ABSL_FLAG(std::string, record_session, "",
+          "Records the session's input and level edits to this path on exit, for "
+          "session_replay_bench to replay.");
+
 namespace zebes {
 
 absl::StatusOr<std::unique_ptr<EditorEngine>> EditorEngine::Create() {
@@ -82,7 +90,14 @@ absl::Status EditorEngine::Init() {
 
   // Translate platform input before it reaches engine logic.
   sdl_input_source_ = std::make_unique<SdlInputSource>(*sdl_, *imgui_wrapper_);
-  ASSIGN_OR_RETURN(input_manager_, InputManager::Create({.input_source = sdl_input_source_.get()}));
+  InputSource* input_source = sdl_input_source_.get();
+  if (!absl::GetFlag(FLAGS_record_session).empty()) {
+    session_recorder_ = std::make_unique<SessionRecorder>();
+    recording_input_source_ =
+        std::make_unique<RecordingInputSource>(*sdl_input_source_, *session_recorder_);
+    input_source = recording_input_source_.get();
+  }
+  ASSIGN_OR_RETURN(input_manager_, InputManager::Create({.input_source = input_source}));
 
   // Create API
   Api::Options api_options = {
@@ -101,7 +116,8 @@ absl::Status EditorEngine::Init() {
 
   // Create UI
   gui_ = std::make_unique<Gui>();
-  ASSIGN_OR_RETURN(ui_, EditorUi::Create(sdl_.get(), api_.get(), gui_.get()));
+  ASSIGN_OR_RETURN(ui_,
+                   EditorUi::Create(sdl_.get(), api_.get(), gui_.get(), session_recorder_.get()));
 
   // Setup Dear ImGui context
   IMGUI_CHECKVERSION();
@@ -159,6 +175,17 @@ void EditorEngine::RenderFrame() {
 }
 
 void EditorEngine::Shutdown() {
+  if (session_recorder_ != nullptr) {
+    const std::string path = absl::GetFlag(FLAGS_record_session);
+    const absl::Status status = WriteSessionRecording(session_recorder_->recording(), path);
+    if (status.ok()) {
+      LOG(INFO) << "Recorded " << session_recorder_->recording().frame_count << " frames to "
+                << path;
+    } else {
+      LOG(ERROR) << "Failed to write session recording: " << status;
+    }
+  }
+
   // Cleanup
   ImGui_ImplSDLRenderer2_Shutdown();
   ImGui_ImplSDL2_Shutdown();
@@ -176,6 +203,8 @@ void EditorEngine::Shutdown() {
   collider_manager_.reset();
   level_manager_.reset();
   input_manager_.reset();
+  recording_input_source_.reset();
+  session_recorder_.reset();
   sdl_input_source_.reset();
   imgui_wrapper_.reset();
 
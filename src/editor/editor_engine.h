@@ -10,6 +10,7 @@
 #include "common/sdl_wrapper.h"
 #include "editor/editor_ui.h"
 #include "editor/gui.h"
+#include "editor/level_editor/session_recording.h"
 #include "engine/input_manager.h"
 #include "platform/sdl/sdl_input_source.h"
 #include "platform/sdl/sdl_texture_store.h"
@@ -73,6 +74,10 @@ class EditorEngine {
   std::unique_ptr<PropRecipeManager> prop_recipe_manager_;
   std::unique_ptr<ImGuiWrapper> imgui_wrapper_;
   std::unique_ptr<SdlInputSource> sdl_input_source_;
+  // Set only with --record_session. The input manager polls through the
+  // recording source, so every frame is stamped before anything reads it.
+  std::unique_ptr<SessionRecorder> session_recorder_;
+  std::unique_ptr<RecordingInputSource> recording_input_source_;
   std::unique_ptr<InputManager> input_manager_;
   std::unique_ptr<Api> api_;
 
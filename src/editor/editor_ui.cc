@@ -23,7 +23,8 @@
 namespace zebes {
 
 absl::StatusOr<std::unique_ptr<EditorUi>> EditorUi::Create(SdlWrapper* sdl, Api* api,
-                                                           GuiInterface* gui) {
+                                                           GuiInterface* gui,
+                                                           SessionRecorder* recorder) {
   if (sdl == nullptr) {
     return absl::InvalidArgumentError("SDL wrapper is null");
   }
@@ -33,13 +34,13 @@ absl::StatusOr<std::unique_ptr<EditorUi>> EditorUi::Create(SdlWrapper* sdl, Api*
   if (gui == nullptr) {
     return absl::InvalidArgumentError("Gui interface is null");
   }
-  auto editor_ui = absl::WrapUnique(new EditorUi(sdl, api, gui));
+  auto editor_ui = absl::WrapUnique(new EditorUi(sdl, api, gui, recorder));
   RETURN_IF_ERROR(editor_ui->Init());
   return editor_ui;
 }
 
-EditorUi::EditorUi(SdlWrapper* sdl, Api* api, GuiInterface* gui)
-    : sdl_(sdl), api_(api), gui_(gui) {}
+EditorUi::EditorUi(SdlWrapper* sdl, Api* api, GuiInterface* gui, SessionRecorder* recorder)
+    : sdl_(sdl), api_(api), gui_(gui), recorder_(recorder) {}
 
 absl::Status EditorUi::Init() {
   ASSIGN_OR_RETURN(texture_editor_, TextureEditor::Create(api_, sdl_, gui_));
@@ -47,9 +48,13 @@ absl::Status EditorUi::Init() {
   ASSIGN_OR_RETURN(sprite_editor_, SpriteEditor::Create(api_, sdl_, gui_));
   ASSIGN_OR_RETURN(blueprint_editor_, BlueprintEditor::Create(api_, gui_));
   terrain_ghost_ = std::make_unique<SdlPreviewTexture>(sdl_);
-  ASSIGN_OR_RETURN(
-      level_editor_,
-      LevelEditor::Create({.api = api_, .gui = gui_, .terrain_ghost = terrain_ghost_.get()}));
+  ASSIGN_OR_RETURN(level_editor_, LevelEditor::Create({
+                                      .api = api_,
+                                      .gui = gui_,
+                                      .terrain_ghost = terrain_ghost_.get(),
+                                      .recorder = recorder_,
+                                      .assets_root = api_->GetConfig()->paths.assets(),
+                                  }));
   ASSIGN_OR_RETURN(tileset_editor_, TilesetEditor::Create(api_, gui_));
   terrain_preview_ = std::make_unique<SdlPreviewTexture>(sdl_);
   ASSIGN_OR_RETURN(terrain_editor_, TerrainEditor::Create(api_, gui_, terrain_preview_.get()));
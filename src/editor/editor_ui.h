@@ -12,6 +12,7 @@
 #include "editor/gui_interface.h"
 #include "editor/image_generation/image_generation_service.h"
 #include "editor/level_editor/level_editor.h"
+#include "editor/level_editor/session_recording.h"
 #include "editor/prop_artwork_editor/prop_artwork_editor.h"
 #include "editor/sdl_preview_texture.h"
 #include "editor/sprite_editor/sprite_editor.h"
@@ -23,8 +24,10 @@ namespace zebes {
 
 class EditorUi {
  public:
+  // `recorder` receives the Level Editor's edits; null records nothing.
   static absl::StatusOr<std::unique_ptr<EditorUi>> Create(SdlWrapper* sdl, Api* api,
-                                                          GuiInterface* gui);
+                                                          GuiInterface* gui,
+                                                          SessionRecorder* recorder = nullptr);
   ~EditorUi() = default;
 
   // Render all editor UI windows
@@ -33,7 +36,7 @@ class EditorUi {
  private:
   // Renders a tab and reports failures without discarding editor state.
   void RenderTab(const char* name, const std::function<absl::Status()>& render_fn);
-  explicit EditorUi(SdlWrapper* sdl, Api* api, GuiInterface* gui);
+  EditorUi(SdlWrapper* sdl, Api* api, GuiInterface* gui, SessionRecorder* recorder);
 
   // Initialize owned objects.
   absl::Status Init();
@@ -42,6 +45,7 @@ class EditorUi {
   SdlWrapper* sdl_;
   Api* api_;
   GuiInterface* gui_;
+  SessionRecorder* recorder_;
   std::unique_ptr<TextureEditor> texture_editor_;
   std::unique_ptr<ConfigEditor> config_editor_;
   std::unique_ptr<SpriteEditor> sprite_editor_;
@@ -0,0 +1,218 @@
+#include "editor/level_editor/chunk_impostor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+
+#include "absl/hash/hash.h"
+#include "absl/strings/str_cat.h"
+#include "common/status_macros.h"
+#include "editor/level_editor/parallax_layout.h"
+
+namespace zebes {
+namespace {
+
+constexpr int kChunkCells = TileChunk::kSize * TileChunk::kSize;
+
+// Everything an impostor's pixels depend on besides its own cells. Tiles are
+// few next to cells, so this is cheap to recompute every frame.
+uint64_t SourceStamp(const Tileset& tileset, TextureHandle atlas_texture, const RgbaImage& atlas) {
+  uint64_t stamp = absl::HashOf(atlas_texture.id(), atlas.width, atlas.height, tileset.tile_width,
+                                tileset.tile_height);
+  for (const Tile& tile : tileset.tiles) {
+    stamp = absl::HashOf(stamp, tile.id, tile.source_x, tile.source_y);
+  }
+  return stamp;
+}
+
+WorldRect ChunkBounds(const Level& level, TileChunkCoordinate coordinate) {
+  const double width = static_cast<double>(TileChunk::kSize) * level.tile_render_width;
+  const double height = static_cast<double>(TileChunk::kSize) * level.tile_render_height;
+  const Vec min{coordinate.x * width, coordinate.y * height};
+  return {.min = min, .max = {min.x + width, min.y + height}};
+}
+
+bool IntersectsHalfOpen(const WorldRect& rect, const VisibleWorldBounds& visible) {
+  return rect.max.x > visible.min.x && rect.min.x < visible.max.x && rect.max.y > visible.min.y &&
+         rect.min.y < visible.max.y;
+}
+
+// The half-open run of source pixels that dest pixel `i` of `count` covers in a
+// span of `extent`. Never empty, so a tile smaller than its cell still lands.
+std::pair<int, int> SourceRun(int i, int count, int extent) {
+  const int begin = i * extent / count;
+  const int end = std::max(begin + 1, (i + 1) * extent / count);
+  return {begin, end};
+}
+
+// Area-averages one atlas region into one cell of the impostor. Colour is
+// weighted by alpha, so a tile's transparent border does not darken its edge.
+void BakeCell(const RgbaImage& atlas, const Tile& tile, const Tileset& tileset, int cell_pixels,
+              int cell_x, int cell_y, RgbaImage& image) {
+  for (int dy = 0; dy < cell_pixels; ++dy) {
+    const auto [y0, y1] = SourceRun(dy, cell_pixels, tileset.tile_height);
+    for (int dx = 0; dx < cell_pixels; ++dx) {
+      const auto [x0, x1] = SourceRun(dx, cell_pixels, tileset.tile_width);
+
+      uint64_t red = 0, green = 0, blue = 0, alpha = 0;
+      for (int sy = y0; sy < y1; ++sy) {
+        const uint8_t* row =
+            &atlas.pixels[(static_cast<size_t>(tile.source_y + sy) * atlas.width + tile.source_x) *
+                          4];
+        for (int sx = x0; sx < x1; ++sx) {
+          const uint8_t* pixel = row + static_cast<size_t>(sx) * 4;
+          red += static_cast<uint64_t>(pixel[0]) * pixel[3];
+          green += static_cast<uint64_t>(pixel[1]) * pixel[3];
+          blue += static_cast<uint64_t>(pixel[2]) * pixel[3];
+          alpha += pixel[3];
+        }
+      }
+
+      const uint64_t area = static_cast<uint64_t>(x1 - x0) * (y1 - y0);
+      uint8_t* out = &image.pixels[(static_cast<size_t>(cell_y * cell_pixels + dy) * image.width +
+                                    cell_x * cell_pixels + dx) *
+                                   4];
+      if (alpha == 0) continue;
+      out[0] = static_cast<uint8_t>((red + alpha / 2) / alpha);
+      out[1] = static_cast<uint8_t>((green + alpha / 2) / alpha);
+      out[2] = static_cast<uint8_t>((blue + alpha / 2) / alpha);
+      out[3] = static_cast<uint8_t>((alpha + area / 2) / area);
+    }
+  }
+}
+
+}  // namespace
+
+std::optional<int> SelectChunkImpostorLevel(const Level& level, const Camera& camera) {
+  const double tile_pixels =
+      std::max(level.tile_render_width, level.tile_render_height) * camera.zoom;
+  if (!(tile_pixels < kChunkImpostorLevelZeroCellPixels)) return std::nullopt;
+
+  for (int impostor_level = kChunkImpostorLevels - 1; impostor_level > 0; --impostor_level) {
+    if (ChunkImpostorCellPixels(impostor_level) >= tile_pixels) return impostor_level;
+  }
+  return 0;
+}
+
+absl::StatusOr<RgbaImage> BakeChunkImpostor(const TileChunk& chunk, const Tileset& tileset,
+                                            const RgbaImage& atlas, int cell_pixels) {
+  if (cell_pixels <= 0) {
+    return absl::InvalidArgumentError("an impostor needs at least one pixel per tile");
+  }
+  if (tileset.tile_width <= 0 || tileset.tile_height <= 0) {
+    return absl::InvalidArgumentError("tileset atlas dimensions must be positive");
+  }
+  if (!atlas.IsValid()) {
+    return absl::InvalidArgumentError("impostor atlas must be tightly packed RGBA");
+  }
+
+  absl::flat_hash_map<int, const Tile*> tiles;
+  for (const Tile& tile : tileset.tiles) tiles.emplace(tile.id, &tile);
+
+  RgbaImage image{
+      .width = TileChunk::kSize * cell_pixels,
+      .height = TileChunk::kSize * cell_pixels,
+  };
+  image.pixels.assign(static_cast<size_t>(image.width) * image.height * 4, 0);
+
+  for (int index = 0; index < kChunkCells; ++index) {
+    const int tile_id = chunk.tile(index);
+    if (tile_id == 0) continue;
+
+    const auto tile = tiles.find(tile_id);
+    if (tile == tiles.end()) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("level references unknown tile ID: ", tile_id));
+    }
+    const Tile& source = *tile->second;
+    if (source.source_x < 0 || source.source_y < 0 ||
+        source.source_x + tileset.tile_width > atlas.width ||
+        source.source_y + tileset.tile_height > atlas.height) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("tile ", tile_id, " lies outside its atlas"));
+    }
+    BakeCell(atlas, source, tileset, cell_pixels, index % TileChunk::kSize,
+             index / TileChunk::kSize, image);
+  }
+  return image;
+}
+
+ChunkImpostorCache::~ChunkImpostorCache() { Clear(); }
+
+absl::StatusOr<ChunkImpostorFrame> ChunkImpostorCache::Compose(
+    const Level& level, const WorldLayer& layer, const Tileset& tileset,
+    TextureHandle atlas_texture, const RgbaImage& atlas, const Camera& camera,
+    int impostor_level) {
+  if (impostor_level < 0 || impostor_level >= kChunkImpostorLevels) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("impostor level ", impostor_level, " does not exist"));
+  }
+  if (level.tile_render_width <= 0 || level.tile_render_height <= 0) {
+    return absl::InvalidArgumentError("tile render dimensions must be positive");
+  }
+  if (!std::isfinite(camera.zoom) || camera.zoom <= 0.0) {
+    return absl::InvalidArgumentError("camera zoom must be finite and positive");
+  }
+
+  const uint64_t stamp = SourceStamp(tileset, atlas_texture, atlas);
+  const VisibleWorldBounds visible = CalculateVisibleWorldBounds(camera);
+  std::map<TileChunkCoordinate, std::pair<int64_t, const TileChunk*>> visible_chunks;
+  for (const auto& [key, chunk] : layer.tile_chunks) {
+    const TileChunkCoordinate coordinate = DecodeChunkKey(key);
+    if (coordinate.x < 0 || coordinate.y < 0) {
+      return absl::InvalidArgumentError("level contains a tile chunk with negative coordinates");
+    }
+    if (IntersectsHalfOpen(ChunkBounds(level, coordinate), visible)) {
+      visible_chunks.emplace(coordinate, std::pair{key, &chunk});
+    }
+  }
+
+  ChunkImpostorFrame frame;
+  for (const auto& [coordinate, visible_chunk] : visible_chunks) {
+    const auto& [key, chunk] = visible_chunk;
+    Entry& entry = entries_[{layer.id, key}];
+    entry.last_used_frame = frame_;
+
+    const bool current = entry.texture && entry.level == impostor_level &&
+                         entry.source_stamp == stamp && entry.cells == *chunk;
+    if (!current) {
+      if (bakes_this_frame_ >= options_.max_bakes_per_frame) {
+        frame.pending.insert(key);
+        continue;
+      }
+      ASSIGN_OR_RETURN(const RgbaImage image,
+                       BakeChunkImpostor(*chunk, tileset, atlas,
+                                         ChunkImpostorCellPixels(impostor_level)));
+      ASSIGN_OR_RETURN(const TextureHandle texture, textures_.Upload(image));
+      if (entry.texture) textures_.Release(entry.texture);
+      entry.texture = texture;
+      entry.level = impostor_level;
+      entry.source_stamp = stamp;
+      entry.cells = *chunk;
+      ++bakes_this_frame_;
+    }
+    frame.items.push_back(
+        ChunkImpostorRenderItem{.bounds = ChunkBounds(level, coordinate), .texture = entry.texture});
+  }
+  return frame;
+}
+
+void ChunkImpostorCache::EndFrame() {
+  absl::erase_if(entries_, [&](const auto& keyed) {
+    const Entry& entry = keyed.second;
+    if (frame_ - entry.last_used_frame < options_.release_after_frames) return false;
+    if (entry.texture) textures_.Release(entry.texture);
+    return true;
+  });
+  ++frame_;
+  bakes_this_frame_ = 0;
+}
+
+void ChunkImpostorCache::Clear() {
+  for (auto& [key, entry] : entries_) {
+    if (entry.texture) textures_.Release(entry.texture);
+  }
+  entries_.clear();
+}
+
+}  // namespace zebes
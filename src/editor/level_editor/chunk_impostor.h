@@ -0,0 +1,144 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/status/statusor.h"
+#include "common/image_io.h"
+#include "editor/level_editor/viewport_model.h"
+#include "engine/texture_handle.h"
+#include "objects/camera.h"
+#include "objects/level.h"
+#include "objects/tileset.h"
+
+namespace zebes {
+
+// Whole chunks drawn as one picture when the camera is far enough out.
+//
+// Zoomed out over a large level, drawing every tile as its own quad means
+// hundreds of thousands of quads for artwork a few pixels across. Instead each
+// visible 32x32 chunk is composited once into a small texture, and that texture
+// is drawn in its place. The number of impostors on screen is bounded by the
+// viewport rather than by the world, so overview navigation costs the same on
+// any level.
+//
+// Impostors come in levels, each half the size of the one before: a tile is 8
+// pixels across at level 0 and 1 pixel at the last. The viewport switches over
+// once a tile covers fewer screen pixels than level 0 gives it, and then uses
+// the smallest level that still has a pixel for every screen pixel.
+inline constexpr int kChunkImpostorLevels = 4;
+inline constexpr int kChunkImpostorLevelZeroCellPixels = 8;
+
+// Pixels per tile side at an impostor level.
+constexpr int ChunkImpostorCellPixels(int level) {
+  return kChunkImpostorLevelZeroCellPixels >> level;
+}
+
+// The impostor level the camera calls for, or nullopt when tiles are large
+// enough on screen to draw individually.
+std::optional<int> SelectChunkImpostorLevel(const Level& level, const Camera& camera);
+
+// Composites one chunk into a single image with `cell_pixels` pixels per tile
+// side, area-averaging each tile's atlas region down to its cell. Empty cells
+// are transparent; a tile the tileset does not define is an error, as it is
+// for ComposeLevelTileRenderBatch.
+absl::StatusOr<RgbaImage> BakeChunkImpostor(const TileChunk& chunk, const Tileset& tileset,
+                                            const RgbaImage& atlas, int cell_pixels);
+
+// Uploads impostors and gives them back.
+//
+// The same split as PreviewTextureSink: the SDL-facing implementation lives
+// with the viewport, and tests substitute one that only counts. Unlike a
+// preview, impostors are many and each outlives the frame that made it.
+class ChunkImpostorTextures {
+ public:
+  virtual ~ChunkImpostorTextures() = default;
+
+  virtual absl::StatusOr<TextureHandle> Upload(const RgbaImage& image) = 0;
+  virtual void Release(TextureHandle texture) = 0;
+};
+
+// One chunk drawn as one quad.
+struct ChunkImpostorRenderItem {
+  WorldRect bounds;
+  TextureHandle texture;
+};
+
+struct ChunkImpostorFrame {
+  // Visible chunks with a current impostor, in row-major order.
+  std::vector<ChunkImpostorRenderItem> items;
+  // Visible chunks still waiting for one. The caller draws these tile by tile
+  // this frame, so a chunk is never missing while its impostor is pending.
+  absl::flat_hash_set<int64_t> pending;
+};
+
+// Impostors for the chunks the viewport has recently shown.
+//
+// Regeneration is lazy. An impostor is rebaked only when its chunk is visible
+// and something it was made from has changed: the chunk's cells, the atlas
+// texture (a derived terrain's grows, and every upload is a new handle), or
+// which atlas region a tile names. Changed cells are noticed by comparing the
+// chunk against the copy taken when it was baked, so nothing that writes tiles
+// has to remember to invalidate anything.
+//
+// Bakes are capped per frame so zooming out over a large level spreads the
+// work over a few frames instead of stalling one; chunks past the cap are
+// reported as pending. Impostors not shown for a while are released, which
+// keeps texture memory proportional to the viewport.
+class ChunkImpostorCache {
+ public:
+  struct Options {
+    int max_bakes_per_frame = 24;
+    int release_after_frames = 120;
+  };
+
+  explicit ChunkImpostorCache(ChunkImpostorTextures& textures) : ChunkImpostorCache(textures, {}) {}
+  ChunkImpostorCache(ChunkImpostorTextures& textures, Options options)
+      : textures_(textures), options_(options) {}
+  ~ChunkImpostorCache();
+
+  ChunkImpostorCache(const ChunkImpostorCache&) = delete;
+  ChunkImpostorCache& operator=(const ChunkImpostorCache&) = delete;
+
+  // The impostors for one layer's visible chunks at `impostor_level`, baking
+  // whichever are missing or stale within this frame's budget.
+  //
+  // `atlas` must hold the pixels `atlas_texture` was made from: the impostors
+  // are composited on the CPU, and the handle is what says they are current.
+  absl::StatusOr<ChunkImpostorFrame> Compose(const Level& level, const WorldLayer& layer,
+                                             const Tileset& tileset, TextureHandle atlas_texture,
+                                             const RgbaImage& atlas, const Camera& camera,
+                                             int impostor_level);
+
+  // Closes the frame: resets the bake budget and releases impostors that have
+  // gone unseen for too long.
+  void EndFrame();
+
+  // Releases every impostor.
+  void Clear();
+
+  int size() const { return static_cast<int>(entries_.size()); }
+
+ private:
+  struct Entry {
+    int level = 0;
+    uint64_t source_stamp = 0;
+    TextureHandle texture;
+    // The cells the impostor shows.
+    TileChunk cells;
+    int64_t last_used_frame = 0;
+  };
+
+  ChunkImpostorTextures& textures_;
+  Options options_;
+  // Keyed by (world layer ID, chunk key).
+  absl::flat_hash_map<std::pair<int, int64_t>, Entry> entries_;
+  int64_t frame_ = 0;
+  int bakes_this_frame_ = 0;
+};
+
+}  // namespace zebes
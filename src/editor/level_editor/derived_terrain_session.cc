@@ -60,6 +60,10 @@ TerrainTileProvider* DerivedTerrainSession::provider() {
   return provider_.has_value() ? &*provider_ : nullptr;
 }
 
+const RgbaImage* DerivedTerrainSession::atlas() const {
+  return provider_.has_value() ? &provider_->atlas() : nullptr;
+}
+
 bool DerivedTerrainSession::has_unsaved_artwork() const {
   return provider_.has_value() && provider_->appended_tile_count() > committed_tiles_;
 }
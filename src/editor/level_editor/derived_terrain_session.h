@@ -41,6 +41,9 @@ class DerivedTerrainSession {
   // Null when closed, which is the signal to use the authored-artwork provider.
   TerrainTileProvider* provider();
 
+  // The atlas as it stands in memory, new artwork included. Null when closed.
+  const RgbaImage* atlas() const;
+
   // Uploads artwork appended since the last call. Cheap and idempotent when
   // nothing was appended, so callers may run it every frame.
   absl::Status ShowNewArtwork(Api& api);
@@ -2,13 +2,22 @@
 
 #include <algorithm>
 #include <set>
+#include <vector>
 
+#include "absl/container/flat_hash_set.h"
 #include "absl/strings/str_cat.h"
+#include "common/parallel_for.h"
 #include "common/status_macros.h"
 
 namespace zebes {
 namespace {
 
+// Fewer unrendered keys than this render on the calling thread. A drag paints
+// every frame, and once its first cells are memoized a frame usually leaves
+// only a handful of keys, which starting a thread per core would cost more
+// than rendering them here.
+constexpr int kMinParallelRenders = 8;
+
 // Copies artwork into an atlas cell. Unlike CopyTile in blob47_compose this
 // takes independent width and height, because a tileset's cells need not be
 // square.
@@ -169,6 +178,42 @@ absl::StatusOr<TerrainPreview> DerivedTileProvider::PreviewForKey(const Terrain&
   return TerrainPreview{.artwork = std::move(artwork)};
 }
 
+absl::Status DerivedTileProvider::PrepareKeys(const Terrain& terrain,
+                                              absl::Span<const TerrainCellKey> keys) {
+  if (terrain.scheme != TerrainScheme::kDerived) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("terrain '", terrain.name, "' is not derived and has no recipe to render"));
+  }
+
+  std::vector<TerrainCellKey> unrendered;
+  absl::flat_hash_set<TerrainCellKey> seen;
+  for (const TerrainCellKey& key : keys) {
+    if (tile_by_key_.contains(key) || preview_by_key_.contains(key)) continue;
+    if (seen.insert(key).second) unrendered.push_back(key);
+  }
+
+  // Each render reads only the renderer's immutable fields and writes only its
+  // own slot, so the workers share nothing but the input.
+  const int count = static_cast<int>(unrendered.size());
+  std::vector<RgbaImage> artwork(unrendered.size());
+  RETURN_IF_ERROR(ParallelFor(
+      count, /*max_workers=*/count < kMinParallelRenders ? 1 : 0, [&](int i) -> absl::Status {
+        const TerrainCellKey& key = unrendered[i];
+        ASSIGN_OR_RETURN(artwork[i],
+                         renderer_.RenderShapeTileInContext(key.shape, key.neighbors, key.phase));
+        return absl::OkStatus();
+      }));
+
+  for (size_t i = 0; i < unrendered.size(); ++i) {
+    if (const std::optional<int> existing = content_.Find(artwork[i]); existing.has_value()) {
+      tile_by_key_.emplace(unrendered[i], *existing);
+      continue;
+    }
+    preview_by_key_.emplace(unrendered[i], std::move(artwork[i]));
+  }
+  return absl::OkStatus();
+}
+
 absl::StatusOr<int> DerivedTileProvider::TileForKey(const Terrain& terrain,
                                                     const TerrainCellKey& key, int tile_x,
                                                     int tile_y) {
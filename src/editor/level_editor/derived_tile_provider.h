@@ -5,6 +5,7 @@
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/status/statusor.h"
+#include "absl/types/span.h"
 #include "common/image_io.h"
 #include "editor/level_editor/terrain_brush.h"
 #include "objects/tileset.h"
@@ -61,6 +62,15 @@ class DerivedTileProvider : public TerrainTileProvider {
   absl::StatusOr<TerrainPreview> PreviewForKey(const Terrain& terrain, const TerrainCellKey& key,
                                                int tile_x, int tile_y) override;
 
+  // Renders every key not already settled, across all cores, and parks the
+  // pixels where TileForKey will find them.
+  //
+  // Rendering is the expensive, pure half of resolving a key, so it is the half
+  // that fans out. Looking the pixels up and appending stay on the calling
+  // thread and happen later in TileForKey, so tile IDs are handed out in the
+  // order the region asks rather than the order workers finish.
+  absl::Status PrepareKeys(const Terrain& terrain, absl::Span<const TerrainCellKey> keys) override;
+
   // Whether anything was appended since Create. False means the caller has
   // nothing to write back, which is the common case once a level settles.
   bool has_uncommitted_tiles() const { return appended_ > 0; }
@@ -86,9 +96,10 @@ class DerivedTileProvider : public TerrainTileProvider {
   RgbaImage atlas_;
   TerrainContentIndex content_;
   absl::flat_hash_map<TerrainCellKey, int> tile_by_key_;
-  // Artwork rendered for a preview that had nowhere to go. Kept so that resting
-  // the pointer on a novel cell does not re-render every frame, and dropped
-  // wholesale once a key earns a tile.
+  // Artwork rendered ahead of a tile to hold it: by a preview that had nowhere
+  // to go, or by PrepareKeys ahead of a region paint. Kept so that resting the
+  // pointer on a novel cell does not re-render every frame, and each entry is
+  // dropped once its key earns a tile.
   absl::flat_hash_map<TerrainCellKey, RgbaImage> preview_by_key_;
   int columns_ = 0;
   int appended_ = 0;
@@ -30,6 +30,10 @@ constexpr float kMinimumPaletteHeight = 120.0f;
 constexpr float kMaximumPaletteHeight = 260.0f;
 constexpr float kConstrainedWorkspaceFraction = 0.6f;
 
+// Play mode's pull on every dynamic body, in world pixels per second squared.
+// World y grows down the screen, so positive is down.
+constexpr Vec kPlayGravity = {.x = 0, .y = 600};
+
 }  // namespace
 
 LevelEditorPanelLayout CalculateLevelEditorPanelLayout(float available_height) {
@@ -65,6 +69,8 @@ absl::StatusOr<std::unique_ptr<LevelEditor>> LevelEditor::Create(Options options
 LevelEditor::LevelEditor(Api* api, GuiInterface* gui) : api_(api), gui_(gui) {}
 
 absl::Status LevelEditor::Init(Options options) {
+  recorder_ = options.recorder;
+  assets_root_ = std::move(options.assets_root);
   if (options.level_panel) {
     level_panel_ = std::move(options.level_panel);
   } else {
@@ -120,6 +126,17 @@ absl::Status LevelEditor::SaveActiveLevel() {
   // level naming tiles that are not on disk is a level that will not open.
   RETURN_IF_ERROR(derived_terrain_.Commit(*api_));
 
+  // A streamed level's content is saved as its regions, and only here: edits
+  // stay in memory until the user saves. The definition keeps its layers
+  // empty, as the split left them.
+  if (streamer_ != nullptr) {
+    RETURN_IF_ERROR(streamer_->Commit());
+    for (WorldLayer& layer : level.layers) {
+      layer.tile_chunks.clear();
+      layer.entities.clear();
+    }
+  }
+
   if (level.id.empty()) {
     ASSIGN_OR_RETURN(std::string id, api_->CreateLevel(std::move(level)));
     RETURN_IF_ERROR(level_model_.FinishCreate(id));
@@ -131,6 +148,33 @@ absl::Status LevelEditor::SaveActiveLevel() {
   return absl::OkStatus();
 }
 
+absl::Status LevelEditor::StartStreaming() {
+  if (assets_root_.empty()) return absl::OkStatus();
+  Level& level = *level_model_.active_level();
+  absl::StatusOr<std::unique_ptr<LevelRegionStore>> store =
+      LevelRegionStore::Open(assets_root_, level.id);
+  if (absl::IsNotFound(store.status())) return absl::OkStatus();
+  RETURN_IF_ERROR(store.status());
+  ASSIGN_OR_RETURN(streamer_, LevelStreamer::Create(&level, store->get()));
+  region_store_ = *std::move(store);
+  return absl::OkStatus();
+}
+
+absl::Status LevelEditor::CloseActiveLevel() {
+  // Closing discards unsaved work, a streamed level's resident edits included.
+  streamer_.reset();
+  region_store_.reset();
+  stream_error_.reset();
+  play_.reset();
+  level_model_.CloseActiveLevel();
+  world_layer_model_.Close();
+  viewport_tab_->Reset();
+  selection_.Clear();
+  save_error_.reset();
+  history_error_.reset();
+  return absl::OkStatus();
+}
+
 absl::Status LevelEditor::HandleLevelPanelEvent(LevelPanelEvent event) {
   switch (event.action) {
     case LevelPanelAction::kNone:
@@ -142,6 +186,12 @@ absl::Status LevelEditor::HandleLevelPanelEvent(LevelPanelEvent event) {
       selection_.type = SelectionState::Type::kLevel;
       return absl::OkStatus();
     case LevelPanelAction::kOpen:
+      if (absl::Status status = StartStreaming(); !status.ok()) {
+        // Edited without its regions, the level would save new content into
+        // its definition and then collide with them on the next open.
+        level_model_.CloseActiveLevel();
+        return status;
+      }
       viewport_tab_->Reset();
       world_layer_model_.Open(*level_model_.active_level());
       selection_.Clear();
@@ -161,11 +211,7 @@ absl::Status LevelEditor::HandleLevelPanelEvent(LevelPanelEvent event) {
       RefreshLevelCatalog();
       return absl::OkStatus();
     case LevelPanelAction::kClose:
-      viewport_tab_->Reset();
-      world_layer_model_.Close();
-      selection_.Clear();
-      save_error_.reset();
-      return absl::OkStatus();
+      return CloseActiveLevel();
   }
   return absl::InternalError("Unknown level panel action");
 }
@@ -197,7 +243,7 @@ absl::Status LevelEditor::Render() {
     gui_->TableNextColumn();
     {
       ScopedChild inspector = gui_->CreateScopedChild("LevelEditorInspector", ImVec2(0.0f, 0.0f));
-      if (inspector) RETURN_IF_ERROR(RenderInspector());
+      if (inspector) RETURN_IF_ERROR(RenderUnrecorded([this] { return RenderInspector(); }));
     }
   }
 
@@ -229,17 +275,21 @@ absl::Status LevelEditor::RenderNavigator() {
 
   // A Level is loaded. Render the Scene Graph.
   Level& level = *level_model_.active_level();
+  // Nothing is authored while playing, saving included: the level would be
+  // edited underneath a session that copied it when play started.
+  const bool playing = play_ != nullptr;
 
   if (gui_->Button("Close Level")) {
-    level_model_.CloseActiveLevel();
-    world_layer_model_.Close();
-    viewport_tab_->Reset();
-    selection_.Clear();
-    save_error_.reset();
+    if (absl::Status status = CloseActiveLevel(); !status.ok()) save_error_ = status.message();
     return absl::OkStatus();
   }
   gui_->SameLine();
-  if (gui_->Button("Save Level")) {
+  bool save = false;
+  {
+    ScopedDisabled disabled = gui_->CreateScopedDisabled(playing);
+    save = gui_->Button("Save Level");
+  }
+  if (save && !playing) {
     absl::Status status = SaveActiveLevel();
     if (!status.ok()) {
       save_error_ = status.message();
@@ -247,10 +297,18 @@ absl::Status LevelEditor::RenderNavigator() {
       save_error_.reset();
     }
   }
+  RenderHistoryControls(level);
 
   if (save_error_.has_value()) {
     gui_->TextColored(ImVec4(1.0f, 0.0f, 0.0f, 1.0f), "Save failed: %s", save_error_->c_str());
   }
+  if (history_error_.has_value()) {
+    gui_->TextColored(ImVec4(1.0f, 0.0f, 0.0f, 1.0f), "%s", history_error_->c_str());
+  }
+  if (stream_error_.has_value()) {
+    gui_->TextColored(ImVec4(1.0f, 0.0f, 0.0f, 1.0f), "Streaming failed: %s",
+                      stream_error_->c_str());
+  }
   gui_->Separator();
 
   // Root Node: The Level itself
@@ -270,18 +328,21 @@ absl::Status LevelEditor::RenderNavigator() {
   if (root_open) {
     // 1. World content
     if (gui_->CollapsingHeader("World Layers", ImGuiTreeNodeFlags_DefaultOpen)) {
-      RETURN_IF_ERROR(world_layer_panel_->RenderNavigator(level, world_layer_model_, selection_));
+      RETURN_IF_ERROR(RenderUnrecorded([&] {
+        return world_layer_panel_->RenderNavigator(level, world_layer_model_, selection_,
+                                                   level_model_.journal(), !playing);
+      }));
     }
 
     // 2. Parallax
     if (gui_->CollapsingHeader("Parallax", ImGuiTreeNodeFlags_DefaultOpen)) {
-      RETURN_IF_ERROR(parallax_theme_panel_->RenderNavigator(level, selection_));
+      RETURN_IF_ERROR(parallax_theme_panel_->RenderNavigator(level, selection_, !playing));
 
       std::optional<int> previous_zone_id;
       if (selection_.type == SelectionState::Type::kZone) {
         previous_zone_id = selection_.zone_id;
       }
-      RETURN_IF_ERROR(parallax_zone_panel_->RenderNavigator(level, selection_));
+      RETURN_IF_ERROR(parallax_zone_panel_->RenderNavigator(level, selection_, !playing));
 
       if (selection_.type == SelectionState::Type::kZone &&
           previous_zone_id != selection_.zone_id) {
@@ -304,6 +365,9 @@ absl::Status LevelEditor::RenderInspector() {
     gui_->TextDisabled("No Level Loaded");
     return absl::OkStatus();
   }
+  // Everything below edits the level, which waits until play stops. Frame Zone
+  // only moves the camera, so it stays usable.
+  const bool playing = play_ != nullptr;
 
   switch (selection_.type) {
     case SelectionState::Type::kNone:
@@ -311,24 +375,32 @@ absl::Status LevelEditor::RenderInspector() {
       break;
 
     case SelectionState::Type::kLevel: {
-      ASSIGN_OR_RETURN(LevelPanelEvent event, level_panel_->RenderDetails(level_model_));
-      RETURN_IF_ERROR(HandleLevelPanelEvent(event));
+      LevelPanelEvent event;
+      {
+        ScopedDisabled disabled = gui_->CreateScopedDisabled(playing);
+        ASSIGN_OR_RETURN(event, level_panel_->RenderDetails(level_model_));
+      }
+      if (!playing) RETURN_IF_ERROR(HandleLevelPanelEvent(event));
     } break;
 
-    case SelectionState::Type::kTheme:
+    case SelectionState::Type::kTheme: {
+      ScopedDisabled disabled = gui_->CreateScopedDisabled(playing);
       RETURN_IF_ERROR(
           parallax_theme_panel_->RenderThemeDetails(*level_model_.active_level(), selection_));
-      break;
+    } break;
 
-    case SelectionState::Type::kParallaxLayer:
+    case SelectionState::Type::kParallaxLayer: {
+      ScopedDisabled disabled = gui_->CreateScopedDisabled(playing);
       RETURN_IF_ERROR(
           parallax_theme_panel_->RenderLayerDetails(*level_model_.active_level(), selection_));
-      break;
+    } break;
 
-    case SelectionState::Type::kWorldLayer:
+    case SelectionState::Type::kWorldLayer: {
+      ScopedDisabled disabled = gui_->CreateScopedDisabled(playing);
       RETURN_IF_ERROR(world_layer_panel_->RenderDetails(*level_model_.active_level(),
-                                                        world_layer_model_, selection_));
-      break;
+                                                        world_layer_model_, selection_,
+                                                        level_model_.journal(), streamer_.get()));
+    } break;
 
     case SelectionState::Type::kZone:
       if (gui_->Button("Frame Zone")) {
@@ -338,8 +410,11 @@ absl::Status LevelEditor::RenderInspector() {
           viewport_tab_->FrameZone(*zone);
         }
       }
-      RETURN_IF_ERROR(
-          parallax_zone_panel_->RenderDetails(*level_model_.active_level(), selection_));
+      {
+        ScopedDisabled disabled = gui_->CreateScopedDisabled(playing);
+        RETURN_IF_ERROR(
+            parallax_zone_panel_->RenderDetails(*level_model_.active_level(), selection_));
+      }
       break;
 
     case SelectionState::Type::kEntity: {
@@ -360,7 +435,11 @@ absl::Status LevelEditor::RenderInspector() {
       gui_->Separator();
 
       const bool locked = world_layer_model_.IsLocked(entity_layer->id);
-      ScopedDisabled locked_controls = gui_->CreateScopedDisabled(locked);
+      ScopedDisabled locked_controls = gui_->CreateScopedDisabled(locked || playing);
+      LevelJournal& journal = level_model_.journal();
+      // Typing or dragging a value changes it every frame; coalescing makes
+      // the whole adjustment one undo step.
+      const Entity before = *entity;
       float pos_x = static_cast<float>(entity->transform.position.x);
       float pos_y = static_cast<float>(entity->transform.position.y);
       if (gui_->InputFloat("X", &pos_x)) {
@@ -376,6 +455,7 @@ absl::Status LevelEditor::RenderInspector() {
       if (gui_->InputInt("Draw Order", &sort_order)) {
         entity->sort_order = sort_order;
       }
+      journal.RecordEntity({entity_layer->id, entity_id, before, *entity}, /*coalesce=*/true);
 
       if (ScopedCombo combo = gui_->CreateScopedCombo("World Layer", entity_layer->name.c_str());
           combo) {
@@ -384,9 +464,18 @@ absl::Status LevelEditor::RenderInspector() {
           ScopedDisabled destination_locked =
               gui_->CreateScopedDisabled(world_layer_model_.IsLocked(candidate.id));
           if (gui_->Selectable(candidate.name.c_str(), selected)) {
+            const int source_layer_id = entity_layer->id;
+            const Entity moved = *entity;
             RETURN_IF_ERROR(MoveEntityToLayer(level, entity_id, candidate.id));
+            if (source_layer_id != candidate.id) {
+              journal.BeginGroup();
+              journal.RecordEntity({source_layer_id, entity_id, moved, std::nullopt});
+              journal.RecordEntity({candidate.id, entity_id, std::nullopt, moved});
+              journal.EndGroup();
+            }
             RETURN_IF_ERROR(world_layer_model_.Activate(level, candidate.id));
             entity_layer = FindWorldLayer(level, candidate.id);
+            entity = FindEntity(level, entity_id);
           }
           if (selected) gui_->SetItemDefaultFocus();
         }
@@ -394,6 +483,7 @@ absl::Status LevelEditor::RenderInspector() {
       gui_->Separator();
 
       if (gui_->Button("Remove Entity")) {
+        journal.RecordEntity({entity_layer->id, entity_id, *entity, std::nullopt});
         entity_layer->entities.erase(entity_id);
         selection_.Clear();
       }
@@ -403,6 +493,76 @@ absl::Status LevelEditor::RenderInspector() {
   return absl::OkStatus();
 }
 
+absl::Status LevelEditor::RenderUnrecorded(absl::FunctionRef<absl::Status()> render) {
+  if (recorder_ == nullptr) return render();
+  const uint64_t edits = level_model_.journal().edits();
+  absl::Status status = render();
+  if (level_model_.journal().edits() != edits && level_model_.has_active_level()) {
+    recorder_->RecordUnrecordedEdit(*level_model_.active_level());
+  }
+  return status;
+}
+
+absl::Status LevelEditor::LoadAllBeforeRemovingLayer(bool removes_layer) {
+  if (!removes_layer || streamer_ == nullptr) return absl::OkStatus();
+  return streamer_->LoadAll();
+}
+
+void LevelEditor::RenderHistoryControls(Level& level) {
+  LevelJournal& journal = level_model_.journal();
+  const ImGuiIO& io = gui_->GetIO();
+  // History is authoring like any other tool, so it is off while playing.
+  const bool playing = play_ != nullptr;
+  // Shortcuts only while no widget has focus, so Ctrl+Z in a text field stays
+  // the field's own.
+  const bool shortcuts = !playing && io.KeyCtrl && !gui_->IsAnyItemActive();
+  const bool z_pressed = shortcuts && gui_->IsKeyPressed(ImGuiKey_Z, true);
+  const bool y_pressed = shortcuts && gui_->IsKeyPressed(ImGuiKey_Y, true);
+
+  gui_->SameLine();
+  bool undo = false;
+  {
+    ScopedDisabled disabled = gui_->CreateScopedDisabled(playing || !journal.can_undo());
+    undo = gui_->Button("Undo");
+  }
+  gui_->SameLine();
+  bool redo = false;
+  {
+    ScopedDisabled disabled = gui_->CreateScopedDisabled(playing || !journal.can_redo());
+    redo = gui_->Button("Redo");
+  }
+  undo |= z_pressed && !io.KeyShift;
+  redo |= (z_pressed && io.KeyShift) || y_pressed;
+
+  const size_t position = journal.position();
+  // The recording must start from the level before the step, not after it.
+  if (recorder_ != nullptr && (undo || redo)) recorder_->Begin(level);
+  absl::Status status = absl::OkStatus();
+  if (undo && journal.can_undo()) {
+    status = LoadAllBeforeRemovingLayer(journal.UndoRemovesLayer());
+    if (status.ok()) status = journal.Undo(level);
+  } else if (redo && journal.can_redo()) {
+    status = LoadAllBeforeRemovingLayer(journal.RedoRemovesLayer());
+    if (status.ok()) status = journal.Redo(level);
+  } else {
+    return;
+  }
+  if (!status.ok()) {
+    history_error_ = absl::StrCat(undo ? "Undo" : "Redo", " failed: ", status.message());
+    return;
+  }
+  if (recorder_ != nullptr) {
+    // A failed one changed nothing, so only what landed is worth replaying.
+    if (journal.position() < position) {
+      recorder_->RecordUndo(level);
+    } else {
+      recorder_->RecordRedo(level);
+    }
+  }
+  history_error_.reset();
+  world_layer_model_.Reconcile(level);
+}
+
 void LevelEditor::RenderTilesetMismatchWarning(const Level& level,
                                                const Tileset* rejected_tileset) {
   if (rejected_tileset == nullptr) return;
@@ -432,6 +592,58 @@ void LevelEditor::RenderDerivedArtworkStatus() {
                     status.tiles, status.atlas_width, status.atlas_height, status.unsaved);
 }
 
+void LevelEditor::RenderPlayControls(const Level& level) {
+  if (play_ == nullptr) {
+    if (gui_->Button("Play")) {
+      absl::StatusOr<std::unique_ptr<PlaySession>> session =
+          PlaySession::Create(level, {.gravity = kPlayGravity});
+      if (session.ok()) {
+        play_ = *std::move(session);
+        play_level_id_ = level.id;
+        play_paused_ = false;
+        play_step_ = 0;
+        play_error_.reset();
+      } else {
+        play_error_ = absl::StrCat("Play failed: ", session.status().message());
+      }
+    }
+  } else {
+    if (gui_->Button("Stop")) {
+      play_.reset();
+      return;
+    }
+    gui_->SameLine();
+    // A full command queue only drops a click; the next one gets through.
+    if (gui_->Button(play_paused_ ? "Resume" : "Pause")) {
+      const absl::Status sent = play_paused_ ? play_->engine().Resume() : play_->engine().Pause();
+      if (sent.ok()) play_paused_ = !play_paused_;
+    }
+    gui_->SameLine();
+    {
+      ScopedDisabled disabled = gui_->CreateScopedDisabled(!play_paused_);
+      if (gui_->Button("Step")) play_->engine().StepOnce().IgnoreError();
+    }
+    gui_->SameLine();
+    gui_->TextDisabled("Playing: step %" PRId64, play_step_);
+  }
+  if (play_error_.has_value()) {
+    gui_->TextColored(ImVec4(1.0f, 0.0f, 0.0f, 1.0f), "%s", play_error_->c_str());
+  }
+}
+
+void LevelEditor::CollectPlayPositions(const Level& level) {
+  play_positions_.clear();
+  SnapshotExchange<PlaySnapshot>::Read snapshot = play_->engine().AcquireSnapshot();
+  if (!snapshot) return;
+  play_step_ = snapshot->step;
+  for (const WorldLayer& layer : level.layers) {
+    for (const auto& [id, entity] : layer.entities) {
+      const std::optional<size_t> index = play_->engine().IndexOf(id);
+      if (index.has_value()) play_positions_[id] = snapshot->positions[*index];
+    }
+  }
+}
+
 absl::Status LevelEditor::RenderViewport() {
   gui_->Text("Viewport");
   gui_->Separator();
@@ -445,11 +657,27 @@ absl::Status LevelEditor::RenderViewport() {
     return absl::OkStatus();
   }
   world_layer_model_.Reconcile(*level);
+  if (streamer_ != nullptr) {
+    // Loads what comes into view and drops unedited regions far out of it. A
+    // refused region is reported here until its conflict is cleared.
+    const absl::Status streamed = streamer_->Update(viewport_tab_->camera_position());
+    if (streamed.ok()) {
+      stream_error_.reset();
+    } else {
+      stream_error_ = streamed.message();
+    }
+  }
   WorldLayer* active_world_layer = world_layer_model_.active_layer(*level);
   if (active_world_layer == nullptr) {
     return absl::FailedPreconditionError("level viewport has no active world layer");
   }
-  const bool active_world_layer_editable = world_layer_model_.IsVisible(active_world_layer->id) &&
+  if (play_ != nullptr && play_level_id_ != level->id) play_.reset();
+  RenderPlayControls(*level);
+  const bool playing = play_ != nullptr;
+  if (playing) CollectPlayPositions(*level);
+  // Nothing is authored while playing: what the viewport shows is not the level.
+  const bool active_world_layer_editable = !playing &&
+                                           world_layer_model_.IsVisible(active_world_layer->id) &&
                                            !world_layer_model_.IsLocked(active_world_layer->id);
 
   const Tileset* terrain_tileset = palette_panel_->GetSelectedTerrainTileset();
@@ -460,6 +688,9 @@ absl::Status LevelEditor::RenderViewport() {
       .terrain_id = palette_panel_->GetSelectedTerrainId(),
   };
   const PaletteBinding binding = ResolvePaletteBinding(*level, selection);
+  // Tile IDs mean nothing under another tileset, so no edit made under the old
+  // one may be replayed under the new.
+  if (binding.tileset_id != level->tileset_id) level_model_.journal().Clear();
   level->tileset_id = binding.tileset_id;
   RenderTilesetMismatchWarning(*level, binding.rejected_tileset);
 
@@ -475,7 +706,13 @@ absl::Status LevelEditor::RenderViewport() {
   // Opened before the index is built, because a derived terrain grows the
   // tileset and the index has to see every tile that exists.
   if (bound_tileset != nullptr) {
+    // Reopening drops unsaved artwork, and redoing a stroke that painted it
+    // would write tile IDs nothing renders.
+    const bool had_unsaved_artwork = derived_terrain_.has_unsaved_artwork();
     RETURN_IF_ERROR(derived_terrain_.OpenFor(*api_, *bound_tileset));
+    if (had_unsaved_artwork && !derived_terrain_.has_unsaved_artwork()) {
+      level_model_.journal().Clear();
+    }
   }
   RenderDerivedArtworkStatus();
 
@@ -487,7 +724,7 @@ absl::Status LevelEditor::RenderViewport() {
   if (paint_terrain_id.has_value() && bound_tileset != nullptr) {
     ASSIGN_OR_RETURN(terrain_index, TerrainIndex::Build(*bound_tileset));
   }
-  if (!terrain_index.has_value()) paint_terrain_id.reset();
+  if (!terrain_index.has_value() || playing) paint_terrain_id.reset();
 
   // Which provider answers is the scheme's whole difference. The authored one
   // is rebuilt per frame because it holds nothing; the derived one is the
@@ -508,17 +745,21 @@ absl::Status LevelEditor::RenderViewport() {
       .paint_shape = palette_panel_->GetSelectedTerrainShape(),
       .terrain_index = terrain_index.has_value() ? &*terrain_index : nullptr,
       .terrain_provider = terrain_provider,
-      .placement_blueprint = palette_panel_->GetSelectedBlueprint(),
+      .placement_blueprint = playing ? nullptr : palette_panel_->GetSelectedBlueprint(),
       .selected_entity_id = (selection_.type == SelectionState::Type::kEntity)
                                 ? selection_.entity_id
                                 : Entity::kInvalidId,
       .snap_to_grid = palette_panel_->GetSnapToGrid(),
       .show_entity_borders = palette_panel_->GetShowEntityBorders(),
-      .delete_mode = palette_panel_->GetDeleteMode(),
-      .placement_tile = binding.tile,
+      .delete_mode = !playing && palette_panel_->GetDeleteMode(),
+      .journal = &level_model_.journal(),
+      .recorder = recorder_,
+      .streamer = streamer_.get(),
+      .placement_tile = playing ? nullptr : binding.tile,
       .show_tile_frame = palette_panel_->GetShowTileFrame(),
       .show_tile_collision = palette_panel_->GetShowTileCollision(),
       .tile_overlay_opacity = palette_panel_->GetTileOverlayOpacity(),
+      .tile_atlas_pixels = derived_terrain_.atlas(),
       .entity_overlay_opacity = palette_panel_->GetEntityOverlayOpacity(),
       .selected_zone_id = (selection_.type == SelectionState::Type::kZone)
                               ? std::optional<int>(selection_.zone_id)
@@ -530,6 +771,7 @@ absl::Status LevelEditor::RenderViewport() {
       .selected_parallax_layer_index = (selection_.type == SelectionState::Type::kParallaxLayer)
                                            ? std::optional<int>(selection_.layer_index)
                                            : std::nullopt,
+      .play_positions = playing ? &play_positions_ : nullptr,
   });
 
   // Painting may have rendered artwork the atlas did not hold. Upload it before
@@ -545,12 +787,20 @@ absl::Status LevelEditor::RenderViewport() {
   std::optional<uint64_t> delete_request = viewport_tab_->TakeDeleteRequest();
   if (delete_request.has_value()) {
     if (selection_.entity_id == *delete_request) selection_.Clear();
-    active_world_layer->entities.erase(*delete_request);
+    if (const auto deleted = active_world_layer->entities.find(*delete_request);
+        deleted != active_world_layer->entities.end()) {
+      level_model_.journal().RecordEntity(
+          {active_world_layer->id, *delete_request, deleted->second, std::nullopt});
+      active_world_layer->entities.erase(deleted);
+    }
   }
 
   std::optional<Entity> new_entity = viewport_tab_->TakeNewEntity();
   if (new_entity.has_value()) {
+    const Entity added = *new_entity;
     RETURN_IF_ERROR(level->AddEntity(active_world_layer->id, std::move(*new_entity)));
+    level_model_.journal().RecordEntity(
+        {active_world_layer->id, added.id, std::nullopt, added});
   }
 
   std::optional<uint64_t> click_selection = viewport_tab_->TakeClickSelection();
@@ -1,7 +1,13 @@
 #pragma once
 
+#include <cstdint>
 #include <memory>
+#include <optional>
+#include <string>
 
+#include "absl/container/flat_hash_map.h"
+#include "absl/functional/function_ref.h"
+#include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "api/api.h"
 #include "editor/gui_interface.h"
@@ -12,10 +18,15 @@
 #include "editor/level_editor/palette_panel.h"
 #include "editor/level_editor/parallax_theme_panel.h"
 #include "editor/level_editor/parallax_zone_panel.h"
+#include "editor/level_editor/play_session.h"
+#include "editor/level_editor/session_recording.h"
 #include "editor/level_editor/viewport_tab.h"
 #include "editor/level_editor/world_layer_model.h"
 #include "editor/level_editor/world_layer_panel.h"
 #include "objects/level.h"
+#include "objects/vec.h"
+#include "resources/level_region_store.h"
+#include "resources/level_streamer.h"
 
 namespace zebes {
 
@@ -36,6 +47,13 @@ class LevelEditor {
     // Uploads artwork for a hovered cell whose picture no tile holds yet. Null
     // previews such a cell as nothing, which is what a headless test wants.
     PreviewTextureSink* terrain_ghost = nullptr;
+    // Receives every viewport command, undo and redo, for replaying the
+    // session headless. Null records nothing. Must outlive the editor.
+    SessionRecorder* recorder = nullptr;
+    // Where level files live. A level split into regions there is streamed
+    // around the viewport camera; empty opens every level whole, which is what
+    // a test that never touches disk wants.
+    std::string assets_root;
     std::unique_ptr<LevelPanelInterface> level_panel;
     std::unique_ptr<ParallaxThemePanel> parallax_theme_panel;
     std::unique_ptr<ParallaxZonePanel> parallax_zone_panel;
@@ -60,6 +78,11 @@ class LevelEditor {
   absl::Status Init(Options options);
   void RefreshLevelCatalog();
   absl::Status SaveActiveLevel();
+  // Starts streaming the level just opened when it has regions on disk.
+  absl::Status StartStreaming();
+  // Writes out what only the live level holds, then closes it. A streamed level
+  // whose regions cannot be written stays open, so nothing is lost.
+  absl::Status CloseActiveLevel();
   absl::Status HandleLevelPanelEvent(LevelPanelEvent event);
 
   // Renders the level list and management controls.
@@ -68,6 +91,26 @@ class LevelEditor {
   // Renders the main editing viewport.
   absl::Status RenderViewport();  // Middle
 
+  // Play, Pause, Step and Stop. Starting play simulates the level as it is now;
+  // stopping throws the simulation away and leaves the level untouched.
+  void RenderPlayControls(const Level& level);
+
+  // Copies where the newest play snapshot has each of the level's entities,
+  // holding the snapshot no longer than that takes.
+  void CollectPlayPositions(const Level& level);
+
+  // Runs `render`, a panel whose edits reach the journal without a command the
+  // session recorder can replay, and tells the recorder when one does.
+  absl::Status RenderUnrecorded(absl::FunctionRef<absl::Status()> render);
+
+  // Loads every region of a streamed level when the step about to run removes
+  // a world layer. Otherwise regions still on disk would hold content for a
+  // layer the level no longer has.
+  absl::Status LoadAllBeforeRemovingLayer(bool removes_layer);
+
+  // Undo and Redo, as buttons and as Ctrl+Z, Ctrl+Shift+Z and Ctrl+Y.
+  void RenderHistoryControls(Level& level);
+
   // Explains why a palette selection cannot be painted. Without this the
   // mismatch is invisible: the brush simply does nothing.
   void RenderTilesetMismatchWarning(const Level& level, const Tileset* rejected_tileset);
@@ -84,6 +127,7 @@ class LevelEditor {
 
   Api* api_;
   GuiInterface* gui_;
+  SessionRecorder* recorder_ = nullptr;
 
   // Sub-Panels
   std::unique_ptr<LevelPanelInterface> level_panel_;
@@ -100,10 +144,30 @@ class LevelEditor {
   WorldLayerModel world_layer_model_;
   SelectionState selection_;
   std::optional<std::string> save_error_;
+  std::optional<std::string> history_error_;
   // Long-lived on purpose: it carries a content index rebuilt from the atlas
   // and a memo of everything rendered this session, both of which rebuilding
   // per frame would throw away.
   DerivedTerrainSession derived_terrain_;
+
+  // Play mode, while it runs. The simulation steps on its own thread; the
+  // viewport only ever reads the snapshots it publishes.
+  std::unique_ptr<PlaySession> play_;
+  // The level play_ was started from. Switching levels stops play.
+  std::string play_level_id_;
+  bool play_paused_ = false;
+  int64_t play_step_ = 0;
+  std::optional<std::string> play_error_;
+  // Kept across frames so its buckets are reused rather than reallocated.
+  absl::flat_hash_map<uint64_t, Vec> play_positions_;
+
+  std::string assets_root_;
+  // The open level's regions and the streamer keeping those near the camera
+  // resident in it, while the open level is a streamed one. Declared after
+  // level_model_, which owns the level both point into.
+  std::unique_ptr<LevelRegionStore> region_store_;
+  std::unique_ptr<LevelStreamer> streamer_;
+  std::optional<std::string> stream_error_;
 };
 
 }  // namespace zebes
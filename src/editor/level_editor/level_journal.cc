@@ -0,0 +1,307 @@
+#include "editor/level_editor/level_journal.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "absl/strings/str_cat.h"
+#include "common/status_macros.h"
+
+namespace zebes {
+namespace {
+
+absl::StatusOr<const WorldLayer*> FindLayer(const Level& level, int layer_id) {
+  const WorldLayer* layer = FindWorldLayer(level, layer_id);
+  if (layer == nullptr) {
+    return absl::FailedPreconditionError(
+        absl::StrCat("journal entry names world layer ", layer_id, ", which no longer exists"));
+  }
+  return layer;
+}
+
+absl::Status ValidateLayerDelta(const Level& level, const LevelJournal::LayerDelta& delta,
+                                bool forward) {
+  using Kind = LevelJournal::LayerDelta::Kind;
+  const int size = static_cast<int>(level.layers.size());
+  const bool inserting = (delta.kind == Kind::kInsert) == forward;
+  switch (delta.kind) {
+    case Kind::kInsert:
+    case Kind::kRemove:
+      if (inserting) {
+        if (delta.index < 0 || delta.index > size) {
+          return absl::FailedPreconditionError("journal layer insertion is out of range");
+        }
+        if (FindWorldLayer(level, delta.layer.id) != nullptr) {
+          return absl::FailedPreconditionError(
+              absl::StrCat("world layer ", delta.layer.id, " already exists"));
+        }
+        return absl::OkStatus();
+      }
+      if (delta.index < 0 || delta.index >= size ||
+          level.layers[delta.index].id != delta.layer.id) {
+        return absl::FailedPreconditionError(
+            absl::StrCat("world layer ", delta.layer.id, " is not where the journal left it"));
+      }
+      return absl::OkStatus();
+    case Kind::kSwap:
+      if (delta.index < 0 || delta.index >= size || delta.other_index < 0 ||
+          delta.other_index >= size) {
+        return absl::FailedPreconditionError("journal layer swap is out of range");
+      }
+      return absl::OkStatus();
+  }
+  return absl::InternalError("unknown journal layer edit");
+}
+
+void ApplyLayerDelta(Level& level, const LevelJournal::LayerDelta& delta, bool forward) {
+  using Kind = LevelJournal::LayerDelta::Kind;
+  if (delta.kind == Kind::kSwap) {
+    std::iter_swap(level.layers.begin() + delta.index, level.layers.begin() + delta.other_index);
+    return;
+  }
+  if ((delta.kind == Kind::kInsert) == forward) {
+    level.layers.insert(level.layers.begin() + delta.index, delta.layer);
+  } else {
+    level.layers.erase(level.layers.begin() + delta.index);
+  }
+}
+
+}  // namespace
+
+void LevelJournal::Reset(bool saved) {
+  entries_.clear();
+  position_ = 0;
+  saved_position_ = saved ? std::optional<size_t>(0) : std::nullopt;
+  group_open_ = false;
+  group_cells_.clear();
+  group_entities_.clear();
+}
+
+void LevelJournal::Clear() { Reset(!dirty()); }
+
+void LevelJournal::BeginGroup() {
+  if (group_open_) return;
+  group_open_ = true;
+  group_cells_.clear();
+  group_entities_.clear();
+}
+
+void LevelJournal::EndGroup() {
+  if (!group_open_) return;
+  const bool recorded = !group_cells_.empty() || !group_entities_.empty();
+  group_open_ = false;
+  group_cells_.clear();
+  group_entities_.clear();
+  if (!recorded) return;
+
+  // A cell painted and erased again within one stroke is no edit at all.
+  Entry& entry = entries_.back();
+  std::erase_if(entry.tiles, [](const TileDelta& delta) { return delta.before == delta.after; });
+  std::erase_if(entry.entities,
+                [](const EntityDelta& delta) { return delta.before == delta.after; });
+  if (entry.tiles.empty() && entry.entities.empty()) {
+    entries_.pop_back();
+    --position_;
+  }
+}
+
+LevelJournal::Entry& LevelJournal::Append() {
+  if (group_open_ && (!group_cells_.empty() || !group_entities_.empty())) {
+    return entries_.back();
+  }
+  Push(Entry{});
+  return entries_.back();
+}
+
+void LevelJournal::Push(Entry entry) {
+  // A new edit makes everything that was undone unreachable, the saved state
+  // included when it was among them.
+  if (saved_position_.has_value() && *saved_position_ > position_) saved_position_.reset();
+  entries_.erase(entries_.begin() + position_, entries_.end());
+
+  entries_.push_back(std::move(entry));
+  ++position_;
+  if (entries_.size() <= kMaxEntries) return;
+  entries_.pop_front();
+  --position_;
+  if (saved_position_.has_value()) {
+    saved_position_ = *saved_position_ == 0 ? std::nullopt : std::optional(*saved_position_ - 1);
+  }
+}
+
+absl::Status LevelJournal::RecordTiles(WorldLayer& layer, absl::Span<const TileCoordinate> cells,
+                                       absl::FunctionRef<absl::Status()> edit) {
+  std::vector<TileDelta> deltas;
+  deltas.reserve(cells.size());
+  for (const TileCoordinate& cell : cells) {
+    // Negative cells cannot hold a tile, so no edit can change one.
+    if (cell.x < 0 || cell.y < 0) continue;
+    deltas.push_back({.layer_id = layer.id, .x = cell.x, .y = cell.y});
+  }
+  std::sort(deltas.begin(), deltas.end(), [](const TileDelta& a, const TileDelta& b) {
+    return std::tie(a.y, a.x) < std::tie(b.y, b.x);
+  });
+  deltas.erase(std::unique(deltas.begin(), deltas.end(),
+                           [](const TileDelta& a, const TileDelta& b) {
+                             return a.x == b.x && a.y == b.y;
+                           }),
+               deltas.end());
+  for (TileDelta& delta : deltas) {
+    ASSIGN_OR_RETURN(delta.before, GetTileAt(layer, delta.x, delta.y));
+  }
+
+  const absl::Status edited = edit();
+
+  for (TileDelta& delta : deltas) {
+    ASSIGN_OR_RETURN(delta.after, GetTileAt(layer, delta.x, delta.y));
+  }
+  std::erase_if(deltas, [](const TileDelta& delta) { return delta.before == delta.after; });
+  if (deltas.empty()) return edited;
+  ++edits_;
+
+  if (!group_open_) {
+    Push(Entry{.tiles = std::move(deltas)});
+    return edited;
+  }
+  Entry& entry = Append();
+  for (const TileDelta& delta : deltas) {
+    const auto [slot, added] =
+        group_cells_.try_emplace(std::tuple(delta.layer_id, delta.x, delta.y), entry.tiles.size());
+    if (added) {
+      entry.tiles.push_back(delta);
+    } else {
+      entry.tiles[slot->second].after = delta.after;
+    }
+  }
+  return edited;
+}
+
+void LevelJournal::RecordEntity(EntityDelta delta, bool coalesce) {
+  if (delta.before == delta.after) return;
+  ++edits_;
+
+  if (group_open_) {
+    Entry& entry = Append();
+    const auto [slot, added] = group_entities_.try_emplace(
+        std::pair(delta.layer_id, delta.entity_id), entry.entities.size());
+    if (added) {
+      entry.entities.push_back(std::move(delta));
+    } else {
+      entry.entities[slot->second].after = std::move(delta.after);
+    }
+    return;
+  }
+
+  // Joining the newest entry is only safe while it is not the saved state:
+  // otherwise the saved position would silently come to include this edit.
+  if (coalesce && can_undo() && !can_redo() && saved_position_ != position_) {
+    Entry& newest = entries_.back();
+    if (newest.coalescing && newest.entities.size() == 1 && newest.tiles.empty() &&
+        newest.entities.front().layer_id == delta.layer_id &&
+        newest.entities.front().entity_id == delta.entity_id) {
+      newest.entities.front().after = std::move(delta.after);
+      return;
+    }
+  }
+  Push(Entry{.entities = {std::move(delta)}, .coalescing = coalesce});
+}
+
+void LevelJournal::RecordLayer(LayerDelta delta) {
+  EndGroup();
+  ++edits_;
+  Push(Entry{.layer = std::move(delta)});
+}
+
+bool LevelJournal::UndoRemovesLayer() const {
+  if (!can_undo()) return false;
+  const std::optional<LayerDelta>& layer = entries_[position_ - 1].layer;
+  return layer.has_value() && layer->kind == LayerDelta::Kind::kInsert;
+}
+
+bool LevelJournal::RedoRemovesLayer() const {
+  if (!can_redo()) return false;
+  const std::optional<LayerDelta>& layer = entries_[position_].layer;
+  return layer.has_value() && layer->kind == LayerDelta::Kind::kRemove;
+}
+
+absl::Status LevelJournal::Undo(Level& level) {
+  EndGroup();
+  if (!can_undo()) return absl::FailedPreconditionError("Nothing to undo");
+  const Entry& entry = entries_[position_ - 1];
+  RETURN_IF_ERROR(Validate(level, entry, /*forward=*/false));
+  RETURN_IF_ERROR(Apply(level, entry, /*forward=*/false));
+  --position_;
+  ++edits_;
+  return absl::OkStatus();
+}
+
+absl::Status LevelJournal::Redo(Level& level) {
+  EndGroup();
+  if (!can_redo()) return absl::FailedPreconditionError("Nothing to redo");
+  const Entry& entry = entries_[position_];
+  RETURN_IF_ERROR(Validate(level, entry, /*forward=*/true));
+  RETURN_IF_ERROR(Apply(level, entry, /*forward=*/true));
+  ++position_;
+  ++edits_;
+  return absl::OkStatus();
+}
+
+absl::Status LevelJournal::Validate(const Level& level, const Entry& entry, bool forward) const {
+  if (entry.layer.has_value()) return ValidateLayerDelta(level, *entry.layer, forward);
+
+  for (const EntityDelta& delta : entry.entities) {
+    ASSIGN_OR_RETURN(const WorldLayer* layer, FindLayer(level, delta.layer_id));
+    const std::optional<Entity>& expected = forward ? delta.before : delta.after;
+    const auto found = layer->entities.find(delta.entity_id);
+    const bool matches = found == layer->entities.end() ? !expected.has_value()
+                                                        : expected == found->second;
+    if (!matches) {
+      return absl::FailedPreconditionError(
+          absl::StrCat("entity ", delta.entity_id, " changed outside the journal"));
+    }
+  }
+  for (const TileDelta& delta : entry.tiles) {
+    ASSIGN_OR_RETURN(const WorldLayer* layer, FindLayer(level, delta.layer_id));
+    ASSIGN_OR_RETURN(const int tile_id, GetTileAt(*layer, delta.x, delta.y));
+    if (tile_id != (forward ? delta.before : delta.after)) {
+      return absl::FailedPreconditionError(
+          absl::StrCat("tile (", delta.x, ", ", delta.y, ") changed outside the journal"));
+    }
+  }
+  return absl::OkStatus();
+}
+
+absl::Status LevelJournal::Apply(Level& level, const Entry& entry, bool forward) const {
+  if (entry.layer.has_value()) {
+    ApplyLayerDelta(level, *entry.layer, forward);
+    return absl::OkStatus();
+  }
+
+  auto apply_entity = [&](const EntityDelta& delta) {
+    WorldLayer* layer = FindWorldLayer(level, delta.layer_id);
+    const std::optional<Entity>& target = forward ? delta.after : delta.before;
+    if (target.has_value()) {
+      layer->entities.insert_or_assign(delta.entity_id, *target);
+    } else {
+      layer->entities.erase(delta.entity_id);
+    }
+  };
+  auto apply_tile = [&](const TileDelta& delta) {
+    return SetTileAt(*FindWorldLayer(level, delta.layer_id), delta.x, delta.y,
+                     forward ? delta.after : delta.before);
+  };
+
+  if (forward) {
+    for (const EntityDelta& delta : entry.entities) apply_entity(delta);
+    for (const TileDelta& delta : entry.tiles) RETURN_IF_ERROR(apply_tile(delta));
+    return absl::OkStatus();
+  }
+  for (auto delta = entry.tiles.rbegin(); delta != entry.tiles.rend(); ++delta) {
+    RETURN_IF_ERROR(apply_tile(*delta));
+  }
+  for (auto delta = entry.entities.rbegin(); delta != entry.entities.rend(); ++delta) {
+    apply_entity(*delta);
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace zebes
@@ -0,0 +1,163 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/functional/function_ref.h"
+#include "absl/status/status.h"
+#include "absl/types/span.h"
+#include "editor/level_editor/viewport_model.h"
+#include "objects/entity.h"
+#include "objects/level.h"
+
+namespace zebes {
+
+// Undo history for the level being edited.
+//
+// An entry holds only what one edit changed: the cells it rewrote with their
+// old and new tile IDs, the entities it added, removed or changed, the layers it
+// inserted, deleted or reordered. Undoing or redoing therefore costs the size of
+// the edit and never the size of the level. A brush stroke is one entry however
+// many frames it spans, and the neighbours a terrain stroke re-resolved belong
+// to that same entry.
+//
+// The journal also remembers which position matches what is saved, so whether a
+// level has unsaved work is a comparison of two positions instead of two
+// levels. That only holds while every content edit goes through the journal;
+// whatever it does not record it cannot undo, and Undo() and Redo() refuse an
+// entry the level no longer matches rather than overwrite an unrecorded edit.
+//
+// Tile IDs are only meaningful under one tileset and, for a derived terrain,
+// only while the artwork they name exists. History that crosses a tileset
+// change or outlives discarded artwork is cleared rather than replayed.
+class LevelJournal {
+ public:
+  // One rewritten cell.
+  struct TileDelta {
+    int layer_id = -1;
+    int x = 0;
+    int y = 0;
+    int before = 0;
+    int after = 0;
+  };
+
+  // An entity appearing (no `before`), disappearing (no `after`), or changing.
+  // Moving one between layers is a removal from one and an addition to the
+  // other.
+  struct EntityDelta {
+    int layer_id = -1;
+    uint64_t entity_id = Entity::kInvalidId;
+    std::optional<Entity> before;
+    std::optional<Entity> after;
+  };
+
+  // A whole layer, contents included, inserted at or removed from `index` in
+  // Level::layers; or the layers at `index` and `other_index` trading places.
+  struct LayerDelta {
+    enum class Kind {
+      kInsert,
+      kRemove,
+      kSwap,
+    };
+    Kind kind = Kind::kInsert;
+    int index = 0;
+    int other_index = 0;
+    // Empty for kSwap.
+    WorldLayer layer;
+  };
+
+  // Entries beyond this many drop the oldest. A stroke is one entry, so this
+  // is a long session's worth.
+  static constexpr size_t kMaxEntries = 1000;
+
+  // Forgets every entry. `saved` says whether the level as it stands is the
+  // saved one.
+  void Reset(bool saved = true);
+  // Forgets every entry and keeps whether the level as it stands is saved.
+  void Clear();
+
+  // Whether the level differs from the saved state by anything recorded here.
+  bool dirty() const { return saved_position_ != position_; }
+  void MarkSaved() { saved_position_ = position_; }
+
+  bool can_undo() const { return position_ > 0; }
+  bool can_redo() const { return position_ < entries_.size(); }
+  size_t size() const { return entries_.size(); }
+  size_t position() const { return position_; }
+  // Whether the next Undo or Redo removes a world layer, so a caller holding
+  // content outside the level can bring it in first.
+  bool UndoRemovesLayer() const;
+  bool RedoRemovesLayer() const;
+  // How many edits have been recorded, undone or redone. Only grows, and a
+  // coalesced edit counts though it adds no entry, so a caller can tell
+  // whether anything it ran edited the level.
+  uint64_t edits() const { return edits_; }
+
+  // Every record until EndGroup() joins one entry, and a cell or entity
+  // recorded twice keeps its first `before` and its last `after`. Groups do not
+  // nest: beginning one while one is open continues it.
+  void BeginGroup();
+  void EndGroup();
+  bool in_group() const { return group_open_; }
+
+  // Runs `edit` and records whichever of `cells` on `layer` it changed.
+  //
+  // A cell the edit writes outside `cells` goes unrecorded, so callers name
+  // every cell the edit can reach -- for a terrain stroke, the stroke and its
+  // neighbours. What the edit changed is recorded even when it fails partway,
+  // so the partial edit can still be undone.
+  absl::Status RecordTiles(WorldLayer& layer, absl::Span<const TileCoordinate> cells,
+                           absl::FunctionRef<absl::Status()> edit);
+
+  // Records an entity edit already applied to the level. With `coalesce`, an
+  // edit to the same entity as the newest entry joins it, so dragging a value
+  // in the inspector undoes in one step rather than one per frame.
+  void RecordEntity(EntityDelta delta, bool coalesce = false);
+
+  // Records a layer edit already applied to the level. A layer edit is always
+  // an entry of its own, and ends any open group.
+  void RecordLayer(LayerDelta delta);
+
+  // Steps back or forward one entry. Fails, changing nothing, when there is no
+  // entry to apply or the level does not hold what the entry expects.
+  absl::Status Undo(Level& level);
+  absl::Status Redo(Level& level);
+
+ private:
+  // Either one layer edit or any number of content edits. Entities replay
+  // before tiles, and undo runs the reverse.
+  struct Entry {
+    std::optional<LayerDelta> layer;
+    std::vector<EntityDelta> entities;
+    std::vector<TileDelta> tiles;
+    // Whether the next coalescing entity edit may join this entry.
+    bool coalescing = false;
+  };
+
+  // The entry the next record lands in: the open group's, or a fresh one.
+  Entry& Append();
+  void Push(Entry entry);
+  // Checks every delta against the level before changing any of it.
+  absl::Status Validate(const Level& level, const Entry& entry, bool forward) const;
+  absl::Status Apply(Level& level, const Entry& entry, bool forward) const;
+
+  std::deque<Entry> entries_;
+  // Entries before this one are applied to the level.
+  size_t position_ = 0;
+  // Empty when no reachable position is the saved state.
+  std::optional<size_t> saved_position_ = 0;
+  uint64_t edits_ = 0;
+
+  bool group_open_ = false;
+  // Where the open group has recorded each cell and entity.
+  absl::flat_hash_map<std::tuple<int, int, int>, size_t> group_cells_;
+  absl::flat_hash_map<std::pair<int, uint64_t>, size_t> group_entities_;
+};
+
+}  // namespace zebes
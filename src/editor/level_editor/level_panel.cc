@@ -133,12 +133,10 @@ absl::StatusOr<LevelPanelEvent> LevelPanel::RenderDetails(LevelPanelModel& model
   if (discard_edits_prompt_.armed()) {
     if (discard_edits_prompt_.Render(*gui_, "Back", model.selected_level_id(),
                                      "Discard unsaved changes to this level?", "Back")) {
-      model.CloseActiveLevel();
       return LevelPanelEvent{.action = LevelPanelAction::kClose};
     }
   } else if (gui_->Button("Back")) {
     if (!model.has_unsaved_changes()) {
-      model.CloseActiveLevel();
       return LevelPanelEvent{.action = LevelPanelAction::kClose};
     }
     discard_edits_prompt_.Arm(model.selected_level_id());
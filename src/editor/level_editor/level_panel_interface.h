@@ -13,6 +13,8 @@ enum class LevelPanelAction : std::uint8_t {
   kOpen,
   kSave,
   kDelete,
+  // Leaves the active level. The editor closes it, since a streamed level has
+  // regions to write out first.
   kClose,
 };
 
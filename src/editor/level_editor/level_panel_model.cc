@@ -1,11 +1,43 @@
 #include "editor/level_editor/level_panel_model.h"
 
+#include <cstddef>
+#include <tuple>
 #include <utility>
 
 #include "absl/status/status.h"
 #include "editor/level_editor/level_tiles.h"
 
 namespace zebes {
+namespace {
+
+// The level without its layers' contents. Copies the whole level, which is
+// fine at the rate levels are opened and saved.
+Level WithoutLayerContents(const Level& level) {
+  Level outline = level;
+  for (WorldLayer& layer : outline.layers) {
+    layer.tile_chunks.clear();
+    layer.entities.clear();
+  }
+  return outline;
+}
+
+// Everything has_unsaved_changes() does not leave to the journal. A field added
+// to Level belongs here unless edits to it go through the journal.
+bool SameProperties(const Level& level, const Level& outline) {
+  if (level.layers.size() != outline.layers.size()) return false;
+  for (size_t i = 0; i < level.layers.size(); ++i) {
+    if (level.layers[i].id != outline.layers[i].id) return false;
+    if (level.layers[i].name != outline.layers[i].name) return false;
+  }
+  return std::tie(level.id, level.name, level.tileset_id, level.tile_render_width,
+                  level.tile_render_height, level.width, level.height, level.spawn_point,
+                  level.themes, level.zones) ==
+         std::tie(outline.id, outline.name, outline.tileset_id, outline.tile_render_width,
+                  outline.tile_render_height, outline.width, outline.height, outline.spawn_point,
+                  outline.themes, outline.zones);
+}
+
+}  // namespace
 
 void LevelPanelModel::SetLevels(std::vector<Level> levels) {
   levels_.clear();
@@ -38,8 +70,10 @@ absl::Status LevelPanelModel::RequestTilesetChange(const std::string& tileset_id
   if (tileset_id == active_level_->tileset_id) return absl::OkStatus();
 
   // Nothing is placed, so no tile ID can be reinterpreted by the new tileset.
+  // History could still put some back, so it ends here.
   if (!LevelHasTiles(*active_level_)) {
     active_level_->tileset_id = tileset_id;
+    journal_.Clear();
     return absl::OkStatus();
   }
 
@@ -66,6 +100,9 @@ absl::Status LevelPanelModel::ConfirmTilesetChange() {
   for (WorldLayer& layer : active_level_->layers) layer.tile_chunks.clear();
   active_level_->tileset_id = *std::move(pending_tileset_id_);
   pending_tileset_id_.reset();
+  // The erased tiles are in no entry, so nothing reachable is the saved state
+  // any more -- even once the old tileset is chosen again.
+  journal_.Reset(/*saved=*/false);
   return absl::OkStatus();
 }
 
@@ -90,7 +127,8 @@ absl::Status LevelPanelModel::BeginEditingSelectedLevel() {
 
 void LevelPanelModel::BeginEditingLevel(Level level) {
   active_level_ = std::move(level);
-  baseline_level_ = active_level_;
+  baseline_level_ = WithoutLayerContents(*active_level_);
+  journal_.Reset();
   // A staged tileset change belongs to the level it was requested for.
   pending_tileset_id_.reset();
 }
@@ -98,16 +136,21 @@ void LevelPanelModel::BeginEditingLevel(Level level) {
 void LevelPanelModel::CloseActiveLevel() {
   active_level_.reset();
   baseline_level_.reset();
+  journal_.Reset();
   pending_tileset_id_.reset();
 }
 
 bool LevelPanelModel::has_unsaved_changes() const {
   if (!active_level_.has_value()) return false;
   if (!baseline_level_.has_value()) return true;
-  return *active_level_ != *baseline_level_;
+  return journal_.dirty() || !SameProperties(*active_level_, *baseline_level_);
 }
 
-void LevelPanelModel::MarkSaved() { baseline_level_ = active_level_; }
+void LevelPanelModel::MarkSaved() {
+  if (!active_level_.has_value()) return;
+  baseline_level_ = WithoutLayerContents(*active_level_);
+  journal_.MarkSaved();
+}
 
 bool LevelPanelModel::is_new_level() const {
   return active_level_.has_value() && active_level_->id.empty();
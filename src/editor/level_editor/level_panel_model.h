@@ -8,6 +8,7 @@
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "editor/asset_catalog.h"
+#include "editor/level_editor/level_journal.h"
 #include "objects/level.h"
 
 namespace zebes {
@@ -49,7 +50,8 @@ class LevelPanelModel {
   int placed_tile_count() const;
 
   // Applies the staged change, erasing every placed tile. Fails when nothing
-  // is staged rather than silently doing nothing.
+  // is staged rather than silently doing nothing. Undo history ends here: it
+  // names tiles of the old tileset.
   absl::Status ConfirmTilesetChange();
   void CancelTilesetChange();
 
@@ -65,14 +67,22 @@ class LevelPanelModel {
   bool has_active_level() const { return active_level_.has_value(); }
 
   // Whether the level being edited differs from the state it was opened or last
-  // saved at. Only asked on the frame the user tries to leave, so comparing the
-  // whole level -- tile chunks included -- costs nothing per frame and cannot
-  // miss an edit the way a flag some mutating path forgot to set would.
+  // saved at.
+  //
+  // Tiles, entities and the layer stack are answered by the journal's position,
+  // which is what keeps this cheap on a level of any size; every edit to them
+  // must therefore go through journal(). The level's remaining properties are
+  // small and edited in place by several panels, so those are compared against
+  // the baseline instead.
   bool has_unsaved_changes() const;
   bool is_new_level() const;
   Level* active_level();
   const Level* active_level() const;
 
+  // Undo history for the active level. Reset whenever a level is opened.
+  LevelJournal& journal() { return journal_; }
+  const LevelJournal& journal() const { return journal_; }
+
   absl::StatusOr<Level> BuildSaveRequest() const;
   absl::Status FinishCreate(const std::string& saved_id);
   // Makes the current state the clean one. Called after a successful write, so
@@ -87,8 +97,10 @@ class LevelPanelModel {
   LevelCatalog levels_;
   std::string selected_level_id_;
   std::optional<Level> active_level_;
-  // The active level as it stood when editing began or when it was last saved.
+  // The active level as it stood when editing began or when it was last saved,
+  // without its layers' tiles and entities: the journal answers for those.
   std::optional<Level> baseline_level_;
+  LevelJournal journal_;
   std::vector<TilesetChoice> tileset_choices_;
   // Set only while a tileset change is waiting on confirmation.
   std::optional<std::string> pending_tileset_id_;
@@ -5,9 +5,7 @@ namespace zebes {
 bool LevelHasTiles(const Level& level) {
   for (const WorldLayer& layer : level.layers) {
     for (const auto& entry : layer.tile_chunks) {
-      for (const int tile_id : entry.second.tiles) {
-        if (tile_id != 0) return true;
-      }
+      if (!entry.second.empty()) return true;
     }
   }
   return false;
@@ -16,11 +14,7 @@ bool LevelHasTiles(const Level& level) {
 int CountPlacedTiles(const Level& level) {
   int count = 0;
   for (const WorldLayer& layer : level.layers) {
-    for (const auto& entry : layer.tile_chunks) {
-      for (const int tile_id : entry.second.tiles) {
-        if (tile_id != 0) ++count;
-      }
-    }
+    for (const auto& entry : layer.tile_chunks) count += entry.second.occupied();
   }
   return count;
 }
@@ -2,8 +2,22 @@
 
 #include <algorithm>
 #include <cmath>
+#include <iterator>
+#include <limits>
 
 namespace zebes {
+namespace {
+
+// Bounds the grid however far apart zones are.
+constexpr double kMaxCellsPerAxis = 1 << 16;
+// A zone covering more cells than this is tested on every lookup instead.
+constexpr int64_t kMaxCellsPerZone = 64;
+
+bool ZoneContains(Vec min, Vec max, Vec point) {
+  return point.x >= min.x && point.x < max.x && point.y >= min.y && point.y < max.y;
+}
+
+}  // namespace
 
 VisibleWorldBounds CalculateVisibleWorldBounds(const Camera& camera) {
   const double half_width = camera.viewport_width / (2.0 * camera.zoom);
@@ -23,8 +37,7 @@ const ParallaxZone* FindParallaxZoneById(const std::vector<ParallaxZone>& zones,
 std::optional<ActiveParallaxZone> ResolveActiveParallaxZone(
     const std::vector<ParallaxZone>& zones, Vec reference_point) {
   for (auto it = zones.rbegin(); it != zones.rend(); ++it) {
-    if (reference_point.x >= it->min_point.x && reference_point.x < it->max_point.x &&
-        reference_point.y >= it->min_point.y && reference_point.y < it->max_point.y) {
+    if (ZoneContains(it->min_point, it->max_point, reference_point)) {
       return ActiveParallaxZone{
           .zone_id = it->id,
           .theme_id = it->theme_id,
@@ -84,15 +97,38 @@ std::optional<ParallaxLayout> CalculateParallaxLayout(const Camera& camera,
                                                       const ParallaxLayer& layer,
                                                       int texture_width,
                                                       int texture_height) {
-  if (camera.zoom <= 0 || camera.viewport_width <= 0 || camera.viewport_height <= 0 ||
-      texture_width <= 0 || texture_height <= 0 || layer.base_scale <= 0) {
+  std::optional<ParallaxLayerGeometry> geometry =
+      CalculateParallaxLayerGeometry(layer, texture_width, texture_height);
+  if (!geometry.has_value()) return std::nullopt;
+  return CalculateParallaxLayout(camera, *geometry);
+}
+
+std::optional<ParallaxLayerGeometry> CalculateParallaxLayerGeometry(const ParallaxLayer& layer,
+                                                                    int texture_width,
+                                                                    int texture_height) {
+  if (texture_width <= 0 || texture_height <= 0 || layer.base_scale <= 0) {
+    return std::nullopt;
+  }
+  return ParallaxLayerGeometry{
+      .scroll_factor = layer.scroll_factor,
+      .offset = layer.offset,
+      .tile_width = static_cast<double>(texture_width) * layer.base_scale,
+      .tile_height = static_cast<double>(texture_height) * layer.base_scale,
+      .repeat_x = layer.repeat_x,
+      .repeat_y = layer.repeat_y,
+  };
+}
+
+std::optional<ParallaxLayout> CalculateParallaxLayout(const Camera& camera,
+                                                      const ParallaxLayerGeometry& geometry) {
+  if (camera.zoom <= 0 || camera.viewport_width <= 0 || camera.viewport_height <= 0) {
     return std::nullopt;
   }
 
   ParallaxLayout layout;
-  layout.origin = camera.ParallaxWorldOrigin(layer.scroll_factor, layer.offset);
-  layout.tile_width = static_cast<double>(texture_width) * layer.base_scale;
-  layout.tile_height = static_cast<double>(texture_height) * layer.base_scale;
+  layout.origin = camera.ParallaxWorldOrigin(geometry.scroll_factor, geometry.offset);
+  layout.tile_width = geometry.tile_width;
+  layout.tile_height = geometry.tile_height;
 
   const VisibleWorldBounds visible = CalculateVisibleWorldBounds(camera);
   layout.first_column =
@@ -104,11 +140,11 @@ std::optional<ParallaxLayout> CalculateParallaxLayout(const Camera& camera,
   layout.last_row =
       static_cast<int>(std::floor((visible.max.y - layout.origin.y) / layout.tile_height));
 
-  if (!layer.repeat_x) {
+  if (!geometry.repeat_x) {
     layout.first_column = 0;
     layout.last_column = 0;
   }
-  if (!layer.repeat_y) {
+  if (!geometry.repeat_y) {
     layout.first_row = 0;
     layout.last_row = 0;
   }
@@ -116,4 +152,152 @@ std::optional<ParallaxLayout> CalculateParallaxLayout(const Camera& camera,
   return layout;
 }
 
+void ParallaxZoneIndex::Sync(const std::vector<ParallaxZone>& zones) {
+  bool current = zones.size() == zones_.size();
+  for (size_t i = 0; current && i < zones.size(); ++i) {
+    const ParallaxZone& zone = zones[i];
+    current = zones_[i] == IndexedZone{.id = zone.id,
+                                       .theme_id = zone.theme_id,
+                                       .min = zone.min_point,
+                                       .max = zone.max_point};
+  }
+  if (current) return;
+
+  zones_.clear();
+  zones_.reserve(zones.size());
+  for (const ParallaxZone& zone : zones) {
+    zones_.push_back({.id = zone.id,
+                      .theme_id = zone.theme_id,
+                      .min = zone.min_point,
+                      .max = zone.max_point});
+  }
+  Rebuild();
+}
+
+void ParallaxZoneIndex::Rebuild() {
+  positions_.clear();
+  cells_.clear();
+  wide_.clear();
+
+  Vec bounds_min{std::numeric_limits<double>::infinity(),
+                 std::numeric_limits<double>::infinity()};
+  Vec bounds_max{-std::numeric_limits<double>::infinity(),
+                 -std::numeric_limits<double>::infinity()};
+  Vec total_extent{0, 0};
+  std::vector<size_t> gridded;
+  for (size_t i = 0; i < zones_.size(); ++i) {
+    const IndexedZone& zone = zones_[i];
+    positions_.try_emplace(zone.id, i);
+    // Empty or NaN bounds contain no point, so no lookup has to test them.
+    if (!(zone.min.x < zone.max.x && zone.min.y < zone.max.y)) continue;
+    if (!std::isfinite(zone.min.x) || !std::isfinite(zone.min.y) || !std::isfinite(zone.max.x) ||
+        !std::isfinite(zone.max.y)) {
+      wide_.push_back(i);
+      continue;
+    }
+    gridded.push_back(i);
+    bounds_min = {std::min(bounds_min.x, zone.min.x), std::min(bounds_min.y, zone.min.y)};
+    bounds_max = {std::max(bounds_max.x, zone.max.x), std::max(bounds_max.y, zone.max.y)};
+    total_extent = {total_extent.x + (zone.max.x - zone.min.x),
+                    total_extent.y + (zone.max.y - zone.min.y)};
+  }
+  if (gridded.empty()) return;
+
+  // Cells the size of an average zone keep both the cells per zone and the
+  // zones per cell small. The floor keeps cell coordinates in range however
+  // far apart the zones are.
+  grid_min_ = bounds_min;
+  grid_max_ = bounds_max;
+  const double count = static_cast<double>(gridded.size());
+  cell_size_ = {
+      std::max(total_extent.x / count, (bounds_max.x - bounds_min.x) / kMaxCellsPerAxis),
+      std::max(total_extent.y / count, (bounds_max.y - bounds_min.y) / kMaxCellsPerAxis),
+  };
+
+  std::vector<size_t> wide;
+  for (size_t i : gridded) {
+    const IndexedZone& zone = zones_[i];
+    const Cell first = CellOf(zone.min);
+    const Cell last = CellOf(zone.max);
+    if ((last.first - first.first + 1) * (last.second - first.second + 1) > kMaxCellsPerZone) {
+      wide.push_back(i);
+      continue;
+    }
+    for (int64_t y = first.second; y <= last.second; ++y) {
+      for (int64_t x = first.first; x <= last.first; ++x) {
+        cells_[{x, y}].push_back(i);
+      }
+    }
+  }
+  // Both lists are already ascending, and lookups depend on it.
+  std::vector<size_t> merged;
+  merged.reserve(wide_.size() + wide.size());
+  std::merge(wide_.begin(), wide_.end(), wide.begin(), wide.end(), std::back_inserter(merged));
+  wide_ = std::move(merged);
+}
+
+ParallaxZoneIndex::Cell ParallaxZoneIndex::CellOf(Vec point) const {
+  return {static_cast<int64_t>(std::floor((point.x - grid_min_.x) / cell_size_.x)),
+          static_cast<int64_t>(std::floor((point.y - grid_min_.y) / cell_size_.y))};
+}
+
+std::optional<ActiveParallaxZone> ParallaxZoneIndex::Resolve(Vec reference_point) const {
+  // Positions only grow toward later zones, so the first hit walking a list
+  // backwards is that list's answer, and the later of the two answers wins.
+  std::optional<size_t> found;
+  if (!cells_.empty() && reference_point.x >= grid_min_.x && reference_point.x <= grid_max_.x &&
+      reference_point.y >= grid_min_.y && reference_point.y <= grid_max_.y) {
+    if (auto cell = cells_.find(CellOf(reference_point)); cell != cells_.end()) {
+      for (auto it = cell->second.rbegin(); it != cell->second.rend(); ++it) {
+        if (ZoneContains(zones_[*it].min, zones_[*it].max, reference_point)) {
+          found = *it;
+          break;
+        }
+      }
+    }
+  }
+  for (auto it = wide_.rbegin(); it != wide_.rend(); ++it) {
+    if (found.has_value() && *it < *found) break;
+    if (ZoneContains(zones_[*it].min, zones_[*it].max, reference_point)) {
+      found = *it;
+      break;
+    }
+  }
+
+  if (!found.has_value()) return std::nullopt;
+  return ActiveParallaxZone{
+      .zone_id = zones_[*found].id,
+      .theme_id = zones_[*found].theme_id,
+  };
+}
+
+const ParallaxZone* ParallaxZoneIndex::Find(const std::vector<ParallaxZone>& zones,
+                                            int zone_id) const {
+  if (zones.size() != zones_.size()) return FindParallaxZoneById(zones, zone_id);
+  auto position = positions_.find(zone_id);
+  if (position == positions_.end()) return nullptr;
+  const ParallaxZone& zone = zones[position->second];
+  if (zone.id != zone_id) return FindParallaxZoneById(zones, zone_id);
+  return &zone;
+}
+
+void ParallaxLayoutCache::Sync(const ParallaxTheme& theme, std::optional<int> layer_index) {
+  if (theme_.has_value() && *theme_ == theme && layer_index_ == layer_index) return;
+  theme_ = theme;
+  layer_index_ = layer_index;
+  entries_.clear();
+}
+
+const ParallaxLayerGeometry* ParallaxLayoutCache::Find(size_t item, TextureHandle texture) const {
+  if (item >= entries_.size() || !entries_[item].has_value()) return nullptr;
+  if (entries_[item]->texture != texture) return nullptr;
+  return &entries_[item]->geometry;
+}
+
+void ParallaxLayoutCache::Store(size_t item, TextureHandle texture,
+                                ParallaxLayerGeometry geometry) {
+  if (item >= entries_.size()) entries_.resize(item + 1);
+  entries_[item] = Entry{.texture = texture, .geometry = geometry};
+}
+
 }  // namespace zebes
@@ -1,8 +1,13 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <optional>
+#include <utility>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
+#include "engine/texture_handle.h"
 #include "objects/camera.h"
 #include "objects/level.h"
 
@@ -26,6 +31,17 @@ struct ParallaxLayout {
   int last_row = 0;
 };
 
+// The part of a layer's layout its texture and authored settings fix. Only the
+// camera moves it from frame to frame.
+struct ParallaxLayerGeometry {
+  Vec scroll_factor;
+  Vec offset;
+  double tile_width = 0;
+  double tile_height = 0;
+  bool repeat_x = false;
+  bool repeat_y = false;
+};
+
 // Stable result of resolving the environment at a world-space reference
 // point. Later zones have priority when bounds overlap, matching their existing
 // draw order.
@@ -69,4 +85,95 @@ std::optional<ParallaxLayout> CalculateParallaxLayout(const Camera& camera,
                                                       int texture_width,
                                                       int texture_height);
 
+// The camera-independent half of CalculateParallaxLayout. Returns no geometry
+// when the texture or layer scale cannot produce any.
+std::optional<ParallaxLayerGeometry> CalculateParallaxLayerGeometry(const ParallaxLayer& layer,
+                                                                    int texture_width,
+                                                                    int texture_height);
+
+// Places geometry under the camera. Returns no layout for an invalid camera.
+std::optional<ParallaxLayout> CalculateParallaxLayout(const Camera& camera,
+                                                      const ParallaxLayerGeometry& geometry);
+
+// Answers ResolveActiveParallaxZone and FindParallaxZoneById without scanning
+// every zone, for levels with hundreds of them.
+//
+// Zones are bucketed into a uniform grid sized from their average extent, and
+// a lookup tests only the zones in the reference point's cell, newest first,
+// so the later-zone priority is unchanged. A zone that would span too many
+// cells is kept in a short list tested on every lookup instead.
+//
+// Sync compares the zones against the copy the index was built from and
+// rebuilds on any difference, so nothing that edits zones has to remember to
+// invalidate it.
+class ParallaxZoneIndex {
+ public:
+  // Rebuilds the index when `zones` no longer matches it.
+  void Sync(const std::vector<ParallaxZone>& zones);
+
+  // Same result as ResolveActiveParallaxZone over the synced zones.
+  std::optional<ActiveParallaxZone> Resolve(Vec reference_point) const;
+
+  // Same result as FindParallaxZoneById. `zones` must be the vector last
+  // synced; if it has changed since, this falls back to a scan.
+  const ParallaxZone* Find(const std::vector<ParallaxZone>& zones, int zone_id) const;
+
+ private:
+  struct IndexedZone {
+    int id = 0;
+    int theme_id = -1;
+    Vec min;
+    Vec max;
+
+    bool operator==(const IndexedZone& other) const = default;
+  };
+
+  using Cell = std::pair<int64_t, int64_t>;
+
+  void Rebuild();
+  Cell CellOf(Vec point) const;
+
+  std::vector<IndexedZone> zones_;
+  // First position of each zone ID, like FindParallaxZoneById.
+  absl::flat_hash_map<int, size_t> positions_;
+  // Zone positions per grid cell, ascending.
+  absl::flat_hash_map<Cell, std::vector<size_t>> cells_;
+  // Zones spanning too many cells or with infinite bounds, ascending.
+  std::vector<size_t> wide_;
+  // Bounds of the gridded zones.
+  Vec grid_min_;
+  Vec grid_max_;
+  Vec cell_size_{1, 1};
+};
+
+// Camera-independent geometry for the parallax theme the viewport shows.
+//
+// It is kept until the theme is edited, the shown theme or layer selection
+// changes, or a layer's texture is replaced, so a frame that does none of
+// those only places the cached geometry under the camera. Crossing into a zone
+// with another theme changes the shown theme; crossing into one that shares
+// it keeps the cache. A replaced texture is noticed because every upload is a
+// new handle.
+class ParallaxLayoutCache {
+ public:
+  // Keeps the cache when `theme` and `layer_index` are the ones it was filled
+  // for, and clears it otherwise.
+  void Sync(const ParallaxTheme& theme, std::optional<int> layer_index);
+
+  // The geometry cached for the `item`th rendered layer, if it was computed
+  // for `texture`.
+  const ParallaxLayerGeometry* Find(size_t item, TextureHandle texture) const;
+  void Store(size_t item, TextureHandle texture, ParallaxLayerGeometry geometry);
+
+ private:
+  struct Entry {
+    TextureHandle texture;
+    ParallaxLayerGeometry geometry;
+  };
+
+  std::optional<ParallaxTheme> theme_;
+  std::optional<int> layer_index_;
+  std::vector<std::optional<Entry>> entries_;
+};
+
 }  // namespace zebes
@@ -27,8 +27,14 @@ absl::StatusOr<std::unique_ptr<ParallaxThemePanel>> ParallaxThemePanel::Create(O
 ParallaxThemePanel::ParallaxThemePanel(Options options)
     : api_(*options.api), gui_(options.gui), texture_preview_(*options.gui) {}
 
-absl::Status ParallaxThemePanel::RenderNavigator(Level& level, SelectionState& selection) {
-  if (gui_->Button("Add Theme")) {
+absl::Status ParallaxThemePanel::RenderNavigator(Level& level, SelectionState& selection,
+                                                 bool editable) {
+  bool add_theme = false;
+  {
+    ScopedDisabled disabled = gui_->CreateScopedDisabled(!editable);
+    add_theme = gui_->Button("Add Theme");
+  }
+  if (add_theme && editable) {
     AddTheme(level, selection);
   }
 
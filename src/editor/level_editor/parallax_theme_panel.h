@@ -22,8 +22,9 @@ class ParallaxThemePanel {
 
   static absl::StatusOr<std::unique_ptr<ParallaxThemePanel>> Create(Options options);
 
-  // Renders the Tree View in the Navigator Panel
-  absl::Status RenderNavigator(Level& level, SelectionState& selection);
+  // Renders the Tree View in the Navigator Panel. Themes can still be selected
+  // when `editable` is false, but not added.
+  absl::Status RenderNavigator(Level& level, SelectionState& selection, bool editable);
 
   // Renders Inspector for a selected Theme
   absl::Status RenderThemeDetails(Level& level, SelectionState& selection);
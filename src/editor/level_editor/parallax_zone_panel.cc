@@ -22,14 +22,15 @@ absl::StatusOr<std::unique_ptr<ParallaxZonePanel>> ParallaxZonePanel::Create(Opt
 
 ParallaxZonePanel::ParallaxZonePanel(Options options) : gui_(options.gui) {}
 
-absl::Status ParallaxZonePanel::RenderNavigator(Level& level, SelectionState& selection) {
-  const bool can_add_zone = std::isfinite(level.width) && std::isfinite(level.height) &&
-                            level.width > 0.0 && level.height > 0.0;
+absl::Status ParallaxZonePanel::RenderNavigator(Level& level, SelectionState& selection,
+                                                bool editable) {
+  const bool can_add_zone = editable && std::isfinite(level.width) &&
+                            std::isfinite(level.height) && level.width > 0.0 && level.height > 0.0;
   gui_->BeginDisabled(!can_add_zone);
   const bool add_zone = gui_->Button("Add Zone");
   gui_->EndDisabled();
 
-  if (!can_add_zone) {
+  if (editable && !can_add_zone) {
     gui_->TextDisabled("Set a positive level width and height before adding a zone.");
   }
 
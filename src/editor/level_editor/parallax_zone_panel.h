@@ -18,8 +18,9 @@ class ParallaxZonePanel {
 
   static absl::StatusOr<std::unique_ptr<ParallaxZonePanel>> Create(Options options);
 
-  // Renders the list of Zones in the Navigator.
-  absl::Status RenderNavigator(Level& level, SelectionState& selection);
+  // Renders the list of Zones in the Navigator. Zones can still be selected
+  // when `editable` is false, but not added.
+  absl::Status RenderNavigator(Level& level, SelectionState& selection, bool editable);
 
   // Renders details for a selected Zone in the Inspector.
   absl::Status RenderDetails(Level& level, SelectionState& selection);
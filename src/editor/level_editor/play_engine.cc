@@ -0,0 +1,135 @@
+#include "editor/level_editor/play_engine.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <variant>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "common/status_macros.h"
+
+namespace zebes {
+namespace {
+
+absl::flat_hash_map<uint64_t, size_t> IndexEntities(const RuntimeEntities& entities) {
+  absl::flat_hash_map<uint64_t, size_t> index_by_id;
+  index_by_id.reserve(entities.size());
+  for (size_t i = 0; i < entities.size(); ++i) index_by_id.emplace(entities.ids[i], i);
+  return index_by_id;
+}
+
+}  // namespace
+
+absl::StatusOr<std::unique_ptr<PlayEngine>> PlayEngine::Create(const Level& level,
+                                                               PlayEngineOptions options) {
+  ASSIGN_OR_RETURN(std::unique_ptr<RuntimeWorld> world, RuntimeWorld::Create(level, options.world));
+  for (size_t i = 0; i < world->entities().dynamic_count; ++i) {
+    world->SetAcceleration(i, options.gravity);
+  }
+  if (options.clock == nullptr) options.clock = [] { return absl::Now(); };
+
+  ASSIGN_OR_RETURN(std::unique_ptr<NotificationSet> notification_set, NotificationSet::Create());
+  ASSIGN_OR_RETURN(Notification * command_notification, notification_set->AddSoftware());
+  return std::unique_ptr<PlayEngine>(new PlayEngine(std::move(world), std::move(options),
+                                                    std::move(notification_set),
+                                                    *command_notification));
+}
+
+PlayEngine::PlayEngine(std::unique_ptr<RuntimeWorld> world, PlayEngineOptions options,
+                       std::unique_ptr<NotificationSet> notification_set,
+                       Notification& command_notification)
+    : world_(std::move(world)),
+      clock_(std::move(options.clock)),
+      index_by_id_(IndexEntities(world_->entities())),
+      notification_set_(std::move(notification_set)),
+      commands_(command_notification) {}
+
+absl::Status PlayEngine::Pause() { return Push(PausePlay{}); }
+
+absl::Status PlayEngine::Resume() { return Push(ResumePlay{}); }
+
+absl::Status PlayEngine::StepOnce() { return Push(StepPlay{}); }
+
+absl::Status PlayEngine::Push(PlayCommand command) {
+  if (!commands_.TryPush(std::move(command))) {
+    return absl::ResourceExhaustedError("the play command queue is full");
+  }
+  return absl::OkStatus();
+}
+
+std::optional<size_t> PlayEngine::IndexOf(uint64_t entity_id) const {
+  const auto it = index_by_id_.find(entity_id);
+  if (it == index_by_id_.end()) return std::nullopt;
+  return it->second;
+}
+
+absl::StatusOr<RunResult> PlayEngine::Run() {
+  // Read once, so every decision this pass makes agrees about what time it is.
+  const absl::Time now = clock_();
+  if (ApplyCommands(now)) publish_pending_ = true;
+
+  if (!paused_) {
+    if (!last_advance_.has_value()) last_advance_ = now;
+    // A clock that steps backwards owes no time rather than negative time.
+    const absl::Duration elapsed = std::max(now - *last_advance_, absl::ZeroDuration());
+    last_advance_ = now;
+    if (world_->Advance(elapsed) > 0) publish_pending_ = true;
+  }
+
+  if (publish_pending_) publish_pending_ = !Publish();
+
+  if (paused_) {
+    // Nothing is due while paused, except a snapshot the viewport declined.
+    // It is pinned only for a frame, so looking again a step later is plenty.
+    if (!publish_pending_) return RunResult{.feedback = RunFeedback::kIdle};
+    return RunResult{.feedback = RunFeedback::kIdle, .wake_deadline = now + world_->timestep()};
+  }
+  // The step is due once the banked remainder reaches a whole timestep. A
+  // pending publish rides along with it: there is nothing newer to show
+  // before then anyway.
+  const double remaining = 1.0 - world_->interpolation();
+  return RunResult{
+      .feedback = RunFeedback::kIdle,
+      .wake_deadline = now + world_->timestep() * remaining,
+  };
+}
+
+bool PlayEngine::ApplyCommands(absl::Time now) {
+  bool applied = false;
+  while (std::optional<PlayCommand> command = commands_.TryPop()) {
+    if (std::holds_alternative<PausePlay>(*command)) {
+      applied |= !paused_;
+      paused_ = true;
+    } else if (std::holds_alternative<ResumePlay>(*command)) {
+      if (!paused_) continue;
+      applied = true;
+      paused_ = false;
+      last_advance_ = now;
+    } else if (paused_) {
+      applied = true;
+      world_->Step();
+    }
+  }
+  return applied;
+}
+
+bool PlayEngine::Publish() {
+  return snapshots_.TryPublish([this](PlaySnapshot& snapshot) {
+    const RuntimeEntities& entities = world_->entities();
+    snapshot.step = world_->step_count();
+    snapshot.paused = paused_;
+    // Assigned in place: the slot keeps its capacity, so a steady run
+    // publishes without allocating.
+    snapshot.positions.resize(entities.size());
+    for (size_t i = 0; i < entities.size(); ++i) {
+      snapshot.positions[i] = Vec{.x = entities.position_x[i], .y = entities.position_y[i]};
+    }
+  });
+}
+
+}  // namespace zebes
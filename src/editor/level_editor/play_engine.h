@@ -0,0 +1,134 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <variant>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/functional/any_invocable.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/time/time.h"
+#include "common/engine.h"
+#include "common/mpsc_queue.h"
+#include "common/notification.h"
+#include "common/notification_set.h"
+#include "common/snapshot_exchange.h"
+#include "objects/level.h"
+#include "objects/vec.h"
+#include "runtime/runtime_world.h"
+
+namespace zebes {
+
+struct PlayEngineOptions {
+  RuntimeWorldOptions world;
+
+  // Set on every dynamic body when play starts, in world units per second
+  // squared. Zero leaves every body where it was authored until something
+  // pushes it.
+  Vec gravity;
+
+  // The time the simulation is paced by. Null means absl::Now; a test supplies
+  // a clock it moves by hand, so a run needs no thread and no sleeping.
+  absl::AnyInvocable<absl::Time()> clock;
+};
+
+// What the viewport draws from: the world as of one step, immutable once
+// published. Positions are indexed like RuntimeEntities; PlayEngine::IndexOf
+// maps a level entity ID to that index.
+struct PlaySnapshot {
+  int64_t step = 0;
+  bool paused = false;
+  std::vector<Vec> positions;
+};
+
+// Runs a level's RuntimeWorld at its fixed timestep for the editor's play mode.
+//
+// The simulation is paced by its clock, not by whoever is watching: a slow UI
+// frame costs it nothing, and a slow step only makes the world take its
+// banked steps late, never makes the UI wait. The two meet only at a
+// SnapshotExchange. Each pass that stepped publishes a PlaySnapshot, and the
+// UI pins the newest one for the frame it draws.
+//
+// Threading: Pause, Resume, StepOnce and IndexOf are safe from any thread.
+// AcquireSnapshot belongs to the one thread that draws. Run belongs to the
+// EngineRunner's thread, or to a test driving it by hand.
+//
+// The level is read once, at creation. Edits made while playing are not seen
+// until play is restarted.
+class PlayEngine final : public Engine {
+ public:
+  static absl::StatusOr<std::unique_ptr<PlayEngine>> Create(const Level& level,
+                                                            PlayEngineOptions options = {});
+
+  NotificationSet& notification_set() override { return *notification_set_; }
+
+  // Applies queued commands, takes every step the clock has paid for, and
+  // publishes the result. The first pass publishes the authored state, so the
+  // viewport has something to draw before the first step is due.
+  //
+  // While running it is idle until the next step is due. While paused it is
+  // idle with no deadline, and sleeps until a command arrives.
+  absl::StatusOr<RunResult> Run() override;
+
+  // Stops and resumes the clock. Time spent paused is not owed on resume.
+  // ResourceExhausted when the command queue is full, which only a caller
+  // issuing commands far faster than frames can reach.
+  absl::Status Pause();
+  absl::Status Resume();
+  // Takes exactly one step, for walking through a paused simulation. Ignored
+  // while running, where a step is already due every timestep.
+  absl::Status StepOnce();
+
+  // Index of a live entity in PlaySnapshot::positions. Fixed at creation, so
+  // it needs no synchronization.
+  std::optional<size_t> IndexOf(uint64_t entity_id) const;
+
+  // The newest published snapshot, pinned until the Read is released. Empty
+  // until the first Run. Hold it for one frame at most: while it is held the
+  // engine can publish once more and then keeps its newer steps to itself.
+  SnapshotExchange<PlaySnapshot>::Read AcquireSnapshot() { return snapshots_.Acquire(); }
+
+ private:
+  struct PausePlay {};
+  struct ResumePlay {};
+  struct StepPlay {};
+
+  using PlayCommand = std::variant<PausePlay, ResumePlay, StepPlay>;
+
+  static constexpr size_t kCommandCapacity = 16;
+
+  PlayEngine(std::unique_ptr<RuntimeWorld> world, PlayEngineOptions options,
+             std::unique_ptr<NotificationSet> notification_set,
+             Notification& command_notification);
+
+  absl::Status Push(PlayCommand command);
+  // True when anything changed that the viewport should see.
+  bool ApplyCommands(absl::Time now);
+  // False when the viewport still held the slot it would have written.
+  bool Publish();
+
+  std::unique_ptr<RuntimeWorld> world_;
+  absl::AnyInvocable<absl::Time()> clock_;
+  // Copied out of the world so other threads can resolve IDs without touching
+  // the world the engine thread is stepping.
+  const absl::flat_hash_map<uint64_t, size_t> index_by_id_;
+
+  // Destroyed after the queue that holds its notification.
+  std::unique_ptr<NotificationSet> notification_set_;
+  MpscNotifyQueue<PlayCommand, kCommandCapacity> commands_;
+  SnapshotExchange<PlaySnapshot> snapshots_;
+
+  // Engine-thread only.
+  bool paused_ = false;
+  // When the world last banked time. Unset until the first pass, and reset on
+  // resume so a pause is not simulated as one long frame.
+  std::optional<absl::Time> last_advance_;
+  // A declined publish owes the viewport the state it missed.
+  bool publish_pending_ = true;
+};
+
+}  // namespace zebes
@@ -0,0 +1,41 @@
+#include "editor/level_editor/play_session.h"
+
+#include <memory>
+#include <optional>
+#include <utility>
+
+#include "absl/log/log.h"
+#include "absl/memory/memory.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "common/blocking_callback_thread.h"
+#include "common/engine_runner.h"
+#include "common/status_macros.h"
+#include "editor/level_editor/play_engine.h"
+
+namespace zebes {
+
+absl::StatusOr<std::unique_ptr<PlaySession>> PlaySession::Create(const Level& level,
+                                                                 PlayEngineOptions options) {
+  ASSIGN_OR_RETURN(std::unique_ptr<PlayEngine> engine,
+                   PlayEngine::Create(level, std::move(options)));
+  ASSIGN_OR_RETURN(std::unique_ptr<EngineRunner> runner, EngineRunner::Create(*engine));
+  ASSIGN_OR_RETURN(
+      BlockingCallbackThread thread,
+      BlockingCallbackThread::Start([runner = runner.get()] { return runner->Run(); }));
+  return absl::WrapUnique(
+      new PlaySession(std::move(engine), std::move(runner), std::move(thread)));
+}
+
+PlaySession::PlaySession(std::unique_ptr<PlayEngine> engine, std::unique_ptr<EngineRunner> runner,
+                         BlockingCallbackThread thread)
+    : engine_(std::move(engine)), runner_(std::move(runner)), thread_(std::move(thread)) {}
+
+PlaySession::~PlaySession() {
+  runner_->Stop();
+  const absl::Status stopped = thread_->Wait();
+  if (stopped.ok()) return;
+  LOG(ERROR) << "Play engine stopped with an error: " << stopped;
+}
+
+}  // namespace zebes
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <memory>
+#include <optional>
+
+#include "absl/status/statusor.h"
+#include "common/blocking_callback_thread.h"
+#include "common/engine_runner.h"
+#include "editor/level_editor/play_engine.h"
+#include "objects/level.h"
+
+namespace zebes {
+
+// One play-mode run of a level: the engine stepping its world, and the thread
+// its runner polls it on.
+//
+// Starting play creates one of these and stopping play destroys it.
+// Construction starts the engine thread and destruction stops and joins it, so
+// a caller only ever holds `engine()`, to steer it and read its snapshots.
+//
+// Member order matters: the runner borrows the engine and the thread borrows
+// the runner, so each must outlive the thing that borrows it.
+class PlaySession {
+ public:
+  static absl::StatusOr<std::unique_ptr<PlaySession>> Create(const Level& level,
+                                                             PlayEngineOptions options = {});
+
+  // Stops the runner and joins its thread. A non-OK run status is logged
+  // rather than reported, because a destructor has nowhere to report it.
+  ~PlaySession();
+
+  PlaySession(const PlaySession&) = delete;
+  PlaySession& operator=(const PlaySession&) = delete;
+
+  PlayEngine& engine() { return *engine_; }
+
+ private:
+  PlaySession(std::unique_ptr<PlayEngine> engine, std::unique_ptr<EngineRunner> runner,
+              BlockingCallbackThread thread);
+
+  std::unique_ptr<PlayEngine> engine_;
+  std::unique_ptr<EngineRunner> runner_;
+  // Declared last so it is joined before anything its callback touches is
+  // destroyed. The destructor stops the runner first; without that the join
+  // would never return.
+  std::optional<BlockingCallbackThread> thread_;
+};
+
+}  // namespace zebes
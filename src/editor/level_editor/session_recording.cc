@@ -0,0 +1,274 @@
+#include "editor/level_editor/session_recording.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "common/status_macros.h"
+#include "nlohmann/json.hpp"
+#include "objects/level_state_hash.h"
+#include "resources/json_file.h"
+
+namespace zebes {
+namespace {
+
+bool SameInput(const InputSnapshot& a, const InputSnapshot& b) {
+  return a.keys == b.keys && a.quit_requested == b.quit_requested;
+}
+
+// A frame that holds a button or issues a click. Anything else is the pointer
+// hovering, which changes nothing unless it ends a gesture.
+bool IsGesture(const ViewportInteractionInput& input) {
+  return input.primary_pressed || input.primary_down || input.secondary_pressed ||
+         input.secondary_down;
+}
+
+// Optional fields are always written, as null when empty, so a reader can tell
+// an empty one from one a writer forgot.
+template <typename T>
+nlohmann::json NullableToJson(const std::optional<T>& value) {
+  return value.has_value() ? nlohmann::json(*value) : nlohmann::json(nullptr);
+}
+
+template <typename T>
+std::optional<T> NullableFromJson(const nlohmann::json& j) {
+  if (j.is_null()) return std::nullopt;
+  return j.get<T>();
+}
+
+nlohmann::json InputToJson(const InputSnapshot& input) {
+  return nlohmann::json{{"keys", input.keys}, {"quit_requested", input.quit_requested}};
+}
+
+absl::StatusOr<InputSnapshot> ParseInput(const nlohmann::json& j) {
+  const nlohmann::json& keys = j.at("keys");
+  InputSnapshot input;
+  if (!keys.is_array() || keys.size() != input.keys.size()) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("recorded input has ", keys.size(), " keys, expected ", input.keys.size()));
+  }
+  for (size_t i = 0; i < input.keys.size(); ++i) keys[i].get_to(input.keys[i]);
+  j.at("quit_requested").get_to(input.quit_requested);
+  return input;
+}
+
+nlohmann::json ViewportToJson(const RecordedViewportCommand& command) {
+  const ViewportInteractionInput& input = command.input;
+  return nlohmann::json{
+      {"type", "viewport"},
+      {"layer_id", command.layer_id},
+      {"x", input.world_position.x},
+      {"y", input.world_position.y},
+      {"pointer_in_level", input.pointer_in_level},
+      {"primary_pressed", input.primary_pressed},
+      {"primary_down", input.primary_down},
+      {"secondary_pressed", input.secondary_pressed},
+      {"secondary_down", input.secondary_down},
+      {"paint_shape", kTileShapeIdentifiers[static_cast<size_t>(command.paint_shape)]},
+      {"placement_blueprint_id", command.placement_blueprint_id},
+      {"selected_entity_id", command.selected_entity_id},
+      {"delete_mode", command.delete_mode},
+      {"paint_terrain_id", NullableToJson(command.paint_terrain_id)},
+      {"paint_tile_id", NullableToJson(command.paint_tile_id)},
+  };
+}
+
+absl::StatusOr<RecordedViewportCommand> ParseViewport(const nlohmann::json& j) {
+  RecordedViewportCommand command;
+  ViewportInteractionInput& input = command.input;
+  j.at("layer_id").get_to(command.layer_id);
+  j.at("x").get_to(input.world_position.x);
+  j.at("y").get_to(input.world_position.y);
+  j.at("pointer_in_level").get_to(input.pointer_in_level);
+  j.at("primary_pressed").get_to(input.primary_pressed);
+  j.at("primary_down").get_to(input.primary_down);
+  j.at("secondary_pressed").get_to(input.secondary_pressed);
+  j.at("secondary_down").get_to(input.secondary_down);
+
+  const std::string shape = j.at("paint_shape").get<std::string>();
+  const std::optional<TileShape> paint_shape = TileShapeFromIdentifier(shape);
+  if (!paint_shape.has_value()) {
+    return absl::InvalidArgumentError(absl::StrCat("unknown paint shape: ", shape));
+  }
+  command.paint_shape = *paint_shape;
+
+  j.at("placement_blueprint_id").get_to(command.placement_blueprint_id);
+  j.at("selected_entity_id").get_to(command.selected_entity_id);
+  j.at("delete_mode").get_to(command.delete_mode);
+  command.paint_terrain_id = NullableFromJson<int>(j.at("paint_terrain_id"));
+  command.paint_tile_id = NullableFromJson<int>(j.at("paint_tile_id"));
+  return command;
+}
+
+nlohmann::json CommandToJson(const RecordedCommand& command) {
+  if (const auto* viewport = std::get_if<RecordedViewportCommand>(&command)) {
+    return ViewportToJson(*viewport);
+  }
+  if (std::holds_alternative<RecordedUndo>(command)) return nlohmann::json{{"type", "undo"}};
+  return nlohmann::json{{"type", "redo"}};
+}
+
+absl::StatusOr<RecordedCommand> ParseCommand(const nlohmann::json& j) {
+  const std::string type = j.at("type").get<std::string>();
+  if (type == "viewport") {
+    ASSIGN_OR_RETURN(RecordedViewportCommand viewport, ParseViewport(j));
+    return RecordedCommand(std::move(viewport));
+  }
+  if (type == "undo") return RecordedCommand(RecordedUndo{});
+  if (type == "redo") return RecordedCommand(RecordedRedo{});
+  return absl::InvalidArgumentError(absl::StrCat("unknown recorded command: ", type));
+}
+
+nlohmann::json RecordingToJson(const SessionRecording& recording) {
+  nlohmann::json frames = nlohmann::json::array();
+  for (const RecordedFrame& frame : recording.frames) {
+    nlohmann::json commands = nlohmann::json::array();
+    for (const RecordedCommand& command : frame.commands) {
+      commands.push_back(CommandToJson(command));
+    }
+    frames.push_back({
+        {"frame", frame.frame},
+        {"input", frame.input.has_value() ? InputToJson(*frame.input) : nlohmann::json(nullptr)},
+        {"commands", std::move(commands)},
+    });
+  }
+  return nlohmann::json{
+      {"version", SessionRecording::kVersion},
+      {"level_id", recording.level_id},
+      {"frame_count", recording.frame_count},
+      {"unrecorded_edit_frame", NullableToJson(recording.unrecorded_edit_frame)},
+      {"initial_hash", NullableToJson(recording.initial_hash)},
+      {"frames", std::move(frames)},
+  };
+}
+
+absl::StatusOr<SessionRecording> ParseRecording(const nlohmann::json& j) {
+  const int version = j.at("version").get<int>();
+  if (version != SessionRecording::kVersion) {
+    return absl::InvalidArgumentError(absl::StrCat("session recording version ", version,
+                                                   " is not ", SessionRecording::kVersion));
+  }
+
+  SessionRecording recording;
+  j.at("level_id").get_to(recording.level_id);
+  j.at("frame_count").get_to(recording.frame_count);
+  recording.unrecorded_edit_frame = NullableFromJson<int64_t>(j.at("unrecorded_edit_frame"));
+  recording.initial_hash = NullableFromJson<uint64_t>(j.at("initial_hash"));
+  int64_t previous = -1;
+  for (const nlohmann::json& item : j.at("frames")) {
+    RecordedFrame frame;
+    item.at("frame").get_to(frame.frame);
+    // Replay walks frames in order, and the last one must have been run.
+    if (frame.frame <= previous || frame.frame >= recording.frame_count) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("recorded frame ", frame.frame, " is out of order"));
+    }
+    previous = frame.frame;
+    if (const nlohmann::json& input = item.at("input"); !input.is_null()) {
+      ASSIGN_OR_RETURN(frame.input, ParseInput(input));
+    }
+    for (const nlohmann::json& command : item.at("commands")) {
+      ASSIGN_OR_RETURN(RecordedCommand parsed, ParseCommand(command));
+      frame.commands.push_back(std::move(parsed));
+    }
+    recording.frames.push_back(std::move(frame));
+  }
+  return recording;
+}
+
+}  // namespace
+
+uint64_t LevelStateHash(const Level& level) {
+  StateHasher hasher;
+  hasher.Add(level.layers.size());
+  for (const WorldLayer& layer : level.layers) HashWorldLayer(layer, hasher);
+  return hasher.hash();
+}
+
+void SessionRecorder::BeginFrame(const InputSnapshot& input) {
+  const int64_t frame = recording_.frame_count++;
+  if (last_input_.has_value() && SameInput(*last_input_, input)) return;
+  last_input_ = input;
+  recording_.frames.push_back({.frame = frame, .input = input});
+}
+
+void SessionRecorder::RecordViewport(const Level& level, const RecordedViewportCommand& command) {
+  const bool gesture = IsGesture(command.input);
+  if (!gesture && !viewport_gesture_) return;
+  if (!Accept(level)) return;
+  viewport_gesture_ = gesture;
+  CurrentFrame().commands.push_back(command);
+}
+
+void SessionRecorder::RecordUndo(const Level& level) {
+  if (Accept(level)) CurrentFrame().commands.emplace_back(std::in_place_type<RecordedUndo>);
+}
+
+void SessionRecorder::RecordRedo(const Level& level) {
+  if (Accept(level)) CurrentFrame().commands.emplace_back(std::in_place_type<RecordedRedo>);
+}
+
+void SessionRecorder::Begin(const Level& level) {
+  if (!recording_.level_id.empty()) return;
+  recording_.level_id = level.id;
+  recording_.initial_hash = LevelStateHash(level);
+}
+
+void SessionRecorder::RecordUnrecordedEdit(const Level& level) {
+  if (recording_.level_id != level.id || recording_.unrecorded_edit_frame.has_value()) return;
+  recording_.unrecorded_edit_frame = std::max<int64_t>(recording_.frame_count - 1, 0);
+}
+
+bool SessionRecorder::Accept(const Level& level) {
+  Begin(level);
+  if (level.id == recording_.level_id) return true;
+  ++dropped_commands_;
+  return false;
+}
+
+RecordedFrame& SessionRecorder::CurrentFrame() {
+  // A command issued before any input was polled belongs to frame zero.
+  if (recording_.frame_count == 0) recording_.frame_count = 1;
+  const int64_t frame = recording_.frame_count - 1;
+  if (recording_.frames.empty() || recording_.frames.back().frame != frame) {
+    recording_.frames.push_back({.frame = frame});
+  }
+  return recording_.frames.back();
+}
+
+InputSnapshot RecordingInputSource::Poll() {
+  InputSnapshot input = source_.Poll();
+  recorder_.BeginFrame(input);
+  return input;
+}
+
+InputSnapshot ReplayInputSource::Poll() {
+  const int64_t frame = next_frame_++;
+  if (next_index_ < recording_.frames.size() && recording_.frames[next_index_].frame == frame) {
+    const RecordedFrame& recorded = recording_.frames[next_index_++];
+    if (recorded.input.has_value()) current_ = *recorded.input;
+  }
+  return current_;
+}
+
+absl::Status WriteSessionRecording(const SessionRecording& recording, const std::string& path) {
+  return WriteJsonFile(path, RecordingToJson(recording));
+}
+
+absl::StatusOr<SessionRecording> ReadSessionRecording(const std::string& path) {
+  SessionRecording recording;
+  RETURN_IF_ERROR(ReadJsonFile(path, [&recording](const nlohmann::json& json) -> absl::Status {
+    ASSIGN_OR_RETURN(recording, ParseRecording(json));
+    return absl::OkStatus();
+  }));
+  return recording;
+}
+
+}  // namespace zebes
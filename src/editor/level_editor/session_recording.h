@@ -0,0 +1,153 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <variant>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "editor/level_editor/viewport_interaction.h"
+#include "engine/input_types.h"
+#include "objects/level.h"
+#include "objects/tileset.h"
+
+namespace zebes {
+
+// One frame of viewport authoring: the pointer state ViewportInteraction saw,
+// and the mode it saw it in. Assets are named by ID, so a replay resolves them
+// from its own managers rather than from pointers into this session.
+struct RecordedViewportCommand {
+  int layer_id = -1;
+  ViewportInteractionInput input;
+  std::optional<int> paint_terrain_id;
+  TileShape paint_shape = TileShape::kFullBlock;
+  std::optional<int> paint_tile_id;
+  // Empty when no blueprint was being placed.
+  std::string placement_blueprint_id;
+  uint64_t selected_entity_id = Entity::kInvalidId;
+  bool delete_mode = false;
+};
+
+struct RecordedUndo {};
+struct RecordedRedo {};
+
+// An editor command that changed, or could have changed, the level.
+using RecordedCommand = std::variant<RecordedViewportCommand, RecordedUndo, RecordedRedo>;
+
+// What happened on one frame. Frames where nothing happened are not stored:
+// their input is the last one recorded and they issued no commands.
+struct RecordedFrame {
+  int64_t frame = 0;
+  // Present when the polled input differs from the previous frame's.
+  std::optional<InputSnapshot> input;
+  std::vector<RecordedCommand> commands;
+};
+
+// One session's input and editor commands against one level, stamped by frame.
+struct SessionRecording {
+  static constexpr int kVersion = 2;
+
+  // The level every command was issued against. Empty until the first command.
+  std::string level_id;
+  // LevelStateHash of that level just before its first command. A replay
+  // refuses a level that no longer matches, such as one saved since.
+  std::optional<uint64_t> initial_hash;
+  // Frames the session ran, stored or not.
+  int64_t frame_count = 0;
+  // The first frame that edited the level other than through a recorded
+  // command. A replay diverges from there, so it stops before that frame.
+  std::optional<int64_t> unrecorded_edit_frame;
+  // In frame order.
+  std::vector<RecordedFrame> frames;
+};
+
+// Records a session as it runs, for SessionReplayer to re-execute headless.
+//
+// The input source opens each frame, and the editor reports each command as it
+// issues it. What is recorded is what the editor acted on -- the pointer state
+// after snapping, the mode after the palette was resolved -- so a replay makes
+// the same decisions without a window, a camera or an Api.
+//
+// A recording covers the level its first command was issued against. Commands
+// on any other level are dropped, since a replay starts from one level. Edits
+// that bypass these commands, such as the inspector's, cannot be replayed; the
+// editor reports them, and the recording keeps the frame of the first.
+class SessionRecorder {
+ public:
+  // Starts the next frame with the input polled for it.
+  void BeginFrame(const InputSnapshot& input);
+
+  // Starts the recording on `level` if no command has yet, hashing the level
+  // as it stands. Each Record call does this itself, but RecordUndo and
+  // RecordRedo come after the journal has moved, so the editor calls this
+  // before moving it.
+  void Begin(const Level& level);
+
+  void RecordViewport(const Level& level, const RecordedViewportCommand& command);
+  void RecordUndo(const Level& level);
+  void RecordRedo(const Level& level);
+  // `level` was edited this frame other than through the commands above. An
+  // edit before the recording began is part of the state it starts from.
+  void RecordUnrecordedEdit(const Level& level);
+
+  const SessionRecording& recording() const { return recording_; }
+  // Commands issued against a level other than the recording's.
+  int64_t dropped_commands() const { return dropped_commands_; }
+
+ private:
+  // False, counting the drop, when `level` is not the recording's.
+  bool Accept(const Level& level);
+  RecordedFrame& CurrentFrame();
+
+  SessionRecording recording_;
+  std::optional<InputSnapshot> last_input_;
+  // Whether the last recorded viewport command held a button. Idle pointer
+  // frames change nothing, so only the first one after a gesture is kept,
+  // which is the one that ends it.
+  bool viewport_gesture_ = false;
+  int64_t dropped_commands_ = 0;
+};
+
+// Wraps an input source and opens a recorder frame with everything it polls.
+// Both must outlive it.
+class RecordingInputSource : public InputSource {
+ public:
+  RecordingInputSource(InputSource& source, SessionRecorder& recorder)
+      : source_(source), recorder_(recorder) {}
+
+  InputSnapshot Poll() override;
+
+ private:
+  InputSource& source_;
+  SessionRecorder& recorder_;
+};
+
+// Plays a recording's input back, one frame per Poll. Past the last recorded
+// frame it keeps returning the last input. The recording must outlive it.
+class ReplayInputSource : public InputSource {
+ public:
+  explicit ReplayInputSource(const SessionRecording& recording) : recording_(recording) {}
+
+  InputSnapshot Poll() override;
+
+ private:
+  const SessionRecording& recording_;
+  int64_t next_frame_ = 0;
+  size_t next_index_ = 0;
+  InputSnapshot current_;
+};
+
+// A digest of everything an edit can change: layers, their tiles and their
+// entities. Levels holding the same tiles hash equal, whatever order their
+// chunks were created in. Unseeded, so checkpoints from two runs, or from two
+// builds, can be compared.
+uint64_t LevelStateHash(const Level& level);
+
+// The recording as JSON. Written by the editor at shutdown, read by the replay
+// tools. A recording from another format version is refused.
+absl::Status WriteSessionRecording(const SessionRecording& recording, const std::string& path);
+absl::StatusOr<SessionRecording> ReadSessionRecording(const std::string& path);
+
+}  // namespace zebes
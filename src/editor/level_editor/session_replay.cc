@@ -0,0 +1,206 @@
+#include "editor/level_editor/session_replay.h"
+
+#include <algorithm>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/time/clock.h"
+#include "common/status_macros.h"
+
+namespace zebes {
+
+absl::StatusOr<std::unique_ptr<SessionReplayer>> SessionReplayer::Create(
+    Level level, SessionRecording recording, SessionReplayAssets& assets,
+    SessionReplayOptions options) {
+  if (!recording.level_id.empty() && recording.level_id != level.id) {
+    return absl::InvalidArgumentError(absl::StrCat("recording is of level ", recording.level_id,
+                                                   ", not ", level.id));
+  }
+  if (recording.initial_hash.has_value() && *recording.initial_hash != LevelStateHash(level)) {
+    return absl::FailedPreconditionError(
+        absl::StrCat("level ", level.id, " is not as it was when recording began; it has been ",
+                     "edited or saved since"));
+  }
+  if (options.hash_interval < 0) {
+    return absl::InvalidArgumentError("hash interval must not be negative");
+  }
+
+  std::vector<int> painted_terrains;
+  for (const RecordedFrame& frame : recording.frames) {
+    for (const RecordedCommand& command : frame.commands) {
+      const auto* viewport = std::get_if<RecordedViewportCommand>(&command);
+      if (viewport != nullptr && viewport->paint_terrain_id.has_value()) {
+        painted_terrains.push_back(*viewport->paint_terrain_id);
+      }
+    }
+  }
+
+  std::optional<TerrainIndex> terrain_index;
+  if (!painted_terrains.empty()) {
+    if (level.tileset_id.empty()) {
+      return absl::FailedPreconditionError("recording paints terrain on a level with no tileset");
+    }
+    ASSIGN_OR_RETURN(const Tileset* tileset, assets.GetTileset(level.tileset_id));
+    ASSIGN_OR_RETURN(terrain_index, TerrainIndex::Build(*tileset));
+    for (int terrain_id : painted_terrains) {
+      const Terrain* terrain = terrain_index->FindById(terrain_id);
+      if (terrain == nullptr) {
+        return absl::FailedPreconditionError(
+            absl::StrCat("recording paints terrain ", terrain_id, ", which tileset ",
+                         tileset->id, " does not have"));
+      }
+      if (terrain->scheme == TerrainScheme::kDerived) {
+        return absl::FailedPreconditionError(
+            absl::StrCat("recording paints derived terrain ", terrain_id,
+                         ", whose artwork only the recorded session had"));
+      }
+    }
+  }
+
+  std::unique_ptr<SessionReplayer> replayer(
+      new SessionReplayer(std::move(level), std::move(recording), assets, options,
+                          std::move(terrain_index)));
+  ASSIGN_OR_RETURN(replayer->input_,
+                   InputManager::Create({.input_source = &replayer->input_source_}));
+  return replayer;
+}
+
+SessionReplayer::SessionReplayer(Level level, SessionRecording recording,
+                                 SessionReplayAssets& assets, SessionReplayOptions options,
+                                 std::optional<TerrainIndex> terrain_index)
+    : level_(std::move(level)),
+      recording_(std::move(recording)),
+      assets_(assets),
+      options_(options),
+      terrain_index_(std::move(terrain_index)),
+      input_source_(recording_),
+      end_frame_(std::min(recording_.frame_count,
+                          recording_.unrecorded_edit_frame.value_or(recording_.frame_count))) {
+  if (terrain_index_.has_value()) terrain_provider_.emplace(*terrain_index_);
+}
+
+absl::StatusOr<bool> SessionReplayer::Step() {
+  if (next_frame_ >= end_frame_) return false;
+  const int64_t frame = next_frame_++;
+
+  const RecordedFrame* recorded = nullptr;
+  if (next_index_ < recording_.frames.size() && recording_.frames[next_index_].frame == frame) {
+    recorded = &recording_.frames[next_index_++];
+  }
+
+  const absl::Time start = absl::Now();
+  input_->Update();
+  if (recorded != nullptr) {
+    for (const RecordedCommand& command : recorded->commands) {
+      absl::Status status = Apply(command);
+      if (!status.ok()) {
+        return absl::Status(status.code(),
+                            absl::StrCat("frame ", frame, ": ", status.message()));
+      }
+    }
+  }
+  report_.frames.push_back({
+      .frame = frame,
+      .elapsed = absl::Now() - start,
+      .commands = recorded != nullptr ? recorded->commands.size() : 0,
+  });
+
+  const bool last = next_frame_ == end_frame_;
+  const bool due = options_.hash_interval > 0 && (frame + 1) % options_.hash_interval == 0;
+  if (due || last) report_.checkpoints.push_back({.frame = frame, .hash = LevelStateHash(level_)});
+  return true;
+}
+
+absl::StatusOr<SessionReplayReport> SessionReplayer::Run() {
+  while (true) {
+    ASSIGN_OR_RETURN(const bool stepped, Step());
+    if (!stepped) break;
+  }
+  return report_;
+}
+
+absl::Status SessionReplayer::Apply(const RecordedCommand& command) {
+  if (const auto* viewport = std::get_if<RecordedViewportCommand>(&command)) {
+    return ApplyViewport(*viewport);
+  }
+  // The editor offers undo and redo only when there is something to apply, so
+  // a recorded one always had an entry.
+  if (std::holds_alternative<RecordedUndo>(command)) return journal_.Undo(level_);
+  return journal_.Redo(level_);
+}
+
+absl::Status SessionReplayer::ApplyViewport(const RecordedViewportCommand& command) {
+  WorldLayer* layer = FindWorldLayer(level_, command.layer_id);
+  if (layer == nullptr) {
+    return absl::FailedPreconditionError(
+        absl::StrCat("recorded layer ", command.layer_id, " does not exist"));
+  }
+
+  const Blueprint* blueprint = nullptr;
+  std::string placement_sprite_id;
+  if (!command.placement_blueprint_id.empty()) {
+    ASSIGN_OR_RETURN(blueprint, assets_.GetBlueprint(command.placement_blueprint_id));
+    placement_sprite_id = blueprint->sprite_id(0).value_or("");
+  }
+  RETURN_IF_ERROR(ResolveSprites(*layer, placement_sprite_id));
+
+  ASSIGN_OR_RETURN(
+      ViewportInteractionResult result,
+      interaction_.Update(level_, *layer, command.input,
+                          {
+                              .paint_terrain_id = command.paint_terrain_id,
+                              .paint_shape = command.paint_shape,
+                              .terrain_index = terrain_index_.has_value() ? &*terrain_index_
+                                                                          : nullptr,
+                              .terrain_provider =
+                                  terrain_provider_.has_value() ? &*terrain_provider_ : nullptr,
+                              .paint_tile_id = command.paint_tile_id,
+                              .placement_blueprint = blueprint,
+                              .placement_sprite = FindSprite(sprites_, placement_sprite_id).sprite,
+                              .selected_entity_id = command.selected_entity_id,
+                              .entity_sprites = &sprites_,
+                              .delete_mode = command.delete_mode,
+                              .journal = &journal_,
+                          }));
+
+  // Applied as LevelEditor applies them; selection is the editor's own state
+  // and the next command carries whatever it became.
+  if (result.delete_entity_id.has_value()) {
+    if (const auto deleted = layer->entities.find(*result.delete_entity_id);
+        deleted != layer->entities.end()) {
+      journal_.RecordEntity({layer->id, deleted->first, deleted->second, std::nullopt});
+      layer->entities.erase(deleted);
+    }
+  }
+  if (result.placed_entity.has_value()) {
+    const Entity added = *result.placed_entity;
+    RETURN_IF_ERROR(level_.AddEntity(layer->id, std::move(*result.placed_entity)));
+    journal_.RecordEntity({layer->id, added.id, std::nullopt, added});
+  }
+  return absl::OkStatus();
+}
+
+absl::Status SessionReplayer::ResolveSprites(const WorldLayer& layer,
+                                             const std::string& sprite_id) {
+  auto resolve = [this](const std::string& id) -> absl::Status {
+    if (id.empty() || sprites_.contains(id)) return absl::OkStatus();
+    // An unresolvable sprite is remembered as one, and picks with placeholder
+    // bounds as it does in the editor.
+    absl::StatusOr<const Sprite*> sprite = assets_.GetSprite(id);
+    if (!sprite.ok() && !absl::IsNotFound(sprite.status())) return sprite.status();
+    sprites_[id] = ResolvedSprite{.sprite = sprite.ok() ? *sprite : nullptr};
+    return absl::OkStatus();
+  };
+  RETURN_IF_ERROR(resolve(sprite_id));
+  for (const auto& [id, entity] : layer.entities) RETURN_IF_ERROR(resolve(entity.sprite_id));
+  return absl::OkStatus();
+}
+
+}  // namespace zebes
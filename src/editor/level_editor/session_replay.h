@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "absl/time/time.h"
+#include "editor/level_editor/level_journal.h"
+#include "editor/level_editor/session_recording.h"
+#include "editor/level_editor/terrain_brush.h"
+#include "editor/level_editor/viewport_interaction.h"
+#include "editor/level_editor/viewport_model.h"
+#include "engine/input_manager.h"
+#include "objects/blueprint.h"
+#include "objects/level.h"
+#include "objects/sprite.h"
+#include "objects/tileset.h"
+
+namespace zebes {
+
+// The assets a replay resolves recorded IDs against. The managers the editor
+// loads answer every one; a test answers from a few in memory.
+class SessionReplayAssets {
+ public:
+  virtual ~SessionReplayAssets() = default;
+
+  virtual absl::StatusOr<const Tileset*> GetTileset(const std::string& id) = 0;
+  virtual absl::StatusOr<const Blueprint*> GetBlueprint(const std::string& id) = 0;
+  virtual absl::StatusOr<const Sprite*> GetSprite(const std::string& id) = 0;
+};
+
+struct SessionReplayOptions {
+  // A checkpoint hashes the level every this many frames, and once after the
+  // last. Zero hashes only after the last.
+  int64_t hash_interval = 60;
+};
+
+// One replayed frame.
+struct ReplayFrameTiming {
+  int64_t frame = 0;
+  // Wall time spent re-executing the frame's input and commands.
+  absl::Duration elapsed;
+  size_t commands = 0;
+};
+
+// LevelStateHash after a frame.
+struct ReplayCheckpoint {
+  int64_t frame = 0;
+  uint64_t hash = 0;
+};
+
+struct SessionReplayReport {
+  // Every frame of the recording, in order.
+  std::vector<ReplayFrameTiming> frames;
+  std::vector<ReplayCheckpoint> checkpoints;
+};
+
+// Re-executes a SessionRecording against a fresh copy of its level, without a
+// window, a GPU or an Api, and times each frame.
+//
+// Each frame polls the recorded input through an InputManager and feeds the
+// recorded commands through the same ViewportInteractionController and
+// LevelJournal the editor used, applying their results the way LevelEditor
+// does. Two replays of one recording therefore produce the same checkpoints,
+// and a change that makes them differ has changed what an edit does.
+//
+// Painting a derived terrain needs the session that generated its artwork, so
+// a recording that does is refused rather than replayed wrong. A recording of
+// a session that edited the level some other way, such as in the inspector,
+// replays only the frames before that edit.
+class SessionReplayer {
+ public:
+  // `assets` must outlive the replayer. `level` must be the one the recording
+  // names, as it was when recording began: FailedPrecondition when its state
+  // no longer hashes the same, which is what saving the session's work does.
+  static absl::StatusOr<std::unique_ptr<SessionReplayer>> Create(
+      Level level, SessionRecording recording, SessionReplayAssets& assets,
+      SessionReplayOptions options = {});
+
+  // Replays the next frame. False once every frame that can be replayed has
+  // run.
+  absl::StatusOr<bool> Step();
+  // Replays every remaining frame.
+  absl::StatusOr<SessionReplayReport> Run();
+
+  const Level& level() const { return level_; }
+  const SessionReplayReport& report() const { return report_; }
+  InputManager& input() { return *input_; }
+
+ private:
+  SessionReplayer(Level level, SessionRecording recording, SessionReplayAssets& assets,
+                  SessionReplayOptions options, std::optional<TerrainIndex> terrain_index);
+
+  absl::Status Apply(const RecordedCommand& command);
+  absl::Status ApplyViewport(const RecordedViewportCommand& command);
+  // Resolves every entity sprite the viewport would, plus `sprite_id`.
+  absl::Status ResolveSprites(const WorldLayer& layer, const std::string& sprite_id);
+
+  Level level_;
+  const SessionRecording recording_;
+  SessionReplayAssets& assets_;
+  const SessionReplayOptions options_;
+
+  // Built once: nothing in a replay changes the tileset.
+  std::optional<TerrainIndex> terrain_index_;
+  std::optional<Blob47TileProvider> terrain_provider_;
+
+  ReplayInputSource input_source_;
+  std::unique_ptr<InputManager> input_;
+  ViewportInteractionController interaction_;
+  LevelJournal journal_;
+  // Only grows, since sprites are looked up by ID and never change.
+  SpriteLookup sprites_;
+
+  // One past the last frame to replay.
+  const int64_t end_frame_;
+  int64_t next_frame_ = 0;
+  size_t next_index_ = 0;
+  SessionReplayReport report_;
+};
+
+}  // namespace zebes
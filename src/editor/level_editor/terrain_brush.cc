@@ -1,5 +1,12 @@
 #include "editor/level_editor/terrain_brush.h"
 
+#include <algorithm>
+#include <cstdlib>
+#include <map>
+#include <utility>
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/functional/function_ref.h"
 #include "absl/strings/str_cat.h"
 #include "common/status_macros.h"
 #include "editor/level_editor/viewport_model.h"
@@ -47,6 +54,43 @@ absl::Status ValidateCell(const Level& level, int tile_x, int tile_y) {
   return absl::OkStatus();
 }
 
+// What a neighbour contributes to a key: its shape when it holds the terrain
+// being resolved, and air otherwise.
+using NeighborShapeReader = absl::FunctionRef<absl::StatusOr<TileShape>(int x, int y)>;
+
+// The key for a cell, with neighbours read through `neighbor_shape` so a region
+// can describe cells it has decided but not yet written.
+absl::StatusOr<TerrainCellKey> ComputeKey(const Level& level, const Terrain& terrain,
+                                          TileShape shape, int tile_x, int tile_y,
+                                          NeighborShapeReader neighbor_shape) {
+  RETURN_IF_ERROR(ValidateCell(level, tile_x, tile_y));
+
+  TerrainCellKey key;
+  key.shape = shape;
+  for (int i = 0; i < kNeighborCount; ++i) {
+    const int x = tile_x + kNeighborOffsets[i].dx;
+    const int y = tile_y + kNeighborOffsets[i].dy;
+
+    if (IsOutsideLevel(level, x, y)) {
+      // Outside the level reads as solid ground of this terrain, which is what
+      // stops a coastline being drawn along the world border.
+      key.neighbors[i] = terrain.solid_outside_level ? TileShape::kFullBlock : TileShape::kNone;
+      continue;
+    }
+    ASSIGN_OR_RETURN(key.neighbors[i], neighbor_shape(x, y));
+  }
+
+  // A periodic terrain's artwork is one pattern laid down in phases, so which
+  // phase a cell shows is fixed by where the cell sits rather than chosen.
+  const int period = terrain.variant_period;
+  if (period > 0) {
+    const int phase_x = ((tile_x % period) + period) % period;
+    const int phase_y = ((tile_y % period) + period) % period;
+    key.phase = phase_y * period + phase_x;
+  }
+  return key;
+}
+
 // Re-resolves the eight cells around a coordinate that the brush owns. The
 // centre is deliberately excluded so callers control it explicitly.
 //
@@ -74,6 +118,124 @@ absl::Status RefreshNeighbors(const Level& level, WorldLayer& layer, TerrainInde
   return absl::OkStatus();
 }
 
+// Packs a non-negative cell coordinate into one hashable value.
+uint64_t PackCell(int tile_x, int tile_y) {
+  return (static_cast<uint64_t>(static_cast<uint32_t>(tile_y)) << 32) |
+         static_cast<uint32_t>(tile_x);
+}
+
+// A cell a region resolves, and the geometry it holds once the region lands.
+struct RegionCell {
+  TileCoordinate coordinate;
+  TileShape shape = TileShape::kNone;
+};
+
+bool RowMajorLess(const TileCoordinate& a, const TileCoordinate& b) {
+  if (a.y != b.y) return a.y < b.y;
+  return a.x < b.x;
+}
+
+// Row-major with duplicates removed, so neither the result nor the order a
+// derived provider appends tiles in depends on how a gesture listed its cells.
+std::vector<TileCoordinate> SortedUniqueCells(absl::Span<const TileCoordinate> cells) {
+  std::vector<TileCoordinate> sorted(cells.begin(), cells.end());
+  std::sort(sorted.begin(), sorted.end(), RowMajorLess);
+  sorted.erase(std::unique(sorted.begin(), sorted.end(),
+                           [](const TileCoordinate& a, const TileCoordinate& b) {
+                             return a.x == b.x && a.y == b.y;
+                           }),
+               sorted.end());
+  return sorted;
+}
+
+void SortRowMajor(std::vector<RegionCell>& cells) {
+  std::sort(cells.begin(), cells.end(), [](const RegionCell& a, const RegionCell& b) {
+    return RowMajorLess(a.coordinate, b.coordinate);
+  });
+}
+
+absl::Status ValidateRegion(const Level& level, absl::Span<const TileCoordinate> cells) {
+  for (const TileCoordinate& cell : cells) {
+    RETURN_IF_ERROR(ValidateCell(level, cell.x, cell.y));
+  }
+  return absl::OkStatus();
+}
+
+// Resolves each cell once against geometry the region has already decided.
+//
+// `pending` is what this terrain will see in the region's own cells once it is
+// written: the painted shape, or air where cells are being cleared. Every key is
+// computed before anything is resolved, and nothing is written here, so a
+// failure part way leaves the layer as it was.
+absl::StatusOr<std::vector<int>> ResolveRegionCells(
+    const Level& level, const WorldLayer& layer, TerrainIndex& index, const Terrain& terrain,
+    TerrainTileProvider& provider, absl::Span<const RegionCell> cells,
+    const absl::flat_hash_map<uint64_t, TileShape>& pending) {
+  const auto neighbor_shape = [&](int x, int y) -> absl::StatusOr<TileShape> {
+    if (auto found = pending.find(PackCell(x, y)); found != pending.end()) return found->second;
+    ASSIGN_OR_RETURN(const int neighbor_tile, GetTileAt(layer, x, y));
+    return index.FindByTileId(neighbor_tile) == &terrain ? index.ShapeOfTile(neighbor_tile)
+                                                         : TileShape::kNone;
+  };
+
+  std::vector<TerrainCellKey> keys;
+  keys.reserve(cells.size());
+  std::vector<TerrainCellKey> distinct;
+  absl::flat_hash_set<TerrainCellKey> seen;
+  for (const RegionCell& cell : cells) {
+    ASSIGN_OR_RETURN(TerrainCellKey key,
+                     ComputeKey(level, terrain, cell.shape, cell.coordinate.x, cell.coordinate.y,
+                                neighbor_shape));
+    if (seen.insert(key).second) distinct.push_back(key);
+    keys.push_back(std::move(key));
+  }
+  RETURN_IF_ERROR(provider.PrepareKeys(terrain, distinct));
+
+  std::vector<int> tile_ids;
+  tile_ids.reserve(cells.size());
+  for (size_t i = 0; i < cells.size(); ++i) {
+    const RegionCell& cell = cells[i];
+    ASSIGN_OR_RETURN(const int tile_id,
+                     provider.TileForKey(terrain, keys[i], cell.coordinate.x, cell.coordinate.y));
+    RETURN_IF_ERROR(index.NoteResolvedTile(tile_id, terrain, cell.shape));
+    tile_ids.push_back(tile_id);
+  }
+  return tile_ids;
+}
+
+// Adds the cells around `center` that `terrain` owns and the region is not
+// itself rewriting, each at most once, with the geometry it already has.
+absl::Status CollectFrontier(const Level& level, const WorldLayer& layer,
+                             const TerrainIndex& index, const Terrain& terrain,
+                             TileCoordinate center,
+                             const absl::flat_hash_map<uint64_t, TileShape>& pending,
+                             absl::flat_hash_set<uint64_t>& collected,
+                             std::vector<RegionCell>& frontier) {
+  for (const NeighborOffset& offset : kNeighborOffsets) {
+    const int x = center.x + offset.dx;
+    const int y = center.y + offset.dy;
+    if (IsOutsideLevel(level, x, y)) continue;
+    const uint64_t packed = PackCell(x, y);
+    if (pending.contains(packed) || collected.contains(packed)) continue;
+
+    ASSIGN_OR_RETURN(const int neighbor_tile, GetTileAt(layer, x, y));
+    if (index.FindByTileId(neighbor_tile) != &terrain) continue;
+    collected.insert(packed);
+    frontier.push_back(RegionCell{.coordinate = {.x = x, .y = y},
+                                  .shape = index.ShapeOfTile(neighbor_tile)});
+  }
+  return absl::OkStatus();
+}
+
+absl::Status WriteResolved(WorldLayer& layer, absl::Span<const RegionCell> cells,
+                           absl::Span<const int> tile_ids) {
+  for (size_t i = 0; i < cells.size(); ++i) {
+    RETURN_IF_ERROR(
+        SetTileAt(layer, cells[i].coordinate.x, cells[i].coordinate.y, tile_ids[i]));
+  }
+  return absl::OkStatus();
+}
+
 }  // namespace
 
 absl::StatusOr<TerrainIndex> TerrainIndex::Build(const Tileset& tileset) {
@@ -180,36 +342,13 @@ absl::StatusOr<TerrainCellKey> ComputeTerrainCellKey(const Level& level, const W
                                                      const TerrainIndex& index,
                                                      const Terrain& terrain, TileShape shape,
                                                      int tile_x, int tile_y) {
-  RETURN_IF_ERROR(ValidateCell(level, tile_x, tile_y));
-
-  TerrainCellKey key;
-  key.shape = shape;
-  for (int i = 0; i < kNeighborCount; ++i) {
-    const int x = tile_x + kNeighborOffsets[i].dx;
-    const int y = tile_y + kNeighborOffsets[i].dy;
-
-    if (IsOutsideLevel(level, x, y)) {
-      // Outside the level reads as solid ground of this terrain, which is what
-      // stops a coastline being drawn along the world border.
-      key.neighbors[i] = terrain.solid_outside_level ? TileShape::kFullBlock : TileShape::kNone;
-      continue;
-    }
-
-    ASSIGN_OR_RETURN(const int neighbor_tile, GetTileAt(layer, x, y));
-    key.neighbors[i] = index.FindByTileId(neighbor_tile) == &terrain
-                           ? index.ShapeOfTile(neighbor_tile)
-                           : TileShape::kNone;
-  }
-
-  // A periodic terrain's artwork is one pattern laid down in phases, so which
-  // phase a cell shows is fixed by where the cell sits rather than chosen.
-  const int period = terrain.variant_period;
-  if (period > 0) {
-    const int phase_x = ((tile_x % period) + period) % period;
-    const int phase_y = ((tile_y % period) + period) % period;
-    key.phase = phase_y * period + phase_x;
-  }
-  return key;
+  return ComputeKey(level, terrain, shape, tile_x, tile_y,
+                    [&](int x, int y) -> absl::StatusOr<TileShape> {
+                      ASSIGN_OR_RETURN(const int neighbor_tile, GetTileAt(layer, x, y));
+                      return index.FindByTileId(neighbor_tile) == &terrain
+                                 ? index.ShapeOfTile(neighbor_tile)
+                                 : TileShape::kNone;
+                    });
 }
 
 absl::StatusOr<uint8_t> ComputeTerrainMask(const Level& level, const WorldLayer& layer,
@@ -331,4 +470,152 @@ absl::Status EraseTerrain(const Level& level, WorldLayer& layer, TerrainIndex& i
   return RefreshNeighbors(level, layer, index, *terrain, provider, tile_x, tile_y);
 }
 
+absl::Status PaintTerrainRegion(const Level& level, WorldLayer& layer, TerrainIndex& index,
+                                TerrainTileProvider& provider, int terrain_id, TileShape shape,
+                                absl::Span<const TileCoordinate> cells) {
+  RETURN_IF_ERROR(ValidateRegion(level, cells));
+  const Terrain* terrain = index.FindById(terrain_id);
+  if (terrain == nullptr) {
+    return absl::NotFoundError(absl::StrCat("unknown terrain ID ", terrain_id));
+  }
+
+  // The region's geometry is settled first, so every cell below is resolved
+  // against the finished neighbourhood rather than one painted cell at a time.
+  const std::vector<TileCoordinate> painted = SortedUniqueCells(cells);
+  absl::flat_hash_map<uint64_t, TileShape> pending;
+  pending.reserve(painted.size());
+  for (const TileCoordinate& cell : painted) pending.emplace(PackCell(cell.x, cell.y), shape);
+
+  std::vector<RegionCell> affected;
+  affected.reserve(painted.size());
+  for (const TileCoordinate& cell : painted) {
+    affected.push_back(RegionCell{.coordinate = cell, .shape = shape});
+  }
+  absl::flat_hash_set<uint64_t> collected;
+  for (const TileCoordinate& cell : painted) {
+    RETURN_IF_ERROR(
+        CollectFrontier(level, layer, index, *terrain, cell, pending, collected, affected));
+  }
+  SortRowMajor(affected);
+
+  ASSIGN_OR_RETURN(const std::vector<int> tile_ids,
+                   ResolveRegionCells(level, layer, index, *terrain, provider, affected, pending));
+  return WriteResolved(layer, affected, tile_ids);
+}
+
+absl::Status EraseTerrainRegion(const Level& level, WorldLayer& layer, TerrainIndex& index,
+                                TerrainTileProvider& provider,
+                                absl::Span<const TileCoordinate> cells) {
+  RETURN_IF_ERROR(ValidateRegion(level, cells));
+
+  const std::vector<TileCoordinate> erased = SortedUniqueCells(cells);
+  absl::flat_hash_map<uint64_t, TileShape> pending;
+  pending.reserve(erased.size());
+  for (const TileCoordinate& cell : erased) {
+    pending.emplace(PackCell(cell.x, cell.y), TileShape::kNone);
+  }
+
+  // Only a cell whose own terrain lost a neighbour can change, and a cell
+  // belongs to exactly one terrain, so each terrain's frontier resolves alone.
+  // Ordered by terrain ID so derived artwork is appended deterministically.
+  std::map<int, std::pair<const Terrain*, std::vector<RegionCell>>> frontiers;
+  absl::flat_hash_set<uint64_t> collected;
+  for (const TileCoordinate& cell : erased) {
+    ASSIGN_OR_RETURN(const int existing, GetTileAt(layer, cell.x, cell.y));
+    const Terrain* terrain = index.FindByTileId(existing);
+    if (terrain == nullptr) continue;
+
+    auto& [owner, frontier] = frontiers[terrain->id];
+    owner = terrain;
+    RETURN_IF_ERROR(
+        CollectFrontier(level, layer, index, *terrain, cell, pending, collected, frontier));
+  }
+
+  std::vector<std::pair<std::vector<RegionCell>, std::vector<int>>> resolved;
+  for (auto& [terrain_id, entry] : frontiers) {
+    auto& [terrain, frontier] = entry;
+    SortRowMajor(frontier);
+    ASSIGN_OR_RETURN(std::vector<int> tile_ids, ResolveRegionCells(level, layer, index, *terrain,
+                                                                   provider, frontier, pending));
+    resolved.emplace_back(std::move(frontier), std::move(tile_ids));
+  }
+
+  for (const TileCoordinate& cell : erased) RETURN_IF_ERROR(SetTileAt(layer, cell.x, cell.y, 0));
+  for (const auto& [frontier, tile_ids] : resolved) {
+    RETURN_IF_ERROR(WriteResolved(layer, frontier, tile_ids));
+  }
+  return absl::OkStatus();
+}
+
+std::vector<TileCoordinate> RectangleCells(TileCoordinate corner, TileCoordinate opposite) {
+  const int min_x = std::min(corner.x, opposite.x);
+  const int max_x = std::max(corner.x, opposite.x);
+  const int min_y = std::min(corner.y, opposite.y);
+  const int max_y = std::max(corner.y, opposite.y);
+
+  std::vector<TileCoordinate> cells;
+  cells.reserve(static_cast<size_t>(max_x - min_x + 1) * (max_y - min_y + 1));
+  for (int y = min_y; y <= max_y; ++y) {
+    for (int x = min_x; x <= max_x; ++x) cells.push_back(TileCoordinate{.x = x, .y = y});
+  }
+  return cells;
+}
+
+std::vector<TileCoordinate> StrokeCells(TileCoordinate from, TileCoordinate to) {
+  // Bresenham, stepping diagonally where both axes advance, so consecutive
+  // cells always touch and the stroke has no holes for a neighbour to see.
+  const int delta_x = std::abs(to.x - from.x);
+  const int delta_y = -std::abs(to.y - from.y);
+  const int step_x = from.x < to.x ? 1 : -1;
+  const int step_y = from.y < to.y ? 1 : -1;
+
+  std::vector<TileCoordinate> cells;
+  cells.reserve(static_cast<size_t>(std::max(delta_x, -delta_y)) + 1);
+  TileCoordinate at = from;
+  int error = delta_x + delta_y;
+  while (true) {
+    cells.push_back(at);
+    if (at.x == to.x && at.y == to.y) return cells;
+    const int doubled = 2 * error;
+    if (doubled >= delta_y) {
+      error += delta_y;
+      at.x += step_x;
+    }
+    if (doubled <= delta_x) {
+      error += delta_x;
+      at.y += step_y;
+    }
+  }
+}
+
+absl::StatusOr<std::vector<TileCoordinate>> FloodFillCells(const Level& level,
+                                                           const WorldLayer& layer,
+                                                           TileCoordinate start) {
+  RETURN_IF_ERROR(ValidateCell(level, start.x, start.y));
+  if (IsOutsideLevel(level, start.x, start.y)) {
+    return absl::InvalidArgumentError("a flood fill must start inside the level");
+  }
+
+  ASSIGN_OR_RETURN(const int fill_tile, GetTileAt(layer, start.x, start.y));
+  std::vector<TileCoordinate> filled;
+  std::vector<TileCoordinate> frontier = {start};
+  absl::flat_hash_set<uint64_t> visited = {PackCell(start.x, start.y)};
+  while (!frontier.empty()) {
+    const TileCoordinate at = frontier.back();
+    frontier.pop_back();
+    filled.push_back(at);
+
+    // The orthogonal neighbours only: a fill leaking through a diagonal gap
+    // would cross what reads on screen as a closed wall.
+    for (int i = 0; i < kNeighborCount; i += 2) {
+      const int x = at.x + kNeighborOffsets[i].dx;
+      const int y = at.y + kNeighborOffsets[i].dy;
+      if (IsOutsideLevel(level, x, y) || !visited.insert(PackCell(x, y)).second) continue;
+      ASSIGN_OR_RETURN(const int tile, GetTileAt(layer, x, y));
+      if (tile == fill_tile) frontier.push_back(TileCoordinate{.x = x, .y = y});
+    }
+  }
+  return filled;
+}
+
 }  // namespace zebes
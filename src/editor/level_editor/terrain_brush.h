@@ -1,11 +1,14 @@
 #pragma once
 
 #include <cstdint>
+#include <vector>
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/types/span.h"
 #include "common/image_io.h"
+#include "editor/level_editor/viewport_model.h"
 #include "objects/level.h"
 #include "objects/tileset.h"
 
@@ -122,6 +125,19 @@ class TerrainTileProvider {
   virtual absl::StatusOr<TerrainPreview> PreviewForKey(const Terrain& terrain,
                                                        const TerrainCellKey& key, int tile_x,
                                                        int tile_y) = 0;
+
+  // Announces every distinct key a region operation is about to ask for.
+  //
+  // A region knows all of its neighbourhoods before it resolves any of them, so
+  // a provider whose artwork is expensive can do the expensive part once per
+  // key, and all at once. Preparing must not create anything: tiles still come
+  // into existence in TileForKey, in the order the region asks for them, which
+  // is what keeps the atlas growing deterministically. Authored artwork has
+  // nothing to prepare, hence the default.
+  virtual absl::Status PrepareKeys(const Terrain& terrain,
+                                   absl::Span<const TerrainCellKey> keys) {
+    return absl::OkStatus();
+  }
 };
 
 // The provider for terrain whose artwork was authored against a neighbour mask.
@@ -202,4 +218,42 @@ absl::Status PaintTerrain(const Level& level, WorldLayer& layer, TerrainIndex& i
 absl::Status EraseTerrain(const Level& level, WorldLayer& layer, TerrainIndex& index,
                           TerrainTileProvider& provider, int tile_x, int tile_y);
 
+// Paints every cell in `cells` with terrain_id and one collision shape, leaving
+// the layer exactly as painting them one at a time would.
+//
+// Painting cell by cell resolves each neighbour again for every painted cell
+// beside it, so a filled block costs roughly nine resolutions a cell. Here the
+// geometry is decided for the whole region first, and then every affected
+// cell -- the region and its same-terrain frontier -- is resolved once against
+// it. Identical neighbourhoods are announced to the provider once through
+// PrepareKeys, so a derived terrain renders each distinct one a single time.
+//
+// Cells are resolved in row-major order whatever order they arrive in, and
+// duplicates are ignored. Validation happens before anything is written.
+absl::Status PaintTerrainRegion(const Level& level, WorldLayer& layer, TerrainIndex& index,
+                                TerrainTileProvider& provider, int terrain_id, TileShape shape,
+                                absl::Span<const TileCoordinate> cells);
+
+// Clears every cell in `cells`, then re-resolves once each surviving cell whose
+// own terrain lost a neighbour, as EraseTerrain would one cell at a time.
+absl::Status EraseTerrainRegion(const Level& level, WorldLayer& layer, TerrainIndex& index,
+                                TerrainTileProvider& provider,
+                                absl::Span<const TileCoordinate> cells);
+
+// Every cell of the rectangle spanned by two corners, inclusive, in either
+// order.
+std::vector<TileCoordinate> RectangleCells(TileCoordinate corner, TileCoordinate opposite);
+
+// The 8-connected line of cells from `from` to `to`, both included.
+//
+// The pointer can cross several cells between two frames, and painting only
+// the cell under it would leave gaps in a fast stroke.
+std::vector<TileCoordinate> StrokeCells(TileCoordinate from, TileCoordinate to);
+
+// The 4-connected cells inside the level holding the same tile as `start`.
+// Fails when `start` is outside the level.
+absl::StatusOr<std::vector<TileCoordinate>> FloodFillCells(const Level& level,
+                                                           const WorldLayer& layer,
+                                                           TileCoordinate start);
+
 }  // namespace zebes
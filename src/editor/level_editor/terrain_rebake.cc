@@ -0,0 +1,188 @@
+#include "editor/level_editor/terrain_rebake.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/strings/str_cat.h"
+#include "absl/types/span.h"
+#include "common/parallel_for.h"
+#include "common/status_macros.h"
+
+namespace zebes {
+namespace {
+
+// One cell of the terrain as the scan found it.
+struct ScannedCell {
+  int local = 0;
+  TileShape shape = TileShape::kNone;
+  int tile = 0;
+  TerrainCellKey key;
+};
+
+// A chunk the scan reads, and what it found there. Each worker writes only the
+// slot it claimed.
+struct ChunkSlot {
+  int layer = 0;
+  int64_t chunk_key = 0;
+  TileChunkCoordinate coordinate;
+  std::vector<ScannedCell> cells;
+};
+
+absl::Status CheckCancelled(const TerrainRebakeMonitor* monitor) {
+  if (monitor != nullptr && monitor->cancelled()) {
+    return absl::CancelledError("terrain rebake was cancelled");
+  }
+  return absl::OkStatus();
+}
+
+void BeginStage(TerrainRebakeMonitor* monitor, TerrainRebakeMonitor::Stage stage, int64_t total) {
+  if (monitor != nullptr) monitor->BeginStage(stage, total);
+}
+
+void Advance(TerrainRebakeMonitor* monitor, int64_t done) {
+  if (monitor != nullptr) monitor->Advance(done);
+}
+
+// Every chunk of every layer, in the order the write pass visits them.
+std::vector<ChunkSlot> ListChunks(const Level& level) {
+  std::vector<ChunkSlot> slots;
+  for (int layer = 0; layer < static_cast<int>(level.layers.size()); ++layer) {
+    const size_t first = slots.size();
+    for (const auto& [chunk_key, chunk] : level.layers[layer].tile_chunks) {
+      slots.push_back(ChunkSlot{
+          .layer = layer, .chunk_key = chunk_key, .coordinate = DecodeChunkKey(chunk_key)});
+    }
+    // Hash map order is not an order; row-major is.
+    std::sort(slots.begin() + first, slots.end(), [](const ChunkSlot& a, const ChunkSlot& b) {
+      return a.coordinate < b.coordinate;
+    });
+  }
+  return slots;
+}
+
+absl::Status ScanChunk(const Level& level, const TerrainIndex& index, const Terrain& terrain,
+                       ChunkSlot& slot) {
+  constexpr int kSize = TileChunk::kSize;
+  const WorldLayer& layer = level.layers[slot.layer];
+  const TileChunk& chunk = layer.tile_chunks.at(slot.chunk_key);
+  for (int local = 0; local < kSize * kSize; ++local) {
+    const int tile = chunk.tile(local);
+    if (tile == 0 || index.FindByTileId(tile) != &terrain) continue;
+
+    // The cell keeps the geometry it has; only how it looks is up for change.
+    const TileShape shape = index.ShapeOfTile(tile);
+    const int x = slot.coordinate.x * kSize + local % kSize;
+    const int y = slot.coordinate.y * kSize + local / kSize;
+    ASSIGN_OR_RETURN(TerrainCellKey key,
+                     ComputeTerrainCellKey(level, layer, index, terrain, shape, x, y));
+    slot.cells.push_back(
+        ScannedCell{.local = local, .shape = shape, .tile = tile, .key = std::move(key)});
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace
+
+TerrainRebakeMonitor::Progress TerrainRebakeMonitor::progress() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return progress_;
+}
+
+void TerrainRebakeMonitor::BeginStage(Stage stage, int64_t total) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  progress_.stage = stage;
+  progress_.done = 0;
+  progress_.total = total;
+}
+
+void TerrainRebakeMonitor::Advance(int64_t done) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  progress_.done += done;
+}
+
+void TerrainRebakeMonitor::BeginLevel(int level, int levels) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  progress_ = Progress{.level = level, .levels = levels};
+}
+
+absl::StatusOr<TerrainRebakeStats> RebakeTerrain(Level& level, TerrainIndex& index,
+                                                 TerrainTileProvider& provider, int terrain_id,
+                                                 const TerrainRebakeOptions& options) {
+  const Terrain* terrain = index.FindById(terrain_id);
+  if (terrain == nullptr) {
+    return absl::NotFoundError(absl::StrCat("unknown terrain ID ", terrain_id));
+  }
+  if (options.render_batch <= 0) {
+    return absl::InvalidArgumentError("a rebake must render at least one key per batch");
+  }
+  TerrainRebakeMonitor* monitor = options.monitor;
+
+  // Scan. Nothing is written until every key is known, so each worker reads a
+  // level no one is changing.
+  std::vector<ChunkSlot> slots = ListChunks(level);
+  BeginStage(monitor, TerrainRebakeMonitor::Stage::kScanning, static_cast<int64_t>(slots.size()));
+  RETURN_IF_ERROR(ParallelFor(static_cast<int>(slots.size()), options.max_workers,
+                              [&](int i) -> absl::Status {
+                                RETURN_IF_ERROR(CheckCancelled(monitor));
+                                RETURN_IF_ERROR(ScanChunk(level, index, *terrain, slots[i]));
+                                Advance(monitor, 1);
+                                return absl::OkStatus();
+                              }));
+
+  TerrainRebakeStats stats;
+  std::vector<TerrainCellKey> distinct;
+  absl::flat_hash_set<TerrainCellKey> seen;
+  for (const ChunkSlot& slot : slots) {
+    stats.cells += static_cast<int64_t>(slot.cells.size());
+    for (const ScannedCell& cell : slot.cells) {
+      if (seen.insert(cell.key).second) distinct.push_back(cell.key);
+    }
+  }
+  stats.distinct_keys = static_cast<int64_t>(distinct.size());
+
+  // Render. Each batch is one chance to report and to stop.
+  BeginStage(monitor, TerrainRebakeMonitor::Stage::kRendering, stats.distinct_keys);
+  const absl::Span<const TerrainCellKey> keys(distinct);
+  for (size_t first = 0; first < keys.size(); first += options.render_batch) {
+    RETURN_IF_ERROR(CheckCancelled(monitor));
+    const absl::Span<const TerrainCellKey> batch = keys.subspan(first, options.render_batch);
+    RETURN_IF_ERROR(provider.PrepareKeys(*terrain, batch));
+    Advance(monitor, static_cast<int64_t>(batch.size()));
+  }
+  RETURN_IF_ERROR(CheckCancelled(monitor));
+
+  // Write. Every tile is resolved before the first is stored, so a provider
+  // that fails partway leaves the level as it was.
+  BeginStage(monitor, TerrainRebakeMonitor::Stage::kWriting, stats.cells);
+  constexpr int kSize = TileChunk::kSize;
+  std::vector<int> resolved;
+  resolved.reserve(stats.cells);
+  for (const ChunkSlot& slot : slots) {
+    for (const ScannedCell& cell : slot.cells) {
+      const int x = slot.coordinate.x * kSize + cell.local % kSize;
+      const int y = slot.coordinate.y * kSize + cell.local / kSize;
+      ASSIGN_OR_RETURN(const int tile_id, provider.TileForKey(*terrain, cell.key, x, y));
+      RETURN_IF_ERROR(index.NoteResolvedTile(tile_id, *terrain, cell.shape));
+      resolved.push_back(tile_id);
+    }
+    Advance(monitor, static_cast<int64_t>(slot.cells.size()));
+  }
+
+  size_t next = 0;
+  for (const ChunkSlot& slot : slots) {
+    if (slot.cells.empty()) continue;
+    TileChunk& chunk = level.layers[slot.layer].tile_chunks.at(slot.chunk_key);
+    for (const ScannedCell& cell : slot.cells) {
+      const int tile_id = resolved[next++];
+      if (tile_id == cell.tile) continue;
+      chunk.SetTile(cell.local, tile_id);
+      ++stats.rewritten;
+    }
+  }
+
+  BeginStage(monitor, TerrainRebakeMonitor::Stage::kDone, 0);
+  return stats;
+}
+
+}  // namespace zebes
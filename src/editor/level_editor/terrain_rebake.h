@@ -0,0 +1,102 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+#include "absl/status/statusor.h"
+#include "editor/level_editor/terrain_brush.h"
+#include "objects/level.h"
+
+namespace zebes {
+
+// Watches a rebake from another thread, and stops it.
+//
+// A whole-level rebake is long enough to run as a BackgroundTask, and the
+// thread that started it is the one that wants to draw a progress bar and offer
+// a Cancel button. Every member is safe to call from any thread at any time.
+class TerrainRebakeMonitor {
+ public:
+  enum class Stage {
+    kScanning,
+    kRendering,
+    kWriting,
+    kDone,
+  };
+
+  struct Progress {
+    Stage stage = Stage::kScanning;
+    // Units of the current stage: chunks while scanning, distinct keys while
+    // rendering, cells while writing.
+    int64_t done = 0;
+    int64_t total = 0;
+    // Which of several levels is being rebaked, counting from zero, when a
+    // driver rebakes them in turn. `levels` is zero for a single rebake.
+    int level = 0;
+    int levels = 0;
+  };
+
+  // Asks the rebake to stop. Honoured until writing starts; from then on the
+  // rebake finishes, because a level half rewritten is worse than either side.
+  void Cancel() { cancelled_.store(true, std::memory_order_relaxed); }
+  bool cancelled() const { return cancelled_.load(std::memory_order_relaxed); }
+
+  Progress progress() const;
+
+  // Called by the rebake.
+  void BeginStage(Stage stage, int64_t total);
+  void Advance(int64_t done);
+
+  // Called by a driver before each level it rebakes.
+  void BeginLevel(int level, int levels);
+
+ private:
+  std::atomic<bool> cancelled_ = false;
+  mutable std::mutex mutex_;
+  Progress progress_;
+};
+
+struct TerrainRebakeOptions {
+  // Workers for scanning and rendering. Zero means one per hardware thread.
+  int max_workers = 0;
+  // Distinct keys handed to the provider per PrepareKeys call. Smaller batches
+  // report progress and notice a cancel sooner; larger ones keep more cores
+  // busy at once.
+  int render_batch = 64;
+  // Optional; may be null.
+  TerrainRebakeMonitor* monitor = nullptr;
+};
+
+struct TerrainRebakeStats {
+  int64_t cells = 0;
+  int64_t distinct_keys = 0;
+  // Cells whose tile changed. Zero means the level was already up to date.
+  int64_t rewritten = 0;
+};
+
+// Re-resolves every cell of `terrain_id` in every layer of the level against
+// what the provider draws now.
+//
+// This is what brings a level up to date after its terrain was regenerated or
+// its tileset edited. Painting never changes during a rebake -- each cell keeps
+// its terrain and its geometry, exactly as ResolveTerrainCell promises -- so
+// every key can be computed from the level as it stands, all at once, before
+// any of it is written. That is what makes the work divisible:
+//
+//  1. Scan. Chunks are read in parallel, each into its own slot.
+//  2. Render. The distinct keys, in first-seen order, are handed to
+//     PrepareKeys in batches, which is where a derived terrain renders them
+//     across cores.
+//  3. Write. Cells are resolved and rewritten on the calling thread, layer by
+//     layer, chunk by chunk in row-major order and cell by cell within each, so
+//     any tiles the provider appends land in the same order on every run.
+//
+// Cancelled is returned if the monitor asks for it before writing starts, and
+// the level is then untouched. An error during writing also leaves the level
+// untouched, since every tile is resolved before the first one is written; a
+// derived provider may still have appended artwork nothing references.
+absl::StatusOr<TerrainRebakeStats> RebakeTerrain(Level& level, TerrainIndex& index,
+                                                 TerrainTileProvider& provider, int terrain_id,
+                                                 const TerrainRebakeOptions& options = {});
+
+}  // namespace zebes
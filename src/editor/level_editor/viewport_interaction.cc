@@ -3,6 +3,7 @@
 #include <cmath>
 #include <limits>
 #include <utility>
+#include <vector>
 
 #include "absl/status/status.h"
 #include "common/status_macros.h"
@@ -32,12 +33,26 @@ absl::Status ValidateInput(const Level& level, const ViewportInteractionInput& i
   return absl::OkStatus();
 }
 
+// Every cell a terrain write to `cells` can rewrite: the cells themselves and
+// the neighbours the brush re-resolves around them.
+std::vector<TileCoordinate> TerrainReach(absl::Span<const TileCoordinate> cells) {
+  std::vector<TileCoordinate> reach;
+  reach.reserve(cells.size() * 9);
+  for (const TileCoordinate& cell : cells) {
+    for (int dy = -1; dy <= 1; ++dy) {
+      for (int dx = -1; dx <= 1; ++dx) reach.push_back({.x = cell.x + dx, .y = cell.y + dy});
+    }
+  }
+  return reach;
+}
+
 }  // namespace
 
 void ViewportInteractionController::Reset() {
   next_entity_id_ = 1;
   entity_drag_.reset();
   last_painted_.reset();
+  EndStroke();
 }
 
 absl::StatusOr<ViewportInteractionResult> ViewportInteractionController::Update(
@@ -54,16 +69,19 @@ absl::StatusOr<ViewportInteractionResult> ViewportInteractionController::Update(
   }
 
   // A released button ends the current stroke, so the next press may repaint
-  // the same cell.
-  if (!input.primary_down && !input.secondary_down) last_painted_.reset();
+  // the same cell and starts a new undo step.
+  if (!input.primary_down && !input.secondary_down) {
+    last_painted_.reset();
+    EndStroke();
+  }
 
   if (options.paint_terrain_id.has_value()) {
-    entity_drag_.reset();
+    EndEntityDrag(layer, options.journal);
     return UpdateTerrain(level, layer, input, options);
   }
   if (options.paint_tile_id.has_value()) {
-    entity_drag_.reset();
-    return UpdateTile(level, layer, input, *options.paint_tile_id);
+    EndEntityDrag(layer, options.journal);
+    return UpdateTile(level, layer, input, *options.paint_tile_id, options.journal);
   }
   return UpdateEntity(level, layer, input, options);
 }
@@ -77,8 +95,53 @@ bool ViewportInteractionController::ClaimPaintCell(TileCoordinate coordinate, bo
   return true;
 }
 
+std::vector<TileCoordinate> ViewportInteractionController::ClaimStrokeCells(
+    TileCoordinate coordinate, bool erasing) {
+  const std::optional<PaintedCell> previous = last_painted_;
+  if (!ClaimPaintCell(coordinate, erasing)) return {};
+  if (!previous.has_value() || previous->erasing != erasing) return {coordinate};
+
+  std::vector<TileCoordinate> cells = StrokeCells(previous->coordinate, coordinate);
+  cells.erase(cells.begin());
+  return cells;
+}
+
+absl::Status ViewportInteractionController::PaintStroke(LevelJournal* journal, WorldLayer& layer,
+                                                        absl::Span<const TileCoordinate> reach,
+                                                        absl::FunctionRef<absl::Status()> paint) {
+  if (journal == nullptr) return paint();
+  if (stroke_journal_ != journal) {
+    EndStroke();
+    journal->BeginGroup();
+    stroke_journal_ = journal;
+  }
+  return journal->RecordTiles(layer, reach, paint);
+}
+
+void ViewportInteractionController::EndStroke() {
+  if (stroke_journal_ == nullptr) return;
+  stroke_journal_->EndGroup();
+  stroke_journal_ = nullptr;
+}
+
+void ViewportInteractionController::EndEntityDrag(const WorldLayer& layer,
+                                                  LevelJournal* journal) {
+  if (!entity_drag_.has_value()) return;
+  const auto entity = layer.entities.find(entity_drag_->entity_id);
+  if (journal != nullptr && entity != layer.entities.end()) {
+    journal->RecordEntity({
+        .layer_id = layer.id,
+        .entity_id = entity->first,
+        .before = entity_drag_->before,
+        .after = entity->second,
+    });
+  }
+  entity_drag_.reset();
+}
+
 absl::StatusOr<ViewportInteractionResult> ViewportInteractionController::UpdateTile(
-    const Level& level, WorldLayer& layer, const ViewportInteractionInput& input, int tile_id) {
+    const Level& level, WorldLayer& layer, const ViewportInteractionInput& input, int tile_id,
+    LevelJournal* journal) {
   if (tile_id <= 0) {
     return absl::InvalidArgumentError("paint tile ID must be positive");
   }
@@ -94,7 +157,10 @@ absl::StatusOr<ViewportInteractionResult> ViewportInteractionController::UpdateT
   if (!input.primary_down && !erasing) return ViewportInteractionResult{};
   if (!ClaimPaintCell(coordinate, erasing)) return ViewportInteractionResult{};
 
-  RETURN_IF_ERROR(SetTileAt(layer, coordinate.x, coordinate.y, erasing ? 0 : tile_id));
+  const TileCoordinate reach[] = {coordinate};
+  RETURN_IF_ERROR(PaintStroke(journal, layer, reach, [&] {
+    return SetTileAt(layer, coordinate.x, coordinate.y, erasing ? 0 : tile_id);
+  }));
   return ViewportInteractionResult{};
 }
 
@@ -117,16 +183,17 @@ absl::StatusOr<ViewportInteractionResult> ViewportInteractionController::UpdateT
                                          level.tile_render_height));
   const bool erasing = !input.primary_down && (input.secondary_pressed || input.secondary_down);
   if (!input.primary_down && !erasing) return ViewportInteractionResult{};
-  if (!ClaimPaintCell(coordinate, erasing)) return ViewportInteractionResult{};
+  const std::vector<TileCoordinate> stroke = ClaimStrokeCells(coordinate, erasing);
+  if (stroke.empty()) return ViewportInteractionResult{};
 
-  if (!erasing) {
-    RETURN_IF_ERROR(PaintTerrain(level, layer, *options.terrain_index, *options.terrain_provider,
-                                 *options.paint_terrain_id, options.paint_shape, coordinate.x,
-                                 coordinate.y));
-    return ViewportInteractionResult{};
-  }
-  RETURN_IF_ERROR(EraseTerrain(level, layer, *options.terrain_index, *options.terrain_provider,
-                               coordinate.x, coordinate.y));
+  RETURN_IF_ERROR(PaintStroke(options.journal, layer, TerrainReach(stroke), [&] {
+    if (erasing) {
+      return EraseTerrainRegion(level, layer, *options.terrain_index, *options.terrain_provider,
+                                stroke);
+    }
+    return PaintTerrainRegion(level, layer, *options.terrain_index, *options.terrain_provider,
+                              *options.paint_terrain_id, options.paint_shape, stroke);
+  }));
   return ViewportInteractionResult{};
 }
 
@@ -148,7 +215,7 @@ absl::StatusOr<ViewportInteractionResult> ViewportInteractionController::UpdateE
   }
 
   if (options.placement_blueprint != nullptr) {
-    entity_drag_.reset();
+    EndEntityDrag(layer, options.journal);
     if (!input.primary_pressed || !input.pointer_in_level) return result;
 
     const bool blueprint_references_sprite = options.placement_blueprint->sprite_id(0).has_value();
@@ -159,7 +226,11 @@ absl::StatusOr<ViewportInteractionResult> ViewportInteractionController::UpdateE
       return absl::InvalidArgumentError("invisible placement blueprint received a sprite");
     }
 
-    ASSIGN_OR_RETURN(const uint64_t available, NextAvailableEntityId(level));
+    // A streamed level only holds the entities near the camera; the rest still
+    // own their IDs.
+    ASSIGN_OR_RETURN(const uint64_t available, options.streamer != nullptr
+                                                   ? options.streamer->NextAvailableEntityId()
+                                                   : NextAvailableEntityId(level));
     if (!next_entity_id_.has_value() || available > *next_entity_id_) {
       next_entity_id_ = available;
     }
@@ -180,7 +251,7 @@ absl::StatusOr<ViewportInteractionResult> ViewportInteractionController::UpdateE
 
   if (entity_drag_.has_value()) {
     if (!input.primary_down) {
-      entity_drag_.reset();
+      EndEntityDrag(layer, options.journal);
       return result;
     }
 
@@ -213,6 +284,7 @@ absl::StatusOr<ViewportInteractionResult> ViewportInteractionController::UpdateE
               input.world_position.x - entity->second.transform.position.x,
               input.world_position.y - entity->second.transform.position.y,
           },
+      .before = entity->second,
   };
   return result;
 }
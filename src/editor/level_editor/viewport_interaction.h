@@ -2,8 +2,12 @@
 
 #include <cstdint>
 #include <optional>
+#include <vector>
 
+#include "absl/functional/function_ref.h"
 #include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "editor/level_editor/level_journal.h"
 #include "editor/level_editor/terrain_brush.h"
 #include "editor/level_editor/viewport_model.h"
 #include "objects/blueprint.h"
@@ -11,6 +15,7 @@
 #include "objects/level.h"
 #include "objects/sprite.h"
 #include "objects/vec.h"
+#include "resources/level_streamer.h"
 
 namespace zebes {
 
@@ -60,6 +65,12 @@ struct ViewportInteractionOptions {
   const SpriteLookup* entity_sprites = nullptr;
   // Whether a secondary press requests deletion instead of ordinary interaction.
   bool delete_mode = false;
+  // Records paint strokes and entity drags, one entry each. Null records
+  // nothing.
+  LevelJournal* journal = nullptr;
+  // Keeps the level resident when it is streamed, and knows the entity IDs its
+  // regions on disk hold. Null for a level held whole.
+  const LevelStreamer* streamer = nullptr;
 };
 
 // Discrete actions produced for the Level Editor after processing one frame.
@@ -86,11 +97,13 @@ class ViewportInteractionController {
   struct EntityDrag {
     uint64_t entity_id = Entity::kInvalidId;
     Vec pointer_offset;
+    // The entity as the drag found it, so the whole drag undoes as one edit.
+    Entity before;
   };
 
   absl::StatusOr<ViewportInteractionResult> UpdateTile(const Level& level, WorldLayer& layer,
                                                        const ViewportInteractionInput& input,
-                                                       int tile_id);
+                                                       int tile_id, LevelJournal* journal);
   absl::StatusOr<ViewportInteractionResult> UpdateTerrain(
       const Level& level, WorldLayer& layer, const ViewportInteractionInput& input,
       const ViewportInteractionOptions& options);
@@ -110,9 +123,28 @@ class ViewportInteractionController {
   // frame, which for terrain also re-resolves its eight neighbours.
   bool ClaimPaintCell(TileCoordinate coordinate, bool erasing);
 
+  // Claims this frame's cell and returns every cell the stroke crossed to reach
+  // it, excluding the one already written. The pointer can skip cells between
+  // frames, and the segment is painted as one region so a fast drag leaves no
+  // gaps and resolves each neighbourhood once.
+  std::vector<TileCoordinate> ClaimStrokeCells(TileCoordinate coordinate, bool erasing);
+
+  // Runs `paint`, which may rewrite any cell in `reach`, as part of the current
+  // stroke. The stroke is one journal entry from its first write until the
+  // button is released.
+  absl::Status PaintStroke(LevelJournal* journal, WorldLayer& layer,
+                           absl::Span<const TileCoordinate> reach,
+                           absl::FunctionRef<absl::Status()> paint);
+  void EndStroke();
+
+  // Ends the current entity drag, recording it when it moved anything.
+  void EndEntityDrag(const WorldLayer& layer, LevelJournal* journal);
+
   std::optional<uint64_t> next_entity_id_ = 1;
   std::optional<EntityDrag> entity_drag_;
   std::optional<PaintedCell> last_painted_;
+  // The journal holding the current stroke's entry, or null between strokes.
+  LevelJournal* stroke_journal_ = nullptr;
 };
 
 }  // namespace zebes
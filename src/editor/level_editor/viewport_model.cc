@@ -117,7 +117,18 @@ absl::Status SetTileAt(WorldLayer& layer, int tile_x, int tile_y, int tile_id) {
   const int chunk_y = tile_y / kSize;
   const int local_x = tile_x % kSize;
   const int local_y = tile_y % kSize;
-  layer.tile_chunks[ChunkKey(chunk_x, chunk_y)].tiles[local_y * kSize + local_x] = tile_id;
+  const int64_t key = ChunkKey(chunk_x, chunk_y);
+
+  // Empty chunks are not kept: erasing never allocates one, and erasing a
+  // chunk's last tile drops it.
+  if (tile_id == 0) {
+    const auto chunk = layer.tile_chunks.find(key);
+    if (chunk == layer.tile_chunks.end()) return absl::OkStatus();
+    chunk->second.SetTile(local_y * kSize + local_x, 0);
+    if (chunk->second.empty()) layer.tile_chunks.erase(chunk);
+    return absl::OkStatus();
+  }
+  layer.tile_chunks[key].SetTile(local_y * kSize + local_x, tile_id);
   return absl::OkStatus();
 }
 
@@ -133,7 +144,7 @@ absl::StatusOr<int> GetTileAt(const WorldLayer& layer, int tile_x, int tile_y) {
   const int local_y = tile_y % kSize;
   const auto chunk = layer.tile_chunks.find(ChunkKey(chunk_x, chunk_y));
   if (chunk == layer.tile_chunks.end()) return 0;
-  return chunk->second.tiles[local_y * kSize + local_x];
+  return chunk->second.tile(local_y * kSize + local_x);
 }
 
 PaletteBinding ResolvePaletteBinding(const Level& level, const PaletteSelection& selection) {
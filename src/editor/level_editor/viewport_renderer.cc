@@ -1,6 +1,7 @@
 #include "editor/level_editor/viewport_renderer.h"
 
 #include <cmath>
+#include <cstddef>
 #include <cstdint>
 #include <map>
 #include <optional>
@@ -202,27 +203,52 @@ absl::Status ViewportRenderer::RenderTiles(const TileRenderBatch& batch) const {
   return absl::OkStatus();
 }
 
-absl::Status ViewportRenderer::RenderParallax(const ParallaxRenderBatch& batch) const {
+absl::Status ViewportRenderer::RenderChunkImpostors(
+    std::span<const ChunkImpostorRenderItem> items) const {
   ImDrawList* draw_list = canvas_.GetDrawList();
   if (draw_list == nullptr) {
     return absl::FailedPreconditionError("viewport canvas has no active draw list");
   }
 
-  std::map<SDL_Texture*, NativeTextureInfo> texture_info;
-  for (const ParallaxRenderItem& item : batch.layers) {
+  for (const ChunkImpostorRenderItem& item : items) {
+    if (!item.bounds.IsValid() || !item.texture) {
+      return absl::InvalidArgumentError("chunk impostor has invalid geometry or texture");
+    }
+    SDL_Texture* native_texture = SdlTextureHandleAdapter::ToNative(item.texture);
+    draw_list->AddImage(reinterpret_cast<ImTextureID>(native_texture),
+                        canvas_.WorldToScreen(item.bounds.min),
+                        canvas_.WorldToScreen(item.bounds.max));
+  }
+  return absl::OkStatus();
+}
+
+absl::Status ViewportRenderer::RenderParallax(const ParallaxRenderBatch& batch,
+                                              ParallaxLayoutCache& layouts) const {
+  ImDrawList* draw_list = canvas_.GetDrawList();
+  if (draw_list == nullptr) {
+    return absl::FailedPreconditionError("viewport canvas has no active draw list");
+  }
+
+  for (size_t index = 0; index < batch.layers.size(); ++index) {
+    const ParallaxRenderItem& item = batch.layers[index];
     SDL_Texture* native_texture = SdlTextureHandleAdapter::ToNative(item.texture);
     if (native_texture == nullptr) {
       return absl::FailedPreconditionError("parallax texture handle cannot be resolved");
     }
 
-    auto [texture_it, inserted] = texture_info.try_emplace(native_texture);
-    if (inserted) {
-      ASSIGN_OR_RETURN(texture_it->second, QueryTextureInfo(native_texture));
+    const ParallaxLayerGeometry* geometry = layouts.Find(index, item.texture);
+    if (geometry == nullptr) {
+      ASSIGN_OR_RETURN(const NativeTextureInfo texture, QueryTextureInfo(native_texture));
+      std::optional<ParallaxLayerGeometry> computed =
+          CalculateParallaxLayerGeometry(item.layer, texture.width, texture.height);
+      if (!computed.has_value()) {
+        return absl::InvalidArgumentError("parallax render item has invalid layout inputs");
+      }
+      layouts.Store(index, item.texture, *computed);
+      geometry = layouts.Find(index, item.texture);
     }
-    const NativeTextureInfo& texture = texture_it->second;
 
-    std::optional<ParallaxLayout> layout =
-        CalculateParallaxLayout(batch.camera, item.layer, texture.width, texture.height);
+    std::optional<ParallaxLayout> layout = CalculateParallaxLayout(batch.camera, *geometry);
     if (!layout.has_value()) {
       return absl::InvalidArgumentError("parallax render item has invalid layout inputs");
     }
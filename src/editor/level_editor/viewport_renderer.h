@@ -4,6 +4,8 @@
 
 #include "absl/status/status.h"
 #include "editor/canvas/canvas.h"
+#include "editor/level_editor/chunk_impostor.h"
+#include "editor/level_editor/parallax_layout.h"
 #include "editor/level_editor/viewport_scene.h"
 
 namespace zebes {
@@ -20,7 +22,12 @@ class ViewportRenderer {
   // selection in a background layer is not obscured by foreground content.
   absl::Status RenderEntityOverlays(std::span<const EntityRenderItem> items) const;
   absl::Status RenderTiles(const TileRenderBatch& batch) const;
-  absl::Status RenderParallax(const ParallaxRenderBatch& batch) const;
+  // Draws each impostor's whole texture over its chunk, in place of the tiles.
+  absl::Status RenderChunkImpostors(std::span<const ChunkImpostorRenderItem> items) const;
+  // Reuses the geometry `layouts` holds for each layer, so a texture's size is
+  // queried only when the cache misses. The caller syncs it to the theme.
+  absl::Status RenderParallax(const ParallaxRenderBatch& batch,
+                              ParallaxLayoutCache& layouts) const;
   void RenderZoneGizmos(std::span<const ZoneGizmoItem> items) const;
 
  private:
@@ -218,6 +218,7 @@ absl::StatusOr<TileRenderBatch> ComposeLevelTileRenderBatch(
     if (coordinate.x < 0 || coordinate.y < 0) {
       return absl::InvalidArgumentError("level contains a tile chunk with negative coordinates");
     }
+    if (options.only_chunks != nullptr && !options.only_chunks->contains(key)) continue;
 
     const Vec chunk_min{
         static_cast<double>(coordinate.x) * TileChunk::kSize * level.tile_render_width,
@@ -242,7 +243,7 @@ absl::StatusOr<TileRenderBatch> ComposeLevelTileRenderBatch(
   };
   for (const auto& [coordinate, chunk] : visible_chunks) {
     for (int index = 0; index < TileChunk::kSize * TileChunk::kSize; ++index) {
-      const int tile_id = chunk->tiles[index];
+      const int tile_id = chunk->tile(index);
       if (tile_id == 0) continue;
 
       const auto tile = tile_lookup.find(tile_id);
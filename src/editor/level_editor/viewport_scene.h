@@ -6,6 +6,7 @@
 #include <string>
 #include <vector>
 
+#include "absl/container/flat_hash_set.h"
 #include "absl/status/statusor.h"
 #include "editor/level_editor/viewport_model.h"
 #include "engine/texture_handle.h"
@@ -130,6 +131,9 @@ struct TileRenderOptions {
   float overlay_opacity = 0.0f;
   bool show_frame = false;
   bool show_collision = false;
+  // When set, only these chunk keys are composed. The viewport uses it to draw
+  // tile by tile just the chunks whose impostors are not ready yet.
+  const absl::flat_hash_set<int64_t>* only_chunks = nullptr;
 };
 
 // Platform-neutral description of one parallax layer and its managed texture.
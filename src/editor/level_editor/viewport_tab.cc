@@ -37,6 +37,23 @@ const char* ParallaxPreviewModeLabel(ParallaxPreviewMode mode) {
   return "Unknown";
 }
 
+// Moves each item by how far play mode has carried its entity from where it
+// was authored, so the sprite keeps its offset from the entity's position.
+void OffsetToPlayPositions(const WorldLayer& layer,
+                           const absl::flat_hash_map<uint64_t, Vec>& play_positions,
+                           std::vector<EntityRenderItem>& items) {
+  for (EntityRenderItem& item : items) {
+    const auto played = play_positions.find(item.entity_id);
+    const auto authored = layer.entities.find(item.entity_id);
+    if (played == play_positions.end() || authored == layer.entities.end()) continue;
+    const Vec& from = authored->second.transform.position;
+    const double dx = played->second.x - from.x;
+    const double dy = played->second.y - from.y;
+    item.bounds.min = {.x = item.bounds.min.x + dx, .y = item.bounds.min.y + dy};
+    item.bounds.max = {.x = item.bounds.max.x + dx, .y = item.bounds.max.y + dy};
+  }
+}
+
 }  // namespace
 
 absl::StatusOr<Vec> ViewportTab::SnapBlueprintToGrid(Vec mouse_world, const Blueprint& blueprint,
@@ -62,7 +79,9 @@ ViewportTab::ViewportTab(Api& api, GuiInterface* gui, PreviewTextureSink* terrai
           .snap_grid = true,
           .grid_size = static_cast<float>(TileChunk::kSize),
       }),
-      renderer_(canvas_) {
+      renderer_(canvas_),
+      impostor_textures_(api),
+      impostors_(impostor_textures_) {
   camera_ = Camera{};
 }
 
@@ -73,6 +92,8 @@ void ViewportTab::Reset() {
   pending_entity_.reset();
   click_selected_entity_id_.reset();
   delete_requested_entity_id_.reset();
+  impostors_.Clear();
+  file_atlas_ = {};
 }
 
 void ViewportTab::FrameZone(const ParallaxZone& zone) {
@@ -158,7 +179,7 @@ void ViewportTab::HandleFrameZoneShortcut(const Level& level, const ViewportRend
   if (!options.selected_zone_id.has_value() || !canvas_hovered) return;
   if (!gui_->IsKeyPressed(ImGuiKey_F, false)) return;
 
-  const ParallaxZone* zone = FindParallaxZoneById(level.zones, *options.selected_zone_id);
+  const ParallaxZone* zone = zone_index_.Find(level.zones, *options.selected_zone_id);
   if (zone == nullptr) return;
   FrameZone(*zone);
 }
@@ -168,6 +189,7 @@ absl::StatusOr<ViewportTab::RenderedScene> ViewportTab::RenderScene(
     Vec mouse_world, bool mouse_in_level) {
   RenderedScene rendered;
   rendered.placement.interaction_world = mouse_world;
+  absl::Cleanup end_impostor_frame = [this] { impostors_.EndFrame(); };
   ASSIGN_OR_RETURN(rendered.scene.active_zone, RenderParallaxBackground(level, options));
 
   canvas_.DrawGrid();
@@ -184,13 +206,7 @@ absl::StatusOr<ViewportTab::RenderedScene> ViewportTab::RenderScene(
     }
 
     if (active.tileset != nullptr) {
-      ASSIGN_OR_RETURN(
-          TileRenderBatch tile_batch,
-          ComposeLevelTileRenderBatch(level, layer, *active.tileset, active.texture, camera_,
-                                      {.overlay_opacity = options.tile_overlay_opacity,
-                                       .show_frame = options.show_tile_frame,
-                                       .show_collision = options.show_tile_collision}));
-      RETURN_IF_ERROR(renderer_.RenderTiles(tile_batch));
+      RETURN_IF_ERROR(RenderLayerTiles(level, layer, options, active));
     }
 
     ASSIGN_OR_RETURN(std::vector<EntityRenderItem> entity_items,
@@ -198,6 +214,9 @@ absl::StatusOr<ViewportTab::RenderedScene> ViewportTab::RenderScene(
                                               {.selected_entity_id = options.selected_entity_id,
                                                .show_borders = options.show_entity_borders,
                                                .overlay_opacity = options.entity_overlay_opacity}));
+    if (options.play_positions != nullptr) {
+      OffsetToPlayPositions(layer, *options.play_positions, entity_items);
+    }
     for (EntityRenderItem& item : entity_items) {
       if (item.overlay_opacity > 0.0f || item.show_border || item.selected) {
         rendered.scene.entity_overlays.push_back(item);
@@ -226,6 +245,49 @@ absl::StatusOr<ViewportTab::RenderedScene> ViewportTab::RenderScene(
   return rendered;
 }
 
+absl::Status ViewportTab::RenderLayerTiles(const Level& level, const WorldLayer& layer,
+                                           const ViewportRenderOptions& options,
+                                           const ActiveTileset& active) {
+  TileRenderOptions tile_options{.overlay_opacity = options.tile_overlay_opacity,
+                                 .show_frame = options.show_tile_frame,
+                                 .show_collision = options.show_tile_collision};
+
+  // The overlays are drawn per tile, so asking for one means asking for tiles.
+  const bool tile_overlays =
+      options.tile_overlay_opacity > 0.0f || options.show_tile_frame || options.show_tile_collision;
+  const std::optional<int> impostor_level = SelectChunkImpostorLevel(level, camera_);
+  const RgbaImage* atlas = nullptr;
+  if (impostor_level.has_value() && !tile_overlays && active.texture) {
+    atlas = ResolveAtlasPixels(*active.tileset, active.texture, options);
+  }
+
+  ChunkImpostorFrame impostors;
+  if (atlas != nullptr) {
+    ASSIGN_OR_RETURN(impostors, impostors_.Compose(level, layer, *active.tileset, active.texture,
+                                                   *atlas, camera_, *impostor_level));
+    RETURN_IF_ERROR(renderer_.RenderChunkImpostors(impostors.items));
+    if (impostors.pending.empty()) return absl::OkStatus();
+    tile_options.only_chunks = &impostors.pending;
+  }
+
+  ASSIGN_OR_RETURN(TileRenderBatch tile_batch,
+                   ComposeLevelTileRenderBatch(level, layer, *active.tileset, active.texture,
+                                               camera_, tile_options));
+  return renderer_.RenderTiles(tile_batch);
+}
+
+const RgbaImage* ViewportTab::ResolveAtlasPixels(const Tileset& tileset, TextureHandle texture,
+                                                 const ViewportRenderOptions& options) {
+  if (options.tile_atlas_pixels != nullptr) return options.tile_atlas_pixels;
+
+  if (file_atlas_.texture != texture) {
+    absl::StatusOr<RgbaImage> pixels = api_.ReadTexturePixels(tileset.texture_id);
+    file_atlas_ = FileAtlas{.texture = texture};
+    if (pixels.ok()) file_atlas_.pixels = *std::move(pixels);
+  }
+  return file_atlas_.pixels.has_value() ? &*file_atlas_.pixels : nullptr;
+}
+
 absl::StatusOr<ViewportTab::PlacementFrame> ViewportTab::RenderPlacementPreview(
     const Level& level, const WorldLayer& layer, const ViewportRenderOptions& options,
     const ActiveTileset& active, Vec mouse_world, bool mouse_in_level) {
@@ -273,33 +335,49 @@ absl::Status ViewportTab::UpdateInteraction(Level& level, const ViewportRenderOp
     return absl::FailedPreconditionError("active world layer disappeared during viewport frame");
   }
 
-  ASSIGN_OR_RETURN(
-      ViewportInteractionResult result,
-      interaction_.Update(
-          level, *active_layer,
-          {
-              .world_position = placement.interaction_world,
-              .pointer_in_level = mouse_in_level && editing,
-              .primary_pressed = editing && gui_->IsItemClicked(ImGuiMouseButton_Left),
-              .primary_down = editing && interaction_active && io.MouseDown[ImGuiMouseButton_Left],
-              .secondary_pressed = editing && gui_->IsItemClicked(ImGuiMouseButton_Right),
-              .secondary_down =
-                  editing && interaction_active && io.MouseDown[ImGuiMouseButton_Right],
-          },
-          {
-              .paint_terrain_id = options.paint_terrain_id,
-              .paint_shape = options.paint_shape,
-              .terrain_index = options.terrain_index,
-              .terrain_provider = options.terrain_provider,
-              .paint_tile_id = options.placement_tile != nullptr
-                                   ? std::optional<int>(options.placement_tile->id)
-                                   : std::nullopt,
-              .placement_blueprint = options.placement_blueprint,
-              .placement_sprite = placement.sprite.sprite,
-              .selected_entity_id = options.selected_entity_id,
-              .entity_sprites = &scene.entity_sprites,
-              .delete_mode = options.delete_mode,
-          }));
+  const ViewportInteractionInput input = {
+      .world_position = placement.interaction_world,
+      .pointer_in_level = mouse_in_level && editing,
+      .primary_pressed = editing && gui_->IsItemClicked(ImGuiMouseButton_Left),
+      .primary_down = editing && interaction_active && io.MouseDown[ImGuiMouseButton_Left],
+      .secondary_pressed = editing && gui_->IsItemClicked(ImGuiMouseButton_Right),
+      .secondary_down = editing && interaction_active && io.MouseDown[ImGuiMouseButton_Right],
+  };
+  const std::optional<int> paint_tile_id =
+      options.placement_tile != nullptr ? std::optional<int>(options.placement_tile->id)
+                                        : std::nullopt;
+  if (options.recorder != nullptr) {
+    options.recorder->RecordViewport(
+        level, {
+                   .layer_id = active_layer->id,
+                   .input = input,
+                   .paint_terrain_id = options.paint_terrain_id,
+                   .paint_shape = options.paint_shape,
+                   .paint_tile_id = paint_tile_id,
+                   .placement_blueprint_id = options.placement_blueprint != nullptr
+                                                 ? options.placement_blueprint->id
+                                                 : std::string(),
+                   .selected_entity_id = options.selected_entity_id,
+                   .delete_mode = options.delete_mode,
+               });
+  }
+
+  ASSIGN_OR_RETURN(ViewportInteractionResult result,
+                   interaction_.Update(level, *active_layer, input,
+                                       {
+                                           .paint_terrain_id = options.paint_terrain_id,
+                                           .paint_shape = options.paint_shape,
+                                           .terrain_index = options.terrain_index,
+                                           .terrain_provider = options.terrain_provider,
+                                           .paint_tile_id = paint_tile_id,
+                                           .placement_blueprint = options.placement_blueprint,
+                                           .placement_sprite = placement.sprite.sprite,
+                                           .selected_entity_id = options.selected_entity_id,
+                                           .entity_sprites = &scene.entity_sprites,
+                                           .delete_mode = options.delete_mode,
+                                           .journal = options.journal,
+                                           .streamer = options.streamer,
+                                       }));
 
   if (result.placed_entity.has_value()) {
     pending_entity_ = std::move(*result.placed_entity);
@@ -317,7 +395,7 @@ void ViewportTab::RenderStatusBar(const Level& level, const ViewportRenderOption
                                   const SceneFrame& scene, Vec mouse_world, float zoom) {
   const char* active_zone_name = "None";
   if (scene.active_zone.has_value()) {
-    if (const ParallaxZone* zone = FindParallaxZoneById(level.zones, scene.active_zone->zone_id);
+    if (const ParallaxZone* zone = zone_index_.Find(level.zones, scene.active_zone->zone_id);
         zone != nullptr) {
       active_zone_name = zone->name.c_str();
     }
@@ -339,6 +417,7 @@ absl::Status ViewportTab::Render(const ViewportRenderOptions& options) {
   RETURN_IF_ERROR(ValidateRenderOptions(options));
   Level& level = *options.level;
   ReconcileParallaxPreviewMode(options);
+  zone_index_.Sync(level.zones);
 
   auto child = ScopedChild(gui_, "ViewportCanvas", ImVec2(0, 0), false,
                            ImGuiWindowFlags_NoScrollbar | ImGuiWindowFlags_NoScrollWithMouse);
@@ -477,8 +556,7 @@ absl::Status ViewportTab::RenderPlacementGhost(Vec world_pos, const ResolvedSpri
 
 absl::StatusOr<std::optional<ActiveParallaxZone>> ViewportTab::RenderParallaxBackground(
     const Level& level, const ViewportRenderOptions& options) {
-  std::optional<ActiveParallaxZone> active =
-      ResolveActiveParallaxZone(level.zones, camera_.position);
+  std::optional<ActiveParallaxZone> active = zone_index_.Resolve(camera_.position);
 
   std::optional<int> theme_id;
   std::optional<int> layer_index;
@@ -519,7 +597,8 @@ absl::StatusOr<std::optional<ActiveParallaxZone>> ViewportTab::RenderParallaxBac
   ASSIGN_OR_RETURN(ParallaxRenderBatch batch,
                    ComposeParallaxRenderBatch(theme_it->second, camera_, textures,
                                               {.layer_index = layer_index}));
-  RETURN_IF_ERROR(renderer_.RenderParallax(batch));
+  parallax_layouts_.Sync(theme_it->second, layer_index);
+  RETURN_IF_ERROR(renderer_.RenderParallax(batch, parallax_layouts_));
   return active;
 }
 
@@ -4,13 +4,17 @@
 #include <optional>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "api/api.h"
 #include "editor/canvas/canvas.h"
 #include "editor/gui_interface.h"
+#include "editor/level_editor/chunk_impostor.h"
+#include "editor/level_editor/level_journal.h"
 #include "editor/level_editor/parallax_layout.h"
+#include "editor/level_editor/session_recording.h"
 #include "editor/level_editor/viewport_interaction.h"
 #include "editor/level_editor/viewport_renderer.h"
 #include "editor/preview_texture_sink.h"
@@ -21,6 +25,7 @@
 #include "objects/sprite.h"
 #include "objects/tileset.h"
 #include "objects/vec.h"
+#include "resources/level_streamer.h"
 
 namespace zebes {
 
@@ -66,6 +71,15 @@ struct ViewportRenderOptions {
   bool show_entity_borders = false;
   // When true, a right-click on the canvas deletes the entity under the cursor.
   bool delete_mode = false;
+  // Receives each paint stroke and entity drag as one undoable edit. Null
+  // records nothing.
+  LevelJournal* journal = nullptr;
+  // Receives what each frame's interaction acted on, so the session can be
+  // replayed headless. Null records nothing.
+  SessionRecorder* recorder = nullptr;
+  // Streams the level around the camera; new entity IDs must avoid its regions
+  // on disk too. Null for a level held whole.
+  const LevelStreamer* streamer = nullptr;
   // Tile to paint when non-null; nullptr = not in tile-painting mode. It must
   // belong to the level's own tileset, which is the only one a frame resolves:
   // levels store bare tile IDs, so a tile from elsewhere would be stored as
@@ -77,6 +91,10 @@ struct ViewportRenderOptions {
   bool show_tile_collision = false;
   // Blue overlay alpha [0,1] drawn on top of every tile cell. 0 = off.
   float tile_overlay_opacity = 0.0f;
+  // The level tileset's atlas pixels when they live in memory rather than on
+  // disk, as a derived terrain's do while it grows. Null means the tab reads
+  // the atlas file itself. Used only to bake zoomed-out chunk impostors.
+  const RgbaImage* tile_atlas_pixels = nullptr;
   // Yellow overlay alpha [0,1] drawn on top of every entity. 0 = off.
   float entity_overlay_opacity = 0.0f;
   // Zone selected in the editor navigator. Used only for gizmo highlighting
@@ -86,6 +104,10 @@ struct ViewportRenderOptions {
   std::optional<int> selected_parallax_theme_id;
   // Layer selected within selected_parallax_theme_id and available for isolation.
   std::optional<int> selected_parallax_layer_index;
+  // Where play mode has each entity this frame, by entity ID; null outside play
+  // mode. An entity it does not place is drawn where it was authored. Only the
+  // drawing moves: picking still reads the authored level.
+  const absl::flat_hash_map<uint64_t, Vec>* play_positions = nullptr;
 };
 
 class ViewportTab {
@@ -102,6 +124,9 @@ class ViewportTab {
   // Resets the viewport camera and transient interaction state.
   void Reset();
 
+  // The world point at the center of the viewport.
+  Vec camera_position() const { return camera_.position; }
+
   // Requests that the next viewport frame center and fit this zone.
   void FrameZone(const ParallaxZone& zone);
 
@@ -150,6 +175,28 @@ class ViewportTab {
     PlacementFrame placement;
   };
 
+  // Hands impostors to the texture store. They have no definition behind them
+  // and are released as soon as the cache is done with them.
+  class ApiImpostorTextures : public ChunkImpostorTextures {
+   public:
+    explicit ApiImpostorTextures(Api& api) : api_(api) {}
+
+    absl::StatusOr<TextureHandle> Upload(const RgbaImage& image) override {
+      return api_.LoadTransientTexture(image.width, image.height, image.pixels);
+    }
+    void Release(TextureHandle texture) override { api_.UnloadTransientTexture(texture); }
+
+   private:
+    Api& api_;
+  };
+
+  // The atlas file's pixels, read once per texture handle. Empty when the read
+  // failed, so a missing file costs one attempt rather than one per frame.
+  struct FileAtlas {
+    TextureHandle texture;
+    std::optional<RgbaImage> pixels;
+  };
+
   // Rejects option combinations that would render an undefined frame.
   static absl::Status ValidateRenderOptions(const ViewportRenderOptions& options);
 
@@ -167,6 +214,16 @@ class ViewportTab {
                                             const ActiveTileset& active, Vec mouse_world,
                                             bool mouse_in_level);
 
+  // Draws one layer's tiles, as chunk impostors when the camera is far enough
+  // out and tile by tile otherwise.
+  absl::Status RenderLayerTiles(const Level& level, const WorldLayer& layer,
+                                const ViewportRenderOptions& options, const ActiveTileset& active);
+
+  // The CPU copy of the active atlas impostors are baked from, or null when
+  // there is none and the frame should draw tiles instead.
+  const RgbaImage* ResolveAtlasPixels(const Tileset& tileset, TextureHandle texture,
+                                      const ViewportRenderOptions& options);
+
   // Draws whichever preview the current mode calls for, and settles where a
   // click would land.
   absl::StatusOr<PlacementFrame> RenderPlacementPreview(const Level& level, const WorldLayer& layer,
@@ -247,8 +304,15 @@ class ViewportTab {
   Camera camera_;
   ViewportRenderer renderer_;
   ViewportInteractionController interaction_;
+  // Declared before the cache, which releases through it on destruction.
+  ApiImpostorTextures impostor_textures_;
+  ChunkImpostorCache impostors_;
+  FileAtlas file_atlas_;
   bool show_camera_guide_ = true;
   ParallaxPreviewMode parallax_preview_mode_ = ParallaxPreviewMode::kActiveZone;
+  // Synced to the level's zones at the start of every Render.
+  ParallaxZoneIndex zone_index_;
+  ParallaxLayoutCache parallax_layouts_;
   std::optional<VisibleWorldBounds> pending_camera_frame_;
 
   std::optional<Entity> pending_entity_;
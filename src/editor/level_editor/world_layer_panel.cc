@@ -3,6 +3,7 @@
 #include <cstdint>
 #include <memory>
 #include <string>
+#include <utility>
 
 #include "absl/memory/memory.h"
 #include "absl/status/status.h"
@@ -18,14 +19,17 @@ namespace {
 
 int CountTiles(const WorldLayer& layer) {
   int count = 0;
-  for (const auto& entry : layer.tile_chunks) {
-    for (int tile_id : entry.second.tiles) {
-      if (tile_id != 0) ++count;
-    }
-  }
+  for (const auto& entry : layer.tile_chunks) count += entry.second.occupied();
   return count;
 }
 
+int IndexOf(const Level& level, int layer_id) {
+  for (size_t index = 0; index < level.layers.size(); ++index) {
+    if (level.layers[index].id == layer_id) return static_cast<int>(index);
+  }
+  return -1;
+}
+
 }  // namespace
 
 absl::StatusOr<std::unique_ptr<WorldLayerPanel>> WorldLayerPanel::Create(GuiInterface* gui) {
@@ -34,10 +38,22 @@ absl::StatusOr<std::unique_ptr<WorldLayerPanel>> WorldLayerPanel::Create(GuiInte
 }
 
 absl::Status WorldLayerPanel::RenderNavigator(Level& level, WorldLayerModel& model,
-                                              SelectionState& selection) {
+                                              SelectionState& selection, LevelJournal& journal,
+                                              bool editable) {
   model.Reconcile(level);
-  if (gui_->Button("Add World Layer")) {
+  bool add_layer = false;
+  {
+    ScopedDisabled disabled = gui_->CreateScopedDisabled(!editable);
+    add_layer = gui_->Button("Add World Layer");
+  }
+  if (add_layer && editable) {
     ASSIGN_OR_RETURN(const int id, model.AddLayer(level));
+    const int index = IndexOf(level, id);
+    journal.RecordLayer({
+        .kind = LevelJournal::LayerDelta::Kind::kInsert,
+        .index = index,
+        .layer = level.layers[index],
+    });
     selection.Clear();
     selection.type = SelectionState::Type::kWorldLayer;
     selection.world_layer_id = id;
@@ -89,7 +105,8 @@ absl::Status WorldLayerPanel::RenderNavigator(Level& level, WorldLayerModel& mod
 }
 
 absl::Status WorldLayerPanel::RenderDetails(Level& level, WorldLayerModel& model,
-                                            SelectionState& selection) {
+                                            SelectionState& selection, LevelJournal& journal,
+                                            LevelStreamer* streamer) {
   WorldLayer* layer = FindWorldLayer(level, selection.world_layer_id);
   if (layer == nullptr) {
     selection.Clear();
@@ -101,17 +118,32 @@ absl::Status WorldLayerPanel::RenderDetails(Level& level, WorldLayerModel& model
   gui_->InputText("Name", &layer->name);
   gui_->Text("%d painted tile(s), %zu entity(s)", CountTiles(*layer), layer->entities.size());
 
+  const int layer_id = layer->id;
+  const int index = IndexOf(level, layer_id);
   {
-    ScopedDisabled disabled = gui_->CreateScopedDisabled(!model.CanMoveForward(level, layer->id));
-    if (gui_->Button("Move Forward")) RETURN_IF_ERROR(model.MoveForward(level, layer->id));
+    ScopedDisabled disabled = gui_->CreateScopedDisabled(!model.CanMoveForward(level, layer_id));
+    if (gui_->Button("Move Forward")) {
+      RETURN_IF_ERROR(model.MoveForward(level, layer_id));
+      journal.RecordLayer({
+          .kind = LevelJournal::LayerDelta::Kind::kSwap,
+          .index = index,
+          .other_index = index + 1,
+      });
+    }
   }
   gui_->SameLine();
   {
-    ScopedDisabled disabled = gui_->CreateScopedDisabled(!model.CanMoveBackward(level, layer->id));
-    if (gui_->Button("Move Backward")) RETURN_IF_ERROR(model.MoveBackward(level, layer->id));
+    ScopedDisabled disabled = gui_->CreateScopedDisabled(!model.CanMoveBackward(level, layer_id));
+    if (gui_->Button("Move Backward")) {
+      RETURN_IF_ERROR(model.MoveBackward(level, layer_id));
+      journal.RecordLayer({
+          .kind = LevelJournal::LayerDelta::Kind::kSwap,
+          .index = index,
+          .other_index = index - 1,
+      });
+    }
   }
 
-  const int layer_id = layer->id;
   const std::string target = absl::StrCat(layer_id);
   const std::string question =
       absl::StrCat("Delete world layer '", layer->name, "'? This removes ", CountTiles(*layer),
@@ -121,7 +153,14 @@ absl::Status WorldLayerPanel::RenderDetails(Level& level, WorldLayerModel& model
     ScopedStyleColor color =
         gui_->CreateScopedStyleColor(ImGuiCol_Button, ImVec4(0.8f, 0.2f, 0.2f, 1.0f));
     if (delete_prompt_.Render(*gui_, "Delete World Layer", target, question, "WorldLayer")) {
+      if (streamer != nullptr) RETURN_IF_ERROR(streamer->LoadAll());
+      WorldLayer deleted = level.layers[index];
       RETURN_IF_ERROR(model.DeleteLayer(level, layer_id));
+      journal.RecordLayer({
+          .kind = LevelJournal::LayerDelta::Kind::kRemove,
+          .index = index,
+          .layer = std::move(deleted),
+      });
       selection.Clear();
       selection.type = SelectionState::Type::kWorldLayer;
       selection.world_layer_id = model.active_layer_id();
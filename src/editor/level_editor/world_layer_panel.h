@@ -6,9 +6,11 @@
 #include "absl/status/statusor.h"
 #include "editor/confirm_prompt.h"
 #include "editor/gui_interface.h"
+#include "editor/level_editor/level_journal.h"
 #include "editor/level_editor/level_selection_state.h"
 #include "editor/level_editor/world_layer_model.h"
 #include "objects/level.h"
+#include "resources/level_streamer.h"
 
 namespace zebes {
 
@@ -16,8 +18,15 @@ class WorldLayerPanel {
  public:
   static absl::StatusOr<std::unique_ptr<WorldLayerPanel>> Create(GuiInterface* gui);
 
-  absl::Status RenderNavigator(Level& level, WorldLayerModel& model, SelectionState& selection);
-  absl::Status RenderDetails(Level& level, WorldLayerModel& model, SelectionState& selection);
+  // Adding, deleting and reordering layers is recorded in `journal`. Layers
+  // can still be selected, shown and hidden when `editable` is false, but not
+  // added.
+  absl::Status RenderNavigator(Level& level, WorldLayerModel& model, SelectionState& selection,
+                               LevelJournal& journal, bool editable);
+  // A streamed level passes its `streamer`, which loads every region before a
+  // layer is deleted so the deletion takes all of the layer's content.
+  absl::Status RenderDetails(Level& level, WorldLayerModel& model, SelectionState& selection,
+                             LevelJournal& journal, LevelStreamer* streamer);
 
  private:
   explicit WorldLayerPanel(GuiInterface* gui) : gui_(gui) {}
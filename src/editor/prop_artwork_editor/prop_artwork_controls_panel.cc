@@ -196,6 +196,8 @@ bool PropArtworkControlsPanel::RenderPipeline(PropArtworkEditorModel& model) {
   gui_->SetNextItemWidth(kControlWidth);
   changed |= gui_->SliderInt("Minimum subject area##PropArtwork",
                              &pipeline.isolation.minimum_subject_area, 1, 4096);
+  changed |= gui_->Checkbox("Isolate at full resolution##PropArtwork",
+                            &pipeline.working_proxy.full_resolution);
   gui_->SetNextItemWidth(kControlWidth);
   changed |= gui_->SliderInt("Outline width##PropArtwork", &pipeline.edge.width, 0, 4);
   gui_->SetNextItemWidth(kControlWidth);
@@ -46,8 +46,9 @@ absl::StatusOr<std::optional<PropArtworkContextPreview>> BuildContext(
 
 absl::StatusOr<PreparedPropCreationPreview> PrepareCreationPreview(
     SourceArtwork source, RgbaImage source_pixels, PreparePropAssetRequest request,
-    std::optional<TerrainGenConfig> terrain) {
-  ASSIGN_OR_RETURN(PreparedPropAsset prepared, PreparePropAsset(source, source_pixels, request));
+    std::optional<TerrainGenConfig> terrain, PropArtworkPipelineCache* cache) {
+  ASSIGN_OR_RETURN(PreparedPropAsset prepared,
+                   PreparePropAsset(source, source_pixels, request, cache));
   ASSIGN_OR_RETURN(std::optional<PropArtworkContextPreview> context,
                    BuildContext(prepared.artwork.finished, terrain,
                                 request.pipeline.composition.attachment.mode));
@@ -60,10 +61,10 @@ absl::StatusOr<PreparedPropCreationPreview> PrepareCreationPreview(
 absl::StatusOr<PreparedPropRegenerationPreview> PrepareRegenerationPreview(
     SourceArtwork source, RgbaImage source_pixels, PropRecipe recipe, Texture texture,
     RgbaImage texture_pixels, Sprite sprite, PropRegenerationSettings settings,
-    std::optional<TerrainGenConfig> terrain) {
+    std::optional<TerrainGenConfig> terrain, PropArtworkPipelineCache* cache) {
   ASSIGN_OR_RETURN(PreparedPropRegeneration prepared,
                    PreparePropRegeneration(source, source_pixels, recipe, texture, texture_pixels,
-                                           sprite, settings));
+                                           sprite, settings, cache));
   ASSIGN_OR_RETURN(std::optional<PropArtworkContextPreview> context,
                    BuildContext(prepared.artwork.finished, terrain,
                                 settings.pipeline.composition.attachment.mode));
@@ -365,6 +366,7 @@ void PropArtworkEditor::ClearWorkspace() {
     return;
   }
   model_.StartNewRecipe();
+  pipeline_cache_.Clear();
   model_.SetStatus("Prop Artwork workspace cleared. Saved prop bundles were not changed.");
 }
 
@@ -403,9 +405,9 @@ void PropArtworkEditor::StartPreparation() {
     };
     absl::StatusOr<BackgroundTask<PreparedPropCreationPreview>> work =
         BackgroundTask<PreparedPropCreationPreview>::Start(
-            [source, source_pixels, request, terrain]() mutable {
+            [source, source_pixels, request, terrain, cache = &pipeline_cache_]() mutable {
               return PrepareCreationPreview(std::move(source), std::move(source_pixels), request,
-                                            terrain);
+                                            terrain, cache);
             });
     if (!work.ok()) {
       model_.SetStatus(std::string(work.status().message()));
@@ -437,11 +439,11 @@ void PropArtworkEditor::StartPreparation() {
   absl::StatusOr<BackgroundTask<PreparedPropRegenerationPreview>> work =
       BackgroundTask<PreparedPropRegenerationPreview>::Start(
           [source, source_pixels, recipe, texture = **texture,
-           texture_pixels = *std::move(texture_pixels), sprite = **sprite, settings,
-           terrain]() mutable {
+           texture_pixels = *std::move(texture_pixels), sprite = **sprite, settings, terrain,
+           cache = &pipeline_cache_]() mutable {
             return PrepareRegenerationPreview(
                 std::move(source), std::move(source_pixels), std::move(recipe), std::move(texture),
-                std::move(texture_pixels), std::move(sprite), settings, terrain);
+                std::move(texture_pixels), std::move(sprite), settings, terrain, cache);
           });
   if (!work.ok()) {
     model_.SetStatus(std::string(work.status().message()));
@@ -113,6 +113,10 @@ class PropArtworkEditor {
   PropArtworkEditorModel model_;
   std::unique_ptr<PropArtworkControlsPanel> controls_panel_;
   std::unique_ptr<PropArtworkOutputPanel> output_panel_;
+  // Lets reprocessing after a settings change resume at the first stage the
+  // change affects. Declared before pending_work_ so that a running preparation,
+  // which borrows it, finishes before it is destroyed.
+  PropArtworkPipelineCache pipeline_cache_;
   std::variant<std::monostate, PendingImport, PendingCreation, PendingRegeneration> pending_work_;
   // The id of the one generation this editor is waiting for. At most one is in
   // flight: a second prompt would produce two candidate sets with no way to
@@ -300,7 +300,7 @@ void SpriteEditor::RenderSpriteAnimation() {
 
     animation_timer_ += ImGui::GetIO().DeltaTime;
     while (animation_timer_ >= tick_duration) {
-      animator_->Update(frames);
+      animator_->Update();
       animation_timer_ -= tick_duration;
     }
   }
@@ -1,8 +1,10 @@
 #include "editor/terrain_editor/terrain_editor.h"
 
+#include <algorithm>
 #include <fstream>
 #include <sstream>
 #include <utility>
+#include <vector>
 
 #include "absl/cleanup/cleanup.h"
 #include "absl/memory/memory.h"
@@ -34,6 +36,25 @@ absl::StatusOr<std::string> ReadFile(const std::string& path) {
   return contents.str();
 }
 
+std::string RebakeProgress(const std::string& name,
+                           const TerrainRebakeMonitor::Progress& progress) {
+  const char* stage = "Scanning";
+  switch (progress.stage) {
+    case TerrainRebakeMonitor::Stage::kScanning:
+      break;
+    case TerrainRebakeMonitor::Stage::kRendering:
+      stage = "Rendering";
+      break;
+    case TerrainRebakeMonitor::Stage::kWriting:
+    case TerrainRebakeMonitor::Stage::kDone:
+      stage = "Resolving";
+      break;
+  }
+  return absl::StrCat("Rebaking levels that use '", name, "': level ", progress.level + 1, " of ",
+                      std::max(progress.levels, 1), ", ", stage, " ", progress.done, "/",
+                      progress.total, "...");
+}
+
 }  // namespace
 
 TerrainEditor::TerrainEditor(Api* api, GuiInterface* gui, PreviewTextureSink* preview)
@@ -244,9 +265,85 @@ void TerrainEditor::PollTerrainWork() {
     if (saved.ok()) model_.LoadRecipe(**saved);
     model_.SetStatus(
         absl::StrCat("Regenerated '", completed.recipe.name, "' without changing asset IDs."));
+    TerrainRecipe regenerated = completed.recipe;
+    regenerated.config = completed.config;
+    StartLevelRebake(regenerated);
+    return;
+  }
+
+  if (PendingLevelRebake* pending = std::get_if<PendingLevelRebake>(&pending_work_);
+      pending != nullptr) {
+    absl::StatusOr<bool> ready = pending->work.IsReady();
+    if (!ready.ok()) {
+      pending_work_.emplace<std::monostate>();
+      model_.SetStatus(std::string(ready.status().message()));
+      return;
+    }
+    if (!*ready) {
+      model_.SetStatus(RebakeProgress(pending->recipe.name, pending->monitor->progress()));
+      return;
+    }
+
+    PendingLevelRebake completed = std::move(*pending);
+    pending_work_.emplace<std::monostate>();
+    absl::StatusOr<PreparedLevelRebake> prepared = completed.work.TakeResult();
+    if (absl::IsCancelled(prepared.status())) {
+      model_.SetStatus(absl::StrCat("Regenerated '", completed.recipe.name,
+                                    "'. Rebake cancelled; no level was changed."));
+      return;
+    }
+    if (!prepared.ok()) {
+      model_.SetStatus(std::string(prepared.status().message()));
+      return;
+    }
+    const int changed = static_cast<int>(prepared->levels.size());
+    const absl::Status status = CommitLevelRebake(*api_, *std::move(prepared));
+    if (!status.ok()) {
+      model_.SetStatus(std::string(status.message()));
+      return;
+    }
+    model_.SetStatus(absl::StrCat("Regenerated '", completed.recipe.name, "' and rebaked ",
+                                  completed.levels, " level(s) using it; ", changed,
+                                  " changed."));
   }
 }
 
+void TerrainEditor::StartLevelRebake(const TerrainRecipe& recipe) {
+  std::vector<Level> levels = LevelsUsingTileset(*api_, recipe.tileset_id);
+  if (levels.empty()) return;
+
+  absl::StatusOr<Tileset*> tileset = api_->GetTileset(recipe.tileset_id);
+  if (!tileset.ok()) {
+    model_.SetStatus(std::string(tileset.status().message()));
+    return;
+  }
+  absl::StatusOr<RgbaImage> atlas = api_->ReadTexturePixels((*tileset)->texture_id);
+  if (!atlas.ok()) {
+    model_.SetStatus(std::string(atlas.status().message()));
+    return;
+  }
+
+  const int count = static_cast<int>(levels.size());
+  auto monitor = std::make_unique<TerrainRebakeMonitor>();
+  absl::StatusOr<BackgroundTask<PreparedLevelRebake>> work =
+      BackgroundTask<PreparedLevelRebake>::Start(
+          [recipe, tileset = **tileset, atlas = *std::move(atlas), levels = std::move(levels),
+           monitor = monitor.get()]() mutable {
+            return PrepareLevelRebake(recipe, std::move(tileset), std::move(atlas),
+                                      std::move(levels), monitor);
+          });
+  if (!work.ok()) {
+    model_.SetStatus(std::string(work.status().message()));
+    return;
+  }
+  pending_work_.emplace<PendingLevelRebake>(PendingLevelRebake{
+      .recipe = recipe,
+      .levels = count,
+      .monitor = std::move(monitor),
+      .work = *std::move(work),
+  });
+}
+
 void TerrainEditor::OpenRecipe() {
   absl::StatusOr<TerrainRecipe*> recipe = api_->GetTerrainRecipe(model_.recipe_to_open());
   if (!recipe.ok()) {
@@ -328,6 +425,13 @@ absl::Status TerrainEditor::RenderOutput() {
     if (loaded.ok()) textures = *std::move(loaded);
   }
 
+  // The one control that stays live while a rebake runs is the one that stops
+  // it; regenerating is the only thing that starts one.
+  if (PendingLevelRebake* rebake = std::get_if<PendingLevelRebake>(&pending_work_);
+      rebake != nullptr && !rebake->monitor->cancelled()) {
+    if (gui_->Button("Cancel Rebake##TerrainOut")) rebake->monitor->Cancel();
+  }
+
   gui_->BeginDisabled(HasPendingTerrainWork());
   auto output_enabled = absl::MakeCleanup([this] { gui_->EndDisabled(); });
   ASSIGN_OR_RETURN(const TerrainOutputPanel::Action action,
@@ -13,6 +13,7 @@
 #include "editor/preview_texture_sink.h"
 #include "editor/terrain_editor/terrain_controls_panel.h"
 #include "editor/terrain_editor/terrain_editor_model.h"
+#include "editor/terrain_editor/terrain_level_rebake.h"
 #include "editor/terrain_editor/terrain_output_panel.h"
 #include "objects/camera.h"
 
@@ -60,6 +61,10 @@ class TerrainEditor {
   bool HasPendingTerrainWork() const;
   void OpenRecipe();
   void RegenerateTerrain();
+  // Rebakes, in the background, every level painted with the recipe's tileset
+  // against the artwork a regeneration just committed. Does nothing when no
+  // level uses it.
+  void StartLevelRebake(const TerrainRecipe& recipe);
   // Removes the open terrain whole -- recipe, tileset and artwork -- and
   // returns the tab to its empty state, since what it was editing is gone.
   void DeleteTerrain();
@@ -95,9 +100,18 @@ class TerrainEditor {
     BackgroundTask<PreparedTerrainRegeneration> work;
   };
 
+  struct PendingLevelRebake {
+    TerrainRecipe recipe;
+    int levels = 0;
+    // Declared before the task so that it outlives the worker reading it.
+    std::unique_ptr<TerrainRebakeMonitor> monitor;
+    BackgroundTask<PreparedLevelRebake> work;
+  };
+
   // Api is deliberately absent: workers render copied inputs, and
   // PollTerrainWork performs every resource mutation here.
-  std::variant<std::monostate, PendingCreation, PendingRegeneration> pending_work_;
+  std::variant<std::monostate, PendingCreation, PendingRegeneration, PendingLevelRebake>
+      pending_work_;
 };
 
 }  // namespace zebes
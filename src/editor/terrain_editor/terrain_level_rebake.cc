@@ -0,0 +1,88 @@
+#include "editor/terrain_editor/terrain_level_rebake.h"
+
+#include <utility>
+
+#include "absl/strings/str_cat.h"
+#include "common/status_macros.h"
+#include "editor/level_editor/derived_tile_provider.h"
+#include "editor/level_editor/terrain_brush.h"
+#include "terrain/terrain_generator.h"
+
+namespace zebes {
+
+std::vector<Level> LevelsUsingTileset(Api& api, const std::string& tileset_id) {
+  std::vector<Level> levels;
+  for (Level& level : api.GetAllLevels()) {
+    if (level.tileset_id == tileset_id) levels.push_back(std::move(level));
+  }
+  return levels;
+}
+
+absl::StatusOr<PreparedLevelRebake> PrepareLevelRebake(const TerrainRecipe& recipe,
+                                                       Tileset tileset, RgbaImage atlas,
+                                                       std::vector<Level> levels,
+                                                       TerrainRebakeMonitor* monitor) {
+  if (tileset.id != recipe.tileset_id) {
+    return absl::InvalidArgumentError(absl::StrCat("recipe '", recipe.name, "' draws tileset ",
+                                                   recipe.tileset_id, ", not ", tileset.id));
+  }
+
+  PreparedLevelRebake prepared{.source_tileset = tileset,
+                               .levels_scanned = static_cast<int>(levels.size())};
+  // The provider grows this copy in place, so it must stay put until the end.
+  Tileset grown = std::move(tileset);
+  ASSIGN_OR_RETURN(TerrainRenderer renderer, TerrainRenderer::Create(recipe.config));
+  ASSIGN_OR_RETURN(DerivedTileProvider provider,
+                   DerivedTileProvider::Create(std::move(renderer), grown, std::move(atlas)));
+  ASSIGN_OR_RETURN(TerrainIndex index, TerrainIndex::Build(grown));
+
+  const int count = static_cast<int>(levels.size());
+  for (int i = 0; i < count; ++i) {
+    if (monitor != nullptr) monitor->BeginLevel(i, count);
+    Level rebaked = levels[i];
+    const absl::StatusOr<TerrainRebakeStats> stats = RebakeTerrain(
+        rebaked, index, provider, recipe.terrain_id, TerrainRebakeOptions{.monitor = monitor});
+    if (!stats.ok() && !absl::IsCancelled(stats.status())) {
+      return absl::Status(stats.status().code(), absl::StrCat("level '", levels[i].name,
+                                                              "': ", stats.status().message()));
+    }
+    RETURN_IF_ERROR(stats.status());
+    if (stats->rewritten == 0) continue;
+    prepared.cells_rewritten += stats->rewritten;
+    prepared.source_levels.push_back(std::move(levels[i]));
+    prepared.levels.push_back(std::move(rebaked));
+  }
+
+  prepared.appended_tiles = provider.appended_tile_count();
+  prepared.atlas = provider.atlas();
+  prepared.tileset = std::move(grown);
+  return prepared;
+}
+
+absl::Status CommitLevelRebake(Api& api, PreparedLevelRebake prepared) {
+  ASSIGN_OR_RETURN(Tileset * current_tileset, api.GetTileset(prepared.source_tileset.id));
+  if (*current_tileset != prepared.source_tileset) {
+    return absl::FailedPreconditionError(
+        absl::StrCat("tileset '", prepared.source_tileset.name,
+                     "' changed while its levels were rebaking; regenerate again to rebake them"));
+  }
+  for (const Level& source : prepared.source_levels) {
+    ASSIGN_OR_RETURN(Level * current, api.GetLevel(source.id));
+    if (*current != source) {
+      return absl::FailedPreconditionError(
+          absl::StrCat("level '", source.name,
+                       "' was saved while it was rebaking; regenerate again to rebake it"));
+    }
+  }
+
+  if (prepared.appended_tiles > 0) {
+    const RgbaImage& atlas = prepared.atlas;
+    RETURN_IF_ERROR(api.ReplaceTexturePixels(prepared.tileset.texture_id, atlas.width,
+                                             atlas.height, atlas.pixels));
+    RETURN_IF_ERROR(api.UpdateTileset(std::move(prepared.tileset)));
+  }
+  for (Level& level : prepared.levels) RETURN_IF_ERROR(api.UpdateLevel(std::move(level)));
+  return absl::OkStatus();
+}
+
+}  // namespace zebes
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "api/api.h"
+#include "common/image_io.h"
+#include "editor/level_editor/terrain_rebake.h"
+#include "objects/level.h"
+#include "objects/tileset.h"
+#include "terrain/terrain_recipe.h"
+
+namespace zebes {
+
+// Brings every level drawn with a regenerated terrain up to date.
+//
+// Split like PrepareTerrainRegeneration and CommitTerrainRegeneration: the
+// worker rebakes copies and grows its own copy of the atlas, and the editor
+// thread writes the result through Api. Every level shares one provider, so a
+// neighbourhood two levels both need is rendered and appended once.
+struct PreparedLevelRebake {
+  // The definitions the worker started from. Commit refuses if any changed
+  // while it ran, since writing the result would undo that change.
+  Tileset source_tileset;
+  std::vector<Level> source_levels;
+
+  // The tileset and atlas with whatever artwork the rebake appended.
+  Tileset tileset;
+  RgbaImage atlas;
+  int appended_tiles = 0;
+
+  // Only the levels a rebake changed, each beside its entry in source_levels.
+  std::vector<Level> levels;
+  int levels_scanned = 0;
+  int64_t cells_rewritten = 0;
+};
+
+// The levels painted with `tileset_id`, which are the ones a regeneration of its
+// terrain can leave stale.
+std::vector<Level> LevelsUsingTileset(Api& api, const std::string& tileset_id);
+
+// Rebakes `recipe`'s terrain in each level against artwork rendered from the
+// recipe as it now stands. Safe to run on a worker thread.
+//
+// Cancelled when the monitor asks for it before the last level has been
+// written in memory; nothing is prepared in that case, so nothing is committed.
+absl::StatusOr<PreparedLevelRebake> PrepareLevelRebake(const TerrainRecipe& recipe,
+                                                       Tileset tileset, RgbaImage atlas,
+                                                       std::vector<Level> levels,
+                                                       TerrainRebakeMonitor* monitor = nullptr);
+
+// Writes the grown atlas, then the tileset, then every changed level, after
+// checking that none of them changed since the worker took its copies. The
+// order is DerivedTerrainSession::Commit's: a level must never reach disk
+// naming tiles that have not.
+absl::Status CommitLevelRebake(Api& api, PreparedLevelRebake prepared);
+
+}  // namespace zebes
@@ -0,0 +1,293 @@
+#include "objects/collider_geometry.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace zebes {
+namespace {
+
+// Lengths and areas below this are treated as zero. Collider points are
+// authored in pixels, so this is far below anything drawn on purpose.
+constexpr double kEpsilon = 1e-9;
+
+double Cross(const Vec& origin, const Vec& a, const Vec& b) {
+  return (a.x - origin.x) * (b.y - origin.y) - (a.y - origin.y) * (b.x - origin.x);
+}
+
+double SignedArea(const Polygon& polygon) {
+  double area = 0;
+  for (size_t i = 0; i < polygon.size(); ++i) {
+    const Vec& a = polygon[i];
+    const Vec& b = polygon[(i + 1) % polygon.size()];
+    area += a.x * b.y - b.x * a.y;
+  }
+  return area / 2;
+}
+
+// Drops repeated and collinear points, which add edges without adding shape.
+Polygon Simplify(const Polygon& polygon) {
+  Polygon points;
+  for (const Vec& point : polygon) {
+    if (points.empty() || std::abs(point.x - points.back().x) > kEpsilon ||
+        std::abs(point.y - points.back().y) > kEpsilon) {
+      points.push_back(point);
+    }
+  }
+  while (points.size() > 1 && std::abs(points.front().x - points.back().x) <= kEpsilon &&
+         std::abs(points.front().y - points.back().y) <= kEpsilon) {
+    points.pop_back();
+  }
+
+  bool removed = true;
+  while (removed && points.size() >= 3) {
+    removed = false;
+    for (size_t i = 0; i < points.size(); ++i) {
+      const Vec& previous = points[(i + points.size() - 1) % points.size()];
+      const Vec& next = points[(i + 1) % points.size()];
+      if (std::abs(Cross(previous, points[i], next)) <= kEpsilon) {
+        points.erase(points.begin() + static_cast<std::ptrdiff_t>(i));
+        removed = true;
+        break;
+      }
+    }
+  }
+  return points;
+}
+
+// Assumes positive winding.
+bool IsConvex(const Polygon& polygon) {
+  for (size_t i = 0; i < polygon.size(); ++i) {
+    const Vec& a = polygon[i];
+    const Vec& b = polygon[(i + 1) % polygon.size()];
+    const Vec& c = polygon[(i + 2) % polygon.size()];
+    if (Cross(a, b, c) < -kEpsilon) return false;
+  }
+  return true;
+}
+
+bool InsideTriangle(const Vec& a, const Vec& b, const Vec& c, const Vec& point) {
+  return Cross(a, b, point) >= -kEpsilon && Cross(b, c, point) >= -kEpsilon &&
+         Cross(c, a, point) >= -kEpsilon;
+}
+
+// Whether two edges that share no endpoint cross or touch.
+bool SegmentsMeet(const Vec& a, const Vec& b, const Vec& c, const Vec& d) {
+  const double c_side = Cross(a, b, c);
+  const double d_side = Cross(a, b, d);
+  const double a_side = Cross(c, d, a);
+  const double b_side = Cross(c, d, b);
+  return ((c_side <= kEpsilon && d_side >= -kEpsilon) ||
+          (c_side >= -kEpsilon && d_side <= kEpsilon)) &&
+         ((a_side <= kEpsilon && b_side >= -kEpsilon) ||
+          (a_side >= -kEpsilon && b_side <= kEpsilon));
+}
+
+bool IsSimple(const Polygon& polygon) {
+  const size_t size = polygon.size();
+  for (size_t i = 0; i < size; ++i) {
+    // Skip the edge itself and both its neighbours, which share an endpoint.
+    for (size_t j = i + 2; j < size; ++j) {
+      if (i == 0 && j == size - 1) continue;
+      if (SegmentsMeet(polygon[i], polygon[(i + 1) % size], polygon[j],
+                       polygon[(j + 1) % size])) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// Ear clipping over a positively wound simple polygon. Nullopt when no ear can
+// be found, which rounding can cause on nearly degenerate input.
+std::optional<std::vector<Polygon>> Triangulate(Polygon polygon) {
+  std::vector<Polygon> triangles;
+  while (polygon.size() > 3) {
+    bool clipped = false;
+    for (size_t i = 0; i < polygon.size() && !clipped; ++i) {
+      const Vec& a = polygon[(i + polygon.size() - 1) % polygon.size()];
+      const Vec& b = polygon[i];
+      const Vec& c = polygon[(i + 1) % polygon.size()];
+      if (Cross(a, b, c) <= kEpsilon) continue;
+      bool blocked = false;
+      for (const Vec& point : polygon) {
+        if (&point == &a || &point == &b || &point == &c) continue;
+        if (InsideTriangle(a, b, c, point)) {
+          blocked = true;
+          break;
+        }
+      }
+      if (blocked) continue;
+      triangles.push_back({a, b, c});
+      polygon.erase(polygon.begin() + static_cast<std::ptrdiff_t>(i));
+      clipped = true;
+    }
+    if (!clipped) return std::nullopt;
+  }
+  triangles.push_back(std::move(polygon));
+  return triangles;
+}
+
+// Joins pieces that share an edge whenever the union is still convex, so a
+// concave polygon costs a few pieces rather than one per triangle.
+void MergePieces(std::vector<Polygon>& pieces) {
+  bool merged = true;
+  while (merged) {
+    merged = false;
+    for (size_t i = 0; i < pieces.size() && !merged; ++i) {
+      for (size_t j = i + 1; j < pieces.size() && !merged; ++j) {
+        const Polygon& first = pieces[i];
+        const Polygon& second = pieces[j];
+        for (size_t a = 0; a < first.size() && !merged; ++a) {
+          const Vec& from = first[a];
+          const Vec& to = first[(a + 1) % first.size()];
+          // A shared edge runs the other way round the neighbour.
+          for (size_t b = 0; b < second.size(); ++b) {
+            if (second[b] != to || second[(b + 1) % second.size()] != from) continue;
+            Polygon joined;
+            for (size_t k = 0; k < first.size(); ++k) {
+              joined.push_back(first[(a + 1 + k) % first.size()]);
+            }
+            for (size_t k = 2; k < second.size(); ++k) {
+              joined.push_back(second[(b + k) % second.size()]);
+            }
+            joined = Simplify(joined);
+            if (!IsConvex(joined)) break;
+            pieces[i] = std::move(joined);
+            pieces.erase(pieces.begin() + static_cast<std::ptrdiff_t>(j));
+            merged = true;
+            break;
+          }
+        }
+      }
+    }
+  }
+}
+
+// Andrew's monotone chain, positively wound.
+Polygon ConvexHull(Polygon points) {
+  std::sort(points.begin(), points.end());
+  if (points.size() < 3) return points;
+  Polygon hull(points.size() * 2);
+  size_t size = 0;
+  for (const Vec& point : points) {
+    while (size >= 2 && Cross(hull[size - 2], hull[size - 1], point) <= 0) --size;
+    hull[size++] = point;
+  }
+  const size_t lower = size + 1;
+  for (size_t i = points.size() - 1; i-- > 0;) {
+    while (size >= lower && Cross(hull[size - 2], hull[size - 1], points[i]) <= 0) --size;
+    hull[size++] = points[i];
+  }
+  hull.resize(size - 1);
+  return hull;
+}
+
+ColliderBounds BoundsOf(const Polygon& polygon) {
+  ColliderBounds bounds{
+      .min = {.x = std::numeric_limits<double>::infinity(),
+              .y = std::numeric_limits<double>::infinity()},
+      .max = {.x = -std::numeric_limits<double>::infinity(),
+              .y = -std::numeric_limits<double>::infinity()},
+  };
+  for (const Vec& point : polygon) {
+    bounds.min.x = std::min(bounds.min.x, point.x);
+    bounds.min.y = std::min(bounds.min.y, point.y);
+    bounds.max.x = std::max(bounds.max.x, point.x);
+    bounds.max.y = std::max(bounds.max.y, point.y);
+  }
+  return bounds;
+}
+
+// True when some edge normal of `a` separates the two pieces, each shifted by
+// its own offset. Touching counts as separated.
+bool HasSeparatingEdge(const Polygon& a, Vec offset_a, const Polygon& b, Vec offset_b) {
+  for (size_t i = 0; i < a.size(); ++i) {
+    const Vec& from = a[i];
+    const Vec& to = a[(i + 1) % a.size()];
+    const double axis_x = to.y - from.y;
+    const double axis_y = from.x - to.x;
+    double a_min = std::numeric_limits<double>::infinity();
+    double a_max = -a_min;
+    for (const Vec& point : a) {
+      const double projection = axis_x * (point.x + offset_a.x) + axis_y * (point.y + offset_a.y);
+      a_min = std::min(a_min, projection);
+      a_max = std::max(a_max, projection);
+    }
+    double b_min = std::numeric_limits<double>::infinity();
+    double b_max = -b_min;
+    for (const Vec& point : b) {
+      const double projection = axis_x * (point.x + offset_b.x) + axis_y * (point.y + offset_b.y);
+      b_min = std::min(b_min, projection);
+      b_max = std::max(b_max, projection);
+    }
+    if (a_max <= b_min || b_max <= a_min) return true;
+  }
+  return false;
+}
+
+}  // namespace
+
+ColliderGeometry BuildColliderGeometry(const Collider& collider) {
+  ColliderGeometry geometry;
+  for (const Polygon& authored : collider.polygons) {
+    Polygon polygon = Simplify(authored);
+    if (polygon.size() < 3) continue;
+    const double area = SignedArea(polygon);
+    if (area < 0) std::reverse(polygon.begin(), polygon.end());
+
+    // A polygon that crosses itself can have any signed area, zero included,
+    // so only a simple one is taken at its word.
+    std::vector<Polygon> pieces;
+    const bool simple = std::abs(area) > kEpsilon && IsSimple(polygon);
+    if (simple && IsConvex(polygon)) {
+      pieces.push_back(std::move(polygon));
+    } else if (std::optional<std::vector<Polygon>> triangles =
+                   simple ? Triangulate(polygon) : std::nullopt) {
+      pieces = *std::move(triangles);
+      MergePieces(pieces);
+    } else {
+      Polygon hull = ConvexHull(std::move(polygon));
+      if (hull.size() < 3 || SignedArea(hull) <= kEpsilon) continue;
+      pieces.push_back(std::move(hull));
+    }
+
+    for (Polygon& piece : pieces) {
+      const ColliderBounds bounds = BoundsOf(piece);
+      geometry.pieces.push_back(ConvexPiece{.points = std::move(piece), .bounds = bounds});
+    }
+  }
+
+  if (!geometry.pieces.empty()) {
+    geometry.bounds = geometry.pieces.front().bounds;
+    for (const ConvexPiece& piece : geometry.pieces) {
+      geometry.bounds.min.x = std::min(geometry.bounds.min.x, piece.bounds.min.x);
+      geometry.bounds.min.y = std::min(geometry.bounds.min.y, piece.bounds.min.y);
+      geometry.bounds.max.x = std::max(geometry.bounds.max.x, piece.bounds.max.x);
+      geometry.bounds.max.y = std::max(geometry.bounds.max.y, piece.bounds.max.y);
+    }
+  }
+  return geometry;
+}
+
+bool ColliderGeometriesOverlap(const ColliderGeometry& a, Vec position_a,
+                               const ColliderGeometry& b, Vec position_b) {
+  if (a.empty() || b.empty()) return false;
+  if (!a.bounds.Translated(position_a).Overlaps(b.bounds.Translated(position_b))) return false;
+  for (const ConvexPiece& piece_a : a.pieces) {
+    const ColliderBounds bounds_a = piece_a.bounds.Translated(position_a);
+    for (const ConvexPiece& piece_b : b.pieces) {
+      if (!bounds_a.Overlaps(piece_b.bounds.Translated(position_b))) continue;
+      if (HasSeparatingEdge(piece_a.points, position_a, piece_b.points, position_b)) continue;
+      if (HasSeparatingEdge(piece_b.points, position_b, piece_a.points, position_a)) continue;
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace zebes
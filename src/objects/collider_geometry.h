@@ -0,0 +1,58 @@
+#pragma once
+
+#include <vector>
+
+#include "objects/collider.h"
+#include "objects/vec.h"
+
+namespace zebes {
+
+// An axis-aligned box. Boxes that only touch do not overlap, so two colliders
+// resting against each other are not reported as colliding.
+struct ColliderBounds {
+  Vec min;
+  Vec max;
+
+  bool Overlaps(const ColliderBounds& other) const {
+    return min.x < other.max.x && other.min.x < max.x && min.y < other.max.y &&
+           other.min.y < max.y;
+  }
+
+  ColliderBounds Translated(Vec offset) const {
+    return {.min = {.x = min.x + offset.x, .y = min.y + offset.y},
+            .max = {.x = max.x + offset.x, .y = max.y + offset.y}};
+  }
+};
+
+// One convex polygon with its bounds. Points wind so the shoelace area is
+// positive, which with y pointing down is clockwise on screen.
+struct ConvexPiece {
+  Polygon points;
+  ColliderBounds bounds;
+};
+
+// What a Collider is as a solid, derived once when it is loaded so that no
+// collision test has to look at its authored polygons again.
+//
+// Collider asks for convex polygons, but nothing enforces it, and the editor
+// happily produces a concave one mid-edit. Concave polygons are therefore split
+// into convex pieces rather than trusted, and a polygon too tangled to split
+// stands in as its convex hull, which may overreport but never misses.
+// Polygons with no area are dropped.
+struct ColliderGeometry {
+  // Bounds of every piece, relative to the entity's position. Only meaningful
+  // when there are pieces.
+  ColliderBounds bounds;
+  std::vector<ConvexPiece> pieces;
+
+  bool empty() const { return pieces.empty(); }
+};
+
+ColliderGeometry BuildColliderGeometry(const Collider& collider);
+
+// Narrow phase: whether two placed colliders overlap by more than touching,
+// by the separating-axis theorem over every pair of pieces whose bounds meet.
+bool ColliderGeometriesOverlap(const ColliderGeometry& a, Vec position_a,
+                               const ColliderGeometry& b, Vec position_b);
+
+}  // namespace zebes
@@ -102,14 +102,14 @@ absl::Status ValidateWorldLayers(const Level& level) {
         return absl::InvalidArgumentError(absl::StrCat(
             "World layer '", layer.name, "' contains a tile chunk with negative coordinates."));
       }
-      const TileChunk& chunk = entry.second;
-      for (int index = 0; index < static_cast<int>(chunk.tiles.size()); ++index) {
-        const int tile_id = chunk.tiles[index];
+      absl::Status cells = absl::OkStatus();
+      entry.second.ForEachTile([&](int index, int tile_id) {
+        if (!cells.ok()) return;
         if (tile_id < 0) {
-          return absl::InvalidArgumentError(
+          cells = absl::InvalidArgumentError(
               absl::StrCat("World layer '", layer.name, "' contains a negative tile ID."));
+          return;
         }
-        if (tile_id == 0) continue;
 
         const int64_t tile_x =
             static_cast<int64_t>(coordinate.x) * TileChunk::kSize + index % TileChunk::kSize;
@@ -117,10 +117,11 @@ absl::Status ValidateWorldLayers(const Level& level) {
             static_cast<int64_t>(coordinate.y) * TileChunk::kSize + index / TileChunk::kSize;
         if (static_cast<double>(tile_x + 1) * level.tile_render_width > level.width ||
             static_cast<double>(tile_y + 1) * level.tile_render_height > level.height) {
-          return absl::InvalidArgumentError(absl::StrCat(
+          cells = absl::InvalidArgumentError(absl::StrCat(
               "World layer '", layer.name, "' contains a tile outside level boundaries."));
         }
-      }
+      });
+      RETURN_IF_ERROR(cells);
     }
 
     for (const auto& [entity_id, entity] : layer.entities) {
@@ -10,19 +10,10 @@
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "objects/entity.h"
+#include "objects/tile_chunk.h"
 
 namespace zebes {
 
-// Definition of a Tile Chunk (Optimized Storage)
-struct TileChunk {
-  static constexpr int kSize = 32;
-  // Zero-initialized: zero means "no tile", so a default-constructed chunk has
-  // to read as empty rather than as whatever the memory held.
-  std::array<int, kSize * kSize> tiles{};
-
-  bool operator==(const TileChunk& other) const = default;
-};
-
 // Definition of Parallax Layer (Visuals)
 struct ParallaxLayer {
   std::string name;
@@ -0,0 +1,270 @@
+#include "objects/level_region.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <utility>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/str_cat.h"
+#include "common/status_macros.h"
+#include "objects/level_state_hash.h"
+
+namespace zebes {
+namespace {
+
+// Per-entry overhead of the containers a region's content is installed into:
+// one control byte per flat_hash_map slot, and the links and colour of a
+// std::map node.
+constexpr size_t kChunkEntryOverhead = 1;
+constexpr size_t kEntityNodeOverhead = 4 * sizeof(void*);
+
+int FloorDivide(int value, int divisor) {
+  const int64_t wide = value;
+  const int64_t quotient = wide >= 0 ? wide / divisor : -((-wide - 1) / divisor) - 1;
+  return static_cast<int>(quotient);
+}
+
+// Floors a coordinate already divided into regions, saturating so that a point
+// far outside the level still names some region rather than overflowing.
+int RegionIndex(double scaled) {
+  if (std::isnan(scaled)) return 0;
+  const double floored = std::floor(scaled);
+  if (floored <= std::numeric_limits<int>::min()) return std::numeric_limits<int>::min();
+  if (floored >= std::numeric_limits<int>::max()) return std::numeric_limits<int>::max();
+  return static_cast<int>(floored);
+}
+
+// The keys of a layer's chunks that lie in one region, empty ones included.
+// Looks each of the region's chunk positions up, or walks the layer when it
+// holds fewer chunks than a region has positions.
+std::vector<int64_t> ChunkKeysIn(const WorldLayer& layer, LevelRegionCoordinate coordinate,
+                                 int region_chunks) {
+  std::vector<int64_t> keys;
+  const size_t positions = static_cast<size_t>(region_chunks) * region_chunks;
+  if (layer.tile_chunks.size() < positions) {
+    for (const auto& [key, chunk] : layer.tile_chunks) {
+      if (RegionOfChunk(DecodeChunkKey(key), region_chunks) == coordinate) keys.push_back(key);
+    }
+    return keys;
+  }
+
+  const int64_t first_x = int64_t{coordinate.x} * region_chunks;
+  const int64_t first_y = int64_t{coordinate.y} * region_chunks;
+  for (int64_t y = first_y; y < first_y + region_chunks; ++y) {
+    if (y < std::numeric_limits<int>::min() || y > std::numeric_limits<int>::max()) continue;
+    for (int64_t x = first_x; x < first_x + region_chunks; ++x) {
+      if (x < std::numeric_limits<int>::min() || x > std::numeric_limits<int>::max()) continue;
+      const int64_t key = ChunkKey(static_cast<int>(x), static_cast<int>(y));
+      if (layer.tile_chunks.contains(key)) keys.push_back(key);
+    }
+  }
+  return keys;
+}
+
+std::vector<uint64_t> EntityIdsIn(const Level& level, const WorldLayer& layer,
+                                  LevelRegionCoordinate coordinate, int region_chunks) {
+  std::vector<uint64_t> ids;
+  for (const auto& [id, entity] : layer.entities) {
+    if (RegionOfPoint(level, entity.transform.position, region_chunks) == coordinate) {
+      ids.push_back(id);
+    }
+  }
+  return ids;
+}
+
+// The region's copy of `layer_id`, added after the ones already there. Content
+// is gathered one level layer at a time, so the copy for a layer is always the
+// last one if it exists at all.
+WorldLayer& RegionLayer(LevelRegion& region, int layer_id) {
+  if (region.layers.empty() || region.layers.back().id != layer_id) {
+    region.layers.push_back(WorldLayer{.id = layer_id});
+  }
+  return region.layers.back();
+}
+
+}  // namespace
+
+LevelRegionCoordinate RegionOfChunk(TileChunkCoordinate chunk, int region_chunks) {
+  return {
+      .x = FloorDivide(chunk.x, region_chunks),
+      .y = FloorDivide(chunk.y, region_chunks),
+  };
+}
+
+LevelRegionCoordinate RegionOfPoint(const Level& level, Vec point, int region_chunks) {
+  const double span = static_cast<double>(region_chunks) * TileChunk::kSize;
+  return {
+      .x = RegionIndex(point.x / (span * level.tile_render_width)),
+      .y = RegionIndex(point.y / (span * level.tile_render_height)),
+  };
+}
+
+int RegionDistance(LevelRegionCoordinate center, LevelRegionCoordinate region) {
+  const int64_t dx = std::abs(int64_t{region.x} - center.x);
+  const int64_t dy = std::abs(int64_t{region.y} - center.y);
+  return static_cast<int>(
+      std::min<int64_t>(std::max(dx, dy), std::numeric_limits<int>::max()));
+}
+
+size_t LevelRegion::EstimatedBytes() const {
+  size_t bytes = 0;
+  for (const WorldLayer& layer : layers) {
+    for (const auto& [key, chunk] : layer.tile_chunks) {
+      bytes += sizeof(std::pair<const int64_t, TileChunk>) + kChunkEntryOverhead +
+               chunk.heap_bytes();
+    }
+    bytes += layer.entities.size() *
+             (sizeof(std::pair<const uint64_t, Entity>) + kEntityNodeOverhead);
+  }
+  return bytes;
+}
+
+uint64_t LevelRegionStateHash(const LevelRegion& region) {
+  StateHasher hasher;
+  hasher.Add(region.coordinate.x);
+  hasher.Add(region.coordinate.y);
+  hasher.Add(region.layers.size());
+  for (const WorldLayer& layer : region.layers) HashWorldLayer(layer, hasher);
+  return hasher.hash();
+}
+
+LevelRegion CopyRegion(const Level& level, LevelRegionCoordinate coordinate, int region_chunks) {
+  LevelRegion region{.coordinate = coordinate};
+  for (const WorldLayer& layer : level.layers) {
+    for (const int64_t key : ChunkKeysIn(layer, coordinate, region_chunks)) {
+      const TileChunk& chunk = layer.tile_chunks.at(key);
+      if (!chunk.empty()) RegionLayer(region, layer.id).tile_chunks.emplace(key, chunk);
+    }
+    for (const uint64_t id : EntityIdsIn(level, layer, coordinate, region_chunks)) {
+      RegionLayer(region, layer.id).entities.emplace(id, layer.entities.at(id));
+    }
+  }
+  return region;
+}
+
+LevelRegion TakeRegion(Level& level, LevelRegionCoordinate coordinate, int region_chunks) {
+  LevelRegion region{.coordinate = coordinate};
+  for (WorldLayer& layer : level.layers) {
+    for (const int64_t key : ChunkKeysIn(layer, coordinate, region_chunks)) {
+      auto node = layer.tile_chunks.extract(key);
+      if (node.mapped().empty()) continue;
+      RegionLayer(region, layer.id).tile_chunks.insert(std::move(node));
+    }
+    for (const uint64_t id : EntityIdsIn(level, layer, coordinate, region_chunks)) {
+      RegionLayer(region, layer.id).entities.insert(layer.entities.extract(id));
+    }
+  }
+  return region;
+}
+
+absl::Status CheckRegionInstall(const Level& level, const LevelRegion& region) {
+  for (const WorldLayer& content : region.layers) {
+    const WorldLayer* layer = FindWorldLayer(level, content.id);
+    if (layer == nullptr) {
+      return absl::FailedPreconditionError(
+          absl::StrCat("Region (", region.coordinate.x, ", ", region.coordinate.y,
+                       ") holds content for world layer ", content.id,
+                       ", which the level does not have"));
+    }
+    for (const auto& [key, chunk] : content.tile_chunks) {
+      const auto held = layer->tile_chunks.find(key);
+      if (held == layer->tile_chunks.end()) continue;
+      int conflict = -1;
+      chunk.ForEachTile([&](int index, int tile_id) {
+        const int existing = held->second.tile(index);
+        if (conflict < 0 && existing != 0 && existing != tile_id) conflict = index;
+      });
+      if (conflict < 0) continue;
+      const TileChunkCoordinate coordinate = DecodeChunkKey(key);
+      return absl::FailedPreconditionError(absl::StrCat(
+          "Region (", region.coordinate.x, ", ", region.coordinate.y, ") paints cell ",
+          conflict, " of chunk (", coordinate.x, ", ", coordinate.y, ") on layer ", content.id,
+          " with tile ", chunk.tile(conflict), ", but the level already holds tile ",
+          held->second.tile(conflict), " there"));
+    }
+    for (const auto& [id, entity] : content.entities) {
+      const WorldLayer* holder = FindEntityLayer(level, id);
+      if (holder == nullptr) continue;
+      if (holder->id == content.id && holder->entities.at(id) == entity) continue;
+      return absl::FailedPreconditionError(
+          absl::StrCat("Region (", region.coordinate.x, ", ", region.coordinate.y,
+                       ") holds entity ", id, ", but the level already has another entity ",
+                       "with that ID"));
+    }
+  }
+  return absl::OkStatus();
+}
+
+absl::Status InstallRegion(Level& level, LevelRegion region) {
+  // Everything is checked before anything moves, so a refused region leaves the
+  // level as it was.
+  RETURN_IF_ERROR(CheckRegionInstall(level, region));
+
+  for (WorldLayer& content : region.layers) {
+    WorldLayer* layer = FindWorldLayer(level, content.id);
+    for (auto& [key, chunk] : content.tile_chunks) {
+      const auto [held, inserted] = layer->tile_chunks.try_emplace(key, std::move(chunk));
+      if (inserted) continue;
+      // Only cells the level leaves empty are written; the rest already match.
+      chunk.ForEachTile([&](int index, int tile_id) {
+        if (held->second.tile(index) == 0) held->second.SetTile(index, tile_id);
+      });
+    }
+    for (auto& [id, entity] : content.entities) {
+      if (FindEntity(level, id) != nullptr) continue;
+      layer->entities.emplace(id, std::move(entity));
+    }
+  }
+  return absl::OkStatus();
+}
+
+std::vector<LevelRegion> TakeAllRegions(Level& level, int region_chunks) {
+  absl::flat_hash_map<LevelRegionCoordinate, LevelRegion> regions;
+  auto region_at = [&](LevelRegionCoordinate coordinate) -> LevelRegion& {
+    LevelRegion& region = regions[coordinate];
+    region.coordinate = coordinate;
+    return region;
+  };
+
+  for (WorldLayer& layer : level.layers) {
+    for (auto& [key, chunk] : layer.tile_chunks) {
+      if (chunk.empty()) continue;
+      LevelRegion& region = region_at(RegionOfChunk(DecodeChunkKey(key), region_chunks));
+      RegionLayer(region, layer.id).tile_chunks.emplace(key, std::move(chunk));
+    }
+    layer.tile_chunks.clear();
+    for (auto& [id, entity] : layer.entities) {
+      LevelRegion& region = region_at(RegionOfPoint(level, entity.transform.position,
+                                                    region_chunks));
+      RegionLayer(region, layer.id).entities.emplace(id, std::move(entity));
+    }
+    layer.entities.clear();
+  }
+
+  std::vector<LevelRegion> sorted;
+  sorted.reserve(regions.size());
+  for (auto& [coordinate, region] : regions) sorted.push_back(std::move(region));
+  std::sort(sorted.begin(), sorted.end(), [](const LevelRegion& a, const LevelRegion& b) {
+    return a.coordinate < b.coordinate;
+  });
+  return sorted;
+}
+
+absl::flat_hash_set<LevelRegionCoordinate> OccupiedRegions(const Level& level, int region_chunks) {
+  absl::flat_hash_set<LevelRegionCoordinate> regions;
+  for (const WorldLayer& layer : level.layers) {
+    for (const auto& [key, chunk] : layer.tile_chunks) {
+      if (chunk.empty()) continue;
+      regions.insert(RegionOfChunk(DecodeChunkKey(key), region_chunks));
+    }
+    for (const auto& [id, entity] : layer.entities) {
+      regions.insert(RegionOfPoint(level, entity.transform.position, region_chunks));
+    }
+  }
+  return regions;
+}
+
+}  // namespace zebes
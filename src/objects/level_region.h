@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_format.h"
+#include "objects/level.h"
+#include "objects/vec.h"
+
+namespace zebes {
+
+// Chunks along each side of a region unless a region store says otherwise: 256
+// tiles square, a few screens at the default tile size.
+inline constexpr int kDefaultRegionChunks = 8;
+
+// Identifies one square block of region_chunks x region_chunks tile chunks,
+// the unit a streamed level is stored, loaded and evicted in. Regions are
+// addressed like chunks, so region (0, 0) starts at the world origin.
+struct LevelRegionCoordinate {
+  int x = 0;
+  int y = 0;
+
+  bool operator==(const LevelRegionCoordinate& other) const = default;
+
+  constexpr bool operator<(const LevelRegionCoordinate& other) const {
+    if (y != other.y) return y < other.y;
+    return x < other.x;
+  }
+
+  template <typename H>
+  friend H AbslHashValue(H h, const LevelRegionCoordinate& coordinate) {
+    return H::combine(std::move(h), coordinate.x, coordinate.y);
+  }
+
+  template <typename Sink>
+  friend void AbslStringify(Sink& sink, const LevelRegionCoordinate& coordinate) {
+    absl::Format(&sink, "(%d, %d)", coordinate.x, coordinate.y);
+  }
+};
+
+LevelRegionCoordinate RegionOfChunk(TileChunkCoordinate chunk, int region_chunks);
+// The region a world-space point, such as an entity's position, falls in.
+LevelRegionCoordinate RegionOfPoint(const Level& level, Vec point, int region_chunks);
+
+// Chebyshev distance in regions: the ring around `center` that `region` lies on.
+int RegionDistance(LevelRegionCoordinate center, LevelRegionCoordinate region);
+
+// The part of a level's world content that lies in one region.
+//
+// A tile chunk belongs to the region containing it and an entity to the region
+// containing its position, so every piece of content has exactly one region
+// and moving an entity may move it between regions. Layers are listed in level
+// order, only when they hold something here, and carry just the ID of the
+// level layer they belong to. Empty chunks read the same as missing ones and
+// are never part of a region.
+struct LevelRegion {
+  LevelRegionCoordinate coordinate;
+  std::vector<WorldLayer> layers;
+
+  bool empty() const { return layers.empty(); }
+
+  // Roughly what the content occupies once installed in a level: chunk cells
+  // plus the per-entry bookkeeping of the containers holding them.
+  size_t EstimatedBytes() const;
+
+  bool operator==(const LevelRegion& other) const = default;
+};
+
+// A digest of a region's content, for noticing that it changed without keeping
+// a copy to compare with. Regions holding the same content hash equal.
+uint64_t LevelRegionStateHash(const LevelRegion& region);
+
+// Copies one region's content out of a level, leaving the level untouched.
+LevelRegion CopyRegion(const Level& level, LevelRegionCoordinate coordinate, int region_chunks);
+
+// Removes one region's content from a level and returns it.
+LevelRegion TakeRegion(Level& level, LevelRegionCoordinate coordinate, int region_chunks);
+
+// Whether InstallRegion would take `region`: FailedPrecondition naming the
+// cell, entity or layer in the way when it would not.
+absl::Status CheckRegionInstall(const Level& level, const LevelRegion& region);
+
+// Puts a region's content back into a level, merging it with whatever the level
+// already holds there. A chunk the level already has takes the region's tiles
+// in the cells it leaves empty, and an entity the level already holds
+// unchanged is kept once.
+//
+// Fails, installing nothing, when the region would overwrite a different tile
+// in a cell, reuse an entity ID the level gives to another entity, or holds
+// content for a layer the level does not have: either way one side's content
+// would be lost, or the level-wide entity-ID invariant broken.
+absl::Status InstallRegion(Level& level, LevelRegion region);
+
+// Removes all world content from a level, leaving its layers empty, and
+// returns it as the non-empty regions it spans, in coordinate order.
+std::vector<LevelRegion> TakeAllRegions(Level& level, int region_chunks);
+
+// Every region the level currently holds some content in.
+absl::flat_hash_set<LevelRegionCoordinate> OccupiedRegions(const Level& level, int region_chunks);
+
+}  // namespace zebes
@@ -0,0 +1,52 @@
+#include "objects/level_state_hash.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace zebes {
+namespace {
+
+void HashEntity(const Entity& entity, StateHasher& hasher) {
+  hasher.Add(entity.id);
+  hasher.Add(entity.active);
+  hasher.Add(entity.transform.position.x);
+  hasher.Add(entity.transform.position.y);
+  hasher.Add(entity.transform.rotation);
+  hasher.Add(entity.body.drag.x);
+  hasher.Add(entity.body.drag.y);
+  hasher.Add(entity.body.mass);
+  hasher.Add(entity.body.is_static);
+  hasher.Add(entity.sort_order);
+  hasher.Add(entity.blueprint_id);
+  hasher.Add(entity.blueprint_state_index);
+  hasher.Add(entity.sprite_id);
+  hasher.Add(entity.collider_id);
+}
+
+}  // namespace
+
+void HashWorldLayer(const WorldLayer& layer, StateHasher& hasher) {
+  hasher.Add(layer.id);
+  hasher.Add(layer.name);
+
+  // The map's order depends on its history; the tiles it holds do not.
+  std::vector<int64_t> keys;
+  keys.reserve(layer.tile_chunks.size());
+  for (const auto& [key, chunk] : layer.tile_chunks) {
+    if (!chunk.empty()) keys.push_back(key);
+  }
+  std::sort(keys.begin(), keys.end());
+  hasher.Add(keys.size());
+  for (int64_t key : keys) {
+    hasher.Add(key);
+    layer.tile_chunks.at(key).ForEachTile([&hasher](int index, int tile_id) {
+      hasher.Add(index);
+      hasher.Add(tile_id);
+    });
+  }
+
+  hasher.Add(layer.entities.size());
+  for (const auto& [id, entity] : layer.entities) HashEntity(entity, hasher);
+}
+
+}  // namespace zebes
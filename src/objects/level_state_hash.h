@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+#include "objects/level.h"
+
+namespace zebes {
+
+// FNV-1a, chosen over absl::Hash because that one is seeded per process: a
+// state hash is compared across runs and builds, not just within one.
+class StateHasher {
+ public:
+  template <typename T>
+  void Add(const T& value) {
+    static_assert(std::is_arithmetic_v<T>);
+    unsigned char bytes[sizeof(T)];
+    std::memcpy(bytes, &value, sizeof(T));
+    for (unsigned char byte : bytes) Mix(byte);
+  }
+
+  void Add(const std::string& value) {
+    Add(value.size());
+    for (char c : value) Mix(static_cast<unsigned char>(c));
+  }
+
+  uint64_t hash() const { return hash_; }
+
+ private:
+  void Mix(unsigned char byte) {
+    hash_ ^= byte;
+    hash_ *= 0x100000001b3ull;
+  }
+
+  uint64_t hash_ = 0xcbf29ce484222325ull;
+};
+
+// Adds everything an edit can change in one layer: its ID and name, its tiles,
+// and every authored field of its entities. Layers holding the same tiles hash
+// equal, whatever order their chunks were created in.
+void HashWorldLayer(const WorldLayer& layer, StateHasher& hasher);
+
+}  // namespace zebes
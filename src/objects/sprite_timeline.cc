@@ -0,0 +1,51 @@
+#include "objects/sprite_timeline.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+
+namespace zebes {
+
+SpriteTimeline::SpriteTimeline(absl::Span<const SpriteFrame> frames)
+    : frame_count_(static_cast<int>(frames.size())) {
+  if (frames.empty()) return;
+  size_t padded = 1;
+  while (padded < frames.size()) padded *= 2;
+  frame_ends_.assign(padded, std::numeric_limits<int64_t>::max());
+  for (size_t i = 0; i < frames.size(); ++i) {
+    cycle_ticks_ += std::max(1, frames[i].frames_per_cycle);
+    frame_ends_[i] = cycle_ticks_;
+  }
+}
+
+int SpriteTimeline::FrameIndexInCycle(int64_t tick) const {
+  // Counts the frames that have ended by `tick`, which is the index of the one
+  // still showing.
+  size_t index = 0;
+  for (size_t step = frame_ends_.size() / 2; step > 0; step /= 2) {
+    if (frame_ends_[index + step - 1] <= tick) index += step;
+  }
+  return static_cast<int>(index);
+}
+
+int SpriteTimeline::FrameIndexAt(int64_t elapsed_ticks) const {
+  if (empty()) return -1;
+  int64_t tick = elapsed_ticks % cycle_ticks_;
+  if (tick < 0) tick += cycle_ticks_;
+  return FrameIndexInCycle(tick);
+}
+
+void SpriteTimeline::FrameIndicesAt(int64_t now, absl::Span<const int64_t> start_ticks,
+                                    absl::Span<int> indices) const {
+  if (empty()) {
+    std::fill(indices.begin(), indices.end(), -1);
+    return;
+  }
+  for (size_t i = 0; i < start_ticks.size(); ++i) {
+    int64_t tick = (now - start_ticks[i]) % cycle_ticks_;
+    if (tick < 0) tick += cycle_ticks_;
+    indices[i] = FrameIndexInCycle(tick);
+  }
+}
+
+}  // namespace zebes
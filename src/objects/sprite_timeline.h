@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "absl/types/span.h"
+#include "objects/sprite.h"
+
+namespace zebes {
+
+// A sprite's frame durations laid end to end, so the frame showing at any
+// tick is looked up rather than reached by stepping there.
+//
+// Every frame lasts its frames_per_cycle ticks, at least one, and the sprite
+// loops. An animated thing then needs no state beyond the tick it started on:
+// its frame is FrameIndexAt(now - start), which is the same at any frame rate
+// and for any number of things sharing the sprite.
+class SpriteTimeline {
+ public:
+  // A timeline with no frames.
+  SpriteTimeline() = default;
+  explicit SpriteTimeline(absl::Span<const SpriteFrame> frames);
+
+  bool empty() const { return frame_count_ == 0; }
+  int frame_count() const { return frame_count_; }
+
+  // Ticks in one loop: the sum of the frame durations.
+  int64_t cycle_ticks() const { return cycle_ticks_; }
+
+  // The index of the frame showing `elapsed_ticks` after playback started. A
+  // negative count runs the loop backwards, as for something that starts in
+  // the future. -1 when there are no frames.
+  int FrameIndexAt(int64_t elapsed_ticks) const;
+
+  // FrameIndexAt(now - start_ticks[i]) into indices[i] for every i, for a batch
+  // of things sharing this sprite. The spans must be the same size.
+  void FrameIndicesAt(int64_t now, absl::Span<const int64_t> start_ticks,
+                      absl::Span<int> indices) const;
+
+ private:
+  // The search for one tick already folded into [0, cycle_ticks_).
+  int FrameIndexInCycle(int64_t tick) const;
+
+  int frame_count_ = 0;
+  int64_t cycle_ticks_ = 0;
+  // Where each frame ends, in ticks from the start of the loop, padded with
+  // the largest int64_t to a power of two. The search then halves a fixed
+  // number of times with no early exit, which keeps batches branch-free.
+  std::vector<int64_t> frame_ends_;
+};
+
+}  // namespace zebes
@@ -0,0 +1,199 @@
+#include "objects/tile_chunk.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "absl/container/flat_hash_map.h"
+
+namespace zebes {
+namespace {
+
+// Distinct tiles an index width can name. Sixteen bits names more than a chunk
+// has cells, so it never runs out.
+size_t Capacity(int bits) { return size_t{1} << bits; }
+
+int BitsFor(size_t palette_size) {
+  if (palette_size <= Capacity(4)) return 4;
+  if (palette_size <= Capacity(8)) return 8;
+  return 16;
+}
+
+}  // namespace
+
+TileChunk::TileChunk(const std::array<int, kCells>& tiles) { Encode(tiles, 0); }
+
+int TileChunk::tile(int index) const {
+  if (bits_ == 0) return palette_.empty() ? 0 : palette_.front();
+  return palette_[IndexAt(index)];
+}
+
+void TileChunk::SetTile(int index, int tile_id) {
+  const int previous = tile(index);
+  if (previous == tile_id) return;
+
+  occupied_ += (tile_id != 0 ? 1 : 0) - (previous != 0 ? 1 : 0);
+  if (occupied_ == 0) {
+    Reset();
+    return;
+  }
+
+  if (bits_ == 0) {
+    // Empty or uniform until now: every other cell keeps the old fill.
+    palette_.assign(1, previous);
+    bits_ = 4;
+    indices_.assign(kCells / 2, 0);
+  }
+
+  const auto found = std::find(palette_.begin(), palette_.end(), tile_id);
+  if (found != palette_.end()) {
+    StoreIndex(index, static_cast<int>(found - palette_.begin()));
+    return;
+  }
+  if (palette_.size() < Capacity(bits_)) {
+    palette_.push_back(tile_id);
+    StoreIndex(index, static_cast<int>(palette_.size()) - 1);
+    return;
+  }
+
+  // The palette is full. Re-encoding drops entries no cell uses any more, and
+  // widens the indices only if that was not enough.
+  std::array<int, kCells> tiles = ToArray();
+  tiles[index] = tile_id;
+  Encode(tiles, bits_);
+}
+
+void TileChunk::Fill(int tile_id) {
+  Reset();
+  if (tile_id == 0) return;
+  palette_.assign(1, tile_id);
+  occupied_ = kCells;
+}
+
+void TileChunk::Compact() {
+  if (bits_ != 0) Encode(ToArray(), 0);
+}
+
+int TileChunk::CountOf(int tile_id) const {
+  if (tile_id == 0) return kCells - occupied_;
+  if (bits_ == 0) return !palette_.empty() && palette_.front() == tile_id ? kCells : 0;
+
+  const auto found = std::find(palette_.begin(), palette_.end(), tile_id);
+  if (found == palette_.end()) return 0;
+  const int slot = static_cast<int>(found - palette_.begin());
+  int count = 0;
+  for (int index = 0; index < kCells; ++index) {
+    if (IndexAt(index) == slot) ++count;
+  }
+  return count;
+}
+
+TileChunk::Encoding TileChunk::encoding() const {
+  switch (bits_) {
+    case 0:
+      return empty() ? Encoding::kEmpty : Encoding::kUniform;
+    case 4:
+      return Encoding::kPalette4;
+    case 8:
+      return Encoding::kPalette8;
+    default:
+      return Encoding::kPalette16;
+  }
+}
+
+size_t TileChunk::heap_bytes() const {
+  return palette_.capacity() * sizeof(int) + indices_.capacity();
+}
+
+std::array<int, TileChunk::kCells> TileChunk::ToArray() const {
+  std::array<int, kCells> tiles;
+  if (bits_ == 0) {
+    tiles.fill(palette_.empty() ? 0 : palette_.front());
+    return tiles;
+  }
+  for (int index = 0; index < kCells; ++index) tiles[index] = palette_[IndexAt(index)];
+  return tiles;
+}
+
+bool TileChunk::operator==(const TileChunk& other) const {
+  if (occupied_ != other.occupied_) return false;
+  // A copy keeps its encoding, and comparing against a copy is the common case.
+  if (bits_ == other.bits_ && palette_ == other.palette_ && indices_ == other.indices_) {
+    return true;
+  }
+  for (int index = 0; index < kCells; ++index) {
+    if (tile(index) != other.tile(index)) return false;
+  }
+  return true;
+}
+
+int TileChunk::IndexAt(int index) const {
+  switch (bits_) {
+    case 4: {
+      const uint8_t packed = indices_[index >> 1];
+      return (index & 1) != 0 ? packed >> 4 : packed & 0x0F;
+    }
+    case 8:
+      return indices_[index];
+    default:
+      return indices_[2 * index] | (indices_[2 * index + 1] << 8);
+  }
+}
+
+void TileChunk::StoreIndex(int index, int slot) {
+  switch (bits_) {
+    case 4: {
+      uint8_t& packed = indices_[index >> 1];
+      packed = (index & 1) != 0 ? static_cast<uint8_t>((packed & 0x0F) | (slot << 4))
+                                : static_cast<uint8_t>((packed & 0xF0) | slot);
+      return;
+    }
+    case 8:
+      indices_[index] = static_cast<uint8_t>(slot);
+      return;
+    default:
+      indices_[2 * index] = static_cast<uint8_t>(slot);
+      indices_[2 * index + 1] = static_cast<uint8_t>(slot >> 8);
+      return;
+  }
+}
+
+void TileChunk::Encode(const std::array<int, kCells>& tiles, int min_bits) {
+  std::vector<int> palette;
+  absl::flat_hash_map<int, int> slots;
+  std::array<uint16_t, kCells> slot_of;
+  int occupied = 0;
+  for (int index = 0; index < kCells; ++index) {
+    const auto [slot, added] = slots.try_emplace(tiles[index], static_cast<int>(palette.size()));
+    if (added) palette.push_back(tiles[index]);
+    slot_of[index] = static_cast<uint16_t>(slot->second);
+    if (tiles[index] != 0) ++occupied;
+  }
+
+  if (occupied == 0) {
+    Reset();
+    return;
+  }
+  occupied_ = occupied;
+  if (palette.size() == 1 && min_bits == 0) {
+    bits_ = 0;
+    palette_ = std::move(palette);
+    indices_ = std::vector<uint8_t>();
+    return;
+  }
+
+  bits_ = std::max(min_bits, BitsFor(palette.size()));
+  palette_ = std::move(palette);
+  indices_.assign(static_cast<size_t>(kCells) * bits_ / 8, 0);
+  indices_.shrink_to_fit();
+  for (int index = 0; index < kCells; ++index) StoreIndex(index, slot_of[index]);
+}
+
+void TileChunk::Reset() {
+  bits_ = 0;
+  occupied_ = 0;
+  // Assigning fresh vectors, unlike clear(), gives the memory back.
+  palette_ = std::vector<int>();
+  indices_ = std::vector<uint8_t>();
+}
+
+}  // namespace zebes
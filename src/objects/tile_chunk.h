@@ -0,0 +1,103 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace zebes {
+
+// One 32x32 block of a world layer's tile grid, stored compactly.
+//
+// Most chunks of a real level are empty, solid, or drawn from a handful of
+// tiles, so a plain 1,024-int array spends 4 KB on what a few bytes describe.
+// Cells are instead indices into a small per-chunk palette of tile IDs, packed
+// as tightly as the palette allows:
+//
+//  - Empty. No cells set; nothing allocated.
+//  - Uniform. Every cell holds the same nonzero tile; one palette entry.
+//  - Palette with 4-, 8- or 16-bit indices, for up to 16, 256 or 1,024
+//    distinct tiles.
+//
+// A chunk widens its indices when a write brings in one tile too many, after
+// first dropping palette entries no cell still uses. Cell data lives on the
+// heap, so a chunk is a few words to move: rehashing WorldLayer::tile_chunks
+// moves those words and never the cells.
+//
+// Zero means "no tile" in every encoding, so a default-constructed chunk reads
+// as empty. Equality is over cells, not encodings: two chunks that read the same
+// are equal however they got there.
+class TileChunk {
+ public:
+  static constexpr int kSize = 32;
+  static constexpr int kCells = kSize * kSize;
+
+  enum class Encoding {
+    kEmpty,
+    kUniform,
+    kPalette4,
+    kPalette8,
+    kPalette16,
+  };
+
+  TileChunk() = default;
+  // Cells in row-major order, encoded as compactly as they allow.
+  explicit TileChunk(const std::array<int, kCells>& tiles);
+
+  // The tile at a row-major cell index in [0, kCells).
+  int tile(int index) const;
+  void SetTile(int index, int tile_id);
+  // Sets every cell. Zero empties the chunk.
+  void Fill(int tile_id);
+
+  // Re-encodes as compactly as the current cells allow. Writes never shrink an
+  // encoding on their own, since a brush stroke would otherwise repack a chunk
+  // on every other cell.
+  void Compact();
+
+  bool empty() const { return occupied_ == 0; }
+  // Cells holding a nonzero tile.
+  int occupied() const { return occupied_; }
+  // Cells holding exactly `tile_id`.
+  int CountOf(int tile_id) const;
+  Encoding encoding() const;
+  // Bytes the chunk holds outside itself, for measuring level footprint.
+  size_t heap_bytes() const;
+
+  std::array<int, kCells> ToArray() const;
+
+  // Calls visit(index, tile_id) for every nonzero cell, in index order.
+  template <typename Visit>
+  void ForEachTile(Visit&& visit) const {
+    if (empty()) return;
+    if (bits_ == 0) {
+      for (int index = 0; index < kCells; ++index) visit(index, palette_.front());
+      return;
+    }
+    for (int index = 0; index < kCells; ++index) {
+      const int tile_id = palette_[IndexAt(index)];
+      if (tile_id != 0) visit(index, tile_id);
+    }
+  }
+
+  bool operator==(const TileChunk& other) const;
+
+ private:
+  // Palette slot of a cell. Only meaningful when bits_ is nonzero.
+  int IndexAt(int index) const;
+  void StoreIndex(int index, int slot);
+  // Rebuilds the encoding from dense cells, with indices at least `min_bits`
+  // wide; zero allows the uniform encoding.
+  void Encode(const std::array<int, kCells>& tiles, int min_bits);
+  void Reset();
+
+  // 0 for the empty and uniform encodings; otherwise 4, 8 or 16.
+  int bits_ = 0;
+  int occupied_ = 0;
+  // Empty when the chunk is; the single tile when uniform; otherwise indexed by
+  // the packed cells, and may hold entries no cell still uses.
+  std::vector<int> palette_;
+  std::vector<uint8_t> indices_;
+};
+
+}  // namespace zebes
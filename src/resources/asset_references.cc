@@ -222,11 +222,7 @@ std::vector<AssetReference> FindTileReferrers(const AssetCatalog& catalog,
 
     int painted = 0;
     for (const WorldLayer& layer : level.layers) {
-      for (const auto& entry : layer.tile_chunks) {
-        for (const int painted_id : entry.second.tiles) {
-          if (painted_id == tile_id) ++painted;
-        }
-      }
+      for (const auto& entry : layer.tile_chunks) painted += entry.second.CountOf(tile_id);
     }
     if (painted == 0) continue;
     // The count, because "this level uses it" leaves the user hunting a whole
@@ -97,6 +97,7 @@ absl::StatusOr<Collider*> ColliderManager::LoadCollider(const std::string& path_
 
   // Create Collider object.
   std::string id = collider.id;
+  geometries_[id] = std::make_unique<ColliderGeometry>(BuildColliderGeometry(collider));
   colliders_[id] = std::make_unique<Collider>(std::move(collider));
   return colliders_[id].get();
 }
@@ -161,11 +162,15 @@ absl::Status ColliderManager::SaveCollider(Collider collider) {
   // Assigned through the existing allocation rather than replacing it: callers
   // hold Collider* from GetCollider, and swapping the unique_ptr frees what
   // they point at. The pointer indirection exists so an address survives a save.
+  // The same holds for the geometry derived from it.
   std::string id = collider.id;
+  ColliderGeometry geometry = BuildColliderGeometry(collider);
   if (auto it = colliders_.find(id); it != colliders_.end()) {
     *it->second = std::move(collider);
+    *geometries_[id] = std::move(geometry);
     return absl::OkStatus();
   }
+  geometries_[id] = std::make_unique<ColliderGeometry>(std::move(geometry));
   colliders_[id] = std::make_unique<Collider>(std::move(collider));
 
   return absl::OkStatus();
@@ -179,6 +184,15 @@ absl::StatusOr<Collider*> ColliderManager::GetCollider(const std::string& id) {
   return it->second.get();
 }
 
+absl::StatusOr<const ColliderGeometry*> ColliderManager::GetColliderGeometry(
+    const std::string& id) {
+  auto it = geometries_.find(id);
+  if (it == geometries_.end()) {
+    return absl::NotFoundError(absl::StrCat("Collider with id ", id, " not found in manager."));
+  }
+  return it->second.get();
+}
+
 absl::Status ColliderManager::DeleteCollider(const std::string& id) {
   auto it = colliders_.find(id);
   if (it == colliders_.end()) return absl::NotFoundError("Collider not found");
@@ -189,6 +203,7 @@ absl::Status ColliderManager::DeleteCollider(const std::string& id) {
   std::filesystem::remove(GetDefinitionsPath(filename));
 
   colliders_.erase(it);
+  geometries_.erase(id);
   return absl::OkStatus();
 }
 
@@ -8,6 +8,7 @@
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "objects/collider.h"
+#include "objects/collider_geometry.h"
 
 namespace zebes {
 
@@ -51,6 +52,17 @@ class ColliderManager {
    */
   virtual absl::StatusOr<Collider*> GetCollider(const std::string& id);
 
+  /**
+   * @brief Retrieves the bounds and convex pieces derived from a loaded collider.
+   *
+   * Built whenever the collider is loaded or saved, so the pointer stays valid,
+   * and current, until the collider is deleted.
+   *
+   * @param id The ID of the collider whose geometry to retrieve.
+   * @return The collider's geometry, or an error if not found/loaded.
+   */
+  virtual absl::StatusOr<const ColliderGeometry*> GetColliderGeometry(const std::string& id);
+
   /**
    * @brief Deletes a collider by its ID, removing the JSON file.
    */
@@ -69,6 +81,8 @@ class ColliderManager {
   const std::string root_path_;
   const std::string definitions_path_;  // Path to definitions/colliders
   absl::flat_hash_map<std::string, std::unique_ptr<Collider>> colliders_;
+  // Keyed like colliders_ and kept in step with it.
+  absl::flat_hash_map<std::string, std::unique_ptr<ColliderGeometry>> geometries_;
 };
 
 }  // namespace zebes
@@ -0,0 +1,28 @@
+#include "resources/json_file.h"
+
+#include <filesystem>
+#include <fstream>
+
+#include "absl/strings/str_cat.h"
+#include "nlohmann/json.hpp"
+#include "resources/resource_utils.h"
+
+namespace zebes {
+
+absl::Status ReadJsonFile(const std::string& path,
+                          absl::FunctionRef<absl::Status(const nlohmann::json&)> parse) {
+  if (!std::filesystem::exists(path)) return absl::NotFoundError(absl::StrCat("no file at ", path));
+  std::ifstream stream(path);
+  if (!stream.is_open()) return absl::InternalError(absl::StrCat("could not open ", path));
+  try {
+    return parse(nlohmann::json::parse(stream));
+  } catch (const nlohmann::json::exception& e) {
+    return absl::InvalidArgumentError(absl::StrCat("could not parse ", path, ": ", e.what()));
+  }
+}
+
+absl::Status WriteJsonFile(const std::string& path, const nlohmann::json& json, int indent) {
+  return WriteTextFileAtomically(path, json.dump(indent));
+}
+
+}  // namespace zebes
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <string>
+
+#include "absl/functional/function_ref.h"
+#include "absl/status/status.h"
+#include "nlohmann/json_fwd.hpp"
+
+namespace zebes {
+
+// Reads the JSON document at `path` and hands it to `parse`.
+//
+// nlohmann reports a malformed document, and a field that is missing or of the
+// wrong type, by throwing. Both come back from here as InvalidArgument naming
+// the file, so `parse` reads fields with at() and get() and returns a Status
+// only for what it rejects itself. NotFound when there is no file.
+absl::Status ReadJsonFile(const std::string& path,
+                          absl::FunctionRef<absl::Status(const nlohmann::json&)> parse);
+
+// Replaces the file at `path` with `json`, indented by `indent` spaces, or
+// compact when negative. Goes through WriteTextFileAtomically, so a failed
+// write leaves the previous file.
+absl::Status WriteJsonFile(const std::string& path, const nlohmann::json& json, int indent = 4);
+
+}  // namespace zebes
@@ -0,0 +1,142 @@
+#include "resources/level_json.h"
+
+#include <array>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "common/status_macros.h"
+#include "nlohmann/json.hpp"
+
+namespace zebes {
+namespace {
+
+// Helper for TileChunk
+// Chunks are written as dense arrays: the file format predates the compact
+// encoding, and the encoding is a memory layout rather than something to pin.
+void ToJson(nlohmann::json& j, const TileChunk& chunk) { j["tiles"] = chunk.ToArray(); }
+
+void FromJson(const nlohmann::json& j, TileChunk& chunk) {
+  chunk = TileChunk(j.at("tiles").get<std::array<int, TileChunk::kCells>>());
+}
+
+void ToJson(nlohmann::json& j, const Entity& entity) {
+  j = nlohmann::json{
+      {"id", entity.id},
+      {"active", entity.active},
+      {"blueprint_id", entity.blueprint_id},
+      {"blueprint_state_index", entity.blueprint_state_index},
+      {"sort_order", entity.sort_order},
+      {"transform",
+       {
+           {"x", entity.transform.position.x},
+           {"y", entity.transform.position.y},
+           {"rotation", entity.transform.rotation},
+       }},
+      // Only authored properties are persisted. Velocity, acceleration, and
+      // animation playback are simulation state and deliberately never written.
+      {"body",
+       {
+           {"drag_x", entity.body.drag.x},
+           {"drag_y", entity.body.drag.y},
+           {"is_static", entity.body.is_static},
+           {"mass", entity.body.mass},
+       }},
+  };
+  // Written even when empty. An unbound reference is a state the level means to
+  // record, not one to leave the reader inferring from an absent key.
+  j["sprite_id"] = entity.sprite_id;
+  j["collider_id"] = entity.collider_id;
+}
+
+absl::Status FromJson(const nlohmann::json& j, Entity& entity) {
+  j.at("id").get_to(entity.id);
+  j.at("active").get_to(entity.active);
+  j.at("blueprint_id").get_to(entity.blueprint_id);
+  j.at("blueprint_state_index").get_to(entity.blueprint_state_index);
+  j.at("sort_order").get_to(entity.sort_order);
+
+  const nlohmann::json& t = j.at("transform");
+  t.at("x").get_to(entity.transform.position.x);
+  t.at("y").get_to(entity.transform.position.y);
+  t.at("rotation").get_to(entity.transform.rotation);
+
+  // Levels written before the split carry current_frame_index alongside the
+  // body's vx/vy/ax/ay. Those keys are simulation state; extra keys are ignored
+  // here rather than rejected, since the writer stopped emitting them and
+  // nothing reads them.
+  const nlohmann::json& b = j.at("body");
+  b.at("drag_x").get_to(entity.body.drag.x);
+  b.at("drag_y").get_to(entity.body.drag.y);
+  b.at("is_static").get_to(entity.body.is_static);
+  b.at("mass").get_to(entity.body.mass);
+
+  // Asset references are kept as IDs. Resolving them is the renderer's job, so
+  // a level can be loaded without the sprite or collider managers.
+  j.at("sprite_id").get_to(entity.sprite_id);
+  j.at("collider_id").get_to(entity.collider_id);
+  return absl::OkStatus();
+}
+
+}  // namespace
+
+nlohmann::json WorldLayerToJson(const WorldLayer& layer) {
+  nlohmann::json j;
+  j["id"] = layer.id;
+  j["name"] = layer.name;
+
+  std::vector<nlohmann::json> chunks_json;
+  for (const auto& [id, chunk] : layer.tile_chunks) {
+    // An empty chunk reads the same as a missing one, so it is not written.
+    if (chunk.empty()) continue;
+    nlohmann::json chunk_j;
+    chunk_j["chunk_id"] = id;
+    ToJson(chunk_j, chunk);
+    chunks_json.push_back(std::move(chunk_j));
+  }
+  j["tile_chunks"] = std::move(chunks_json);
+
+  std::vector<nlohmann::json> entities_json;
+  for (const auto& [id, entity] : layer.entities) {
+    nlohmann::json entity_j;
+    ToJson(entity_j, entity);
+    entities_json.push_back(std::move(entity_j));
+  }
+  j["entities"] = std::move(entities_json);
+  return j;
+}
+
+absl::StatusOr<WorldLayer> WorldLayerFromJson(const nlohmann::json& j) {
+  WorldLayer layer;
+  j.at("id").get_to(layer.id);
+  j.at("name").get_to(layer.name);
+
+  absl::flat_hash_set<int64_t> chunk_ids;
+  for (const nlohmann::json& item : j.at("tile_chunks")) {
+    const int64_t chunk_id = item.at("chunk_id").get<int64_t>();
+    if (!chunk_ids.insert(chunk_id).second) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("Duplicate tile chunk ID in world layer ", layer.id, ": ", chunk_id));
+    }
+    TileChunk chunk;
+    FromJson(item, chunk);
+    // Files written before empty chunks were dropped may still hold some.
+    if (!chunk.empty()) layer.tile_chunks.emplace(chunk_id, std::move(chunk));
+  }
+
+  for (const nlohmann::json& item : j.at("entities")) {
+    Entity entity;
+    RETURN_IF_ERROR(FromJson(item, entity));
+    const uint64_t entity_id = entity.id;
+    if (!layer.entities.emplace(entity_id, std::move(entity)).second) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("Duplicate entity ID in world layer ", layer.id, ": ", entity_id));
+    }
+  }
+  return layer;
+}
+
+}  // namespace zebes
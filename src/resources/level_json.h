@@ -0,0 +1,18 @@
+#pragma once
+
+#include "absl/status/statusor.h"
+#include "nlohmann/json_fwd.hpp"
+#include "objects/level.h"
+
+namespace zebes {
+
+// The JSON form of a world layer, shared by level definitions and the region
+// files of a streamed level so that both spell chunks and entities the same way.
+nlohmann::json WorldLayerToJson(const WorldLayer& layer);
+
+// Reads a layer, assuming every field the writer emits is present. Throws
+// nlohmann::json::exception when one is not, as the rest of the level parser
+// does; callers turn that into a Status at their document boundary.
+absl::StatusOr<WorldLayer> WorldLayerFromJson(const nlohmann::json& j);
+
+}  // namespace zebes
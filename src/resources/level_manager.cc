@@ -10,6 +10,7 @@
 #include "common/utils.h"
 #include "nlohmann/json.hpp"
 #include "objects/level.h"
+#include "resources/level_json.h"
 #include "resources/resource_utils.h"
 
 namespace zebes {
@@ -17,35 +18,6 @@ namespace {
 
 constexpr char kDefinitionsPath[] = "definitions/levels";
 
-// Helper for TileChunk
-void ToJson(nlohmann::json& j, const TileChunk& chunk) { j["tiles"] = chunk.tiles; }
-
-void FromJson(const nlohmann::json& j, TileChunk& chunk) { j.at("tiles").get_to(chunk.tiles); }
-
-void ToJson(nlohmann::json& j, const Entity& entity);
-
-void ToJson(nlohmann::json& j, const WorldLayer& layer) {
-  j["id"] = layer.id;
-  j["name"] = layer.name;
-
-  std::vector<nlohmann::json> chunks_json;
-  for (const auto& [id, chunk] : layer.tile_chunks) {
-    nlohmann::json chunk_j;
-    chunk_j["chunk_id"] = id;
-    ToJson(chunk_j, chunk);
-    chunks_json.push_back(std::move(chunk_j));
-  }
-  j["tile_chunks"] = std::move(chunks_json);
-
-  std::vector<nlohmann::json> entities_json;
-  for (const auto& [id, entity] : layer.entities) {
-    nlohmann::json entity_j;
-    ToJson(entity_j, entity);
-    entities_json.push_back(std::move(entity_j));
-  }
-  j["entities"] = std::move(entities_json);
-}
-
 // Helper for ParallaxLayer
 void ToJson(nlohmann::json& j, const ParallaxLayer& layer) {
   j = nlohmann::json{
@@ -123,91 +95,6 @@ void FromJson(const nlohmann::json& j, ParallaxZone& zone) {
   j.at("fade_y").get_to(zone.fade_length.y);
 }
 
-void ToJson(nlohmann::json& j, const Entity& entity) {
-  j = nlohmann::json{
-      {"id", entity.id},
-      {"active", entity.active},
-      {"blueprint_id", entity.blueprint_id},
-      {"blueprint_state_index", entity.blueprint_state_index},
-      {"sort_order", entity.sort_order},
-      {"transform",
-       {
-           {"x", entity.transform.position.x},
-           {"y", entity.transform.position.y},
-           {"rotation", entity.transform.rotation},
-       }},
-      // Only authored properties are persisted. Velocity, acceleration, and
-      // animation playback are simulation state and deliberately never written.
-      {"body",
-       {
-           {"drag_x", entity.body.drag.x},
-           {"drag_y", entity.body.drag.y},
-           {"is_static", entity.body.is_static},
-           {"mass", entity.body.mass},
-       }},
-  };
-  // Written even when empty. An unbound reference is a state the level means to
-  // record, not one to leave the reader inferring from an absent key.
-  j["sprite_id"] = entity.sprite_id;
-  j["collider_id"] = entity.collider_id;
-}
-
-absl::Status FromJson(const nlohmann::json& j, Entity& entity) {
-  j.at("id").get_to(entity.id);
-  j.at("active").get_to(entity.active);
-  j.at("blueprint_id").get_to(entity.blueprint_id);
-  j.at("blueprint_state_index").get_to(entity.blueprint_state_index);
-  j.at("sort_order").get_to(entity.sort_order);
-
-  const nlohmann::json& t = j.at("transform");
-  t.at("x").get_to(entity.transform.position.x);
-  t.at("y").get_to(entity.transform.position.y);
-  t.at("rotation").get_to(entity.transform.rotation);
-
-  // Levels written before the split carry current_frame_index alongside the
-  // body's vx/vy/ax/ay. Those keys are simulation state; extra keys are ignored
-  // here rather than rejected, since the writer stopped emitting them and
-  // nothing reads them.
-  const nlohmann::json& b = j.at("body");
-  b.at("drag_x").get_to(entity.body.drag.x);
-  b.at("drag_y").get_to(entity.body.drag.y);
-  b.at("is_static").get_to(entity.body.is_static);
-  b.at("mass").get_to(entity.body.mass);
-
-  // Asset references are kept as IDs. Resolving them is the renderer's job, so
-  // a level can be loaded without the sprite or collider managers.
-  j.at("sprite_id").get_to(entity.sprite_id);
-  j.at("collider_id").get_to(entity.collider_id);
-  return absl::OkStatus();
-}
-
-absl::StatusOr<WorldLayer> WorldLayerFromJson(const nlohmann::json& j) {
-  WorldLayer layer;
-  j.at("id").get_to(layer.id);
-  j.at("name").get_to(layer.name);
-
-  for (const nlohmann::json& item : j.at("tile_chunks")) {
-    const int64_t chunk_id = item.at("chunk_id").get<int64_t>();
-    TileChunk chunk;
-    FromJson(item, chunk);
-    if (!layer.tile_chunks.emplace(chunk_id, std::move(chunk)).second) {
-      return absl::InvalidArgumentError(
-          absl::StrCat("Duplicate tile chunk ID in world layer ", layer.id, ": ", chunk_id));
-    }
-  }
-
-  for (const nlohmann::json& item : j.at("entities")) {
-    Entity entity;
-    RETURN_IF_ERROR(FromJson(item, entity));
-    const uint64_t entity_id = entity.id;
-    if (!layer.entities.emplace(entity_id, std::move(entity)).second) {
-      return absl::InvalidArgumentError(
-          absl::StrCat("Duplicate entity ID in world layer ", layer.id, ": ", entity_id));
-    }
-  }
-  return layer;
-}
-
 nlohmann::json ToJson(const Level& level) {
   nlohmann::json j;
   j["id"] = level.id;
@@ -239,11 +126,7 @@ nlohmann::json ToJson(const Level& level) {
 
   std::vector<nlohmann::json> layers_json;
   layers_json.reserve(level.layers.size());
-  for (const WorldLayer& layer : level.layers) {
-    nlohmann::json layer_j;
-    ToJson(layer_j, layer);
-    layers_json.push_back(std::move(layer_j));
-  }
+  for (const WorldLayer& layer : level.layers) layers_json.push_back(WorldLayerToJson(layer));
   j["layers"] = std::move(layers_json);
 
   return j;
@@ -441,6 +324,8 @@ absl::Status LevelManager::DeleteLevel(const std::string& id) {
 
   std::string filename = absl::StrCat(it->second->name, "-", id, ".json");
   std::filesystem::remove(GetDefinitionsPath(filename));
+  // A streamed level keeps its regions in a directory named for its ID.
+  if (!id.empty()) std::filesystem::remove_all(GetDefinitionsPath(id));
 
   levels_.erase(it);
   return absl::OkStatus();
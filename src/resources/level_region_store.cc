@@ -0,0 +1,204 @@
+#include "resources/level_region_store.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+#include <utility>
+
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_split.h"
+#include "common/status_macros.h"
+#include "nlohmann/json.hpp"
+#include "resources/level_json.h"
+#include "resources/resource_utils.h"
+
+namespace zebes {
+namespace {
+
+constexpr char kDefinitionsPath[] = "definitions/levels";
+constexpr char kManifestFile[] = "manifest.json";
+constexpr int kFormatVersion = 1;
+// Large enough for any sensible streaming granularity, small enough that a
+// region's chunk span never overflows an int.
+constexpr int kMaxRegionChunks = 1024;
+
+std::string RegionDirectory(const std::string& root_path, const std::string& level_id) {
+  return absl::StrCat(root_path, "/", kDefinitionsPath, "/", level_id, "/regions");
+}
+
+absl::StatusOr<nlohmann::json> ReadJsonFile(const std::string& path) {
+  std::ifstream stream(path);
+  if (!stream.is_open()) return absl::InternalError(absl::StrCat("could not open ", path));
+  try {
+    return nlohmann::json::parse(stream);
+  } catch (const nlohmann::json::exception& e) {
+    return absl::InvalidArgumentError(absl::StrCat("could not parse ", path, ": ", e.what()));
+  }
+}
+
+absl::Status CheckVersion(const nlohmann::json& j, const std::string& path) {
+  const int version = j.at("version").get<int>();
+  if (version != kFormatVersion) {
+    return absl::FailedPreconditionError(
+        absl::StrCat(path, " is region format version ", version, ", not ", kFormatVersion));
+  }
+  return absl::OkStatus();
+}
+
+absl::StatusOr<LevelRegion> ParseRegion(const nlohmann::json& j, const std::string& path) {
+  RETURN_IF_ERROR(CheckVersion(j, path));
+  LevelRegion region{.coordinate = {.x = j.at("x").get<int>(), .y = j.at("y").get<int>()}};
+  for (const nlohmann::json& item : j.at("layers")) {
+    ASSIGN_OR_RETURN(WorldLayer layer, WorldLayerFromJson(item));
+    if (layer.tile_chunks.empty() && layer.entities.empty()) continue;
+    region.layers.push_back(std::move(layer));
+  }
+  return region;
+}
+
+}  // namespace
+
+absl::StatusOr<std::unique_ptr<LevelRegionStore>> LevelRegionStore::Open(
+    const std::string& root_path, const std::string& level_id) {
+  std::string directory = RegionDirectory(root_path, level_id);
+  const std::string manifest_path = absl::StrCat(directory, "/", kManifestFile);
+  if (!std::filesystem::exists(manifest_path)) {
+    return absl::NotFoundError(absl::StrCat("Level ", level_id, " has no regions"));
+  }
+
+  ASSIGN_OR_RETURN(const nlohmann::json manifest, ReadJsonFile(manifest_path));
+  int region_chunks = 0;
+  uint64_t next_entity_id = 0;
+  try {
+    RETURN_IF_ERROR(CheckVersion(manifest, manifest_path));
+    manifest.at("region_chunks").get_to(region_chunks);
+    manifest.at("next_entity_id").get_to(next_entity_id);
+  } catch (const nlohmann::json::exception& e) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("could not read ", manifest_path, ": ", e.what()));
+  }
+  if (region_chunks <= 0 || region_chunks > kMaxRegionChunks) {
+    return absl::InvalidArgumentError(
+        absl::StrCat(manifest_path, " names an invalid region size of ", region_chunks));
+  }
+  return std::unique_ptr<LevelRegionStore>(
+      new LevelRegionStore(std::move(directory), region_chunks, next_entity_id));
+}
+
+absl::StatusOr<std::unique_ptr<LevelRegionStore>> LevelRegionStore::Create(
+    const std::string& root_path, const std::string& level_id, int region_chunks) {
+  if (region_chunks <= 0 || region_chunks > kMaxRegionChunks) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Regions must span 1 to ", kMaxRegionChunks, " chunks, not ", region_chunks));
+  }
+  std::string directory = RegionDirectory(root_path, level_id);
+  if (std::filesystem::exists(absl::StrCat(directory, "/", kManifestFile))) {
+    return absl::AlreadyExistsError(absl::StrCat("Level ", level_id, " already has regions"));
+  }
+
+  std::unique_ptr<LevelRegionStore> store(
+      new LevelRegionStore(std::move(directory), region_chunks, /*next_entity_id=*/1));
+  RETURN_IF_ERROR(store->WriteManifest());
+  return store;
+}
+
+LevelRegionStore::LevelRegionStore(std::string directory, int region_chunks,
+                                   uint64_t next_entity_id)
+    : directory_(std::move(directory)),
+      region_chunks_(region_chunks),
+      next_entity_id_(next_entity_id) {}
+
+std::string LevelRegionStore::RegionPath(LevelRegionCoordinate coordinate) const {
+  return absl::StrCat(directory_, "/", coordinate.x, "_", coordinate.y, ".json");
+}
+
+absl::Status LevelRegionStore::WriteManifest() const {
+  const nlohmann::json manifest = {
+      {"version", kFormatVersion},
+      {"region_chunks", region_chunks_},
+      {"next_entity_id", next_entity_id_},
+  };
+  return WriteTextFileAtomically(absl::StrCat(directory_, "/", kManifestFile), manifest.dump(4));
+}
+
+absl::StatusOr<LevelRegion> LevelRegionStore::Read(LevelRegionCoordinate coordinate) const {
+  const std::string path = RegionPath(coordinate);
+  if (!std::filesystem::exists(path)) return LevelRegion{.coordinate = coordinate};
+
+  ASSIGN_OR_RETURN(const nlohmann::json j, ReadJsonFile(path));
+  absl::StatusOr<LevelRegion> region;
+  try {
+    region = ParseRegion(j, path);
+  } catch (const nlohmann::json::exception& e) {
+    return absl::InvalidArgumentError(absl::StrCat("could not read ", path, ": ", e.what()));
+  }
+  if (region.ok() && region->coordinate != coordinate) {
+    return absl::InvalidArgumentError(
+        absl::StrCat(path, " holds region (", region->coordinate.x, ", ", region->coordinate.y,
+                     ") instead"));
+  }
+  return region;
+}
+
+absl::Status LevelRegionStore::Write(const LevelRegion& region) {
+  const std::string path = RegionPath(region.coordinate);
+  if (region.empty()) {
+    std::error_code error;
+    std::filesystem::remove(path, error);
+    if (error) {
+      return absl::InternalError(absl::StrCat("could not remove ", path, ": ", error.message()));
+    }
+    return absl::OkStatus();
+  }
+
+  nlohmann::json j = {
+      {"version", kFormatVersion},
+      {"x", region.coordinate.x},
+      {"y", region.coordinate.y},
+  };
+  std::vector<nlohmann::json> layers_json;
+  layers_json.reserve(region.layers.size());
+  uint64_t greatest_entity_id = 0;
+  for (const WorldLayer& layer : region.layers) {
+    layers_json.push_back(WorldLayerToJson(layer));
+    if (!layer.entities.empty()) {
+      greatest_entity_id = std::max(greatest_entity_id, layer.entities.rbegin()->first);
+    }
+  }
+  j["layers"] = std::move(layers_json);
+
+  // The manifest goes first, so a write interrupted between the two files
+  // skips IDs rather than leaving one on disk that the manifest calls free.
+  if (greatest_entity_id >= next_entity_id_) {
+    next_entity_id_ = greatest_entity_id + 1;
+    RETURN_IF_ERROR(WriteManifest());
+  }
+  return WriteTextFileAtomically(path, j.dump());
+}
+
+absl::StatusOr<std::vector<LevelRegionCoordinate>> LevelRegionStore::List() const {
+  std::vector<LevelRegionCoordinate> regions;
+  std::error_code error;
+  for (const std::filesystem::directory_entry& entry :
+       std::filesystem::directory_iterator(directory_, error)) {
+    if (entry.path().extension() != ".json") continue;
+    const std::vector<std::string> parts =
+        absl::StrSplit(entry.path().stem().string(), absl::MaxSplits('_', 1));
+    LevelRegionCoordinate coordinate;
+    if (parts.size() != 2 || !absl::SimpleAtoi(parts[0], &coordinate.x) ||
+        !absl::SimpleAtoi(parts[1], &coordinate.y)) {
+      continue;
+    }
+    regions.push_back(coordinate);
+  }
+  if (error) {
+    return absl::InternalError(
+        absl::StrCat("could not list regions in ", directory_, ": ", error.message()));
+  }
+  std::sort(regions.begin(), regions.end());
+  return regions;
+}
+
+}  // namespace zebes
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "objects/level_region.h"
+
+namespace zebes {
+
+// The region files of a streamed level.
+//
+// A streamed level keeps its definition -- name, layers, themes, zones -- in
+// the usual definitions/levels/<name>-<id>.json, with layers left empty, and
+// its world content in definitions/levels/<id>/regions/: one <x>_<y>.json per
+// non-empty region beside a manifest.json fixing the region size. Region files
+// are machine-written and compact, since a dense chunk pretty-printed runs to a
+// thousand lines.
+//
+// Read may be called from any thread, concurrently with itself and with Write
+// of a different region; everything else belongs to the thread that owns the
+// store.
+class LevelRegionStore {
+ public:
+  // Opens the regions of a level split earlier. NotFound when it has none.
+  static absl::StatusOr<std::unique_ptr<LevelRegionStore>> Open(const std::string& root_path,
+                                                                const std::string& level_id);
+
+  // Starts an empty store. AlreadyExists when the level already has one, so
+  // splitting twice never mixes two region sizes in one directory.
+  static absl::StatusOr<std::unique_ptr<LevelRegionStore>> Create(
+      const std::string& root_path, const std::string& level_id,
+      int region_chunks = kDefaultRegionChunks);
+
+  int region_chunks() const { return region_chunks_; }
+
+  // One more than the greatest entity ID any region file has held. Entity IDs
+  // are unique across the whole level, and a level with regions on disk only
+  // sees the IDs of those resident, so new IDs start from here.
+  uint64_t next_entity_id() const { return next_entity_id_; }
+
+  // A region with no file is empty, not missing.
+  absl::StatusOr<LevelRegion> Read(LevelRegionCoordinate coordinate) const;
+
+  // Replaces a region's file, or removes it when the region is empty.
+  absl::Status Write(const LevelRegion& region);
+
+  // Every region with a file, in coordinate order.
+  absl::StatusOr<std::vector<LevelRegionCoordinate>> List() const;
+
+ private:
+  LevelRegionStore(std::string directory, int region_chunks, uint64_t next_entity_id);
+
+  std::string RegionPath(LevelRegionCoordinate coordinate) const;
+  absl::Status WriteManifest() const;
+
+  std::string directory_;
+  int region_chunks_;
+  uint64_t next_entity_id_;
+};
+
+}  // namespace zebes
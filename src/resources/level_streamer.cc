@@ -0,0 +1,284 @@
+#include "resources/level_streamer.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+#include <utility>
+
+#include "absl/strings/str_cat.h"
+#include "common/status_macros.h"
+
+namespace zebes {
+namespace {
+
+// The region `dx`, `dy` regions from `center`, if that is addressable at all.
+std::optional<LevelRegionCoordinate> Offset(LevelRegionCoordinate center, int dx, int dy) {
+  const int64_t x = int64_t{center.x} + dx;
+  const int64_t y = int64_t{center.y} + dy;
+  constexpr int64_t kMin = std::numeric_limits<int>::min();
+  constexpr int64_t kMax = std::numeric_limits<int>::max();
+  if (x < kMin || x > kMax || y < kMin || y > kMax) return std::nullopt;
+  return LevelRegionCoordinate{.x = static_cast<int>(x), .y = static_cast<int>(y)};
+}
+
+}  // namespace
+
+absl::StatusOr<std::unique_ptr<LevelStreamer>> LevelStreamer::Create(
+    Level* level, LevelRegionStore* store, LevelStreamerOptions options) {
+  if (level == nullptr || store == nullptr) {
+    return absl::InvalidArgumentError("A level streamer needs a level and a region store");
+  }
+  if (options.residency_radius < 0) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Residency radius must be non-negative, not ", options.residency_radius));
+  }
+  if (options.max_loads_in_flight < 1) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "At least one region load must be allowed, not ", options.max_loads_in_flight));
+  }
+  ASSIGN_OR_RETURN(const std::vector<LevelRegionCoordinate> listed, store->List());
+  return std::unique_ptr<LevelStreamer>(
+      new LevelStreamer(level, store, options, {listed.begin(), listed.end()}));
+}
+
+LevelStreamer::LevelStreamer(Level* level, LevelRegionStore* store, LevelStreamerOptions options,
+                             absl::flat_hash_set<LevelRegionCoordinate> stored)
+    : level_(level),
+      store_(store),
+      options_(options),
+      region_chunks_(store->region_chunks()),
+      stored_(std::move(stored)) {}
+
+absl::Status LevelStreamer::Update(Vec focus) {
+  focus_ = RegionOfPoint(*level_, focus, region_chunks_);
+  absl::Status status = InstallLoads(/*wait=*/false);
+  status.Update(RetryRefused());
+  status.Update(StartLoads());
+  status.Update(EvictOutsideRadius());
+  return status;
+}
+
+absl::Status LevelStreamer::WaitForLoads() { return InstallLoads(/*wait=*/true); }
+
+absl::Status LevelStreamer::LoadAll() {
+  RETURN_IF_ERROR(WaitForLoads());
+  std::vector<LevelRegionCoordinate> missing;
+  for (const LevelRegionCoordinate& coordinate : stored_) {
+    if (!resident_.contains(coordinate)) missing.push_back(coordinate);
+  }
+  std::sort(missing.begin(), missing.end());
+  for (const LevelRegionCoordinate& coordinate : missing) RETURN_IF_ERROR(LoadNow(coordinate));
+  return absl::OkStatus();
+}
+
+absl::Status LevelStreamer::Commit() {
+  RETURN_IF_ERROR(WaitForLoads());
+
+  // Stray content merges with what its region holds on disk before either is
+  // written, exactly as if the region had been loaded first. A refused region
+  // would have to lose one side to be written, so nothing is.
+  absl::Status status = RetryRefused();
+  for (const LevelRegionCoordinate& coordinate : OccupiedRegions(*level_, region_chunks_)) {
+    if (!resident_.contains(coordinate) && !refused_.contains(coordinate)) {
+      status.Update(LoadNow(coordinate));
+    }
+  }
+  RETURN_IF_ERROR(status);
+
+  for (auto& [coordinate, resident] : resident_) {
+    status.Update(WriteBack(CopyRegion(*level_, coordinate, region_chunks_), resident));
+  }
+  return status;
+}
+
+absl::StatusOr<uint64_t> LevelStreamer::NextAvailableEntityId() const {
+  ASSIGN_OR_RETURN(const uint64_t resident, zebes::NextAvailableEntityId(*level_));
+  return std::max(resident, store_->next_entity_id());
+}
+
+LevelStreamerStats LevelStreamer::stats() const {
+  return {
+      .resident_regions = static_cast<int>(resident_.size()),
+      .loads_in_flight = static_cast<int>(loads_.size()),
+      .resident_bytes = resident_bytes_,
+      .regions_loaded = regions_loaded_,
+      .regions_evicted = regions_evicted_,
+      .regions_written = regions_written_,
+      .refused_regions = static_cast<int>(refused_.size()),
+  };
+}
+
+absl::Status LevelStreamer::InstallLoads(bool wait) {
+  absl::Status status;
+  std::vector<PendingLoad> pending;
+  for (PendingLoad& load : loads_) {
+    if (!wait) {
+      const absl::StatusOr<bool> ready = load.task.IsReady();
+      if (ready.ok() && !*ready) {
+        pending.push_back(std::move(load));
+        continue;
+      }
+    }
+    absl::StatusOr<LoadedRegion> loaded = load.task.TakeResult();
+    if (!loaded.ok()) {
+      status.Update(loaded.status());
+      continue;
+    }
+    status.Update(Install(*std::move(loaded)));
+  }
+  loads_ = std::move(pending);
+  return status;
+}
+
+absl::Status LevelStreamer::LoadNow(LevelRegionCoordinate coordinate) {
+  if (refused_.contains(coordinate)) return Retry(coordinate);
+  LoadedRegion loaded{.region = {.coordinate = coordinate}};
+  if (stored_.contains(coordinate)) {
+    ASSIGN_OR_RETURN(loaded.region, store_->Read(coordinate));
+  }
+  loaded.hash = LevelRegionStateHash(loaded.region);
+  return Install(std::move(loaded));
+}
+
+absl::Status LevelStreamer::Install(LoadedRegion loaded) {
+  const LevelRegionCoordinate coordinate = loaded.region.coordinate;
+  if (absl::Status conflict = CheckRegionInstall(*level_, loaded.region); !conflict.ok()) {
+    refused_[coordinate] = std::move(loaded);
+    return conflict;
+  }
+  const size_t bytes = loaded.region.EstimatedBytes();
+  RETURN_IF_ERROR(InstallRegion(*level_, std::move(loaded.region)));
+  resident_[coordinate] = {.stored_hash = loaded.hash, .bytes = bytes};
+  resident_bytes_ += bytes;
+  ++regions_loaded_;
+  return absl::OkStatus();
+}
+
+absl::Status LevelStreamer::Retry(LevelRegionCoordinate coordinate) {
+  const auto refused = refused_.find(coordinate);
+  RETURN_IF_ERROR(CheckRegionInstall(*level_, refused->second.region));
+  LoadedRegion loaded = std::move(refused->second);
+  refused_.erase(refused);
+  return Install(std::move(loaded));
+}
+
+absl::Status LevelStreamer::RetryRefused() {
+  // In coordinate order, so which refusal is reported does not depend on
+  // hash-map iteration.
+  std::vector<LevelRegionCoordinate> coordinates;
+  for (const auto& [coordinate, refused] : refused_) coordinates.push_back(coordinate);
+  std::sort(coordinates.begin(), coordinates.end());
+  absl::Status status;
+  for (const LevelRegionCoordinate& coordinate : coordinates) status.Update(Retry(coordinate));
+  return status;
+}
+
+bool LevelStreamer::IsLoading(LevelRegionCoordinate coordinate) const {
+  return std::any_of(loads_.begin(), loads_.end(),
+                     [&](const PendingLoad& load) { return load.coordinate == coordinate; });
+}
+
+absl::Status LevelStreamer::StartLoads() {
+  if (!focus_.has_value()) return absl::OkStatus();
+
+  // Ring by ring outwards, so the regions nearest the focus are read first.
+  for (int ring = 0; ring <= options_.residency_radius; ++ring) {
+    for (int dy = -ring; dy <= ring; ++dy) {
+      for (int dx = -ring; dx <= ring; ++dx) {
+        if (std::max(std::abs(dx), std::abs(dy)) != ring) continue;
+        const std::optional<LevelRegionCoordinate> coordinate = Offset(*focus_, dx, dy);
+        if (!coordinate.has_value() || resident_.contains(*coordinate) ||
+            refused_.contains(*coordinate) || IsLoading(*coordinate)) {
+          continue;
+        }
+        // Nothing on disk to wait for.
+        if (!stored_.contains(*coordinate)) {
+          RETURN_IF_ERROR(LoadNow(*coordinate));
+          continue;
+        }
+        if (loads_.size() >= static_cast<size_t>(options_.max_loads_in_flight)) {
+          return absl::OkStatus();
+        }
+
+        const LevelRegionStore* store = store_;
+        const LevelRegionCoordinate target = *coordinate;
+        ASSIGN_OR_RETURN(BackgroundTask<LoadedRegion> task,
+                         BackgroundTask<LoadedRegion>::Start(
+                             [store, target]() -> absl::StatusOr<LoadedRegion> {
+                               ASSIGN_OR_RETURN(LevelRegion region, store->Read(target));
+                               const uint64_t hash = LevelRegionStateHash(region);
+                               return LoadedRegion{.region = std::move(region), .hash = hash};
+                             }));
+        loads_.push_back({.coordinate = target, .task = std::move(task)});
+      }
+    }
+  }
+  return absl::OkStatus();
+}
+
+absl::Status LevelStreamer::EvictOutsideRadius() {
+  if (!focus_.has_value()) return absl::OkStatus();
+
+  std::vector<std::pair<int, LevelRegionCoordinate>> candidates;
+  for (const auto& [coordinate, resident] : resident_) {
+    const int distance = RegionDistance(*focus_, coordinate);
+    if (distance > options_.residency_radius && !resident.edited) {
+      candidates.push_back({distance, coordinate});
+    }
+  }
+  // Farthest first, ties in coordinate order so eviction does not depend on
+  // hash-map iteration.
+  std::sort(candidates.begin(), candidates.end(), [](const auto& a, const auto& b) {
+    if (a.first != b.first) return a.first > b.first;
+    return a.second < b.second;
+  });
+
+  absl::Status status;
+  for (const auto& [distance, coordinate] : candidates) {
+    // A region that was empty costs nothing to bring back, so it is not kept
+    // as cache.
+    const bool empty = resident_.at(coordinate).bytes == 0;
+    if (!empty && resident_bytes_ <= options_.memory_budget_bytes) continue;
+    status.Update(Evict(coordinate));
+  }
+  return status;
+}
+
+absl::Status LevelStreamer::Evict(LevelRegionCoordinate coordinate) {
+  ResidentRegion& resident = resident_.at(coordinate);
+  LevelRegion region = TakeRegion(*level_, coordinate, region_chunks_);
+  if (LevelRegionStateHash(region) != resident.stored_hash) {
+    // Edits reach disk only through Commit, so this one stays until then.
+    // Taken from the level a moment ago, so it goes back without conflict.
+    resident.edited = true;
+    return InstallRegion(*level_, std::move(region));
+  }
+  resident_bytes_ -= resident.bytes;
+  resident_.erase(coordinate);
+  ++regions_evicted_;
+  return absl::OkStatus();
+}
+
+absl::Status LevelStreamer::WriteBack(const LevelRegion& region, ResidentRegion& resident) {
+  const uint64_t hash = LevelRegionStateHash(region);
+  if (hash == resident.stored_hash) {
+    resident.edited = false;
+    return absl::OkStatus();
+  }
+
+  RETURN_IF_ERROR(store_->Write(region));
+  if (region.empty()) {
+    stored_.erase(region.coordinate);
+  } else {
+    stored_.insert(region.coordinate);
+  }
+  const size_t bytes = region.EstimatedBytes();
+  resident_bytes_ = resident_bytes_ - resident.bytes + bytes;
+  resident.stored_hash = hash;
+  resident.bytes = bytes;
+  resident.edited = false;
+  ++regions_written_;
+  return absl::OkStatus();
+}
+
+}  // namespace zebes
@@ -0,0 +1,177 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "common/background_task.h"
+#include "objects/level.h"
+#include "objects/level_region.h"
+#include "objects/vec.h"
+#include "resources/level_region_store.h"
+
+namespace zebes {
+
+struct LevelStreamerOptions {
+  // Regions within this many regions of the focus, counting diagonals as one,
+  // are loaded and never evicted. Zero keeps just the focus region.
+  int residency_radius = 2;
+  // Regions outside the radius stay resident as a cache until their estimated
+  // size passes this, and then go farthest first. Regions inside the radius,
+  // and edited regions anywhere, are never evicted, so a radius too large for
+  // the budget, or a session of far-flung edits, overruns it rather than
+  // unloading what is on screen or what has not been committed.
+  size_t memory_budget_bytes = size_t{256} << 20;
+  // Region reads running at once.
+  int max_loads_in_flight = 4;
+};
+
+struct LevelStreamerStats {
+  int resident_regions = 0;
+  int loads_in_flight = 0;
+  // LevelRegion::EstimatedBytes of each resident region as loaded.
+  size_t resident_bytes = 0;
+  int64_t regions_loaded = 0;
+  int64_t regions_evicted = 0;
+  int64_t regions_written = 0;
+  // Regions read but refused, for conflicting with what the level holds.
+  int refused_regions = 0;
+};
+
+// Keeps the regions of a streamed level resident around a moving focus, such
+// as the camera, inside one live Level that editing and rendering use as
+// though it held the whole world.
+//
+// Regions are read on background threads and installed by Update on the
+// owning thread, so the level is only ever touched there. Nothing reaches disk
+// until Commit, which writes every resident region whose content differs from
+// what was loaded; that is how edits made anywhere in the live level are saved
+// without the editor tracking regions at all. Until then an edited region is
+// never evicted, so dropping the streamer drops its edits. Content that lands
+// in a region not resident -- an entity dragged far off screen -- stays in the
+// level until that region is loaded, when the two merge, or until Commit loads
+// it to merge them.
+//
+// A region whose stored content conflicts with that stray content is refused,
+// as InstallRegion refuses it, and stays unloaded with both sides intact. It
+// is not read again: the streamer keeps what it read and checks it against
+// the level on every Update and Commit, reporting the cell or entity in the
+// way, until the conflict is gone and it installs.
+class LevelStreamer {
+ public:
+  // `level` should hold only what the store does not: the definition with
+  // empty layers, as split, plus any edits. Both must outlive the streamer.
+  static absl::StatusOr<std::unique_ptr<LevelStreamer>> Create(Level* level,
+                                                               LevelRegionStore* store,
+                                                               LevelStreamerOptions options = {});
+
+  // Waits for reads in flight and drops their results. Edits not yet committed
+  // are not written.
+  ~LevelStreamer() = default;
+
+  LevelStreamer(const LevelStreamer&) = delete;
+  LevelStreamer& operator=(const LevelStreamer&) = delete;
+
+  // Installs finished reads, retries refused regions, starts reads for the
+  // regions around `focus` nearest first, and evicts unedited regions beyond
+  // the budget. Never blocks on the store. A failed read is reported by the
+  // update that collects it and retried by the next; a refused region is
+  // reported by every update until it installs.
+  absl::Status Update(Vec focus);
+
+  // Blocks until every read in flight has been installed.
+  absl::Status WaitForLoads();
+
+  // Loads every region the store has, for tools that need the whole world and
+  // before removing a world layer, so that no region left on disk still holds
+  // content for it.
+  absl::Status LoadAll();
+
+  // Writes every resident region that differs from what was loaded, loading
+  // first any region the level holds stray content for. Writes nothing while
+  // any region is refused. Call when saving the level definition, and only
+  // then: edits are meant to reach disk with the save the user asked for.
+  absl::Status Commit();
+
+  bool IsResident(LevelRegionCoordinate coordinate) const {
+    return resident_.contains(coordinate);
+  }
+
+  // The smallest entity ID unused both in the live level and in every region
+  // on disk. NextAvailableEntityId(level) alone only sees resident regions.
+  absl::StatusOr<uint64_t> NextAvailableEntityId() const;
+
+  LevelStreamerStats stats() const;
+
+ private:
+  struct ResidentRegion {
+    // LevelRegionStateHash of the region as read from the store, or as last
+    // written. A hash rather than a copy, so residency costs the level's memory
+    // once.
+    uint64_t stored_hash = 0;
+    size_t bytes = 0;
+    // Found to differ from the store when it was due for eviction. Kept until
+    // Commit writes it, so a region is not taken out and put back every update.
+    bool edited = false;
+  };
+
+  struct LoadedRegion {
+    LevelRegion region;
+    uint64_t hash = 0;
+  };
+
+  struct PendingLoad {
+    LevelRegionCoordinate coordinate;
+    BackgroundTask<LoadedRegion> task;
+  };
+
+  LevelStreamer(Level* level, LevelRegionStore* store, LevelStreamerOptions options,
+                absl::flat_hash_set<LevelRegionCoordinate> stored);
+
+  // Installs the reads that have finished, or all of them when `wait`.
+  absl::Status InstallLoads(bool wait);
+  // Reads and installs one region on the calling thread, or retries it when it
+  // was refused.
+  absl::Status LoadNow(LevelRegionCoordinate coordinate);
+  // Fails, recording the region as refused and leaving it unloaded, when it
+  // conflicts with content the level already holds there.
+  absl::Status Install(LoadedRegion loaded);
+  // Installs a refused region once nothing in the level conflicts with it, and
+  // otherwise fails with what still does.
+  absl::Status Retry(LevelRegionCoordinate coordinate);
+  absl::Status RetryRefused();
+  bool IsLoading(LevelRegionCoordinate coordinate) const;
+  absl::Status StartLoads();
+  absl::Status EvictOutsideRadius();
+  // Unloads a region unless it has been edited since it was loaded, which
+  // marks it edited instead.
+  absl::Status Evict(LevelRegionCoordinate coordinate);
+  // Writes a resident region's current content when it differs from what was
+  // loaded.
+  absl::Status WriteBack(const LevelRegion& region, ResidentRegion& resident);
+
+  Level* level_;
+  LevelRegionStore* store_;
+  LevelStreamerOptions options_;
+  int region_chunks_;
+
+  // Regions with a file in the store. Anything else is empty on disk and
+  // becomes resident without a read.
+  absl::flat_hash_set<LevelRegionCoordinate> stored_;
+  absl::flat_hash_map<LevelRegionCoordinate, ResidentRegion> resident_;
+  absl::flat_hash_map<LevelRegionCoordinate, LoadedRegion> refused_;
+  std::optional<LevelRegionCoordinate> focus_;
+  size_t resident_bytes_ = 0;
+  int64_t regions_loaded_ = 0;
+  int64_t regions_evicted_ = 0;
+  int64_t regions_written_ = 0;
+  std::vector<PendingLoad> loads_;
+};
+
+}  // namespace zebes
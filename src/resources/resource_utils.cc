@@ -36,7 +36,11 @@ void RemoveOldFileIfExists(const std::string& id, const std::string& old_name,
 absl::Status WriteTextFileAtomically(const std::string& path, std::string_view contents) {
   const std::string temporary = absl::StrCat(path, ".tmp");
   std::error_code error;
-  std::filesystem::create_directories(std::filesystem::path(path).parent_path(), error);
+  // A bare file name lives in the working directory, which already exists.
+  if (const std::filesystem::path parent = std::filesystem::path(path).parent_path();
+      !parent.empty()) {
+    std::filesystem::create_directories(parent, error);
+  }
   if (error) {
     return absl::InternalError(
         absl::StrCat("could not create definition directory: ", error.message()));
@@ -124,6 +124,7 @@ absl::StatusOr<Sprite*> SpriteManager::LoadSprite(const std::string& path_json)
 
   // Create Sprite object.
   std::string id = sprite.id;
+  timelines_[id] = std::make_unique<SpriteTimeline>(sprite.frames);
   sprites_[id] = std::make_unique<Sprite>(std::move(sprite));
   return sprites_[id].get();
 }
@@ -206,11 +207,15 @@ absl::Status SpriteManager::SaveSprite(Sprite sprite) {
   // Assigned through the existing allocation rather than replacing it: callers
   // hold Sprite* from GetSprite, and swapping the unique_ptr frees what they
   // point at. The pointer indirection exists so an address survives a save.
+  // The same holds for the timeline derived from it.
   std::string id = sprite.id;
+  SpriteTimeline timeline(sprite.frames);
   if (auto it = sprites_.find(id); it != sprites_.end()) {
     *it->second = std::move(sprite);
+    *timelines_[id] = std::move(timeline);
     return absl::OkStatus();
   }
+  timelines_[id] = std::make_unique<SpriteTimeline>(std::move(timeline));
   sprites_[id] = std::make_unique<Sprite>(std::move(sprite));
 
   return absl::OkStatus();
@@ -224,6 +229,14 @@ absl::StatusOr<Sprite*> SpriteManager::GetSprite(const std::string& id) {
   return it->second.get();
 }
 
+absl::StatusOr<const SpriteTimeline*> SpriteManager::GetSpriteTimeline(const std::string& id) {
+  auto it = timelines_.find(id);
+  if (it == timelines_.end()) {
+    return absl::NotFoundError(absl::StrCat("Sprite with id ", id, " not found in manager."));
+  }
+  return it->second.get();
+}
+
 absl::Status SpriteManager::DeleteSprite(const std::string& id) {
   auto it = sprites_.find(id);
   if (it == sprites_.end()) return absl::NotFoundError("Sprite not found");
@@ -237,6 +250,7 @@ absl::Status SpriteManager::DeleteSprite(const std::string& id) {
   }
 
   sprites_.erase(it);
+  timelines_.erase(id);
   return absl::OkStatus();
 }
 
@@ -8,6 +8,7 @@
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "objects/sprite.h"
+#include "objects/sprite_timeline.h"
 #include "resources/texture_manager.h"
 
 namespace zebes {
@@ -57,6 +58,17 @@ class SpriteManager {
    */
   virtual absl::StatusOr<Sprite*> GetSprite(const std::string& id);
 
+  /**
+   * @brief Retrieves the frame timeline of a loaded sprite.
+   *
+   * Built whenever the sprite is loaded or saved, so it matches the saved
+   * frames, and the pointer stays valid until the sprite is deleted.
+   *
+   * @param id The ID of the sprite whose timeline to retrieve.
+   * @return The sprite's timeline, or an error if not found/loaded.
+   */
+  virtual absl::StatusOr<const SpriteTimeline*> GetSpriteTimeline(const std::string& id);
+
   /**
    * @brief Deletes a sprite by its ID, removing the JSON file.
    */
@@ -76,6 +88,8 @@ class SpriteManager {
   const std::string definitions_path_;
   TextureManager* tm_;
   absl::flat_hash_map<std::string, std::unique_ptr<Sprite>> sprites_;
+  // Keyed like sprites_ and kept in step with it.
+  absl::flat_hash_map<std::string, std::unique_ptr<SpriteTimeline>> timelines_;
 };
 
 }  // namespace zebes
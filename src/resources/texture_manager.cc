@@ -261,6 +261,15 @@ absl::StatusOr<RgbaImage> TextureManager::ReadTexturePixels(const std::string& i
   return ReadPng(GetImagesPath(texture->second->path));
 }
 
+absl::StatusOr<TextureHandle> TextureManager::LoadTransientTexture(
+    int width, int height, absl::Span<const uint8_t> pixels) {
+  return resources_->LoadFromPixels(width, height, pixels);
+}
+
+void TextureManager::UnloadTransientTexture(TextureHandle handle) {
+  if (handle) resources_->Unload(handle).IgnoreError();
+}
+
 absl::StatusOr<std::string> TextureManager::CreateTexture(Texture texture) {
   // Generate GUID
   std::string id = GenerateGuid();
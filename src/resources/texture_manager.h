@@ -101,6 +101,16 @@ class TextureManager {
   // would be a second place that has to agree about where artwork lives.
   virtual absl::StatusOr<RgbaImage> ReadTexturePixels(const std::string& id);
 
+  // Loads pixels that belong to no texture definition.
+  //
+  // For artwork the editor derives for its own display and throws away, such
+  // as the viewport's zoomed-out chunk impostors. No ID, no file and no entry in
+  // GetAllTextures; the caller owns the handle and must give it back through
+  // UnloadTransientTexture.
+  virtual absl::StatusOr<TextureHandle> LoadTransientTexture(int width, int height,
+                                                             absl::Span<const uint8_t> pixels);
+  virtual void UnloadTransientTexture(TextureHandle handle);
+
   /**
    * @brief Retrieves a loaded texture by its ID.
    *
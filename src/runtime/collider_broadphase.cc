@@ -0,0 +1,145 @@
+#include "runtime/collider_broadphase.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+
+namespace zebes {
+namespace {
+
+// The grid never has more than this many cells per box, so clearing it costs
+// no more than binning the boxes.
+constexpr double kMaxCellsPerBox = 4;
+
+// A box covering more cells than this is tested against every box instead.
+constexpr int kMaxCellsCovered = 16;
+
+// Marks a CellRange whose box is in oversized_.
+constexpr int kOversized = -1;
+
+}  // namespace
+
+absl::StatusOr<ColliderBroadphase> ColliderBroadphase::Create(double cell_size) {
+  if (!(cell_size > 0) || std::isinf(cell_size)) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("broadphase cell size must be positive and finite, got ", cell_size));
+  }
+  return ColliderBroadphase(cell_size);
+}
+
+absl::Span<const BroadphasePair> ColliderBroadphase::FindPairs(
+    absl::Span<const ColliderBounds> bounds) {
+  pairs_.clear();
+  if (bounds.size() < 2) return pairs_;
+
+  ColliderBounds world = bounds.front();
+  for (const ColliderBounds& box : bounds) {
+    world.min.x = std::min(world.min.x, box.min.x);
+    world.min.y = std::min(world.min.y, box.min.y);
+    world.max.x = std::max(world.max.x, box.max.x);
+    world.max.y = std::max(world.max.y, box.max.y);
+  }
+  const double width = world.max.x - world.min.x;
+  const double height = world.max.y - world.min.y;
+
+  // Coarsen the cells until the grid fits its cap. The first guess spreads the
+  // cap over the area; the loop settles rounding and thin, one-row worlds.
+  const double max_cells = kMaxCellsPerBox * static_cast<double>(bounds.size()) + 1;
+  double cell = std::max(cell_size_, std::sqrt(width * height / max_cells));
+  auto grid_cells = [&](double size) {
+    return (std::floor(width / size) + 1) * (std::floor(height / size) + 1);
+  };
+  while (grid_cells(cell) > max_cells) cell *= 1.25;
+  const int columns = static_cast<int>(std::floor(width / cell)) + 1;
+  const int rows = static_cast<int>(std::floor(height / cell)) + 1;
+  auto column_of = [&](double x) {
+    return std::clamp(static_cast<int>((x - world.min.x) / cell), 0, columns - 1);
+  };
+  auto row_of = [&](double y) {
+    return std::clamp(static_cast<int>((y - world.min.y) / cell), 0, rows - 1);
+  };
+
+  // Count each cell's boxes, then lay them out cell by cell. Boxes go in by
+  // index, so every cell lists its boxes in ascending order.
+  ranges_.resize(bounds.size());
+  oversized_.clear();
+  cell_starts_.assign(static_cast<size_t>(columns) * rows, 0);
+  for (size_t i = 0; i < bounds.size(); ++i) {
+    CellRange& range = ranges_[i];
+    range = {.first_column = column_of(bounds[i].min.x),
+             .first_row = row_of(bounds[i].min.y),
+             .last_column = column_of(bounds[i].max.x),
+             .last_row = row_of(bounds[i].max.y)};
+    if ((range.last_column - range.first_column + 1) * (range.last_row - range.first_row + 1) >
+        kMaxCellsCovered) {
+      range.first_column = kOversized;
+      oversized_.push_back(static_cast<uint32_t>(i));
+      continue;
+    }
+    for (int row = range.first_row; row <= range.last_row; ++row) {
+      for (int column = range.first_column; column <= range.last_column; ++column) {
+        ++cell_starts_[static_cast<size_t>(row) * columns + column];
+      }
+    }
+  }
+  uint32_t total = 0;
+  for (uint32_t& start : cell_starts_) {
+    const uint32_t count = start;
+    start = total;
+    total += count;
+  }
+  entries_.resize(total);
+  // Filling advances each start to its cell's end, which is where the next
+  // cell starts: afterwards cell c holds [cell_starts_[c - 1], cell_starts_[c]).
+  for (size_t i = 0; i < bounds.size(); ++i) {
+    const CellRange& range = ranges_[i];
+    if (range.first_column == kOversized) continue;
+    const CellEntry entry{.bounds = bounds[i],
+                          .index = static_cast<uint32_t>(i),
+                          .first_column = range.first_column,
+                          .first_row = range.first_row};
+    for (int row = range.first_row; row <= range.last_row; ++row) {
+      for (int column = range.first_column; column <= range.last_column; ++column) {
+        entries_[cell_starts_[static_cast<size_t>(row) * columns + column]++] = entry;
+      }
+    }
+  }
+
+  uint32_t begin = 0;
+  for (int row = 0; row < rows; ++row) {
+    for (int column = 0; column < columns; ++column) {
+      const uint32_t end = cell_starts_[static_cast<size_t>(row) * columns + column];
+      for (uint32_t i = begin; i < end; ++i) {
+        const CellEntry& a = entries_[i];
+        for (uint32_t j = i + 1; j < end; ++j) {
+          const CellEntry& b = entries_[j];
+          // Only the first cell the two share reports them.
+          if (std::max(a.first_column, b.first_column) != column ||
+              std::max(a.first_row, b.first_row) != row) {
+            continue;
+          }
+          if (a.bounds.Overlaps(b.bounds)) pairs_.push_back({.first = a.index, .second = b.index});
+        }
+      }
+      begin = end;
+    }
+  }
+
+  for (const uint32_t large : oversized_) {
+    for (uint32_t other = 0; other < bounds.size(); ++other) {
+      // Two oversized boxes meet once, when the smaller index comes round.
+      if (other == large || (ranges_[other].first_column == kOversized && other < large)) {
+        continue;
+      }
+      if (!bounds[large].Overlaps(bounds[other])) continue;
+      pairs_.push_back({.first = std::min(large, other), .second = std::max(large, other)});
+    }
+  }
+  return pairs_;
+}
+
+}  // namespace zebes
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "objects/collider_geometry.h"
+
+namespace zebes {
+
+// Two boxes whose bounds overlap, by their indices in the FindPairs input.
+// `first` is always the smaller index.
+struct BroadphasePair {
+  uint32_t first = 0;
+  uint32_t second = 0;
+
+  bool operator==(const BroadphasePair& other) const {
+    return first == other.first && second == other.second;
+  }
+};
+
+// Finds which of a frame's collider bounds overlap, so the narrow phase only
+// runs on pairs that might collide.
+//
+// Boxes are binned into a uniform grid spanning the frame's boxes, rebuilt
+// from scratch each call by a counting sort: the cost is linear in the boxes,
+// the cells they cover and the pairs found, however they moved since the last
+// frame. The grid is capped at a few cells per box, coarsening if the boxes
+// are spread thin, and a box covering too many cells is tested against every
+// other box instead of filling them all. Each pair is reported once, from the
+// first cell both boxes cover, in an order that depends only on the input.
+//
+// The buffers are kept between calls, so once they have grown to a frame's
+// size a steady stream of frames allocates nothing.
+class ColliderBroadphase {
+ public:
+  // `cell_size` is in world pixels, and does best around the size of a
+  // typical collider.
+  static absl::StatusOr<ColliderBroadphase> Create(double cell_size);
+
+  // Every overlapping pair among `bounds`, by ColliderBounds::Overlaps. The
+  // span stays valid until the next call.
+  absl::Span<const BroadphasePair> FindPairs(absl::Span<const ColliderBounds> bounds);
+
+ private:
+  explicit ColliderBroadphase(double cell_size) : cell_size_(cell_size) {}
+
+  // The cells a box covers, inclusive. first_column is negative for a box in
+  // oversized_.
+  struct CellRange {
+    int first_column = 0;
+    int first_row = 0;
+    int last_column = 0;
+    int last_row = 0;
+  };
+
+  // A box's place in one cell, with copies of what the pair test reads so a
+  // cell's boxes are tested without chasing indices around the input.
+  struct CellEntry {
+    ColliderBounds bounds;
+    uint32_t index = 0;
+    int first_column = 0;
+    int first_row = 0;
+  };
+
+  double cell_size_ = 0;
+  std::vector<CellRange> ranges_;
+  // Boxes too large for the grid.
+  std::vector<uint32_t> oversized_;
+  // Per cell, row-major: its offset into entries_ while binning, and the
+  // offset of its end once binning is done.
+  std::vector<uint32_t> cell_starts_;
+  std::vector<CellEntry> entries_;
+  std::vector<BroadphasePair> pairs_;
+};
+
+}  // namespace zebes
@@ -0,0 +1,353 @@
+#include "runtime/level_bundle.h"
+
+#include <array>
+#include <bit>
+#include <cerrno>
+#include <cstring>
+#include <optional>
+
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "common/status_macros.h"
+#include "objects/tile_chunk.h"
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace zebes {
+
+static_assert(std::endian::native == std::endian::little,
+              "level bundles are read in place, which assumes a little-endian host");
+
+namespace {
+
+// The highest BundleSectionKind.
+constexpr size_t kSectionKinds = static_cast<size_t>(BundleSectionKind::kParallaxZones);
+
+absl::Status OutOfRange(absl::string_view what) {
+  return absl::DataLossError(absl::StrCat("level bundle ", what, " out of range"));
+}
+
+}  // namespace
+
+uint64_t LevelBundleChecksum(absl::Span<const uint8_t> payload) {
+  uint64_t hash = 14695981039346656037ull;
+  for (size_t i = 0; i + sizeof(uint64_t) <= payload.size(); i += sizeof(uint64_t)) {
+    uint64_t word;
+    std::memcpy(&word, payload.data() + i, sizeof(word));
+    hash = (hash ^ word) * 1099511628211ull;
+    // Multiplying only carries upward; folding the top back down lets a flip in
+    // any bit of any word reach every bit of the result.
+    hash ^= hash >> 29;
+  }
+  return hash;
+}
+
+// A read-only view of a whole file, unmapped on destruction.
+class LevelBundle::MappedFile {
+ public:
+  static absl::StatusOr<std::unique_ptr<MappedFile>> Open(const std::string& path) {
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+      if (GetLastError() == ERROR_FILE_NOT_FOUND || GetLastError() == ERROR_PATH_NOT_FOUND) {
+        return absl::NotFoundError(absl::StrCat("no level bundle at ", path));
+      }
+      return absl::InternalError(
+          absl::StrCat("opening ", path, " failed with Windows error ", GetLastError()));
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+      const DWORD error = GetLastError();
+      CloseHandle(file);
+      return absl::InternalError(
+          absl::StrCat("sizing ", path, " failed with Windows error ", error));
+    }
+    if (static_cast<uint64_t>(size.QuadPart) < sizeof(BundleHeader)) {
+      CloseHandle(file);
+      return absl::DataLossError(absl::StrCat(path, " is too small to be a level bundle"));
+    }
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    // The view keeps the mapping, and the mapping the file, open.
+    CloseHandle(file);
+    if (mapping == nullptr) {
+      return absl::InternalError(
+          absl::StrCat("mapping ", path, " failed with Windows error ", GetLastError()));
+    }
+    void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    const DWORD error = GetLastError();
+    CloseHandle(mapping);
+    if (data == nullptr) {
+      return absl::InternalError(
+          absl::StrCat("mapping ", path, " failed with Windows error ", error));
+    }
+    return std::unique_ptr<MappedFile>(
+        new MappedFile(static_cast<const uint8_t*>(data), static_cast<size_t>(size.QuadPart)));
+#else
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      if (errno == ENOENT) return absl::NotFoundError(absl::StrCat("no level bundle at ", path));
+      return absl::InternalError(absl::StrCat("opening ", path, " failed: ", std::strerror(errno)));
+    }
+    struct stat status;
+    if (::fstat(fd, &status) != 0) {
+      const int error = errno;
+      ::close(fd);
+      return absl::InternalError(absl::StrCat("sizing ", path, " failed: ", std::strerror(error)));
+    }
+    const size_t size = static_cast<size_t>(status.st_size);
+    if (size < sizeof(BundleHeader)) {
+      ::close(fd);
+      return absl::DataLossError(absl::StrCat(path, " is too small to be a level bundle"));
+    }
+    void* data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    const int error = errno;
+    // The mapping holds its own reference to the file.
+    ::close(fd);
+    if (data == MAP_FAILED) {
+      return absl::InternalError(absl::StrCat("mapping ", path, " failed: ", std::strerror(error)));
+    }
+    return std::unique_ptr<MappedFile>(new MappedFile(static_cast<const uint8_t*>(data), size));
+#endif
+  }
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  ~MappedFile() {
+#if defined(_WIN32)
+    UnmapViewOfFile(data_);
+#else
+    ::munmap(const_cast<uint8_t*>(data_), size_);
+#endif
+  }
+
+  absl::Span<const uint8_t> bytes() const { return {data_, size_}; }
+
+ private:
+  MappedFile(const uint8_t* data, size_t size) : data_(data), size_(size) {}
+
+  const uint8_t* data_;
+  size_t size_;
+};
+
+absl::StatusOr<std::unique_ptr<LevelBundle>> LevelBundle::Open(const std::string& path,
+                                                               const LevelBundleOptions& options) {
+  std::unique_ptr<LevelBundle> bundle(new LevelBundle());
+  ASSIGN_OR_RETURN(bundle->file_, MappedFile::Open(path));
+  RETURN_IF_ERROR(bundle->Bind(bundle->file_->bytes(), options));
+  return bundle;
+}
+
+absl::StatusOr<std::unique_ptr<LevelBundle>> LevelBundle::FromBytes(
+    absl::Span<const uint8_t> bytes, const LevelBundleOptions& options) {
+  std::unique_ptr<LevelBundle> bundle(new LevelBundle());
+  bundle->copy_.resize((bytes.size() + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+  if (!bytes.empty()) std::memcpy(bundle->copy_.data(), bytes.data(), bytes.size());
+  RETURN_IF_ERROR(bundle->Bind(
+      {reinterpret_cast<const uint8_t*>(bundle->copy_.data()), bytes.size()}, options));
+  return bundle;
+}
+
+LevelBundle::~LevelBundle() = default;
+
+absl::Span<const uint16_t> LevelBundle::ChunkCells(size_t chunk) const {
+  return chunk_cells_.subspan(chunk * TileChunk::kCells, TileChunk::kCells);
+}
+
+absl::Status LevelBundle::Bind(absl::Span<const uint8_t> bytes, const LevelBundleOptions& options) {
+  if (bytes.size() < sizeof(BundleHeader)) {
+    return absl::DataLossError("level bundle is too small to hold its header");
+  }
+  BundleHeader header;
+  std::memcpy(&header, bytes.data(), sizeof(header));
+  if (std::memcmp(header.magic, kLevelBundleMagic, sizeof(kLevelBundleMagic)) != 0) {
+    return absl::DataLossError("not a level bundle");
+  }
+  if (header.version != kLevelBundleVersion) {
+    return absl::FailedPreconditionError(
+        absl::StrCat("level bundle is format version ", header.version, " but this build reads ",
+                     kLevelBundleVersion, "; recompile it"));
+  }
+  if (header.file_size != bytes.size()) {
+    return absl::DataLossError(absl::StrCat("level bundle is ", bytes.size(),
+                                            " bytes but its header says ", header.file_size));
+  }
+  if (bytes.size() % sizeof(uint64_t) != 0) {
+    return absl::DataLossError("level bundle is not a whole number of words");
+  }
+  if (options.verify_checksum &&
+      LevelBundleChecksum(bytes.subspan(sizeof(BundleHeader))) != header.checksum) {
+    return absl::DataLossError("level bundle checksum mismatch");
+  }
+
+  // The section table.
+  const uint64_t table_end =
+      sizeof(BundleHeader) + static_cast<uint64_t>(header.section_count) * sizeof(BundleSection);
+  if (table_end > bytes.size()) return OutOfRange("section table");
+  std::array<std::optional<BundleSection>, kSectionKinds + 1> sections;
+  for (uint32_t i = 0; i < header.section_count; ++i) {
+    BundleSection section;
+    std::memcpy(&section, bytes.data() + sizeof(BundleHeader) + i * sizeof(BundleSection),
+                sizeof(section));
+    const size_t kind = static_cast<size_t>(section.kind);
+    if (kind == 0 || kind > kSectionKinds) {
+      return absl::DataLossError(absl::StrCat("level bundle has unknown section kind ", kind));
+    }
+    if (sections[kind].has_value()) {
+      return absl::DataLossError(absl::StrCat("level bundle repeats section kind ", kind));
+    }
+    if (section.offset < table_end || section.offset % sizeof(uint64_t) != 0 ||
+        section.record_size == 0 || section.offset > bytes.size() ||
+        section.count > (bytes.size() - section.offset) / section.record_size) {
+      return OutOfRange(absl::StrCat("section ", kind));
+    }
+    sections[kind] = section;
+  }
+  auto records = [&]<typename Record>(BundleSectionKind kind,
+                                      absl::Span<const Record>& out) -> absl::Status {
+    const std::optional<BundleSection>& section = sections[static_cast<size_t>(kind)];
+    if (!section.has_value()) {
+      return absl::DataLossError(
+          absl::StrCat("level bundle has no section of kind ", static_cast<uint32_t>(kind)));
+    }
+    if (section->record_size != sizeof(Record)) {
+      return absl::DataLossError(absl::StrCat("level bundle section ",
+                                              static_cast<uint32_t>(kind), " has ",
+                                              section->record_size, "-byte records, expected ",
+                                              sizeof(Record)));
+    }
+    out = {reinterpret_cast<const Record*>(bytes.data() + section->offset),
+           static_cast<size_t>(section->count)};
+    return absl::OkStatus();
+  };
+
+  absl::Span<const BundleLevel> level;
+  absl::Span<const char> strings;
+  RETURN_IF_ERROR(records(BundleSectionKind::kLevel, level));
+  RETURN_IF_ERROR(records(BundleSectionKind::kStrings, strings));
+  RETURN_IF_ERROR(records(BundleSectionKind::kPixels, pixels_));
+  RETURN_IF_ERROR(records(BundleSectionKind::kTextures, textures_));
+  RETURN_IF_ERROR(records(BundleSectionKind::kTiles, tiles_));
+  RETURN_IF_ERROR(records(BundleSectionKind::kTileTags, tile_tags_));
+  RETURN_IF_ERROR(records(BundleSectionKind::kSprites, sprites_));
+  RETURN_IF_ERROR(records(BundleSectionKind::kSpriteFrames, sprite_frames_));
+  RETURN_IF_ERROR(records(BundleSectionKind::kColliders, colliders_));
+  RETURN_IF_ERROR(records(BundleSectionKind::kPolygons, polygons_));
+  RETURN_IF_ERROR(records(BundleSectionKind::kPoints, points_));
+  RETURN_IF_ERROR(records(BundleSectionKind::kBlueprints, blueprints_));
+  RETURN_IF_ERROR(records(BundleSectionKind::kBlueprintStates, blueprint_states_));
+  RETURN_IF_ERROR(records(BundleSectionKind::kLayers, layers_));
+  RETURN_IF_ERROR(records(BundleSectionKind::kChunks, chunks_));
+  RETURN_IF_ERROR(records(BundleSectionKind::kChunkCells, chunk_cells_));
+  RETURN_IF_ERROR(records(BundleSectionKind::kEntities, entities_));
+  RETURN_IF_ERROR(records(BundleSectionKind::kParallaxThemes, parallax_themes_));
+  RETURN_IF_ERROR(records(BundleSectionKind::kParallaxLayers, parallax_layers_));
+  RETURN_IF_ERROR(records(BundleSectionKind::kParallaxZones, parallax_zones_));
+  if (level.size() != 1) return absl::DataLossError("level bundle must hold exactly one level");
+  level_ = level.front();
+  strings_ = absl::string_view(strings.data(), strings.size());
+
+  // Every reference between records, so the accessors never need checking.
+  auto check_string = [&](BundleString string, absl::string_view what) {
+    if (string.offset > strings_.size() || string.size > strings_.size() - string.offset) {
+      return OutOfRange(what);
+    }
+    return absl::OkStatus();
+  };
+  auto check_run = [](uint64_t first, uint64_t count, size_t size, absl::string_view what) {
+    if (first > size || count > size - first) return OutOfRange(what);
+    return absl::OkStatus();
+  };
+  auto check_index = [](int32_t index, size_t size, absl::string_view what) {
+    if (index != kBundleNone && (index < 0 || static_cast<size_t>(index) >= size)) {
+      return OutOfRange(what);
+    }
+    return absl::OkStatus();
+  };
+
+  RETURN_IF_ERROR(check_string(level_.id, "level ID"));
+  RETURN_IF_ERROR(check_string(level_.name, "level name"));
+  RETURN_IF_ERROR(check_index(level_.tile_atlas, textures_.size(), "tile atlas"));
+  for (const BundleTexture& texture : textures_) {
+    RETURN_IF_ERROR(check_string(texture.id, "texture ID"));
+    if (texture.width < 0 || texture.height < 0) return OutOfRange("texture size");
+    const uint64_t pixel_count = static_cast<uint64_t>(texture.width) * texture.height;
+    if (pixel_count > pixels_.size() / 4) return OutOfRange("texture pixels");
+    RETURN_IF_ERROR(check_run(texture.pixel_offset, pixel_count * 4, pixels_.size(),
+                              "texture pixels"));
+  }
+  for (const BundleTile& tile : tiles_) {
+    RETURN_IF_ERROR(check_run(tile.first_tag, tile.tag_count, tile_tags_.size(), "tile tags"));
+  }
+  for (const BundleString& tag : tile_tags_) RETURN_IF_ERROR(check_string(tag, "tile tag"));
+  for (const BundleSprite& sprite : sprites_) {
+    RETURN_IF_ERROR(check_string(sprite.id, "sprite ID"));
+    RETURN_IF_ERROR(check_index(sprite.texture, textures_.size(), "sprite texture"));
+    RETURN_IF_ERROR(check_run(sprite.first_frame, sprite.frame_count, sprite_frames_.size(),
+                              "sprite frames"));
+  }
+  for (const BundleCollider& collider : colliders_) {
+    RETURN_IF_ERROR(check_string(collider.id, "collider ID"));
+    RETURN_IF_ERROR(check_run(collider.first_polygon, collider.polygon_count, polygons_.size(),
+                              "collider polygons"));
+  }
+  for (const BundlePolygon& polygon : polygons_) {
+    RETURN_IF_ERROR(
+        check_run(polygon.first_point, polygon.point_count, points_.size(), "polygon points"));
+  }
+  for (const BundleBlueprint& blueprint : blueprints_) {
+    RETURN_IF_ERROR(check_string(blueprint.id, "blueprint ID"));
+    RETURN_IF_ERROR(check_run(blueprint.first_state, blueprint.state_count,
+                              blueprint_states_.size(), "blueprint states"));
+  }
+  for (const BundleBlueprintState& state : blueprint_states_) {
+    RETURN_IF_ERROR(check_string(state.name, "blueprint state name"));
+    RETURN_IF_ERROR(check_index(state.sprite, sprites_.size(), "blueprint state sprite"));
+    RETURN_IF_ERROR(check_index(state.collider, colliders_.size(), "blueprint state collider"));
+  }
+  for (const BundleLayer& layer : layers_) {
+    RETURN_IF_ERROR(check_string(layer.name, "layer name"));
+    RETURN_IF_ERROR(
+        check_run(layer.first_chunk, layer.chunk_count, chunks_.size(), "layer chunks"));
+    RETURN_IF_ERROR(
+        check_run(layer.first_entity, layer.entity_count, entities_.size(), "layer entities"));
+  }
+  if (chunk_cells_.size() != chunks_.size() * TileChunk::kCells) {
+    return OutOfRange("chunk cells");
+  }
+  for (const uint16_t cell : chunk_cells_) {
+    if (cell > tiles_.size()) return OutOfRange("chunk cell tile");
+  }
+  for (const BundleEntity& entity : entities_) {
+    RETURN_IF_ERROR(check_index(entity.sprite, sprites_.size(), "entity sprite"));
+    RETURN_IF_ERROR(check_index(entity.collider, colliders_.size(), "entity collider"));
+    RETURN_IF_ERROR(check_index(entity.blueprint, blueprints_.size(), "entity blueprint"));
+  }
+  for (const BundleParallaxTheme& theme : parallax_themes_) {
+    RETURN_IF_ERROR(check_string(theme.name, "parallax theme name"));
+    RETURN_IF_ERROR(check_run(theme.first_layer, theme.layer_count, parallax_layers_.size(),
+                              "parallax theme layers"));
+  }
+  for (const BundleParallaxLayer& layer : parallax_layers_) {
+    RETURN_IF_ERROR(check_string(layer.name, "parallax layer name"));
+    RETURN_IF_ERROR(check_index(layer.texture, textures_.size(), "parallax layer texture"));
+  }
+  for (const BundleParallaxZone& zone : parallax_zones_) {
+    RETURN_IF_ERROR(check_string(zone.name, "parallax zone name"));
+    RETURN_IF_ERROR(check_index(zone.theme, parallax_themes_.size(), "parallax zone theme"));
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace zebes
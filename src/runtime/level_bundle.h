@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "runtime/level_bundle_format.h"
+
+namespace zebes {
+
+struct LevelBundleOptions {
+  // Hash every byte before trusting any of them. A shipped build that already
+  // verified its files at install time can skip the pass and touch only the
+  // pages it reads.
+  bool verify_checksum = true;
+};
+
+// A compiled level, read in place from the bytes CompileLevelBundle wrote.
+//
+// Opening maps the file and checks it: the header, that every section lies
+// inside the file with the record size this build expects, and that every
+// index and range one record holds into another section is in bounds. After
+// that nothing is parsed or copied; the accessors are spans over the mapping,
+// and a record's runs (a sprite's frames, a layer's chunks) are subspans at
+// its first_/count fields, which the checks already proved fit.
+//
+// Damage is DataLoss and a bundle from another format version is
+// FailedPrecondition, since the fix for the latter is to recompile it.
+class LevelBundle {
+ public:
+  static absl::StatusOr<std::unique_ptr<LevelBundle>> Open(const std::string& path,
+                                                           const LevelBundleOptions& options = {});
+
+  // Reads a bundle held in memory, such as one just compiled. The bytes are
+  // copied, so they need not outlive the bundle or be aligned.
+  static absl::StatusOr<std::unique_ptr<LevelBundle>> FromBytes(
+      absl::Span<const uint8_t> bytes, const LevelBundleOptions& options = {});
+
+  LevelBundle(const LevelBundle&) = delete;
+  LevelBundle& operator=(const LevelBundle&) = delete;
+  ~LevelBundle();
+
+  const BundleLevel& level() const { return level_; }
+
+  absl::Span<const BundleTexture> textures() const { return textures_; }
+  absl::Span<const BundleTile> tiles() const { return tiles_; }
+  absl::Span<const BundleString> tile_tags() const { return tile_tags_; }
+  absl::Span<const BundleSprite> sprites() const { return sprites_; }
+  absl::Span<const BundleSpriteFrame> sprite_frames() const { return sprite_frames_; }
+  absl::Span<const BundleCollider> colliders() const { return colliders_; }
+  absl::Span<const BundlePolygon> polygons() const { return polygons_; }
+  absl::Span<const BundlePoint> points() const { return points_; }
+  absl::Span<const BundleBlueprint> blueprints() const { return blueprints_; }
+  absl::Span<const BundleBlueprintState> blueprint_states() const { return blueprint_states_; }
+  absl::Span<const BundleLayer> layers() const { return layers_; }
+  absl::Span<const BundleChunk> chunks() const { return chunks_; }
+  absl::Span<const BundleEntity> entities() const { return entities_; }
+  absl::Span<const BundleParallaxTheme> parallax_themes() const { return parallax_themes_; }
+  absl::Span<const BundleParallaxLayer> parallax_layers() const { return parallax_layers_; }
+  absl::Span<const BundleParallaxZone> parallax_zones() const { return parallax_zones_; }
+
+  absl::string_view String(BundleString string) const {
+    return strings_.substr(string.offset, string.size);
+  }
+
+  // A texture's RGBA8 pixels, width * height * 4 bytes.
+  absl::Span<const uint8_t> Pixels(const BundleTexture& texture) const {
+    return pixels_.subspan(texture.pixel_offset, static_cast<size_t>(texture.width) *
+                                                     static_cast<size_t>(texture.height) * 4);
+  }
+
+  // The TileChunk::kCells cells of chunks()[chunk], row-major.
+  absl::Span<const uint16_t> ChunkCells(size_t chunk) const;
+
+ private:
+  class MappedFile;
+
+  LevelBundle() = default;
+
+  // Points every span into `bytes` and checks everything they hold.
+  absl::Status Bind(absl::Span<const uint8_t> bytes, const LevelBundleOptions& options);
+
+  // Exactly one of these holds the bytes.
+  std::unique_ptr<MappedFile> file_;
+  // Words rather than bytes, so a copied bundle is as aligned as a mapped one.
+  std::vector<uint64_t> copy_;
+
+  BundleLevel level_;
+  absl::string_view strings_;
+  absl::Span<const uint8_t> pixels_;
+  absl::Span<const BundleTexture> textures_;
+  absl::Span<const BundleTile> tiles_;
+  absl::Span<const BundleString> tile_tags_;
+  absl::Span<const BundleSprite> sprites_;
+  absl::Span<const BundleSpriteFrame> sprite_frames_;
+  absl::Span<const BundleCollider> colliders_;
+  absl::Span<const BundlePolygon> polygons_;
+  absl::Span<const BundlePoint> points_;
+  absl::Span<const BundleBlueprint> blueprints_;
+  absl::Span<const BundleBlueprintState> blueprint_states_;
+  absl::Span<const BundleLayer> layers_;
+  absl::Span<const BundleChunk> chunks_;
+  absl::Span<const uint16_t> chunk_cells_;
+  absl::Span<const BundleEntity> entities_;
+  absl::Span<const BundleParallaxTheme> parallax_themes_;
+  absl::Span<const BundleParallaxLayer> parallax_layers_;
+  absl::Span<const BundleParallaxZone> parallax_zones_;
+};
+
+// The checksum BundleHeader::checksum holds: FNV-1a over the payload's
+// little-endian 64-bit words, folded after every word. The payload's size must
+// be a multiple of eight.
+uint64_t LevelBundleChecksum(absl::Span<const uint8_t> payload);
+
+}  // namespace zebes
@@ -0,0 +1,393 @@
+#include "runtime/level_bundle_compiler.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+#include <limits>
+#include <utility>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "common/status_macros.h"
+#include "runtime/level_bundle.h"
+#include "runtime/level_bundle_format.h"
+
+namespace zebes {
+
+static_assert(std::endian::native == std::endian::little,
+              "level bundles are written as they sit in memory, which assumes little-endian");
+
+namespace {
+
+constexpr size_t kSectionCount = static_cast<size_t>(BundleSectionKind::kParallaxZones);
+
+size_t PaddedToWord(size_t size) { return (size + 7) & ~size_t{7}; }
+
+uint32_t Size32(size_t size) { return static_cast<uint32_t>(size); }
+
+// Gathers a level's records in memory, resolving each ID the first time it
+// is reached, and lays them out as a bundle at the end.
+class BundleBuilder {
+ public:
+  explicit BundleBuilder(LevelBundleAssetSource& assets) : assets_(assets) {}
+
+  absl::StatusOr<std::vector<uint8_t>> Compile(const Level& level);
+
+ private:
+  BundleString Intern(absl::string_view string);
+
+  // Each returns the asset's index, adding it on first use. An empty ID is
+  // kBundleNone.
+  absl::StatusOr<int32_t> AddTexture(const std::string& id);
+  absl::StatusOr<int32_t> AddSprite(const std::string& id);
+  absl::StatusOr<int32_t> AddCollider(const std::string& id);
+  absl::StatusOr<int32_t> AddBlueprint(const std::string& id);
+
+  absl::Status AddTileset(const Level& level);
+  absl::Status AddLayer(const Level& level, const WorldLayer& layer);
+  absl::Status AddParallax(const Level& level);
+
+  std::vector<uint8_t> Serialize() const;
+
+  LevelBundleAssetSource& assets_;
+
+  std::string strings_;
+  absl::flat_hash_map<std::string, BundleString> interned_;
+  absl::flat_hash_map<std::string, int32_t> texture_indices_;
+  absl::flat_hash_map<std::string, int32_t> sprite_indices_;
+  absl::flat_hash_map<std::string, int32_t> collider_indices_;
+  absl::flat_hash_map<std::string, int32_t> blueprint_indices_;
+  // Tile ID to the cell value that places it.
+  absl::flat_hash_map<int, uint16_t> tile_cells_;
+
+  BundleLevel level_;
+  std::vector<uint8_t> pixels_;
+  std::vector<BundleTexture> textures_;
+  std::vector<BundleTile> tiles_;
+  std::vector<BundleString> tile_tags_;
+  std::vector<BundleSprite> sprites_;
+  std::vector<BundleSpriteFrame> sprite_frames_;
+  std::vector<BundleCollider> colliders_;
+  std::vector<BundlePolygon> polygons_;
+  std::vector<BundlePoint> points_;
+  std::vector<BundleBlueprint> blueprints_;
+  std::vector<BundleBlueprintState> blueprint_states_;
+  std::vector<BundleLayer> layers_;
+  std::vector<BundleChunk> chunks_;
+  std::vector<uint16_t> chunk_cells_;
+  std::vector<BundleEntity> entities_;
+  std::vector<BundleParallaxTheme> parallax_themes_;
+  std::vector<BundleParallaxLayer> parallax_layers_;
+  std::vector<BundleParallaxZone> parallax_zones_;
+};
+
+absl::StatusOr<std::vector<uint8_t>> BundleBuilder::Compile(const Level& level) {
+  RETURN_IF_ERROR(ValidateLevel(level));
+  level_ = {.id = Intern(level.id),
+            .name = Intern(level.name),
+            .tile_render_width = level.tile_render_width,
+            .tile_render_height = level.tile_render_height,
+            .width = level.width,
+            .height = level.height,
+            .spawn_x = level.spawn_point.x,
+            .spawn_y = level.spawn_point.y};
+  RETURN_IF_ERROR(AddTileset(level));
+  for (const WorldLayer& layer : level.layers) RETURN_IF_ERROR(AddLayer(level, layer));
+  RETURN_IF_ERROR(AddParallax(level));
+  if (strings_.size() > std::numeric_limits<uint32_t>::max()) {
+    return absl::ResourceExhaustedError(
+        absl::StrCat("level ", level.id, " has more string data than a bundle can address"));
+  }
+  return Serialize();
+}
+
+BundleString BundleBuilder::Intern(absl::string_view string) {
+  auto [it, inserted] = interned_.try_emplace(string);
+  if (inserted) {
+    it->second = {.offset = Size32(strings_.size()), .size = Size32(string.size())};
+    strings_.append(string.data(), string.size());
+  }
+  return it->second;
+}
+
+absl::StatusOr<int32_t> BundleBuilder::AddTexture(const std::string& id) {
+  if (id.empty()) return kBundleNone;
+  if (auto it = texture_indices_.find(id); it != texture_indices_.end()) return it->second;
+  ASSIGN_OR_RETURN(const RgbaImage image, assets_.ReadTexturePixels(id));
+  if (!image.IsValid()) {
+    return absl::DataLossError(absl::StrCat("texture ", id, " decoded to invalid pixels"));
+  }
+  const int32_t index = static_cast<int32_t>(textures_.size());
+  textures_.push_back({.id = Intern(id),
+                       .width = image.width,
+                       .height = image.height,
+                       .pixel_offset = pixels_.size()});
+  // Each texture starts on a word, like everything else in a bundle.
+  pixels_.insert(pixels_.end(), image.pixels.begin(), image.pixels.end());
+  pixels_.resize(PaddedToWord(pixels_.size()));
+  texture_indices_[id] = index;
+  return index;
+}
+
+absl::StatusOr<int32_t> BundleBuilder::AddSprite(const std::string& id) {
+  if (id.empty()) return kBundleNone;
+  if (auto it = sprite_indices_.find(id); it != sprite_indices_.end()) return it->second;
+  ASSIGN_OR_RETURN(const Sprite* sprite, assets_.GetSprite(id));
+  ASSIGN_OR_RETURN(const int32_t texture, AddTexture(sprite->texture_id));
+  const int32_t index = static_cast<int32_t>(sprites_.size());
+  sprites_.push_back({.id = Intern(id),
+                      .texture = texture,
+                      .first_frame = Size32(sprite_frames_.size()),
+                      .frame_count = Size32(sprite->frames.size())});
+  for (const SpriteFrame& frame : sprite->frames) {
+    sprite_frames_.push_back({.index = frame.index,
+                              .texture_x = frame.texture_x,
+                              .texture_y = frame.texture_y,
+                              .texture_w = frame.texture_w,
+                              .texture_h = frame.texture_h,
+                              .render_w = frame.render_w,
+                              .render_h = frame.render_h,
+                              .frames_per_cycle = frame.frames_per_cycle,
+                              .offset_x = frame.offset_x,
+                              .offset_y = frame.offset_y});
+  }
+  sprite_indices_[id] = index;
+  return index;
+}
+
+absl::StatusOr<int32_t> BundleBuilder::AddCollider(const std::string& id) {
+  if (id.empty()) return kBundleNone;
+  if (auto it = collider_indices_.find(id); it != collider_indices_.end()) return it->second;
+  ASSIGN_OR_RETURN(const Collider* collider, assets_.GetCollider(id));
+  const int32_t index = static_cast<int32_t>(colliders_.size());
+  colliders_.push_back({.id = Intern(id),
+                        .first_polygon = Size32(polygons_.size()),
+                        .polygon_count = Size32(collider->polygons.size())});
+  for (const Polygon& polygon : collider->polygons) {
+    polygons_.push_back(
+        {.first_point = Size32(points_.size()), .point_count = Size32(polygon.size())});
+    for (const Vec& point : polygon) points_.push_back({.x = point.x, .y = point.y});
+  }
+  collider_indices_[id] = index;
+  return index;
+}
+
+absl::StatusOr<int32_t> BundleBuilder::AddBlueprint(const std::string& id) {
+  if (id.empty()) return kBundleNone;
+  if (auto it = blueprint_indices_.find(id); it != blueprint_indices_.end()) return it->second;
+  ASSIGN_OR_RETURN(const Blueprint* blueprint, assets_.GetBlueprint(id));
+  // States go in as one run, so their sprites and colliders are resolved first.
+  std::vector<BundleBlueprintState> states;
+  for (const Blueprint::State& state : blueprint->states) {
+    ASSIGN_OR_RETURN(const int32_t sprite, AddSprite(state.sprite_id));
+    ASSIGN_OR_RETURN(const int32_t collider, AddCollider(state.collider_id));
+    states.push_back({.name = Intern(state.name), .sprite = sprite, .collider = collider});
+  }
+  const int32_t index = static_cast<int32_t>(blueprints_.size());
+  blueprints_.push_back({.id = Intern(id),
+                         .first_state = Size32(blueprint_states_.size()),
+                         .state_count = Size32(states.size())});
+  blueprint_states_.insert(blueprint_states_.end(), states.begin(), states.end());
+  blueprint_indices_[id] = index;
+  return index;
+}
+
+absl::Status BundleBuilder::AddTileset(const Level& level) {
+  if (level.tileset_id.empty()) return absl::OkStatus();
+  ASSIGN_OR_RETURN(const Tileset* tileset, assets_.GetTileset(level.tileset_id));
+  // Cell values are 16 bits, and zero is taken by "no tile".
+  if (tileset->tiles.size() > std::numeric_limits<uint16_t>::max()) {
+    return absl::ResourceExhaustedError(absl::StrCat("tileset ", tileset->id, " has ",
+                                                     tileset->tiles.size(),
+                                                     " tiles; a bundle holds at most 65535"));
+  }
+  ASSIGN_OR_RETURN(level_.tile_atlas, AddTexture(tileset->texture_id));
+  level_.tile_width = tileset->tile_width;
+  level_.tile_height = tileset->tile_height;
+  for (const Tile& tile : tileset->tiles) {
+    tile_cells_[tile.id] = static_cast<uint16_t>(tiles_.size() + 1);
+    tiles_.push_back({.id = tile.id,
+                      .source_x = tile.source_x,
+                      .source_y = tile.source_y,
+                      .shape = static_cast<uint8_t>(tile.shape),
+                      .is_one_way = tile.is_one_way,
+                      .first_tag = Size32(tile_tags_.size()),
+                      .tag_count = Size32(tile.tags.size())});
+    for (const std::string& tag : tile.tags) tile_tags_.push_back(Intern(tag));
+  }
+  return absl::OkStatus();
+}
+
+absl::Status BundleBuilder::AddLayer(const Level& level, const WorldLayer& layer) {
+  layers_.push_back({.id = layer.id,
+                     .name = Intern(layer.name),
+                     .first_chunk = Size32(chunks_.size()),
+                     .first_entity = Size32(entities_.size())});
+
+  // Hash order is not stable from run to run, so chunks go in by coordinate.
+  std::vector<std::pair<TileChunkCoordinate, const TileChunk*>> chunks;
+  chunks.reserve(layer.tile_chunks.size());
+  for (const auto& [key, chunk] : layer.tile_chunks) {
+    if (!chunk.empty()) chunks.emplace_back(DecodeChunkKey(key), &chunk);
+  }
+  std::sort(chunks.begin(), chunks.end(),
+            [](const auto& a, const auto& b) { return a.first < b.first; });
+  for (const auto& [coordinate, chunk] : chunks) {
+    chunks_.push_back({.x = coordinate.x, .y = coordinate.y});
+    const size_t first_cell = chunk_cells_.size();
+    chunk_cells_.resize(first_cell + TileChunk::kCells, 0);
+    absl::Status status;
+    chunk->ForEachTile([&](int index, int tile_id) {
+      auto it = tile_cells_.find(tile_id);
+      if (it == tile_cells_.end()) {
+        if (status.ok()) {
+          status = absl::NotFoundError(absl::StrCat("level ", level.id, " places tile ", tile_id,
+                                                    " in layer ", layer.id,
+                                                    ", which its tileset does not define"));
+        }
+        return;
+      }
+      chunk_cells_[first_cell + index] = it->second;
+    });
+    RETURN_IF_ERROR(status);
+  }
+  layers_.back().chunk_count = Size32(chunks_.size()) - layers_.back().first_chunk;
+
+  for (const auto& [id, entity] : layer.entities) {
+    ASSIGN_OR_RETURN(const int32_t sprite, AddSprite(entity.sprite_id));
+    ASSIGN_OR_RETURN(const int32_t collider, AddCollider(entity.collider_id));
+    ASSIGN_OR_RETURN(const int32_t blueprint, AddBlueprint(entity.blueprint_id));
+    entities_.push_back({.id = entity.id,
+                         .x = entity.transform.position.x,
+                         .y = entity.transform.position.y,
+                         .drag_x = entity.body.drag.x,
+                         .drag_y = entity.body.drag.y,
+                         .mass = entity.body.mass,
+                         .rotation = entity.transform.rotation,
+                         .sort_order = entity.sort_order,
+                         .sprite = sprite,
+                         .collider = collider,
+                         .blueprint = blueprint,
+                         .blueprint_state = entity.blueprint_state_index,
+                         .active = entity.active,
+                         .is_static = entity.body.is_static});
+  }
+  layers_.back().entity_count = Size32(entities_.size()) - layers_.back().first_entity;
+  return absl::OkStatus();
+}
+
+absl::Status BundleBuilder::AddParallax(const Level& level) {
+  absl::flat_hash_map<int, int32_t> theme_indices;
+  for (const auto& [id, theme] : level.themes) {
+    theme_indices[id] = static_cast<int32_t>(parallax_themes_.size());
+    parallax_themes_.push_back({.id = theme.id,
+                                .name = Intern(theme.name),
+                                .first_layer = Size32(parallax_layers_.size()),
+                                .layer_count = Size32(theme.layers.size())});
+    for (const ParallaxLayer& layer : theme.layers) {
+      ASSIGN_OR_RETURN(const int32_t texture, AddTexture(layer.texture_id));
+      parallax_layers_.push_back({.name = Intern(layer.name),
+                                  .texture = texture,
+                                  .base_scale = layer.base_scale,
+                                  .scroll_x = layer.scroll_factor.x,
+                                  .scroll_y = layer.scroll_factor.y,
+                                  .offset_x = layer.offset.x,
+                                  .offset_y = layer.offset.y,
+                                  .repeat_x = layer.repeat_x,
+                                  .repeat_y = layer.repeat_y});
+    }
+  }
+  for (const ParallaxZone& zone : level.zones) {
+    // ValidateLevel has already refused a zone whose theme does not exist.
+    parallax_zones_.push_back({.id = zone.id,
+                               .theme = theme_indices.at(zone.theme_id),
+                               .name = Intern(zone.name),
+                               .min_x = zone.min_point.x,
+                               .min_y = zone.min_point.y,
+                               .max_x = zone.max_point.x,
+                               .max_y = zone.max_point.y,
+                               .fade_x = zone.fade_length.x,
+                               .fade_y = zone.fade_length.y});
+  }
+  return absl::OkStatus();
+}
+
+std::vector<uint8_t> BundleBuilder::Serialize() const {
+  struct Source {
+    BundleSectionKind kind;
+    uint32_t record_size;
+    const void* data;
+    size_t count;
+  };
+  auto source = [](BundleSectionKind kind, const auto& records) {
+    return Source{.kind = kind,
+                  .record_size = sizeof(records[0]),
+                  .data = records.data(),
+                  .count = records.size()};
+  };
+  const std::array<Source, kSectionCount> sources = {
+      Source{.kind = BundleSectionKind::kLevel,
+             .record_size = sizeof(BundleLevel),
+             .data = &level_,
+             .count = 1},
+      source(BundleSectionKind::kStrings, strings_),
+      source(BundleSectionKind::kTextures, textures_),
+      source(BundleSectionKind::kPixels, pixels_),
+      source(BundleSectionKind::kTiles, tiles_),
+      source(BundleSectionKind::kTileTags, tile_tags_),
+      source(BundleSectionKind::kSprites, sprites_),
+      source(BundleSectionKind::kSpriteFrames, sprite_frames_),
+      source(BundleSectionKind::kColliders, colliders_),
+      source(BundleSectionKind::kPolygons, polygons_),
+      source(BundleSectionKind::kPoints, points_),
+      source(BundleSectionKind::kBlueprints, blueprints_),
+      source(BundleSectionKind::kBlueprintStates, blueprint_states_),
+      source(BundleSectionKind::kLayers, layers_),
+      source(BundleSectionKind::kChunks, chunks_),
+      source(BundleSectionKind::kChunkCells, chunk_cells_),
+      source(BundleSectionKind::kEntities, entities_),
+      source(BundleSectionKind::kParallaxThemes, parallax_themes_),
+      source(BundleSectionKind::kParallaxLayers, parallax_layers_),
+      source(BundleSectionKind::kParallaxZones, parallax_zones_),
+  };
+
+  size_t size = sizeof(BundleHeader) + kSectionCount * sizeof(BundleSection);
+  std::array<BundleSection, kSectionCount> table;
+  for (size_t i = 0; i < kSectionCount; ++i) {
+    table[i] = {.kind = sources[i].kind,
+                .record_size = sources[i].record_size,
+                .offset = size,
+                .count = sources[i].count};
+    size += PaddedToWord(sources[i].count * sources[i].record_size);
+  }
+
+  // Zero-filled, so padding between sections is deterministic.
+  std::vector<uint8_t> bytes(size, 0);
+  std::memcpy(bytes.data() + sizeof(BundleHeader), table.data(), sizeof(table));
+  for (size_t i = 0; i < kSectionCount; ++i) {
+    if (sources[i].count == 0) continue;
+    std::memcpy(bytes.data() + table[i].offset, sources[i].data,
+                sources[i].count * sources[i].record_size);
+  }
+  BundleHeader header;
+  std::memcpy(header.magic, kLevelBundleMagic, sizeof(header.magic));
+  header.version = kLevelBundleVersion;
+  header.section_count = static_cast<uint32_t>(kSectionCount);
+  header.file_size = size;
+  header.checksum =
+      LevelBundleChecksum(absl::MakeConstSpan(bytes).subspan(sizeof(BundleHeader)));
+  std::memcpy(bytes.data(), &header, sizeof(header));
+  return bytes;
+}
+
+}  // namespace
+
+absl::StatusOr<std::vector<uint8_t>> CompileLevelBundle(const Level& level,
+                                                        LevelBundleAssetSource& assets) {
+  return BundleBuilder(assets).Compile(level);
+}
+
+}  // namespace zebes
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "common/image_io.h"
+#include "objects/blueprint.h"
+#include "objects/collider.h"
+#include "objects/level.h"
+#include "objects/sprite.h"
+#include "objects/tileset.h"
+
+namespace zebes {
+
+// Where CompileLevelBundle finds what a level refers to by ID. The asset tool
+// answers from the resource managers; tests answer from plain maps.
+//
+// A missing asset is NotFound, and stops the compile.
+class LevelBundleAssetSource {
+ public:
+  virtual ~LevelBundleAssetSource() = default;
+
+  virtual absl::StatusOr<const Tileset*> GetTileset(const std::string& id) = 0;
+  virtual absl::StatusOr<const Sprite*> GetSprite(const std::string& id) = 0;
+  virtual absl::StatusOr<const Collider*> GetCollider(const std::string& id) = 0;
+  virtual absl::StatusOr<const Blueprint*> GetBlueprint(const std::string& id) = 0;
+  // A texture's decoded pixels.
+  virtual absl::StatusOr<RgbaImage> ReadTexturePixels(const std::string& texture_id) = 0;
+};
+
+// Compiles a level and everything it references into the bytes of one level
+// bundle (see level_bundle_format.h), for LevelBundle to read back.
+//
+// Only referenced assets are included, each once, in the order the level
+// first reaches them: the tileset's atlas, then layer by layer the chunks by
+// (y, x) and the entities by ID, then the parallax themes and zones. Empty
+// chunks are dropped. The same level and assets therefore always compile to
+// the same bytes.
+//
+// The level must pass ValidateLevel. Beyond that, every ID it or its assets
+// hold must resolve, and every tile it places must be in its tileset.
+absl::StatusOr<std::vector<uint8_t>> CompileLevelBundle(const Level& level,
+                                                        LevelBundleAssetSource& assets);
+
+}  // namespace zebes
@@ -0,0 +1,247 @@
+#pragma once
+
+#include <cstdint>
+
+namespace zebes {
+
+// The on-disk layout of a compiled level bundle: one file holding a level and
+// every asset it references, with string IDs resolved to dense indices.
+//
+// A bundle is a header, a table of sections, then the sections themselves.
+// Each section is an array of one fixed-size record type starting on an
+// 8-byte boundary, so once mapped into memory it is used where it lies: the
+// only work on open is checking the bytes and turning offsets into spans.
+// Records point at each other by index into a section, never by address, so
+// the file can be mapped anywhere. Integers are little-endian.
+//
+// Anything that changes a record's layout or meaning bumps kLevelBundleVersion.
+// Bundles are build outputs, recompiled from the JSON definitions whenever
+// those change, so an old version is refused rather than migrated.
+
+inline constexpr char kLevelBundleMagic[8] = {'Z', 'B', 'L', 'E', 'V', 'E', 'L', '\0'};
+inline constexpr uint32_t kLevelBundleVersion = 1;
+
+// Index of nothing, for optional references.
+inline constexpr int32_t kBundleNone = -1;
+
+struct BundleHeader {
+  char magic[8];
+  uint32_t version = 0;
+  uint32_t section_count = 0;
+  // Of the whole file, header included.
+  uint64_t file_size = 0;
+  // LevelBundleChecksum of every byte after the header. Sections are padded
+  // to 8 bytes, so those bytes are whole 64-bit words.
+  uint64_t checksum = 0;
+};
+
+enum class BundleSectionKind : uint32_t {
+  kLevel = 1,
+  kStrings = 2,
+  kTextures = 3,
+  kPixels = 4,
+  kTiles = 5,
+  kTileTags = 6,
+  kSprites = 7,
+  kSpriteFrames = 8,
+  kColliders = 9,
+  kPolygons = 10,
+  kPoints = 11,
+  kBlueprints = 12,
+  kBlueprintStates = 13,
+  kLayers = 14,
+  kChunks = 15,
+  kChunkCells = 16,
+  kEntities = 17,
+  kParallaxThemes = 18,
+  kParallaxLayers = 19,
+  kParallaxZones = 20,
+};
+
+struct BundleSection {
+  BundleSectionKind kind = BundleSectionKind::kLevel;
+  // sizeof the record type the writer used, checked against the reader's.
+  uint32_t record_size = 0;
+  // From the start of the file.
+  uint64_t offset = 0;
+  uint64_t count = 0;
+};
+
+// A run of bytes in the strings section. Not NUL-terminated.
+struct BundleString {
+  uint32_t offset = 0;
+  uint32_t size = 0;
+};
+
+// The single record of the kLevel section.
+struct BundleLevel {
+  BundleString id;
+  BundleString name;
+  int32_t tile_render_width = 0;
+  int32_t tile_render_height = 0;
+  double width = 0;
+  double height = 0;
+  double spawn_x = 0;
+  double spawn_y = 0;
+  // The tileset's atlas, or kBundleNone for a level without a tileset.
+  int32_t tile_atlas = kBundleNone;
+  int32_t tile_width = 0;
+  int32_t tile_height = 0;
+  uint32_t padding = 0;
+};
+
+// RGBA8 pixels, tightly packed, at pixel_offset in the pixels section.
+struct BundleTexture {
+  BundleString id;
+  int32_t width = 0;
+  int32_t height = 0;
+  uint64_t pixel_offset = 0;
+};
+
+struct BundleTile {
+  int32_t id = 0;
+  int32_t source_x = 0;
+  int32_t source_y = 0;
+  uint8_t shape = 0;
+  uint8_t is_one_way = 0;
+  uint16_t padding = 0;
+  // Into the tile tags section, which holds BundleStrings.
+  uint32_t first_tag = 0;
+  uint32_t tag_count = 0;
+};
+
+struct BundleSprite {
+  BundleString id;
+  int32_t texture = kBundleNone;
+  uint32_t first_frame = 0;
+  uint32_t frame_count = 0;
+  uint32_t padding = 0;
+};
+
+// SpriteFrame, field for field.
+struct BundleSpriteFrame {
+  int32_t index = 0;
+  int32_t texture_x = 0;
+  int32_t texture_y = 0;
+  int32_t texture_w = 0;
+  int32_t texture_h = 0;
+  int32_t render_w = 0;
+  int32_t render_h = 0;
+  int32_t frames_per_cycle = 0;
+  int32_t offset_x = 0;
+  int32_t offset_y = 0;
+};
+
+struct BundleCollider {
+  BundleString id;
+  uint32_t first_polygon = 0;
+  uint32_t polygon_count = 0;
+};
+
+struct BundlePolygon {
+  uint32_t first_point = 0;
+  uint32_t point_count = 0;
+};
+
+struct BundlePoint {
+  double x = 0;
+  double y = 0;
+};
+
+struct BundleBlueprint {
+  BundleString id;
+  uint32_t first_state = 0;
+  uint32_t state_count = 0;
+};
+
+struct BundleBlueprintState {
+  BundleString name;
+  int32_t sprite = kBundleNone;
+  int32_t collider = kBundleNone;
+};
+
+// A WorldLayer, back to front. Its chunks and entities are contiguous runs.
+struct BundleLayer {
+  int32_t id = 0;
+  uint32_t padding = 0;
+  BundleString name;
+  uint32_t first_chunk = 0;
+  uint32_t chunk_count = 0;
+  uint32_t first_entity = 0;
+  uint32_t entity_count = 0;
+};
+
+// A non-empty TileChunk. Its cells are TileChunk::kCells uint16 values at
+// index * kCells in the chunk cells section, row-major: zero for no tile,
+// otherwise one more than an index into the tiles section.
+struct BundleChunk {
+  int32_t x = 0;
+  int32_t y = 0;
+};
+
+struct BundleEntity {
+  uint64_t id = 0;
+  double x = 0;
+  double y = 0;
+  double drag_x = 0;
+  double drag_y = 0;
+  double mass = 0;
+  float rotation = 0;
+  int32_t sort_order = 0;
+  int32_t sprite = kBundleNone;
+  int32_t collider = kBundleNone;
+  int32_t blueprint = kBundleNone;
+  int32_t blueprint_state = 0;
+  uint8_t active = 0;
+  uint8_t is_static = 0;
+  uint16_t padding = 0;
+  uint32_t padding2 = 0;
+};
+
+struct BundleParallaxTheme {
+  int32_t id = 0;
+  uint32_t padding = 0;
+  BundleString name;
+  uint32_t first_layer = 0;
+  uint32_t layer_count = 0;
+};
+
+struct BundleParallaxLayer {
+  BundleString name;
+  int32_t texture = kBundleNone;
+  float base_scale = 1.0f;
+  double scroll_x = 0;
+  double scroll_y = 0;
+  double offset_x = 0;
+  double offset_y = 0;
+  uint8_t repeat_x = 0;
+  uint8_t repeat_y = 0;
+  uint16_t padding = 0;
+  uint32_t padding2 = 0;
+};
+
+struct BundleParallaxZone {
+  int32_t id = 0;
+  // Into the parallax themes section, or kBundleNone.
+  int32_t theme = kBundleNone;
+  BundleString name;
+  double min_x = 0;
+  double min_y = 0;
+  double max_x = 0;
+  double max_y = 0;
+  double fade_x = 0;
+  double fade_y = 0;
+};
+
+static_assert(sizeof(BundleHeader) % 8 == 0 && sizeof(BundleSection) % 8 == 0 &&
+                  sizeof(BundleLevel) % 8 == 0 && sizeof(BundleTexture) % 8 == 0 &&
+                  sizeof(BundleTile) % 8 == 0 && sizeof(BundleSprite) % 8 == 0 &&
+                  sizeof(BundleSpriteFrame) % 8 == 0 && sizeof(BundleCollider) % 8 == 0 &&
+                  sizeof(BundlePolygon) % 8 == 0 && sizeof(BundlePoint) % 8 == 0 &&
+                  sizeof(BundleBlueprint) % 8 == 0 && sizeof(BundleBlueprintState) % 8 == 0 &&
+                  sizeof(BundleLayer) % 8 == 0 && sizeof(BundleChunk) % 8 == 0 &&
+                  sizeof(BundleEntity) % 8 == 0 && sizeof(BundleParallaxTheme) % 8 == 0 &&
+                  sizeof(BundleParallaxLayer) % 8 == 0 && sizeof(BundleParallaxZone) % 8 == 0,
+              "bundle records must keep every section 8-byte aligned");
+
+}  // namespace zebes
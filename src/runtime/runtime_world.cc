@@ -0,0 +1,223 @@
+#include "runtime/runtime_world.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "absl/log/absl_check.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "common/status_macros.h"
+
+namespace zebes {
+namespace {
+
+void AppendEntity(const Entity& entity, RuntimeEntities& entities) {
+  entities.ids.push_back(entity.id);
+  entities.position_x.push_back(entity.transform.position.x);
+  entities.position_y.push_back(entity.transform.position.y);
+  // Motion is never authored, so every entity starts at rest.
+  entities.velocity_x.push_back(0);
+  entities.velocity_y.push_back(0);
+  entities.acceleration_x.push_back(0);
+  entities.acceleration_y.push_back(0);
+  entities.drag_x.push_back(entity.body.drag.x);
+  entities.drag_y.push_back(entity.body.drag.y);
+  entities.mass.push_back(entity.body.mass);
+  entities.is_static.push_back(entity.body.is_static ? 1 : 0);
+}
+
+}  // namespace
+
+absl::StatusOr<std::unique_ptr<RuntimeWorld>> RuntimeWorld::Create(
+    const Level& level, const RuntimeWorldOptions& options) {
+  if (options.timestep <= absl::ZeroDuration()) {
+    return absl::InvalidArgumentError(absl::StrCat("runtime timestep must be positive, got ",
+                                                   absl::FormatDuration(options.timestep)));
+  }
+  if (options.worker_threads < 0) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "runtime world cannot have ", options.worker_threads, " worker threads"));
+  }
+  if (options.max_steps_per_advance <= 0) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "runtime world must allow at least one step per advance, got ",
+        options.max_steps_per_advance));
+  }
+
+  size_t live_count = 0;
+  for (const WorldLayer& layer : level.layers) {
+    for (const auto& [id, entity] : layer.entities) {
+      if (entity.active) ++live_count;
+    }
+  }
+
+  RuntimeEntities entities;
+  entities.ids.reserve(live_count);
+  entities.position_x.reserve(live_count);
+  entities.position_y.reserve(live_count);
+  entities.velocity_x.reserve(live_count);
+  entities.velocity_y.reserve(live_count);
+  entities.acceleration_x.reserve(live_count);
+  entities.acceleration_y.reserve(live_count);
+  entities.drag_x.reserve(live_count);
+  entities.drag_y.reserve(live_count);
+  entities.mass.reserve(live_count);
+  entities.is_static.reserve(live_count);
+
+  // Two passes rather than a sort, so each half keeps level order without a
+  // comparator having to reconstruct it.
+  for (const bool want_static : {false, true}) {
+    for (const WorldLayer& layer : level.layers) {
+      for (const auto& [id, entity] : layer.entities) {
+        if (!entity.active || entity.body.is_static != want_static) continue;
+        AppendEntity(entity, entities);
+      }
+    }
+    if (!want_static) entities.dynamic_count = entities.size();
+  }
+
+  absl::flat_hash_map<uint64_t, size_t> index_by_id;
+  index_by_id.reserve(entities.size());
+  for (size_t i = 0; i < entities.size(); ++i) {
+    if (!index_by_id.emplace(entities.ids[i], i).second) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("level ", level.name_id(), " places entity ", entities.ids[i], " twice"));
+    }
+  }
+
+  std::unique_ptr<RuntimeWorld> world(
+      new RuntimeWorld(options, std::move(entities), std::move(index_by_id)));
+  if (options.worker_threads > 0) {
+    ASSIGN_OR_RETURN(world->scheduler_,
+                     TickScheduler::Create(world->IntegrationSystems(),
+                                           {.worker_threads = options.worker_threads}));
+  }
+  return world;
+}
+
+RuntimeWorld::RuntimeWorld(const RuntimeWorldOptions& options, RuntimeEntities entities,
+                           absl::flat_hash_map<uint64_t, size_t> index_by_id)
+    : options_(options),
+      timestep_(absl::ToDoubleSeconds(options.timestep)),
+      entities_(std::move(entities)),
+      index_by_id_(std::move(index_by_id)) {}
+
+int RuntimeWorld::Advance(absl::Duration elapsed) {
+  if (elapsed > absl::ZeroDuration()) accumulated_ += elapsed;
+
+  int steps = 0;
+  while (accumulated_ >= options_.timestep && steps < options_.max_steps_per_advance) {
+    Step();
+    accumulated_ -= options_.timestep;
+    ++steps;
+  }
+  // Whatever a stalled host still owes is forgiven rather than carried, so the
+  // next frame starts at most one step behind.
+  if (accumulated_ >= options_.timestep) accumulated_ %= options_.timestep;
+  return steps;
+}
+
+void RuntimeWorld::Step() {
+  if (scheduler_ != nullptr) {
+    // The integration systems neither fail nor throw.
+    ABSL_CHECK_OK(scheduler_->Tick());
+  } else {
+    IntegrateAxis(entities_.position_x, entities_.velocity_x, entities_.acceleration_x,
+                  entities_.drag_x);
+    IntegrateAxis(entities_.position_y, entities_.velocity_y, entities_.acceleration_y,
+                  entities_.drag_y);
+  }
+  ++step_count_;
+}
+
+void RuntimeWorld::IntegrateAxis(std::vector<double>& position, std::vector<double>& velocity,
+                                 const std::vector<double>& acceleration,
+                                 const std::vector<double>& drag) {
+  const double dt = timestep_;
+  const size_t count = entities_.dynamic_count;
+  // One axis at a time, so the loop streams through four arrays and nothing
+  // else.
+  double* p = position.data();
+  double* v = velocity.data();
+  const double* a = acceleration.data();
+  const double* d = drag.data();
+
+  // Drag removes at most all of a body's velocity in one step; a larger
+  // product would reverse it instead.
+  for (size_t i = 0; i < count; ++i) {
+    const double damping = std::max(0.0, 1.0 - d[i] * dt);
+    v[i] = (v[i] + a[i] * dt) * damping;
+    p[i] += v[i] * dt;
+  }
+}
+
+std::vector<TickSystem> RuntimeWorld::IntegrationSystems() {
+  auto resources = [](std::initializer_list<RuntimeArray> arrays) {
+    std::vector<TickResource> resources;
+    for (const RuntimeArray array : arrays) resources.push_back(static_cast<TickResource>(array));
+    return resources;
+  };
+
+  std::vector<TickSystem> systems;
+  systems.push_back({
+      .name = "integrate_x",
+      .reads = resources({RuntimeArray::kAccelerationX, RuntimeArray::kDragX}),
+      .writes = resources({RuntimeArray::kPositionX, RuntimeArray::kVelocityX}),
+      .run =
+          [this] {
+            IntegrateAxis(entities_.position_x, entities_.velocity_x, entities_.acceleration_x,
+                          entities_.drag_x);
+            return absl::OkStatus();
+          },
+  });
+  systems.push_back({
+      .name = "integrate_y",
+      .reads = resources({RuntimeArray::kAccelerationY, RuntimeArray::kDragY}),
+      .writes = resources({RuntimeArray::kPositionY, RuntimeArray::kVelocityY}),
+      .run =
+          [this] {
+            IntegrateAxis(entities_.position_y, entities_.velocity_y, entities_.acceleration_y,
+                          entities_.drag_y);
+            return absl::OkStatus();
+          },
+  });
+  return systems;
+}
+
+double RuntimeWorld::interpolation() const {
+  return absl::FDivDuration(accumulated_, options_.timestep);
+}
+
+std::optional<size_t> RuntimeWorld::IndexOf(uint64_t entity_id) const {
+  auto it = index_by_id_.find(entity_id);
+  if (it == index_by_id_.end()) return std::nullopt;
+  return it->second;
+}
+
+Vec RuntimeWorld::position(size_t index) const {
+  return {.x = entities_.position_x[index], .y = entities_.position_y[index]};
+}
+
+Vec RuntimeWorld::velocity(size_t index) const {
+  return {.x = entities_.velocity_x[index], .y = entities_.velocity_y[index]};
+}
+
+void RuntimeWorld::SetAcceleration(size_t index, Vec acceleration) {
+  if (entities_.is_static[index] != 0) return;
+  entities_.acceleration_x[index] = acceleration.x;
+  entities_.acceleration_y[index] = acceleration.y;
+}
+
+void RuntimeWorld::SetVelocity(size_t index, Vec velocity) {
+  if (entities_.is_static[index] != 0) return;
+  entities_.velocity_x[index] = velocity.x;
+  entities_.velocity_y[index] = velocity.y;
+}
+
+}  // namespace zebes
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/statusor.h"
+#include "absl/time/time.h"
+#include "common/tick_scheduler.h"
+#include "objects/level.h"
+#include "objects/vec.h"
+
+namespace zebes {
+
+struct RuntimeWorldOptions {
+  // Simulated time per step. Every step integrates exactly this much, so a run
+  // is reproducible whatever the frame rate that drove it.
+  absl::Duration timestep = absl::Seconds(1) / 60;
+
+  // The most steps one Advance may take. A host that stalls would otherwise
+  // owe a burst of steps that takes longer than the stall, and fall further
+  // behind every frame; past this many the backlog is dropped instead.
+  int max_steps_per_advance = 8;
+
+  // Pool threads a step may run its systems on besides the calling one. Zero
+  // steps on the caller alone, without a scheduler; any count gives the same
+  // result.
+  int worker_threads = 0;
+};
+
+// The packed arrays of RuntimeEntities, as the resources a TickScheduler
+// orders systems by.
+enum class RuntimeArray : TickResource {
+  kPositionX,
+  kPositionY,
+  kVelocityX,
+  kVelocityY,
+  kAccelerationX,
+  kAccelerationY,
+  kDragX,
+  kDragY,
+  kMass,
+  kIsStatic,
+};
+
+// A level's entities as the running game sees them: one packed array per
+// field, so a pass that reads positions and velocities touches nothing else.
+//
+// Dynamic bodies come first and static bodies after them, each in level order
+// (layer by layer, then by ID), so integration is one branch-free loop over
+// [0, dynamic_count). An entity's index is fixed for the life of the world.
+struct RuntimeEntities {
+  size_t dynamic_count = 0;
+
+  std::vector<uint64_t> ids;
+  std::vector<double> position_x;
+  std::vector<double> position_y;
+  std::vector<double> velocity_x;
+  std::vector<double> velocity_y;
+  std::vector<double> acceleration_x;
+  std::vector<double> acceleration_y;
+  std::vector<double> drag_x;
+  std::vector<double> drag_y;
+  std::vector<double> mass;
+  std::vector<uint8_t> is_static;
+
+  size_t size() const { return ids.size(); }
+};
+
+// A headless simulation of one level. It owns nothing but plain arrays, so it
+// runs without a renderer, an editor, or any asset manager, and the same world
+// can be stepped by the game loop, a test, or a benchmark.
+//
+// The level is read once, at creation. Entities that are soft-deleted
+// (Entity::active false) are not instantiated.
+class RuntimeWorld {
+ public:
+  static absl::StatusOr<std::unique_ptr<RuntimeWorld>> Create(
+      const Level& level, const RuntimeWorldOptions& options = {});
+
+  RuntimeWorld(const RuntimeWorld&) = delete;
+  RuntimeWorld& operator=(const RuntimeWorld&) = delete;
+
+  // Banks `elapsed` wall time and takes every fixed step it pays for, up to
+  // max_steps_per_advance. Time left over is carried into the next call.
+  // Returns the number of steps taken.
+  int Advance(absl::Duration elapsed);
+
+  // One fixed step: semi-implicit Euler with per-axis linear drag. Velocity is
+  // updated from acceleration first and position from the new velocity, which
+  // keeps orbits and springs from gaining energy the way explicit Euler does.
+  //
+  // The axes share no array, so with worker_threads they integrate as two
+  // systems at once.
+  void Step();
+
+  // How far the carried time has progressed into the next step, in [0, 1).
+  // A renderer blends the last two states by this to draw between steps.
+  double interpolation() const;
+
+  int64_t step_count() const { return step_count_; }
+  absl::Duration timestep() const { return options_.timestep; }
+
+  const RuntimeEntities& entities() const { return entities_; }
+
+  // The scheduler stepping the world, for its per-system timings. Null without
+  // worker_threads.
+  const TickScheduler* scheduler() const { return scheduler_.get(); }
+
+  // Index of a live entity, for callers holding a level entity ID.
+  std::optional<size_t> IndexOf(uint64_t entity_id) const;
+
+  Vec position(size_t index) const;
+  Vec velocity(size_t index) const;
+
+  // Both are ignored for static bodies, which never move. An acceleration
+  // holds until it is overwritten, so gravity is set once, not every step.
+  void SetAcceleration(size_t index, Vec acceleration);
+  void SetVelocity(size_t index, Vec velocity);
+
+ private:
+  RuntimeWorld(const RuntimeWorldOptions& options, RuntimeEntities entities,
+               absl::flat_hash_map<uint64_t, size_t> index_by_id);
+
+  // Integrates one axis of every dynamic body.
+  void IntegrateAxis(std::vector<double>& position, std::vector<double>& velocity,
+                     const std::vector<double>& acceleration, const std::vector<double>& drag);
+  std::vector<TickSystem> IntegrationSystems();
+
+  const RuntimeWorldOptions options_;
+  // The timestep in seconds, which is what the integrator multiplies by.
+  const double timestep_;
+  RuntimeEntities entities_;
+  absl::flat_hash_map<uint64_t, size_t> index_by_id_;
+  // Banked wall time not yet spent on a step. Kept as a Duration, whose ticks
+  // are exact, so a long session does not drift off the step grid.
+  absl::Duration accumulated_ = absl::ZeroDuration();
+  int64_t step_count_ = 0;
+  // Declared last: its systems point into the arrays above, and its pool must
+  // stop before they go.
+  std::unique_ptr<TickScheduler> scheduler_;
+};
+
+}  // namespace zebes
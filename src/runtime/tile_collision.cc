@@ -0,0 +1,321 @@
+#include "runtime/tile_collision.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <optional>
+
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/types/span.h"
+#include "objects/tile_shape_geometry.h"
+
+namespace zebes {
+namespace {
+
+constexpr uint8_t kOneWayBit = 0x80;
+constexpr uint8_t kShapeMask = 0x7f;
+constexpr size_t kTileShapeCount = std::size(kTileShapeIdentifiers);
+static_assert(kTileShapeCount <= kShapeMask + 1, "a TileShape must fit beside kOneWayBit");
+
+constexpr double kInfinity = std::numeric_limits<double>::infinity();
+
+// A separating-axis candidate: a unit direction in normalized tile space and
+// the extent of the tile's polygon along it.
+struct ShapeAxis {
+  double x = 0;
+  double y = 0;
+  double min = 0;
+  double max = 0;
+};
+
+// Every axis that can separate a box from one TileShape: the box's own two,
+// then each polygon edge normal not parallel to one already listed. Polygons
+// have at most four edges, so six axes always suffice.
+struct ShapeEdges {
+  std::array<ShapeAxis, 6> axes;
+  int count = 0;
+};
+
+ShapeEdges BuildShapeEdges(TileShape shape) {
+  ShapeEdges edges;
+  absl::Span<const TilePoint> polygon = TileShapePolygon(shape);
+  if (polygon.empty()) return edges;
+
+  auto add_axis = [&](double x, double y) {
+    const double length = std::hypot(x, y);
+    x /= length;
+    y /= length;
+    for (int i = 0; i < edges.count; ++i) {
+      if (std::abs(edges.axes[i].x * y - edges.axes[i].y * x) < 1e-9) return;
+    }
+    ShapeAxis axis{.x = x, .y = y, .min = kInfinity, .max = -kInfinity};
+    for (const TilePoint& point : polygon) {
+      const double projection = x * point.x + y * point.y;
+      axis.min = std::min(axis.min, projection);
+      axis.max = std::max(axis.max, projection);
+    }
+    edges.axes[edges.count++] = axis;
+  };
+  add_axis(1, 0);
+  add_axis(0, 1);
+  for (size_t i = 0; i < polygon.size(); ++i) {
+    const TilePoint& from = polygon[i];
+    const TilePoint& to = polygon[(i + 1) % polygon.size()];
+    add_axis(to.y - from.y, from.x - to.x);
+  }
+  return edges;
+}
+
+// Built on first use, from TileShapePolygon, so the two can never disagree.
+const std::array<ShapeEdges, kTileShapeCount>& ShapeEdgeTable() {
+  static const std::array<ShapeEdges, kTileShapeCount> table = [] {
+    std::array<ShapeEdges, kTileShapeCount> edges;
+    for (size_t shape = 0; shape < kTileShapeCount; ++shape) {
+      edges[shape] = BuildShapeEdges(static_cast<TileShape>(shape));
+    }
+    return edges;
+  }();
+  return table;
+}
+
+// A box sweeping through cell space, where one tile is one unit on each axis.
+struct CellSweep {
+  double center_x = 0;
+  double center_y = 0;
+  double half_x = 0;
+  double half_y = 0;
+  double delta_x = 0;
+  double delta_y = 0;
+};
+
+// The contact of a sweep with one cell's polygon.
+struct CellContact {
+  double time = 0;
+  // Cell-space normal; zero when the box started inside.
+  double normal_x = 0;
+  double normal_y = 0;
+};
+
+// Swept separating-axis test against the polygon of the cell at (x, y). For
+// each axis the box is separated before `enter` and after `exit`; the box and
+// polygon overlap exactly when every axis does, so contact is the latest
+// enter, provided it comes before the earliest exit and before `limit`.
+std::optional<CellContact> SweepCell(const ShapeEdges& edges, int x, int y, const CellSweep& sweep,
+                                     double limit) {
+  double enter = -kInfinity;
+  double exit = kInfinity;
+  CellContact contact;
+  for (int i = 0; i < edges.count; ++i) {
+    const ShapeAxis& axis = edges.axes[i];
+    const double offset = axis.x * x + axis.y * y;
+    const double polygon_min = axis.min + offset;
+    const double polygon_max = axis.max + offset;
+    const double center = axis.x * sweep.center_x + axis.y * sweep.center_y;
+    const double radius = std::abs(axis.x) * sweep.half_x + std::abs(axis.y) * sweep.half_y;
+    const double box_min = center - radius;
+    const double box_max = center + radius;
+    const double velocity = axis.x * sweep.delta_x + axis.y * sweep.delta_y;
+
+    // A shape with no extent along an axis can only ever touch the polygon
+    // there, so resting against it counts as overlap. Otherwise a point could
+    // run along the seam between two solid tiles without entering either.
+    const bool touch_overlaps = radius == 0 && velocity == 0;
+
+    double axis_enter = -kInfinity;
+    double axis_exit = kInfinity;
+    double side = 0;
+    if (box_max < polygon_min || (box_max == polygon_min && !touch_overlaps)) {
+      if (velocity <= 0) return std::nullopt;
+      axis_enter = (polygon_min - box_max) / velocity;
+      axis_exit = (polygon_max - box_min) / velocity;
+      side = -1;
+    } else if (box_min > polygon_max || (box_min == polygon_max && !touch_overlaps)) {
+      if (velocity >= 0) return std::nullopt;
+      axis_enter = (polygon_max - box_min) / velocity;
+      axis_exit = (polygon_min - box_max) / velocity;
+      side = 1;
+    } else if (velocity > 0) {
+      axis_exit = (polygon_max - box_min) / velocity;
+    } else if (velocity < 0) {
+      axis_exit = (polygon_min - box_max) / velocity;
+    }
+
+    if (axis_enter > enter) {
+      enter = axis_enter;
+      contact.normal_x = side * axis.x;
+      contact.normal_y = side * axis.y;
+    }
+    exit = std::min(exit, axis_exit);
+    if (enter >= exit || enter >= limit) return std::nullopt;
+  }
+  contact.time = std::max(enter, 0.0);
+  return contact;
+}
+
+// The interval of [0, 1) during which a moving span [low, high] + delta * t
+// overlaps the unit strip [cell, cell + 1].
+struct Interval {
+  double begin = 0;
+  double end = 1;
+};
+
+Interval StripInterval(double low, double high, double delta, int cell) {
+  if (delta == 0) return {.begin = 0, .end = 1};
+  double begin = delta > 0 ? (cell - high) / delta : (cell + 1 - low) / delta;
+  double end = delta > 0 ? (cell + 1 - low) / delta : (cell - high) / delta;
+  return {.begin = std::max(begin, 0.0), .end = std::min(end, 1.0)};
+}
+
+// The cells a span reaching from `low` (or to `high`) can contact. A span with
+// extent overlaps only the cells it enters; one with none also touches the
+// cell on the far side of a seam it lies on, and touching is contact for it.
+int FirstCell(double low, double half) {
+  return static_cast<int>(half == 0 ? std::ceil(low) - 1 : std::floor(low));
+}
+
+int LastCell(double high, double half) {
+  return static_cast<int>(half == 0 ? std::floor(high) : std::ceil(high) - 1);
+}
+
+}  // namespace
+
+absl::StatusOr<TileCollisionMap> TileCollisionMap::Create(const WorldLayer& layer,
+                                                          const Tileset& tileset, int tile_width,
+                                                          int tile_height) {
+  if (tile_width <= 0 || tile_height <= 0) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "tile collision needs a positive tile size, got ", tile_width, "x", tile_height));
+  }
+
+  absl::flat_hash_map<int, uint8_t> codes;
+  codes.reserve(tileset.tiles.size());
+  for (const Tile& tile : tileset.tiles) {
+    codes[tile.id] =
+        static_cast<uint8_t>(static_cast<uint8_t>(tile.shape) | (tile.is_one_way ? kOneWayBit : 0));
+  }
+
+  TileCollisionMap map(tile_width, tile_height);
+  for (const auto& [key, chunk] : layer.tile_chunks) {
+    ChunkCells cells{};
+    bool solid = false;
+    absl::Status status = absl::OkStatus();
+    chunk.ForEachTile([&](int index, int tile_id) {
+      if (!status.ok()) return;
+      auto it = codes.find(tile_id);
+      if (it == codes.end()) {
+        status = absl::NotFoundError(absl::StrCat("level references unknown tile ID ", tile_id));
+        return;
+      }
+      cells[index] = it->second;
+      solid |= (it->second & kShapeMask) != TileShape::kNone;
+    });
+    if (!status.ok()) return status;
+    if (!solid) continue;
+    map.chunk_slots_[key] = static_cast<int>(map.chunk_cells_.size());
+    map.chunk_cells_.push_back(cells);
+  }
+  return map;
+}
+
+uint8_t TileCollisionMap::CellAt(int cell_x, int cell_y, ChunkCursor& cursor) const {
+  // Chunk coordinates are never negative, so neither is any tile.
+  if (cell_x < 0 || cell_y < 0) return 0;
+  const int64_t key = ChunkKey(cell_x / TileChunk::kSize, cell_y / TileChunk::kSize);
+  if (!cursor.valid || cursor.key != key) {
+    auto it = chunk_slots_.find(key);
+    cursor = {.valid = true,
+              .key = key,
+              .cells = it == chunk_slots_.end() ? nullptr : &chunk_cells_[it->second]};
+  }
+  if (cursor.cells == nullptr) return 0;
+  return (*cursor.cells)[(cell_y % TileChunk::kSize) * TileChunk::kSize +
+                         cell_x % TileChunk::kSize];
+}
+
+TileShape TileCollisionMap::ShapeAt(int cell_x, int cell_y) const {
+  ChunkCursor cursor;
+  return static_cast<TileShape>(CellAt(cell_x, cell_y, cursor) & kShapeMask);
+}
+
+std::optional<TileSweepHit> TileCollisionMap::SweepBox(Vec center, Vec half_extents,
+                                                       Vec delta) const {
+  const double scale_x = 1.0 / tile_width_;
+  const double scale_y = 1.0 / tile_height_;
+  const CellSweep sweep{
+      .center_x = center.x * scale_x,
+      .center_y = center.y * scale_y,
+      .half_x = std::abs(half_extents.x) * scale_x,
+      .half_y = std::abs(half_extents.y) * scale_y,
+      .delta_x = delta.x * scale_x,
+      .delta_y = delta.y * scale_y,
+  };
+  const double low_x = sweep.center_x - sweep.half_x;
+  const double high_x = sweep.center_x + sweep.half_x;
+  const double low_y = sweep.center_y - sweep.half_y;
+  const double high_y = sweep.center_y + sweep.half_y;
+  if (!std::isfinite(low_x + high_x + low_y + high_y + sweep.delta_x + sweep.delta_y)) {
+    return std::nullopt;
+  }
+
+  const auto& shape_edges = ShapeEdgeTable();
+  ChunkCursor cursor;
+  double best_time = 1;
+  std::optional<TileSweepHit> best;
+
+  // Columns are visited in the direction of travel, so the time the box enters
+  // each one only grows and the walk ends at the first that cannot beat the
+  // best hit. Within a column, rows are visited the same way for vertical
+  // travel. For a point this is the usual grid DDA; a box widens each column's
+  // row range by its height.
+  const int first_column = FirstCell(std::min(low_x, low_x + sweep.delta_x), sweep.half_x);
+  const int last_column = LastCell(std::max(high_x, high_x + sweep.delta_x), sweep.half_x);
+  const int column_step = sweep.delta_x < 0 ? -1 : 1;
+  const int column_begin = column_step > 0 ? first_column : last_column;
+  const int column_end = (column_step > 0 ? last_column : first_column) + column_step;
+  for (int column = column_begin; column != column_end; column += column_step) {
+    const Interval in_column = StripInterval(low_x, high_x, sweep.delta_x, column);
+    if (in_column.begin >= best_time) break;
+    if (in_column.begin >= in_column.end) continue;
+
+    const double rise_begin = sweep.delta_y * in_column.begin;
+    const double rise_end = sweep.delta_y * in_column.end;
+    const int first_row = FirstCell(low_y + std::min(rise_begin, rise_end), sweep.half_y);
+    const int last_row = LastCell(high_y + std::max(rise_begin, rise_end), sweep.half_y);
+    const int row_step = sweep.delta_y < 0 ? -1 : 1;
+    const int row_begin = row_step > 0 ? first_row : last_row;
+    const int row_end = (row_step > 0 ? last_row : first_row) + row_step;
+    for (int row = row_begin; row != row_end; row += row_step) {
+      const Interval in_row = StripInterval(low_y, high_y, sweep.delta_y, row);
+      if (std::max(in_column.begin, in_row.begin) >= best_time) break;
+
+      const uint8_t code = CellAt(column, row, cursor);
+      const TileShape shape = static_cast<TileShape>(code & kShapeMask);
+      if (shape == TileShape::kNone) continue;
+      std::optional<CellContact> contact =
+          SweepCell(shape_edges[shape], column, row, sweep, best_time);
+      if (!contact.has_value()) continue;
+      // A one-way tile stops only a landing: contact through its top surface
+      // while moving down, never a shape already inside it.
+      const bool landing = contact->normal_y < 0 && sweep.delta_y > 0;
+      if ((code & kOneWayBit) != 0 && !landing) continue;
+
+      best_time = contact->time;
+      // Normals transform by the transpose of the world-to-cell scale.
+      Vec normal{.x = contact->normal_x * scale_x, .y = contact->normal_y * scale_y};
+      const double length = std::hypot(normal.x, normal.y);
+      if (length > 0) normal = {.x = normal.x / length, .y = normal.y / length};
+      best = TileSweepHit{
+          .time = contact->time, .normal = normal, .cell_x = column, .cell_y = row, .shape = shape};
+      // Nothing can come earlier than an overlap at the start.
+      if (best_time == 0) return best;
+    }
+  }
+  return best;
+}
+
+}  // namespace zebes
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/statusor.h"
+#include "objects/level.h"
+#include "objects/tile_chunk.h"
+#include "objects/tileset.h"
+#include "objects/vec.h"
+
+namespace zebes {
+
+// Where a swept shape first touched the tile grid.
+struct TileSweepHit {
+  // The fraction of the requested motion completed before contact, in [0, 1).
+  double time = 0;
+  // Unit surface normal in world space, pointing out of the tile. Zero when the
+  // shape already overlapped solid ground before it moved: no direction is
+  // meaningful then, and time is zero.
+  Vec normal;
+  int cell_x = 0;
+  int cell_y = 0;
+  TileShape shape = TileShape::kNone;
+};
+
+// The solid tiles of one world layer, resolved to shapes once so that sweeping
+// against them is arithmetic.
+//
+// A cell collides as its tile's TileShapePolygon, scaled to the level's tile
+// render size. Only overlap is contact: a box resting on a floor or sliding
+// along a wall touches it without hitting it, so it can keep moving. Along an
+// axis where the shape has no extent, as for a point, touching is contact:
+// otherwise a bullet could follow the seam between two solid tiles through
+// both. A one-way tile is solid only to a shape that lands on it from above.
+//
+// Queries walk the grid in the direction of travel and stop at the first
+// column that cannot beat the best hit found, so their cost follows the
+// distance moved rather than the size of the level. They allocate nothing and
+// touch no shared mutable state, so any number may run at once.
+class TileCollisionMap {
+ public:
+  // Fails when the layer uses a tile ID the tileset does not define, like
+  // every other reader of level tiles.
+  static absl::StatusOr<TileCollisionMap> Create(const WorldLayer& layer, const Tileset& tileset,
+                                                 int tile_width, int tile_height);
+
+  // The shape of the tile at a cell, or kNone for empty and non-colliding cells.
+  TileShape ShapeAt(int cell_x, int cell_y) const;
+
+  // Moves an axis-aligned box by `delta` in world pixels and reports its first
+  // contact. Nullopt means the whole motion is free.
+  std::optional<TileSweepHit> SweepBox(Vec center, Vec half_extents, Vec delta) const;
+
+  // SweepBox for a box with no extent, as for a bullet or a line of sight.
+  std::optional<TileSweepHit> SweepPoint(Vec start, Vec delta) const {
+    return SweepBox(start, Vec{}, delta);
+  }
+
+ private:
+  // One byte per cell: the TileShape, with kOneWayBit set for one-way tiles.
+  using ChunkCells = std::array<uint8_t, TileChunk::kCells>;
+
+  TileCollisionMap(int tile_width, int tile_height)
+      : tile_width_(tile_width), tile_height_(tile_height) {}
+
+  // The last chunk a query looked in. Consecutive cells of one walk nearly
+  // always share a chunk, so this saves most of the hash lookups.
+  struct ChunkCursor {
+    bool valid = false;
+    int64_t key = 0;
+    const ChunkCells* cells = nullptr;
+  };
+
+  uint8_t CellAt(int cell_x, int cell_y, ChunkCursor& cursor) const;
+
+  int tile_width_ = 0;
+  int tile_height_ = 0;
+  // Keyed by ChunkKey. Chunks with nothing solid are left out.
+  absl::flat_hash_map<int64_t, int> chunk_slots_;
+  std::vector<ChunkCells> chunk_cells_;
+};
+
+}  // namespace zebes
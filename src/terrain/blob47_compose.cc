@@ -1,9 +1,14 @@
 #include "terrain/blob47_compose.h"
 
 #include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
 
 #include "absl/status/status.h"
 #include "absl/strings/str_cat.h"
+#include "absl/types/span.h"
+#include "common/parallel_for.h"
 #include "common/status_macros.h"
 #include "nlohmann/json.hpp"
 
@@ -54,17 +59,33 @@ void BlitCell(const RgbaImage& source, int source_x, int source_y, RgbaImage& ta
   }
 }
 
-// Resolves which variant actually supplies a quadrant cell, honouring the
-// transparent-means-inherit rule.
-int ResolveVariantForCell(const QuadrantSheet& sheet, Quadrant quadrant, QuadrantState state,
-                          int variant) {
-  if (variant == 0) return 0;
-
-  const int column = variant * kQuadrantStateCount + static_cast<int>(state);
-  const int origin_x = column * sheet.quadrant_size;
-  const int origin_y = static_cast<int>(quadrant) * sheet.quadrant_size;
-  if (IsCellTransparent(sheet.image, origin_x, origin_y, sheet.quadrant_size)) return 0;
-  return variant;
+// Index of a quadrant cell within the `source_variants` vector that
+// ResolveSourceVariants fills: variant-major, then quadrant, then state.
+int CellSlot(int variant, Quadrant quadrant, QuadrantState state) {
+  return (variant * kQuadrantCount + static_cast<int>(quadrant)) * kQuadrantStateCount +
+         static_cast<int>(state);
+}
+
+// Resolves, once per sheet cell, which variant actually supplies it, honouring
+// the transparent-means-inherit rule. Every tile reuses the same 20 cells per
+// variant, so scanning each cell here rather than per tile quadrant saves 47 x
+// 4 transparency scans per variant for the price of 20.
+absl::Status ResolveSourceVariants(const QuadrantSheet& sheet, std::vector<int>& source_variants) {
+  const int cells_per_variant = kQuadrantCount * kQuadrantStateCount;
+  source_variants.assign(static_cast<size_t>(sheet.variant_count) * cells_per_variant, 0);
+  return ParallelFor(
+      static_cast<int>(source_variants.size()), /*max_workers=*/0, [&](int slot) {
+        const int variant = slot / cells_per_variant;
+        if (variant == 0) return absl::OkStatus();
+        const int quadrant = slot % cells_per_variant / kQuadrantStateCount;
+        const int state = slot % kQuadrantStateCount;
+        const int column = variant * kQuadrantStateCount + state;
+        if (!IsCellTransparent(sheet.image, column * sheet.quadrant_size,
+                               quadrant * sheet.quadrant_size, sheet.quadrant_size)) {
+          source_variants[slot] = variant;
+        }
+        return absl::OkStatus();
+      });
 }
 
 absl::Status ValidateSheet(const QuadrantSheet& sheet) {
@@ -133,13 +154,22 @@ std::vector<int> FindProvidedSlopeColumns(const SlopeSheet& slopes) {
   return columns;
 }
 
+// Clears one tile-sized cell of the atlas. Used for the cells no tile lands in,
+// which a reused atlas may still hold from an earlier composition.
+void ClearCell(RgbaImage& target, int target_x, int target_y, int size) {
+  for (int y = 0; y < size; ++y) {
+    const size_t target_row = (static_cast<size_t>(target_y + y) * target.width + target_x) * 4;
+    std::fill_n(target.pixels.begin() + target_row, static_cast<size_t>(size) * 4, uint8_t{0});
+  }
+}
+
 // Composites the four quadrants of one tile into the atlas.
-void ComposeTile(const QuadrantSheet& sheet, uint8_t mask, int variant, int target_x, int target_y,
-                 RgbaImage& atlas) {
+void ComposeTile(const QuadrantSheet& sheet, absl::Span<const int> source_variants, uint8_t mask,
+                 int variant, int target_x, int target_y, RgbaImage& atlas) {
   for (int q = 0; q < kQuadrantCount; ++q) {
     const Quadrant quadrant = static_cast<Quadrant>(q);
     const QuadrantState state = QuadrantStateForMask(mask, quadrant);
-    const int source_variant = ResolveVariantForCell(sheet, quadrant, state, variant);
+    const int source_variant = source_variants[CellSlot(variant, quadrant, state)];
 
     const int column = source_variant * kQuadrantStateCount + static_cast<int>(state);
     const QuadrantOffset offset = OffsetForQuadrant(quadrant);
@@ -152,6 +182,13 @@ void ComposeTile(const QuadrantSheet& sheet, uint8_t mask, int variant, int targ
 }  // namespace
 
 absl::StatusOr<Blob47Atlas> ComposeBlob47(const QuadrantSheet& sheet, const SlopeSheet* slopes) {
+  Blob47Atlas atlas;
+  RETURN_IF_ERROR(ComposeBlob47Into(sheet, slopes, atlas));
+  return atlas;
+}
+
+absl::Status ComposeBlob47Into(const QuadrantSheet& sheet, const SlopeSheet* slopes,
+                               Blob47Atlas& atlas) {
   RETURN_IF_ERROR(ValidateSheet(sheet));
   RETURN_IF_ERROR(ValidateBaseVariant(sheet));
 
@@ -167,47 +204,61 @@ absl::StatusOr<Blob47Atlas> ComposeBlob47(const QuadrantSheet& sheet, const Slop
   const int slope_rows =
       (static_cast<int>(slope_columns.size()) + kBlob47Columns - 1) / kBlob47Columns;
 
-  Blob47Atlas atlas;
+  std::vector<int> source_variants;
+  RETURN_IF_ERROR(ResolveSourceVariants(sheet, source_variants));
+
+  // Every atlas cell is written below, blank ones included, so a buffer of the
+  // right size is reused as is rather than cleared first.
   atlas.tile_size = tile_size;
+  atlas.variant_period = 0;
   atlas.image.width = kBlob47Columns * tile_size;
   atlas.image.height = (kBlob47Rows * sheet.variant_count + slope_rows) * tile_size;
-  atlas.image.pixels.assign(
-      static_cast<size_t>(atlas.image.width) * atlas.image.height * 4, 0);
-  atlas.tiles.reserve(static_cast<size_t>(masks.size()) * sheet.variant_count);
-
-  for (int variant = 0; variant < sheet.variant_count; ++variant) {
-    for (int index = 0; index < static_cast<int>(masks.size()); ++index) {
-      const int column = index % kBlob47Columns;
-      const int row = variant * kBlob47Rows + index / kBlob47Columns;
-      const int target_x = column * tile_size;
-      const int target_y = row * tile_size;
-
-      ComposeTile(sheet, masks[index], variant, target_x, target_y, atlas.image);
-      atlas.tiles.push_back(ComposedTile{
-          .index = index,
-          .mask = masks[index],
-          .variant = variant,
+  atlas.image.pixels.resize(static_cast<size_t>(atlas.image.width) * atlas.image.height * 4);
+  atlas.tiles.resize(static_cast<size_t>(masks.size()) * sheet.variant_count);
+  atlas.slopes.resize(slope_columns.size());
+
+  // One work item per atlas cell. Cells never overlap, and each writes only its
+  // own pixels and its own manifest slot, so the result does not depend on the
+  // order they run in.
+  const int cells_per_block = kBlob47Columns * kBlob47Rows;
+  const int blob_cells = cells_per_block * sheet.variant_count;
+  const int cell_count = blob_cells + slope_rows * kBlob47Columns;
+  return ParallelFor(cell_count, /*max_workers=*/0, [&](int cell) {
+    const int target_x = (cell % kBlob47Columns) * tile_size;
+    const int target_y = (cell / kBlob47Columns) * tile_size;
+
+    if (cell >= blob_cells) {
+      const int i = cell - blob_cells;
+      if (i >= static_cast<int>(slope_columns.size())) {
+        ClearCell(atlas.image, target_x, target_y, tile_size);
+        return absl::OkStatus();
+      }
+      BlitCell(slopes->image, slope_columns[i] * tile_size, 0, atlas.image, target_x, target_y,
+               tile_size);
+      atlas.slopes[i] = ComposedSlope{
+          .shape = static_cast<TileShape>(kFirstSlopeShape + slope_columns[i]),
           .source_x = target_x,
           .source_y = target_y,
-      });
+      };
+      return absl::OkStatus();
     }
-  }
 
-  const int slope_origin_row = kBlob47Rows * sheet.variant_count;
-  for (int i = 0; i < static_cast<int>(slope_columns.size()); ++i) {
-    const int target_x = (i % kBlob47Columns) * tile_size;
-    const int target_y = (slope_origin_row + i / kBlob47Columns) * tile_size;
-
-    BlitCell(slopes->image, slope_columns[i] * tile_size, 0, atlas.image, target_x, target_y,
-             tile_size);
-    atlas.slopes.push_back(ComposedSlope{
-        .shape = static_cast<TileShape>(kFirstSlopeShape + slope_columns[i]),
+    const int variant = cell / cells_per_block;
+    const int index = cell % cells_per_block;
+    if (index >= static_cast<int>(masks.size())) {
+      ClearCell(atlas.image, target_x, target_y, tile_size);
+      return absl::OkStatus();
+    }
+    ComposeTile(sheet, source_variants, masks[index], variant, target_x, target_y, atlas.image);
+    atlas.tiles[static_cast<size_t>(variant) * masks.size() + index] = ComposedTile{
+        .index = index,
+        .mask = masks[index],
+        .variant = variant,
         .source_x = target_x,
         .source_y = target_y,
-    });
-  }
-
-  return atlas;
+    };
+    return absl::OkStatus();
+  });
 }
 
 std::string WriteBlob47Manifest(const Blob47Atlas& atlas) {
@@ -4,6 +4,7 @@
 #include <string>
 #include <vector>
 
+#include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "common/image_io.h"
 #include "objects/tileset.h"
@@ -90,6 +91,14 @@ struct Blob47Atlas {
 absl::StatusOr<Blob47Atlas> ComposeBlob47(const QuadrantSheet& sheet,
                                           const SlopeSheet* slopes = nullptr);
 
+// ComposeBlob47 into an existing atlas, for callers that re-compose as the
+// artist edits a quadrant. Tiles are composed in parallel straight into
+// atlas.image, and its buffers are reused, so re-composing a sheet whose size
+// has not changed allocates no pixel storage. On failure the atlas is left in
+// an unspecified state.
+absl::Status ComposeBlob47Into(const QuadrantSheet& sheet, const SlopeSheet* slopes,
+                               Blob47Atlas& atlas);
+
 // Serializes an atlas manifest for the tileset importer.
 std::string WriteBlob47Manifest(const Blob47Atlas& atlas);
 
@@ -1,13 +1,18 @@
 #include "terrain/terrain_detect.h"
 
+#include <algorithm>
+#include <cstdint>
 #include <map>
 #include <optional>
 #include <set>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/status/status.h"
 #include "absl/strings/str_cat.h"
+#include "common/parallel_for.h"
 #include "common/status_macros.h"
 #include "nlohmann/json.hpp"
 #include "terrain/blob47_compose.h"
@@ -25,8 +30,18 @@ struct AtlasCoordinate {
     if (row != other.row) return row < other.row;
     return column < other.column;
   }
+  bool operator==(const AtlasCoordinate& other) const = default;
+
+  template <typename H>
+  friend H AbslHashValue(H state, const AtlasCoordinate& coordinate) {
+    return H::combine(std::move(state), coordinate.column, coordinate.row);
+  }
 };
 
+// Origins whose block test one ParallelFor item runs. Each test is a handful
+// of lookups, so items are coarse enough to keep claiming them cheap.
+constexpr int kOriginsPerBatch = 1024;
+
 // One manifest entry, before it is turned into a tile.
 struct ManifestEntry {
   uint8_t mask = 0;
@@ -148,44 +163,87 @@ absl::Status ValidateManifestCoverage(const std::vector<ManifestEntry>& entries)
   return absl::OkStatus();
 }
 
+// The tileset's cell-aligned tiles in row-major order. Cells next to each
+// other on the atlas are next to each other here too, so each row of a block is
+// one stretch of `cells`.
+struct AtlasIndex {
+  struct Cell {
+    AtlasCoordinate coordinate;
+    int tile_id = 0;
+    // Occupied cells from this one rightwards, itself included.
+    int run = 0;
+  };
+  std::vector<Cell> cells;
+  absl::flat_hash_map<AtlasCoordinate, int> position;
+};
+
 // Indexes a tileset's tiles by their atlas cell. Tiles whose source position is
 // not cell-aligned cannot belong to a generated block and are skipped.
-std::map<AtlasCoordinate, int> BuildAtlasIndex(const Tileset& tileset) {
-  std::map<AtlasCoordinate, int> index;
+AtlasIndex BuildAtlasIndex(const Tileset& tileset) {
+  // Later tiles at the same cell replace earlier ones.
+  std::map<AtlasCoordinate, int> by_coordinate;
   for (const Tile& tile : tileset.tiles) {
     if (tile.source_x % tileset.tile_width != 0) continue;
     if (tile.source_y % tileset.tile_height != 0) continue;
-    index[AtlasCoordinate{.column = tile.source_x / tileset.tile_width,
-                          .row = tile.source_y / tileset.tile_height}] = tile.id;
+    by_coordinate[AtlasCoordinate{.column = tile.source_x / tileset.tile_width,
+                                  .row = tile.source_y / tileset.tile_height}] = tile.id;
+  }
+
+  AtlasIndex index;
+  index.cells.reserve(by_coordinate.size());
+  index.position.reserve(by_coordinate.size());
+  for (const auto& [coordinate, tile_id] : by_coordinate) {
+    index.position[coordinate] = static_cast<int>(index.cells.size());
+    index.cells.push_back(AtlasIndex::Cell{.coordinate = coordinate, .tile_id = tile_id});
+  }
+  for (int i = static_cast<int>(index.cells.size()) - 1; i >= 0; --i) {
+    AtlasIndex::Cell& cell = index.cells[i];
+    const bool continues = i + 1 < static_cast<int>(index.cells.size()) &&
+                           index.cells[i + 1].coordinate ==
+                               AtlasCoordinate{.column = cell.coordinate.column + 1,
+                                               .row = cell.coordinate.row};
+    cell.run = continues ? index.cells[i + 1].run + 1 : 1;
   }
   return index;
 }
 
-// Returns the tile IDs of a complete blob-47 block at the given origin, in
-// table order, or nullopt when any of the 47 cells is missing.
-std::optional<std::vector<int>> ReadBlockAt(const std::map<AtlasCoordinate, int>& index,
-                                            int origin_column, int origin_row) {
+// Whether a complete blob-47 block starts at the cell at `origin`. Each of the
+// block's rows is checked against the run starting there, so an incomplete
+// block is rejected after at most six lookups without reading any tile.
+bool BlockStartsAt(const AtlasIndex& index, int origin) {
+  const AtlasCoordinate& corner = index.cells[origin].coordinate;
+  for (int row = 0; row * kBlob47Columns < kBlob47TileCount; ++row) {
+    const int needed = std::min(kBlob47Columns, kBlob47TileCount - row * kBlob47Columns);
+    int start = origin;
+    if (row > 0) {
+      const auto found = index.position.find(
+          AtlasCoordinate{.column = corner.column, .row = corner.row + row});
+      if (found == index.position.end()) return false;
+      start = found->second;
+    }
+    if (index.cells[start].run < needed) return false;
+  }
+  return true;
+}
+
+// The tile IDs of the complete block at `origin`, in table order.
+std::vector<int> ReadBlockAt(const AtlasIndex& index, int origin) {
+  const AtlasCoordinate& corner = index.cells[origin].coordinate;
   std::vector<int> tile_ids;
   tile_ids.reserve(kBlob47TileCount);
-
-  for (int i = 0; i < kBlob47TileCount; ++i) {
-    const AtlasCoordinate coordinate{
-        .column = origin_column + i % kBlob47Columns,
-        .row = origin_row + i / kBlob47Columns,
-    };
-    auto found = index.find(coordinate);
-    if (found == index.end()) return std::nullopt;
-    tile_ids.push_back(found->second);
+  for (int row = 0; row * kBlob47Columns < kBlob47TileCount; ++row) {
+    const int needed = std::min(kBlob47Columns, kBlob47TileCount - row * kBlob47Columns);
+    const int start =
+        index.position.at(AtlasCoordinate{.column = corner.column, .row = corner.row + row});
+    for (int i = 0; i < needed; ++i) tile_ids.push_back(index.cells[start + i].tile_id);
   }
   return tile_ids;
 }
 
 // Derives a terrain name from the tiles' shared name prefix so detected
 // candidates arrive with something better than "Terrain 1".
-std::string SuggestName(const Tileset& tileset, const std::vector<int>& tile_ids) {
-  absl::flat_hash_map<int, const Tile*> by_id;
-  for (const Tile& tile : tileset.tiles) by_id[tile.id] = &tile;
-
+std::string SuggestName(const absl::flat_hash_map<int, const Tile*>& by_id,
+                        const std::vector<int>& tile_ids) {
   std::string prefix;
   bool first = true;
   for (int tile_id : tile_ids) {
@@ -352,37 +410,60 @@ absl::StatusOr<std::vector<TerrainCandidate>> DetectBlob47Terrains(const Tileset
     return absl::InvalidArgumentError("tileset tile dimensions must be positive");
   }
 
-  const std::map<AtlasCoordinate, int> index = BuildAtlasIndex(tileset);
-  std::set<AtlasCoordinate> claimed;
+  const AtlasIndex index = BuildAtlasIndex(tileset);
+  const int cell_count = static_cast<int>(index.cells.size());
+
+  // Which cells start a complete block is independent per cell, so that is
+  // worked out in parallel. Claiming blocks and stacking variants stays one
+  // pass in row-major order, which keeps the result the same however the
+  // tests were scheduled.
+  std::vector<uint8_t> starts_block(cell_count, 0);
+  const int batches = (cell_count + kOriginsPerBatch - 1) / kOriginsPerBatch;
+  RETURN_IF_ERROR(ParallelFor(batches, /*max_workers=*/0, [&](int batch) {
+    const int end = std::min(cell_count, (batch + 1) * kOriginsPerBatch);
+    for (int origin = batch * kOriginsPerBatch; origin < end; ++origin) {
+      starts_block[origin] = BlockStartsAt(index, origin) ? 1 : 0;
+    }
+    return absl::OkStatus();
+  }));
+
+  absl::flat_hash_map<int, const Tile*> tiles_by_id;
+  for (const Tile& tile : tileset.tiles) tiles_by_id[tile.id] = &tile;
+  std::vector<uint8_t> claimed(cell_count, 0);
   std::vector<TerrainCandidate> candidates;
   int next_terrain_id = 1;
 
-  for (const auto& [origin, unused_tile_id] : index) {
-    if (claimed.count(origin) == 1) continue;
-
-    std::optional<std::vector<int>> block = ReadBlockAt(index, origin.column, origin.row);
-    if (!block.has_value()) continue;
+  for (int origin = 0; origin < cell_count; ++origin) {
+    if (claimed[origin] != 0 || starts_block[origin] == 0) continue;
 
     TerrainCandidate candidate;
     candidate.terrain.id = next_terrain_id++;
     candidate.terrain.scheme = TerrainScheme::kBlob47;
 
     // Blocks stacked directly below are additional variants of one terrain.
-    int variant_row = origin.row;
-    std::vector<int> first_block_tiles = *block;
+    const AtlasCoordinate& corner = index.cells[origin].coordinate;
+    std::vector<int> first_block_tiles;
+    std::optional<int> block = origin;
     while (block.has_value()) {
-      AppendVariant(*block, candidate.terrain.rules);
+      const std::vector<int> tile_ids = ReadBlockAt(index, *block);
+      if (first_block_tiles.empty()) first_block_tiles = tile_ids;
+      AppendVariant(tile_ids, candidate.terrain.rules);
+      const int block_row = index.cells[*block].coordinate.row;
       for (int i = 0; i < kBlob47TileCount; ++i) {
-        claimed.insert(AtlasCoordinate{
-            .column = origin.column + i % kBlob47Columns,
-            .row = variant_row + i / kBlob47Columns,
-        });
+        claimed[index.position.at(AtlasCoordinate{
+            .column = corner.column + i % kBlob47Columns,
+            .row = block_row + i / kBlob47Columns,
+        })] = 1;
+      }
+      const auto below = index.position.find(
+          AtlasCoordinate{.column = corner.column, .row = block_row + kBlob47Rows});
+      block.reset();
+      if (below != index.position.end() && starts_block[below->second] != 0) {
+        block = below->second;
       }
-      variant_row += kBlob47Rows;
-      block = ReadBlockAt(index, origin.column, variant_row);
     }
 
-    candidate.suggested_name = SuggestName(tileset, first_block_tiles);
+    candidate.suggested_name = SuggestName(tiles_by_id, first_block_tiles);
     candidate.terrain.name = candidate.suggested_name;
     candidates.push_back(std::move(candidate));
   }
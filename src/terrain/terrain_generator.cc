@@ -3,6 +3,7 @@
 #include <algorithm>
 #include <array>
 #include <cmath>
+#include <cstdint>
 #include <cstring>
 #include <random>
 #include <utility>
@@ -150,6 +151,96 @@ uint8_t MotifPixelIndex(TerrainMotifPixel pixel, bool lit, float gradient_t,
   return kIndexEmpty;
 }
 
+// (size + 1)^2 running totals of the set flags in a size x size mask, with a
+// zero row and column in front so no query needs a bounds check.
+std::vector<int> SummedAreaTable(const std::vector<uint8_t>& flags, int size) {
+  const size_t stride = static_cast<size_t>(size) + 1;
+  std::vector<int> table(stride * stride, 0);
+  for (int y = 0; y < size; ++y) {
+    int row = 0;
+    for (int x = 0; x < size; ++x) {
+      row += flags[static_cast<size_t>(y) * size + x] != 0 ? 1 : 0;
+      table[(y + 1) * stride + x + 1] = table[y * stride + x + 1] + row;
+    }
+  }
+  return table;
+}
+
+// How many flags are set in [left, right) x [top, bottom).
+int CountInRect(const std::vector<int>& table, int size, int left, int top, int right,
+                int bottom) {
+  const size_t stride = static_cast<size_t>(size) + 1;
+  return table[bottom * stride + right] - table[top * stride + right] -
+         table[bottom * stride + left] + table[top * stride + left];
+}
+
+// --------------------------------------------------------------------------
+// motif placement
+
+// Accepted motif positions bucketed on the periodic field's torus. Cells are
+// at least `spacing` wide, so anything closer than that to a candidate sits
+// in one of the 3x3 cells around it, and the crowding test reads those rather
+// than every placement. It answers exactly what a pairwise scan would.
+class PeriodicSpacingGrid {
+ public:
+  PeriodicSpacingGrid(int period, int spacing, int expected_count)
+      : period_(period), spacing_squared_(spacing * spacing) {
+    // About one placement per cell; more cells would only be empty.
+    const int wanted = static_cast<int>(std::ceil(std::sqrt(std::max(1, expected_count))));
+    cells_ = std::clamp(period / std::max(1, spacing), 1, wanted);
+    heads_.assign(static_cast<size_t>(cells_) * cells_, -1);
+  }
+
+  bool Crowded(int x, int y) const {
+    std::array<int, 3> columns;
+    std::array<int, 3> rows;
+    const int column_count = Around(Cell(x), columns);
+    const int row_count = Around(Cell(y), rows);
+    for (int row = 0; row < row_count; ++row) {
+      for (int column = 0; column < column_count; ++column) {
+        for (int placed = heads_[static_cast<size_t>(rows[row]) * cells_ + columns[column]];
+             placed >= 0; placed = next_[placed]) {
+          int dx = std::abs(x - xs_[placed]);
+          int dy = std::abs(y - ys_[placed]);
+          dx = std::min(dx, period_ - dx);
+          dy = std::min(dy, period_ - dy);
+          if (dx * dx + dy * dy < spacing_squared_) return true;
+        }
+      }
+    }
+    return false;
+  }
+
+  void Insert(int x, int y) {
+    const size_t cell = static_cast<size_t>(Cell(y)) * cells_ + Cell(x);
+    next_.push_back(heads_[cell]);
+    heads_[cell] = static_cast<int>(xs_.size());
+    xs_.push_back(x);
+    ys_.push_back(y);
+  }
+
+ private:
+  int Cell(int coordinate) const {
+    return static_cast<int>(static_cast<int64_t>(coordinate) * cells_ / period_);
+  }
+
+  // The distinct cells within one of `cell`, wrapping; fewer than three when
+  // the torus is that small.
+  int Around(int cell, std::array<int, 3>& out) const {
+    out = {cell, (cell + 1) % cells_, (cell + cells_ - 1) % cells_};
+    return std::min(cells_, 3);
+  }
+
+  int period_ = 1;
+  int spacing_squared_ = 0;
+  int cells_ = 1;
+  // Per cell, the newest placement in it; next_ chains to the one before.
+  std::vector<int> heads_;
+  std::vector<int> next_;
+  std::vector<int> xs_;
+  std::vector<int> ys_;
+};
+
 // --------------------------------------------------------------------------
 // polygon rasterisation
 
@@ -227,8 +318,8 @@ TerrainRenderer::TerrainRenderer(TerrainGenConfig config, ResolvedTerrainStyle s
                                  RuffleField ruffle, ValueNoiseField surface_texture,
                                  ValueNoiseField mottle, PeriodicPatternGrid surface_pattern,
                                  CellularField cellular, PeriodicPatternGrid edge_pattern,
-                                 std::vector<MotifPlacement> pattern_placements,
-                                 std::vector<MotifPlacement> detail_placements)
+                                 std::vector<std::vector<MotifDraw>> pattern_draws,
+                                 std::vector<std::vector<MotifDraw>> detail_draws)
     : config_(std::move(config)),
       style_(std::move(style)),
       ruffle_(std::move(ruffle)),
@@ -237,8 +328,8 @@ TerrainRenderer::TerrainRenderer(TerrainGenConfig config, ResolvedTerrainStyle s
       surface_pattern_(std::move(surface_pattern)),
       cellular_(std::move(cellular)),
       edge_pattern_(std::move(edge_pattern)),
-      pattern_placements_(std::move(pattern_placements)),
-      detail_placements_(std::move(detail_placements)),
+      pattern_draws_(std::move(pattern_draws)),
+      detail_draws_(std::move(detail_draws)),
       resolution_(config_.tile_size * config_.supersample),
       canvas_(resolution_ * 3) {}
 
@@ -322,43 +413,77 @@ absl::StatusOr<TerrainRenderer> TerrainRenderer::Create(TerrainGenConfig config)
                      CellularField::Create(final_period, style.interior_cells, config.seed));
   }
 
-  const auto build_placements = [&](absl::Span<const TerrainMotif> motifs, int density, int spacing,
-                                    uint64_t seed) {
-    const int target = density * config.variant_period * config.variant_period;
-    const int spacing_squared = spacing * spacing;
-    std::mt19937_64 generator(seed);
-    std::uniform_int_distribution<int> position(0, final_period - 1);
-    std::vector<MotifPlacement> placements;
-    for (int attempt = 0; !motifs.empty() && attempt < std::max(32, target * 80) &&
-                          static_cast<int>(placements.size()) < target;
-         ++attempt) {
-      MotifPlacement candidate{position(generator), position(generator),
-                               generator() % motifs.size()};
-      bool crowded = false;
-      for (const MotifPlacement& placed : placements) {
-        int dx = std::abs(candidate.x - placed.x);
-        int dy = std::abs(candidate.y - placed.y);
-        dx = std::min(dx, final_period - dx);
-        dy = std::min(dy, final_period - dy);
-        if (dx * dx + dy * dy < spacing_squared) {
-          crowded = true;
-          break;
+  const int variants = config.variant_period * config.variant_period;
+  const std::vector<MotifPlacement> pattern_placements = BuildMotifPlacements(
+      final_period, config.interior.pattern.density * variants, style.pattern_spacing,
+      pattern_motifs.size(), config.seed ^ 0xc2b2ae35);
+  const std::vector<MotifPlacement> detail_placements = BuildMotifPlacements(
+      final_period, config.interior.details.density * variants, style.detail_spacing,
+      detail_motifs.size(), config.seed ^ 0x85ebca6b);
+
+  // Bucketed per variant, so rendering a tile never visits a placement that misses it.
+  std::vector<std::vector<MotifDraw>> pattern_draws =
+      BucketMotifDraws(pattern_placements, pattern_motifs, style.pattern_scale, config.tile_size,
+                       config.variant_period);
+  std::vector<std::vector<MotifDraw>> detail_draws =
+      BucketMotifDraws(detail_placements, detail_motifs, style.detail_scale, config.tile_size,
+                       config.variant_period);
+  return TerrainRenderer(std::move(config), std::move(style), std::move(ruffle),
+                         std::move(surface_texture), std::move(mottle), std::move(surface_pattern),
+                         std::move(cellular), std::move(edge_pattern), std::move(pattern_draws),
+                         std::move(detail_draws));
+}
+
+std::vector<TerrainRenderer::MotifPlacement> TerrainRenderer::BuildMotifPlacements(
+    int period, int target, int spacing, size_t motif_count, uint64_t seed) {
+  std::mt19937_64 generator(seed);
+  std::uniform_int_distribution<int> position(0, period - 1);
+  std::vector<MotifPlacement> placements;
+  PeriodicSpacingGrid accepted(period, spacing, target);
+  for (int attempt = 0; motif_count > 0 && attempt < std::max(32, target * 80) &&
+                        static_cast<int>(placements.size()) < target;
+       ++attempt) {
+    MotifPlacement candidate{position(generator), position(generator), generator() % motif_count};
+    if (accepted.Crowded(candidate.x, candidate.y)) continue;
+    accepted.Insert(candidate.x, candidate.y);
+    placements.push_back(candidate);
+  }
+  return placements;
+}
+
+std::vector<std::vector<TerrainRenderer::MotifDraw>> TerrainRenderer::BucketMotifDraws(
+    absl::Span<const MotifPlacement> placements, absl::Span<const TerrainMotif> motifs, int scale,
+    int tile, int variant_period) {
+  const int period = tile * variant_period;
+  std::vector<std::vector<MotifDraw>> draws(static_cast<size_t>(variant_period) * variant_period);
+  for (size_t variant = 0; variant < draws.size(); ++variant) {
+    const int tile_origin_x = static_cast<int>(variant % variant_period) * tile;
+    const int tile_origin_y = static_cast<int>(variant / variant_period) * tile;
+    for (const MotifPlacement& placement : placements) {
+      const TerrainMotif& stamp = motifs[placement.motif];
+      const int drawn_width = stamp.width * scale;
+      const int drawn_height = stamp.height * scale;
+
+      int centre_x = placement.x - tile_origin_x;
+      int centre_y = placement.y - tile_origin_y;
+      while (centre_x < -drawn_width) centre_x += period;
+      while (centre_x >= tile + drawn_width) centre_x -= period;
+      while (centre_y < -drawn_height) centre_y += period;
+      while (centre_y >= tile + drawn_height) centre_y -= period;
+
+      for (const int wrap_y : {-period, 0, period}) {
+        for (const int wrap_x : {-period, 0, period}) {
+          const int x0 = centre_x + wrap_x - drawn_width / 2;
+          const int y0 = centre_y + wrap_y - drawn_height / 2;
+          if (x0 >= tile || y0 >= tile || x0 + drawn_width <= 0 || y0 + drawn_height <= 0) {
+            continue;
+          }
+          draws[variant].push_back(MotifDraw{.motif = placement.motif, .x0 = x0, .y0 = y0});
         }
       }
-      if (!crowded) placements.push_back(candidate);
     }
-    return placements;
-  };
-  std::vector<MotifPlacement> pattern_placements =
-      build_placements(pattern_motifs, config.interior.pattern.density, style.pattern_spacing,
-                       config.seed ^ 0xc2b2ae35);
-  std::vector<MotifPlacement> detail_placements =
-      build_placements(detail_motifs, config.interior.details.density, style.detail_spacing,
-                       config.seed ^ 0x85ebca6b);
-  return TerrainRenderer(std::move(config), std::move(style), std::move(ruffle),
-                         std::move(surface_texture), std::move(mottle), std::move(surface_pattern),
-                         std::move(cellular), std::move(edge_pattern),
-                         std::move(pattern_placements), std::move(detail_placements));
+  }
+  return draws;
 }
 
 std::vector<uint8_t> TerrainRenderer::Occupancy(
@@ -662,54 +787,58 @@ void TerrainRenderer::ApplyInteriorTexture(std::vector<uint8_t>& indices, int or
   }
 }
 
-void TerrainRenderer::PlaceSubstratePattern(std::vector<uint8_t>& indices, int origin_x,
-                                            int origin_y) const {
+void TerrainRenderer::PlaceSubstratePattern(std::vector<uint8_t>& indices, int variant) const {
   const MotifLayer layer{
       .stamps = TerrainSubstrateMotifsFor(config_.interior.pattern.family, config_.pixel_profile),
-      .placements = pattern_placements_,
+      .draws = pattern_draws_[variant],
       .margin = style_.pattern_margin,
       .scale = style_.pattern_scale,
       .accent_mode = config_.interior.pattern.accent_mode,
       .substrate_layer = true};
-  ApplyMotifs(indices, origin_x, origin_y, layer);
+  ApplyMotifs(indices, layer);
 }
 
-void TerrainRenderer::PlaceDetails(std::vector<uint8_t>& indices, int origin_x,
-                                   int origin_y) const {
+void TerrainRenderer::PlaceDetails(std::vector<uint8_t>& indices, int variant) const {
   const MotifLayer layer{
       .stamps = TerrainDetailMotifsFor(config_.interior.details.family, config_.pixel_profile),
-      .placements = detail_placements_,
+      .draws = detail_draws_[variant],
       .margin = style_.detail_margin,
       .scale = style_.detail_scale,
       .accent_mode = config_.interior.details.accent_mode,
       .substrate_layer = false};
-  ApplyMotifs(indices, origin_x, origin_y, layer);
+  ApplyMotifs(indices, layer);
 }
 
-std::vector<uint8_t> TerrainRenderer::LegalMotifPixels(const std::vector<uint8_t>& indices,
-                                                       int margin) const {
+TerrainRenderer::MotifLegality TerrainRenderer::LegalMotifPixels(
+    const std::vector<uint8_t>& indices, int margin) const {
   const int tile = config_.tile_size;
-  std::vector<uint8_t> legal(indices.size(), 0);
+  std::vector<uint8_t> interior(indices.size(), 0);
+  for (size_t index = 0; index < indices.size(); ++index) {
+    interior[index] = IsInteriorIndex(indices[index]) ? 1 : 0;
+  }
+  const std::vector<int> interior_counts = SummedAreaTable(interior, tile);
+
+  MotifLegality legality;
+  legality.legal.assign(indices.size(), 0);
   for (int y = 0; y < tile; ++y) {
+    // Neighbours off the tile are not checked, so the window is clipped.
+    const int top = std::max(0, y - margin);
+    const int bottom = std::min(tile, y + margin + 1);
     for (int x = 0; x < tile; ++x) {
       const size_t index = static_cast<size_t>(y) * tile + x;
-      if (!IsInteriorIndex(indices[index])) continue;
-      bool clear = true;
-      for (int oy = -margin; oy <= margin && clear; ++oy) {
-        for (int ox = -margin; ox <= margin && clear; ++ox) {
-          const int ny = y + oy;
-          const int nx = x + ox;
-          if (ny < 0 || nx < 0 || ny >= tile || nx >= tile) continue;
-          clear = IsInteriorIndex(indices[static_cast<size_t>(ny) * tile + nx]);
-        }
-      }
-      legal[index] = clear ? 1 : 0;
+      if (interior[index] == 0) continue;
+      const int left = std::max(0, x - margin);
+      const int right = std::min(tile, x + margin + 1);
+      const int window = (right - left) * (bottom - top);
+      legality.legal[index] =
+          CountInRect(interior_counts, tile, left, top, right, bottom) == window ? 1 : 0;
     }
   }
-  return legal;
+  legality.legal_counts = SummedAreaTable(legality.legal, tile);
+  return legality;
 }
 
-void TerrainRenderer::StampMotif(std::vector<uint8_t>& indices, const std::vector<uint8_t>& legal,
+void TerrainRenderer::StampMotif(std::vector<uint8_t>& indices, const MotifLegality& legality,
                                  const TerrainMotif& stamp, int x0, int y0,
                                  const MotifLayer& layer) const {
   const int tile = config_.tile_size;
@@ -724,15 +853,21 @@ void TerrainRenderer::StampMotif(std::vector<uint8_t>& indices, const std::vecto
     return stamp.pixels[static_cast<size_t>(sy / scale) * stamp.width + sx / scale];
   };
 
+  const int left = std::max(0, x0);
+  const int top = std::max(0, y0);
+  const int right = std::min(tile, x0 + drawn_width);
+  const int bottom = std::min(tile, y0 + drawn_height);
+  const bool box_legal = CountInRect(legality.legal_counts, tile, left, top, right, bottom) ==
+                         (right - left) * (bottom - top);
   bool visible = false;
-  for (int sy = 0; sy < drawn_height; ++sy) {
-    for (int sx = 0; sx < drawn_width; ++sx) {
-      if (source_at(sx, sy) == TerrainMotifPixel::kTransparent) continue;
-      const int px = x0 + sx;
-      const int py = y0 + sy;
-      if (px < 0 || py < 0 || px >= tile || py >= tile) continue;
-      if (legal[static_cast<size_t>(py) * tile + px] == 0) return;
+  for (int py = top; py < bottom && !(visible && box_legal); ++py) {
+    for (int px = left; px < right; ++px) {
+      if (source_at(px - x0, py - y0) == TerrainMotifPixel::kTransparent) continue;
+      // Only the stamp's opaque pixels have to be legal, so a box that is not
+      // wholly legal still has to be checked pixel by pixel.
+      if (!box_legal && legality.legal[static_cast<size_t>(py) * tile + px] == 0) return;
       visible = true;
+      if (box_legal) break;
     }
   }
   if (!visible) return;
@@ -768,34 +903,12 @@ void TerrainRenderer::StampMotif(std::vector<uint8_t>& indices, const std::vecto
   }
 }
 
-void TerrainRenderer::ApplyMotifs(std::vector<uint8_t>& indices, int origin_x, int origin_y,
-                                  const MotifLayer& layer) const {
-  if (layer.placements.empty() || layer.stamps.empty()) return;
-
-  const std::vector<uint8_t> legal = LegalMotifPixels(indices, layer.margin);
+void TerrainRenderer::ApplyMotifs(std::vector<uint8_t>& indices, const MotifLayer& layer) const {
+  if (layer.draws.empty() || layer.stamps.empty()) return;
 
-  const int tile = config_.tile_size;
-  const int period = tile * config_.variant_period;
-  const int tile_origin_x = origin_x / config_.supersample;
-  const int tile_origin_y = origin_y / config_.supersample;
-  for (const MotifPlacement& placement : layer.placements) {
-    const TerrainMotif& stamp = layer.stamps[placement.motif];
-    const int drawn_width = stamp.width * layer.scale;
-    const int drawn_height = stamp.height * layer.scale;
-
-    int centre_x = placement.x - tile_origin_x;
-    int centre_y = placement.y - tile_origin_y;
-    while (centre_x < -drawn_width) centre_x += period;
-    while (centre_x >= tile + drawn_width) centre_x -= period;
-    while (centre_y < -drawn_height) centre_y += period;
-    while (centre_y >= tile + drawn_height) centre_y -= period;
-
-    for (const int wrap_y : {-period, 0, period}) {
-      for (const int wrap_x : {-period, 0, period}) {
-        StampMotif(indices, legal, stamp, centre_x + wrap_x - drawn_width / 2,
-                   centre_y + wrap_y - drawn_height / 2, layer);
-      }
-    }
+  const MotifLegality legality = LegalMotifPixels(indices, layer.margin);
+  for (const MotifDraw& draw : layer.draws) {
+    StampMotif(indices, legality, layer.stamps[draw.motif], draw.x0, draw.y0, layer);
   }
 }
 
@@ -832,8 +945,8 @@ RgbaImage TerrainRenderer::RenderTile(absl::Span<const TilePoint> polygon,
   ApplyEdgeDetails(indices, depth, surface, origin_x, origin_y);
   ApplySurfaceTexture(indices, origin_x, origin_y);
   ApplyInteriorTexture(indices, origin_x, origin_y);
-  PlaceSubstratePattern(indices, origin_x, origin_y);
-  PlaceDetails(indices, origin_x, origin_y);
+  PlaceSubstratePattern(indices, variant);
+  PlaceDetails(indices, variant);
   return Colorize(indices);
 }
 
@@ -65,12 +65,23 @@ class TerrainRenderer {
   const TerrainGenConfig& config() const { return config_; }
 
  private:
+  friend class TerrainRendererTestPeer;
+
   struct MotifPlacement {
     int x = 0;
     int y = 0;
     size_t motif = 0;
   };
 
+  // One stamp a layer draws on one variant's tile: a placement, or a wrapped
+  // copy of one, whose box overlaps that tile. (x0, y0) is its top-left corner
+  // in tile pixels.
+  struct MotifDraw {
+    size_t motif = 0;
+    int x0 = 0;
+    int y0 = 0;
+  };
+
   // Per-supersample surface measurements shared by classification passes.
   // Keeping the normal-derived upness beside the band prevents wall styles
   // from re-deriving orientation with subtly different seam behaviour.
@@ -85,7 +96,8 @@ class TerrainRenderer {
   // they share the whole placement and wrapping path.
   struct MotifLayer {
     absl::Span<const TerrainMotif> stamps;
-    absl::Span<const MotifPlacement> placements;
+    // Only the draws that reach the tile being rendered, in placement order.
+    absl::Span<const MotifDraw> draws;
     int margin = 0;
     // Integer magnification. Source pixels are read at sx / scale, so a stamp
     // stays pixel art rather than being resampled.
@@ -97,8 +109,23 @@ class TerrainRenderer {
   TerrainRenderer(TerrainGenConfig config, ResolvedTerrainStyle style, RuffleField ruffle,
                   ValueNoiseField surface_texture, ValueNoiseField mottle,
                   PeriodicPatternGrid surface_pattern, CellularField cellular,
-                  PeriodicPatternGrid edge_pattern, std::vector<MotifPlacement> pattern_placements,
-                  std::vector<MotifPlacement> detail_placements);
+                  PeriodicPatternGrid edge_pattern,
+                  std::vector<std::vector<MotifDraw>> pattern_draws,
+                  std::vector<std::vector<MotifDraw>> detail_draws);
+
+  // Scatters up to `target` placements over a period x period torus, none
+  // closer than `spacing` to another, each naming one of `motif_count` motifs.
+  // The same seed always gives the same placements in the same order.
+  static std::vector<MotifPlacement> BuildMotifPlacements(int period, int target, int spacing,
+                                                          size_t motif_count, uint64_t seed);
+
+  // Sorts a layer's placements into per-variant lists of the stamps, wrapped
+  // copies included, whose boxes overlap that variant's tile. Each list keeps
+  // placement order, and a placement's wraps keep the order they were always
+  // stamped in, so overlapping motifs layer as they did.
+  static std::vector<std::vector<MotifDraw>> BucketMotifDraws(
+      absl::Span<const MotifPlacement> placements, absl::Span<const TerrainMotif> motifs,
+      int scale, int tile, int variant_period);
 
   // Rasterises the tile and its eight neighbours at supersampled resolution.
   std::vector<uint8_t> Occupancy(absl::Span<const TilePoint> polygon,
@@ -120,20 +147,27 @@ class TerrainRenderer {
   void ApplyEdgeDetails(std::vector<uint8_t>& indices, const std::vector<float>& depth,
                         const SurfaceField& surface, int origin_x, int origin_y) const;
   void ApplyInteriorTexture(std::vector<uint8_t>& indices, int origin_x, int origin_y) const;
-  void PlaceSubstratePattern(std::vector<uint8_t>& indices, int origin_x, int origin_y) const;
-  void PlaceDetails(std::vector<uint8_t>& indices, int origin_x, int origin_y) const;
-  void ApplyMotifs(std::vector<uint8_t>& indices, int origin_x, int origin_y,
-                   const MotifLayer& layer) const;
+  void PlaceSubstratePattern(std::vector<uint8_t>& indices, int variant) const;
+  void PlaceDetails(std::vector<uint8_t>& indices, int variant) const;
+  void ApplyMotifs(std::vector<uint8_t>& indices, const MotifLayer& layer) const;
+
+  // The pixels a motif may cover, with a summed-area table of them so a
+  // stamp's whole box can be checked with four reads.
+  struct MotifLegality {
+    std::vector<uint8_t> legal;
+    std::vector<int> legal_counts;
+  };
 
   // Marks the pixels a motif may cover: interior pixels whose whole margin
   // neighbourhood is also interior. This is what keeps details off the surface
-  // band instead of letting them spill over the edge.
-  std::vector<uint8_t> LegalMotifPixels(const std::vector<uint8_t>& indices, int margin) const;
+  // band instead of letting them spill over the edge. Each neighbourhood is a
+  // summed-area query, so the margin does not change the cost.
+  MotifLegality LegalMotifPixels(const std::vector<uint8_t>& indices, int margin) const;
 
   // Draws one motif with its top-left corner at (x0, y0), or draws nothing if
   // any pixel it would cover is not clear interior. Placement is all or
   // nothing: a partially drawn motif reads as damage rather than as detail.
-  void StampMotif(std::vector<uint8_t>& indices, const std::vector<uint8_t>& legal,
+  void StampMotif(std::vector<uint8_t>& indices, const MotifLegality& legality,
                   const TerrainMotif& stamp, int x0, int y0, const MotifLayer& layer) const;
 
   RgbaImage Colorize(const std::vector<uint8_t>& indices) const;
@@ -149,8 +183,9 @@ class TerrainRenderer {
   PeriodicPatternGrid surface_pattern_;
   CellularField cellular_;
   PeriodicPatternGrid edge_pattern_;
-  std::vector<MotifPlacement> pattern_placements_;
-  std::vector<MotifPlacement> detail_placements_;
+  // Per variant, what each motif layer draws on that variant's tile.
+  std::vector<std::vector<MotifDraw>> pattern_draws_;
+  std::vector<std::vector<MotifDraw>> detail_draws_;
   // Supersampled pixels per tile, and the 3x3 canvas edge that implies.
   int resolution_ = 0;
   int canvas_ = 0;
@@ -11,11 +11,10 @@ namespace zebes {
 namespace {
 
 constexpr int kMaxFieldEdge = 4096;
-// The placement builder uses exact pairwise spacing checks. This is generous
-// beside the editor's current maximum of 192 placements, while keeping a
-// programmatic configuration from turning renderer creation quadratic at an
-// unbounded scale.
-constexpr int kMaxMotifPlacements = 1024;
+// The placement builder's spacing checks are bucketed, so renderer creation is
+// linear in this; the bound is on what every rendered tile has to consider. It
+// is generous beside the editor's current maximum of 192 placements.
+constexpr int kMaxMotifPlacements = 16384;
 constexpr int kMaxTileSize = 256;
 constexpr int kMaxSupersample = 8;
 constexpr int kMaxVariantPeriod = 4;
@@ -21,6 +21,9 @@ class MockApi : public Api {
   MOCK_METHOD(absl::Status, ShowTexturePixels,
               (const std::string&, int, int, absl::Span<const uint8_t>), (override));
   MOCK_METHOD(absl::StatusOr<RgbaImage>, ReadTexturePixels, (const std::string&), (override));
+  MOCK_METHOD(absl::StatusOr<TextureHandle>, LoadTransientTexture,
+              (int, int, absl::Span<const uint8_t>), (override));
+  MOCK_METHOD(void, UnloadTransientTexture, (TextureHandle), (override));
   MOCK_METHOD(absl::Status, DeleteTexture, (const std::string&), (override));
   MOCK_METHOD(absl::StatusOr<std::vector<Texture>>, GetAllTextures, (), (override));
   MOCK_METHOD(absl::Status, UpdateTexture, (const Texture&), (override));
@@ -187,8 +187,8 @@ TEST_F(ApiValidationTest, CheckTileDeletablePaintedInALevelReturnsError) {
   const std::string tileset_id = "test_tileset";
   Level level = LevelUsingTileset(tileset_id);
   TileChunk chunk;
-  chunk.tiles[0] = 7;
-  chunk.tiles[1] = 7;
+  chunk.SetTile(0, 7);
+  chunk.SetTile(1, 7);
   level.layers.front().tile_chunks[0] = chunk;
   EXPECT_CALL(level_manager_, GetAllLevels())
       .WillOnce(Return(std::vector<Level>{std::move(level)}));
@@ -214,7 +214,7 @@ TEST_F(ApiValidationTest, CheckTileDeletableUnpaintedPasses) {
 TEST_F(ApiValidationTest, CheckTileDeletableIgnoresLevelsBoundToAnotherTileset) {
   Level level = LevelUsingTileset("some_other_tileset");
   TileChunk chunk;
-  chunk.tiles[0] = 7;
+  chunk.SetTile(0, 7);
   level.layers.front().tile_chunks[0] = chunk;
   EXPECT_CALL(level_manager_, GetAllLevels())
       .WillOnce(Return(std::vector<Level>{std::move(level)}));
@@ -0,0 +1,124 @@
+#include "artwork/connected_components.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <queue>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "tests/macros.h"
+
+namespace zebes {
+namespace {
+
+// The breadth-first flood fill the labeller replaced, numbering components in
+// the order their first pixel is met.
+ConnectedComponents FloodFill(const std::vector<uint8_t>& mask, int width, int height,
+                              Connectivity connectivity) {
+  ConnectedComponents components;
+  components.labels.assign(mask.size(), 0);
+  std::queue<size_t> pending;
+  for (size_t start = 0; start < mask.size(); ++start) {
+    if (mask[start] == 0 || components.labels[start] != 0) continue;
+    components.areas.push_back(0);
+    const uint32_t label = static_cast<uint32_t>(components.areas.size());
+    components.labels[start] = label;
+    pending.push(start);
+    while (!pending.empty()) {
+      const size_t pixel = pending.front();
+      pending.pop();
+      ++components.areas.back();
+      const int x = static_cast<int>(pixel % width);
+      const int y = static_cast<int>(pixel / width);
+      for (int dy = -1; dy <= 1; ++dy) {
+        for (int dx = -1; dx <= 1; ++dx) {
+          if ((dx == 0 && dy == 0) ||
+              (connectivity == Connectivity::kFour && dx != 0 && dy != 0)) {
+            continue;
+          }
+          const int neighbor_x = x + dx;
+          const int neighbor_y = y + dy;
+          if (neighbor_x < 0 || neighbor_y < 0 || neighbor_x >= width || neighbor_y >= height) {
+            continue;
+          }
+          const size_t neighbor = static_cast<size_t>(neighbor_y) * width + neighbor_x;
+          if (mask[neighbor] == 0 || components.labels[neighbor] != 0) continue;
+          components.labels[neighbor] = label;
+          pending.push(neighbor);
+        }
+      }
+    }
+  }
+  return components;
+}
+
+TEST(ConnectedComponentsTest, CornersJoinOnlyUnderEightConnectivity) {
+  // Two diagonal pixels and a separate one.
+  const std::vector<uint8_t> mask = {
+      1, 0, 0, 0,  //
+      0, 1, 0, 1,  //
+  };
+
+  ASSERT_OK_AND_ASSIGN(const ConnectedComponents four,
+                       LabelConnectedComponents(mask, 4, 2, Connectivity::kFour));
+  EXPECT_EQ(four.labels, (std::vector<uint32_t>{1, 0, 0, 0, 0, 2, 0, 3}));
+  EXPECT_EQ(four.areas, (std::vector<int>{1, 1, 1}));
+
+  ASSERT_OK_AND_ASSIGN(const ConnectedComponents eight,
+                       LabelConnectedComponents(mask, 4, 2, Connectivity::kEight));
+  EXPECT_EQ(eight.labels, (std::vector<uint32_t>{1, 0, 0, 0, 0, 1, 0, 2}));
+  EXPECT_EQ(eight.areas, (std::vector<int>{2, 1}));
+}
+
+TEST(ConnectedComponentsTest, AShapeJoinedOnlyFarBelowKeepsItsFirstLabel) {
+  // A U whose arms only meet at the bottom, over more rows than one band, with
+  // a component starting between the arms before they meet.
+  constexpr int kWidth = 9;
+  constexpr int kHeight = 200;
+  std::vector<uint8_t> mask(kWidth * kHeight, 0);
+  for (int y = 0; y < kHeight; ++y) {
+    mask[y * kWidth + 0] = 1;
+    mask[y * kWidth + 8] = 1;
+  }
+  for (int x = 0; x < kWidth; ++x) mask[(kHeight - 1) * kWidth + x] = 1;
+  mask[3 * kWidth + 4] = 1;
+
+  ASSERT_OK_AND_ASSIGN(const ConnectedComponents components,
+                       LabelConnectedComponents(mask, kWidth, kHeight, Connectivity::kEight));
+
+  EXPECT_EQ(components.areas, (std::vector<int>{2 * kHeight + kWidth - 2, 1}));
+  EXPECT_EQ(components.labels[8], 1u);
+  EXPECT_EQ(components.labels[3 * kWidth + 4], 2u);
+}
+
+TEST(ConnectedComponentsTest, MatchesAFloodFillOnRandomMasks) {
+  std::mt19937 random(33);
+  for (const Connectivity connectivity : {Connectivity::kFour, Connectivity::kEight}) {
+    for (const auto [width, height] : {std::pair{1, 1}, std::pair{1, 300}, std::pair{300, 1},
+                                       std::pair{37, 129}, std::pair{150, 257}}) {
+      // Sparse masks make many specks; dense ones make long, winding shapes.
+      for (const int density : {20, 50, 65}) {
+        std::bernoulli_distribution set(density / 100.0);
+        std::vector<uint8_t> mask(static_cast<size_t>(width) * height);
+        for (uint8_t& pixel : mask) pixel = set(random) ? 1 : 0;
+
+        ASSERT_OK_AND_ASSIGN(const ConnectedComponents components,
+                             LabelConnectedComponents(mask, width, height, connectivity));
+        const ConnectedComponents expected = FloodFill(mask, width, height, connectivity);
+        EXPECT_EQ(components.labels, expected.labels) << width << "x" << height;
+        EXPECT_EQ(components.areas, expected.areas) << width << "x" << height;
+      }
+    }
+  }
+}
+
+TEST(ConnectedComponentsTest, RejectsAMaskThatDoesNotMatchItsSize) {
+  const std::vector<uint8_t> mask(5, 1);
+
+  EXPECT_FALSE(LabelConnectedComponents(mask, 2, 2, Connectivity::kFour).ok());
+  EXPECT_FALSE(LabelConnectedComponents(mask, 0, 5, Connectivity::kFour).ok());
+}
+
+}  // namespace
+}  // namespace zebes
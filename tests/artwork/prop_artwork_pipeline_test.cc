@@ -1,7 +1,12 @@
 #include "artwork/prop_artwork_pipeline.h"
 
+#include <algorithm>
+#include <array>
+#include <cmath>
 #include <cstddef>
 #include <cstdint>
+#include <limits>
+#include <random>
 #include <vector>
 
 #include "absl/strings/string_view.h"
@@ -104,6 +109,93 @@ TEST(PropArtworkPipelineTest, RasterizationUsesPremultipliedAlpha) {
   EXPECT_NEAR(rasterized.image.pixels[3], 128, 1);
 }
 
+// The double-precision area average RasterizeProp used before it went
+// integer, kept as the reference its results are held to.
+RgbaImage ReferenceAreaResize(const RgbaImage& source, int output_width, int output_height) {
+  RgbaImage output;
+  output.width = output_width;
+  output.height = output_height;
+  output.pixels.resize(static_cast<size_t>(output_width) * output_height * 4);
+  auto to_byte = [](double value) {
+    return static_cast<uint8_t>(std::clamp(std::lround(value), 0L, 255L));
+  };
+  const double scale_x = static_cast<double>(source.width) / output_width;
+  const double scale_y = static_cast<double>(source.height) / output_height;
+  for (int output_y = 0; output_y < output_height; ++output_y) {
+    const double top = output_y * scale_y;
+    const double bottom = (output_y + 1) * scale_y;
+    for (int output_x = 0; output_x < output_width; ++output_x) {
+      const double left = output_x * scale_x;
+      const double right = (output_x + 1) * scale_x;
+      double alpha_sum = 0.0;
+      double channel_sums[3] = {0.0, 0.0, 0.0};
+      double area_sum = 0.0;
+      for (int y = static_cast<int>(std::floor(top)); y < static_cast<int>(std::ceil(bottom));
+           ++y) {
+        if (y < 0 || y >= source.height) continue;
+        const double overlap_y = std::max(0.0, std::min(bottom, y + 1.0) - std::max(top, 1.0 * y));
+        for (int x = static_cast<int>(std::floor(left)); x < static_cast<int>(std::ceil(right));
+             ++x) {
+          if (x < 0 || x >= source.width) continue;
+          const double overlap_x =
+              std::max(0.0, std::min(right, x + 1.0) - std::max(left, 1.0 * x));
+          const double area = overlap_x * overlap_y;
+          const size_t pixel = (static_cast<size_t>(y) * source.width + x) * 4;
+          const double alpha = source.pixels[pixel + 3] / 255.0;
+          alpha_sum += alpha * area;
+          for (int channel = 0; channel < 3; ++channel) {
+            channel_sums[channel] += source.pixels[pixel + channel] * alpha * area;
+          }
+          area_sum += area;
+        }
+      }
+      const size_t pixel = (static_cast<size_t>(output_y) * output_width + output_x) * 4;
+      for (int channel = 0; channel < 3; ++channel) {
+        output.pixels[pixel + channel] =
+            alpha_sum > 0.0 ? to_byte(channel_sums[channel] / alpha_sum) : 0;
+      }
+      output.pixels[pixel + 3] = area_sum > 0.0 ? to_byte(alpha_sum / area_sum * 255.0) : 0;
+    }
+  }
+  return output;
+}
+
+TEST(PropArtworkPipelineTest, RasterizationMatchesTheReferenceAreaAverageWithinOne) {
+  std::mt19937 random(5);
+  std::uniform_int_distribution<int> byte(0, 255);
+  struct Case {
+    int source_width;
+    int source_height;
+    int output_width;
+    int output_height;
+  };
+  // Whole and fractional ratios, an identity, and an enlargement.
+  for (const Case& c : {Case{96, 64, 24, 16}, Case{97, 61, 24, 16}, Case{300, 200, 45, 30},
+                        Case{32, 32, 32, 32}, Case{10, 7, 24, 16}}) {
+    RgbaImage source = SolidImage(c.source_width, c.source_height, RgbaColor{});
+    for (size_t i = 0; i < source.pixels.size(); ++i) {
+      const int value = byte(random);
+      // Mostly opaque or clear alpha, like a composed prop.
+      source.pixels[i] = i % 4 == 3 && value < 200 ? (value < 100 ? 0 : 255) : value;
+    }
+
+    ASSERT_OK_AND_ASSIGN(const PropArtwork rasterized,
+                         RasterizeProp(PropArtwork{.image = source},
+                                       PropRasterConfig{.tile_size = 1,
+                                                        .canvas_tiles_wide = c.output_width,
+                                                        .canvas_tiles_high = c.output_height}));
+    const RgbaImage reference = ReferenceAreaResize(source, c.output_width, c.output_height);
+
+    ASSERT_EQ(rasterized.image.pixels.size(), reference.pixels.size());
+    int largest_difference = 0;
+    for (size_t i = 0; i < reference.pixels.size(); ++i) {
+      largest_difference = std::max(
+          largest_difference, std::abs(rasterized.image.pixels[i] - reference.pixels[i]));
+    }
+    EXPECT_LE(largest_difference, 1) << c.source_width << "x" << c.source_height;
+  }
+}
+
 TEST(PropArtworkPipelineTest, RasterizationRequiresWholePixelBlocks) {
   const PropArtwork artwork{
       .image = SolidImage(4, 4, RgbaColor{255, 0, 0, 255}), .anchor_x = 1, .anchor_y = 3};
@@ -187,6 +279,99 @@ TEST(PropArtworkPipelineTest, AcceptedPaletteContainsEveryResolvedTerrainColour)
   EXPECT_EQ(palette.outline, terrain.at(TerrainPaletteRole::kOutline));
 }
 
+std::array<double, 3> ReferenceOklab(const RgbaColor& color) {
+  auto linear = [](uint8_t channel) {
+    const double value = channel / 255.0;
+    return value <= 0.04045 ? value / 12.92 : std::pow((value + 0.055) / 1.055, 2.4);
+  };
+  const double red = linear(color.r);
+  const double green = linear(color.g);
+  const double blue = linear(color.b);
+  const double l = std::cbrt(0.4122214708 * red + 0.5363325363 * green + 0.0514459929 * blue);
+  const double m = std::cbrt(0.2119034982 * red + 0.6806995451 * green + 0.1073969566 * blue);
+  const double s = std::cbrt(0.0883024619 * red + 0.2817188376 * green + 0.6299787005 * blue);
+  return {
+      0.2104542553 * l + 0.7936177850 * m - 0.0040720468 * s,
+      1.9779984951 * l - 2.4285922050 * m + 0.4505937099 * s,
+      0.0259040371 * l + 0.7827717662 * m - 0.8086757660 * s,
+  };
+}
+
+// The search of every palette colour that PropPaletteLookup replaced, kept as
+// the definition of the right answer.
+size_t ExhaustiveNearest(const std::vector<std::array<double, 3>>& palette,
+                         const RgbaColor& color) {
+  const std::array<double, 3> source = ReferenceOklab(color);
+  size_t best = 0;
+  double best_distance = std::numeric_limits<double>::infinity();
+  for (size_t candidate = 0; candidate < palette.size(); ++candidate) {
+    const double lightness = source[0] - palette[candidate][0];
+    const double green_red = source[1] - palette[candidate][1];
+    const double blue_yellow = source[2] - palette[candidate][2];
+    const double distance =
+        lightness * lightness + green_red * green_red + blue_yellow * blue_yellow;
+    if (distance < best_distance) {
+      best = candidate;
+      best_distance = distance;
+    }
+  }
+  return best;
+}
+
+TEST(PropArtworkPipelineTest, QuantizationLookupMatchesAnExhaustiveSearch) {
+  const TerrainGenConfig config;
+  ASSERT_OK_AND_ASSIGN(const ResolvedTerrainPalette terrain, ResolveTerrainPalette(config));
+  // The production palette, and one with a duplicate so ties are exercised.
+  std::vector<RgbaColor> tied = terrain.OpaqueColors();
+  tied.push_back(tied.front());
+  tied.insert(tied.begin(), RgbaColor{128, 128, 128, 255});
+  tied.push_back(RgbaColor{128, 128, 128, 255});
+
+  for (const std::vector<RgbaColor>& palette : {terrain.OpaqueColors(), tied}) {
+    ASSERT_OK_AND_ASSIGN(const PropPaletteLookup lookup, PropPaletteLookup::Build(palette));
+    std::vector<std::array<double, 3>> resolved;
+    for (const RgbaColor& color : palette) resolved.push_back(ReferenceOklab(color));
+
+    std::vector<RgbaColor> samples;
+    std::mt19937 random(11);
+    std::uniform_int_distribution<int> channel(0, 255);
+    for (int sample = 0; sample < 100000; ++sample) {
+      samples.push_back(RgbaColor{static_cast<uint8_t>(channel(random)),
+                                  static_cast<uint8_t>(channel(random)),
+                                  static_cast<uint8_t>(channel(random)), 255});
+    }
+    // Every colour in a slice of the cube, boundaries between cells included.
+    for (int r = 0; r < 256; ++r) {
+      for (int g = 0; g < 256; ++g) {
+        samples.push_back(RgbaColor{static_cast<uint8_t>(r), static_cast<uint8_t>(g),
+                                    static_cast<uint8_t>((r * 7 + g * 3) % 256), 255});
+      }
+    }
+
+    int mismatches = 0;
+    for (const RgbaColor& sample : samples) {
+      if (lookup.Nearest(sample.r, sample.g, sample.b) != ExhaustiveNearest(resolved, sample)) {
+        ++mismatches;
+      }
+    }
+    EXPECT_EQ(mismatches, 0);
+  }
+}
+
+TEST(PropArtworkPipelineTest, QuantizationKeepsAlphaAndClearsTransparentColour) {
+  const std::vector<RgbaColor> colors = {{20, 20, 20, 255}, {220, 40, 40, 255}};
+  RgbaImage image = SolidImage(2, 1, RgbaColor{200, 60, 50, 90});
+  PaintRect(image, 1, 0, 1, 1, RgbaColor{30, 200, 90, 0});
+
+  ASSERT_OK_AND_ASSIGN(const PropArtwork quantized,
+                       QuantizeProp(PropArtwork{.image = image}, PropPalette{.colors = colors}));
+
+  EXPECT_EQ(quantized.image.pixels, (std::vector<uint8_t>{220, 40, 40, 90, 0, 0, 0, 0}));
+  EXPECT_FALSE(QuantizeProp(PropArtwork{.image = image},
+                            PropPalette{.colors = {{20, 20, 20, 128}}})
+                   .ok());
+}
+
 TEST(PropArtworkPipelineTest, CoordinatorRetainsEveryPreviewAndProducesAValidatedProp) {
   RgbaImage source = SolidImage(32, 24, RgbaColor{236, 232, 228, 255});
   PaintRect(source, 7, 6, 18, 13, RgbaColor{74, 68, 64, 255});
@@ -260,6 +445,141 @@ TEST(PropArtworkPipelineTest, CoordinatorIsByteDeterministic) {
   EXPECT_EQ(first.finished.image.pixels, second.finished.image.pixels);
 }
 
+void ExpectSameArtifacts(const PropArtworkPipelineResult& actual,
+                         const PropArtworkPipelineResult& expected) {
+  EXPECT_EQ(actual.source_digest, expected.source_digest);
+  EXPECT_EQ(actual.isolated.pixels, expected.isolated.pixels);
+  EXPECT_EQ(actual.composed.image.pixels, expected.composed.image.pixels);
+  EXPECT_EQ(actual.rasterized.image.pixels, expected.rasterized.image.pixels);
+  EXPECT_EQ(actual.quantized.image.pixels, expected.quantized.image.pixels);
+  EXPECT_EQ(actual.edge_treated.image.pixels, expected.edge_treated.image.pixels);
+  EXPECT_EQ(actual.finished.image.pixels, expected.finished.image.pixels);
+  EXPECT_EQ(actual.finished.anchor_x, expected.finished.anchor_x);
+  EXPECT_EQ(actual.finished.anchor_y, expected.finished.anchor_y);
+  for (size_t index = 0; index < actual.diagnostics.size(); ++index) {
+    EXPECT_EQ(actual.diagnostics[index].visible_pixels, expected.diagnostics[index].visible_pixels);
+  }
+}
+
+TEST(PropArtworkPipelineTest, CacheResumesAtTheFirstStageWhoseInputsChanged) {
+  RgbaImage source = SolidImage(32, 24, RgbaColor{236, 232, 228, 255});
+  PaintRect(source, 7, 6, 18, 13, RgbaColor{74, 68, 64, 255});
+  PaintRect(source, 10, 7, 8, 5, RgbaColor{126, 116, 104, 255});
+  const TerrainGenConfig terrain_config;
+  ASSERT_OK_AND_ASSIGN(const ResolvedTerrainPalette terrain, ResolveTerrainPalette(terrain_config));
+  PropArtworkStyle style{.tile_size = 8, .palette = terrain};
+  PropArtworkPipelineConfig config;
+  config.isolation.minimum_subject_area = 16;
+  config.composition.canvas_tiles_wide = 2;
+  config.composition.canvas_tiles_high = 1;
+  config.cleanup.contact_tolerance = 2;
+  PropArtworkPipelineCache cache;
+
+  const auto expect_resumes = [&](const RgbaImage& run_source, int reused) {
+    ASSERT_OK_AND_ASSIGN(const PropArtworkPipelineResult cached,
+                         cache.Run(run_source, style, config));
+    EXPECT_EQ(cache.reused_stages(), reused);
+    ASSERT_OK_AND_ASSIGN(const PropArtworkPipelineResult fresh,
+                         RunPropArtworkPipeline(run_source, style, config));
+    ExpectSameArtifacts(cached, fresh);
+  };
+
+  expect_resumes(source, 0);
+  expect_resumes(source, 6);
+  config.edge.width = 2;
+  expect_resumes(source, 4);
+  config.cleanup.minimum_component_area = 3;
+  expect_resumes(source, 5);
+  // An outline in the subject's own colour changes what it quantizes to, which
+  // a lookup kept from the old palette would miss.
+  style.palette.colors[static_cast<size_t>(TerrainPaletteRole::kOutline)] =
+      RgbaColor{74, 68, 64, 255};
+  expect_resumes(source, 3);
+  config.composition.padding_fraction = 0.1f;
+  expect_resumes(source, 1);
+  config.isolation.alpha_threshold = 20;
+  expect_resumes(source, 0);
+
+  RgbaImage edited = source;
+  PaintRect(edited, 12, 14, 2, 2, RgbaColor{200, 40, 40, 255});
+  expect_resumes(edited, 0);
+  expect_resumes(edited, 6);
+}
+
+TEST(PropArtworkPipelineTest, CacheKeepsTheStagesBeforeAFailure) {
+  RgbaImage source = SolidImage(32, 24, RgbaColor{236, 232, 228, 255});
+  PaintRect(source, 7, 6, 18, 13, RgbaColor{74, 68, 64, 255});
+  const TerrainGenConfig terrain_config;
+  ASSERT_OK_AND_ASSIGN(const ResolvedTerrainPalette terrain, ResolveTerrainPalette(terrain_config));
+  const PropArtworkStyle style{.tile_size = 8, .palette = terrain};
+  PropArtworkPipelineConfig config;
+  config.isolation.minimum_subject_area = 16;
+  config.cleanup.minimum_component_area = 100000;
+  PropArtworkPipelineCache cache;
+
+  const absl::Status status = cache.Run(source, style, config).status();
+  EXPECT_EQ(status.message().find("cleanup:"), 0);
+
+  config.cleanup.minimum_component_area = 2;
+  ASSERT_OK(cache.Run(source, style, config).status());
+  EXPECT_EQ(cache.reused_stages(), 5);
+
+  cache.Clear();
+  ASSERT_OK(cache.Run(source, style, config).status());
+  EXPECT_EQ(cache.reused_stages(), 0);
+}
+
+TEST(PropArtworkPipelineTest, LargeSourcesAreIsolatedOnAWorkingProxy) {
+  // Sixteen times the 16x8 prop; edges on multiples of four survive two
+  // halvings exactly.
+  RgbaImage source = SolidImage(512, 384, RgbaColor{236, 232, 228, 255});
+  PaintRect(source, 112, 96, 288, 208, RgbaColor{74, 68, 64, 255});
+  PaintRect(source, 160, 112, 128, 80, RgbaColor{126, 116, 104, 255});
+  const TerrainGenConfig terrain_config;
+  ASSERT_OK_AND_ASSIGN(const ResolvedTerrainPalette terrain, ResolveTerrainPalette(terrain_config));
+  const PropArtworkStyle style{.tile_size = 8, .palette = terrain};
+  PropArtworkPipelineConfig config;
+  config.isolation.minimum_subject_area = 4096;
+  config.composition.canvas_tiles_wide = 2;
+  config.composition.canvas_tiles_high = 1;
+  config.cleanup.contact_tolerance = 2;
+
+  ASSERT_OK_AND_ASSIGN(const PropArtworkPipelineResult proxy,
+                       RunPropArtworkPipeline(source, style, config));
+  config.working_proxy.full_resolution = true;
+  ASSERT_OK_AND_ASSIGN(const PropArtworkPipelineResult full,
+                       RunPropArtworkPipeline(source, style, config));
+
+  EXPECT_EQ(proxy.isolated.width, 128);
+  EXPECT_EQ(proxy.isolated.height, 96);
+  EXPECT_EQ(full.isolated.width, 512);
+  EXPECT_EQ(full.isolated.height, 384);
+  EXPECT_EQ(proxy.source_digest, full.source_digest);
+  EXPECT_EQ(proxy.finished.anchor_x, full.finished.anchor_x);
+  EXPECT_EQ(proxy.finished.anchor_y, full.finished.anchor_y);
+  // Composition rounds its padding at each one's own scale, so the blocks that
+  // straddle the subject's edge cover slightly different parts of it.
+  const std::vector<uint8_t>& proxy_pixels = proxy.rasterized.image.pixels;
+  const std::vector<uint8_t>& full_pixels = full.rasterized.image.pixels;
+  ASSERT_EQ(proxy_pixels.size(), full_pixels.size());
+  for (size_t index = 0; index < proxy_pixels.size(); ++index) {
+    EXPECT_NEAR(proxy_pixels[index], full_pixels[index], 24) << index;
+  }
+}
+
+TEST(PropArtworkPipelineTest, WorkingProxyRequiresAPositiveOversample) {
+  const RgbaImage source = SolidImage(16, 16, RgbaColor{74, 68, 64, 255});
+  const TerrainGenConfig terrain_config;
+  ASSERT_OK_AND_ASSIGN(const ResolvedTerrainPalette terrain, ResolveTerrainPalette(terrain_config));
+  PropArtworkPipelineConfig config;
+  config.working_proxy.minimum_oversample = 0;
+
+  EXPECT_EQ(RunPropArtworkPipeline(source, PropArtworkStyle{.palette = terrain}, config)
+                .status()
+                .code(),
+            absl::StatusCode::kInvalidArgument);
+}
+
 TEST(PropArtworkPipelineTest, FreeAttachmentPreservesExactFinalPixelAnchor) {
   RgbaImage source = SolidImage(32, 24, RgbaColor{236, 232, 228, 255});
   PaintRect(source, 7, 6, 18, 13, RgbaColor{74, 68, 64, 255});
@@ -0,0 +1,67 @@
+#include "common/parallel_for.h"
+
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "gtest/gtest.h"
+#include "macros.h"
+
+namespace zebes {
+namespace {
+
+TEST(ParallelForTest, RunsEveryIndexExactlyOnce) {
+  std::vector<std::atomic<int>> runs(1000);
+
+  ASSERT_OK(ParallelFor(static_cast<int>(runs.size()), 4, [&](int index) {
+    runs[index].fetch_add(1);
+    return absl::OkStatus();
+  }));
+
+  for (const std::atomic<int>& count : runs) EXPECT_EQ(count.load(), 1);
+}
+
+TEST(ParallelForTest, NothingToDoSucceeds) {
+  ASSERT_OK(ParallelFor(0, 4, [](int) { return absl::InternalError("never called"); }));
+}
+
+TEST(ParallelForTest, RefusesANegativeCount) {
+  const absl::Status status = ParallelFor(-1, 4, [](int) { return absl::OkStatus(); });
+  EXPECT_EQ(status.code(), absl::StatusCode::kInvalidArgument);
+}
+
+TEST(ParallelForTest, ReportsTheFailureASequentialLoopWouldHitFirst) {
+  // Both fail, and whichever thread gets there first, the answer must not
+  // depend on scheduling.
+  for (int attempt = 0; attempt < 20; ++attempt) {
+    const absl::Status status = ParallelFor(200, 8, [](int index) {
+      if (index == 150) return absl::DataLossError("late");
+      if (index == 40) return absl::NotFoundError("early");
+      return absl::OkStatus();
+    });
+    EXPECT_EQ(status.code(), absl::StatusCode::kNotFound);
+    EXPECT_EQ(status.message(), "early");
+  }
+}
+
+TEST(ParallelForTest, ZeroWorkersMeansOnePerHardwareThread) {
+  std::atomic<int> total = 0;
+  ASSERT_OK(ParallelFor(64, 0, [&](int index) {
+    total.fetch_add(index);
+    return absl::OkStatus();
+  }));
+  EXPECT_EQ(total.load(), 64 * 63 / 2);
+}
+
+TEST(ParallelForTest, TranslatesAnEscapedExceptionToStatus) {
+  const absl::Status status = ParallelFor(4, 2, [](int index) -> absl::Status {
+    if (index == 2) throw std::runtime_error("broken");
+    return absl::OkStatus();
+  });
+  EXPECT_EQ(status.code(), absl::StatusCode::kInternal);
+  EXPECT_EQ(status.message(), "Parallel work failed outside its status contract: broken");
+}
+
+}  // namespace
+}  // namespace zebes
@@ -0,0 +1,123 @@
+#include "common/snapshot_exchange.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace zebes {
+namespace {
+
+TEST(SnapshotExchangeTest, ReadsNothingBeforeTheFirstPublish) {
+  SnapshotExchange<int> exchange;
+  SnapshotExchange<int>::Read read = exchange.Acquire();
+  EXPECT_FALSE(read);
+  EXPECT_EQ(read.get(), nullptr);
+}
+
+TEST(SnapshotExchangeTest, ReadsTheNewestPublish) {
+  SnapshotExchange<int> exchange;
+  ASSERT_TRUE(exchange.TryPublish([](int& value) { value = 1; }));
+  ASSERT_TRUE(exchange.TryPublish([](int& value) { value = 2; }));
+
+  SnapshotExchange<int>::Read read = exchange.Acquire();
+  ASSERT_TRUE(read);
+  EXPECT_EQ(*read, 2);
+}
+
+TEST(SnapshotExchangeTest, DeclinesToOverwriteAPinnedValue) {
+  SnapshotExchange<int> exchange;
+  ASSERT_TRUE(exchange.TryPublish([](int& value) { value = 1; }));
+
+  SnapshotExchange<int>::Read read = exchange.Acquire();
+  // The first publish goes to the other slot, so the pinned value is safe.
+  EXPECT_TRUE(exchange.TryPublish([](int& value) { value = 2; }));
+  EXPECT_EQ(*read, 1);
+
+  // The second would land on the pinned slot, and is declined without filling.
+  bool filled = false;
+  EXPECT_FALSE(exchange.TryPublish([&filled](int& value) {
+    filled = true;
+    value = 3;
+  }));
+  EXPECT_FALSE(filled);
+  EXPECT_EQ(*read, 1);
+
+  read = SnapshotExchange<int>::Read();
+  EXPECT_EQ(*exchange.Acquire(), 2);
+  EXPECT_TRUE(exchange.TryPublish([](int& value) { value = 3; }));
+}
+
+TEST(SnapshotExchangeTest, MovingAReadKeepsOnePin) {
+  SnapshotExchange<int> exchange;
+  ASSERT_TRUE(exchange.TryPublish([](int& value) { value = 1; }));
+  ASSERT_TRUE(exchange.TryPublish([](int& value) { value = 2; }));
+
+  SnapshotExchange<int>::Read moved;
+  {
+    SnapshotExchange<int>::Read read = exchange.Acquire();
+    moved = std::move(read);
+  }
+  ASSERT_TRUE(moved);
+  EXPECT_EQ(*moved, 2);
+
+  // Still pinned after the original was destroyed: only one publish fits.
+  EXPECT_TRUE(exchange.TryPublish([](int& value) { value = 3; }));
+  EXPECT_FALSE(exchange.TryPublish([](int& value) { value = 4; }));
+}
+
+TEST(SnapshotExchangeTest, ReuseKeepsSlotStorage) {
+  SnapshotExchange<std::vector<int>> exchange;
+  ASSERT_TRUE(exchange.TryPublish([](std::vector<int>& value) { value.assign(64, 1); }));
+  ASSERT_TRUE(exchange.TryPublish([](std::vector<int>& value) { value.assign(64, 2); }));
+
+  // The third publish lands on the first slot, which still has its capacity.
+  ASSERT_TRUE(exchange.TryPublish([](std::vector<int>& value) {
+    EXPECT_GE(value.capacity(), 64u);
+    value.assign(64, 3);
+  }));
+  EXPECT_EQ(exchange.Acquire()->front(), 3);
+}
+
+// Every field of a published value is written with its sequence number, so a
+// reader that ever sees a mix has caught the writer filling a slot it pinned.
+struct Stamped {
+  std::vector<uint64_t> words;
+};
+
+TEST(SnapshotExchangeTest, ReaderNeverSeesATornValueUnderConcurrentPublishing) {
+  constexpr uint64_t kPublishes = 200000;
+  constexpr size_t kWords = 16;
+  SnapshotExchange<Stamped> exchange;
+  std::atomic<bool> done = false;
+
+  std::thread writer([&] {
+    for (uint64_t sequence = 1; sequence <= kPublishes; ++sequence) {
+      exchange.TryPublish([sequence](Stamped& value) { value.words.assign(kWords, sequence); });
+    }
+    done.store(true, std::memory_order_release);
+  });
+
+  uint64_t last_seen = 0;
+  size_t reads = 0;
+  while (!done.load(std::memory_order_acquire)) {
+    SnapshotExchange<Stamped>::Read read = exchange.Acquire();
+    if (!read) continue;
+    ++reads;
+    ASSERT_EQ(read->words.size(), kWords);
+    const uint64_t sequence = read->words.front();
+    for (uint64_t word : read->words) ASSERT_EQ(word, sequence);
+    // Newest wins, so what the reader sees never goes backwards.
+    ASSERT_GE(sequence, last_seen);
+    last_seen = sequence;
+  }
+  writer.join();
+  EXPECT_GT(reads, 0u);
+}
+
+}  // namespace
+}  // namespace zebes
@@ -0,0 +1,293 @@
+#include "common/tick_scheduler.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "macros.h"
+
+namespace zebes {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+
+constexpr TickResource kPositions = 0;
+constexpr TickResource kVelocities = 1;
+constexpr TickResource kContacts = 2;
+
+// Appends each system's name as it runs.
+class RunLog {
+ public:
+  TickSystem System(std::string name, std::vector<TickResource> reads,
+                    std::vector<TickResource> writes) {
+    return {.name = name,
+            .reads = std::move(reads),
+            .writes = std::move(writes),
+            .run = [this, name] {
+              std::lock_guard<std::mutex> lock(mutex_);
+              names_.push_back(name);
+              return absl::OkStatus();
+            }};
+  }
+
+  std::vector<std::string> Take() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return std::exchange(names_, {});
+  }
+
+ private:
+  std::mutex mutex_;
+  std::vector<std::string> names_;
+};
+
+TEST(TickSchedulerTest, RunsSystemsThatShareNothingAtOnce) {
+  // Each system waits for the other to start, which only ends before the
+  // deadline if they run on two threads at the same time.
+  std::atomic<int> started = 0;
+  auto rendezvous = [&started] {
+    started.fetch_add(1);
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (started.load() < 2) {
+      if (std::chrono::steady_clock::now() > deadline) {
+        return absl::DeadlineExceededError("the other system never started");
+      }
+      std::this_thread::yield();
+    }
+    return absl::OkStatus();
+  };
+  std::vector<TickSystem> systems;
+  systems.push_back({.name = "integrate", .writes = {kPositions}, .run = rendezvous});
+  systems.push_back({.name = "contacts", .writes = {kContacts}, .run = rendezvous});
+
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<TickScheduler> scheduler,
+                       TickScheduler::Create(std::move(systems), {.worker_threads = 1}));
+  ASSERT_EQ(scheduler->worker_threads(), 1);
+  EXPECT_THAT(scheduler->prerequisites(1), IsEmpty());
+  EXPECT_OK(scheduler->Tick());
+}
+
+TEST(TickSchedulerTest, ConflictingSystemsRunInRegistrationOrder) {
+  RunLog log;
+  std::vector<TickSystem> systems;
+  systems.push_back(log.System("accelerate", {}, {kVelocities}));
+  systems.push_back(log.System("integrate", {kVelocities}, {kPositions}));
+  systems.push_back(log.System("collide", {kPositions}, {kContacts}));
+  systems.push_back(log.System("respond", {kContacts}, {kVelocities}));
+
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<TickScheduler> scheduler,
+                       TickScheduler::Create(std::move(systems), {.worker_threads = 4}));
+  EXPECT_THAT(scheduler->prerequisites(1), ElementsAre(0));
+  EXPECT_THAT(scheduler->prerequisites(2), ElementsAre(1));
+  // Writes what the first two touch, and reads what the third wrote.
+  EXPECT_THAT(scheduler->prerequisites(3), ElementsAre(0, 1, 2));
+
+  for (int tick = 0; tick < 50; ++tick) {
+    ASSERT_OK(scheduler->Tick());
+    ASSERT_THAT(log.Take(), ElementsAre("accelerate", "integrate", "collide", "respond"));
+  }
+}
+
+TEST(TickSchedulerTest, ReadersOfOneResourceDoNotWaitForEachOther) {
+  RunLog log;
+  std::vector<TickSystem> systems;
+  systems.push_back(log.System("render", {kPositions}, {}));
+  systems.push_back(log.System("audio", {kPositions}, {}));
+  systems.push_back(log.System("integrate", {}, {kPositions}));
+
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<TickScheduler> scheduler,
+                       TickScheduler::Create(std::move(systems)));
+  EXPECT_THAT(scheduler->prerequisites(1), IsEmpty());
+  EXPECT_THAT(scheduler->prerequisites(2), ElementsAre(0, 1));
+}
+
+TEST(TickSchedulerTest, WithoutWorkersRunsInRegistrationOrderOnTheCaller) {
+  RunLog log;
+  std::vector<TickSystem> systems;
+  systems.push_back(log.System("c", {}, {kContacts}));
+  systems.push_back(log.System("a", {}, {kPositions}));
+  systems.push_back(log.System("b", {}, {kVelocities}));
+
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<TickScheduler> scheduler,
+                       TickScheduler::Create(std::move(systems)));
+  EXPECT_EQ(scheduler->worker_threads(), 0);
+  ASSERT_OK(scheduler->Tick());
+  EXPECT_THAT(log.Take(), ElementsAre("c", "a", "b"));
+}
+
+// A small world whose systems would give different answers if any ran out of
+// order against another it shares an array with.
+struct ToyWorld {
+  std::vector<double> position = std::vector<double>(256, 0);
+  std::vector<double> velocity = std::vector<double>(256, 1);
+  std::vector<double> scratch = std::vector<double>(256, 0);
+  double energy = 0;
+
+  std::vector<TickSystem> Systems() {
+    std::vector<TickSystem> systems;
+    systems.push_back({.name = "accelerate", .writes = {kVelocities}, .run = [this] {
+                         for (double& v : velocity) v = v * 0.99 + 0.5;
+                         return absl::OkStatus();
+                       }});
+    systems.push_back({.name = "integrate",
+                       .reads = {kVelocities},
+                       .writes = {kPositions},
+                       .run = [this] {
+                         for (size_t i = 0; i < position.size(); ++i) position[i] += velocity[i];
+                         return absl::OkStatus();
+                       }});
+    systems.push_back({.name = "scratch", .writes = {kContacts}, .run = [this] {
+                         for (size_t i = 0; i < scratch.size(); ++i) scratch[i] += i;
+                         return absl::OkStatus();
+                       }});
+    systems.push_back({.name = "measure",
+                       .reads = {kPositions, kVelocities, kContacts},
+                       .writes = {3},
+                       .run = [this] {
+                         for (size_t i = 0; i < position.size(); ++i) {
+                           energy += position[i] * velocity[i] - scratch[i];
+                         }
+                         return absl::OkStatus();
+                       }});
+    return systems;
+  }
+};
+
+TEST(TickSchedulerTest, MatchesASequentialLoopWhateverTheThreadCount) {
+  ToyWorld sequential;
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<TickScheduler> reference,
+                       TickScheduler::Create(sequential.Systems()));
+  for (int tick = 0; tick < 100; ++tick) {
+    ASSERT_OK(reference->Tick());
+  }
+
+  for (const int workers : {1, 3, 8}) {
+    ToyWorld parallel;
+    ASSERT_OK_AND_ASSIGN(std::unique_ptr<TickScheduler> scheduler,
+                         TickScheduler::Create(parallel.Systems(), {.worker_threads = workers}));
+    for (int tick = 0; tick < 100; ++tick) {
+      ASSERT_OK(scheduler->Tick());
+    }
+    EXPECT_EQ(parallel.position, sequential.position) << workers << " workers";
+    EXPECT_EQ(parallel.energy, sequential.energy) << workers << " workers";
+  }
+}
+
+TEST(TickSchedulerTest, ReportsTheFailureASequentialLoopWouldHitFirst) {
+  std::vector<TickSystem> systems;
+  for (int i = 0; i < 20; ++i) {
+    systems.push_back({.name = std::to_string(i), .writes = {i}, .run = [i] {
+                         if (i == 15) return absl::DataLossError("late");
+                         if (i == 3) return absl::NotFoundError("early");
+                         return absl::OkStatus();
+                       }});
+  }
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<TickScheduler> scheduler,
+                       TickScheduler::Create(std::move(systems), {.worker_threads = 6}));
+
+  for (int tick = 0; tick < 20; ++tick) {
+    const absl::Status status = scheduler->Tick();
+    ASSERT_EQ(status.code(), absl::StatusCode::kNotFound);
+    ASSERT_EQ(status.message(), "early");
+  }
+}
+
+TEST(TickSchedulerTest, DoesNotStartSystemsAfterAFailure) {
+  RunLog log;
+  std::vector<TickSystem> systems;
+  systems.push_back(log.System("first", {}, {kVelocities}));
+  systems.push_back({.name = "broken", .reads = {kVelocities}, .writes = {kPositions}, .run = [] {
+                       return absl::InternalError("broken");
+                     }});
+  systems.push_back(log.System("after", {kPositions}, {}));
+
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<TickScheduler> scheduler,
+                       TickScheduler::Create(std::move(systems), {.worker_threads = 2}));
+  EXPECT_EQ(scheduler->Tick().code(), absl::StatusCode::kInternal);
+  EXPECT_THAT(log.Take(), ElementsAre("first"));
+
+  // A failed tick does not poison the next one.
+  EXPECT_EQ(scheduler->Tick().code(), absl::StatusCode::kInternal);
+  EXPECT_THAT(log.Take(), ElementsAre("first"));
+}
+
+TEST(TickSchedulerTest, TranslatesAnEscapingException) {
+  std::vector<TickSystem> systems;
+  systems.push_back({.name = "thrower", .run = []() -> absl::Status {
+                       throw std::runtime_error("broken");
+                     }});
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<TickScheduler> scheduler,
+                       TickScheduler::Create(std::move(systems), {.worker_threads = 1}));
+
+  const absl::Status status = scheduler->Tick();
+  EXPECT_EQ(status.code(), absl::StatusCode::kInternal);
+  EXPECT_EQ(status.message(), "system thrower failed outside its status contract: broken");
+}
+
+TEST(TickSchedulerTest, CountsRunsPerSystem) {
+  RunLog log;
+  std::vector<TickSystem> systems;
+  systems.push_back(log.System("integrate", {}, {kPositions}));
+  systems.push_back(log.System("collide", {kPositions}, {kContacts}));
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<TickScheduler> scheduler,
+                       TickScheduler::Create(std::move(systems), {.worker_threads = 2}));
+
+  for (int tick = 0; tick < 3; ++tick) {
+    ASSERT_OK(scheduler->Tick());
+  }
+  ASSERT_EQ(scheduler->stats().size(), 2);
+  EXPECT_EQ(scheduler->stats()[0].name, "integrate");
+  EXPECT_EQ(scheduler->stats()[0].runs, 3);
+  EXPECT_EQ(scheduler->stats()[1].name, "collide");
+  EXPECT_EQ(scheduler->stats()[1].runs, 3);
+  EXPECT_GE(scheduler->stats()[1].total, scheduler->stats()[1].max);
+  EXPECT_GE(scheduler->stats()[1].max, scheduler->stats()[1].last);
+
+  scheduler->ResetStats();
+  EXPECT_EQ(scheduler->stats()[0].name, "integrate");
+  EXPECT_EQ(scheduler->stats()[0].runs, 0);
+  EXPECT_EQ(scheduler->stats()[0].total, absl::ZeroDuration());
+}
+
+TEST(TickSchedulerTest, RefusesInvalidSystems) {
+  auto create = [](TickSystem system) {
+    std::vector<TickSystem> systems;
+    systems.push_back(std::move(system));
+    return TickScheduler::Create(std::move(systems)).status().code();
+  };
+  auto ok = [] { return absl::OkStatus(); };
+
+  EXPECT_EQ(create({.run = ok}), absl::StatusCode::kInvalidArgument);
+  EXPECT_EQ(create({.name = "idle"}), absl::StatusCode::kInvalidArgument);
+  EXPECT_EQ(create({.name = "far", .reads = {kMaxTickResources}, .run = ok}),
+            absl::StatusCode::kInvalidArgument);
+  EXPECT_EQ(create({.name = "negative", .writes = {-1}, .run = ok}),
+            absl::StatusCode::kInvalidArgument);
+
+  std::vector<TickSystem> twice;
+  twice.push_back({.name = "same", .run = ok});
+  twice.push_back({.name = "same", .run = ok});
+  EXPECT_EQ(TickScheduler::Create(std::move(twice)).status().code(),
+            absl::StatusCode::kInvalidArgument);
+  EXPECT_EQ(TickScheduler::Create({}, {.worker_threads = -1}).status().code(),
+            absl::StatusCode::kInvalidArgument);
+}
+
+TEST(TickSchedulerTest, NothingToRunSucceeds) {
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<TickScheduler> scheduler,
+                       TickScheduler::Create({}, {.worker_threads = 2}));
+  EXPECT_OK(scheduler->Tick());
+}
+
+}  // namespace
+}  // namespace zebes
@@ -16,10 +16,10 @@ TEST(AnimatorTest, ReadsLiveFramesAddedAfterPlaybackStarts) {
   };
 
   ASSERT_OK(animator.GetCurrentFrame(frames));
-  animator.Update(frames);
+  animator.Update();
 
+  // One tick in, a second one-tick frame is the one showing.
   frames.push_back({.index = 1, .texture_x = 20, .frames_per_cycle = 1});
-  animator.Update(frames);
 
   absl::StatusOr<SpriteFrame> current = animator.GetCurrentFrame(frames);
   ASSERT_OK(current);
@@ -34,14 +34,14 @@ TEST(AnimatorTest, UsesEachFramesDuration) {
       {.index = 1, .frames_per_cycle = 1},
   };
 
-  animator.Update(frames);
+  animator.Update();
   ASSERT_OK(animator.GetCurrentFrame(frames));
   EXPECT_EQ(animator.GetCurrentFrame(frames)->index, 0);
 
-  animator.Update(frames);
+  animator.Update();
   EXPECT_EQ(animator.GetCurrentFrame(frames)->index, 1);
 
-  animator.Update(frames);
+  animator.Update();
   EXPECT_EQ(animator.GetCurrentFrame(frames)->index, 0);
 }
 
@@ -51,24 +51,57 @@ TEST(AnimatorTest, HandlesFramesRemovedDuringPlayback) {
       {.index = 0, .frames_per_cycle = 1},
       {.index = 1, .frames_per_cycle = 1},
   };
-  animator.Update(frames);
+  animator.Update();
   ASSERT_EQ(animator.GetCurrentFrame(frames)->index, 1);
 
   frames.resize(1);
 
   ASSERT_OK(animator.GetCurrentFrame(frames));
   EXPECT_EQ(animator.GetCurrentFrame(frames)->index, 0);
-  animator.Update(frames);
+  animator.Update();
   EXPECT_EQ(animator.GetCurrentFrame(frames)->index, 0);
 }
 
+TEST(AnimatorTest, LongerEditsKeepTheElapsedTime) {
+  Animator animator;
+  std::vector<SpriteFrame> frames = {
+      {.index = 0, .frames_per_cycle = 2},
+      {.index = 1, .frames_per_cycle = 2},
+  };
+  for (int tick = 0; tick < 3; ++tick) animator.Update();
+  ASSERT_EQ(animator.GetCurrentFrame(frames)->index, 1);
+
+  // Stretching the first frame past the elapsed time brings it back, rather
+  // than carrying on from wherever stepping had got to.
+  frames[0].frames_per_cycle = 4;
+  EXPECT_EQ(animator.GetCurrentFrame(frames)->index, 0);
+}
+
+TEST(AnimatorTest, SwitchingSpritesUsesEachOnesDurations) {
+  Animator animator;
+  const std::vector<SpriteFrame> slow = {
+      {.index = 0, .frames_per_cycle = 3},
+      {.index = 1, .frames_per_cycle = 3},
+  };
+  const std::vector<SpriteFrame> fast = {
+      {.index = 0, .frames_per_cycle = 1},
+      {.index = 1, .frames_per_cycle = 1},
+      {.index = 2, .frames_per_cycle = 1},
+  };
+  for (int tick = 0; tick < 2; ++tick) animator.Update();
+
+  EXPECT_EQ(animator.GetCurrentFrame(slow)->index, 0);
+  EXPECT_EQ(animator.GetCurrentFrame(fast)->index, 2);
+  EXPECT_EQ(animator.GetCurrentFrame(slow)->index, 0);
+}
+
 TEST(AnimatorTest, EmptyFramesAreInactive) {
   Animator animator;
   const std::vector<SpriteFrame> frames;
 
   EXPECT_FALSE(animator.IsActive(frames));
   EXPECT_FALSE(animator.GetCurrentFrame(frames).ok());
-  animator.Update(frames);
+  animator.Update();
 }
 
 }  // namespace
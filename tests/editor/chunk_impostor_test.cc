@@ -0,0 +1,256 @@
+#include "editor/level_editor/chunk_impostor.h"
+
+#include <vector>
+
+#include "absl/container/flat_hash_set.h"
+#include "gtest/gtest.h"
+#include "macros.h"
+
+namespace zebes {
+namespace {
+
+constexpr int kTileSize = 16;
+
+// Uploads nothing; hands out distinct handles and keeps count.
+class FakeTextures : public ChunkImpostorTextures {
+ public:
+  absl::StatusOr<TextureHandle> Upload(const RgbaImage& image) override {
+    uploaded.push_back(image);
+    const TextureHandle texture = TextureHandleAccess::Create(next_id_++, this);
+    live.insert(texture.id());
+    return texture;
+  }
+
+  void Release(TextureHandle texture) override {
+    EXPECT_EQ(live.erase(texture.id()), 1u) << "released a texture twice";
+  }
+
+  std::vector<RgbaImage> uploaded;
+  absl::flat_hash_set<uint64_t> live;
+
+ private:
+  uint64_t next_id_ = 1;
+};
+
+// Two solid tiles side by side: red, then half-transparent blue.
+RgbaImage MakeAtlas() {
+  RgbaImage atlas{.width = 2 * kTileSize, .height = kTileSize};
+  atlas.pixels.assign(static_cast<size_t>(atlas.width) * atlas.height * 4, 0);
+  for (int y = 0; y < atlas.height; ++y) {
+    for (int x = 0; x < atlas.width; ++x) {
+      uint8_t* pixel = &atlas.pixels[(static_cast<size_t>(y) * atlas.width + x) * 4];
+      if (x < kTileSize) {
+        pixel[0] = 255;
+        pixel[3] = 255;
+      } else {
+        pixel[2] = 200;
+        pixel[3] = 128;
+      }
+    }
+  }
+  return atlas;
+}
+
+Tileset MakeTileset() {
+  Tileset tileset;
+  tileset.tile_width = kTileSize;
+  tileset.tile_height = kTileSize;
+  tileset.tiles.push_back(Tile{.id = 1, .name = "Red", .source_x = 0});
+  tileset.tiles.push_back(Tile{.id = 2, .name = "Blue", .source_x = kTileSize});
+  return tileset;
+}
+
+Level MakeLevel() {
+  Level level;
+  level.tile_render_width = kTileSize;
+  level.tile_render_height = kTileSize;
+  return level;
+}
+
+const uint8_t* PixelAt(const RgbaImage& image, int x, int y) {
+  return &image.pixels[(static_cast<size_t>(y) * image.width + x) * 4];
+}
+
+// A camera over the top-left corner of the world showing chunks_wide x
+// chunks_high chunks with one screen pixel per tile.
+Camera OverviewCamera(int chunks_wide, int chunks_high) {
+  const int wide = chunks_wide * TileChunk::kSize;
+  const int high = chunks_high * TileChunk::kSize;
+  return Camera{
+      .position = {wide * kTileSize / 2.0, high * kTileSize / 2.0},
+      .zoom = 1.0 / kTileSize,
+      .viewport_width = wide,
+      .viewport_height = high,
+  };
+}
+
+TEST(SelectChunkImpostorLevelTest, TilesLargeOnScreenAreDrawnIndividually) {
+  EXPECT_EQ(SelectChunkImpostorLevel(MakeLevel(), Camera{.zoom = 1.0}), std::nullopt);
+  EXPECT_EQ(SelectChunkImpostorLevel(MakeLevel(), Camera{.zoom = 0.5}), std::nullopt);
+}
+
+TEST(SelectChunkImpostorLevelTest, TheSmallestLevelThatStillCoversEveryScreenPixel) {
+  // 16 * 0.4 = 6.4 screen pixels per tile: level 0 has 8.
+  EXPECT_EQ(SelectChunkImpostorLevel(MakeLevel(), Camera{.zoom = 0.4}), 0);
+  // 4 screen pixels: level 1 has exactly 4.
+  EXPECT_EQ(SelectChunkImpostorLevel(MakeLevel(), Camera{.zoom = 0.25}), 1);
+  // Under a pixel: the last level.
+  EXPECT_EQ(SelectChunkImpostorLevel(MakeLevel(), Camera{.zoom = 0.01}), kChunkImpostorLevels - 1);
+}
+
+TEST(BakeChunkImpostorTest, EachTileIsAveragedIntoItsCell) {
+  TileChunk chunk;
+  chunk.SetTile(0, 1);
+  chunk.SetTile(1, 2);
+
+  ASSERT_OK_AND_ASSIGN(RgbaImage image, BakeChunkImpostor(chunk, MakeTileset(), MakeAtlas(), 2));
+
+  ASSERT_EQ(image.width, TileChunk::kSize * 2);
+  ASSERT_EQ(image.height, TileChunk::kSize * 2);
+  for (int y = 0; y < 2; ++y) {
+    EXPECT_EQ(PixelAt(image, 1, y)[0], 255);
+    EXPECT_EQ(PixelAt(image, 1, y)[3], 255);
+    // Transparency does not darken the colour it averages.
+    EXPECT_EQ(PixelAt(image, 3, y)[2], 200);
+    EXPECT_EQ(PixelAt(image, 3, y)[3], 128);
+    // Empty cells stay empty.
+    EXPECT_EQ(PixelAt(image, 5, y)[3], 0);
+  }
+}
+
+TEST(BakeChunkImpostorTest, AnUnknownTileIsAnError) {
+  TileChunk chunk;
+  chunk.SetTile(7, 99);
+  EXPECT_EQ(BakeChunkImpostor(chunk, MakeTileset(), MakeAtlas(), 1).status().code(),
+            absl::StatusCode::kInvalidArgument);
+}
+
+TEST(BakeChunkImpostorTest, ATileOutsideItsAtlasIsAnError) {
+  Tileset tileset = MakeTileset();
+  tileset.tiles[1].source_x = 3 * kTileSize;
+  TileChunk chunk;
+  chunk.SetTile(0, 2);
+  EXPECT_EQ(BakeChunkImpostor(chunk, tileset, MakeAtlas(), 1).status().code(),
+            absl::StatusCode::kInvalidArgument);
+}
+
+class ChunkImpostorCacheTest : public ::testing::Test {
+ protected:
+  void Paint(int x, int y, int tile) {
+    ASSERT_OK(SetTileAt(level_.layers.front(), x, y, tile));
+  }
+
+  absl::StatusOr<ChunkImpostorFrame> Compose(ChunkImpostorCache& cache, const Camera& camera,
+                                             int impostor_level = kChunkImpostorLevels - 1) {
+    return cache.Compose(level_, level_.layers.front(), tileset_, atlas_texture_, atlas_, camera,
+                         impostor_level);
+  }
+
+  Level level_ = MakeLevel();
+  Tileset tileset_ = MakeTileset();
+  RgbaImage atlas_ = MakeAtlas();
+  TextureHandle atlas_texture_ = TextureHandleAccess::Create(1000, nullptr);
+  FakeTextures textures_;
+};
+
+TEST_F(ChunkImpostorCacheTest, OnlyVisibleChunksAreBakedAndInRowMajorOrder) {
+  Paint(0, 0, 1);
+  Paint(TileChunk::kSize, 0, 1);
+  Paint(0, TileChunk::kSize, 2);
+  Paint(10 * TileChunk::kSize, 0, 1);
+  ChunkImpostorCache cache(textures_);
+
+  ASSERT_OK_AND_ASSIGN(ChunkImpostorFrame frame, Compose(cache, OverviewCamera(2, 2)));
+
+  ASSERT_EQ(frame.items.size(), 3u);
+  EXPECT_TRUE(frame.pending.empty());
+  EXPECT_EQ(textures_.uploaded.size(), 3u);
+  const double chunk_span = TileChunk::kSize * kTileSize;
+  EXPECT_EQ(frame.items[0].bounds.min.x, 0);
+  EXPECT_EQ(frame.items[1].bounds.min.x, chunk_span);
+  EXPECT_EQ(frame.items[2].bounds.min.y, chunk_span);
+  EXPECT_EQ(frame.items[2].bounds.max.y, 2 * chunk_span);
+}
+
+TEST_F(ChunkImpostorCacheTest, AnUnchangedChunkIsNotRebaked) {
+  Paint(3, 3, 1);
+  ChunkImpostorCache cache(textures_);
+
+  ASSERT_OK_AND_ASSIGN(ChunkImpostorFrame first, Compose(cache, OverviewCamera(1, 1)));
+  cache.EndFrame();
+  ASSERT_OK_AND_ASSIGN(ChunkImpostorFrame second, Compose(cache, OverviewCamera(1, 1)));
+
+  EXPECT_EQ(textures_.uploaded.size(), 1u);
+  ASSERT_EQ(second.items.size(), 1u);
+  EXPECT_EQ(second.items[0].texture, first.items[0].texture);
+}
+
+TEST_F(ChunkImpostorCacheTest, PaintingAChunkRebakesItAndReleasesTheOldImpostor) {
+  Paint(3, 3, 1);
+  ChunkImpostorCache cache(textures_);
+  ASSERT_OK_AND_ASSIGN(ChunkImpostorFrame first, Compose(cache, OverviewCamera(1, 1)));
+  cache.EndFrame();
+
+  Paint(4, 3, 2);
+  ASSERT_OK_AND_ASSIGN(ChunkImpostorFrame second, Compose(cache, OverviewCamera(1, 1)));
+
+  EXPECT_EQ(textures_.uploaded.size(), 2u);
+  EXPECT_NE(second.items[0].texture, first.items[0].texture);
+  EXPECT_EQ(textures_.live.size(), 1u);
+}
+
+TEST_F(ChunkImpostorCacheTest, ANewAtlasOrLevelRebakes) {
+  Paint(3, 3, 1);
+  ChunkImpostorCache cache(textures_);
+  ASSERT_OK(Compose(cache, OverviewCamera(1, 1)));
+  cache.EndFrame();
+
+  atlas_texture_ = TextureHandleAccess::Create(1001, nullptr);
+  ASSERT_OK(Compose(cache, OverviewCamera(1, 1)));
+  cache.EndFrame();
+  EXPECT_EQ(textures_.uploaded.size(), 2u);
+
+  ASSERT_OK(Compose(cache, OverviewCamera(1, 1), 0));
+  EXPECT_EQ(textures_.uploaded.size(), 3u);
+  EXPECT_EQ(textures_.uploaded.back().width, TileChunk::kSize * ChunkImpostorCellPixels(0));
+}
+
+TEST_F(ChunkImpostorCacheTest, BakesPastTheBudgetArePendingUntilTheNextFrame) {
+  for (int chunk = 0; chunk < 4; ++chunk) Paint(chunk * TileChunk::kSize, 0, 1);
+  ChunkImpostorCache cache(textures_, {.max_bakes_per_frame = 3});
+
+  ASSERT_OK_AND_ASSIGN(ChunkImpostorFrame first, Compose(cache, OverviewCamera(4, 1)));
+  EXPECT_EQ(first.items.size(), 3u);
+  EXPECT_EQ(first.pending, absl::flat_hash_set<int64_t>{ChunkKey(3, 0)});
+
+  cache.EndFrame();
+  ASSERT_OK_AND_ASSIGN(ChunkImpostorFrame second, Compose(cache, OverviewCamera(4, 1)));
+  EXPECT_EQ(second.items.size(), 4u);
+  EXPECT_TRUE(second.pending.empty());
+}
+
+TEST_F(ChunkImpostorCacheTest, ImpostorsOutOfViewAreReleasedEventually) {
+  Paint(0, 0, 1);
+  ChunkImpostorCache cache(textures_, {.release_after_frames = 2});
+  ASSERT_OK(Compose(cache, OverviewCamera(1, 1)));
+  cache.EndFrame();
+
+  cache.EndFrame();
+  EXPECT_EQ(cache.size(), 1);
+  cache.EndFrame();
+  EXPECT_EQ(cache.size(), 0);
+  EXPECT_TRUE(textures_.live.empty());
+}
+
+TEST_F(ChunkImpostorCacheTest, DestroyingTheCacheReleasesEverything) {
+  Paint(0, 0, 1);
+  {
+    ChunkImpostorCache cache(textures_);
+    ASSERT_OK(Compose(cache, OverviewCamera(1, 1)));
+    EXPECT_EQ(textures_.live.size(), 1u);
+  }
+  EXPECT_TRUE(textures_.live.empty());
+}
+
+}  // namespace
+}  // namespace zebes
@@ -297,6 +297,36 @@ TEST_F(DerivedTileProviderTest, APreviewMatchingExistingArtworkResolvesToThatTil
   EXPECT_EQ(reopened->appended_tile_count(), 0);
 }
 
+TEST_F(DerivedTileProviderTest, PreparingKeysCreatesNothing) {
+  const std::vector<TerrainCellKey> keys = {
+      KeyOf(TileShape::kFullBlock, {}),
+      KeyOf(TileShape::kFullBlock, {{2, TileShape::kFullBlock}}),
+  };
+  ASSERT_OK(provider_->PrepareKeys(terrain_, keys));
+
+  EXPECT_EQ(provider_->appended_tile_count(), 0);
+  EXPECT_FALSE(provider_->has_uncommitted_tiles());
+}
+
+TEST_F(DerivedTileProviderTest, PreparedKeysResolveAsUnpreparedOnesWould) {
+  const std::vector<TerrainCellKey> keys = {
+      KeyOf(TileShape::kFullBlock, {{2, TileShape::kFullBlock}}),
+      KeyOf(TileShape::kFullBlock, {}),
+      KeyOf(TileShape::kFullBlock, {{6, TileShape::kFullBlock}}),
+  };
+  std::vector<int> unprepared;
+  for (const TerrainCellKey& key : keys) unprepared.push_back(Resolve(key));
+
+  SetUp();
+  ASSERT_OK(provider_->PrepareKeys(terrain_, keys));
+  std::vector<int> prepared;
+  for (const TerrainCellKey& key : keys) prepared.push_back(Resolve(key));
+
+  // Tile IDs follow the order tiles are asked for, not the order they render.
+  EXPECT_EQ(prepared, unprepared);
+  EXPECT_EQ(provider_->appended_tile_count(), 3);
+}
+
 TEST_F(DerivedTileProviderTest, PreviewingABlobFortySevenTerrainIsRefused) {
   Terrain authored = DerivedTerrain();
   authored.scheme = TerrainScheme::kBlob47;
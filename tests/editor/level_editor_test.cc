@@ -1,13 +1,22 @@
 #include "editor/level_editor/level_editor.h"
 
+#include <cstdint>
+#include <filesystem>
 #include <memory>
 #include <optional>
+#include <string>
+#include <variant>
+#include <vector>
 
 #include "absl/status/status.h"
+#include "editor/level_editor/session_recording.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "macros.h"
 #include "objects/level.h"
+#include "objects/level_region.h"
+#include "resources/level_region_store.h"
+#include "resources/level_streamer.h"
 #include "tests/api_mock.h"
 #include "tests/editor/mock_gui.h"
 #include "tests/editor/mock_level_panel.h"
@@ -47,6 +56,25 @@ class LevelEditorTestPeer {
   static absl::Status HandleLevelPanelEvent(LevelEditor& editor, LevelPanelEvent event) {
     return editor.HandleLevelPanelEvent(event);
   }
+
+  static LevelStreamer* GetStreamer(LevelEditor& editor) { return editor.streamer_.get(); }
+
+  static void SetRecorder(LevelEditor& editor, SessionRecorder* recorder) {
+    editor.recorder_ = recorder;
+  }
+
+  // Renders the inspector as Render does, telling the recorder of its edits.
+  static absl::Status RenderRecordedInspector(LevelEditor& editor) {
+    return editor.RenderUnrecorded([&editor] { return editor.RenderInspector(); });
+  }
+
+  // Plays the active level, as pressing Play does.
+  static absl::Status StartPlaying(LevelEditor& editor) {
+    const Level& level = *editor.level_model_.active_level();
+    ASSIGN_OR_RETURN(editor.play_, PlaySession::Create(level));
+    editor.play_level_id_ = level.id;
+    return absl::OkStatus();
+  }
 };
 
 namespace {
@@ -155,12 +183,15 @@ class LevelEditorTest : public ::testing::Test {
     auto editor_or = LevelEditor::Create({
         .api = api_.get(),
         .gui = &gui_,
+        .assets_root = assets_root_,
         .level_panel = std::move(mock_panel),
     });
     ASSERT_OK(editor_or);
     editor_ = *std::move(editor_or);
   }
 
+  // Set before SetUp by fixtures that stream levels from disk.
+  std::string assets_root_;
   std::unique_ptr<MockApi> api_ = std::make_unique<NiceMock<MockApi>>();
   NiceMock<MockGui> gui_;
   std::unique_ptr<LevelEditor> editor_;
@@ -199,6 +230,17 @@ TEST_F(LevelEditorTest, RenderNavigatorSaveLevelFailureDoesNotCallRefresh) {
   EXPECT_TRUE(LevelEditorTestPeer::HasSaveError(*editor_));
 }
 
+TEST_F(LevelEditorTest, RenderNavigatorDoesNotSaveWhilePlaying) {
+  LevelEditorTestPeer::SetEditingLevel(*editor_, Level{.id = "a-id", .name = "Alpha"});
+  ASSERT_OK(LevelEditorTestPeer::StartPlaying(*editor_));
+
+  // A disabled button never reports a click; the editor must not trust it to.
+  EXPECT_CALL(gui_, Button(StrEq("Save Level"), _)).WillRepeatedly(Return(true));
+  EXPECT_CALL(*api_, UpdateLevel(_)).Times(0);
+
+  ASSERT_OK(LevelEditorTestPeer::RenderNavigator(*editor_));
+}
+
 // --- RenderNavigator: close level ---
 
 TEST_F(LevelEditorTest, RenderNavigatorCloseLevelDelegatesListOnNextRender) {
@@ -232,6 +274,102 @@ TEST_F(LevelEditorTest, RenderInspectorLevelSelectionDelegatesToLevelPanel) {
   ASSERT_OK(LevelEditorTestPeer::RenderInspector(*editor_));
 }
 
+TEST_F(LevelEditorTest, RenderInspectorIgnoresLevelDetailsWhilePlaying) {
+  LevelEditorTestPeer::SetEditingLevel(*editor_, Level{.id = "a-id"});
+  SelectionState selection;
+  selection.type = SelectionState::Type::kLevel;
+  LevelEditorTestPeer::SetSelection(*editor_, selection);
+  ASSERT_OK(LevelEditorTestPeer::StartPlaying(*editor_));
+
+  EXPECT_CALL(gui_, CreateScopedDisabled(true)).Times(1);
+  EXPECT_CALL(*mock_level_panel_, RenderDetails(_))
+      .WillOnce(Return(LevelPanelEvent{.action = LevelPanelAction::kSave}));
+  EXPECT_CALL(*api_, UpdateLevel(_)).Times(0);
+
+  ASSERT_OK(LevelEditorTestPeer::RenderInspector(*editor_));
+}
+
+TEST_F(LevelEditorTest, RenderInspectorDisablesEntityControlsWhilePlaying) {
+  Level level{.id = "a-id"};
+  level.layers.push_back(WorldLayer{.id = 1, .name = "Main"});
+  level.layers[0].entities[7] = Entity{.id = 7};
+  LevelEditorTestPeer::SetEditingLevel(*editor_, std::move(level));
+  SelectionState selection;
+  selection.type = SelectionState::Type::kEntity;
+  selection.entity_id = 7;
+  LevelEditorTestPeer::SetSelection(*editor_, selection);
+  ON_CALL(gui_, CreateScopedCombo(_, _, _))
+      .WillByDefault([this](const char* label, const char* preview, ImGuiComboFlags) {
+        return ScopedCombo(&gui_, label, preview);
+      });
+
+  EXPECT_CALL(gui_, CreateScopedDisabled(false)).Times(1);
+  ASSERT_OK(LevelEditorTestPeer::RenderInspector(*editor_));
+
+  ASSERT_OK(LevelEditorTestPeer::StartPlaying(*editor_));
+  EXPECT_CALL(gui_, CreateScopedDisabled(true)).Times(1);
+  ASSERT_OK(LevelEditorTestPeer::RenderInspector(*editor_));
+}
+
+TEST_F(LevelEditorTest, UndoStartsTheRecordingFromTheLevelBeforeTheStep) {
+  Level level{.id = "a-id"};
+  level.layers[0].entities[7] = Entity{.id = 7};
+  LevelEditorTestPeer::SetEditingLevel(*editor_, std::move(level));
+  LevelPanelModel& model = LevelEditorTestPeer::GetLevelModel(*editor_);
+  WorldLayer& layer = model.active_level()->layers[0];
+  Entity& entity = layer.entities[7];
+  const Entity before = entity;
+  entity.transform.position.x = 3;
+  model.journal().RecordEntity(
+      {.layer_id = layer.id, .entity_id = 7, .before = before, .after = entity});
+  const uint64_t moved = LevelStateHash(*model.active_level());
+
+  SessionRecorder recorder;
+  LevelEditorTestPeer::SetRecorder(*editor_, &recorder);
+  recorder.BeginFrame(InputSnapshot());
+  EXPECT_CALL(gui_, Button(StrEq("Undo"), _)).WillOnce(Return(true));
+  ASSERT_OK(LevelEditorTestPeer::RenderNavigator(*editor_));
+
+  EXPECT_EQ(model.active_level()->layers[0].entities[7].transform.position.x, 0);
+  EXPECT_EQ(recorder.recording().initial_hash, moved);
+  ASSERT_EQ(recorder.recording().frames.size(), 1u);
+  ASSERT_EQ(recorder.recording().frames[0].commands.size(), 1u);
+  EXPECT_TRUE(std::holds_alternative<RecordedUndo>(recorder.recording().frames[0].commands[0]));
+}
+
+TEST_F(LevelEditorTest, InspectorEditsMarkTheFrameTheRecordingDivergesOn) {
+  Level level{.id = "a-id"};
+  level.layers.push_back(WorldLayer{.id = 1, .name = "Main"});
+  level.layers[0].entities[7] = Entity{.id = 7};
+  LevelEditorTestPeer::SetEditingLevel(*editor_, std::move(level));
+  SelectionState selection;
+  selection.type = SelectionState::Type::kEntity;
+  selection.entity_id = 7;
+  LevelEditorTestPeer::SetSelection(*editor_, selection);
+  ON_CALL(gui_, CreateScopedCombo(_, _, _))
+      .WillByDefault([this](const char* label, const char* preview, ImGuiComboFlags) {
+        return ScopedCombo(&gui_, label, preview);
+      });
+
+  SessionRecorder recorder;
+  LevelEditorTestPeer::SetRecorder(*editor_, &recorder);
+  recorder.BeginFrame(InputSnapshot());
+  recorder.Begin(*LevelEditorTestPeer::GetLevelModel(*editor_).active_level());
+  recorder.BeginFrame(InputSnapshot());
+
+  // Nothing typed: nothing to mark.
+  ASSERT_OK(LevelEditorTestPeer::RenderRecordedInspector(*editor_));
+  EXPECT_FALSE(recorder.recording().unrecorded_edit_frame.has_value());
+
+  ON_CALL(gui_, InputFloat(StrEq("X"), _, _, _, _, _))
+      .WillByDefault([](const char*, float* v, float, float, const char*, ImGuiInputTextFlags) {
+        *v = 4;
+        return true;
+      });
+  ASSERT_OK(LevelEditorTestPeer::RenderRecordedInspector(*editor_));
+  EXPECT_EQ(recorder.recording().unrecorded_edit_frame, 1);
+}
+
 TEST_F(LevelEditorTest, RenderInspectorNoSelectionDoesNotDelegateToLevelPanel) {
   LevelEditorTestPeer::SetEditingLevel(*editor_, Level{.id = "a-id"});
   // selection_.type == kNone by default.
@@ -255,6 +393,15 @@ TEST_F(LevelEditorTest, CreateEventPersistsDraftAndSelectsLevel) {
   EXPECT_EQ(LevelEditorTestPeer::GetSelectionType(*editor_), SelectionState::Type::kLevel);
 }
 
+TEST_F(LevelEditorTest, CloseEventClosesTheLevel) {
+  LevelEditorTestPeer::SetEditingLevel(*editor_, Level{.id = "a-id", .name = "Alpha"});
+
+  ASSERT_OK(LevelEditorTestPeer::HandleLevelPanelEvent(
+      *editor_, LevelPanelEvent{.action = LevelPanelAction::kClose}));
+
+  EXPECT_FALSE(LevelEditorTestPeer::HasEditingLevel(*editor_));
+}
+
 TEST_F(LevelEditorTest, FailedDeletePreservesModelSelection) {
   LevelPanelModel& model = LevelEditorTestPeer::GetLevelModel(*editor_);
   model.SetLevels({{.id = "cave", .name = "Cave"}});
@@ -269,5 +416,99 @@ TEST_F(LevelEditorTest, FailedDeletePreservesModelSelection) {
   EXPECT_EQ(model.selected_level_id(), "cave");
 }
 
+constexpr char kStreamedRoot[] = "test_data/level_editor_test";
+constexpr char kStreamedLevelId[] = "streamed";
+
+// A level split into regions under kStreamedRoot, holding one entity.
+class LevelEditorStreamingTest : public LevelEditorTest {
+ protected:
+  void SetUp() override {
+    std::filesystem::remove_all(kStreamedRoot);
+    definition_ = Level{.id = kStreamedLevelId, .name = "Streamed"};
+    definition_.layers.front().entities.emplace(
+        1, Entity{.id = 1, .transform = {.position = {.x = 10, .y = 10}}});
+    ASSERT_OK_AND_ASSIGN(std::unique_ptr<LevelRegionStore> store,
+                         LevelRegionStore::Create(kStreamedRoot, kStreamedLevelId));
+    for (const LevelRegion& region : TakeAllRegions(definition_, store->region_chunks())) {
+      ASSERT_OK(store->Write(region));
+    }
+    assets_root_ = kStreamedRoot;
+    LevelEditorTest::SetUp();
+  }
+
+  void TearDown() override { std::filesystem::remove_all(kStreamedRoot); }
+
+  // Opens the level as the level list does, then loads all of it.
+  void OpenLevel() {
+    LevelEditorTestPeer::GetLevelModel(*editor_).BeginEditingLevel(definition_);
+    ASSERT_OK(LevelEditorTestPeer::HandleLevelPanelEvent(
+        *editor_, LevelPanelEvent{.action = LevelPanelAction::kOpen}));
+    LevelStreamer* streamer = LevelEditorTestPeer::GetStreamer(*editor_);
+    ASSERT_NE(streamer, nullptr);
+    ASSERT_OK(streamer->LoadAll());
+  }
+
+  Level& ActiveLevel() { return *LevelEditorTestPeer::GetLevelModel(*editor_).active_level(); }
+
+  // The entity IDs stored in region (0, 0).
+  std::vector<uint64_t> StoredEntityIds() {
+    absl::StatusOr<std::unique_ptr<LevelRegionStore>> store =
+        LevelRegionStore::Open(kStreamedRoot, kStreamedLevelId);
+    if (!store.ok()) return {};
+    absl::StatusOr<LevelRegion> region = (*store)->Read({.x = 0, .y = 0});
+    if (!region.ok() || region->layers.empty()) return {};
+    std::vector<uint64_t> ids;
+    for (const auto& [id, entity] : region->layers.front().entities) ids.push_back(id);
+    return ids;
+  }
+
+  // The definition as split: layers with nothing in them.
+  Level definition_;
+};
+
+TEST_F(LevelEditorStreamingTest, OpeningAStreamedLevelLoadsItsRegions) {
+  OpenLevel();
+  EXPECT_NE(FindEntity(ActiveLevel(), 1), nullptr);
+}
+
+TEST_F(LevelEditorStreamingTest, ALevelWithoutRegionsOpensWhole) {
+  LevelEditorTestPeer::GetLevelModel(*editor_).BeginEditingLevel(
+      Level{.id = "whole", .name = "Whole"});
+  ASSERT_OK(LevelEditorTestPeer::HandleLevelPanelEvent(
+      *editor_, LevelPanelEvent{.action = LevelPanelAction::kOpen}));
+  EXPECT_EQ(LevelEditorTestPeer::GetStreamer(*editor_), nullptr);
+}
+
+TEST_F(LevelEditorStreamingTest, SavingWritesRegionsAndAnEmptyDefinition) {
+  OpenLevel();
+  ASSERT_OK(ActiveLevel().AddEntity(0, Entity{.id = 2, .transform = {.position = {20, 20}}}));
+
+  std::optional<Level> saved;
+  EXPECT_CALL(*api_, UpdateLevel(_)).WillOnce([&](Level level) {
+    saved = std::move(level);
+    return absl::OkStatus();
+  });
+  ASSERT_OK(LevelEditorTestPeer::HandleLevelPanelEvent(
+      *editor_, LevelPanelEvent{.action = LevelPanelAction::kSave}));
+
+  ASSERT_TRUE(saved.has_value());
+  EXPECT_TRUE(saved->layers.front().entities.empty());
+  EXPECT_THAT(StoredEntityIds(), ::testing::ElementsAre(1, 2));
+  // The live level keeps its content.
+  EXPECT_NE(FindEntity(ActiveLevel(), 2), nullptr);
+}
+
+TEST_F(LevelEditorStreamingTest, ClosingDropsUnsavedEdits) {
+  OpenLevel();
+  ASSERT_OK(ActiveLevel().AddEntity(0, Entity{.id = 2, .transform = {.position = {20, 20}}}));
+
+  ASSERT_OK(LevelEditorTestPeer::HandleLevelPanelEvent(
+      *editor_, LevelPanelEvent{.action = LevelPanelAction::kClose}));
+
+  EXPECT_FALSE(LevelEditorTestPeer::HasEditingLevel(*editor_));
+  EXPECT_EQ(LevelEditorTestPeer::GetStreamer(*editor_), nullptr);
+  EXPECT_THAT(StoredEntityIds(), ::testing::ElementsAre(1));
+}
+
 }  // namespace
 }  // namespace zebes
@@ -0,0 +1,343 @@
+#include "editor/level_editor/level_journal.h"
+
+#include <vector>
+
+#include "absl/status/status.h"
+#include "common/status_macros.h"
+#include "gtest/gtest.h"
+#include "macros.h"
+
+namespace zebes {
+namespace {
+
+using LayerDelta = LevelJournal::LayerDelta;
+
+int TileAt(const Level& level, int x, int y, int layer_index = 0) {
+  absl::StatusOr<int> tile = GetTileAt(level.layers[layer_index], x, y);
+  EXPECT_OK(tile);
+  return tile.value_or(-1);
+}
+
+// Writes `tile_id` to each cell through the journal, as one edit.
+absl::Status Paint(LevelJournal& journal, Level& level, std::vector<TileCoordinate> cells,
+                   int tile_id) {
+  WorldLayer& layer = level.layers.front();
+  return journal.RecordTiles(layer, cells, [&]() -> absl::Status {
+    for (const TileCoordinate& cell : cells) {
+      RETURN_IF_ERROR(SetTileAt(layer, cell.x, cell.y, tile_id));
+    }
+    return absl::OkStatus();
+  });
+}
+
+TEST(LevelJournalTest, UndoAndRedoRestoreTheCellsAnEditChanged) {
+  Level level;
+  LevelJournal journal;
+  ASSERT_OK((Paint(journal, level, {{1, 1}}, 3)));
+  ASSERT_OK((Paint(journal, level, {{1, 1}, {2, 1}}, 4)));
+  ASSERT_EQ(journal.size(), 2u);
+
+  ASSERT_OK(journal.Undo(level));
+  EXPECT_EQ(TileAt(level, 1, 1), 3);
+  EXPECT_EQ(TileAt(level, 2, 1), 0);
+
+  ASSERT_OK(journal.Undo(level));
+  EXPECT_EQ(TileAt(level, 1, 1), 0);
+  EXPECT_TRUE(level.layers.front().tile_chunks.empty()) << "undo must not leave empty chunks";
+  EXPECT_FALSE(journal.can_undo());
+
+  ASSERT_OK(journal.Redo(level));
+  ASSERT_OK(journal.Redo(level));
+  EXPECT_EQ(TileAt(level, 1, 1), 4);
+  EXPECT_EQ(TileAt(level, 2, 1), 4);
+  EXPECT_FALSE(journal.can_redo());
+}
+
+TEST(LevelJournalTest, OnlyCellsThatChangedAreRecorded) {
+  Level level;
+  LevelJournal journal;
+  ASSERT_OK((Paint(journal, level, {{0, 0}}, 5)));
+
+  // Watching a neighbourhood the edit leaves alone records nothing.
+  const std::vector<TileCoordinate> watched = {{0, 0}, {1, 0}, {-1, 0}};
+  ASSERT_OK(journal.RecordTiles(level.layers.front(), watched, [] { return absl::OkStatus(); }));
+  EXPECT_EQ(journal.size(), 1u);
+}
+
+TEST(LevelJournalTest, AFailedEditIsStillRecordedSoItCanBeUndone) {
+  Level level;
+  LevelJournal journal;
+  WorldLayer& layer = level.layers.front();
+
+  const std::vector<TileCoordinate> cells = {{0, 0}, {1, 0}};
+  const absl::Status status = journal.RecordTiles(layer, cells, [&]() -> absl::Status {
+    RETURN_IF_ERROR(SetTileAt(layer, 0, 0, 2));
+    return absl::InternalError("halfway");
+  });
+  EXPECT_EQ(status.code(), absl::StatusCode::kInternal);
+
+  ASSERT_OK(journal.Undo(level));
+  EXPECT_EQ(TileAt(level, 0, 0), 0);
+}
+
+TEST(LevelJournalTest, AGroupIsOneStepKeepingEachCellsFirstAndLastState) {
+  Level level;
+  LevelJournal journal;
+  ASSERT_OK((Paint(journal, level, {{0, 0}}, 1)));
+
+  journal.BeginGroup();
+  ASSERT_OK((Paint(journal, level, {{0, 0}, {1, 0}}, 2)));
+  ASSERT_OK((Paint(journal, level, {{1, 0}, {2, 0}}, 3)));
+  journal.EndGroup();
+  ASSERT_EQ(journal.size(), 2u);
+
+  ASSERT_OK(journal.Undo(level));
+  EXPECT_EQ(TileAt(level, 0, 0), 1);
+  EXPECT_EQ(TileAt(level, 1, 0), 0);
+  EXPECT_EQ(TileAt(level, 2, 0), 0);
+
+  ASSERT_OK(journal.Redo(level));
+  EXPECT_EQ(TileAt(level, 0, 0), 2);
+  EXPECT_EQ(TileAt(level, 1, 0), 3);
+  EXPECT_EQ(TileAt(level, 2, 0), 3);
+}
+
+TEST(LevelJournalTest, AGroupThatChangedNothingLeavesNoEntry) {
+  Level level;
+  LevelJournal journal;
+
+  journal.BeginGroup();
+  ASSERT_OK((Paint(journal, level, {{4, 4}}, 2)));
+  ASSERT_OK((Paint(journal, level, {{4, 4}}, 0)));
+  journal.EndGroup();
+
+  EXPECT_EQ(journal.size(), 0u);
+  EXPECT_FALSE(journal.dirty());
+}
+
+TEST(LevelJournalTest, DirtyFollowsThePositionNotTheContents) {
+  Level level;
+  LevelJournal journal;
+  EXPECT_FALSE(journal.dirty());
+
+  ASSERT_OK((Paint(journal, level, {{0, 0}}, 1)));
+  EXPECT_TRUE(journal.dirty());
+  ASSERT_OK(journal.Undo(level));
+  EXPECT_FALSE(journal.dirty());
+  ASSERT_OK(journal.Redo(level));
+  EXPECT_TRUE(journal.dirty());
+
+  journal.MarkSaved();
+  EXPECT_FALSE(journal.dirty());
+  ASSERT_OK(journal.Undo(level));
+  EXPECT_TRUE(journal.dirty()) << "the saved state had the tile";
+}
+
+TEST(LevelJournalTest, EditingAfterUndoingPastTheSaveLosesTheSavedState) {
+  Level level;
+  LevelJournal journal;
+  ASSERT_OK((Paint(journal, level, {{0, 0}}, 1)));
+  journal.MarkSaved();
+  ASSERT_OK(journal.Undo(level));
+
+  ASSERT_OK((Paint(journal, level, {{0, 0}}, 2)));
+  EXPECT_FALSE(journal.can_redo());
+  ASSERT_OK(journal.Undo(level));
+  EXPECT_TRUE(journal.dirty()) << "nothing reachable matches what was saved";
+}
+
+TEST(LevelJournalTest, ClearingKeepsWhetherTheLevelIsSaved) {
+  Level level;
+  LevelJournal journal;
+  ASSERT_OK((Paint(journal, level, {{0, 0}}, 1)));
+  journal.Clear();
+  EXPECT_FALSE(journal.can_undo());
+  EXPECT_TRUE(journal.dirty());
+
+  journal.MarkSaved();
+  journal.Clear();
+  EXPECT_FALSE(journal.dirty());
+
+  ASSERT_OK((Paint(journal, level, {{0, 0}}, 2)));
+  journal.Reset(/*saved=*/false);
+  EXPECT_FALSE(journal.can_undo());
+  EXPECT_TRUE(journal.dirty());
+  journal.Reset();
+  EXPECT_FALSE(journal.dirty());
+}
+
+TEST(LevelJournalTest, EntitiesAreAddedRemovedAndChanged) {
+  Level level;
+  LevelJournal journal;
+  const Entity placed{.id = 7, .transform = {.position = {10, 20}}};
+  ASSERT_OK(level.AddEntity(0, placed));
+  journal.RecordEntity({.layer_id = 0, .entity_id = 7, .after = placed});
+
+  Entity moved = placed;
+  moved.transform.position = {30, 40};
+  level.layers.front().entities[7] = moved;
+  journal.RecordEntity({.layer_id = 0, .entity_id = 7, .before = placed, .after = moved});
+
+  level.layers.front().entities.erase(7);
+  journal.RecordEntity({.layer_id = 0, .entity_id = 7, .before = moved});
+  ASSERT_EQ(journal.size(), 3u);
+
+  ASSERT_OK(journal.Undo(level));
+  EXPECT_EQ(FindEntity(level, 7)->transform.position, (Vec{30, 40}));
+  ASSERT_OK(journal.Undo(level));
+  EXPECT_EQ(FindEntity(level, 7)->transform.position, (Vec{10, 20}));
+  ASSERT_OK(journal.Undo(level));
+  EXPECT_EQ(FindEntity(level, 7), nullptr);
+  ASSERT_OK(journal.Redo(level));
+  EXPECT_NE(FindEntity(level, 7), nullptr);
+}
+
+TEST(LevelJournalTest, CoalescedEditsToOneEntityUndoTogether) {
+  Level level;
+  Entity entity{.id = 1};
+  ASSERT_OK(level.AddEntity(0, entity));
+  LevelJournal journal;
+
+  for (int x = 1; x <= 5; ++x) {
+    const Entity before = entity;
+    entity.transform.position.x = x;
+    level.layers.front().entities[1] = entity;
+    journal.RecordEntity({.layer_id = 0, .entity_id = 1, .before = before, .after = entity},
+                         /*coalesce=*/true);
+  }
+  ASSERT_EQ(journal.size(), 1u);
+
+  ASSERT_OK(journal.Undo(level));
+  EXPECT_EQ(FindEntity(level, 1)->transform.position.x, 0);
+}
+
+TEST(LevelJournalTest, EditsCountCoalescedChangesAndHistoryButNotNoOps) {
+  Level level;
+  Entity entity{.id = 1};
+  ASSERT_OK(level.AddEntity(0, entity));
+  LevelJournal journal;
+
+  journal.RecordEntity({.layer_id = 0, .entity_id = 1, .before = entity, .after = entity}, true);
+  EXPECT_EQ(journal.edits(), 0u);
+
+  for (int x = 1; x <= 2; ++x) {
+    const Entity before = entity;
+    entity.transform.position.x = x;
+    level.layers.front().entities[1] = entity;
+    journal.RecordEntity({.layer_id = 0, .entity_id = 1, .before = before, .after = entity},
+                         /*coalesce=*/true);
+  }
+  ASSERT_EQ(journal.size(), 1u);
+  EXPECT_EQ(journal.edits(), 2u);
+
+  ASSERT_OK(journal.Undo(level));
+  ASSERT_OK(journal.Redo(level));
+  EXPECT_EQ(journal.edits(), 4u);
+  EXPECT_FALSE(journal.Redo(level).ok());
+  EXPECT_EQ(journal.edits(), 4u);
+}
+
+TEST(LevelJournalTest, CoalescingNeverJoinsTheSavedEntry) {
+  Level level;
+  Entity entity{.id = 1};
+  ASSERT_OK(level.AddEntity(0, entity));
+  LevelJournal journal;
+
+  const Entity before = entity;
+  entity.transform.position.x = 1;
+  level.layers.front().entities[1] = entity;
+  journal.RecordEntity({.layer_id = 0, .entity_id = 1, .before = before, .after = entity}, true);
+  journal.MarkSaved();
+
+  const Entity saved = entity;
+  entity.transform.position.x = 2;
+  level.layers.front().entities[1] = entity;
+  journal.RecordEntity({.layer_id = 0, .entity_id = 1, .before = saved, .after = entity}, true);
+
+  EXPECT_EQ(journal.size(), 2u);
+  EXPECT_TRUE(journal.dirty());
+}
+
+TEST(LevelJournalTest, LayerInsertionsRemovalsAndSwapsReplay) {
+  Level level;
+  level.layers.push_back(WorldLayer{.id = 1, .name = "Front"});
+  LevelJournal journal;
+
+  WorldLayer removed = level.layers.front();
+  ASSERT_OK(SetTileAt(removed, 3, 3, 9));
+  level.layers.erase(level.layers.begin());
+  journal.RecordLayer({.kind = LayerDelta::Kind::kRemove, .index = 0, .layer = removed});
+
+  level.layers.insert(level.layers.begin(), WorldLayer{.id = 2, .name = "Back"});
+  journal.RecordLayer({.kind = LayerDelta::Kind::kInsert, .index = 0, .layer = level.layers[0]});
+
+  std::swap(level.layers[0], level.layers[1]);
+  journal.RecordLayer({.kind = LayerDelta::Kind::kSwap, .index = 0, .other_index = 1});
+
+  ASSERT_OK(journal.Undo(level));
+  ASSERT_OK(journal.Undo(level));
+  ASSERT_OK(journal.Undo(level));
+  ASSERT_EQ(level.layers.size(), 2u);
+  EXPECT_EQ(level.layers[0].id, 0);
+  EXPECT_EQ(level.layers[1].id, 1);
+  EXPECT_EQ(TileAt(level, 3, 3), 9) << "a removed layer comes back with its contents";
+
+  ASSERT_OK(journal.Redo(level));
+  ASSERT_OK(journal.Redo(level));
+  ASSERT_OK(journal.Redo(level));
+  ASSERT_EQ(level.layers.size(), 2u);
+  EXPECT_EQ(level.layers[0].id, 1);
+  EXPECT_EQ(level.layers[1].id, 2);
+}
+
+TEST(LevelJournalTest, TellsWhetherTheNextStepRemovesALayer) {
+  Level level;
+  LevelJournal journal;
+  EXPECT_FALSE(journal.UndoRemovesLayer());
+  EXPECT_FALSE(journal.RedoRemovesLayer());
+
+  const WorldLayer removed = level.layers.front();
+  level.layers.erase(level.layers.begin());
+  journal.RecordLayer({.kind = LayerDelta::Kind::kRemove, .index = 0, .layer = removed});
+  level.layers.push_back(WorldLayer{.id = 1, .name = "Front"});
+  journal.RecordLayer({.kind = LayerDelta::Kind::kInsert, .index = 0, .layer = level.layers[0]});
+
+  // Undoing the insertion removes layer 1; undoing the removal restores layer 0.
+  EXPECT_TRUE(journal.UndoRemovesLayer());
+  ASSERT_OK(journal.Undo(level));
+  EXPECT_FALSE(journal.UndoRemovesLayer());
+  EXPECT_FALSE(journal.RedoRemovesLayer());
+  ASSERT_OK(journal.Undo(level));
+  EXPECT_TRUE(journal.RedoRemovesLayer());
+}
+
+TEST(LevelJournalTest, AnEntryTheLevelNoLongerMatchesIsRefused) {
+  Level level;
+  LevelJournal journal;
+  ASSERT_OK((Paint(journal, level, {{0, 0}, {1, 0}}, 1)));
+
+  // Edited behind the journal's back.
+  ASSERT_OK(SetTileAt(level.layers.front(), 1, 0, 6));
+
+  EXPECT_EQ(journal.Undo(level).code(), absl::StatusCode::kFailedPrecondition);
+  EXPECT_EQ(TileAt(level, 0, 0), 1) << "nothing is half-undone";
+  EXPECT_EQ(journal.position(), 1u);
+}
+
+TEST(LevelJournalTest, TheOldestEntriesAreDroppedPastTheLimit) {
+  Level level;
+  LevelJournal journal;
+  journal.MarkSaved();
+  for (size_t i = 0; i <= LevelJournal::kMaxEntries; ++i) {
+    ASSERT_OK((Paint(journal, level, {{0, 0}}, static_cast<int>(i % 2) + 1)));
+  }
+
+  EXPECT_EQ(journal.size(), LevelJournal::kMaxEntries);
+  while (journal.can_undo()) {
+    ASSERT_OK(journal.Undo(level));
+  }
+  EXPECT_TRUE(journal.dirty()) << "the saved state fell off the end";
+}
+
+}  // namespace
+}  // namespace zebes
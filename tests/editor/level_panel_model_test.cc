@@ -4,6 +4,7 @@
 #include <utility>
 
 #include "absl/status/status.h"
+#include "editor/level_editor/viewport_model.h"
 #include "gtest/gtest.h"
 #include "macros.h"
 
@@ -15,7 +16,7 @@ namespace {
 Level LevelWithTiles(std::string tileset_id, int count) {
   Level level{.id = "alpha", .tileset_id = std::move(tileset_id)};
   TileChunk chunk{};
-  for (int i = 0; i < count; ++i) chunk.tiles[i] = i + 1;
+  for (int i = 0; i < count; ++i) chunk.SetTile(i, i + 1);
   level.layers.front().tile_chunks[0] = chunk;
   return level;
 }
@@ -210,30 +211,59 @@ TEST(LevelPanelModelTest, EditsToAnyPartOfALevelCount) {
   model.active_level()->name = "Renamed";
   EXPECT_TRUE(model.has_unsaved_changes());
 
-  // Painting is the edit that matters most and the one a flag is most likely
-  // to miss, since it goes straight into the chunk map.
+  // Painting is the edit that matters most, and it is answered by the journal
+  // rather than by comparing chunk maps.
   ASSERT_OK(model.BeginEditingSelectedLevel());
-  model.active_level()->layers.front().tile_chunks[0].tiles[5] = 7;
+  WorldLayer& layer = model.active_level()->layers.front();
+  ASSERT_OK(model.journal().RecordTiles(layer, {{{5, 0}}},
+                                        [&] { return SetTileAt(layer, 5, 0, 7); }));
   EXPECT_TRUE(model.has_unsaved_changes());
 
   ASSERT_OK(model.BeginEditingSelectedLevel());
-  model.active_level()->layers.front().entities[1] = Entity{.id = 1};
+  const Entity entity{.id = 1};
+  model.active_level()->layers.front().entities[1] = entity;
+  model.journal().RecordEntity({.layer_id = 0, .entity_id = 1, .after = entity});
+  EXPECT_TRUE(model.has_unsaved_changes());
+
+  ASSERT_OK(model.BeginEditingSelectedLevel());
+  model.active_level()->layers.front().name = "Ground";
   EXPECT_TRUE(model.has_unsaved_changes());
 }
 
-// Comparing against a snapshot rather than latching a flag means painting a
-// tile and erasing it again correctly reports clean.
-TEST(LevelPanelModelTest, UndoingAnEditByHandIsCleanAgain) {
+// Dirtiness follows the journal's position, so undoing back to the opened
+// state is clean again.
+TEST(LevelPanelModelTest, UndoingBackToTheOpenedStateIsClean) {
   LevelPanelModel model;
   model.SetLevels({Level{.id = "a", .name = "Alpha"}});
   ASSERT_OK(model.SelectLevel("a"));
   ASSERT_OK(model.BeginEditingSelectedLevel());
 
-  model.active_level()->layers.front().tile_chunks[0].tiles[5] = 7;
+  WorldLayer& layer = model.active_level()->layers.front();
+  ASSERT_OK(model.journal().RecordTiles(layer, {{{5, 0}}},
+                                        [&] { return SetTileAt(layer, 5, 0, 7); }));
   ASSERT_TRUE(model.has_unsaved_changes());
 
-  model.active_level()->layers.front().tile_chunks.erase(0);
+  ASSERT_OK(model.journal().Undo(*model.active_level()));
   EXPECT_FALSE(model.has_unsaved_changes());
+  EXPECT_TRUE(model.active_level()->layers.front().tile_chunks.empty());
+}
+
+TEST(LevelPanelModelTest, ATilesetChangeEndsHistoryAndCannotBeUndoneToClean) {
+  LevelPanelModel model;
+  model.SetLevels({LevelWithTiles("grass-uuid", 3)});
+  ASSERT_OK(model.SelectLevel("alpha"));
+  ASSERT_OK(model.BeginEditingSelectedLevel());
+  WorldLayer& layer = model.active_level()->layers.front();
+  ASSERT_OK(model.journal().RecordTiles(layer, {{{9, 0}}},
+                                        [&] { return SetTileAt(layer, 9, 0, 2); }));
+
+  ASSERT_OK(model.RequestTilesetChange("stone-uuid"));
+  ASSERT_OK(model.ConfirmTilesetChange());
+  EXPECT_FALSE(model.journal().can_undo()) << "its entries name the old tileset's tiles";
+
+  // Choosing the old tileset again does not bring the erased tiles back.
+  ASSERT_OK(model.RequestTilesetChange("grass-uuid"));
+  EXPECT_TRUE(model.has_unsaved_changes());
 }
 
 TEST(LevelPanelModelTest, SavingMakesTheCurrentStateTheCleanOne) {
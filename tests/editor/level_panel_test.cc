@@ -112,7 +112,7 @@ TEST_F(LevelPanelTest, SaveReportsIntentWithoutPersisting) {
   EXPECT_TRUE(model_.has_active_level());
 }
 
-TEST_F(LevelPanelTest, BackClosesActiveLevel) {
+TEST_F(LevelPanelTest, BackReportsCloseAndLeavesClosingToTheEditor) {
   model_.BeginEditingLevel(Level{.id = "alpha", .name = "Alpha"});
   EXPECT_CALL(gui_, Button(StrEq("Back"), _)).WillOnce(Return(true));
 
@@ -120,7 +120,8 @@ TEST_F(LevelPanelTest, BackClosesActiveLevel) {
 
   ASSERT_OK(event);
   EXPECT_EQ(event->action, LevelPanelAction::kClose);
-  EXPECT_FALSE(model_.has_active_level());
+  // A streamed level still has regions to write out before it goes.
+  EXPECT_TRUE(model_.has_active_level());
 }
 
 TEST_F(LevelPanelTest, TilesetComboPreviewsTheLevelsTilesetByName) {
@@ -157,7 +158,7 @@ TEST_F(LevelPanelTest, PickingATilesetForAPopulatedLevelAsksFirst) {
   model_.SetTilesetChoices({{.id = "grass-uuid", .name = "Grass"}});
   Level level{.id = "alpha", .tileset_id = "sunny-uuid"};
   TileChunk chunk{};
-  chunk.tiles[0] = 4;
+  chunk.SetTile(0, 4);
   level.layers.front().tile_chunks[0] = chunk;
   model_.BeginEditingLevel(std::move(level));
   OpenTilesetCombo();
@@ -174,7 +175,7 @@ TEST_F(LevelPanelTest, ConfirmingTheSwitchDiscardsTheTiles) {
   model_.SetTilesetChoices({{.id = "grass-uuid", .name = "Grass"}});
   Level level{.id = "alpha", .tileset_id = "sunny-uuid"};
   TileChunk chunk{};
-  chunk.tiles[0] = 4;
+  chunk.SetTile(0, 4);
   level.layers.front().tile_chunks[0] = chunk;
   model_.BeginEditingLevel(std::move(level));
   ASSERT_OK(model_.RequestTilesetChange("grass-uuid"));
@@ -192,7 +193,7 @@ TEST_F(LevelPanelTest, KeepingTheTilesetCancelsTheSwitch) {
   model_.SetTilesetChoices({{.id = "grass-uuid", .name = "Grass"}});
   Level level{.id = "alpha", .tileset_id = "sunny-uuid"};
   TileChunk chunk{};
-  chunk.tiles[0] = 4;
+  chunk.SetTile(0, 4);
   level.layers.front().tile_chunks[0] = chunk;
   model_.BeginEditingLevel(std::move(level));
   ASSERT_OK(model_.RequestTilesetChange("grass-uuid"));
@@ -10,7 +10,7 @@ namespace {
 // these queries do not care about.
 TileChunk ChunkWithTiles(int count) {
   TileChunk chunk{};
-  for (int i = 0; i < count; ++i) chunk.tiles[i] = i + 1;
+  for (int i = 0; i < count; ++i) chunk.SetTile(i, i + 1);
   return chunk;
 }
 
@@ -2,6 +2,11 @@
 
 #include <gtest/gtest.h>
 
+#include <cstddef>
+#include <limits>
+#include <random>
+#include <vector>
+
 namespace zebes {
 namespace {
 
@@ -233,5 +238,168 @@ TEST(ParallaxLayoutTest, ConstrainedFrameRejectsInvalidWorldBounds) {
                    .has_value());
 }
 
+TEST(ParallaxLayoutTest, CachedGeometryPlacesLayerLikeDirectLayout) {
+  Camera camera{
+      .position = {1234, -567},
+      .zoom = 0.75,
+      .viewport_width = 800,
+      .viewport_height = 600,
+  };
+  ParallaxLayer layer{
+      .scroll_factor = {0.5, 0.25},
+      .offset = {30, -40},
+      .base_scale = 1.5f,
+      .repeat_x = true,
+  };
+
+  std::optional<ParallaxLayerGeometry> geometry = CalculateParallaxLayerGeometry(layer, 100, 50);
+  ASSERT_TRUE(geometry.has_value());
+  std::optional<ParallaxLayout> cached = CalculateParallaxLayout(camera, *geometry);
+  std::optional<ParallaxLayout> direct = CalculateParallaxLayout(camera, layer, 100, 50);
+
+  ASSERT_TRUE(cached.has_value());
+  ASSERT_TRUE(direct.has_value());
+  EXPECT_DOUBLE_EQ(cached->origin.x, direct->origin.x);
+  EXPECT_DOUBLE_EQ(cached->origin.y, direct->origin.y);
+  EXPECT_DOUBLE_EQ(cached->tile_width, 150);
+  EXPECT_DOUBLE_EQ(cached->tile_height, 75);
+  EXPECT_EQ(cached->first_column, direct->first_column);
+  EXPECT_EQ(cached->last_column, direct->last_column);
+  EXPECT_EQ(cached->first_row, 0);
+  EXPECT_EQ(cached->last_row, 0);
+
+  camera.zoom = 0;
+  EXPECT_FALSE(CalculateParallaxLayout(camera, *geometry).has_value());
+  EXPECT_FALSE(CalculateParallaxLayerGeometry(layer, 0, 50).has_value());
+}
+
+TEST(ParallaxLayoutTest, ZoneIndexMatchesLinearResolution) {
+  std::mt19937 random(7);
+  std::uniform_real_distribution<double> position(-4096, 4096);
+  std::uniform_real_distribution<double> size(16, 1024);
+  std::vector<ParallaxZone> zones;
+  for (int id = 0; id < 300; ++id) {
+    const Vec min{position(random), position(random)};
+    zones.push_back({.id = id,
+                     .theme_id = id % 5,
+                     .min_point = min,
+                     .max_point = {min.x + size(random), min.y + size(random)}});
+  }
+  // A level-sized zone in the middle of the order, and a degenerate one.
+  zones[150].min_point = {-8192, -8192};
+  zones[150].max_point = {8192, 8192};
+  zones[151].max_point = zones[151].min_point;
+
+  ParallaxZoneIndex index;
+  index.Sync(zones);
+
+  for (int sample = 0; sample < 5000; ++sample) {
+    const Vec point{position(random), position(random)};
+    std::optional<ActiveParallaxZone> expected = ResolveActiveParallaxZone(zones, point);
+    std::optional<ActiveParallaxZone> actual = index.Resolve(point);
+    ASSERT_EQ(actual.has_value(), expected.has_value()) << point.x << ", " << point.y;
+    if (expected.has_value()) {
+      ASSERT_EQ(actual->zone_id, expected->zone_id) << point.x << ", " << point.y;
+      ASSERT_EQ(actual->theme_id, expected->theme_id);
+    }
+  }
+  // Exact corners exercise the half-open bounds.
+  for (const ParallaxZone& zone : zones) {
+    for (const Vec point : {zone.min_point, zone.max_point}) {
+      std::optional<ActiveParallaxZone> expected = ResolveActiveParallaxZone(zones, point);
+      std::optional<ActiveParallaxZone> actual = index.Resolve(point);
+      ASSERT_EQ(actual.has_value(), expected.has_value());
+      if (expected.has_value()) {
+        ASSERT_EQ(actual->zone_id, expected->zone_id);
+      }
+    }
+  }
+}
+
+TEST(ParallaxLayoutTest, ZoneIndexKeepsLaterZonePriorityOverWideZones) {
+  const double infinity = std::numeric_limits<double>::infinity();
+  std::vector<ParallaxZone> zones{
+      {.id = 1, .theme_id = 10, .min_point = {0, 0}, .max_point = {100, 100}},
+      {.id = 2, .theme_id = 20, .min_point = {-infinity, -infinity},
+       .max_point = {infinity, infinity}},
+      {.id = 3, .theme_id = 30, .min_point = {50, 50}, .max_point = {60, 60}},
+  };
+  ParallaxZoneIndex index;
+  index.Sync(zones);
+
+  EXPECT_EQ(index.Resolve({10, 10})->zone_id, 2);
+  EXPECT_EQ(index.Resolve({55, 55})->zone_id, 3);
+  EXPECT_EQ(index.Resolve({1e9, -1e9})->zone_id, 2);
+  EXPECT_FALSE(index.Resolve({std::numeric_limits<double>::quiet_NaN(), 0}).has_value());
+}
+
+TEST(ParallaxLayoutTest, ZoneIndexRebuildsWhenZonesChange) {
+  std::vector<ParallaxZone> zones{
+      {.id = 1, .theme_id = 10, .min_point = {0, 0}, .max_point = {100, 100}},
+  };
+  ParallaxZoneIndex index;
+  index.Sync(zones);
+  EXPECT_FALSE(index.Resolve({150, 50}).has_value());
+
+  zones[0].max_point.x = 200;
+  index.Sync(zones);
+  EXPECT_EQ(index.Resolve({150, 50})->zone_id, 1);
+
+  zones.push_back({.id = 2, .theme_id = 20, .min_point = {100, 0}, .max_point = {300, 100}});
+  index.Sync(zones);
+  EXPECT_EQ(index.Resolve({150, 50})->zone_id, 2);
+  EXPECT_EQ(index.Resolve({150, 50})->theme_id, 20);
+
+  zones.clear();
+  index.Sync(zones);
+  EXPECT_FALSE(index.Resolve({150, 50}).has_value());
+}
+
+TEST(ParallaxLayoutTest, ZoneIndexFindsZonesById) {
+  std::vector<ParallaxZone> zones{
+      {.id = 4, .name = "first"},
+      {.id = 9, .name = "second"},
+      {.id = 4, .name = "duplicate"},
+  };
+  ParallaxZoneIndex index;
+  index.Sync(zones);
+
+  EXPECT_EQ(index.Find(zones, 9), &zones[1]);
+  EXPECT_EQ(index.Find(zones, 4), FindParallaxZoneById(zones, 4));
+  EXPECT_EQ(index.Find(zones, 5), nullptr);
+
+  // Edited since the last sync: the answer is still right.
+  zones.erase(zones.begin());
+  EXPECT_EQ(index.Find(zones, 9), &zones[0]);
+  EXPECT_EQ(index.Find(zones, 4), &zones[1]);
+}
+
+TEST(ParallaxLayoutTest, LayoutCacheKeepsGeometryUntilThemeOrTextureChanges) {
+  const TextureHandle texture = TextureHandleAccess::Create(1, nullptr);
+  const TextureHandle replacement = TextureHandleAccess::Create(2, nullptr);
+  ParallaxTheme theme{.id = 3, .layers = {{.texture_id = "sky"}, {.texture_id = "hills"}}};
+  const ParallaxLayerGeometry geometry{.tile_width = 64, .tile_height = 32};
+
+  ParallaxLayoutCache cache;
+  cache.Sync(theme, std::nullopt);
+  EXPECT_EQ(cache.Find(1, texture), nullptr);
+  cache.Store(1, texture, geometry);
+  ASSERT_NE(cache.Find(1, texture), nullptr);
+  EXPECT_DOUBLE_EQ(cache.Find(1, texture)->tile_width, 64);
+  EXPECT_EQ(cache.Find(0, texture), nullptr);
+  EXPECT_EQ(cache.Find(1, replacement), nullptr);
+
+  cache.Sync(theme, std::nullopt);
+  EXPECT_NE(cache.Find(1, texture), nullptr);
+
+  cache.Sync(theme, 1);
+  EXPECT_EQ(cache.Find(1, texture), nullptr);
+
+  cache.Store(0, texture, geometry);
+  theme.layers[1].base_scale = 2;
+  cache.Sync(theme, 1);
+  EXPECT_EQ(cache.Find(0, texture), nullptr);
+}
+
 }  // namespace
 }  // namespace zebes
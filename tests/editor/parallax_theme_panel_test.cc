@@ -18,8 +18,8 @@ namespace zebes {
 class ParallaxThemePanelTestPeer {
  public:
   static absl::Status RenderNavigator(ParallaxThemePanel& panel, Level& level,
-                                      SelectionState& selection) {
-    return panel.RenderNavigator(level, selection);
+                                      SelectionState& selection, bool editable) {
+    return panel.RenderNavigator(level, selection, editable);
   }
 
   static absl::Status RenderThemeDetails(ParallaxThemePanel& panel, Level& level,
@@ -95,8 +95,8 @@ class ParallaxThemePanelTest : public Test {
     EXPECT_CALL(gui_, Button(_, _)).WillRepeatedly(Return(false));
   }
 
-  absl::Status RenderNavigator() {
-    return ParallaxThemePanelTestPeer::RenderNavigator(*panel_, level_, selection_);
+  absl::Status RenderNavigator(bool editable = true) {
+    return ParallaxThemePanelTestPeer::RenderNavigator(*panel_, level_, selection_, editable);
   }
 
   absl::Status RenderThemeDetails() {
@@ -128,6 +128,17 @@ TEST_F(ParallaxThemePanelTest, AddThemeUpdatesLevelAndSelection) {
   EXPECT_TRUE(level_.themes.contains(0));
 }
 
+TEST_F(ParallaxThemePanelTest, AddThemeIsDisabledWhileTheLevelIsNotEditable) {
+  EXPECT_CALL(gui_, CreateScopedDisabled(true)).Times(1);
+  // A disabled button never reports a click; the panel must not trust it to.
+  EXPECT_CALL(gui_, Button(StrEq("Add Theme"), _)).WillOnce(Return(true));
+
+  ASSERT_OK(RenderNavigator(/*editable=*/false));
+
+  EXPECT_TRUE(level_.themes.empty());
+  EXPECT_EQ(selection_.type, SelectionState::Type::kNone);
+}
+
 TEST_F(ParallaxThemePanelTest, AddLayerUpdatesThemeAndSelection) {
   level_.themes[1] = ParallaxTheme{.name = "Theme 1"};
   selection_.type = SelectionState::Type::kTheme;
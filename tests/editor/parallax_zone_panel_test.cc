@@ -16,8 +16,8 @@ namespace zebes {
 class ParallaxZonePanelTestPeer {
  public:
   static absl::Status RenderNavigator(ParallaxZonePanel& panel, Level& level,
-                                      SelectionState& selection) {
-    return panel.RenderNavigator(level, selection);
+                                      SelectionState& selection, bool editable) {
+    return panel.RenderNavigator(level, selection, editable);
   }
 
   static absl::Status RenderDetails(ParallaxZonePanel& panel, Level& level,
@@ -82,8 +82,8 @@ class ParallaxZonePanelTest : public ::testing::Test {
             }));
   }
 
-  absl::Status RenderNavigator() {
-    return ParallaxZonePanelTestPeer::RenderNavigator(*panel_, level_, selection_);
+  absl::Status RenderNavigator(bool editable = true) {
+    return ParallaxZonePanelTestPeer::RenderNavigator(*panel_, level_, selection_, editable);
   }
 
   absl::Status RenderDetails() {
@@ -132,6 +132,19 @@ TEST_F(ParallaxZonePanelTest, CreateZoneIsDisabledForLevelWithoutPositiveDimensi
   EXPECT_EQ(selection_.type, SelectionState::Type::kNone);
 }
 
+TEST_F(ParallaxZonePanelTest, CreateZoneIsDisabledWhileTheLevelIsNotEditable) {
+  level_.width = 1024.0;
+  level_.height = 512.0;
+
+  EXPECT_CALL(gui_, BeginDisabled(true)).Times(1);
+  EXPECT_CALL(gui_, Button(StrEq("Add Zone"), _)).WillOnce(Return(true));
+
+  ASSERT_OK(RenderNavigator(/*editable=*/false));
+
+  EXPECT_TRUE(level_.zones.empty());
+  EXPECT_EQ(selection_.type, SelectionState::Type::kNone);
+}
+
 TEST_F(ParallaxZonePanelTest, DeleteZoneRemovesFromLevel) {
   level_.zones.push_back({});
   selection_.type = SelectionState::Type::kZone;
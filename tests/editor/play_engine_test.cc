@@ -0,0 +1,173 @@
+#include "editor/level_editor/play_engine.h"
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "common/engine.h"
+#include "editor/level_editor/play_session.h"
+#include "gtest/gtest.h"
+#include "macros.h"
+
+namespace zebes {
+namespace {
+
+// Long enough that a loaded machine cannot fail a passing test, short enough
+// that a genuine hang still ends the run.
+constexpr absl::Duration kSnapshotTimeout = absl::Seconds(10);
+
+Entity MakeEntity(uint64_t id, Vec position, bool is_static = false) {
+  return Entity{
+      .id = id,
+      .transform = {.position = position},
+      .body = {.mass = 1, .is_static = is_static},
+  };
+}
+
+Level FallingLevel() {
+  Level level;
+  EXPECT_OK(level.AddEntity(0, MakeEntity(7, {.x = 10, .y = 0})));
+  EXPECT_OK(level.AddEntity(0, MakeEntity(9, {.x = 50, .y = 0}, /*is_static=*/true)));
+  return level;
+}
+
+// A test owns the clock, so the engine runs on the test's thread and never
+// waits for real time to pass.
+class PlayEngineTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_OK_AND_ASSIGN(
+        engine_,
+        PlayEngine::Create(FallingLevel(),
+                           {.world = {.timestep = absl::Seconds(1), .max_steps_per_advance = 4},
+                            .gravity = {.x = 0, .y = 2},
+                            .clock = [this] { return now_; }}));
+  }
+
+  RunResult RunOnce() {
+    absl::StatusOr<RunResult> result = engine_->Run();
+    EXPECT_OK(result.status());
+    return result.ok() ? *result : RunResult{};
+  }
+
+  int64_t SnapshotStep() {
+    SnapshotExchange<PlaySnapshot>::Read snapshot = engine_->AcquireSnapshot();
+    return snapshot ? snapshot->step : -1;
+  }
+
+  absl::Time now_ = absl::UnixEpoch();
+  std::unique_ptr<PlayEngine> engine_;
+};
+
+TEST_F(PlayEngineTest, FirstPassPublishesTheAuthoredState) {
+  EXPECT_FALSE(engine_->AcquireSnapshot());
+
+  const RunResult result = RunOnce();
+
+  SnapshotExchange<PlaySnapshot>::Read snapshot = engine_->AcquireSnapshot();
+  ASSERT_TRUE(snapshot);
+  EXPECT_EQ(snapshot->step, 0);
+  EXPECT_FALSE(snapshot->paused);
+  ASSERT_EQ(engine_->IndexOf(9), std::optional<size_t>(1));
+  EXPECT_EQ(snapshot->positions[*engine_->IndexOf(7)], (Vec{.x = 10, .y = 0}));
+  EXPECT_EQ(result.feedback, RunFeedback::kIdle);
+  EXPECT_EQ(result.wake_deadline, std::optional<absl::Time>(now_ + absl::Seconds(1)));
+}
+
+TEST_F(PlayEngineTest, StepsAsTheClockAdvancesAndWakesForTheNextStep) {
+  RunOnce();
+  now_ += absl::Milliseconds(2500);
+
+  const RunResult result = RunOnce();
+
+  SnapshotExchange<PlaySnapshot>::Read snapshot = engine_->AcquireSnapshot();
+  ASSERT_TRUE(snapshot);
+  EXPECT_EQ(snapshot->step, 2);
+  // Gravity on the dynamic body only: 2 then 4.
+  EXPECT_EQ(snapshot->positions[*engine_->IndexOf(7)], (Vec{.x = 10, .y = 6}));
+  EXPECT_EQ(snapshot->positions[*engine_->IndexOf(9)], (Vec{.x = 50, .y = 0}));
+  // Half a step is banked, so the next one is due in the other half.
+  EXPECT_EQ(result.wake_deadline, std::optional<absl::Time>(now_ + absl::Milliseconds(500)));
+}
+
+TEST_F(PlayEngineTest, PauseSleepsUntilCommandedAndDoesNotOweThePause) {
+  RunOnce();
+  ASSERT_OK(engine_->Pause());
+
+  now_ += absl::Seconds(3);
+  RunResult result = RunOnce();
+  EXPECT_EQ(result.wake_deadline, std::nullopt);
+  EXPECT_EQ(SnapshotStep(), 0);
+  EXPECT_TRUE(engine_->AcquireSnapshot()->paused);
+
+  ASSERT_OK(engine_->StepOnce());
+  RunOnce();
+  EXPECT_EQ(SnapshotStep(), 1);
+
+  ASSERT_OK(engine_->Resume());
+  result = RunOnce();
+  EXPECT_EQ(SnapshotStep(), 1);
+  EXPECT_FALSE(engine_->AcquireSnapshot()->paused);
+  EXPECT_EQ(result.wake_deadline, std::optional<absl::Time>(now_ + absl::Seconds(1)));
+
+  now_ += absl::Seconds(1);
+  RunOnce();
+  EXPECT_EQ(SnapshotStep(), 2);
+}
+
+TEST_F(PlayEngineTest, StepOnceIsIgnoredWhileRunning) {
+  RunOnce();
+  ASSERT_OK(engine_->StepOnce());
+  RunOnce();
+  EXPECT_EQ(SnapshotStep(), 0);
+}
+
+TEST_F(PlayEngineTest, SnapshotHeldByTheViewportIsNeverOverwritten) {
+  RunOnce();
+  SnapshotExchange<PlaySnapshot>::Read held = engine_->AcquireSnapshot();
+
+  now_ += absl::Seconds(1);
+  RunOnce();
+  now_ += absl::Seconds(1);
+  RunOnce();
+  EXPECT_EQ(held->step, 0);
+
+  // Step 2 was declined; released, the engine publishes it on its next pass
+  // even though no step is due.
+  held = SnapshotExchange<PlaySnapshot>::Read();
+  EXPECT_EQ(SnapshotStep(), 1);
+  RunOnce();
+  EXPECT_EQ(SnapshotStep(), 2);
+}
+
+TEST_F(PlayEngineTest, RejectsAnInvalidWorld) {
+  EXPECT_FALSE(PlayEngine::Create(FallingLevel(), {.world = {.timestep = absl::ZeroDuration()}})
+                   .ok());
+}
+
+TEST(PlaySessionTest, StepsOnItsOwnThreadWithoutAWindow) {
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<PlaySession> session,
+                       PlaySession::Create(FallingLevel(),
+                                           {.world = {.timestep = absl::Milliseconds(1)},
+                                            .gravity = {.x = 0, .y = 2}}));
+
+  const absl::Time deadline = absl::Now() + kSnapshotTimeout;
+  int64_t step = -1;
+  while (step < 3 && absl::Now() < deadline) {
+    {
+      SnapshotExchange<PlaySnapshot>::Read snapshot = session->engine().AcquireSnapshot();
+      if (snapshot) step = snapshot->step;
+    }
+    absl::SleepFor(absl::Milliseconds(1));
+  }
+  EXPECT_GE(step, 3);
+
+  ASSERT_OK(session->engine().Pause());
+  // Destruction stops and joins the engine thread.
+  session.reset();
+}
+
+}  // namespace
+}  // namespace zebes
@@ -0,0 +1,365 @@
+#include "editor/level_editor/session_replay.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <variant>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "editor/level_editor/session_recording.h"
+#include "editor/level_editor/viewport_model.h"
+#include "gtest/gtest.h"
+#include "macros.h"
+
+namespace zebes {
+namespace {
+
+constexpr int kTile = 5;
+
+Level MakeLevel() {
+  return Level{
+      .id = "level-1",
+      .tile_render_width = 16,
+      .tile_render_height = 16,
+      .width = 160,
+      .height = 160,
+  };
+}
+
+class FakeAssets : public SessionReplayAssets {
+ public:
+  FakeAssets() { blueprints_["crate"] = Blueprint{.id = "crate", .states = {{.name = "Idle"}}}; }
+
+  absl::StatusOr<const Tileset*> GetTileset(const std::string& id) override {
+    return absl::NotFoundError(id);
+  }
+  absl::StatusOr<const Blueprint*> GetBlueprint(const std::string& id) override {
+    const auto it = blueprints_.find(id);
+    if (it == blueprints_.end()) return absl::NotFoundError(id);
+    return &it->second;
+  }
+  absl::StatusOr<const Sprite*> GetSprite(const std::string& id) override {
+    return absl::NotFoundError(id);
+  }
+
+ private:
+  absl::flat_hash_map<std::string, Blueprint> blueprints_;
+};
+
+RecordedViewportCommand Paint(Vec position, bool pressed = false) {
+  return {
+      .layer_id = 0,
+      .input = {.world_position = position,
+                .pointer_in_level = true,
+                .primary_pressed = pressed,
+                .primary_down = true},
+      .paint_tile_id = kTile,
+  };
+}
+
+RecordedViewportCommand Hover(Vec position) {
+  return {
+      .layer_id = 0,
+      .input = {.world_position = position, .pointer_in_level = true},
+      .paint_tile_id = kTile,
+  };
+}
+
+RecordedViewportCommand Place(Vec position) {
+  return {
+      .layer_id = 0,
+      .input = {.world_position = position,
+                .pointer_in_level = true,
+                .primary_pressed = true,
+                .primary_down = true},
+      .placement_blueprint_id = "crate",
+  };
+}
+
+// A stroke across three cells of the top row over three frames, released on
+// the fourth, then a crate, then the stroke undone and redone.
+SessionRecording RecordSession() {
+  const Level level = MakeLevel();
+  SessionRecorder recorder;
+  InputSnapshot idle;
+
+  recorder.BeginFrame(idle);
+  recorder.RecordViewport(level, Hover({8, 8}));
+  recorder.BeginFrame(idle);
+  recorder.RecordViewport(level, Paint({8, 8}, /*pressed=*/true));
+  recorder.BeginFrame(idle);
+  recorder.RecordViewport(level, Paint({24, 8}));
+  recorder.BeginFrame(idle);
+  recorder.RecordViewport(level, Paint({40, 8}));
+  recorder.BeginFrame(idle);
+  recorder.RecordViewport(level, Hover({40, 8}));
+  recorder.BeginFrame(idle);
+  recorder.RecordViewport(level, Place({80, 80}));
+  recorder.BeginFrame(idle);
+  recorder.RecordUndo(level);
+  recorder.BeginFrame(idle);
+  recorder.RecordUndo(level);
+  recorder.BeginFrame(idle);
+  recorder.RecordRedo(level);
+  for (int i = 0; i < 3; ++i) recorder.BeginFrame(idle);
+  return recorder.recording();
+}
+
+absl::StatusOr<std::unique_ptr<SessionReplayer>> MakeReplayer(const SessionRecording& recording,
+                                                              FakeAssets& assets,
+                                                              SessionReplayOptions options = {}) {
+  return SessionReplayer::Create(MakeLevel(), recording, assets, options);
+}
+
+TEST(SessionRecorderTest, StoresOnlyChangedInputAndTheFrameThatEndsAGesture) {
+  const Level level = MakeLevel();
+  SessionRecorder recorder;
+  InputSnapshot jumping;
+  jumping.SetKeyDown(Key::kSpace);
+
+  recorder.BeginFrame(InputSnapshot());
+  recorder.RecordViewport(level, Hover({8, 8}));
+  recorder.BeginFrame(InputSnapshot());
+  recorder.RecordViewport(level, Paint({8, 8}, /*pressed=*/true));
+  recorder.BeginFrame(jumping);
+  recorder.RecordViewport(level, Hover({8, 8}));
+  recorder.BeginFrame(jumping);
+  recorder.RecordViewport(level, Hover({24, 8}));
+
+  const SessionRecording& recording = recorder.recording();
+  EXPECT_EQ(recording.level_id, "level-1");
+  EXPECT_EQ(recording.frame_count, 4);
+  ASSERT_EQ(recording.frames.size(), 3u);
+
+  EXPECT_EQ(recording.frames[0].frame, 0);
+  EXPECT_TRUE(recording.frames[0].input.has_value());
+  EXPECT_TRUE(recording.frames[0].commands.empty());
+
+  EXPECT_EQ(recording.frames[1].frame, 1);
+  EXPECT_FALSE(recording.frames[1].input.has_value());
+  EXPECT_EQ(recording.frames[1].commands.size(), 1u);
+
+  // The release is kept; the hover after it is not.
+  EXPECT_EQ(recording.frames[2].frame, 2);
+  ASSERT_TRUE(recording.frames[2].input.has_value());
+  EXPECT_TRUE(recording.frames[2].input->IsKeyDown(Key::kSpace));
+  EXPECT_EQ(recording.frames[2].commands.size(), 1u);
+}
+
+TEST(SessionRecorderTest, DropsCommandsOnAnotherLevel) {
+  Level other = MakeLevel();
+  other.id = "level-2";
+  SessionRecorder recorder;
+
+  recorder.BeginFrame(InputSnapshot());
+  recorder.RecordUndo(MakeLevel());
+  recorder.RecordUndo(other);
+
+  EXPECT_EQ(recorder.recording().level_id, "level-1");
+  EXPECT_EQ(recorder.recording().frames.front().commands.size(), 1u);
+  EXPECT_EQ(recorder.dropped_commands(), 1);
+}
+
+TEST(SessionRecorderTest, KeepsTheFirstUnrecordedEditOnTheRecordingsLevel) {
+  Level other = MakeLevel();
+  other.id = "level-2";
+  SessionRecorder recorder;
+
+  // Before the recording begins, an edit is part of where it starts.
+  recorder.BeginFrame(InputSnapshot());
+  recorder.RecordUnrecordedEdit(MakeLevel());
+  recorder.RecordUndo(MakeLevel());
+  recorder.BeginFrame(InputSnapshot());
+  recorder.RecordUnrecordedEdit(other);
+  EXPECT_FALSE(recorder.recording().unrecorded_edit_frame.has_value());
+
+  recorder.BeginFrame(InputSnapshot());
+  recorder.RecordUnrecordedEdit(MakeLevel());
+  recorder.BeginFrame(InputSnapshot());
+  recorder.RecordUnrecordedEdit(MakeLevel());
+  EXPECT_EQ(recorder.recording().unrecorded_edit_frame, 2);
+}
+
+TEST(SessionReplayerTest, StopsBeforeTheFirstUnrecordedEdit) {
+  SessionRecording recording = RecordSession();
+  // Frame 6 is the first undo, of the crate.
+  recording.unrecorded_edit_frame = 6;
+  FakeAssets assets;
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<SessionReplayer> replayer,
+                       MakeReplayer(recording, assets, {.hash_interval = 4}));
+
+  ASSERT_OK_AND_ASSIGN(const SessionReplayReport report, replayer->Run());
+
+  ASSERT_EQ(report.frames.size(), 6u);
+  EXPECT_EQ(replayer->level().layers.front().entities.size(), 1u);
+  ASSERT_EQ(report.checkpoints.size(), 2u);
+  EXPECT_EQ(report.checkpoints.back().frame, 5);
+}
+
+TEST(SessionReplayerTest, ReplaysStrokesPlacementAndHistory) {
+  FakeAssets assets;
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<SessionReplayer> replayer,
+                       MakeReplayer(RecordSession(), assets));
+
+  ASSERT_OK_AND_ASSIGN(const SessionReplayReport report, replayer->Run());
+
+  // Undoing the crate and then the stroke, and redoing the stroke, leaves the
+  // stroke without the crate.
+  const WorldLayer& layer = replayer->level().layers.front();
+  for (int x = 0; x < 3; ++x) EXPECT_EQ(GetTileAt(layer, x, 0).value(), kTile) << x;
+  EXPECT_EQ(GetTileAt(layer, 3, 0).value(), 0);
+  EXPECT_TRUE(layer.entities.empty());
+
+  ASSERT_EQ(report.frames.size(), 12u);
+  EXPECT_EQ(report.frames[1].commands, 1u);
+  EXPECT_EQ(report.frames[11].commands, 0u);
+}
+
+TEST(SessionReplayerTest, CheckpointsAreDeterministicAndTrackTheLevel) {
+  FakeAssets assets;
+  const SessionRecording recording = RecordSession();
+
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<SessionReplayer> first,
+                       MakeReplayer(recording, assets, {.hash_interval = 4}));
+  ASSERT_OK_AND_ASSIGN(const SessionReplayReport a, first->Run());
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<SessionReplayer> second,
+                       MakeReplayer(recording, assets, {.hash_interval = 4}));
+  ASSERT_OK_AND_ASSIGN(const SessionReplayReport b, second->Run());
+
+  // Frames 3, 7 and 11, the last of which is also the end.
+  ASSERT_EQ(a.checkpoints.size(), 3u);
+  EXPECT_EQ(a.checkpoints[0].frame, 3);
+  EXPECT_EQ(a.checkpoints[2].frame, 11);
+  for (size_t i = 0; i < a.checkpoints.size(); ++i) {
+    EXPECT_EQ(a.checkpoints[i].hash, b.checkpoints[i].hash);
+  }
+  EXPECT_EQ(a.checkpoints.back().hash, LevelStateHash(first->level()));
+  EXPECT_NE(a.checkpoints.back().hash, LevelStateHash(MakeLevel()));
+}
+
+TEST(SessionReplayerTest, HashIgnoresChunkHistory) {
+  Level painted = MakeLevel();
+  Level erased = MakeLevel();
+  ASSERT_OK(SetTileAt(erased.layers.front(), 100, 100, kTile));
+  ASSERT_OK(SetTileAt(erased.layers.front(), 100, 100, 0));
+
+  EXPECT_EQ(LevelStateHash(painted), LevelStateHash(erased));
+  ASSERT_OK(SetTileAt(painted.layers.front(), 1, 1, kTile));
+  EXPECT_NE(LevelStateHash(painted), LevelStateHash(erased));
+}
+
+TEST(SessionReplayerTest, FeedsRecordedInputToTheInputManager) {
+  SessionRecorder recorder;
+  InputSnapshot jumping;
+  jumping.SetKeyDown(Key::kSpace);
+  recorder.BeginFrame(InputSnapshot());
+  recorder.BeginFrame(jumping);
+  recorder.BeginFrame(jumping);
+  recorder.BeginFrame(InputSnapshot());
+
+  FakeAssets assets;
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<SessionReplayer> replayer,
+                       MakeReplayer(recorder.recording(), assets));
+  replayer->input().BindAction("jump", Key::kSpace);
+
+  std::vector<bool> active;
+  std::vector<bool> just_pressed;
+  while (true) {
+    ASSERT_OK_AND_ASSIGN(const bool stepped, replayer->Step());
+    if (!stepped) break;
+    active.push_back(replayer->input().IsActionActive("jump"));
+    just_pressed.push_back(replayer->input().IsActionJustPressed("jump"));
+  }
+  EXPECT_EQ(active, (std::vector<bool>{false, true, true, false}));
+  EXPECT_EQ(just_pressed, (std::vector<bool>{false, true, false, false}));
+}
+
+TEST(SessionReplayerTest, RefusesARecordingOfAnotherLevel) {
+  SessionRecording recording = RecordSession();
+  recording.level_id = "level-2";
+  FakeAssets assets;
+  EXPECT_EQ(MakeReplayer(recording, assets).status().code(),
+            absl::StatusCode::kInvalidArgument);
+}
+
+TEST(SessionReplayerTest, RefusesALevelEditedSinceRecordingBegan) {
+  const SessionRecording recording = RecordSession();
+  ASSERT_TRUE(recording.initial_hash.has_value());
+  Level saved = MakeLevel();
+  ASSERT_OK(SetTileAt(saved.layers.front(), 0, 0, kTile));
+  FakeAssets assets;
+
+  EXPECT_EQ(SessionReplayer::Create(saved, recording, assets).status().code(),
+            absl::StatusCode::kFailedPrecondition);
+}
+
+TEST(SessionRecordingFileTest, RoundTripsThroughJson) {
+  const SessionRecording recording = RecordSession();
+  const std::string path =
+      (std::filesystem::temp_directory_path() /
+       absl::StrCat("session_replay_test_", ::testing::UnitTest::GetInstance()->random_seed(),
+                    ".json"))
+          .string();
+
+  ASSERT_OK(WriteSessionRecording(recording, path));
+  ASSERT_OK_AND_ASSIGN(const SessionRecording read, ReadSessionRecording(path));
+  std::filesystem::remove(path);
+
+  EXPECT_EQ(read.level_id, recording.level_id);
+  EXPECT_EQ(read.initial_hash, recording.initial_hash);
+  EXPECT_EQ(read.unrecorded_edit_frame, recording.unrecorded_edit_frame);
+  EXPECT_EQ(read.frame_count, recording.frame_count);
+  ASSERT_EQ(read.frames.size(), recording.frames.size());
+  for (size_t i = 0; i < read.frames.size(); ++i) {
+    EXPECT_EQ(read.frames[i].frame, recording.frames[i].frame);
+    EXPECT_EQ(read.frames[i].input.has_value(), recording.frames[i].input.has_value());
+    EXPECT_EQ(read.frames[i].commands.size(), recording.frames[i].commands.size());
+  }
+  const auto& place = std::get<RecordedViewportCommand>(read.frames[5].commands.front());
+  EXPECT_EQ(place.placement_blueprint_id, "crate");
+  EXPECT_EQ(place.input.world_position, (Vec{80, 80}));
+  EXPECT_TRUE(place.input.primary_pressed);
+  EXPECT_FALSE(place.paint_tile_id.has_value());
+
+  // What matters is that it replays the same.
+  FakeAssets assets;
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<SessionReplayer> original, MakeReplayer(recording, assets));
+  ASSERT_OK(original->Run().status());
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<SessionReplayer> reloaded, MakeReplayer(read, assets));
+  ASSERT_OK(reloaded->Run().status());
+  EXPECT_EQ(reloaded->level(), original->level());
+}
+
+TEST(SessionRecordingFileTest, RefusesAnotherVersion) {
+  const std::string path =
+      (std::filesystem::temp_directory_path() / "session_replay_test_version.json").string();
+  {
+    std::ofstream file(path);
+    file << R"({"version": 99, "level_id": "", "frame_count": 0, "frames": []})";
+  }
+  EXPECT_EQ(ReadSessionRecording(path).status().code(), absl::StatusCode::kInvalidArgument);
+  std::filesystem::remove(path);
+}
+
+TEST(SessionRecordingFileTest, RefusesAFrameMissingAField) {
+  const std::string path =
+      (std::filesystem::temp_directory_path() / "session_replay_test_missing.json").string();
+  // Frame 0 leaves out its input rather than writing null.
+  {
+    std::ofstream file(path);
+    file << R"({"version": 2, "level_id": "level-1", "initial_hash": null,)"
+         << R"( "unrecorded_edit_frame": null, "frame_count": 1,)"
+         << R"( "frames": [{"frame": 0, "commands": []}]})";
+  }
+  EXPECT_EQ(ReadSessionRecording(path).status().code(), absl::StatusCode::kInvalidArgument);
+  std::filesystem::remove(path);
+}
+
+}  // namespace
+}  // namespace zebes
@@ -1,7 +1,12 @@
 #include "editor/level_editor/terrain_brush.h"
 
+#include <cstdlib>
+#include <map>
 #include <set>
+#include <utility>
+#include <vector>
 
+#include "absl/container/flat_hash_set.h"
 #include "editor/level_editor/viewport_model.h"
 #include "gtest/gtest.h"
 #include "macros.h"
@@ -692,6 +697,176 @@ TEST_F(TerrainMemberTest, ARefreshHandsACellBackTheGeometryItAlreadyHad) {
             TileShape::kSlope45FloorTallRight);
 }
 
+// --- Region painting ---------------------------------------------------------
+
+// Counts what a region operation asks of the provider it wraps.
+class CountingProvider : public TerrainTileProvider {
+ public:
+  explicit CountingProvider(TerrainTileProvider& inner) : inner_(inner) {}
+
+  absl::StatusOr<int> TileForKey(const Terrain& terrain, const TerrainCellKey& key, int tile_x,
+                                 int tile_y) override {
+    ++resolved_[{tile_x, tile_y}];
+    return inner_.TileForKey(terrain, key, tile_x, tile_y);
+  }
+
+  absl::StatusOr<TerrainPreview> PreviewForKey(const Terrain& terrain, const TerrainCellKey& key,
+                                               int tile_x, int tile_y) override {
+    return inner_.PreviewForKey(terrain, key, tile_x, tile_y);
+  }
+
+  absl::Status PrepareKeys(const Terrain& terrain,
+                           absl::Span<const TerrainCellKey> keys) override {
+    prepared_.insert(prepared_.end(), keys.begin(), keys.end());
+    return absl::OkStatus();
+  }
+
+  std::map<std::pair<int, int>, int> resolved_;
+  std::vector<TerrainCellKey> prepared_;
+
+ private:
+  TerrainTileProvider& inner_;
+};
+
+// Every cell's tile, for comparing two layers wholesale.
+std::map<std::pair<int, int>, int> Tiles(const Level& level) {
+  std::map<std::pair<int, int>, int> tiles;
+  const int wide = level.width / kTileSize;
+  const int high = level.height / kTileSize;
+  for (int y = 0; y < high; ++y) {
+    for (int x = 0; x < wide; ++x) {
+      const int tile = GetTileAt(level.layers.front(), x, y).value();
+      if (tile != 0) tiles[{x, y}] = tile;
+    }
+  }
+  return tiles;
+}
+
+TEST_F(TerrainBrushTest, ARegionPaintsWhatPaintingCellByCellWould) {
+  Build();
+  const std::vector<TileCoordinate> block = RectangleCells({.x = 2, .y = 3}, {.x = 6, .y = 5});
+  for (const TileCoordinate& cell : block) Paint(cell.x, cell.y);
+  const std::map<std::pair<int, int>, int> sequential = Tiles(level_);
+
+  Level region = MakeLevel();
+  ASSERT_OK(PaintTerrainRegion(region, region.layers.front(), index_, *provider_, kTerrainId,
+                               TileShape::kFullBlock, block));
+
+  EXPECT_EQ(Tiles(region), sequential);
+}
+
+TEST_F(TerrainBrushTest, ARegionResolvesEachAffectedCellOnce) {
+  Build();
+  Paint(1, 1);  // Frontier: touches the block's corner diagonally.
+  CountingProvider counting(*provider_);
+
+  const std::vector<TileCoordinate> block = RectangleCells({.x = 2, .y = 2}, {.x = 6, .y = 6});
+  ASSERT_OK(PaintTerrainRegion(level_, level_.layers.front(), index_, counting, kTerrainId,
+                               TileShape::kFullBlock, block));
+
+  EXPECT_EQ(counting.resolved_.size(), 26u);
+  for (const auto& [cell, count] : counting.resolved_) {
+    EXPECT_EQ(count, 1) << cell.first << "," << cell.second;
+  }
+  // Twenty-six cells, but only ten neighbourhoods: four corners, four edges,
+  // the interior, and the frontier cell.
+  const absl::flat_hash_set<TerrainCellKey> distinct(counting.prepared_.begin(),
+                                                     counting.prepared_.end());
+  EXPECT_EQ(distinct.size(), counting.prepared_.size());
+  EXPECT_EQ(counting.prepared_.size(), 10u);
+}
+
+TEST_F(TerrainBrushTest, ARegionIgnoresDuplicateAndUnorderedCells) {
+  Build();
+  ASSERT_OK(PaintTerrainRegion(level_, level_.layers.front(), index_, *provider_, kTerrainId,
+                               TileShape::kFullBlock,
+                               {{.x = 5, .y = 4}, {.x = 4, .y = 4}, {.x = 5, .y = 4}}));
+
+  EXPECT_EQ(MaskAt(level_, 4, 4), kEast);
+  EXPECT_EQ(MaskAt(level_, 5, 4), kWest);
+}
+
+TEST_F(TerrainBrushTest, ErasingARegionMatchesErasingCellByCell) {
+  Build();
+  for (const TileCoordinate& cell : RectangleCells({.x = 1, .y = 1}, {.x = 6, .y = 6})) {
+    Paint(cell.x, cell.y);
+  }
+  Level sequential = level_;
+  const std::vector<TileCoordinate> hole = RectangleCells({.x = 3, .y = 2}, {.x = 4, .y = 5});
+  for (const TileCoordinate& cell : hole) {
+    ASSERT_OK(EraseTerrain(sequential, sequential.layers.front(), index_, *provider_, cell.x,
+                           cell.y));
+  }
+
+  ASSERT_OK(EraseTerrainRegion(level_, level_.layers.front(), index_, *provider_, hole));
+
+  EXPECT_EQ(Tiles(level_), Tiles(sequential));
+  EXPECT_EQ(GetTileAt(level_.layers.front(), 3, 3).value(), 0);
+}
+
+TEST_F(TerrainBrushTest, ARegionWithAnUnknownTerrainWritesNothing) {
+  Build();
+  absl::Status status = PaintTerrainRegion(level_, level_.layers.front(), index_, *provider_, 999,
+                                           TileShape::kFullBlock, {{.x = 1, .y = 1}});
+  EXPECT_EQ(status.code(), absl::StatusCode::kNotFound);
+  EXPECT_TRUE(Tiles(level_).empty());
+}
+
+TEST_F(TerrainBrushTest, ARegionWithANegativeCellWritesNothing) {
+  Build();
+  absl::Status status =
+      PaintTerrainRegion(level_, level_.layers.front(), index_, *provider_, kTerrainId,
+                         TileShape::kFullBlock, {{.x = 1, .y = 1}, {.x = -1, .y = 1}});
+  EXPECT_FALSE(status.ok());
+  EXPECT_TRUE(Tiles(level_).empty());
+}
+
+TEST(RegionCellsTest, ARectangleCoversBothCornersInEitherOrder) {
+  const std::vector<TileCoordinate> cells = RectangleCells({.x = 3, .y = 2}, {.x = 1, .y = 1});
+  ASSERT_EQ(cells.size(), 6u);
+  std::set<std::pair<int, int>> seen;
+  for (const TileCoordinate& cell : cells) seen.insert({cell.x, cell.y});
+  EXPECT_TRUE(seen.contains({1, 1}));
+  EXPECT_TRUE(seen.contains({3, 2}));
+}
+
+TEST(RegionCellsTest, AStrokeHasNoGaps) {
+  const std::vector<TileCoordinate> cells = StrokeCells({.x = 0, .y = 0}, {.x = 7, .y = 3});
+  ASSERT_EQ(cells.size(), 8u);
+  EXPECT_EQ(cells.front().x, 0);
+  EXPECT_EQ(cells.back().x, 7);
+  EXPECT_EQ(cells.back().y, 3);
+  for (size_t i = 1; i < cells.size(); ++i) {
+    EXPECT_LE(std::abs(cells[i].x - cells[i - 1].x), 1);
+    EXPECT_LE(std::abs(cells[i].y - cells[i - 1].y), 1);
+  }
+}
+
+TEST(RegionCellsTest, AStrokeOfOneCellIsThatCell) {
+  const std::vector<TileCoordinate> cells = StrokeCells({.x = 4, .y = 4}, {.x = 4, .y = 4});
+  ASSERT_EQ(cells.size(), 1u);
+  EXPECT_EQ(cells.front().x, 4);
+}
+
+TEST_F(TerrainBrushTest, AFloodFillStopsAtADifferentTile) {
+  Build();
+  // A wall across the level at x == 3 leaves three columns on the left.
+  for (int y = 0; y < 16; ++y) Paint(3, y);
+
+  absl::StatusOr<std::vector<TileCoordinate>> cells =
+      FloodFillCells(level_, level_.layers.front(), {.x = 0, .y = 0});
+
+  ASSERT_OK(cells);
+  EXPECT_EQ(cells->size(), 3u * 16u);
+}
+
+TEST_F(TerrainBrushTest, AFloodFillMustStartInsideTheLevel) {
+  Build();
+  absl::StatusOr<std::vector<TileCoordinate>> cells =
+      FloodFillCells(level_, level_.layers.front(), {.x = 16, .y = 0});
+  EXPECT_FALSE(cells.ok());
+}
+
 TEST(TerrainIndexTest, RejectsTwoTilesClaimingOneShape) {
   // Which tile a slope cell resolves to would otherwise depend on the order of
   // shape_tile_ids.
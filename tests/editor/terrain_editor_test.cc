@@ -2,6 +2,7 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "absl/status/status.h"
 #include "gmock/gmock.h"
@@ -32,6 +33,10 @@ class TerrainEditorTestPeer {
         pending != nullptr) {
       return pending->work.Wait();
     }
+    if (auto* pending = std::get_if<TerrainEditor::PendingLevelRebake>(&editor.pending_work_);
+        pending != nullptr) {
+      return pending->work.Wait();
+    }
     return absl::FailedPreconditionError("No terrain work is pending");
   }
   static void DeleteTerrain(TerrainEditor& editor) { editor.DeleteTerrain(); }
@@ -200,5 +205,71 @@ TEST_F(TerrainEditorTest, RegeneratedArtworkAlsoCommitsOnlyWhenPolled) {
   EXPECT_THAT(model().status(), HasSubstr("Regenerated 'meadow'"));
 }
 
+TEST_F(TerrainEditorTest, RegenerationRebakesTheLevelsUsingTheTileset) {
+  TerrainGenConfig config;
+  config.tile_size = 8;
+  config.supersample = 1;
+  config.variant_period = 1;
+  TerrainRecipe recipe{.id = "recipe-id",
+                       .name = "meadow",
+                       .tileset_id = "tileset-id",
+                       .texture_id = "texture-id",
+                       .terrain_id = 1,
+                       .config = config};
+  model().LoadRecipe(recipe);
+
+  Tileset tileset{.id = "tileset-id",
+                  .name = "meadow",
+                  .texture_id = "texture-id",
+                  .tile_width = 8,
+                  .tile_height = 8};
+  tileset.tiles.push_back(Tile{.id = 1, .name = "block", .shape = TileShape::kFullBlock});
+  TerrainCellKey key;
+  key.shape = TileShape::kFullBlock;
+  key.neighbors.fill(TileShape::kFullBlock);
+  tileset.terrains.push_back(Terrain{.id = 1,
+                                     .name = "meadow",
+                                     .scheme = TerrainScheme::kDerived,
+                                     .variant_period = 1,
+                                     .derived_tiles = {{.tile_id = 1, .key = key}}});
+  RgbaImage atlas{.width = 8, .height = 8};
+  atlas.pixels.assign(8 * 8 * 4, 0);
+
+  // A lone cell drawn with the surrounded tile, which no longer matches what
+  // its neighbourhood renders to.
+  Level level{.id = "level-id", .name = "Cavern", .tileset_id = "tileset-id"};
+  level.width = 64;
+  level.height = 64;
+  level.layers[0].tile_chunks[ChunkKey(0, 0)].SetTile(2 * TileChunk::kSize + 2, 1);
+
+  ON_CALL(api_, GetTileset("tileset-id")).WillByDefault(Return(&tileset));
+  ON_CALL(api_, GetLevel("level-id")).WillByDefault(Return(&level));
+  ON_CALL(api_, GetAllLevels()).WillByDefault(Return(std::vector<Level>{level}));
+  ON_CALL(api_, ReadTexturePixels("texture-id")).WillByDefault(Return(atlas));
+  ON_CALL(api_, SaveTerrainRecipe(_)).WillByDefault(Return(absl::OkStatus()));
+  ON_CALL(api_, ReplaceTexturePixels(_, _, _, _)).WillByDefault(Return(absl::OkStatus()));
+  ON_CALL(api_, GetTerrainRecipe("recipe-id"))
+      .WillByDefault(Return(absl::NotFoundError("not cached in this mock")));
+
+  TerrainEditorTestPeer::RegenerateTerrain(*editor_);
+  ASSERT_OK(TerrainEditorTestPeer::WaitForTerrainWork(*editor_));
+  TerrainEditorTestPeer::PollTerrainWork(*editor_);
+
+  // The regeneration is committed and the rebake is running; nothing has been
+  // written to the level yet.
+  EXPECT_TRUE(TerrainEditorTestPeer::HasPendingTerrainWork(*editor_));
+  ASSERT_OK(TerrainEditorTestPeer::WaitForTerrainWork(*editor_));
+
+  EXPECT_CALL(api_, UpdateTileset(_)).WillOnce(Return(absl::OkStatus()));
+  EXPECT_CALL(api_, UpdateLevel(_)).WillOnce([](Level rebaked) {
+    EXPECT_NE(rebaked.layers[0].tile_chunks.at(ChunkKey(0, 0)).tile(2 * TileChunk::kSize + 2), 1);
+    return absl::OkStatus();
+  });
+  TerrainEditorTestPeer::PollTerrainWork(*editor_);
+
+  EXPECT_FALSE(TerrainEditorTestPeer::HasPendingTerrainWork(*editor_));
+  EXPECT_THAT(model().status(), HasSubstr("rebaked 1 level(s)"));
+}
+
 }  // namespace
 }  // namespace zebes
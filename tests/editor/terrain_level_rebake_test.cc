@@ -0,0 +1,171 @@
+#include "editor/terrain_editor/terrain_level_rebake.h"
+
+#include <utility>
+#include <vector>
+
+#include "editor/level_editor/derived_tile_provider.h"
+#include "editor/level_editor/terrain_brush.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "macros.h"
+#include "tests/api_mock.h"
+
+namespace zebes {
+namespace {
+
+using ::testing::_;
+using ::testing::ElementsAre;
+using ::testing::InSequence;
+using ::testing::NiceMock;
+using ::testing::Return;
+
+constexpr int kTileSize = 16;
+constexpr int kTerrainId = 5;
+
+TerrainGenConfig RecipeConfig(uint64_t seed) {
+  TerrainGenConfig config;
+  config.tile_size = kTileSize;
+  config.supersample = 1;
+  config.variant_period = 1;
+  config.seed = seed;
+  return config;
+}
+
+TerrainRecipe Recipe(uint64_t seed) {
+  return TerrainRecipe{.id = "recipe-id",
+                       .name = "Cave",
+                       .tileset_id = "tileset-id",
+                       .texture_id = "texture-id",
+                       .terrain_id = kTerrainId,
+                       .config = RecipeConfig(seed)};
+}
+
+Level MakeLevel(const std::string& id) {
+  Level level{.id = id, .name = id, .tileset_id = "tileset-id"};
+  level.tile_render_width = kTileSize;
+  level.tile_render_height = kTileSize;
+  level.width = 24 * kTileSize;
+  level.height = 12 * kTileSize;
+  return level;
+}
+
+// Two levels painted with the same derived terrain under seed 1, and one bound
+// to the tileset that never used the terrain.
+class TerrainLevelRebakeTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    tileset_ = Tileset{.id = "tileset-id",
+                       .name = "Cave",
+                       .texture_id = "texture-id",
+                       .tile_width = kTileSize,
+                       .tile_height = kTileSize};
+    tileset_.terrains.push_back(Terrain{.id = kTerrainId,
+                                        .name = "Cave",
+                                        .scheme = TerrainScheme::kDerived,
+                                        .variant_period = 1});
+    atlas_.width = 8 * kTileSize;
+    atlas_.height = kTileSize;
+    atlas_.pixels.assign(static_cast<size_t>(atlas_.width) * atlas_.height * 4, 0);
+
+    ASSERT_OK_AND_ASSIGN(TerrainRenderer renderer, TerrainRenderer::Create(RecipeConfig(1)));
+    ASSERT_OK_AND_ASSIGN(DerivedTileProvider provider,
+                         DerivedTileProvider::Create(std::move(renderer), tileset_, atlas_));
+    ASSERT_OK_AND_ASSIGN(TerrainIndex index, TerrainIndex::Build(tileset_));
+    for (const char* id : {"first", "second"}) {
+      Level level = MakeLevel(id);
+      ASSERT_OK(PaintTerrainRegion(level, level.layers.front(), index, provider, kTerrainId,
+                                   TileShape::kFullBlock,
+                                   RectangleCells({.x = 2, .y = 6}, {.x = 20, .y = 11})));
+      levels_.push_back(std::move(level));
+    }
+    levels_.push_back(MakeLevel("bare"));
+    atlas_ = provider.atlas();
+  }
+
+  Tileset tileset_;
+  RgbaImage atlas_;
+  std::vector<Level> levels_;
+};
+
+TEST_F(TerrainLevelRebakeTest, RebakesOnlyTheLevelsTheRegenerationChanged) {
+  ASSERT_OK_AND_ASSIGN(PreparedLevelRebake prepared,
+                       PrepareLevelRebake(Recipe(2), tileset_, atlas_, levels_));
+
+  EXPECT_EQ(prepared.levels_scanned, 3);
+  ASSERT_EQ(prepared.levels.size(), 2u);
+  EXPECT_EQ(prepared.source_levels[0], levels_[0]);
+  EXPECT_NE(prepared.levels[0], levels_[0]);
+  // One provider serves every level, so identical cells resolve identically.
+  EXPECT_EQ(prepared.levels[0].layers, prepared.levels[1].layers);
+  EXPECT_GT(prepared.appended_tiles, 0);
+  EXPECT_EQ(prepared.source_tileset, tileset_);
+  EXPECT_GT(prepared.tileset.tiles.size(), tileset_.tiles.size());
+}
+
+TEST_F(TerrainLevelRebakeTest, AnUnchangedRecipeChangesNothing) {
+  ASSERT_OK_AND_ASSIGN(PreparedLevelRebake prepared,
+                       PrepareLevelRebake(Recipe(1), tileset_, atlas_, levels_));
+  EXPECT_TRUE(prepared.levels.empty());
+  EXPECT_EQ(prepared.appended_tiles, 0);
+}
+
+TEST_F(TerrainLevelRebakeTest, ACancelledRebakePreparesNothing) {
+  TerrainRebakeMonitor monitor;
+  monitor.Cancel();
+  EXPECT_EQ(PrepareLevelRebake(Recipe(2), tileset_, atlas_, levels_, &monitor).status().code(),
+            absl::StatusCode::kCancelled);
+}
+
+TEST_F(TerrainLevelRebakeTest, CommitWritesArtworkBeforeTheLevelsNamingIt) {
+  ASSERT_OK_AND_ASSIGN(PreparedLevelRebake prepared,
+                       PrepareLevelRebake(Recipe(2), tileset_, atlas_, levels_));
+  NiceMock<MockApi> api;
+  ON_CALL(api, GetTileset("tileset-id")).WillByDefault(Return(&tileset_));
+  ON_CALL(api, GetLevel("first")).WillByDefault(Return(&levels_[0]));
+  ON_CALL(api, GetLevel("second")).WillByDefault(Return(&levels_[1]));
+
+  std::vector<std::string> saved;
+  {
+    InSequence order;
+    EXPECT_CALL(api, ReplaceTexturePixels("texture-id", _, _, _))
+        .WillOnce(Return(absl::OkStatus()));
+    EXPECT_CALL(api, UpdateTileset(_)).WillOnce(Return(absl::OkStatus()));
+    EXPECT_CALL(api, UpdateLevel(_)).Times(2).WillRepeatedly([&](Level level) {
+      saved.push_back(level.id);
+      return absl::OkStatus();
+    });
+  }
+  ASSERT_OK(CommitLevelRebake(api, std::move(prepared)));
+  EXPECT_THAT(saved, ElementsAre("first", "second"));
+}
+
+TEST_F(TerrainLevelRebakeTest, CommitRefusesALevelSavedWhileRebaking) {
+  ASSERT_OK_AND_ASSIGN(PreparedLevelRebake prepared,
+                       PrepareLevelRebake(Recipe(2), tileset_, atlas_, levels_));
+  Level edited = levels_[1];
+  edited.name = "Renamed";
+  NiceMock<MockApi> api;
+  ON_CALL(api, GetTileset("tileset-id")).WillByDefault(Return(&tileset_));
+  ON_CALL(api, GetLevel("first")).WillByDefault(Return(&levels_[0]));
+  ON_CALL(api, GetLevel("second")).WillByDefault(Return(&edited));
+  EXPECT_CALL(api, ReplaceTexturePixels(_, _, _, _)).Times(0);
+  EXPECT_CALL(api, UpdateTileset(_)).Times(0);
+  EXPECT_CALL(api, UpdateLevel(_)).Times(0);
+
+  EXPECT_EQ(CommitLevelRebake(api, std::move(prepared)).code(),
+            absl::StatusCode::kFailedPrecondition);
+}
+
+TEST(LevelsUsingTilesetTest, KeepsOnlyLevelsBoundToTheTileset) {
+  NiceMock<MockApi> api;
+  Level other = MakeLevel("other");
+  other.tileset_id = "elsewhere";
+  ON_CALL(api, GetAllLevels())
+      .WillByDefault(Return(std::vector<Level>{MakeLevel("a"), other, MakeLevel("b")}));
+  std::vector<std::string> ids;
+  for (const Level& level : LevelsUsingTileset(api, "tileset-id")) ids.push_back(level.id);
+  EXPECT_THAT(ids, ElementsAre("a", "b"));
+}
+
+}  // namespace
+}  // namespace zebes
@@ -0,0 +1,267 @@
+#include "editor/level_editor/terrain_rebake.h"
+
+#include <map>
+#include <memory>
+#include <tuple>
+#include <utility>
+
+#include "absl/strings/str_cat.h"
+#include "editor/level_editor/derived_tile_provider.h"
+#include "editor/level_editor/viewport_model.h"
+#include "gtest/gtest.h"
+#include "macros.h"
+#include "terrain/terrain_mask.h"
+
+namespace zebes {
+namespace {
+
+constexpr int kTileSize = 16;
+constexpr int kTerrainId = 5;
+constexpr int kOtherTerrainId = 6;
+constexpr int kFirstTileId = 1;
+constexpr int kOtherFirstTileId = 101;
+
+Terrain MakeBlobTerrain(int id, int first_tile_id) {
+  Terrain terrain;
+  terrain.id = id;
+  terrain.name = absl::StrCat("Terrain ", id);
+  absl::Span<const uint8_t> masks = Blob47MaskTable();
+  for (int i = 0; i < kBlob47TileCount; ++i) {
+    terrain.rules.push_back(TerrainRule{
+        .mask = masks[i],
+        .variants = {TerrainVariant{.tile_id = first_tile_id + i, .weight = 1}},
+    });
+  }
+  return terrain;
+}
+
+Tileset MakeBlobTileset() {
+  Tileset tileset;
+  tileset.name = "Generated";
+  tileset.texture_id = "tx";
+  tileset.tile_width = kTileSize;
+  tileset.tile_height = kTileSize;
+  for (int first : {kFirstTileId, kOtherFirstTileId}) {
+    for (int i = 0; i < kBlob47TileCount; ++i) {
+      tileset.tiles.push_back(
+          Tile{.id = first + i, .name = "T", .shape = TileShape::kFullBlock});
+    }
+  }
+  tileset.terrains.push_back(MakeBlobTerrain(kTerrainId, kFirstTileId));
+  tileset.terrains.push_back(MakeBlobTerrain(kOtherTerrainId, kOtherFirstTileId));
+  return tileset;
+}
+
+Level MakeLevel(int tiles_wide, int tiles_high) {
+  Level level;
+  level.tile_render_width = kTileSize;
+  level.tile_render_height = kTileSize;
+  level.width = tiles_wide * kTileSize;
+  level.height = tiles_high * kTileSize;
+  return level;
+}
+
+// Every nonzero cell of every layer, for comparing levels wholesale.
+std::map<std::tuple<int, int, int>, int> Cells(const Level& level) {
+  std::map<std::tuple<int, int, int>, int> cells;
+  const int wide = static_cast<int>(level.width) / kTileSize;
+  const int high = static_cast<int>(level.height) / kTileSize;
+  for (int layer = 0; layer < static_cast<int>(level.layers.size()); ++layer) {
+    for (int y = 0; y < high; ++y) {
+      for (int x = 0; x < wide; ++x) {
+        const int tile = GetTileAt(level.layers[layer], x, y).value();
+        if (tile != 0) cells[{layer, x, y}] = tile;
+      }
+    }
+  }
+  return cells;
+}
+
+class BlobRebakeTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    tileset_ = MakeBlobTileset();
+    ASSERT_OK_AND_ASSIGN(TerrainIndex index, TerrainIndex::Build(tileset_));
+    index_ = std::make_unique<TerrainIndex>(std::move(index));
+    provider_ = std::make_unique<Blob47TileProvider>(*index_);
+    level_.layers.push_back(WorldLayer{.id = 1, .name = "Foreground"});
+  }
+
+  // Paints a block correctly into `level`, the way the editor would have.
+  void PaintBlock(Level& level, int layer, int terrain_id, TileCoordinate corner,
+                  TileCoordinate opposite) {
+    ASSERT_OK(PaintTerrainRegion(level, level.layers[layer], *index_, *provider_, terrain_id,
+                                 TileShape::kFullBlock, RectangleCells(corner, opposite)));
+  }
+
+  // Overwrites a block with one tile the terrain owns, as a level saved against
+  // an older edit of the tileset would hold.
+  void StaleBlock(int layer, int tile_id, TileCoordinate corner, TileCoordinate opposite) {
+    for (const TileCoordinate& cell : RectangleCells(corner, opposite)) {
+      ASSERT_OK(SetTileAt(level_.layers[layer], cell.x, cell.y, tile_id));
+    }
+  }
+
+  Tileset tileset_;
+  std::unique_ptr<TerrainIndex> index_;
+  std::unique_ptr<Blob47TileProvider> provider_;
+  Level level_ = MakeLevel(80, 40);
+};
+
+TEST_F(BlobRebakeTest, StaleCellsEndUpAsPaintingThemWouldHaveLeftThem) {
+  // Spans several chunks in both directions and both layers.
+  StaleBlock(0, kFirstTileId, {.x = 2, .y = 3}, {.x = 70, .y = 35});
+  StaleBlock(1, kFirstTileId, {.x = 30, .y = 1}, {.x = 33, .y = 4});
+  Level expected = MakeLevel(80, 40);
+  expected.layers.push_back(WorldLayer{.id = 1, .name = "Foreground"});
+  PaintBlock(expected, 0, kTerrainId, {.x = 2, .y = 3}, {.x = 70, .y = 35});
+  PaintBlock(expected, 1, kTerrainId, {.x = 30, .y = 1}, {.x = 33, .y = 4});
+
+  ASSERT_OK_AND_ASSIGN(TerrainRebakeStats stats,
+                       RebakeTerrain(level_, *index_, *provider_, kTerrainId));
+
+  EXPECT_EQ(Cells(level_), Cells(expected));
+  EXPECT_EQ(stats.cells, 69 * 33 + 16);
+  EXPECT_GT(stats.rewritten, 0);
+  EXPECT_LT(stats.distinct_keys, 47);
+}
+
+TEST_F(BlobRebakeTest, AnUpToDateLevelIsLeftAlone) {
+  PaintBlock(level_, 0, kTerrainId, {.x = 1, .y = 1}, {.x = 40, .y = 20});
+  const auto before = Cells(level_);
+
+  ASSERT_OK_AND_ASSIGN(TerrainRebakeStats stats,
+                       RebakeTerrain(level_, *index_, *provider_, kTerrainId));
+
+  EXPECT_EQ(stats.rewritten, 0);
+  EXPECT_EQ(Cells(level_), before);
+}
+
+TEST_F(BlobRebakeTest, OnlyTheNamedTerrainIsRebaked) {
+  StaleBlock(0, kOtherFirstTileId, {.x = 1, .y = 1}, {.x = 4, .y = 4});
+  StaleBlock(0, kFirstTileId, {.x = 10, .y = 1}, {.x = 14, .y = 4});
+
+  ASSERT_OK(RebakeTerrain(level_, *index_, *provider_, kTerrainId));
+
+  EXPECT_EQ(GetTileAt(level_.layers[0], 2, 2).value(), kOtherFirstTileId);
+  EXPECT_NE(GetTileAt(level_.layers[0], 11, 2).value(), kFirstTileId);
+}
+
+TEST_F(BlobRebakeTest, TheResultDoesNotDependOnHowManyWorkersRan) {
+  StaleBlock(0, kFirstTileId, {.x = 0, .y = 0}, {.x = 79, .y = 39});
+  Level other = level_;
+
+  ASSERT_OK(RebakeTerrain(level_, *index_, *provider_, kTerrainId, {.max_workers = 1}));
+  ASSERT_OK(RebakeTerrain(other, *index_, *provider_, kTerrainId, {.max_workers = 8}));
+
+  EXPECT_EQ(Cells(level_), Cells(other));
+}
+
+TEST_F(BlobRebakeTest, ProgressEndsDone) {
+  StaleBlock(0, kFirstTileId, {.x = 0, .y = 0}, {.x = 9, .y = 9});
+  TerrainRebakeMonitor monitor;
+
+  ASSERT_OK(RebakeTerrain(level_, *index_, *provider_, kTerrainId, {.monitor = &monitor}));
+
+  EXPECT_EQ(monitor.progress().stage, TerrainRebakeMonitor::Stage::kDone);
+}
+
+TEST_F(BlobRebakeTest, ACancelledRebakeLeavesTheLevelUntouched) {
+  StaleBlock(0, kFirstTileId, {.x = 0, .y = 0}, {.x = 9, .y = 9});
+  const auto before = Cells(level_);
+  TerrainRebakeMonitor monitor;
+  monitor.Cancel();
+
+  absl::StatusOr<TerrainRebakeStats> stats =
+      RebakeTerrain(level_, *index_, *provider_, kTerrainId, {.monitor = &monitor});
+
+  EXPECT_EQ(stats.status().code(), absl::StatusCode::kCancelled);
+  EXPECT_EQ(Cells(level_), before);
+}
+
+TEST_F(BlobRebakeTest, AnUnknownTerrainIsRefused) {
+  absl::StatusOr<TerrainRebakeStats> stats = RebakeTerrain(level_, *index_, *provider_, 999);
+  EXPECT_EQ(stats.status().code(), absl::StatusCode::kNotFound);
+}
+
+// --- Derived terrain -----------------------------------------------------------
+
+TerrainGenConfig RecipeConfig(uint64_t seed) {
+  TerrainGenConfig config;
+  config.tile_size = kTileSize;
+  config.supersample = 1;
+  config.variant_period = 1;
+  config.seed = seed;
+  return config;
+}
+
+Tileset DerivedTileset() {
+  Tileset tileset;
+  tileset.name = "Cave";
+  tileset.texture_id = "tx";
+  tileset.tile_width = kTileSize;
+  tileset.tile_height = kTileSize;
+  tileset.terrains.push_back(Terrain{.id = kTerrainId,
+                                     .name = "Cave",
+                                     .scheme = TerrainScheme::kDerived,
+                                     .variant_period = 1});
+  return tileset;
+}
+
+RgbaImage BlankAtlas() {
+  RgbaImage atlas;
+  atlas.width = 8 * kTileSize;
+  atlas.height = kTileSize;
+  atlas.pixels.assign(static_cast<size_t>(atlas.width) * atlas.height * 4, 0);
+  return atlas;
+}
+
+// A derived terrain painted under one recipe, ready to be regenerated.
+struct PaintedDerivedLevel {
+  Tileset tileset = DerivedTileset();
+  RgbaImage atlas;
+  Level level = MakeLevel(40, 12);
+};
+
+void PaintDerived(PaintedDerivedLevel& painted) {
+  ASSERT_OK_AND_ASSIGN(TerrainRenderer renderer, TerrainRenderer::Create(RecipeConfig(1)));
+  ASSERT_OK_AND_ASSIGN(DerivedTileProvider provider,
+                       DerivedTileProvider::Create(std::move(renderer), painted.tileset,
+                                                   BlankAtlas()));
+  ASSERT_OK_AND_ASSIGN(TerrainIndex index, TerrainIndex::Build(painted.tileset));
+  ASSERT_OK(PaintTerrainRegion(painted.level, painted.level.layers.front(), index, provider,
+                               kTerrainId, TileShape::kFullBlock,
+                               RectangleCells({.x = 2, .y = 6}, {.x = 37, .y = 11})));
+  ASSERT_OK(PaintTerrainRegion(painted.level, painted.level.layers.front(), index, provider,
+                               kTerrainId, TileShape::kFullBlock,
+                               RectangleCells({.x = 10, .y = 2}, {.x = 14, .y = 5})));
+  painted.atlas = provider.atlas();
+}
+
+TEST(DerivedRebakeTest, ARegeneratedRecipeReachesEveryCellTheSameWayEveryTime) {
+  PaintedDerivedLevel serial;
+  PaintDerived(serial);
+  PaintedDerivedLevel parallel = serial;
+  const auto before = Cells(serial.level);
+
+  for (auto [painted, workers] : {std::pair{&serial, 1}, std::pair{&parallel, 8}}) {
+    ASSERT_OK_AND_ASSIGN(TerrainRenderer renderer, TerrainRenderer::Create(RecipeConfig(2)));
+    ASSERT_OK_AND_ASSIGN(DerivedTileProvider provider,
+                         DerivedTileProvider::Create(std::move(renderer), painted->tileset,
+                                                     painted->atlas));
+    ASSERT_OK_AND_ASSIGN(TerrainIndex index, TerrainIndex::Build(painted->tileset));
+
+    ASSERT_OK_AND_ASSIGN(
+        TerrainRebakeStats stats,
+        RebakeTerrain(painted->level, index, provider, kTerrainId,
+                      {.max_workers = workers, .render_batch = 3}));
+    EXPECT_EQ(stats.rewritten, stats.cells);
+  }
+
+  EXPECT_NE(Cells(serial.level), before);
+  EXPECT_EQ(Cells(serial.level), Cells(parallel.level));
+  EXPECT_EQ(serial.tileset.tiles.size(), parallel.tileset.tiles.size());
+}
+
+}  // namespace
+}  // namespace zebes
@@ -1,12 +1,17 @@
 #include "editor/level_editor/viewport_interaction.h"
 
+#include <filesystem>
 #include <limits>
+#include <memory>
 #include <utility>
 
 #include "absl/status/statusor.h"
 #include "editor/level_editor/viewport_model.h"
 #include "gtest/gtest.h"
 #include "macros.h"
+#include "objects/level_region.h"
+#include "resources/level_region_store.h"
+#include "resources/level_streamer.h"
 #include "terrain/terrain_mask.h"
 
 namespace zebes {
@@ -128,6 +133,36 @@ TEST(ViewportInteractionEntityTest, PlacesResolvedBlueprintWithStableId) {
   EXPECT_EQ(result->placed_entity->transform.position, (Vec{32, 48}));
 }
 
+TEST(ViewportInteractionEntityTest, PlacementAvoidsIdsHeldByRegionsNotLoaded) {
+  constexpr char kRoot[] = "test_data/viewport_interaction_test";
+  std::filesystem::remove_all(kRoot);
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<LevelRegionStore> store,
+                       LevelRegionStore::Create(kRoot, "streamed"));
+  LevelRegion far_away{.coordinate = {.x = 9, .y = 9}};
+  far_away.layers.push_back(WorldLayer{.id = 0});
+  far_away.layers[0].entities.emplace(40, Entity{.id = 40});
+  ASSERT_OK(store->Write(far_away));
+
+  ViewportInteractionController controller;
+  Level level = MakeLevel();
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<LevelStreamer> streamer,
+                       LevelStreamer::Create(&level, store.get()));
+  Blueprint blueprint{
+      .id = "marker",
+      .states = {{.name = "Idle"}},
+  };
+
+  absl::StatusOr<ViewportInteractionResult> result = controller.Update(
+      level, level.layers.front(),
+      {.world_position = {32, 48}, .pointer_in_level = true, .primary_pressed = true},
+      {.placement_blueprint = &blueprint, .streamer = streamer.get()});
+
+  ASSERT_OK(result);
+  ASSERT_TRUE(result->placed_entity.has_value());
+  EXPECT_EQ(result->placed_entity->id, 41);
+  std::filesystem::remove_all(kRoot);
+}
+
 TEST(ViewportInteractionEntityTest, RejectsUnresolvedBlueprintSprite) {
   ViewportInteractionController controller;
   Level level = MakeLevel();
@@ -202,6 +237,33 @@ TEST(ViewportInteractionEntityTest, SelectsAndDragsWithStablePointerOffset) {
   EXPECT_EQ(level.layers.front().entities.at(4).transform.position, (Vec{126, 135}));
 }
 
+TEST(ViewportInteractionEntityTest, AWholeDragIsOneJournalEntry) {
+  ViewportInteractionController controller;
+  LevelJournal journal;
+  Level level = MakeLevel();
+  level.layers.front().entities.emplace(4, Entity{.id = 4, .transform = {.position = {100, 100}}});
+  const ViewportInteractionOptions options{.selected_entity_id = 4, .journal = &journal};
+
+  ASSERT_OK(controller.Update(level, level.layers.front(),
+                              {.world_position = {104, 105},
+                               .pointer_in_level = true,
+                               .primary_pressed = true,
+                               .primary_down = true},
+                              options));
+  for (const double x : {110.0, 120.0, 130.0}) {
+    ASSERT_OK(controller.Update(
+        level, level.layers.front(),
+        {.world_position = {x, 140}, .pointer_in_level = true, .primary_down = true}, options));
+  }
+  EXPECT_EQ(journal.size(), 0u) << "the drag is recorded when it ends";
+  ASSERT_OK(controller.Update(level, level.layers.front(), {.world_position = {130, 140}},
+                              options));
+
+  EXPECT_EQ(journal.size(), 1u);
+  ASSERT_OK(journal.Undo(level));
+  EXPECT_EQ(level.layers.front().entities.at(4).transform.position, (Vec{100, 100}));
+}
+
 TEST(ViewportInteractionEntityTest, RequestsDeletionWithoutMutatingTheLevel) {
   ViewportInteractionController controller;
   Level level = MakeLevel();
@@ -434,6 +496,88 @@ TEST(ViewportInteractionTerrainTest, PaintingANeighbourReresolvesTheExistingCell
       << "the first cell should have gained an eastern edge";
 }
 
+TEST(ViewportInteractionTerrainTest, AFastStrokeFillsTheCellsItSkipped) {
+  Tileset tileset = MakeTerrainTileset();
+  absl::StatusOr<TerrainIndex> index = TerrainIndex::Build(tileset);
+  ASSERT_OK(index);
+  Blob47TileProvider provider(*index);
+
+  ViewportInteractionController controller;
+  Level level = MakeLevel();
+  const ViewportInteractionOptions options{
+      .paint_terrain_id = kTerrainId, .terrain_index = &*index, .terrain_provider = &provider};
+
+  ASSERT_OK(controller.Update(
+      level, level.layers.front(),
+      {.world_position = {8, 8}, .pointer_in_level = true, .primary_down = true}, options));
+  // One frame later the pointer is five cells along.
+  ASSERT_OK(controller.Update(
+      level, level.layers.front(),
+      {.world_position = {88, 8}, .pointer_in_level = true, .primary_down = true}, options));
+
+  for (int x = 0; x <= 5; ++x) {
+    EXPECT_NE(GetTileAt(level.layers.front(), x, 0).value(), 0) << "gap at " << x;
+  }
+}
+
+TEST(ViewportInteractionTerrainTest, ANewStrokeDoesNotJoinTheLastOne) {
+  Tileset tileset = MakeTerrainTileset();
+  absl::StatusOr<TerrainIndex> index = TerrainIndex::Build(tileset);
+  ASSERT_OK(index);
+  Blob47TileProvider provider(*index);
+
+  ViewportInteractionController controller;
+  Level level = MakeLevel();
+  const ViewportInteractionOptions options{
+      .paint_terrain_id = kTerrainId, .terrain_index = &*index, .terrain_provider = &provider};
+
+  ASSERT_OK(controller.Update(
+      level, level.layers.front(),
+      {.world_position = {8, 8}, .pointer_in_level = true, .primary_down = true}, options));
+  ASSERT_OK(controller.Update(level, level.layers.front(),
+                              {.world_position = {8, 8}, .pointer_in_level = true}, options));
+  ASSERT_OK(controller.Update(
+      level, level.layers.front(),
+      {.world_position = {88, 8}, .pointer_in_level = true, .primary_down = true}, options));
+
+  EXPECT_EQ(GetTileAt(level.layers.front(), 2, 0).value(), 0);
+}
+
+TEST(ViewportInteractionTerrainTest, AStrokeUndoesAsOneEntryWithTheNeighboursItTouched) {
+  Tileset tileset = MakeTerrainTileset();
+  absl::StatusOr<TerrainIndex> index = TerrainIndex::Build(tileset);
+  ASSERT_OK(index);
+  Blob47TileProvider provider(*index);
+
+  ViewportInteractionController controller;
+  LevelJournal journal;
+  Level level = MakeLevel();
+  const ViewportInteractionOptions options{.paint_terrain_id = kTerrainId,
+                                           .terrain_index = &*index,
+                                           .terrain_provider = &provider,
+                                           .journal = &journal};
+
+  // An earlier stroke whose cell the next one re-resolves.
+  ASSERT_OK(controller.Update(
+      level, level.layers.front(),
+      {.world_position = {8, 24}, .pointer_in_level = true, .primary_down = true}, options));
+  ASSERT_OK(controller.Update(level, level.layers.front(), {}, options));
+  const WorldLayer before = level.layers.front();
+
+  for (const double x : {8.0, 40.0, 88.0}) {
+    ASSERT_OK(controller.Update(
+        level, level.layers.front(),
+        {.world_position = {x, 8}, .pointer_in_level = true, .primary_down = true}, options));
+  }
+  ASSERT_OK(controller.Update(level, level.layers.front(), {}, options));
+  ASSERT_NE(GetTileAt(level.layers.front(), 0, 1).value(), GetTileAt(before, 0, 1).value())
+      << "the stroke should have re-resolved the cell below it";
+
+  EXPECT_EQ(journal.size(), 2u);
+  ASSERT_OK(journal.Undo(level));
+  EXPECT_EQ(level.layers.front().tile_chunks, before.tile_chunks);
+}
+
 TEST(ViewportInteractionTerrainTest, RequiresATerrainIndex) {
   ViewportInteractionController controller;
   Level level = MakeLevel();
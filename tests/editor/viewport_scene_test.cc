@@ -387,6 +387,28 @@ TEST(ViewportSceneTileTest, OffscreenChunksAreNotScanned) {
   EXPECT_TRUE(batch->items.empty());
 }
 
+TEST(ViewportSceneTileTest, OnlyChunksLimitsCompositionToTheNamedChunks) {
+  Level level{
+      .tile_render_width = 16,
+      .tile_render_height = 16,
+      .width = 2048,
+      .height = 1024,
+  };
+  WorldLayer& layer = level.layers.front();
+  ASSERT_OK(SetTileAt(layer, 2, 2, 1));
+  ASSERT_OK(SetTileAt(layer, TileChunk::kSize + 2, 2, 1));
+  Tileset tileset{.tiles = {{.id = 1, .source_x = 0, .source_y = 0}}};
+  Camera camera{.position = {512, 256}, .zoom = 1, .viewport_width = 1024, .viewport_height = 512};
+  const absl::flat_hash_set<int64_t> only{ChunkKey(1, 0)};
+
+  absl::StatusOr<TileRenderBatch> batch =
+      ComposeLevelTileRenderBatch(level, layer, tileset, {}, camera, {.only_chunks = &only});
+
+  ASSERT_OK(batch);
+  ASSERT_EQ(batch->items.size(), 1u);
+  EXPECT_EQ(batch->items.front().bounds.min, (Vec{(TileChunk::kSize + 2) * 16.0, 32}));
+}
+
 TEST(ViewportSceneTileTest, RejectsUnknownVisibleTileAndDuplicateDefinitions) {
   Level level{
       .tile_render_width = 16,
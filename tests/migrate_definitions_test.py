@@ -228,7 +228,7 @@ class MigrateDefinitionsTest(unittest.TestCase):
 
         self.assertEqual(changed, [path])
         document = json.loads(path.read_text(encoding="utf-8"))
-        self.assertEqual(document["schema_version"], 2)
+        self.assertEqual(document["schema_version"], 3)
         self.assertEqual(document["pipeline_version"], 2)
         self.assertEqual(
             document["pipeline"]["composition"]["attachment"],
@@ -238,9 +238,11 @@ class MigrateDefinitionsTest(unittest.TestCase):
         self.assertEqual(cleanup["contact_tolerance"], 3)
         self.assertNotIn("grounded_tolerance", cleanup)
         self.assertEqual(document["pipeline"]["composition"]["padding_fraction"], 0.06)
+        self.assertTrue(document["pipeline"]["working_proxy"]["full_resolution"])
 
-    def test_current_prop_recipe_is_left_byte_untouched(self):
-        document = self.v1_prop_recipe()
+    @classmethod
+    def v2_prop_recipe(cls):
+        document = cls.v1_prop_recipe()
         document["schema_version"] = 2
         document["pipeline_version"] = 2
         document["pipeline"]["composition"]["attachment"] = {
@@ -250,6 +252,36 @@ class MigrateDefinitionsTest(unittest.TestCase):
         document["pipeline"]["cleanup"]["contact_tolerance"] = document["pipeline"][
             "cleanup"
         ].pop("grounded_tolerance")
+        return document
+
+    # v2 always processed the source at full resolution; anything else would
+    # change the pixels its recorded digest describes.
+    def test_v2_prop_recipe_keeps_full_resolution(self):
+        path = self.write_prop_recipe("lamp.json", self.v2_prop_recipe())
+
+        changed = migrate_definitions.migrate_directory(
+            self.root, "prop_recipes", dry_run=False
+        )
+
+        self.assertEqual(changed, [path])
+        document = json.loads(path.read_text(encoding="utf-8"))
+        self.assertEqual(document["schema_version"], 3)
+        self.assertEqual(
+            document["pipeline"]["working_proxy"],
+            {"full_resolution": True, "minimum_oversample": 8},
+        )
+        self.assertEqual(
+            document["pipeline"]["composition"]["attachment"],
+            {"mode": "free", "free_anchor": {"x": 12, "y": 7}},
+        )
+
+    def test_current_prop_recipe_is_left_byte_untouched(self):
+        document = self.v2_prop_recipe()
+        document["schema_version"] = 3
+        document["pipeline"]["working_proxy"] = {
+            "full_resolution": False,
+            "minimum_oversample": 4,
+        }
         path = self.write_prop_recipe("lamp.json", document)
         before = path.read_bytes()
 
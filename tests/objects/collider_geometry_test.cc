@@ -0,0 +1,129 @@
+#include "objects/collider_geometry.h"
+
+#include <cmath>
+#include <cstddef>
+#include <numbers>
+#include <random>
+
+#include "gtest/gtest.h"
+
+namespace zebes {
+namespace {
+
+double Area(const Polygon& polygon) {
+  double area = 0;
+  for (size_t i = 0; i < polygon.size(); ++i) {
+    const Vec& a = polygon[i];
+    const Vec& b = polygon[(i + 1) % polygon.size()];
+    area += a.x * b.y - b.x * a.y;
+  }
+  return area / 2;
+}
+
+bool IsConvex(const Polygon& polygon) {
+  for (size_t i = 0; i < polygon.size(); ++i) {
+    const Vec& a = polygon[i];
+    const Vec& b = polygon[(i + 1) % polygon.size()];
+    const Vec& c = polygon[(i + 2) % polygon.size()];
+    if ((b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x) < 0) return false;
+  }
+  return true;
+}
+
+ColliderGeometry Square(double size) {
+  return BuildColliderGeometry(
+      Collider{.polygons = {{{0, 0}, {0, size}, {size, size}, {size, 0}}}});
+}
+
+TEST(ColliderGeometryTest, KeepsAConvexPolygonWhole) {
+  // Authored the other way round from the canonical winding.
+  const ColliderGeometry geometry = Square(10);
+
+  ASSERT_EQ(geometry.pieces.size(), 1);
+  EXPECT_EQ(geometry.pieces[0].points.size(), 4);
+  EXPECT_GT(Area(geometry.pieces[0].points), 0);
+  EXPECT_EQ(geometry.bounds.min, (Vec{.x = 0, .y = 0}));
+  EXPECT_EQ(geometry.bounds.max, (Vec{.x = 10, .y = 10}));
+}
+
+TEST(ColliderGeometryTest, SplitsAConcavePolygonIntoConvexPieces) {
+  // An L: a 30x10 bar along the top with a 10x20 leg down the left.
+  const Collider collider{
+      .polygons = {{{0, 0}, {30, 0}, {30, 10}, {10, 10}, {10, 30}, {0, 30}}}};
+  const ColliderGeometry geometry = BuildColliderGeometry(collider);
+
+  ASSERT_GE(geometry.pieces.size(), 2);
+  EXPECT_LE(geometry.pieces.size(), 3);
+  double area = 0;
+  for (const ConvexPiece& piece : geometry.pieces) {
+    EXPECT_TRUE(IsConvex(piece.points));
+    area += Area(piece.points);
+  }
+  EXPECT_DOUBLE_EQ(area, 30 * 10 + 10 * 20);
+  EXPECT_EQ(geometry.bounds.max, (Vec{.x = 30, .y = 30}));
+
+  // A small box in the notch of the L is inside its bounds but clear of it.
+  const ColliderGeometry small = Square(4);
+  EXPECT_FALSE(ColliderGeometriesOverlap(geometry, {}, small, {.x = 20, .y = 20}));
+  EXPECT_TRUE(ColliderGeometriesOverlap(geometry, {}, small, {.x = 8, .y = 20}));
+  EXPECT_TRUE(ColliderGeometriesOverlap(geometry, {}, small, {.x = 20, .y = 8}));
+}
+
+// Random star-shaped polygons: always simple, usually concave.
+TEST(ColliderGeometryTest, PiecesTileRandomConcavePolygonsExactly) {
+  std::mt19937 random(3);
+  std::uniform_real_distribution<double> radius(4, 40);
+  std::uniform_int_distribution<int> point_count(4, 14);
+  for (int trial = 0; trial < 200; ++trial) {
+    Polygon polygon;
+    const int points = point_count(random);
+    for (int i = 0; i < points; ++i) {
+      const double angle = 2 * std::numbers::pi * i / points;
+      const double r = radius(random);
+      polygon.push_back({.x = r * std::cos(angle), .y = r * std::sin(angle)});
+    }
+    const ColliderGeometry geometry = BuildColliderGeometry(Collider{.polygons = {polygon}});
+
+    ASSERT_FALSE(geometry.empty()) << "trial " << trial;
+    EXPECT_LT(geometry.pieces.size(), points) << "trial " << trial;
+    double area = 0;
+    for (const ConvexPiece& piece : geometry.pieces) {
+      EXPECT_TRUE(IsConvex(piece.points)) << "trial " << trial;
+      area += Area(piece.points);
+    }
+    EXPECT_NEAR(area, Area(polygon), 1e-6) << "trial " << trial;
+  }
+}
+
+TEST(ColliderGeometryTest, FallsBackToTheHullOfASelfCrossingPolygon) {
+  // A bow tie.
+  const Collider collider{.polygons = {{{0, 0}, {10, 10}, {10, 0}, {0, 10}}}};
+  const ColliderGeometry geometry = BuildColliderGeometry(collider);
+
+  ASSERT_EQ(geometry.pieces.size(), 1);
+  EXPECT_DOUBLE_EQ(Area(geometry.pieces[0].points), 100);
+}
+
+TEST(ColliderGeometryTest, DropsPolygonsWithoutArea) {
+  const Collider collider{.polygons = {{{0, 0}, {5, 5}}, {{0, 0}, {5, 5}, {10, 10}}, {}}};
+  const ColliderGeometry geometry = BuildColliderGeometry(collider);
+
+  EXPECT_TRUE(geometry.empty());
+  EXPECT_FALSE(ColliderGeometriesOverlap(geometry, {}, Square(10), {}));
+}
+
+TEST(ColliderGeometryTest, TouchingIsNotOverlapping) {
+  const ColliderGeometry square = Square(10);
+  const ColliderGeometry triangle =
+      BuildColliderGeometry(Collider{.polygons = {{{0, 0}, {10, 0}, {0, 10}}}});
+
+  EXPECT_FALSE(ColliderGeometriesOverlap(square, {}, square, {.x = 10, .y = 0}));
+  EXPECT_TRUE(ColliderGeometriesOverlap(square, {}, square, {.x = 9.5, .y = 9.5}));
+  // The triangle's long edge runs from (10, 0) to (0, 10); a square with its
+  // corner at (5, 5) sits exactly on it.
+  EXPECT_FALSE(ColliderGeometriesOverlap(triangle, {}, square, {.x = 5, .y = 5}));
+  EXPECT_TRUE(ColliderGeometriesOverlap(triangle, {}, square, {.x = 4.9, .y = 4.9}));
+}
+
+}  // namespace
+}  // namespace zebes
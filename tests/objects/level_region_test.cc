@@ -0,0 +1,237 @@
+#include "objects/level_region.h"
+
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "macros.h"
+
+namespace zebes {
+namespace {
+
+using ::testing::HasSubstr;
+using ::testing::UnorderedElementsAre;
+
+// Two chunks to a region side, so one region spans 1,024 pixels at the
+// default 16-pixel tiles.
+constexpr int kRegionChunks = 2;
+constexpr double kRegionPixels = kRegionChunks * TileChunk::kSize * 16;
+
+TileChunk FilledChunk(int tile_id) {
+  TileChunk chunk;
+  chunk.Fill(tile_id);
+  return chunk;
+}
+
+Entity EntityAt(uint64_t id, double x, double y) {
+  return Entity{.id = id, .transform = {.position = {.x = x, .y = y}}};
+}
+
+// Content in regions (0, 0), (1, 0) and (0, 1), across two layers.
+Level WorldLevel() {
+  Level level{.id = "level-id", .name = "World", .width = 2048, .height = 2048};
+  level.layers.push_back(WorldLayer{.id = 3, .name = "Front"});
+  WorldLayer& base = level.layers[0];
+  WorldLayer& front = level.layers[1];
+  base.tile_chunks.emplace(ChunkKey(0, 0), FilledChunk(1));
+  base.tile_chunks.emplace(ChunkKey(1, 1), FilledChunk(2));
+  base.tile_chunks.emplace(ChunkKey(2, 0), FilledChunk(3));
+  front.tile_chunks.emplace(ChunkKey(0, 2), FilledChunk(4));
+  base.entities.emplace(1, EntityAt(1, 10, 10));
+  front.entities.emplace(2, EntityAt(2, kRegionPixels + 10, 10));
+  front.entities.emplace(3, EntityAt(3, 20, 20));
+  return level;
+}
+
+TEST(LevelRegionTest, ChunksAndPointsRoundTowardsNegativeInfinity) {
+  EXPECT_EQ(RegionOfChunk({.x = 0, .y = 0}, 8), (LevelRegionCoordinate{0, 0}));
+  EXPECT_EQ(RegionOfChunk({.x = 7, .y = 8}, 8), (LevelRegionCoordinate{0, 1}));
+  EXPECT_EQ(RegionOfChunk({.x = -1, .y = -8}, 8), (LevelRegionCoordinate{-1, -1}));
+  EXPECT_EQ(RegionOfChunk({.x = -9, .y = 0}, 8), (LevelRegionCoordinate{-2, 0}));
+
+  const Level level{.tile_render_width = 16, .tile_render_height = 8};
+  EXPECT_EQ(RegionOfPoint(level, {.x = kRegionPixels - 1, .y = kRegionPixels / 2}, kRegionChunks),
+            (LevelRegionCoordinate{0, 1}));
+  EXPECT_EQ(RegionOfPoint(level, {.x = -0.5, .y = 0}, kRegionChunks),
+            (LevelRegionCoordinate{-1, 0}));
+}
+
+TEST(LevelRegionTest, DistanceCountsDiagonalsAsOne) {
+  EXPECT_EQ(RegionDistance({0, 0}, {0, 0}), 0);
+  EXPECT_EQ(RegionDistance({0, 0}, {2, -2}), 2);
+  EXPECT_EQ(RegionDistance({1, 1}, {-2, 0}), 3);
+}
+
+TEST(LevelRegionTest, TakeAllEmptiesTheLevelAndInstallingPutsItBack) {
+  const Level original = WorldLevel();
+  Level level = original;
+
+  const std::vector<LevelRegion> regions = TakeAllRegions(level, kRegionChunks);
+  ASSERT_EQ(regions.size(), 3u);
+  EXPECT_EQ(regions[0].coordinate, (LevelRegionCoordinate{0, 0}));
+  EXPECT_EQ(regions[1].coordinate, (LevelRegionCoordinate{1, 0}));
+  EXPECT_EQ(regions[2].coordinate, (LevelRegionCoordinate{0, 1}));
+  for (const WorldLayer& layer : level.layers) {
+    EXPECT_TRUE(layer.tile_chunks.empty());
+    EXPECT_TRUE(layer.entities.empty());
+  }
+
+  // Region (0, 0) holds both layers, in level order, named by ID alone.
+  ASSERT_EQ(regions[0].layers.size(), 2u);
+  EXPECT_EQ(regions[0].layers[0].id, 0);
+  EXPECT_TRUE(regions[0].layers[0].name.empty());
+  EXPECT_EQ(regions[0].layers[0].tile_chunks.size(), 2u);
+  EXPECT_EQ(regions[0].layers[1].id, 3);
+  EXPECT_TRUE(regions[0].layers[1].entities.contains(3));
+
+  for (const LevelRegion& region : regions) {
+    ASSERT_OK(InstallRegion(level, region));
+  }
+  EXPECT_EQ(level, original);
+}
+
+TEST(LevelRegionTest, CopyMatchesTakeAndOnlyTakeRemoves) {
+  Level level = WorldLevel();
+  const LevelRegion copied = CopyRegion(level, {1, 0}, kRegionChunks);
+  EXPECT_EQ(level, WorldLevel());
+  EXPECT_THAT(OccupiedRegions(level, kRegionChunks),
+              UnorderedElementsAre(LevelRegionCoordinate{0, 0}, LevelRegionCoordinate{1, 0},
+                                   LevelRegionCoordinate{0, 1}));
+
+  const LevelRegion taken = TakeRegion(level, {1, 0}, kRegionChunks);
+  EXPECT_EQ(taken, copied);
+  EXPECT_THAT(OccupiedRegions(level, kRegionChunks),
+              UnorderedElementsAre(LevelRegionCoordinate{0, 0}, LevelRegionCoordinate{0, 1}));
+  EXPECT_FALSE(level.layers[0].tile_chunks.contains(ChunkKey(2, 0)));
+  EXPECT_EQ(FindEntity(level, 2), nullptr);
+  EXPECT_TRUE(TakeRegion(level, {1, 0}, kRegionChunks).empty());
+}
+
+TEST(LevelRegionTest, EntitiesBelongToTheRegionOfTheirPosition) {
+  Level level = WorldLevel();
+  FindEntity(level, 1)->transform.position = {.x = 10, .y = kRegionPixels + 10};
+
+  const LevelRegion region = CopyRegion(level, {0, 1}, kRegionChunks);
+  ASSERT_EQ(region.layers.size(), 2u);
+  EXPECT_TRUE(region.layers[0].entities.contains(1));
+  EXPECT_FALSE(CopyRegion(level, {0, 0}, kRegionChunks).layers[0].entities.contains(1));
+}
+
+TEST(LevelRegionTest, InstallingMergesWithWhatTheLevelAlreadyHolds) {
+  Level level = WorldLevel();
+  // Painted while region (0, 0) was away: one cell of a chunk it also holds.
+  TileChunk painted;
+  painted.SetTile(0, 9);
+  level.layers[0].tile_chunks.emplace(ChunkKey(1, 0), painted);
+
+  LevelRegion region{.coordinate = {0, 0}};
+  region.layers.push_back(WorldLayer{.id = 0});
+  TileChunk stored;
+  stored.SetTile(0, 9);
+  stored.SetTile(1, 5);
+  region.layers[0].tile_chunks.emplace(ChunkKey(1, 0), stored);
+  region.layers[0].tile_chunks.emplace(ChunkKey(0, 1), FilledChunk(6));
+  region.layers[0].entities.emplace(4, EntityAt(4, 40, 40));
+  // The level already holds entity 3 just like this.
+  region.layers.push_back(WorldLayer{.id = 3});
+  region.layers[1].entities.emplace(3, EntityAt(3, 20, 20));
+
+  ASSERT_OK(InstallRegion(level, region));
+
+  const WorldLayer& base = level.layers[0];
+  EXPECT_EQ(base.tile_chunks.at(ChunkKey(1, 0)).tile(0), 9);
+  EXPECT_EQ(base.tile_chunks.at(ChunkKey(1, 0)).tile(1), 5);
+  EXPECT_EQ(base.tile_chunks.at(ChunkKey(1, 0)).occupied(), 2);
+  EXPECT_EQ(base.tile_chunks.at(ChunkKey(0, 1)), FilledChunk(6));
+  EXPECT_EQ(FindEntityLayer(level, 3)->id, 3);
+  EXPECT_EQ(FindEntityLayer(level, 4)->id, 0);
+  EXPECT_OK(ValidateLevel(level));
+}
+
+TEST(LevelRegionTest, InstallingRefusesToOverwriteATile) {
+  Level level = WorldLevel();
+  LevelRegion region{.coordinate = {0, 0}};
+  region.layers.push_back(WorldLayer{.id = 0});
+  region.layers[0].entities.emplace(4, EntityAt(4, 40, 40));
+  region.layers[0].tile_chunks.emplace(ChunkKey(0, 0), FilledChunk(9));
+
+  EXPECT_EQ(InstallRegion(level, region).code(), absl::StatusCode::kFailedPrecondition);
+  // Nothing was installed, not even the content that fit.
+  EXPECT_EQ(level, WorldLevel());
+}
+
+TEST(LevelRegionTest, InstallingRefusesAnEntityIdInUse) {
+  Level level = WorldLevel();
+  LevelRegion region{.coordinate = {0, 0}};
+  region.layers.push_back(WorldLayer{.id = 0});
+  // ID 3 belongs to another entity on the other layer.
+  region.layers[0].entities.emplace(3, EntityAt(3, 30, 30));
+
+  EXPECT_EQ(InstallRegion(level, region).code(), absl::StatusCode::kFailedPrecondition);
+  EXPECT_EQ(level, WorldLevel());
+}
+
+TEST(LevelRegionTest, InstallingRefusesContentForAMissingLayer) {
+  Level level = WorldLevel();
+  LevelRegion region{.coordinate = {0, 0}};
+  region.layers.push_back(WorldLayer{.id = 0});
+  region.layers[0].entities.emplace(4, EntityAt(4, 40, 40));
+  // Layer 7 is not in the level; dropping its entity would lose it on disk too.
+  region.layers.push_back(WorldLayer{.id = 7});
+  region.layers[1].entities.emplace(5, EntityAt(5, 50, 50));
+
+  const absl::Status status = InstallRegion(level, region);
+  EXPECT_EQ(status.code(), absl::StatusCode::kFailedPrecondition);
+  EXPECT_THAT(status.message(), HasSubstr("world layer 7"));
+  EXPECT_EQ(CheckRegionInstall(level, region), status);
+  EXPECT_EQ(level, WorldLevel());
+}
+
+TEST(LevelRegionTest, EmptyChunksAreNotContent) {
+  Level level = WorldLevel();
+  level.layers[0].tile_chunks.emplace(ChunkKey(6, 6), TileChunk());
+
+  EXPECT_THAT(OccupiedRegions(level, kRegionChunks),
+              UnorderedElementsAre(LevelRegionCoordinate{0, 0}, LevelRegionCoordinate{1, 0},
+                                   LevelRegionCoordinate{0, 1}));
+  EXPECT_TRUE(CopyRegion(level, {3, 3}, kRegionChunks).empty());
+  EXPECT_TRUE(TakeRegion(level, {3, 3}, kRegionChunks).empty());
+  EXPECT_FALSE(level.layers[0].tile_chunks.contains(ChunkKey(6, 6)));
+  EXPECT_EQ(TakeAllRegions(level, kRegionChunks).size(), 3u);
+}
+
+TEST(LevelRegionTest, StateHashFollowsContentNotHistory) {
+  const Level level = WorldLevel();
+  const LevelRegion region = CopyRegion(level, {0, 0}, kRegionChunks);
+
+  // The same content in tables of another capacity, which iterate differently.
+  LevelRegion rebuilt{.coordinate = region.coordinate};
+  for (const WorldLayer& layer : region.layers) {
+    WorldLayer copy{.id = layer.id, .entities = layer.entities};
+    copy.tile_chunks.reserve(256);
+    copy.tile_chunks.insert(layer.tile_chunks.begin(), layer.tile_chunks.end());
+    rebuilt.layers.push_back(std::move(copy));
+  }
+  ASSERT_EQ(rebuilt, region);
+  EXPECT_EQ(LevelRegionStateHash(rebuilt), LevelRegionStateHash(region));
+
+  LevelRegion painted = region;
+  painted.layers[0].tile_chunks.at(ChunkKey(0, 0)).SetTile(5, 8);
+  EXPECT_NE(LevelRegionStateHash(painted), LevelRegionStateHash(region));
+
+  LevelRegion moved = region;
+  moved.layers[1].entities.at(3).transform.position.x += 1;
+  EXPECT_NE(LevelRegionStateHash(moved), LevelRegionStateHash(region));
+}
+
+TEST(LevelRegionTest, EstimatedBytesGrowWithContent) {
+  const Level level = WorldLevel();
+  const LevelRegion region = CopyRegion(level, {0, 0}, kRegionChunks);
+  EXPECT_EQ(LevelRegion{}.EstimatedBytes(), 0u);
+  EXPECT_GT(region.EstimatedBytes(), CopyRegion(level, {1, 0}, kRegionChunks).EstimatedBytes());
+}
+
+}  // namespace
+}  // namespace zebes
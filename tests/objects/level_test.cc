@@ -60,11 +60,11 @@ TEST(LevelTest, ValidationRejectsDuplicateEntitiesAcrossLayers) {
 
 TEST(LevelTest, ValidationRejectsInvalidChunkCoordinatesAndTilesOutsideBounds) {
   Level level = ValidLevel();
-  level.layers.front().tile_chunks[ChunkKey(-1, 0)].tiles[0] = 1;
+  level.layers.front().tile_chunks[ChunkKey(-1, 0)].SetTile(0, 1);
   EXPECT_EQ(ValidateLevel(level).code(), absl::StatusCode::kInvalidArgument);
 
   level.layers.front().tile_chunks.clear();
-  level.layers.front().tile_chunks[ChunkKey(0, 0)].tiles[20] = 1;
+  level.layers.front().tile_chunks[ChunkKey(0, 0)].SetTile(20, 1);
   level.width = 16;
   level.height = 16;
   EXPECT_EQ(ValidateLevel(level).code(), absl::StatusCode::kInvalidArgument);
@@ -0,0 +1,106 @@
+#include "objects/sprite_timeline.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace zebes {
+namespace {
+
+std::vector<SpriteFrame> Frames(const std::vector<int>& durations) {
+  std::vector<SpriteFrame> frames;
+  for (int duration : durations) {
+    frames.push_back(
+        {.index = static_cast<int>(frames.size()), .frames_per_cycle = duration});
+  }
+  return frames;
+}
+
+// What stepping one tick at a time, as the editor's Animator used to, shows
+// after `ticks` ticks.
+int FrameAfterStepping(const std::vector<SpriteFrame>& frames, int ticks) {
+  int index = 0;
+  int held = 0;
+  for (int tick = 0; tick < ticks; ++tick) {
+    if (++held >= std::max(1, frames[index].frames_per_cycle)) {
+      held = 0;
+      index = (index + 1) % static_cast<int>(frames.size());
+    }
+  }
+  return index;
+}
+
+TEST(SpriteTimelineTest, HoldsEachFrameForItsDuration) {
+  const SpriteTimeline timeline(Frames({2, 1, 3}));
+
+  EXPECT_EQ(timeline.cycle_ticks(), 6);
+  const std::vector<int> expected = {0, 0, 1, 2, 2, 2, 0, 0, 1};
+  for (int tick = 0; tick < expected.size(); ++tick) {
+    EXPECT_EQ(timeline.FrameIndexAt(tick), expected[tick]) << "tick " << tick;
+  }
+}
+
+TEST(SpriteTimelineTest, FramesWithoutADurationLastOneTick) {
+  const SpriteTimeline timeline(Frames({0, -3, 2}));
+
+  EXPECT_EQ(timeline.cycle_ticks(), 4);
+  EXPECT_EQ(timeline.FrameIndexAt(0), 0);
+  EXPECT_EQ(timeline.FrameIndexAt(1), 1);
+  EXPECT_EQ(timeline.FrameIndexAt(3), 2);
+}
+
+TEST(SpriteTimelineTest, NegativeTimeRunsTheLoopBackwards) {
+  const SpriteTimeline timeline(Frames({2, 1, 3}));
+
+  EXPECT_EQ(timeline.FrameIndexAt(-1), 2);
+  EXPECT_EQ(timeline.FrameIndexAt(-4), 1);
+  EXPECT_EQ(timeline.FrameIndexAt(-6), 0);
+}
+
+TEST(SpriteTimelineTest, AnEmptyTimelineHasNoFrame) {
+  const SpriteTimeline timeline(std::vector<SpriteFrame>{});
+  std::vector<int> indices(3, 7);
+
+  EXPECT_TRUE(timeline.empty());
+  EXPECT_EQ(timeline.FrameIndexAt(5), -1);
+  timeline.FrameIndicesAt(5, std::vector<int64_t>{0, 1, 2}, absl::MakeSpan(indices));
+  EXPECT_EQ(indices, (std::vector<int>{-1, -1, -1}));
+}
+
+// Random frame counts, which exercise every padding of the search table, and
+// random durations, against stepping there one tick at a time.
+TEST(SpriteTimelineTest, MatchesSteppingTickByTick) {
+  std::mt19937 random(5);
+  std::uniform_int_distribution<int> frame_count(1, 19);
+  std::uniform_int_distribution<int> duration(0, 9);
+  for (int trial = 0; trial < 50; ++trial) {
+    std::vector<int> durations(frame_count(random));
+    for (int& frame : durations) frame = duration(random);
+    const std::vector<SpriteFrame> frames = Frames(durations);
+    const SpriteTimeline timeline(frames);
+
+    for (int tick = 0; tick < 3 * timeline.cycle_ticks(); ++tick) {
+      ASSERT_EQ(timeline.FrameIndexAt(tick), FrameAfterStepping(frames, tick))
+          << "trial " << trial << " tick " << tick;
+    }
+  }
+}
+
+TEST(SpriteTimelineTest, ABatchMatchesOneAtATime) {
+  const SpriteTimeline timeline(Frames({3, 1, 4, 1, 5}));
+  std::vector<int64_t> starts;
+  for (int64_t start = -40; start < 40; start += 3) starts.push_back(start);
+  std::vector<int> indices(starts.size());
+
+  timeline.FrameIndicesAt(1000, starts, absl::MakeSpan(indices));
+
+  for (size_t i = 0; i < starts.size(); ++i) {
+    EXPECT_EQ(indices[i], timeline.FrameIndexAt(1000 - starts[i])) << "start " << starts[i];
+  }
+}
+
+}  // namespace
+}  // namespace zebes
@@ -0,0 +1,174 @@
+#include "objects/tile_chunk.h"
+
+#include <array>
+#include <cstddef>
+#include <random>
+
+#include "gtest/gtest.h"
+
+namespace zebes {
+namespace {
+
+constexpr int kCells = TileChunk::kCells;
+
+std::array<int, kCells> Cells(const TileChunk& chunk) {
+  std::array<int, kCells> cells;
+  for (int index = 0; index < kCells; ++index) cells[index] = chunk.tile(index);
+  return cells;
+}
+
+TEST(TileChunkTest, ADefaultChunkIsEmptyAndAllocatesNothing) {
+  TileChunk chunk;
+
+  EXPECT_TRUE(chunk.empty());
+  EXPECT_EQ(chunk.encoding(), TileChunk::Encoding::kEmpty);
+  EXPECT_EQ(chunk.heap_bytes(), 0u);
+  EXPECT_EQ(chunk.tile(0), 0);
+  EXPECT_EQ(chunk.tile(kCells - 1), 0);
+}
+
+TEST(TileChunkTest, AFilledChunkIsUniform) {
+  TileChunk chunk;
+  chunk.Fill(7);
+
+  EXPECT_EQ(chunk.encoding(), TileChunk::Encoding::kUniform);
+  EXPECT_EQ(chunk.occupied(), kCells);
+  EXPECT_EQ(chunk.CountOf(7), kCells);
+  EXPECT_EQ(chunk.tile(500), 7);
+  EXPECT_LE(chunk.heap_bytes(), sizeof(int) * 2);
+
+  chunk.Fill(0);
+  EXPECT_TRUE(chunk.empty());
+}
+
+TEST(TileChunkTest, IndicesWidenAsDistinctTilesArrive) {
+  TileChunk chunk;
+  chunk.SetTile(0, 1);
+  EXPECT_EQ(chunk.encoding(), TileChunk::Encoding::kPalette4);
+
+  // Zero is a palette entry too, so fifteen more tiles fill four bits.
+  for (int tile = 2; tile <= 15; ++tile) chunk.SetTile(tile, tile);
+  EXPECT_EQ(chunk.encoding(), TileChunk::Encoding::kPalette4);
+  chunk.SetTile(16, 16);
+  EXPECT_EQ(chunk.encoding(), TileChunk::Encoding::kPalette8);
+
+  for (int tile = 17; tile <= 300; ++tile) chunk.SetTile(tile, tile);
+  EXPECT_EQ(chunk.encoding(), TileChunk::Encoding::kPalette16);
+  EXPECT_EQ(chunk.tile(0), 1);
+  EXPECT_EQ(chunk.tile(1), 0);
+  for (int tile = 2; tile <= 300; ++tile) EXPECT_EQ(chunk.tile(tile), tile);
+  EXPECT_EQ(chunk.occupied(), 300);
+}
+
+TEST(TileChunkTest, AFullPaletteDropsUnusedEntriesBeforeWidening) {
+  TileChunk chunk;
+  // Paint sixteen distinct tiles into one cell, one after another: only the
+  // last is still used, so the palette never needs more than four bits.
+  for (int tile = 1; tile <= 40; ++tile) chunk.SetTile(3, tile);
+
+  EXPECT_EQ(chunk.encoding(), TileChunk::Encoding::kPalette4);
+  EXPECT_EQ(chunk.tile(3), 40);
+  EXPECT_EQ(chunk.occupied(), 1);
+}
+
+TEST(TileChunkTest, ErasingTheLastTileEmptiesTheChunk) {
+  TileChunk chunk;
+  chunk.SetTile(10, 4);
+  chunk.SetTile(11, 5);
+  chunk.SetTile(10, 0);
+  chunk.SetTile(11, 0);
+
+  EXPECT_TRUE(chunk.empty());
+  EXPECT_EQ(chunk.encoding(), TileChunk::Encoding::kEmpty);
+  EXPECT_EQ(chunk.heap_bytes(), 0u);
+}
+
+TEST(TileChunkTest, CompactFindsTheSmallestEncoding) {
+  TileChunk chunk;
+  for (int index = 0; index < kCells; ++index) chunk.SetTile(index, index % 300 + 1);
+  ASSERT_EQ(chunk.encoding(), TileChunk::Encoding::kPalette16);
+
+  for (int index = 0; index < kCells; ++index) chunk.SetTile(index, 9);
+  chunk.Compact();
+
+  EXPECT_EQ(chunk.encoding(), TileChunk::Encoding::kUniform);
+  EXPECT_EQ(chunk.tile(123), 9);
+}
+
+TEST(TileChunkTest, EqualityIsOverCellsNotEncodings) {
+  TileChunk uniform;
+  uniform.Fill(3);
+  TileChunk painted;
+  for (int index = 0; index < kCells; ++index) painted.SetTile(index, 3);
+  ASSERT_NE(painted.encoding(), uniform.encoding());
+
+  EXPECT_EQ(painted, uniform);
+  painted.SetTile(0, 4);
+  EXPECT_NE(painted, uniform);
+}
+
+TEST(TileChunkTest, MatchesADenseArrayUnderRandomWrites) {
+  std::mt19937 random(7);
+  std::uniform_int_distribution<int> cell(0, kCells - 1);
+  // Mostly a few tiles, occasionally many, with plenty of erasing.
+  std::uniform_int_distribution<int> common(0, 6);
+  std::uniform_int_distribution<int> rare(0, 600);
+  std::array<int, kCells> expected{};
+  TileChunk chunk;
+
+  for (int write = 0; write < 20000; ++write) {
+    const int index = cell(random);
+    const int tile = write % 9 == 0 ? rare(random) : common(random);
+    expected[index] = tile;
+    chunk.SetTile(index, tile);
+  }
+
+  EXPECT_EQ(Cells(chunk), expected);
+  EXPECT_EQ(chunk.ToArray(), expected);
+  EXPECT_EQ(TileChunk(expected), chunk);
+  int occupied = 0;
+  for (const int tile : expected) occupied += tile != 0 ? 1 : 0;
+  EXPECT_EQ(chunk.occupied(), occupied);
+}
+
+TEST(TileChunkTest, ForEachTileVisitsOccupiedCellsInOrder) {
+  TileChunk chunk;
+  chunk.SetTile(900, 2);
+  chunk.SetTile(5, 1);
+
+  std::vector<std::pair<int, int>> visited;
+  chunk.ForEachTile([&](int index, int tile) { visited.emplace_back(index, tile); });
+
+  EXPECT_EQ(visited, (std::vector<std::pair<int, int>>{{5, 1}, {900, 2}}));
+}
+
+TEST(TileChunkTest, TypicalChunksTakeAFractionOfTheirDenseSize) {
+  // A level's typical chunks: solid ground, a platform row, a scattering of
+  // decoration. What used to be a 4 KB array each.
+  std::vector<TileChunk> chunks(300);
+  for (size_t i = 0; i < chunks.size(); ++i) {
+    TileChunk& chunk = chunks[i];
+    switch (i % 3) {
+      case 0:
+        chunk.Fill(1);
+        break;
+      case 1:
+        for (int x = 0; x < TileChunk::kSize; ++x) {
+          chunk.SetTile(20 * TileChunk::kSize + x, 2 + x % 3);
+        }
+        break;
+      default:
+        for (int index = 0; index < kCells; index += 97) chunk.SetTile(index, 10);
+        break;
+    }
+  }
+
+  size_t compact = 0;
+  for (const TileChunk& chunk : chunks) compact += sizeof(TileChunk) + chunk.heap_bytes();
+  const size_t dense = chunks.size() * sizeof(std::array<int, kCells>);
+
+  EXPECT_LT(compact * 6, dense) << compact << " vs " << dense;
+}
+
+}  // namespace
+}  // namespace zebes
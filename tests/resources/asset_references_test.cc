@@ -50,7 +50,7 @@ Level LevelWithTiles(std::string id, std::string name, std::string tileset_id,
   level.name = std::move(name);
   level.tileset_id = std::move(tileset_id);
   TileChunk chunk;
-  for (size_t i = 0; i < painted.size(); ++i) chunk.tiles[i] = painted[i];
+  for (size_t i = 0; i < painted.size(); ++i) chunk.SetTile(static_cast<int>(i), painted[i]);
   level.layers.front().tile_chunks[0] = chunk;
   return level;
 }
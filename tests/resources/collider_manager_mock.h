@@ -18,6 +18,8 @@ class ColliderManagerMock : public ColliderManager {
   MOCK_METHOD(absl::StatusOr<std::string>, CreateCollider, (Collider collider), (override));
   MOCK_METHOD(absl::Status, SaveCollider, (Collider collider), (override));
   MOCK_METHOD(absl::StatusOr<Collider*>, GetCollider, (const std::string& id), (override));
+  MOCK_METHOD(absl::StatusOr<const ColliderGeometry*>, GetColliderGeometry, (const std::string& id),
+              (override));
   MOCK_METHOD(absl::Status, DeleteCollider, (const std::string& id), (override));
   MOCK_METHOD(std::vector<Collider>, GetAllColliders, (), (const, override));
 };
@@ -123,6 +123,29 @@ TEST_F(ColliderManagerTest, SavingKeepsPointersHandedOutBeforeIt) {
   EXPECT_EQ(held->name, "Renamed");
 }
 
+TEST_F(ColliderManagerTest, GeometryFollowsTheColliderThroughSaveAndDelete) {
+  Collider collider;
+  collider.name = "Shaped";
+  collider.polygons.push_back({{0, 0}, {10, 0}, {10, 10}, {0, 10}});
+  ASSERT_OK_AND_ASSIGN(std::string id, manager_->CreateCollider(collider));
+  ASSERT_OK_AND_ASSIGN(const ColliderGeometry* geometry, manager_->GetColliderGeometry(id));
+  ASSERT_EQ(geometry->pieces.size(), 1);
+  EXPECT_EQ(geometry->bounds.max, (Vec{10, 10}));
+
+  // An L-shaped edit is concave, so it comes back in pieces, at the same address.
+  ASSERT_OK_AND_ASSIGN(Collider * held, manager_->GetCollider(id));
+  Collider edited = *held;
+  edited.polygons = {{{0, 0}, {30, 0}, {30, 10}, {10, 10}, {10, 30}, {0, 30}}};
+  ASSERT_OK(manager_->SaveCollider(edited));
+  ASSERT_OK_AND_ASSIGN(const ColliderGeometry* after, manager_->GetColliderGeometry(id));
+  EXPECT_EQ(after, geometry);
+  EXPECT_GT(geometry->pieces.size(), 1);
+  EXPECT_EQ(geometry->bounds.max, (Vec{30, 30}));
+
+  ASSERT_OK(manager_->DeleteCollider(id));
+  EXPECT_FALSE(manager_->GetColliderGeometry(id).ok());
+}
+
 TEST_F(ColliderManagerTest, DeleteCollider) {
   Collider collider;
   // collider.id = "delete-test"; // ID is generated
@@ -0,0 +1,85 @@
+#include "resources/json_file.h"
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include "absl/status/status.h"
+#include "gtest/gtest.h"
+#include "macros.h"
+#include "nlohmann/json.hpp"
+
+namespace zebes {
+namespace {
+
+constexpr char kRoot[] = "test_data/json_file_test";
+
+class JsonFileTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    std::filesystem::remove_all(kRoot);
+    std::filesystem::create_directories(kRoot);
+  }
+  void TearDown() override { std::filesystem::remove_all(kRoot); }
+
+  std::string Path(const std::string& name) { return std::string(kRoot) + "/" + name; }
+
+  void WriteText(const std::string& name, const std::string& text) {
+    std::ofstream(Path(name)) << text;
+  }
+};
+
+TEST_F(JsonFileTest, RoundTripsADocument) {
+  const nlohmann::json written = {{"name", "cave"}, {"size", 3}};
+  ASSERT_OK(WriteJsonFile(Path("nested/doc.json"), written));
+
+  nlohmann::json read;
+  ASSERT_OK(ReadJsonFile(Path("nested/doc.json"), [&read](const nlohmann::json& json) {
+    read = json;
+    return absl::OkStatus();
+  }));
+  EXPECT_EQ(read, written);
+}
+
+TEST_F(JsonFileTest, AMissingFileIsNotFound) {
+  const absl::Status status =
+      ReadJsonFile(Path("missing.json"), [](const nlohmann::json&) { return absl::OkStatus(); });
+  EXPECT_EQ(status.code(), absl::StatusCode::kNotFound);
+}
+
+TEST_F(JsonFileTest, AMalformedDocumentIsInvalid) {
+  WriteText("broken.json", R"({"name": )");
+  bool parsed = false;
+  const absl::Status status = ReadJsonFile(Path("broken.json"), [&parsed](const nlohmann::json&) {
+    parsed = true;
+    return absl::OkStatus();
+  });
+  EXPECT_EQ(status.code(), absl::StatusCode::kInvalidArgument);
+  EXPECT_FALSE(parsed);
+}
+
+TEST_F(JsonFileTest, AFieldTheParserCannotReadIsInvalid) {
+  WriteText("doc.json", R"({"size": "three"})");
+  const absl::Status missing = ReadJsonFile(Path("doc.json"), [](const nlohmann::json& json) {
+    json.at("name").get<std::string>();
+    return absl::OkStatus();
+  });
+  EXPECT_EQ(missing.code(), absl::StatusCode::kInvalidArgument);
+
+  const absl::Status mistyped = ReadJsonFile(Path("doc.json"), [](const nlohmann::json& json) {
+    json.at("size").get<int>();
+    return absl::OkStatus();
+  });
+  EXPECT_EQ(mistyped.code(), absl::StatusCode::kInvalidArgument);
+}
+
+TEST_F(JsonFileTest, TheParsersOwnStatusPassesThrough) {
+  WriteText("doc.json", R"({"size": 3})");
+  const absl::Status status = ReadJsonFile(Path("doc.json"), [](const nlohmann::json&) {
+    return absl::FailedPreconditionError("too small");
+  });
+  EXPECT_EQ(status, absl::FailedPreconditionError("too small"));
+}
+
+}  // namespace
+}  // namespace zebes
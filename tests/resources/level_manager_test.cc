@@ -69,8 +69,8 @@ TEST_F(LevelManagerTest, SerializationTest) {
 
   // Add Tile Chunk
   TileChunk chunk;
-  chunk.tiles[0] = 1;
-  chunk.tiles[1] = 2;
+  chunk.SetTile(0, 1);
+  chunk.SetTile(1, 2);
   level.layers.front().tile_chunks[0] = chunk;
 
   // Add Entity
@@ -104,7 +104,7 @@ TEST_F(LevelManagerTest, SerializationTest) {
   ASSERT_EQ(loaded->layers.size(), 1);
   EXPECT_EQ(loaded->layers.front().name, "Base");
   ASSERT_EQ(loaded->layers.front().tile_chunks.size(), 1);
-  EXPECT_EQ(loaded->layers.front().tile_chunks[0].tiles[0], 1);
+  EXPECT_EQ(loaded->layers.front().tile_chunks[0].tile(0), 1);
 
   ASSERT_EQ(loaded->layers.front().entities.size(), 1);
   const Entity& loaded_entity = loaded->layers.front().entities.at(123);
@@ -123,8 +123,8 @@ TEST_F(LevelManagerTest, WorldLayerOrderAndOwnershipSurviveRoundTrip) {
   };
   level.layers.front().name = "Background";
   level.layers.push_back(WorldLayer{.id = 5, .name = "Foreground"});
-  level.layers.front().tile_chunks[0].tiles[0] = 3;
-  level.layers.back().tile_chunks[0].tiles[0] = 9;
+  level.layers.front().tile_chunks[0].SetTile(0, 3);
+  level.layers.back().tile_chunks[0].SetTile(0, 9);
   ASSERT_OK(level.AddEntity(0, Entity{.id = 2, .sort_order = -1}));
   ASSERT_OK(level.AddEntity(5, Entity{.id = 8, .sort_order = 4}));
 
@@ -134,11 +134,11 @@ TEST_F(LevelManagerTest, WorldLayerOrderAndOwnershipSurviveRoundTrip) {
   ASSERT_EQ(loaded->layers.size(), 2u);
   EXPECT_EQ(loaded->layers[0].id, 0);
   EXPECT_EQ(loaded->layers[0].name, "Background");
-  EXPECT_EQ(loaded->layers[0].tile_chunks.at(0).tiles[0], 3);
+  EXPECT_EQ(loaded->layers[0].tile_chunks.at(0).tile(0), 3);
   EXPECT_TRUE(loaded->layers[0].entities.contains(2));
   EXPECT_EQ(loaded->layers[1].id, 5);
   EXPECT_EQ(loaded->layers[1].name, "Foreground");
-  EXPECT_EQ(loaded->layers[1].tile_chunks.at(0).tiles[0], 9);
+  EXPECT_EQ(loaded->layers[1].tile_chunks.at(0).tile(0), 9);
   EXPECT_TRUE(loaded->layers[1].entities.contains(8));
 }
 
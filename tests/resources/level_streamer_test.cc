@@ -0,0 +1,311 @@
+#include "resources/level_streamer.h"
+
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "macros.h"
+#include "objects/level_region.h"
+#include "resources/level_region_store.h"
+
+namespace zebes {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::HasSubstr;
+
+constexpr char kRoot[] = "test_data/level_streamer_test";
+constexpr char kLevelId[] = "streamed";
+// Two chunks to a region side: one region is 1,024 pixels square.
+constexpr int kRegionChunks = 2;
+constexpr double kRegionPixels = kRegionChunks * TileChunk::kSize * 16;
+
+// The middle of region (x, y).
+Vec RegionCenter(int x, int y) {
+  return {.x = (x + 0.5) * kRegionPixels, .y = (y + 0.5) * kRegionPixels};
+}
+
+// A row of six regions, (0, 0) to (5, 0), each holding one chunk painted with
+// its own tile and one entity.
+Level WorldLevel() {
+  Level level{.id = kLevelId, .name = "Streamed", .width = 6 * kRegionPixels,
+              .height = kRegionPixels};
+  WorldLayer& base = level.layers[0];
+  for (int region = 0; region < 6; ++region) {
+    TileChunk chunk;
+    chunk.Fill(region + 1);
+    base.tile_chunks.emplace(ChunkKey(region * kRegionChunks, 0), std::move(chunk));
+    const uint64_t id = region + 1;
+    base.entities.emplace(
+        id, Entity{.id = id, .transform = {.position = RegionCenter(region, 0)}});
+  }
+  return level;
+}
+
+class LevelStreamerTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    std::filesystem::remove_all(kRoot);
+    ASSERT_OK_AND_ASSIGN(store_, LevelRegionStore::Create(kRoot, kLevelId, kRegionChunks));
+    level_ = WorldLevel();
+    for (const LevelRegion& region : TakeAllRegions(level_, kRegionChunks)) {
+      ASSERT_OK(store_->Write(region));
+    }
+  }
+
+  void TearDown() override { std::filesystem::remove_all(kRoot); }
+
+  bool HoldsRegion(int x) const {
+    return level_.layers[0].tile_chunks.contains(ChunkKey(x * kRegionChunks, 0));
+  }
+
+  std::unique_ptr<LevelRegionStore> store_;
+  // The definition as split: layers with nothing in them.
+  Level level_;
+};
+
+TEST_F(LevelStreamerTest, StoreRoundTripsRegions) {
+  const Level world = WorldLevel();
+  ASSERT_OK_AND_ASSIGN(const std::vector<LevelRegionCoordinate> listed, store_->List());
+  ASSERT_EQ(listed.size(), 6u);
+
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<LevelRegionStore> reopened,
+                       LevelRegionStore::Open(kRoot, kLevelId));
+  EXPECT_EQ(reopened->region_chunks(), kRegionChunks);
+  EXPECT_EQ(reopened->next_entity_id(), 7u);
+  for (const LevelRegionCoordinate& coordinate : listed) {
+    ASSERT_OK_AND_ASSIGN(const LevelRegion region, reopened->Read(coordinate));
+    EXPECT_EQ(region, CopyRegion(world, coordinate, kRegionChunks));
+  }
+
+  ASSERT_OK_AND_ASSIGN(const LevelRegion missing, reopened->Read({.x = 9, .y = 9}));
+  EXPECT_TRUE(missing.empty());
+  ASSERT_OK(reopened->Write(LevelRegion{.coordinate = {.x = 0, .y = 0}}));
+  ASSERT_OK_AND_ASSIGN(const std::vector<LevelRegionCoordinate> remaining, reopened->List());
+  EXPECT_EQ(remaining.size(), 5u);
+}
+
+TEST_F(LevelStreamerTest, StoreRefusesToSplitTwice) {
+  EXPECT_EQ(LevelRegionStore::Create(kRoot, kLevelId).status().code(),
+            absl::StatusCode::kAlreadyExists);
+  EXPECT_EQ(LevelRegionStore::Open(kRoot, "unsplit").status().code(),
+            absl::StatusCode::kNotFound);
+  EXPECT_EQ(LevelRegionStore::Create(kRoot, "other", 0).status().code(),
+            absl::StatusCode::kInvalidArgument);
+}
+
+TEST_F(LevelStreamerTest, RejectsInvalidOptions) {
+  EXPECT_EQ(LevelStreamer::Create(&level_, store_.get(), {.residency_radius = -1}).status().code(),
+            absl::StatusCode::kInvalidArgument);
+  EXPECT_EQ(
+      LevelStreamer::Create(&level_, store_.get(), {.max_loads_in_flight = 0}).status().code(),
+      absl::StatusCode::kInvalidArgument);
+  EXPECT_EQ(LevelStreamer::Create(nullptr, store_.get()).status().code(),
+            absl::StatusCode::kInvalidArgument);
+}
+
+TEST_F(LevelStreamerTest, LoadsTheRegionsAroundTheFocus) {
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<LevelStreamer> streamer,
+                       LevelStreamer::Create(&level_, store_.get(),
+                                             {.residency_radius = 1, .max_loads_in_flight = 1}));
+  ASSERT_OK(streamer->Update(RegionCenter(2, 0)));
+  ASSERT_OK(streamer->WaitForLoads());
+  // Only one read was allowed in flight; later updates start the rest.
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_OK(streamer->Update(RegionCenter(2, 0)));
+    ASSERT_OK(streamer->WaitForLoads());
+  }
+
+  EXPECT_FALSE(HoldsRegion(0));
+  EXPECT_TRUE(HoldsRegion(1));
+  EXPECT_TRUE(HoldsRegion(2));
+  EXPECT_TRUE(HoldsRegion(3));
+  EXPECT_FALSE(HoldsRegion(4));
+  EXPECT_TRUE(streamer->IsResident({.x = 2, .y = 1}));
+  EXPECT_FALSE(streamer->IsResident({.x = 4, .y = 0}));
+
+  const Level world = WorldLevel();
+  for (int x = 1; x <= 3; ++x) {
+    EXPECT_EQ(CopyRegion(level_, {.x = x, .y = 0}, kRegionChunks),
+              CopyRegion(world, {.x = x, .y = 0}, kRegionChunks));
+  }
+  // Three reads; the six empty regions around them needed none.
+  EXPECT_EQ(streamer->stats().resident_regions, 9);
+  EXPECT_EQ(streamer->stats().loads_in_flight, 0);
+  EXPECT_GT(streamer->stats().resident_bytes, 0u);
+}
+
+TEST_F(LevelStreamerTest, EvictsFarthestFirstOnceOverBudget) {
+  // Every region holds the same, so this is room for four of them.
+  ASSERT_OK_AND_ASSIGN(const LevelRegion sample, store_->Read({.x = 0, .y = 0}));
+  const size_t budget = 4 * sample.EstimatedBytes();
+  ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<LevelStreamer> streamer,
+      LevelStreamer::Create(&level_, store_.get(),
+                            {.residency_radius = 1, .memory_budget_bytes = budget}));
+
+  // Moving two regions right leaves two behind; only the farther has to go.
+  ASSERT_OK(streamer->Update(RegionCenter(1, 0)));
+  ASSERT_OK(streamer->WaitForLoads());
+  ASSERT_OK(streamer->Update(RegionCenter(3, 0)));
+  ASSERT_OK(streamer->WaitForLoads());
+  ASSERT_OK(streamer->Update(RegionCenter(3, 0)));
+
+  EXPECT_FALSE(HoldsRegion(0));
+  EXPECT_TRUE(HoldsRegion(1));
+  EXPECT_TRUE(HoldsRegion(2));
+  EXPECT_TRUE(HoldsRegion(4));
+  EXPECT_EQ(FindEntity(level_, 1), nullptr);
+  EXPECT_NE(FindEntity(level_, 2), nullptr);
+  EXPECT_LE(streamer->stats().resident_bytes, budget);
+  // Nothing was edited, so nothing was written.
+  EXPECT_EQ(streamer->stats().regions_written, 0);
+}
+
+TEST_F(LevelStreamerTest, KeepsEditedRegionsResidentUntilCommit) {
+  ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<LevelStreamer> streamer,
+      LevelStreamer::Create(&level_, store_.get(),
+                            {.residency_radius = 0, .memory_budget_bytes = 0}));
+  ASSERT_OK(streamer->Update(RegionCenter(0, 0)));
+  ASSERT_OK(streamer->WaitForLoads());
+  ASSERT_TRUE(HoldsRegion(0));
+  ASSERT_OK_AND_ASSIGN(const LevelRegion stored, store_->Read({.x = 0, .y = 0}));
+
+  level_.layers[0].tile_chunks.at(ChunkKey(0, 0)).SetTile(0, 42);
+  ASSERT_OK_AND_ASSIGN(const uint64_t id, streamer->NextAvailableEntityId());
+  ASSERT_OK(level_.AddEntity(0, Entity{.id = id, .transform = {.position = {.x = 5, .y = 5}}}));
+
+  ASSERT_OK(streamer->Update(RegionCenter(5, 0)));
+  ASSERT_OK(streamer->WaitForLoads());
+  ASSERT_OK(streamer->Update(RegionCenter(5, 0)));
+  // Out of range and over budget, but edited: it stays, and disk is untouched.
+  EXPECT_TRUE(HoldsRegion(0));
+  EXPECT_TRUE(streamer->IsResident({.x = 0, .y = 0}));
+  EXPECT_EQ(streamer->stats().regions_written, 0);
+  ASSERT_OK_AND_ASSIGN(const LevelRegion untouched, store_->Read({.x = 0, .y = 0}));
+  EXPECT_EQ(untouched, stored);
+
+  ASSERT_OK(streamer->Commit());
+  EXPECT_EQ(streamer->stats().regions_written, 1);
+  ASSERT_OK_AND_ASSIGN(const LevelRegion written, store_->Read({.x = 0, .y = 0}));
+  ASSERT_EQ(written.layers.size(), 1u);
+  EXPECT_EQ(written.layers[0].tile_chunks.at(ChunkKey(0, 0)).tile(0), 42);
+  EXPECT_TRUE(written.layers[0].entities.contains(id));
+  EXPECT_TRUE(written.layers[0].entities.contains(1));
+
+  // Committed, it can go like any other.
+  ASSERT_OK(streamer->Update(RegionCenter(5, 0)));
+  EXPECT_FALSE(HoldsRegion(0));
+}
+
+TEST_F(LevelStreamerTest, NewEntityIdsAvoidEveryRegionOnDisk) {
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<LevelStreamer> streamer,
+                       LevelStreamer::Create(&level_, store_.get()));
+  ASSERT_OK_AND_ASSIGN(const uint64_t resident_only, NextAvailableEntityId(level_));
+  EXPECT_EQ(resident_only, 1u);
+  ASSERT_OK_AND_ASSIGN(const uint64_t id, streamer->NextAvailableEntityId());
+  EXPECT_EQ(id, 7u);
+}
+
+TEST_F(LevelStreamerTest, CommitMergesStrayContentIntoItsRegion) {
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<LevelStreamer> streamer,
+                       LevelStreamer::Create(&level_, store_.get()));
+  // Placed in region (4, 0) without that region ever having been loaded.
+  ASSERT_OK_AND_ASSIGN(const uint64_t id, streamer->NextAvailableEntityId());
+  ASSERT_OK(level_.AddEntity(0, Entity{.id = id, .transform = {.position = RegionCenter(4, 0)}}));
+
+  ASSERT_OK(streamer->Commit());
+  EXPECT_TRUE(streamer->IsResident({.x = 4, .y = 0}));
+  EXPECT_EQ(streamer->stats().regions_written, 1);
+
+  ASSERT_OK_AND_ASSIGN(const LevelRegion written, store_->Read({.x = 4, .y = 0}));
+  ASSERT_EQ(written.layers.size(), 1u);
+  EXPECT_EQ(written.layers[0].tile_chunks.size(), 1u);
+  std::vector<uint64_t> ids;
+  for (const auto& [entity_id, entity] : written.layers[0].entities) ids.push_back(entity_id);
+  EXPECT_THAT(ids, ElementsAre(5, id));
+
+  // Committing again finds nothing changed.
+  ASSERT_OK(streamer->Commit());
+  EXPECT_EQ(streamer->stats().regions_written, 1);
+}
+
+TEST_F(LevelStreamerTest, CommitMergesStrayTilesIntoAStoredChunk) {
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<LevelStreamer> streamer,
+                       LevelStreamer::Create(&level_, store_.get()));
+  // Region (4, 0) stores a full chunk at (8, 0); this one beside it on disk is
+  // empty, so painting it must not cost the stored one.
+  TileChunk painted;
+  painted.SetTile(0, 9);
+  level_.layers[0].tile_chunks.emplace(ChunkKey(9, 0), painted);
+  level_.layers[0].tile_chunks.emplace(ChunkKey(8, 0), TileChunk());
+
+  ASSERT_OK(streamer->Commit());
+  ASSERT_OK_AND_ASSIGN(const LevelRegion written, store_->Read({.x = 4, .y = 0}));
+  ASSERT_EQ(written.layers.size(), 1u);
+  EXPECT_EQ(written.layers[0].tile_chunks.at(ChunkKey(8, 0)).occupied(), TileChunk::kCells);
+  EXPECT_EQ(written.layers[0].tile_chunks.at(ChunkKey(9, 0)), painted);
+}
+
+TEST_F(LevelStreamerTest, AConflictingRegionStaysUnloadedAndIntact) {
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<LevelStreamer> streamer,
+                       LevelStreamer::Create(&level_, store_.get()));
+  ASSERT_OK_AND_ASSIGN(const LevelRegion stored, store_->Read({.x = 4, .y = 0}));
+  // ID 5 is region (4, 0)'s entity on disk, taken as though from the level alone.
+  Vec position = RegionCenter(4, 0);
+  position.x += 1;
+  ASSERT_OK(level_.AddEntity(0, Entity{.id = 5, .transform = {.position = position}}));
+
+  const absl::Status committed = streamer->Commit();
+  EXPECT_EQ(committed.code(), absl::StatusCode::kFailedPrecondition);
+  EXPECT_THAT(committed.message(), HasSubstr("entity 5"));
+  EXPECT_FALSE(streamer->IsResident({.x = 4, .y = 0}));
+  EXPECT_EQ(streamer->stats().refused_regions, 1);
+  EXPECT_NE(FindEntity(level_, 5), nullptr);
+  // Nothing is written while a region is refused.
+  EXPECT_EQ(streamer->stats().regions_written, 0);
+  ASSERT_OK_AND_ASSIGN(const LevelRegion unchanged, store_->Read({.x = 4, .y = 0}));
+  EXPECT_EQ(unchanged, stored);
+}
+
+TEST_F(LevelStreamerTest, ARefusedRegionIsNotReadAgainAndInstallsOnceClear) {
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<LevelStreamer> streamer,
+                       LevelStreamer::Create(&level_, store_.get(), {.residency_radius = 0}));
+  Vec position = RegionCenter(4, 0);
+  position.x += 1;
+  ASSERT_OK(level_.AddEntity(0, Entity{.id = 5, .transform = {.position = position}}));
+  ASSERT_OK(streamer->Update(RegionCenter(4, 0)));
+  EXPECT_FALSE(streamer->WaitForLoads().ok());
+  ASSERT_EQ(streamer->stats().refused_regions, 1);
+
+  // Still in the way: reported again, but not read again.
+  EXPECT_FALSE(streamer->Update(RegionCenter(4, 0)).ok());
+  EXPECT_EQ(streamer->stats().loads_in_flight, 0);
+
+  // Renumbered, the stray entity no longer collides with the stored one.
+  Entity stray = level_.layers[0].entities.extract(5).mapped();
+  ASSERT_OK_AND_ASSIGN(stray.id, streamer->NextAvailableEntityId());
+  const uint64_t stray_id = stray.id;
+  level_.layers[0].entities.emplace(stray_id, std::move(stray));
+  ASSERT_OK(streamer->Update(RegionCenter(4, 0)));
+  EXPECT_EQ(streamer->stats().refused_regions, 0);
+  EXPECT_TRUE(streamer->IsResident({.x = 4, .y = 0}));
+  EXPECT_NE(FindEntity(level_, 5), nullptr);
+  EXPECT_NE(FindEntity(level_, stray_id), nullptr);
+  ASSERT_OK(streamer->Commit());
+}
+
+TEST_F(LevelStreamerTest, LoadAllRestoresTheWholeWorld) {
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<LevelStreamer> streamer,
+                       LevelStreamer::Create(&level_, store_.get()));
+  ASSERT_OK(streamer->LoadAll());
+  EXPECT_EQ(level_, WorldLevel());
+  EXPECT_EQ(streamer->stats().resident_regions, 6);
+}
+
+}  // namespace
+}  // namespace zebes
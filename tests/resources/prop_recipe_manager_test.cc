@@ -32,6 +32,8 @@ PropRecipe CompleteRecipe() {
   recipe.pipeline.source_limits.maximum_height = 2048;
   recipe.pipeline.source_limits.maximum_pixels = 4 * 1024 * 1024;
   recipe.pipeline.source_limits.maximum_bytes = 16 * 1024 * 1024;
+  recipe.pipeline.working_proxy.full_resolution = true;
+  recipe.pipeline.working_proxy.minimum_oversample = 4;
   recipe.pipeline.isolation.alpha_threshold = 20;
   recipe.pipeline.isolation.background_distance = 32.0f;
   recipe.pipeline.isolation.enclosed_background_distance = 6.0f;
@@ -20,6 +20,8 @@ class SpriteManagerMock : public SpriteManager {
   MOCK_METHOD(absl::Status, PreflightSpriteWithId, (const Sprite& sprite), (override));
   MOCK_METHOD(absl::Status, SaveSprite, (Sprite sprite), (override));
   MOCK_METHOD(absl::StatusOr<Sprite*>, GetSprite, (const std::string& id), (override));
+  MOCK_METHOD(absl::StatusOr<const SpriteTimeline*>, GetSpriteTimeline, (const std::string& id),
+              (override));
   MOCK_METHOD(absl::Status, DeleteSprite, (const std::string& id), (override));
   MOCK_METHOD(std::vector<Sprite>, GetAllSprites, (), (const, override));
 };
@@ -165,6 +165,32 @@ TEST_F(SpriteManagerTest, SavingKeepsPointersHandedOutBeforeIt) {
   EXPECT_EQ(held->name, "Renamed");
 }
 
+TEST_F(SpriteManagerTest, TimelineFollowsTheSpriteThroughSaveAndDelete) {
+  std::string tex_path = test_dir_ + "/textures/timed.png";
+  std::ofstream file(tex_path);
+  ASSERT_OK_AND_ASSIGN(std::string texture_id, texture_manager_->CreateTexture({.path = tex_path}));
+
+  Sprite sprite;
+  sprite.name = "Timed";
+  sprite.texture_id = texture_id;
+  sprite.frames = {{.index = 0, .frames_per_cycle = 2}, {.index = 1, .frames_per_cycle = 3}};
+  ASSERT_OK_AND_ASSIGN(std::string id, manager_->CreateSprite(sprite));
+  ASSERT_OK_AND_ASSIGN(const SpriteTimeline* timeline, manager_->GetSpriteTimeline(id));
+  EXPECT_EQ(timeline->cycle_ticks(), 5);
+
+  ASSERT_OK_AND_ASSIGN(Sprite * held, manager_->GetSprite(id));
+  Sprite edited = *held;
+  edited.frames.push_back({.index = 2, .frames_per_cycle = 4});
+  ASSERT_OK(manager_->SaveSprite(edited));
+  ASSERT_OK_AND_ASSIGN(const SpriteTimeline* after, manager_->GetSpriteTimeline(id));
+  EXPECT_EQ(after, timeline);
+  EXPECT_EQ(timeline->cycle_ticks(), 9);
+  EXPECT_EQ(timeline->FrameIndexAt(5), 2);
+
+  ASSERT_OK(manager_->DeleteSprite(id));
+  EXPECT_FALSE(manager_->GetSpriteTimeline(id).ok());
+}
+
 TEST_F(SpriteManagerTest, DeleteSprite) {
   Sprite sprite;
   auto tex_path = test_dir_ + "/textures/t2.png";
@@ -30,6 +30,9 @@ class TextureManagerMock : public TextureManager {
               (const std::string& id, int width, int height, absl::Span<const uint8_t> pixels),
               (override));
   MOCK_METHOD(absl::StatusOr<RgbaImage>, ReadTexturePixels, (const std::string& id), (override));
+  MOCK_METHOD(absl::StatusOr<TextureHandle>, LoadTransientTexture,
+              (int width, int height, absl::Span<const uint8_t> pixels), (override));
+  MOCK_METHOD(void, UnloadTransientTexture, (TextureHandle handle), (override));
   MOCK_METHOD(absl::StatusOr<Texture*>, GetTexture, (const std::string& id), (override));
   MOCK_METHOD(absl::StatusOr<TextureHandle>, GetTextureHandle, (const std::string& id),
               (const, override));
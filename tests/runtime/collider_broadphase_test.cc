@@ -0,0 +1,94 @@
+#include "runtime/collider_broadphase.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "macros.h"
+
+namespace zebes {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+using ::testing::UnorderedElementsAreArray;
+
+ColliderBounds Box(double x, double y, double width, double height) {
+  return {.min = {.x = x, .y = y}, .max = {.x = x + width, .y = y + height}};
+}
+
+std::vector<BroadphasePair> BruteForce(const std::vector<ColliderBounds>& boxes) {
+  std::vector<BroadphasePair> pairs;
+  for (uint32_t a = 0; a < boxes.size(); ++a) {
+    for (uint32_t b = a + 1; b < boxes.size(); ++b) {
+      if (boxes[a].Overlaps(boxes[b])) pairs.push_back({.first = a, .second = b});
+    }
+  }
+  return pairs;
+}
+
+TEST(ColliderBroadphaseTest, ReportsOverlapsButNotTouches) {
+  ASSERT_OK_AND_ASSIGN(ColliderBroadphase broadphase, ColliderBroadphase::Create(16));
+  // 0 and 1 overlap; 2 only touches 1 along an edge; 3 is far away.
+  const std::vector<ColliderBounds> boxes = {Box(0, 0, 10, 10), Box(5, 5, 10, 10),
+                                             Box(15, 5, 10, 10), Box(200, 200, 4, 4)};
+
+  EXPECT_THAT(broadphase.FindPairs(boxes), ElementsAre(BroadphasePair{.first = 0, .second = 1}));
+}
+
+TEST(ColliderBroadphaseTest, HandlesTooFewBoxes) {
+  ASSERT_OK_AND_ASSIGN(ColliderBroadphase broadphase, ColliderBroadphase::Create(16));
+  EXPECT_THAT(broadphase.FindPairs({}), IsEmpty());
+  EXPECT_THAT(broadphase.FindPairs({Box(0, 0, 4, 4)}), IsEmpty());
+}
+
+TEST(ColliderBroadphaseTest, RejectsANonPositiveCellSize) {
+  EXPECT_EQ(ColliderBroadphase::Create(0).status().code(), absl::StatusCode::kInvalidArgument);
+  EXPECT_EQ(ColliderBroadphase::Create(-8).status().code(), absl::StatusCode::kInvalidArgument);
+}
+
+// Mostly small movers, with a few boxes spanning much of the world and a
+// cluster stacked in one spot, over frames that move everything, matched
+// against testing every pair.
+TEST(ColliderBroadphaseTest, MatchesTestingEveryPair) {
+  ASSERT_OK_AND_ASSIGN(ColliderBroadphase broadphase, ColliderBroadphase::Create(24));
+  std::mt19937 random(7);
+  std::uniform_real_distribution<double> position(0, 2000);
+  std::uniform_real_distribution<double> size(0, 40);
+  std::uniform_real_distribution<double> large(200, 1500);
+  std::uniform_real_distribution<double> motion(-30, 30);
+  std::vector<ColliderBounds> boxes;
+  for (int i = 0; i < 1500; ++i) {
+    boxes.push_back(Box(position(random), position(random), size(random), size(random)));
+  }
+  for (int i = 0; i < 6; ++i) {
+    boxes.push_back(Box(position(random), position(random), large(random), large(random)));
+  }
+  for (int i = 0; i < 30; ++i) boxes.push_back(Box(1000, 1000, 8, 8));
+
+  for (int frame = 0; frame < 5; ++frame) {
+    const std::vector<BroadphasePair> expected = BruteForce(boxes);
+    absl::Span<const BroadphasePair> pairs = broadphase.FindPairs(boxes);
+    for (const BroadphasePair& pair : pairs) ASSERT_LT(pair.first, pair.second);
+    EXPECT_THAT(pairs, UnorderedElementsAreArray(expected)) << "frame " << frame;
+    EXPECT_GT(expected.size(), 435u);
+
+    for (ColliderBounds& box : boxes) {
+      box = box.Translated({.x = motion(random), .y = motion(random)});
+    }
+  }
+}
+
+TEST(ColliderBroadphaseTest, ALineOfBoxesCoarsensTheGridWithoutMissingPairs) {
+  ASSERT_OK_AND_ASSIGN(ColliderBroadphase broadphase, ColliderBroadphase::Create(0.5));
+  std::vector<ColliderBounds> boxes;
+  for (int i = 0; i < 400; ++i) boxes.push_back(Box(i * 30, 0, 40, 10));
+
+  EXPECT_THAT(broadphase.FindPairs(boxes), UnorderedElementsAreArray(BruteForce(boxes)));
+}
+
+}  // namespace
+}  // namespace zebes
@@ -0,0 +1,328 @@
+#include "runtime/level_bundle.h"
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "gtest/gtest.h"
+#include "macros.h"
+#include "runtime/level_bundle_compiler.h"
+
+namespace zebes {
+namespace {
+
+// Assets held in plain maps, counting pixel reads.
+class FakeAssets : public LevelBundleAssetSource {
+ public:
+  absl::StatusOr<const Tileset*> GetTileset(const std::string& id) override {
+    return Find(tilesets, id);
+  }
+  absl::StatusOr<const Sprite*> GetSprite(const std::string& id) override {
+    return Find(sprites, id);
+  }
+  absl::StatusOr<const Collider*> GetCollider(const std::string& id) override {
+    return Find(colliders, id);
+  }
+  absl::StatusOr<const Blueprint*> GetBlueprint(const std::string& id) override {
+    return Find(blueprints, id);
+  }
+  absl::StatusOr<RgbaImage> ReadTexturePixels(const std::string& id) override {
+    ++pixel_reads;
+    absl::StatusOr<const RgbaImage*> image = Find(textures, id);
+    if (!image.ok()) return image.status();
+    return **image;
+  }
+
+  absl::flat_hash_map<std::string, Tileset> tilesets;
+  absl::flat_hash_map<std::string, Sprite> sprites;
+  absl::flat_hash_map<std::string, Collider> colliders;
+  absl::flat_hash_map<std::string, Blueprint> blueprints;
+  absl::flat_hash_map<std::string, RgbaImage> textures;
+  int pixel_reads = 0;
+
+ private:
+  template <typename T>
+  static absl::StatusOr<const T*> Find(const absl::flat_hash_map<std::string, T>& assets,
+                                       const std::string& id) {
+    auto it = assets.find(id);
+    if (it == assets.end()) return absl::NotFoundError(absl::StrCat("no asset ", id));
+    return &it->second;
+  }
+};
+
+RgbaImage SolidImage(int width, int height, uint8_t value) {
+  return RgbaImage{.width = width,
+                   .height = height,
+                   .pixels = std::vector<uint8_t>(static_cast<size_t>(width) * height * 4, value)};
+}
+
+void AddAssets(FakeAssets& assets) {
+  assets.textures["atlas"] = SolidImage(4, 2, 7);
+  assets.textures["hero-sheet"] = SolidImage(3, 1, 9);
+  assets.textures["sky"] = SolidImage(1, 1, 200);
+  assets.tilesets["ground"] = Tileset{
+      .id = "ground",
+      .name = "Ground",
+      .texture_id = "atlas",
+      .tile_width = 8,
+      .tile_height = 8,
+      .tiles = {Tile{.id = 1, .name = "Dirt", .source_x = 0, .tags = {"solid"}},
+                Tile{.id = 4,
+                     .name = "Ledge",
+                     .source_x = 8,
+                     .shape = TileShape::kHalfBlockBottom,
+                     .is_one_way = true,
+                     .tags = {"solid", "ledge"}}},
+  };
+  assets.sprites["hero"] = Sprite{
+      .id = "hero",
+      .name = "Hero",
+      .texture_id = "hero-sheet",
+      .frames = {SpriteFrame{.index = 0, .texture_w = 1, .frames_per_cycle = 3},
+                 SpriteFrame{.index = 1, .texture_x = 1, .texture_w = 1, .frames_per_cycle = 5}},
+  };
+  assets.colliders["box"] = Collider{
+      .id = "box",
+      .name = "Box",
+      .polygons = {{{.x = 0, .y = 0}, {.x = 4, .y = 0}, {.x = 4, .y = 4}}},
+  };
+  assets.blueprints["door"] = Blueprint{
+      .id = "door",
+      .name = "Door",
+      .states = {{.name = "shut", .collider_id = "box", .sprite_id = "hero"}, {.name = "open"}},
+  };
+}
+
+Level MakeLevel() {
+  Level level{
+      .id = "level-1", .name = "Caves", .tileset_id = "ground", .width = 1024, .height = 3072};
+  level.spawn_point = {.x = 12, .y = 34};
+  level.layers.push_back(WorldLayer{.id = 3, .name = "Front"});
+  TileChunk near;
+  near.SetTile(0, 1);
+  near.SetTile(33, 4);
+  level.layers[0].tile_chunks[ChunkKey(1, 0)] = near;
+  TileChunk far;
+  far.Fill(4);
+  level.layers[0].tile_chunks[ChunkKey(0, 5)] = far;
+  // Empty chunks are not worth shipping.
+  level.layers[0].tile_chunks[ChunkKey(0, 0)] = TileChunk();
+  level.layers[0].entities[7] = Entity{.id = 7,
+                                       .transform = {.position = {.x = 1, .y = 2}},
+                                       .body = {.mass = 3, .is_static = true},
+                                       .sprite_id = "hero",
+                                       .collider_id = "box"};
+  level.layers[1].entities[2] =
+      Entity{.id = 2, .blueprint_id = "door", .blueprint_state_index = 1, .sprite_id = "hero"};
+  level.themes[5] = ParallaxTheme{
+      .id = 5,
+      .name = "Dusk",
+      .layers = {{.name = "far sky", .texture_id = "sky", .scroll_factor = {.x = 0.25}}},
+  };
+  level.zones.push_back(ParallaxZone{
+      .id = 1, .name = "Outside", .theme_id = 5, .max_point = {.x = 100, .y = 50}});
+  return level;
+}
+
+absl::StatusOr<std::unique_ptr<LevelBundle>> CompileAndRead(const Level& level,
+                                                            FakeAssets& assets) {
+  absl::StatusOr<std::vector<uint8_t>> bytes = CompileLevelBundle(level, assets);
+  if (!bytes.ok()) return bytes.status();
+  return LevelBundle::FromBytes(*bytes);
+}
+
+TEST(LevelBundleTest, RoundTripsTheLevelAndWhatItReferences) {
+  FakeAssets assets;
+  AddAssets(assets);
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<LevelBundle> bundle, CompileAndRead(MakeLevel(), assets));
+
+  EXPECT_EQ(bundle->String(bundle->level().id), "level-1");
+  EXPECT_EQ(bundle->String(bundle->level().name), "Caves");
+  EXPECT_EQ(bundle->level().width, 1024);
+  EXPECT_EQ(bundle->level().spawn_y, 34);
+  EXPECT_EQ(bundle->level().tile_width, 8);
+  ASSERT_NE(bundle->level().tile_atlas, kBundleNone);
+  const BundleTexture& atlas = bundle->textures()[bundle->level().tile_atlas];
+  EXPECT_EQ(bundle->String(atlas.id), "atlas");
+  EXPECT_EQ(bundle->Pixels(atlas), absl::MakeConstSpan(assets.textures["atlas"].pixels));
+
+  ASSERT_EQ(bundle->tiles().size(), 2);
+  const BundleTile& ledge = bundle->tiles()[1];
+  EXPECT_EQ(ledge.id, 4);
+  EXPECT_EQ(ledge.shape, static_cast<uint8_t>(TileShape::kHalfBlockBottom));
+  EXPECT_TRUE(ledge.is_one_way);
+  ASSERT_EQ(ledge.tag_count, 2);
+  EXPECT_EQ(bundle->String(bundle->tile_tags()[ledge.first_tag + 1]), "ledge");
+
+  ASSERT_EQ(bundle->layers().size(), 2);
+  const BundleLayer& base = bundle->layers()[0];
+  EXPECT_EQ(bundle->String(base.name), "Base");
+  // The empty chunk is dropped; the rest go in by row, then column.
+  ASSERT_EQ(base.chunk_count, 2);
+  EXPECT_EQ(bundle->chunks()[base.first_chunk].x, 1);
+  EXPECT_EQ(bundle->chunks()[base.first_chunk].y, 0);
+  EXPECT_EQ(bundle->chunks()[base.first_chunk + 1].y, 5);
+  absl::Span<const uint16_t> cells = bundle->ChunkCells(base.first_chunk);
+  EXPECT_EQ(bundle->tiles()[cells[0] - 1].id, 1);
+  EXPECT_EQ(bundle->tiles()[cells[33] - 1].id, 4);
+  EXPECT_EQ(cells[1], 0);
+
+  ASSERT_EQ(base.entity_count, 1);
+  const BundleEntity& statue = bundle->entities()[base.first_entity];
+  EXPECT_EQ(statue.id, 7);
+  EXPECT_EQ(statue.x, 1);
+  EXPECT_EQ(statue.mass, 3);
+  EXPECT_TRUE(statue.is_static);
+  EXPECT_EQ(statue.blueprint, kBundleNone);
+  const BundleSprite& hero = bundle->sprites()[statue.sprite];
+  EXPECT_EQ(bundle->String(hero.id), "hero");
+  ASSERT_EQ(hero.frame_count, 2);
+  EXPECT_EQ(bundle->sprite_frames()[hero.first_frame + 1].frames_per_cycle, 5);
+  const BundleCollider& box = bundle->colliders()[statue.collider];
+  ASSERT_EQ(box.polygon_count, 1);
+  const BundlePolygon& triangle = bundle->polygons()[box.first_polygon];
+  ASSERT_EQ(triangle.point_count, 3);
+  EXPECT_EQ(bundle->points()[triangle.first_point + 2].y, 4);
+
+  const BundleEntity& door = bundle->entities()[bundle->layers()[1].first_entity];
+  EXPECT_EQ(door.blueprint_state, 1);
+  const BundleBlueprint& blueprint = bundle->blueprints()[door.blueprint];
+  ASSERT_EQ(blueprint.state_count, 2);
+  const BundleBlueprintState& shut = bundle->blueprint_states()[blueprint.first_state];
+  EXPECT_EQ(bundle->String(shut.name), "shut");
+  EXPECT_EQ(shut.sprite, statue.sprite);
+  EXPECT_EQ(shut.collider, statue.collider);
+  EXPECT_EQ(bundle->blueprint_states()[blueprint.first_state + 1].sprite, kBundleNone);
+
+  ASSERT_EQ(bundle->parallax_zones().size(), 1);
+  const BundleParallaxZone& zone = bundle->parallax_zones()[0];
+  EXPECT_EQ(zone.max_x, 100);
+  const BundleParallaxTheme& theme = bundle->parallax_themes()[zone.theme];
+  EXPECT_EQ(bundle->String(theme.name), "Dusk");
+  ASSERT_EQ(theme.layer_count, 1);
+  const BundleParallaxLayer& sky = bundle->parallax_layers()[theme.first_layer];
+  EXPECT_EQ(sky.scroll_x, 0.25);
+  EXPECT_EQ(bundle->Pixels(bundle->textures()[sky.texture])[0], 200);
+}
+
+TEST(LevelBundleTest, StoresEachAssetOnce) {
+  FakeAssets assets;
+  AddAssets(assets);
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<LevelBundle> bundle, CompileAndRead(MakeLevel(), assets));
+
+  // The hero sprite is reached from two entities and a blueprint state.
+  EXPECT_EQ(bundle->sprites().size(), 1);
+  EXPECT_EQ(bundle->colliders().size(), 1);
+  EXPECT_EQ(bundle->textures().size(), 3);
+  EXPECT_EQ(assets.pixel_reads, 3);
+  // "solid" is two tiles' tag but one string.
+  EXPECT_EQ(bundle->tile_tags()[0].offset, bundle->tile_tags()[1].offset);
+}
+
+TEST(LevelBundleTest, CompilesTheSameLevelToTheSameBytes) {
+  FakeAssets assets;
+  AddAssets(assets);
+  Level level = MakeLevel();
+  ASSERT_OK_AND_ASSIGN(std::vector<uint8_t> first, CompileLevelBundle(level, assets));
+
+  // Rebuilding the chunk map with a different history changes its iteration
+  // order, which must not reach the output.
+  for (int x = 10; x < 200; ++x) level.layers[0].tile_chunks[ChunkKey(x, 9)] = TileChunk();
+  for (int x = 10; x < 200; ++x) level.layers[0].tile_chunks.erase(ChunkKey(x, 9));
+  ASSERT_OK_AND_ASSIGN(std::vector<uint8_t> second, CompileLevelBundle(level, assets));
+
+  EXPECT_EQ(first, second);
+}
+
+TEST(LevelBundleTest, RefusesReferencesThatDoNotResolve) {
+  FakeAssets assets;
+  AddAssets(assets);
+
+  Level missing_sprite = MakeLevel();
+  missing_sprite.layers[0].entities[7].sprite_id = "ghost";
+  EXPECT_EQ(CompileLevelBundle(missing_sprite, assets).status().code(),
+            absl::StatusCode::kNotFound);
+
+  Level missing_tile = MakeLevel();
+  missing_tile.layers[1].tile_chunks[ChunkKey(0, 0)].SetTile(5, 99);
+  EXPECT_EQ(CompileLevelBundle(missing_tile, assets).status().code(),
+            absl::StatusCode::kNotFound);
+
+  assets.blueprints["door"].states[1].collider_id = "nowhere";
+  EXPECT_EQ(CompileLevelBundle(MakeLevel(), assets).status().code(),
+            absl::StatusCode::kNotFound);
+}
+
+TEST(LevelBundleTest, RefusesDamagedOrForeignBytes) {
+  FakeAssets assets;
+  AddAssets(assets);
+  ASSERT_OK_AND_ASSIGN(const std::vector<uint8_t> bytes, CompileLevelBundle(MakeLevel(), assets));
+
+  std::vector<uint8_t> flipped = bytes;
+  flipped[bytes.size() - 9] ^= 0x10;
+  EXPECT_EQ(LevelBundle::FromBytes(flipped).status().code(), absl::StatusCode::kDataLoss);
+
+  std::vector<uint8_t> truncated(bytes.begin(), bytes.end() - 8);
+  EXPECT_EQ(LevelBundle::FromBytes(truncated).status().code(), absl::StatusCode::kDataLoss);
+
+  std::vector<uint8_t> newer = bytes;
+  BundleHeader header;
+  std::memcpy(&header, newer.data(), sizeof(header));
+  ++header.version;
+  std::memcpy(newer.data(), &header, sizeof(header));
+  EXPECT_EQ(LevelBundle::FromBytes(newer).status().code(),
+            absl::StatusCode::kFailedPrecondition);
+}
+
+TEST(LevelBundleTest, ChecksReferencesEvenWithoutTheChecksum) {
+  FakeAssets assets;
+  AddAssets(assets);
+  ASSERT_OK_AND_ASSIGN(std::vector<uint8_t> bytes, CompileLevelBundle(MakeLevel(), assets));
+
+  // Point the first entity at a sprite that is not there.
+  BundleHeader header;
+  std::memcpy(&header, bytes.data(), sizeof(header));
+  for (uint32_t i = 0; i < header.section_count; ++i) {
+    BundleSection section;
+    std::memcpy(&section, bytes.data() + sizeof(header) + i * sizeof(section), sizeof(section));
+    if (section.kind != BundleSectionKind::kEntities) continue;
+    BundleEntity entity;
+    std::memcpy(&entity, bytes.data() + section.offset, sizeof(entity));
+    entity.sprite = 40;
+    std::memcpy(bytes.data() + section.offset, &entity, sizeof(entity));
+  }
+
+  EXPECT_EQ(LevelBundle::FromBytes(bytes, {.verify_checksum = false}).status().code(),
+            absl::StatusCode::kDataLoss);
+}
+
+TEST(LevelBundleTest, OpensAFileByMappingIt) {
+  FakeAssets assets;
+  AddAssets(assets);
+  ASSERT_OK_AND_ASSIGN(const std::vector<uint8_t> bytes, CompileLevelBundle(MakeLevel(), assets));
+  const std::string path =
+      (std::filesystem::temp_directory_path() / "zebes-level-bundle-test.zblevel").string();
+  {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(bytes.data()),
+               static_cast<std::streamsize>(bytes.size()));
+  }
+
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<LevelBundle> bundle, LevelBundle::Open(path));
+  EXPECT_EQ(bundle->String(bundle->level().name), "Caves");
+  EXPECT_EQ(bundle->entities().size(), 2);
+  bundle.reset();
+  std::filesystem::remove(path);
+
+  EXPECT_EQ(LevelBundle::Open(path).status().code(), absl::StatusCode::kNotFound);
+}
+
+}  // namespace
+}  // namespace zebes
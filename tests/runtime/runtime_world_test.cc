@@ -0,0 +1,149 @@
+#include "runtime/runtime_world.h"
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+
+#include "absl/time/time.h"
+#include "gtest/gtest.h"
+#include "macros.h"
+
+namespace zebes {
+namespace {
+
+Entity MakeEntity(uint64_t id, Vec position, bool is_static = false) {
+  return Entity{
+      .id = id,
+      .transform = {.position = position},
+      .body = {.mass = 1, .is_static = is_static},
+  };
+}
+
+// A one-second step keeps the expected values exact.
+RuntimeWorldOptions WholeSecondSteps() {
+  return RuntimeWorldOptions{.timestep = absl::Seconds(1), .max_steps_per_advance = 4};
+}
+
+TEST(RuntimeWorldTest, PacksDynamicBodiesBeforeStaticOnesInLevelOrder) {
+  Level level;
+  level.layers.push_back(WorldLayer{.id = 1, .name = "Front"});
+  ASSERT_OK(level.AddEntity(1, MakeEntity(2, {.x = 20})));
+  ASSERT_OK(level.AddEntity(0, MakeEntity(5, {.x = 50}, /*is_static=*/true)));
+  ASSERT_OK(level.AddEntity(0, MakeEntity(3, {.x = 30})));
+  Entity removed = MakeEntity(4, {.x = 40});
+  removed.active = false;
+  ASSERT_OK(level.AddEntity(0, removed));
+
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<RuntimeWorld> world, RuntimeWorld::Create(level));
+
+  const RuntimeEntities& entities = world->entities();
+  EXPECT_EQ(entities.ids, (std::vector<uint64_t>{3, 2, 5}));
+  EXPECT_EQ(entities.dynamic_count, 2u);
+  EXPECT_EQ(entities.position_x, (std::vector<double>{30, 20, 50}));
+  EXPECT_EQ(world->IndexOf(5), std::optional<size_t>(2));
+  EXPECT_EQ(world->IndexOf(4), std::nullopt);
+}
+
+TEST(RuntimeWorldTest, StepsIntegrateVelocityBeforePosition) {
+  Level level;
+  ASSERT_OK(level.AddEntity(0, MakeEntity(1, {})));
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<RuntimeWorld> world,
+                       RuntimeWorld::Create(level, WholeSecondSteps()));
+  world->SetAcceleration(0, {.x = 2, .y = -1});
+
+  world->Step();
+  world->Step();
+
+  EXPECT_EQ(world->velocity(0), (Vec{.x = 4, .y = -2}));
+  // Semi-implicit Euler: 2 then 4, not 0 then 2.
+  EXPECT_EQ(world->position(0), (Vec{.x = 6, .y = -3}));
+  EXPECT_EQ(world->step_count(), 2);
+}
+
+TEST(RuntimeWorldTest, DragDampsEachAxisAndNeverReversesMotion) {
+  Level level;
+  Entity entity = MakeEntity(1, {});
+  entity.body.drag = {.x = 0.5, .y = 3};
+  ASSERT_OK(level.AddEntity(0, entity));
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<RuntimeWorld> world,
+                       RuntimeWorld::Create(level, WholeSecondSteps()));
+  world->SetVelocity(0, {.x = 8, .y = 8});
+
+  world->Step();
+
+  EXPECT_EQ(world->velocity(0), (Vec{.x = 4, .y = 0}));
+  EXPECT_EQ(world->position(0), (Vec{.x = 4, .y = 0}));
+}
+
+TEST(RuntimeWorldTest, StaticBodiesNeverMove) {
+  Level level;
+  ASSERT_OK(level.AddEntity(0, MakeEntity(1, {.x = 7, .y = 9}, /*is_static=*/true)));
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<RuntimeWorld> world,
+                       RuntimeWorld::Create(level, WholeSecondSteps()));
+
+  world->SetVelocity(0, {.x = 1, .y = 1});
+  world->SetAcceleration(0, {.x = 1, .y = 1});
+  world->Step();
+
+  EXPECT_EQ(world->position(0), (Vec{.x = 7, .y = 9}));
+  EXPECT_EQ(world->velocity(0), Vec{});
+}
+
+TEST(RuntimeWorldTest, AdvanceCarriesPartialStepsAndDropsAStalledBacklog) {
+  Level level;
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<RuntimeWorld> world,
+                       RuntimeWorld::Create(level, WholeSecondSteps()));
+
+  EXPECT_EQ(world->Advance(absl::Milliseconds(600)), 0);
+  EXPECT_DOUBLE_EQ(world->interpolation(), 0.6);
+  EXPECT_EQ(world->Advance(absl::Milliseconds(600)), 1);
+  EXPECT_DOUBLE_EQ(world->interpolation(), 0.2);
+
+  // Ten seconds owed, but only four steps are allowed. The fraction survives;
+  // the backlog does not.
+  EXPECT_EQ(world->Advance(absl::Milliseconds(10000)), 4);
+  EXPECT_DOUBLE_EQ(world->interpolation(), 0.2);
+  EXPECT_EQ(world->step_count(), 5);
+}
+
+TEST(RuntimeWorldTest, RejectsATimestepThatCannotAdvance) {
+  Level level;
+
+  EXPECT_FALSE(RuntimeWorld::Create(level, {.timestep = absl::ZeroDuration()}).ok());
+  EXPECT_FALSE(RuntimeWorld::Create(level, {.max_steps_per_advance = 0}).ok());
+  EXPECT_FALSE(RuntimeWorld::Create(level, {.worker_threads = -1}).ok());
+}
+
+TEST(RuntimeWorldTest, WorkerThreadsStepToTheSameState) {
+  Level level;
+  for (uint64_t id = 1; id <= 64; ++id) {
+    Entity entity = MakeEntity(id, {.x = id * 3.0, .y = id * -7.0}, /*is_static=*/id % 9 == 0);
+    entity.body.drag = {.x = 0.01 * id, .y = 0.5};
+    ASSERT_OK(level.AddEntity(0, entity));
+  }
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<RuntimeWorld> inline_world, RuntimeWorld::Create(level));
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<RuntimeWorld> pooled_world,
+                       RuntimeWorld::Create(level, {.worker_threads = 2}));
+  EXPECT_EQ(inline_world->scheduler(), nullptr);
+  ASSERT_NE(pooled_world->scheduler(), nullptr);
+
+  for (RuntimeWorld* world : {inline_world.get(), pooled_world.get()}) {
+    for (size_t i = 0; i < world->entities().size(); ++i) {
+      world->SetAcceleration(i, {.x = static_cast<double>(i), .y = 980});
+    }
+    for (int step = 0; step < 120; ++step) world->Step();
+  }
+
+  EXPECT_EQ(pooled_world->entities().position_x, inline_world->entities().position_x);
+  EXPECT_EQ(pooled_world->entities().position_y, inline_world->entities().position_y);
+  EXPECT_EQ(pooled_world->entities().velocity_y, inline_world->entities().velocity_y);
+  EXPECT_EQ(pooled_world->step_count(), 120);
+  ASSERT_EQ(pooled_world->scheduler()->stats().size(), 2);
+  EXPECT_EQ(pooled_world->scheduler()->stats()[0].name, "integrate_x");
+  EXPECT_EQ(pooled_world->scheduler()->stats()[0].runs, 120);
+  // Neither axis waits for the other.
+  EXPECT_TRUE(pooled_world->scheduler()->prerequisites(1).empty());
+}
+
+}  // namespace
+}  // namespace zebes
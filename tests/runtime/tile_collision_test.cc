@@ -0,0 +1,303 @@
+#include "runtime/tile_collision.h"
+
+#include <algorithm>
+#include <cmath>
+#include <optional>
+#include <random>
+
+#include "gtest/gtest.h"
+#include "macros.h"
+#include "objects/tile_shape_geometry.h"
+
+namespace zebes {
+namespace {
+
+constexpr int kTileSize = 16;
+
+// One tile per shape, with the tile ID equal to the shape's value plus a
+// one-way variant of the full block.
+constexpr int kOneWayTileId = 100;
+
+Tileset MakeTileset() {
+  Tileset tileset;
+  for (int shape = TileShape::kFullBlock; shape <= TileShape::kSteepSlopeCeilingTallLeftTop;
+       ++shape) {
+    tileset.tiles.push_back(Tile{.id = shape, .shape = static_cast<TileShape>(shape)});
+  }
+  tileset.tiles.push_back(
+      Tile{.id = kOneWayTileId, .shape = TileShape::kHalfBlockBottom, .is_one_way = true});
+  return tileset;
+}
+
+void SetTile(WorldLayer& layer, int cell_x, int cell_y, int tile_id) {
+  TileChunk& chunk =
+      layer.tile_chunks[ChunkKey(cell_x / TileChunk::kSize, cell_y / TileChunk::kSize)];
+  chunk.SetTile((cell_y % TileChunk::kSize) * TileChunk::kSize + cell_x % TileChunk::kSize,
+                tile_id);
+}
+
+TileCollisionMap MakeMap(const WorldLayer& layer, int tile_width = kTileSize,
+                         int tile_height = kTileSize) {
+  absl::StatusOr<TileCollisionMap> map =
+      TileCollisionMap::Create(layer, MakeTileset(), tile_width, tile_height);
+  EXPECT_TRUE(map.ok()) << map.status();
+  return *std::move(map);
+}
+
+// Whether a box overlaps a cell's polygon by more than touching, by the
+// separating-axis theorem written directly against TileShapePolygon.
+bool BoxOverlapsCell(double min_x, double min_y, double max_x, double max_y, int cell_x,
+                     int cell_y, TileShape shape, int tile_width, int tile_height) {
+  absl::Span<const TilePoint> polygon = TileShapePolygon(shape);
+  auto separated = [&](double axis_x, double axis_y) {
+    double polygon_min = INFINITY;
+    double polygon_max = -INFINITY;
+    for (const TilePoint& point : polygon) {
+      const double projection = axis_x * (cell_x + point.x) * tile_width +
+                                axis_y * (cell_y + point.y) * tile_height;
+      polygon_min = std::min(polygon_min, projection);
+      polygon_max = std::max(polygon_max, projection);
+    }
+    double box_min = INFINITY;
+    double box_max = -INFINITY;
+    for (const double x : {min_x, max_x}) {
+      for (const double y : {min_y, max_y}) {
+        box_min = std::min(box_min, axis_x * x + axis_y * y);
+        box_max = std::max(box_max, axis_x * x + axis_y * y);
+      }
+    }
+    return box_max <= polygon_min + 1e-9 || box_min >= polygon_max - 1e-9;
+  };
+  if (separated(1, 0) || separated(0, 1)) return false;
+  for (size_t i = 0; i < polygon.size(); ++i) {
+    const TilePoint& from = polygon[i];
+    const TilePoint& to = polygon[(i + 1) % polygon.size()];
+    if (separated((to.y - from.y) * tile_height, (from.x - to.x) * tile_width)) return false;
+  }
+  return true;
+}
+
+TEST(TileCollisionTest, AFallingBoxLandsOnAFloor) {
+  WorldLayer layer;
+  for (int x = 0; x < 4; ++x) SetTile(layer, x, 5, TileShape::kFullBlock);
+  const TileCollisionMap map = MakeMap(layer);
+
+  // A 8x8 box whose bottom is 40px above the floor at y = 80, falling 80px.
+  std::optional<TileSweepHit> hit = map.SweepBox({.x = 24, .y = 36}, {.x = 4, .y = 4}, {.y = 80});
+
+  ASSERT_TRUE(hit.has_value());
+  EXPECT_DOUBLE_EQ(hit->time, 0.5);
+  EXPECT_EQ(hit->normal, (Vec{.x = 0, .y = -1}));
+  EXPECT_EQ(hit->cell_x, 1);
+  EXPECT_EQ(hit->cell_y, 5);
+}
+
+TEST(TileCollisionTest, ABoxRestingOnAFloorSlidesFreely) {
+  WorldLayer layer;
+  for (int x = 0; x < 8; ++x) SetTile(layer, x, 5, TileShape::kFullBlock);
+  const TileCollisionMap map = MakeMap(layer);
+
+  EXPECT_FALSE(map.SweepBox({.x = 24, .y = 76}, {.x = 4, .y = 4}, {.x = 60}).has_value());
+}
+
+TEST(TileCollisionTest, ASlopeReportsItsDiagonalNormal) {
+  WorldLayer layer;
+  SetTile(layer, 2, 2, TileShape::kSlope45FloorTallRight);
+  const TileCollisionMap map = MakeMap(layer);
+
+  std::optional<TileSweepHit> hit = map.SweepPoint({.x = 40, .y = 0}, {.y = 64});
+
+  ASSERT_TRUE(hit.has_value());
+  EXPECT_EQ(hit->shape, TileShape::kSlope45FloorTallRight);
+  // The surface at x = 40 is 8px into the tile, so 8px above its bottom.
+  EXPECT_NEAR(hit->time * 64, 40, 1e-9);
+  EXPECT_NEAR(hit->normal.x, -std::sqrt(0.5), 1e-9);
+  EXPECT_NEAR(hit->normal.y, -std::sqrt(0.5), 1e-9);
+}
+
+TEST(TileCollisionTest, NormalsFollowNonSquareTiles) {
+  WorldLayer layer;
+  SetTile(layer, 1, 1, TileShape::kSlope45FloorTallRight);
+  // 32x16 tiles make the 45-degree wedge a 2:1 slope in the world.
+  const TileCollisionMap map = MakeMap(layer, 32, 16);
+
+  std::optional<TileSweepHit> hit = map.SweepPoint({.x = 48, .y = 0}, {.y = 40});
+
+  ASSERT_TRUE(hit.has_value());
+  EXPECT_NEAR(hit->time * 40, 24, 1e-9);
+  EXPECT_NEAR(hit->normal.x / hit->normal.y, 0.5, 1e-9);
+}
+
+TEST(TileCollisionTest, ABoxThatStartsInsideHitsAtOnceWithNoNormal) {
+  WorldLayer layer;
+  SetTile(layer, 0, 0, TileShape::kFullBlock);
+  const TileCollisionMap map = MakeMap(layer);
+
+  std::optional<TileSweepHit> hit = map.SweepBox({.x = 8, .y = 8}, {.x = 2, .y = 2}, {.x = 30});
+
+  ASSERT_TRUE(hit.has_value());
+  EXPECT_EQ(hit->time, 0);
+  EXPECT_EQ(hit->normal, Vec{});
+}
+
+TEST(TileCollisionTest, APointAlongASeamHitsTheTilesEitherSide) {
+  WorldLayer layer;
+  SetTile(layer, 0, 2, TileShape::kFullBlock);
+  SetTile(layer, 1, 2, TileShape::kFullBlock);
+  SetTile(layer, 3, 0, TileShape::kFullBlock);
+  SetTile(layer, 3, 1, TileShape::kFullBlock);
+  const TileCollisionMap map = MakeMap(layer);
+
+  // Down the vertical seam between two floor tiles.
+  std::optional<TileSweepHit> hit = map.SweepPoint({.x = 16, .y = 0}, {.y = 48});
+  ASSERT_TRUE(hit.has_value());
+  EXPECT_NEAR(hit->time * 48, 32, 1e-9);
+  EXPECT_EQ(hit->normal, (Vec{.x = 0, .y = -1}));
+  EXPECT_EQ(hit->cell_y, 2);
+
+  // Leftward along the horizontal seam between two wall tiles.
+  hit = map.SweepPoint({.x = 80, .y = 16}, {.x = -48});
+  ASSERT_TRUE(hit.has_value());
+  EXPECT_NEAR(80 - hit->time * 48, 64, 1e-9);
+  EXPECT_EQ(hit->normal, (Vec{.x = 1, .y = 0}));
+  EXPECT_EQ(hit->cell_x, 3);
+
+  // A box with no width is a point across, so it cannot slip through either.
+  hit = map.SweepBox({.x = 16, .y = 4}, {.x = 0, .y = 4}, {.y = 48});
+  ASSERT_TRUE(hit.has_value());
+  EXPECT_NEAR(8 + hit->time * 48, 32, 1e-9);
+}
+
+TEST(TileCollisionTest, APointOnATileFaceHitsOnlyWhenItMovesIn) {
+  WorldLayer layer;
+  SetTile(layer, 1, 1, TileShape::kFullBlock);
+  const TileCollisionMap map = MakeMap(layer);
+
+  // Leaving the left face is free.
+  EXPECT_FALSE(map.SweepPoint({.x = 16, .y = 24}, {.x = -20}).has_value());
+
+  // Running along the top face touches the tile, which for a point is contact.
+  std::optional<TileSweepHit> hit = map.SweepPoint({.x = 0, .y = 16}, {.x = 48});
+  ASSERT_TRUE(hit.has_value());
+  EXPECT_NEAR(hit->time * 48, 16, 1e-9);
+  EXPECT_EQ(hit->normal, (Vec{.x = -1, .y = 0}));
+
+  // Pushing in through the face it rests on hits at once, from that side.
+  hit = map.SweepPoint({.x = 16, .y = 24}, {.x = 20});
+  ASSERT_TRUE(hit.has_value());
+  EXPECT_EQ(hit->time, 0);
+  EXPECT_EQ(hit->normal, (Vec{.x = -1, .y = 0}));
+}
+
+TEST(TileCollisionTest, OneWayTilesStopOnlyALanding) {
+  WorldLayer layer;
+  SetTile(layer, 1, 1, kOneWayTileId);
+  const TileCollisionMap map = MakeMap(layer);
+
+  // Jumping up through it, and walking through it, are both free.
+  EXPECT_FALSE(map.SweepPoint({.x = 24, .y = 40}, {.y = -40}).has_value());
+  EXPECT_FALSE(map.SweepPoint({.x = 0, .y = 28}, {.x = 48}).has_value());
+
+  std::optional<TileSweepHit> hit = map.SweepPoint({.x = 24, .y = 0}, {.y = 48});
+  ASSERT_TRUE(hit.has_value());
+  EXPECT_EQ(hit->normal, (Vec{.x = 0, .y = -1}));
+  EXPECT_NEAR(hit->time * 48, 24, 1e-9);
+}
+
+TEST(TileCollisionTest, FindsTheFirstHitAcrossChunks) {
+  WorldLayer layer;
+  SetTile(layer, 70, 3, TileShape::kFullBlock);
+  SetTile(layer, 40, 3, TileShape::kHalfBlockRight);
+  const TileCollisionMap map = MakeMap(layer);
+
+  std::optional<TileSweepHit> hit = map.SweepPoint({.x = 8, .y = 56}, {.x = 1200});
+
+  ASSERT_TRUE(hit.has_value());
+  EXPECT_EQ(hit->cell_x, 40);
+  EXPECT_NEAR(8 + hit->time * 1200, 40 * kTileSize + 8, 1e-9);
+  EXPECT_EQ(hit->normal, (Vec{.x = -1, .y = 0}));
+}
+
+TEST(TileCollisionTest, RejectsATileTheTilesetDoesNotDefine) {
+  WorldLayer layer;
+  SetTile(layer, 0, 0, 999);
+
+  EXPECT_EQ(TileCollisionMap::Create(layer, MakeTileset(), kTileSize, kTileSize).status().code(),
+            absl::StatusCode::kNotFound);
+}
+
+// Random boxes through a random field of every shape. At the reported time the
+// box may touch but not overlap anything; just past it, it overlaps the cell
+// that was hit. A sweep reported free overlaps nothing along the way.
+TEST(TileCollisionTest, SweepsAgreeWithAStaticOverlapTest) {
+  constexpr int kCells = 48;
+  std::mt19937 random(42);
+  std::uniform_int_distribution<int> shape_of(0, TileShape::kSteepSlopeCeilingTallLeftTop);
+  std::bernoulli_distribution occupied(0.15);
+  WorldLayer layer;
+  for (int y = 0; y < kCells; ++y) {
+    for (int x = 0; x < kCells; ++x) {
+      if (occupied(random)) SetTile(layer, x, y, std::max(1, shape_of(random)));
+    }
+  }
+  const TileCollisionMap map = MakeMap(layer, 16, 12);
+  const double width = kCells * 16;
+  const double height = kCells * 12;
+
+  auto overlaps_anything = [&](double center_x, double center_y, double half_x, double half_y) {
+    const int first_x = static_cast<int>(std::floor((center_x - half_x) / 16));
+    const int last_x = static_cast<int>(std::floor((center_x + half_x) / 16));
+    const int first_y = static_cast<int>(std::floor((center_y - half_y) / 12));
+    const int last_y = static_cast<int>(std::floor((center_y + half_y) / 12));
+    for (int y = first_y; y <= last_y; ++y) {
+      for (int x = first_x; x <= last_x; ++x) {
+        const TileShape shape = map.ShapeAt(x, y);
+        if (shape != TileShape::kNone &&
+            BoxOverlapsCell(center_x - half_x, center_y - half_y, center_x + half_x,
+                            center_y + half_y, x, y, shape, 16, 12)) {
+          return true;
+        }
+      }
+    }
+    return false;
+  };
+
+  std::uniform_real_distribution<double> coordinate_x(0, width);
+  std::uniform_real_distribution<double> coordinate_y(0, height);
+  std::uniform_real_distribution<double> extent(0, 10);
+  std::uniform_real_distribution<double> motion(-120, 120);
+  int hits = 0;
+  for (int query = 0; query < 2000; ++query) {
+    const Vec half{.x = extent(random), .y = extent(random)};
+    const Vec start{.x = coordinate_x(random), .y = coordinate_y(random)};
+    const Vec delta{.x = motion(random), .y = motion(random)};
+    if (overlaps_anything(start.x, start.y, half.x, half.y)) continue;
+
+    std::optional<TileSweepHit> hit = map.SweepBox(start, half, delta);
+    if (!hit.has_value()) {
+      for (int sample = 1; sample <= 64; ++sample) {
+        const double t = sample / 64.0;
+        ASSERT_FALSE(overlaps_anything(start.x + delta.x * t, start.y + delta.y * t, half.x,
+                                       half.y))
+            << "query " << query << " passed through solid ground at t=" << t;
+      }
+      continue;
+    }
+    ++hits;
+    const double before = std::max(0.0, hit->time - 1e-6);
+    EXPECT_FALSE(overlaps_anything(start.x + delta.x * before, start.y + delta.y * before, half.x,
+                                   half.y))
+        << "query " << query;
+    const double after = hit->time + 1e-6;
+    EXPECT_TRUE(BoxOverlapsCell(start.x + delta.x * after - half.x,
+                                start.y + delta.y * after - half.y,
+                                start.x + delta.x * after + half.x,
+                                start.y + delta.y * after + half.y, hit->cell_x, hit->cell_y,
+                                hit->shape, 16, 12))
+        << "query " << query;
+  }
+  EXPECT_GT(hits, 200);
+}
+
+}  // namespace
+}  // namespace zebes
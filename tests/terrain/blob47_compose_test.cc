@@ -1,5 +1,7 @@
 #include "terrain/blob47_compose.h"
 
+#include <algorithm>
+#include <cstdint>
 #include <set>
 
 #include "gtest/gtest.h"
@@ -306,6 +308,29 @@ TEST(Blob47ComposeTest, RejectsSlopeSheetWithMismatchedTileSize) {
   EXPECT_EQ(atlas.status().code(), absl::StatusCode::kInvalidArgument);
 }
 
+// The tileset editor re-composes into one atlas as quadrants are edited. The
+// cells no tile lands in must not keep what an earlier composition left there.
+TEST(Blob47ComposeTest, ComposingIntoAReusedAtlasMatchesAFreshOne) {
+  SlopeSheet two_slopes = MakeSlopeSheet({0, 1});
+  SlopeSheet one_slope = MakeSlopeSheet({3});
+  Blob47Atlas atlas;
+  ASSERT_OK(ComposeBlob47Into(MakeSheet(2, {static_cast<int>(QuadrantState::kFill)}),
+                              &two_slopes, atlas));
+  std::fill(atlas.image.pixels.begin(), atlas.image.pixels.end(), uint8_t{77});
+  const uint8_t* buffer = atlas.image.pixels.data();
+
+  const QuadrantSheet sheet = MakeSheet(2);
+  ASSERT_OK(ComposeBlob47Into(sheet, &one_slope, atlas));
+  absl::StatusOr<Blob47Atlas> fresh = ComposeBlob47(sheet, &one_slope);
+  ASSERT_OK(fresh);
+
+  EXPECT_EQ(atlas.image.pixels.data(), buffer);
+  EXPECT_EQ(atlas.image.width, fresh->image.width);
+  EXPECT_EQ(atlas.image.height, fresh->image.height);
+  EXPECT_EQ(atlas.image.pixels, fresh->image.pixels);
+  EXPECT_EQ(WriteBlob47Manifest(atlas), WriteBlob47Manifest(*fresh));
+}
+
 TEST(Blob47ComposeTest, ManifestCarriesSlopeShapes) {
   SlopeSheet slopes = MakeSlopeSheet({0, 1});
   absl::StatusOr<Blob47Atlas> atlas = ComposeBlob47(MakeSheet(1), &slopes);
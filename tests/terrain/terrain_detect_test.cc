@@ -1,5 +1,6 @@
 #include "terrain/terrain_detect.h"
 
+#include <algorithm>
 #include <set>
 
 #include "absl/strings/str_cat.h"
@@ -409,6 +410,41 @@ TEST(TerrainDetectTest, DetectSuggestsNameFromSharedTilePrefix) {
   EXPECT_EQ((*candidates)[0].terrain.name, "MossyStone");
 }
 
+TEST(TerrainDetectTest, DetectReportsManyBlocksInAtlasOrder) {
+  // A sheet of blocks side by side, listed in reverse so tile order cannot be
+  // what decides the result. Each block's prefix names its atlas position.
+  Tileset tileset;
+  tileset.tile_width = kTileSize;
+  tileset.tile_height = kTileSize;
+  constexpr int kBlocksWide = 12;
+  constexpr int kBlocksHigh = 9;
+  int next_id = 1;
+  for (int block_row = 0; block_row < kBlocksHigh; ++block_row) {
+    for (int block_column = 0; block_column < kBlocksWide; ++block_column) {
+      const Tileset block = MakeBlockTileset(
+          block_column * kBlob47Columns, block_row * (kBlob47Rows + 1), 1,
+          absl::StrCat("Block", block_row, "x", block_column));
+      for (Tile tile : block.tiles) {
+        tile.id = next_id++;
+        tileset.tiles.push_back(tile);
+      }
+    }
+  }
+  std::reverse(tileset.tiles.begin(), tileset.tiles.end());
+
+  absl::StatusOr<std::vector<TerrainCandidate>> candidates = DetectBlob47Terrains(tileset);
+  ASSERT_OK(candidates);
+  ASSERT_EQ(candidates->size(), static_cast<size_t>(kBlocksWide * kBlocksHigh));
+  for (int i = 0; i < kBlocksWide * kBlocksHigh; ++i) {
+    const TerrainCandidate& candidate = (*candidates)[i];
+    EXPECT_EQ(candidate.terrain.id, i + 1);
+    EXPECT_EQ(candidate.suggested_name,
+              absl::StrCat("Block", i / kBlocksWide, "x", i % kBlocksWide));
+    ASSERT_EQ(candidate.terrain.rules.size(), kBlob47TileCount);
+    EXPECT_EQ(candidate.terrain.rules[0].variants[0].tile_id, i * kBlob47TileCount + 1);
+  }
+}
+
 TEST(TerrainDetectTest, DetectIgnoresTilesThatAreNotCellAligned) {
   Tileset tileset = MakeBlockTileset(0, 0, 1);
   // Nudge one tile off the grid; its cell then has no tile.
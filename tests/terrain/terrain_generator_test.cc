@@ -3,6 +3,7 @@
 #include <algorithm>
 #include <array>
 #include <map>
+#include <random>
 #include <set>
 #include <vector>
 
@@ -13,6 +14,52 @@
 #include "terrain/terrain_mask.h"
 
 namespace zebes {
+
+class TerrainRendererTestPeer {
+ public:
+  // (x, y, motif) for each placement, in the order they were accepted.
+  static std::vector<std::array<int, 3>> MotifPlacements(int period, int target, int spacing,
+                                                         size_t motif_count, uint64_t seed) {
+    std::vector<std::array<int, 3>> out;
+    for (const TerrainRenderer::MotifPlacement& placement :
+         TerrainRenderer::BuildMotifPlacements(period, target, spacing, motif_count, seed)) {
+      out.push_back({placement.x, placement.y, static_cast<int>(placement.motif)});
+    }
+    return out;
+  }
+
+  // (motif, x0, y0) for each draw that reaches each variant's tile.
+  static std::vector<std::vector<std::array<int, 3>>> MotifDraws(
+      const std::vector<std::array<int, 3>>& placements, absl::Span<const TerrainMotif> motifs,
+      int scale, int tile, int variant_period) {
+    std::vector<TerrainRenderer::MotifPlacement> resolved;
+    for (const auto& [x, y, motif] : placements) {
+      resolved.push_back({.x = x, .y = y, .motif = static_cast<size_t>(motif)});
+    }
+    std::vector<std::vector<std::array<int, 3>>> out;
+    for (const std::vector<TerrainRenderer::MotifDraw>& draws :
+         TerrainRenderer::BucketMotifDraws(resolved, motifs, scale, tile, variant_period)) {
+      std::vector<std::array<int, 3>>& variant = out.emplace_back();
+      for (const TerrainRenderer::MotifDraw& draw : draws) {
+        variant.push_back({static_cast<int>(draw.motif), draw.x0, draw.y0});
+      }
+    }
+    return out;
+  }
+
+  static std::vector<uint8_t> LegalMotifPixels(const TerrainRenderer& renderer,
+                                               const std::vector<uint8_t>& indices, int margin) {
+    return renderer.LegalMotifPixels(indices, margin).legal;
+  }
+
+  static void StampMotif(const TerrainRenderer& renderer, std::vector<uint8_t>& indices,
+                         int margin, const TerrainMotif& stamp, int x0, int y0, int scale) {
+    const TerrainRenderer::MotifLegality legality = renderer.LegalMotifPixels(indices, margin);
+    const TerrainRenderer::MotifLayer layer{.scale = scale};
+    renderer.StampMotif(indices, legality, stamp, x0, y0, layer);
+  }
+};
+
 namespace {
 
 // A flat run of ground: solid to the east, west and south with air above. Two
@@ -584,6 +631,215 @@ TEST(TerrainGeneratorTest, RejectsUnusableConfigurations) {
   EXPECT_FALSE(TerrainRenderer::Create(config).ok());
 }
 
+TEST(TerrainGeneratorTest, BuildsMotifFieldsUpToThePlacementLimit) {
+  // 1024 per tile over a 4x4 period is the limit for each layer. Spacing checks
+  // are bucketed, so reaching it costs about what a sparse field does.
+  TerrainGenConfig config = FlatInteriorConfig(/*variant_period=*/4, /*supersample=*/1);
+  config.interior.pattern.density = 1024;
+  config.interior.pattern.spacing = 1;
+  config.interior.details.family = TerrainDetailSet::kMeadow;
+  config.interior.details.density = 1024;
+  config.interior.details.spacing = 2;
+  ASSERT_OK(TerrainRenderer::Create(config));
+
+  config.interior.details.density = 1025;
+  EXPECT_FALSE(TerrainRenderer::Create(config).ok());
+}
+
+// Motif placement as it was before the spacing checks were bucketed: every
+// candidate is compared against every placement already accepted.
+std::vector<std::array<int, 3>> PairwiseMotifPlacements(int period, int target, int spacing,
+                                                        size_t motif_count, uint64_t seed) {
+  std::mt19937_64 generator(seed);
+  std::uniform_int_distribution<int> position(0, period - 1);
+  std::vector<std::array<int, 3>> placements;
+  for (int attempt = 0; motif_count > 0 && attempt < std::max(32, target * 80) &&
+                        static_cast<int>(placements.size()) < target;
+       ++attempt) {
+    const int x = position(generator);
+    const int y = position(generator);
+    const int motif = static_cast<int>(generator() % motif_count);
+    const bool crowded = std::any_of(placements.begin(), placements.end(), [&](const auto& placed) {
+      int dx = std::abs(x - placed[0]);
+      int dy = std::abs(y - placed[1]);
+      dx = std::min(dx, period - dx);
+      dy = std::min(dy, period - dy);
+      return dx * dx + dy * dy < spacing * spacing;
+    });
+    if (!crowded) placements.push_back({x, y, motif});
+  }
+  return placements;
+}
+
+TEST(TerrainGeneratorTest, MotifPlacementsMatchAPairwiseSpacingScan) {
+  struct Field {
+    int period;
+    int target;
+    int spacing;
+  };
+  // Sparse and saturated fields, spacings wider than a grid cell would be, and
+  // tori too small for a 3x3 neighbourhood of distinct cells.
+  for (const Field field : {Field{128, 64, 6}, Field{64, 4096, 1}, Field{128, 4096, 3},
+                            Field{64, 200, 40}, Field{16, 64, 9}, Field{7, 20, 2}}) {
+    for (const uint64_t seed : {uint64_t{1}, uint64_t{20260812}}) {
+      SCOPED_TRACE(testing::Message() << "period " << field.period << " target " << field.target
+                                      << " spacing " << field.spacing << " seed " << seed);
+      const std::vector<std::array<int, 3>> placements = TerrainRendererTestPeer::MotifPlacements(
+          field.period, field.target, field.spacing, /*motif_count=*/5, seed);
+      EXPECT_FALSE(placements.empty());
+      EXPECT_EQ(placements, PairwiseMotifPlacements(field.period, field.target, field.spacing,
+                                                    /*motif_count=*/5, seed));
+    }
+  }
+  EXPECT_TRUE(TerrainRendererTestPeer::MotifPlacements(128, 64, 6, /*motif_count=*/0, 1).empty());
+}
+
+TEST(TerrainGeneratorTest, MotifLegalityAndStampingMatchAPerPixelScan) {
+  ASSERT_OK_AND_ASSIGN(
+      const TerrainRenderer renderer,
+      TerrainRenderer::Create(FlatInteriorConfig(/*variant_period=*/1, /*supersample=*/1)));
+  const int tile = renderer.config().tile_size;
+  const size_t pixels = static_cast<size_t>(tile) * tile;
+
+  // With no margin a pixel is legal exactly when it is interior, which tells
+  // the test which indices count as interior without restating the palette.
+  std::vector<uint8_t> every_index(pixels);
+  for (size_t index = 0; index < pixels; ++index) every_index[index] = index % 256;
+  const std::vector<uint8_t> interior_probe =
+      TerrainRendererTestPeer::LegalMotifPixels(renderer, every_index, /*margin=*/0);
+  std::array<bool, 256> interior{};
+  for (size_t index = 0; index < 256; ++index) interior[index] = interior_probe[index] != 0;
+  const auto first_interior = std::find(interior.begin(), interior.end(), true);
+  ASSERT_NE(first_interior, interior.end());
+  ASSERT_FALSE(interior[0]);
+  const uint8_t interior_index = static_cast<uint8_t>(first_interior - interior.begin());
+
+  // Interior with a band across the top and scattered holes, so every margin
+  // leaves some pixels legal and some not, including against the tile edges.
+  std::mt19937 generator(7);
+  std::vector<uint8_t> mask(pixels, interior_index);
+  for (size_t index = 0; index < pixels; ++index) {
+    if (index < static_cast<size_t>(tile) * 3 || generator() % 40 == 0) mask[index] = 0;
+  }
+
+  const auto legal_by_scan = [&](int margin) {
+    std::vector<uint8_t> legal(pixels, 0);
+    for (int y = 0; y < tile; ++y) {
+      for (int x = 0; x < tile; ++x) {
+        bool clear = true;
+        for (int ny = std::max(0, y - margin); ny <= std::min(tile - 1, y + margin); ++ny) {
+          for (int nx = std::max(0, x - margin); nx <= std::min(tile - 1, x + margin); ++nx) {
+            clear = clear && interior[mask[static_cast<size_t>(ny) * tile + nx]];
+          }
+        }
+        legal[static_cast<size_t>(y) * tile + x] = clear ? 1 : 0;
+      }
+    }
+    return legal;
+  };
+
+  constexpr TerrainMotifPixel T = TerrainMotifPixel::kTransparent;
+  constexpr TerrainMotifPixel A = TerrainMotifPixel::kAutoShaded;
+  constexpr std::array<TerrainMotifPixel, 9> kPlus = {T, A, T, A, A, A, T, A, T};
+  constexpr std::array<TerrainMotifPixel, 8> kCorners = {A, T, T, T, T, T, T, A};
+  const TerrainMotif motifs[] = {TerrainMotif{.width = 3, .height = 3, .pixels = kPlus},
+                                 TerrainMotif{.width = 4, .height = 2, .pixels = kCorners}};
+
+  for (const int margin : {0, 1, 2, 5}) {
+    const std::vector<uint8_t> legal = legal_by_scan(margin);
+    ASSERT_EQ(TerrainRendererTestPeer::LegalMotifPixels(renderer, mask, margin), legal)
+        << "margin " << margin;
+
+    for (const TerrainMotif& stamp : motifs) {
+      for (const int scale : {1, 2, 3}) {
+        const int drawn_width = stamp.width * scale;
+        const int drawn_height = stamp.height * scale;
+        // Every position that overlaps the tile, so stamps clipped by each
+        // edge and corner are covered along with whole ones.
+        for (int y0 = -drawn_height + 1; y0 < tile; ++y0) {
+          for (int x0 = -drawn_width + 1; x0 < tile; ++x0) {
+            bool visible = false;
+            bool clear = true;
+            std::vector<uint8_t> covered(pixels, 0);
+            for (int sy = 0; sy < drawn_height; ++sy) {
+              for (int sx = 0; sx < drawn_width; ++sx) {
+                const int px = x0 + sx;
+                const int py = y0 + sy;
+                if (px < 0 || py < 0 || px >= tile || py >= tile) continue;
+                if (stamp.pixels[(sy / scale) * stamp.width + sx / scale] == T) continue;
+                const size_t index = static_cast<size_t>(py) * tile + px;
+                visible = true;
+                clear = clear && legal[index] != 0;
+                covered[index] = 1;
+              }
+            }
+
+            std::vector<uint8_t> stamped = mask;
+            TerrainRendererTestPeer::StampMotif(renderer, stamped, margin, stamp, x0, y0, scale);
+            const bool drawn = visible && clear;
+            for (size_t index = 0; index < pixels; ++index) {
+              if (drawn && covered[index] != 0) {
+                ASSERT_FALSE(interior[stamped[index]])
+                    << "margin " << margin << " scale " << scale << " at " << x0 << "," << y0;
+              } else {
+                ASSERT_EQ(stamped[index], mask[index])
+                    << "margin " << margin << " scale " << scale << " at " << x0 << "," << y0;
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+TEST(TerrainGeneratorTest, BucketedMotifDrawsKeepTheFlatStampingOrder) {
+  constexpr int kTile = 8;
+  constexpr int kVariantPeriod = 2;
+  constexpr int kPeriod = kTile * kVariantPeriod;
+  constexpr TerrainMotifPixel A = TerrainMotifPixel::kAutoShaded;
+  constexpr std::array<TerrainMotifPixel, 15> kOpaque = {A, A, A, A, A, A, A, A,
+                                                         A, A, A, A, A, A, A};
+  // Wide enough at scale 3 that one placement reaches a tile more than once.
+  const TerrainMotif motifs[] = {TerrainMotif{.width = 1, .height = 1, .pixels = kOpaque},
+                                 TerrainMotif{.width = 5, .height = 3, .pixels = kOpaque}};
+
+  std::mt19937 generator(11);
+  std::vector<std::array<int, 3>> placements = {{0, 0, 1}, {kPeriod - 1, kPeriod - 1, 1},
+                                                {kTile, 0, 0}, {kTile - 1, kTile, 1}};
+  for (int index = 0; index < 60; ++index) {
+    placements.push_back({static_cast<int>(generator() % kPeriod),
+                          static_cast<int>(generator() % kPeriod),
+                          static_cast<int>(generator() % 2)});
+  }
+
+  for (const int scale : {1, 2, 3}) {
+    SCOPED_TRACE(testing::Message() << "scale " << scale);
+    const auto draws =
+        TerrainRendererTestPeer::MotifDraws(placements, motifs, scale, kTile, kVariantPeriod);
+    ASSERT_EQ(draws.size(), static_cast<size_t>(kVariantPeriod * kVariantPeriod));
+    for (int variant = 0; variant < kVariantPeriod * kVariantPeriod; ++variant) {
+      // Every placement in turn, each of its toroidal copies from the top-left
+      // down, kept when its box touches the variant's tile.
+      std::vector<std::array<int, 3>> flat;
+      for (const auto& [x, y, motif] : placements) {
+        const int width = motifs[motif].width * scale;
+        const int height = motifs[motif].height * scale;
+        for (int wrap_y = -2; wrap_y <= 2; ++wrap_y) {
+          for (int wrap_x = -2; wrap_x <= 2; ++wrap_x) {
+            const int x0 = x - (variant % kVariantPeriod) * kTile + wrap_x * kPeriod - width / 2;
+            const int y0 = y - (variant / kVariantPeriod) * kTile + wrap_y * kPeriod - height / 2;
+            if (x0 < kTile && y0 < kTile && x0 + width > 0 && y0 + height > 0) {
+              flat.push_back({motif, x0, y0});
+            }
+          }
+        }
+      }
+      EXPECT_EQ(draws[variant], flat) << "variant " << variant;
+    }
+  }
+}
+
 TEST(TerrainGeneratorTest, ResolvesMeasurementsThroughThePixelProfile) {
   TerrainGenConfig config;
   config.tile_size = 16;